@@ -1,7 +1,9 @@
+#include <fstream>
 #include <iomanip>
 #include <list>
 #include <random>
 #include <sstream>
+#include <unordered_map>
 #include <unordered_set>
 
 #include "baldr/connectivity_map.h"
@@ -17,6 +19,11 @@ using namespace valhalla::baldr;
 using namespace valhalla::midgard;
 
 namespace {
+
+// colors precomputed at the end of the tile build live beside the tiles,
+// one line per tile of the form "level tileid color"
+constexpr const char* CONNECTIVITY_FILE = "connectivity_map.txt";
+
 /*
    { "type": "FeatureCollection",
     "features": [
@@ -222,40 +229,90 @@ polygon_t to_boundary(const std::pair<size_t, std::unordered_set<uint32_t>>& reg
 
 namespace valhalla {
 namespace baldr {
-connectivity_map_t::connectivity_map_t(const boost::property_tree::ptree& pt) {
+connectivity_map_t::connectivity_map_t(const boost::property_tree::ptree& pt,
+                                       const bool use_cached) {
+  transit_level = TileHierarchy::levels().rbegin()->second.level + 1;
+
+  // if the tile build wrote its colors down we can skip scanning the tiles.
+  // extracts enumerate their tiles from the memory mapped index quickly so
+  // they just recompute, the file only covers the loose tiles it was built from
+  auto tile_dir = pt.get_optional<std::string>("tile_dir");
+  if (use_cached && !pt.get_optional<std::string>("tile_extract") && tile_dir && load(*tile_dir)) {
+    return;
+  }
+
   // See what kind of tiles we are dealing with here by getting a graphreader
   GraphReader reader(pt);
   auto tiles = reader.GetTileSet();
-  transit_level = TileHierarchy::levels().rbegin()->second.level + 1;
 
   // Populate a map for each level of the tiles that exist
+  std::unordered_map<uint32_t, std::unordered_map<uint32_t, size_t>> scratch;
   for (const auto& t : tiles) {
-    auto& level_colors =
-        colors.insert({t.level(), std::unordered_map<uint32_t, size_t>{}}).first->second;
-    level_colors.insert({t.tileid(), 0});
+    scratch[t.level()].insert({t.tileid(), 0});
   }
 
   // All tiles have color 0 (not connected), go through and connect
   // (build the ColorMap). Transit level uses local hierarchy tiles
-  for (auto& color : colors) {
+  for (auto& color : scratch) {
     if (color.first == transit_level) {
       TileHierarchy::levels().rbegin()->second.tiles.ColorMap(color.second);
     } else {
       TileHierarchy::levels().find(color.first)->second.tiles.ColorMap(color.second);
     }
   }
+
+  // Move the finished colors into the flat per level tables the hot
+  // lookups probe
+  colors.resize(transit_level + 1);
+  for (const auto& level : scratch) {
+    auto& level_colors = colors[level.first];
+    level_colors.reserve(level.second.size());
+    for (const auto& tile : level.second) {
+      level_colors.emplace(tile.first) = tile.second;
+    }
+  }
 }
 
-size_t connectivity_map_t::get_color(const GraphId& id) const {
-  auto level = colors.find(id.level());
-  if (level == colors.cend()) {
-    return 0;
+bool connectivity_map_t::load(const std::string& tile_dir) {
+  std::ifstream file(tile_dir + "/" + CONNECTIVITY_FILE);
+  if (!file) {
+    return false;
+  }
+
+  // each line pins one tile to a color, anything unparsable means the file
+  // is from another version or truncated so fall back to scanning the tiles
+  uint32_t level, tileid;
+  size_t color;
+  std::string line;
+  colors.resize(transit_level + 1);
+  while (std::getline(file, line)) {
+    std::stringstream parsed(line);
+    if (!(parsed >> level >> tileid >> color) || level >= colors.size()) {
+      LOG_WARN("Unparsable connectivity file, rebuilding the connectivity map: " + line);
+      colors.clear();
+      return false;
+    }
+    colors[level].emplace(tileid) = color;
   }
-  auto color = level->second.find(id.tileid());
-  if (color == level->second.cend()) {
+  return true;
+}
+
+void connectivity_map_t::to_file(const std::string& tile_dir) const {
+  std::ofstream file(tile_dir + "/" + CONNECTIVITY_FILE, std::ios::trunc);
+  for (size_t level = 0; level < colors.size(); ++level) {
+    colors[level].each(
+        [&file, level](const uint32_t tileid, const size_t& color) {
+          file << level << " " << tileid << " " << color << "\n";
+        });
+  }
+}
+
+size_t connectivity_map_t::get_color(const GraphId& id) const {
+  if (id.level() >= colors.size()) {
     return 0;
   }
-  return color->second;
+  const auto* color = colors[id.level()].find(id.tileid());
+  return color == nullptr ? 0 : *color;
 }
 
 std::unordered_set<size_t> connectivity_map_t::get_colors(uint32_t hierarchy_level,
@@ -263,10 +320,10 @@ std::unordered_set<size_t> connectivity_map_t::get_colors(uint32_t hierarchy_lev
                                                           float radius) const {
 
   std::unordered_set<size_t> result;
-  auto level = colors.find(hierarchy_level);
-  if (level == colors.cend()) {
+  if (hierarchy_level >= colors.size()) {
     return result;
   }
+  const auto& level_colors = colors[hierarchy_level];
   const auto& tiles = TileHierarchy::levels().find(hierarchy_level)->second.tiles;
   for (const auto& edge : location.edges) {
     // Get a list of tiles required within the radius of the projected point
@@ -278,9 +335,9 @@ std::unordered_set<size_t> connectivity_map_t::get_colors(uint32_t hierarchy_lev
                         Point2(ll.lng() + lngdeg, ll.lat() + latdeg));
     std::vector<int32_t> tilelist = tiles.TileList(bbox);
     for (auto& id : tilelist) {
-      auto color = level->second.find(id);
-      if (color != level->second.cend()) {
-        result.emplace(color->second);
+      const auto* color = level_colors.find(static_cast<uint32_t>(id));
+      if (color != nullptr) {
+        result.emplace(*color);
       }
     }
   }
@@ -298,16 +355,15 @@ std::string connectivity_map_t::to_geojson(const uint32_t hierarchy_level) const
   // make a region map (inverse mapping of color to lists of tiles)
   // could cache this but shouldnt need to call it much
   std::unordered_map<size_t, std::unordered_set<uint32_t>> regions;
-  auto level = colors.find(hierarchy_level);
-  if (level != colors.cend()) {
-    for (const auto& tile : level->second) {
-      auto region = regions.find(tile.second);
+  if (hierarchy_level < colors.size()) {
+    colors[hierarchy_level].each([&regions](const uint32_t tileid, const size_t& color) {
+      auto region = regions.find(color);
       if (region == regions.end()) {
-        regions.emplace(tile.second, std::unordered_set<uint32_t>{tile.first});
+        regions.emplace(color, std::unordered_set<uint32_t>{tileid});
       } else {
-        region->second.emplace(tile.first);
+        region->second.emplace(tileid);
       }
-    }
+    });
   }
 
   // record the arity of each region so we can put the biggest ones first
@@ -337,12 +393,11 @@ std::vector<size_t> connectivity_map_t::to_image(const uint32_t hierarchy_level)
 
   std::vector<size_t> tiles(bbox->second.tiles.nrows() * bbox->second.tiles.ncolumns(),
                             static_cast<uint32_t>(0));
-  auto level = colors.find(hierarchy_level);
-  if (level != colors.cend()) {
+  if (hierarchy_level < colors.size()) {
     for (size_t i = 0; i < tiles.size(); ++i) {
-      const auto color = level->second.find(static_cast<uint32_t>(i));
-      if (color != level->second.cend()) {
-        tiles[i] = color->second;
+      const auto* color = colors[hierarchy_level].find(static_cast<uint32_t>(i));
+      if (color != nullptr) {
+        tiles[i] = *color;
       }
     }
   }
@@ -1,7 +1,10 @@
 #include "baldr/curler.h"
 #include "midgard/logging.h"
 
+#include <algorithm>
+#include <atomic>
 #include <stdexcept>
+#include <thread>
 
 #ifdef CURL_STATICLIB
 
@@ -104,6 +107,39 @@ operator()(const std::string& url, long& http_code, bool allow_compression) {
   return pimpl->fetch(url, http_code, allow_compression);
 }
 
+std::vector<std::vector<char>> curler_t::operator()(const std::vector<std::string>& urls,
+                                                    std::vector<long>& http_codes,
+                                                    bool allow_compression,
+                                                    size_t concurrency) {
+  std::vector<std::vector<char>> results(urls.size());
+  http_codes.assign(urls.size(), 0);
+
+  // each worker pulls the next unfetched url with its own connection, an
+  // easy handle cannot be shared between threads
+  std::atomic<size_t> next(0);
+  size_t thread_count = std::min(std::max<size_t>(concurrency, 1), urls.size());
+  std::vector<std::thread> threads;
+  threads.reserve(thread_count);
+  for (size_t t = 0; t < thread_count; ++t) {
+    threads.emplace_back([&]() {
+      pimpl_t connection;
+      size_t i;
+      while ((i = next.fetch_add(1)) < urls.size()) {
+        try {
+          results[i] = connection.fetch(urls[i], http_codes[i], allow_compression);
+        } catch (...) {
+          // a failed transfer leaves an empty result and a 0 code, the
+          // caller treats those like any other non-200
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  return results;
+}
+
 } // namespace baldr
 } // namespace valhalla
 
@@ -118,6 +154,11 @@ std::vector<char> curler_t::operator()(const std::string&, long&, bool allow_com
   LOG_ERROR("This version of libvalhalla was not built with CURL support");
   throw std::runtime_error("This version of libvalhalla was not built with CURL support");
 }
+std::vector<std::vector<char>>
+curler_t::operator()(const std::vector<std::string>&, std::vector<long>&, bool, size_t) {
+  LOG_ERROR("This version of libvalhalla was not built with CURL support");
+  throw std::runtime_error("This version of libvalhalla was not built with CURL support");
+}
 } // namespace baldr
 } // namespace valhalla
 
@@ -121,6 +121,40 @@ int timezone_diff(const uint64_t seconds,
   }
 }
 
+// Get the difference between two timezones at the given time, cached per
+// timezone pair. The difference is recomputed only when the query time
+// leaves the window over which both zones keep their current offsets.
+int tz_diff_cache_t::diff(const uint64_t seconds,
+                          const date::time_zone* origin_tz,
+                          const date::time_zone* dest_tz) {
+  if (!origin_tz || !dest_tz || origin_tz == dest_tz) {
+    return 0;
+  }
+
+  auto inserted = entries_.emplace(std::make_pair(origin_tz, dest_tz), entry_t{0, 0, 0});
+  entry_t& entry = inserted.first->second;
+  int64_t secs = static_cast<int64_t>(seconds);
+  if (inserted.second || secs < entry.begin || secs >= entry.end) {
+    // Recompute the difference along with the window bounded by the nearest
+    // DST transition of either zone
+    std::chrono::seconds dur(seconds);
+    std::chrono::time_point<std::chrono::system_clock> tp(dur);
+    const auto origin_info = origin_tz->get_info(tp);
+    const auto dest_info = dest_tz->get_info(tp);
+    entry.begin = std::max(origin_info.begin.time_since_epoch().count(),
+                           dest_info.begin.time_since_epoch().count());
+    entry.end = std::min(origin_info.end.time_since_epoch().count(),
+                         dest_info.end.time_since_epoch().count());
+    entry.diff = timezone_diff(seconds, origin_tz, dest_tz);
+  }
+  return entry.diff;
+}
+
+// Clear the cached timezone differences.
+void tz_diff_cache_t::clear() {
+  entries_.clear();
+}
+
 std::string seconds_to_date(const uint64_t seconds, const date::time_zone* time_zone) {
 
   std::string iso_date;
@@ -220,6 +220,16 @@ void DirectedEdge::set_not_thru(const bool not_thru) {
   not_thru_ = not_thru;
 }
 
+// Sets the approximate reach, clamped to what the field can store.
+void DirectedEdge::set_reach(const uint32_t reach) {
+  reach_ = std::min(reach, kMaxEdgeReach);
+}
+
+// Sets whether the default truck envelope passes all access restrictions.
+void DirectedEdge::set_default_truck_ok(const bool ok) {
+  default_truck_ok_ = ok;
+}
+
 // Set the index of the opposing directed edge at the end node of this
 // directed edge.
 void DirectedEdge::set_opp_index(const uint32_t opp_index) {
@@ -282,6 +292,11 @@ void DirectedEdge::set_ctry_crossing(const bool crossing) {
   ctry_crossing_ = crossing;
 }
 
+// Set the state crossing flag.
+void DirectedEdge::set_st_crossing(const bool crossing) {
+  st_crossing_ = crossing;
+}
+
 // Set the access modes in the forward direction (bit field).
 void DirectedEdge::set_forwardaccess(const uint32_t modes) {
   if (modes > kAllAccess) {
@@ -572,6 +587,7 @@ json::MapPtr DirectedEdge::json() const {
       {"truck_route", static_cast<bool>(truck_route_)},
       {"lane_count", static_cast<uint64_t>(lanecount_)},
       {"country_crossing", static_cast<bool>(ctry_crossing_)},
+      {"state_crossing", static_cast<bool>(st_crossing_)},
       {"geo_attributes",
        json::map({
            {"length", static_cast<uint64_t>(length_)},
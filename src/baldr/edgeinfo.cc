@@ -1,5 +1,7 @@
 #include "baldr/edgeinfo.h"
 
+#include <cstring>
+
 #include "midgard/encoded.h"
 
 using namespace valhalla::baldr;
@@ -28,7 +30,10 @@ json::ArrayPtr names_json(const std::vector<std::string>& names) {
 namespace valhalla {
 namespace baldr {
 
-EdgeInfo::EdgeInfo(char* ptr, const char* names_list, const size_t names_list_length)
+EdgeInfo::EdgeInfo(char* ptr,
+                   const char* names_list,
+                   const size_t names_list_length,
+                   const bool use_shape_index)
     : names_list_(names_list), names_list_length_(names_list_length) {
 
   w0_.value_ = *(reinterpret_cast<uint64_t*>(ptr));
@@ -44,6 +49,18 @@ EdgeInfo::EdgeInfo(char* ptr, const char* names_list, const size_t names_list_le
   // Set encoded_shape_ pointer
   encoded_shape_ = ptr;
   ptr += (encoded_shape_size() * sizeof(char));
+
+  // Set the checkpoint index pointer when the tile carries trustworthy per
+  // edge flags and this edge has one
+  shape_index_ = nullptr;
+  shape_index_count_ = 0;
+  if (use_shape_index && item_->has_shape_index) {
+    uint16_t count;
+    std::memcpy(&count, ptr, sizeof(count));
+    ptr += sizeof(count);
+    shape_index_ = ptr;
+    shape_index_count_ = count;
+  }
 }
 
 EdgeInfo::~EdgeInfo() {
@@ -100,6 +117,25 @@ std::vector<std::pair<std::string, bool>> EdgeInfo::GetNamesAndTypes() const {
   return name_type_pairs;
 }
 
+// Get a list of names as pointers into the tile's text list
+std::vector<std::pair<const char*, bool>> EdgeInfo::GetNamePointersAndTypes() const {
+  std::vector<std::pair<const char*, bool>> name_type_pairs;
+  name_type_pairs.reserve(name_count());
+  const NameInfo* ni = name_info_list_;
+  for (uint32_t i = 0; i < name_count(); i++, ni++) {
+    // Skip any tagged names (FUTURE code may make use of them)
+    if (ni->tagged_) {
+      continue;
+    }
+    if (ni->name_offset_ < names_list_length_) {
+      name_type_pairs.push_back({names_list_ + ni->name_offset_, ni->is_route_num_});
+    } else {
+      throw std::runtime_error("GetNamePointersAndTypes: offset exceeds size of text list");
+    }
+  }
+  return name_type_pairs;
+}
+
 // Get the types.  Are these names route numbers or not?
 uint16_t EdgeInfo::GetTypes() const {
   // Get the types.
@@ -111,6 +147,89 @@ uint16_t EdgeInfo::GetTypes() const {
   return types;
 }
 
+// Get a decoder positioned at the closest checkpoint at or before the vertex
+midgard::Shape7Decoder<PointLL> EdgeInfo::lazy_shape_at(uint32_t& vertex) const {
+  // checkpoint k covers vertex (k + 1) * sample rate, so this is how many of
+  // them sit at or before the one asked for
+  uint32_t usable = vertex / kShapeIndexSampleRate;
+  if (usable > shape_index_count_) {
+    usable = shape_index_count_;
+  }
+  if (usable == 0) {
+    vertex = 0;
+    return lazy_shape();
+  }
+
+  // the records are packed so pull the fields out one by one
+  const char* record = shape_index_ + (usable - 1) * kShapeCheckpointSize;
+  uint16_t offset;
+  int32_t lat, lon;
+  std::memcpy(&offset, record, sizeof(offset));
+  std::memcpy(&lat, record + sizeof(offset), sizeof(lat));
+  std::memcpy(&lon, record + sizeof(offset) + sizeof(lat), sizeof(lon));
+  vertex = usable * kShapeIndexSampleRate;
+  return midgard::Shape7Decoder<PointLL>(encoded_shape_ + offset,
+                                         item_->encoded_shape_size - offset, lat, lon);
+}
+
+// Decode only the leading piece of the shape covering the given distance
+std::vector<PointLL> EdgeInfo::shape_head(const float length) const {
+  // a previous full decode was cached so just hand that over
+  if (!shape_.empty() || encoded_shape_ == nullptr) {
+    return shape_;
+  }
+
+  // decode until the distance is covered, the accumulation here matches what
+  // callers walking consecutive points will compute so they are guaranteed to
+  // find the segment that crosses the distance within the piece
+  std::vector<PointLL> head;
+  auto decoder = lazy_shape();
+  if (!decoder.empty()) {
+    head.push_back(decoder.pop());
+  }
+  float along = 0.f;
+  while (!decoder.empty()) {
+    head.push_back(decoder.pop());
+    along += head.back().Distance(head[head.size() - 2]);
+    if (along > length) {
+      break;
+    }
+  }
+  return head;
+}
+
+// Decode only the trailing piece of the shape covering the given distance
+std::vector<PointLL> EdgeInfo::shape_tail(const float length) const {
+  // a previous full decode was cached so just hand that over
+  if (!shape_.empty() || encoded_shape_ == nullptr) {
+    return shape_;
+  }
+
+  // decode from the last checkpoint toward the end and if that does not
+  // cover the distance halve the starting checkpoint and redecode; the
+  // doubling spans keep the total work within about two full decodes while
+  // the common case touches only the last few dozen vertices
+  uint32_t checkpoint = shape_index_count_;
+  while (true) {
+    uint32_t vertex = checkpoint * kShapeIndexSampleRate;
+    auto decoder = lazy_shape_at(vertex);
+    std::vector<PointLL> tail;
+    float along = 0.f;
+    while (!decoder.empty()) {
+      tail.push_back(decoder.pop());
+      if (tail.size() > 1) {
+        along += tail.back().Distance(tail[tail.size() - 2]);
+      }
+    }
+    // strictly covering means a caller walking back from the end crosses the
+    // distance within the piece, anything less needs more of the shape
+    if (along > length || checkpoint == 0) {
+      return tail;
+    }
+    checkpoint /= 2;
+  }
+}
+
 // Returns shape as a vector of PointLL
 const std::vector<PointLL>& EdgeInfo::shape() const {
   // if we haven't yet decoded the shape, do so
@@ -1,9 +1,21 @@
 #include "baldr/graphreader.h"
 
+#include <chrono>
+#include <condition_variable>
+#include <deque>
 #include <fstream>
 #include <iostream>
 #include <string>
 #include <sys/stat.h>
+#include <thread>
+#include <unordered_set>
+
+#ifndef _MSC_VER
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
 
 #include "midgard/logging.h"
 #include "midgard/sequence.h"
@@ -61,6 +73,131 @@ struct GraphReader::tile_extract_t {
   std::shared_ptr<midgard::tar> archive;
 };
 
+// Background thread that pulls hinted tiles into the cache ahead of the
+// search frontier. Requires a thread-safe cache since it calls Put/Contains
+// concurrently with the reader's own thread.
+struct GraphReader::tile_prefetcher_t {
+  tile_prefetcher_t(GraphReader& reader) : reader(reader), stop(false) {
+    thread = std::thread(&tile_prefetcher_t::Work, this);
+  }
+
+  ~tile_prefetcher_t() {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      stop = true;
+    }
+    signal.notify_one();
+    thread.join();
+  }
+
+  // queue a tile unless its already queued or resident
+  void Enqueue(const GraphId& graphid) {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (!queued.insert(graphid.value).second) {
+        return;
+      }
+      queue.push_back(graphid);
+    }
+    signal.notify_one();
+  }
+
+  // pull tiles off the queue and into the cache until told to stop
+  void Work() {
+    while (true) {
+      GraphId graphid;
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        signal.wait(lock, [this] { return stop || !queue.empty(); });
+        if (stop) {
+          return;
+        }
+        graphid = queue.front();
+        queue.pop_front();
+        queued.erase(graphid.value);
+      }
+      // the extract serves tiles without touching disk, nothing to warm there
+      if (!reader.tile_extract_->tiles.empty() || reader.cache_->Contains(graphid)) {
+        continue;
+      }
+      GraphTile tile(reader.tile_dir_, graphid, reader.mmap_tiles_);
+      if (tile.header()) {
+        reader.AttachSpeedOverlay(tile, graphid);
+        size_t size = tile.memmapped() ? AVERAGE_MM_TILE_SIZE : tile.header()->end_offset();
+        reader.cache_->Put(graphid, tile, size);
+      }
+    }
+  }
+
+  GraphReader& reader;
+  std::thread thread;
+  std::mutex mutex;
+  std::condition_variable signal;
+  std::deque<GraphId> queue;
+  std::unordered_set<uint64_t> queued;
+  bool stop;
+};
+
+namespace {
+// name of the tile update manifest within the tile directory
+constexpr const char* TILE_MANIFEST = "tile_manifest.txt";
+
+// Read just the epoch off the first manifest line ("epoch N"). Returns 0
+// when there is no manifest or it does not start with an epoch line
+uint64_t read_manifest_epoch(const std::string& manifest) {
+  std::ifstream file(manifest);
+  std::string tag;
+  uint64_t epoch = 0;
+  if (file >> tag >> epoch && tag == "epoch") {
+    return epoch;
+  }
+  return 0;
+}
+} // namespace
+
+// Background thread that polls the tile manifest epoch and raises the
+// update flag when it changes. It never touches the cache itself - eviction
+// of the changed tiles happens in CheckForTileUpdates on the request thread
+// at a point where no tile pointers are in flight
+struct GraphReader::tile_manifest_watcher_t {
+  tile_manifest_watcher_t(GraphReader& reader, const std::chrono::seconds interval)
+      : reader(reader), interval(interval), stop(false) {
+    thread = std::thread(&tile_manifest_watcher_t::Work, this);
+  }
+
+  ~tile_manifest_watcher_t() {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      stop = true;
+    }
+    signal.notify_one();
+    thread.join();
+  }
+
+  // compare the epoch on disk to the one the cache was loaded under
+  void Work() {
+    auto manifest = reader.tile_dir_ + filesystem::path::preferred_separator + TILE_MANIFEST;
+    while (true) {
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (signal.wait_for(lock, interval, [this] { return stop; })) {
+          return;
+        }
+      }
+      if (read_manifest_epoch(manifest) != reader.manifest_epoch_) {
+        reader.update_pending_.store(true, std::memory_order_release);
+      }
+    }
+  }
+
+  GraphReader& reader;
+  std::chrono::seconds interval;
+  std::thread thread;
+  std::mutex mutex;
+  std::condition_variable signal;
+  bool stop;
+};
+
 std::shared_ptr<const GraphReader::tile_extract_t>
 GraphReader::get_extract_instance(const boost::property_tree::ptree& pt) {
   static std::shared_ptr<const GraphReader::tile_extract_t> tile_extract(
@@ -79,7 +216,7 @@ void SimpleTileCache::Reserve(size_t tile_size) {
 
 // Checks if tile exists in the cache.
 bool SimpleTileCache::Contains(const GraphId& graphid) const {
-  return cache_.find(graphid) != cache_.end();
+  return cache_.find(graphid.tile_value()) != nullptr;
 }
 
 // Lets you know if the cache is too large.
@@ -87,6 +224,19 @@ bool SimpleTileCache::OverCommitted() const {
   return max_cache_size_ < cache_size_;
 }
 
+// Removes a single tile from the cache.
+void SimpleTileCache::Evict(const GraphId& graphid) {
+  auto* cached = cache_.find(graphid.tile_value());
+  if (cached == nullptr) {
+    return;
+  }
+  // sizes are not kept per entry so charge the same size Put was given
+  size_t size =
+      (*cached)->memmapped() ? AVERAGE_MM_TILE_SIZE : (*cached)->header()->end_offset();
+  cache_size_ -= std::min(size, cache_size_);
+  cache_.erase(graphid.tile_value());
+}
+
 // Clears the cache.
 void SimpleTileCache::Clear() {
   cache_size_ = 0;
@@ -95,17 +245,18 @@ void SimpleTileCache::Clear() {
 
 // Get a pointer to a graph tile object given a GraphId.
 const GraphTile* SimpleTileCache::Get(const GraphId& graphid) const {
-  auto cached = cache_.find(graphid);
-  if (cached != cache_.end()) {
-    return &cached->second;
-  }
-  return nullptr;
+  const auto* cached = cache_.find(graphid.tile_value());
+  return cached == nullptr ? nullptr : cached->get();
 }
 
 // Puts a copy of a tile of into the cache.
 const GraphTile* SimpleTileCache::Put(const GraphId& graphid, const GraphTile& tile, size_t size) {
   cache_size_ += size;
-  return &cache_.emplace(graphid, tile).first->second;
+  auto& cached = cache_.emplace(graphid.tile_value());
+  if (!cached) {
+    cached.reset(new GraphTile(tile));
+  }
+  return cached.get();
 }
 
 // Constructor.
@@ -131,6 +282,12 @@ bool SynchronizedTileCache::OverCommitted() const {
   return cache_.OverCommitted();
 }
 
+// Removes a single tile from the cache.
+void SynchronizedTileCache::Evict(const GraphId& graphid) {
+  std::lock_guard<std::mutex> lock(mutex_ref_);
+  cache_.Evict(graphid);
+}
+
 // Clears the cache.
 void SynchronizedTileCache::Clear() {
   std::lock_guard<std::mutex> lock(mutex_ref_);
@@ -150,6 +307,371 @@ SynchronizedTileCache::Put(const GraphId& graphid, const GraphTile& tile, size_t
   return cache_.Put(graphid, tile, size);
 }
 
+// Constructor.
+TileCacheLRU::TileCacheLRU(size_t max_size) : cache_size_(0), max_cache_size_(max_size) {
+}
+
+// Reserves enough cache to hold (max_cache_size / tile_size) items.
+void TileCacheLRU::Reserve(size_t tile_size) {
+  cache_.reserve(max_cache_size_ / tile_size);
+}
+
+// Checks if tile exists in the cache.
+bool TileCacheLRU::Contains(const GraphId& graphid) const {
+  return cache_.find(graphid.value) != cache_.end();
+}
+
+// Lets you know if the cache is too large.
+bool TileCacheLRU::OverCommitted() const {
+  return max_cache_size_ < cache_size_;
+}
+
+// Removes a single tile from the cache and its recency slot.
+void TileCacheLRU::Evict(const GraphId& graphid) {
+  auto cached = cache_.find(graphid.value);
+  if (cached == cache_.end()) {
+    return;
+  }
+  cache_size_ -= cached->second.size;
+  recency_.erase(cached->second.position);
+  cache_.erase(cached);
+}
+
+// Clears the cache.
+void TileCacheLRU::Clear() {
+  cache_size_ = 0;
+  cache_.clear();
+  recency_.clear();
+}
+
+// Evict cold tiles until we fit under the limit again. The hottest tile is
+// never evicted so the pointer just handed out by Put stays valid.
+void TileCacheLRU::TrimToFit() {
+  while (cache_size_ > max_cache_size_ && recency_.size() > 1) {
+    auto evicted = cache_.find(recency_.back());
+    cache_size_ -= evicted->second.size;
+    cache_.erase(evicted);
+    recency_.pop_back();
+  }
+}
+
+// Get a pointer to a graph tile object given a GraphId.
+const GraphTile* TileCacheLRU::Get(const GraphId& graphid) const {
+  auto cached = cache_.find(graphid.value);
+  if (cached == cache_.end()) {
+    return nullptr;
+  }
+  // a hit moves the tile to the hot end of the recency list
+  recency_.splice(recency_.begin(), recency_, cached->second.position);
+  return &cached->second.tile;
+}
+
+// Puts a copy of a tile of into the cache.
+const GraphTile* TileCacheLRU::Put(const GraphId& graphid, const GraphTile& tile, size_t size) {
+  recency_.push_front(graphid.value);
+  auto inserted =
+      cache_.emplace(graphid.value, entry_t{tile, size, recency_.begin()});
+  // replacing an existing entry drops its old recency slot and size
+  if (!inserted.second) {
+    recency_.erase(inserted.first->second.position);
+    cache_size_ -= inserted.first->second.size;
+    inserted.first->second = entry_t{tile, size, recency_.begin()};
+  }
+  cache_size_ += size;
+  TrimToFit();
+  return &inserted.first->second.tile;
+}
+
+// Constructor. Rounds the shard count up to a power of two for cheap masking.
+ShardedTileCache::ShardedTileCache(size_t max_size, size_t shard_count)
+    : shards_(), cache_size_(0), max_cache_size_(max_size) {
+  size_t count = 1;
+  while (count < shard_count) {
+    count <<= 1;
+  }
+  shards_ = std::vector<shard_t>(count);
+}
+
+// Reserves enough cache to hold (max_cache_size / tile_size) items.
+void ShardedTileCache::Reserve(size_t tile_size) {
+  size_t per_shard = (max_cache_size_ / tile_size) / shards_.size() + 1;
+  for (auto& shard : shards_) {
+    std::unique_lock<std::shared_timed_mutex> lock(shard.lock);
+    shard.tiles.reserve(per_shard);
+  }
+}
+
+// Checks if tile exists in the cache.
+bool ShardedTileCache::Contains(const GraphId& graphid) const {
+  auto& s = shard(graphid);
+  std::shared_lock<std::shared_timed_mutex> lock(s.lock);
+  return s.tiles.find(graphid.value) != s.tiles.end();
+}
+
+// Get a pointer to a graph tile object given a GraphId. Readers only take
+// a shared lock on the tile's shard. The returned pointer stays valid under
+// concurrent inserts since the map nodes are stable.
+const GraphTile* ShardedTileCache::Get(const GraphId& graphid) const {
+  auto& s = shard(graphid);
+  std::shared_lock<std::shared_timed_mutex> lock(s.lock);
+  auto cached = s.tiles.find(graphid.value);
+  if (cached != s.tiles.end()) {
+    return &cached->second;
+  }
+  return nullptr;
+}
+
+// Puts a copy of a tile of into the cache.
+const GraphTile* ShardedTileCache::Put(const GraphId& graphid, const GraphTile& tile, size_t size) {
+  auto& s = shard(graphid);
+  std::unique_lock<std::shared_timed_mutex> lock(s.lock);
+  auto inserted = s.tiles.emplace(graphid.value, tile);
+  if (inserted.second) {
+    cache_size_.fetch_add(size, std::memory_order_relaxed);
+  }
+  return &inserted.first->second;
+}
+
+// Lets you know if the cache is too large.
+bool ShardedTileCache::OverCommitted() const {
+  return max_cache_size_ < cache_size_.load(std::memory_order_relaxed);
+}
+
+// Removes a single tile from its shard.
+void ShardedTileCache::Evict(const GraphId& graphid) {
+  auto& s = shard(graphid);
+  std::unique_lock<std::shared_timed_mutex> lock(s.lock);
+  auto cached = s.tiles.find(graphid.value);
+  if (cached == s.tiles.end()) {
+    return;
+  }
+  size_t size = cached->second.memmapped() ? AVERAGE_MM_TILE_SIZE
+                                           : cached->second.header()->end_offset();
+  cache_size_.fetch_sub(size, std::memory_order_relaxed);
+  s.tiles.erase(cached);
+}
+
+// Clears the cache.
+void ShardedTileCache::Clear() {
+  for (auto& shard : shards_) {
+    std::unique_lock<std::shared_timed_mutex> lock(shard.lock);
+    shard.tiles.clear();
+  }
+  cache_size_.store(0, std::memory_order_relaxed);
+}
+
+// The front of the shared memory segment. The index entries follow directly
+// after this and the data arena after those
+struct SharedTileCache::segment_header_t {
+#ifndef _MSC_VER
+  pthread_mutex_t lock;
+#endif
+  uint64_t magic;         // set last, under the lock, to signal initialization
+  uint64_t index_count;   // number of index slots
+  uint64_t alloc_offset;  // bump allocator position within the arena
+  uint64_t arena_size;    // size of the data arena in bytes
+};
+
+// A slot in the open addressed index
+struct SharedTileCache::index_entry_t {
+  uint64_t graphid; // kInvalidGraphId marks an empty slot
+  uint64_t offset;  // offset of the tile bytes within the arena
+  uint64_t size;    // size of the tile bytes
+};
+
+#ifndef _MSC_VER
+
+namespace {
+constexpr uint64_t SHARED_CACHE_MAGIC = 0x76616c68616c6c61; // "valhalla"
+// marks an index slot whose tile was evicted. Neither a match nor an empty
+// slot, so probe chains walk over it and the slot is simply leaked
+constexpr uint64_t EVICTED_GRAPHID = kInvalidGraphId - 1;
+
+// scoped process-shared lock
+struct shared_lock_t {
+  shared_lock_t(pthread_mutex_t& lock) : lock_(lock) {
+    pthread_mutex_lock(&lock_);
+  }
+  ~shared_lock_t() {
+    pthread_mutex_unlock(&lock_);
+  }
+  pthread_mutex_t& lock_;
+};
+} // namespace
+
+// Constructor. Creates or attaches to the named segment.
+SharedTileCache::SharedTileCache(const std::string& segment_name, size_t max_size)
+    : segment_name_(segment_name), max_cache_size_(max_size), header_(nullptr) {
+  // twice as many slots as the expected tile count keeps probe chains short
+  size_t index_count = std::max<size_t>(1024, (max_size / AVERAGE_TILE_SIZE) * 2);
+  segment_size_ =
+      sizeof(segment_header_t) + index_count * sizeof(index_entry_t) + max_cache_size_;
+
+  // first creator gets to initialize, everyone else just attaches
+  bool creator = true;
+  int fd = shm_open(segment_name_.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+  if (fd == -1 && errno == EEXIST) {
+    creator = false;
+    fd = shm_open(segment_name_.c_str(), O_RDWR, 0644);
+  }
+  if (fd == -1) {
+    throw std::runtime_error(segment_name_ + "(shm_open): " + strerror(errno));
+  }
+  if (creator && ftruncate(fd, segment_size_) == -1) {
+    close(fd);
+    throw std::runtime_error(segment_name_ + "(ftruncate): " + strerror(errno));
+  }
+
+  void* base = mmap(nullptr, segment_size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (base == MAP_FAILED) {
+    throw std::runtime_error(segment_name_ + "(mmap): " + strerror(errno));
+  }
+  header_ = static_cast<segment_header_t*>(base);
+
+  // initialize the header, index and process-shared lock exactly once
+  if (creator) {
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+    pthread_mutex_init(&header_->lock, &attr);
+    pthread_mutexattr_destroy(&attr);
+
+    header_->index_count = index_count;
+    header_->alloc_offset = 0;
+    header_->arena_size = max_cache_size_;
+    auto* entries = reinterpret_cast<index_entry_t*>(header_ + 1);
+    for (size_t i = 0; i < index_count; ++i) {
+      entries[i].graphid = kInvalidGraphId;
+    }
+    __sync_synchronize();
+    header_->magic = SHARED_CACHE_MAGIC;
+  } // spin briefly until the creator finishes initializing
+  else {
+    while (header_->magic != SHARED_CACHE_MAGIC) {
+      sched_yield();
+    }
+  }
+}
+
+// Destructor. The segment stays alive for the other processes.
+SharedTileCache::~SharedTileCache() {
+  if (header_) {
+    munmap(header_, segment_size_);
+  }
+}
+
+// Find the slot for a graphid via linear probing. Lock must be held.
+SharedTileCache::index_entry_t* SharedTileCache::FindSlot(const GraphId& graphid) const {
+  auto* entries = reinterpret_cast<index_entry_t*>(header_ + 1);
+  size_t start = std::hash<uint64_t>()(graphid.value) % header_->index_count;
+  for (size_t probe = 0; probe < header_->index_count; ++probe) {
+    auto* entry = &entries[(start + probe) % header_->index_count];
+    if (entry->graphid == graphid.value || entry->graphid == kInvalidGraphId) {
+      return entry;
+    }
+  }
+  return nullptr;
+}
+
+// Reserve space in the local view map.
+void SharedTileCache::Reserve(size_t tile_size) {
+  views_.reserve(max_cache_size_ / tile_size);
+}
+
+// Checks if tile exists in the cache.
+bool SharedTileCache::Contains(const GraphId& graphid) const {
+  if (views_.find(graphid.value) != views_.end()) {
+    return true;
+  }
+  shared_lock_t lock(header_->lock);
+  auto* entry = FindSlot(graphid);
+  return entry && entry->graphid == graphid.value;
+}
+
+// Get a pointer to a graph tile object given a GraphId.
+const GraphTile* SharedTileCache::Get(const GraphId& graphid) const {
+  // a view over the shared bytes may already exist in this process
+  auto cached = views_.find(graphid.value);
+  if (cached != views_.end()) {
+    return &cached->second;
+  }
+
+  // another process may have put the bytes into the shared arena
+  uint64_t offset, size;
+  {
+    shared_lock_t lock(header_->lock);
+    auto* entry = FindSlot(graphid);
+    if (!entry || entry->graphid != graphid.value) {
+      return nullptr;
+    }
+    offset = entry->offset;
+    size = entry->size;
+  }
+
+  // build a local view over the shared bytes, they are immutable once indexed
+  char* arena = reinterpret_cast<char*>(header_ + 1) + header_->index_count * sizeof(index_entry_t);
+  GraphTile tile(graphid, arena + offset, size);
+  return &views_.emplace(graphid.value, std::move(tile)).first->second;
+}
+
+// Puts a copy of a tile of into the cache.
+const GraphTile* SharedTileCache::Put(const GraphId& graphid, const GraphTile& tile, size_t size) {
+  const char* bytes = reinterpret_cast<const char*>(tile.header());
+  size_t tile_size = tile.header()->end_offset();
+
+  char* arena = reinterpret_cast<char*>(header_ + 1) + header_->index_count * sizeof(index_entry_t);
+  {
+    shared_lock_t lock(header_->lock);
+    auto* entry = FindSlot(graphid);
+    // someone else may have raced us to it, use theirs
+    if (entry && entry->graphid == graphid.value) {
+      GraphTile shared(graphid, arena + entry->offset, entry->size);
+      return &views_.emplace(graphid.value, std::move(shared)).first->second;
+    }
+    // claim space in the arena if there is any left
+    if (entry && header_->alloc_offset + tile_size <= header_->arena_size) {
+      uint64_t offset = header_->alloc_offset;
+      header_->alloc_offset += tile_size;
+      memcpy(arena + offset, bytes, tile_size);
+      entry->graphid = graphid.value;
+      entry->offset = offset;
+      entry->size = tile_size;
+      GraphTile shared(graphid, arena + offset, tile_size);
+      return &views_.emplace(graphid.value, std::move(shared)).first->second;
+    }
+  }
+
+  // arena or index is full, keep a process local copy instead
+  return &views_.emplace(graphid.value, tile).first->second;
+}
+
+// Lets you know if the cache is too large.
+bool SharedTileCache::OverCommitted() const {
+  shared_lock_t lock(header_->lock);
+  return header_->alloc_offset >= header_->arena_size;
+}
+
+// Drops the local view of a tile and tombstones its index slot so the next
+// Get in any process that also dropped its view re-reads the tile from disk.
+// The old bytes stay in the arena (the bump allocator cannot free) so views
+// held by processes that have not evicted yet remain valid.
+void SharedTileCache::Evict(const GraphId& graphid) {
+  views_.erase(graphid.value);
+  shared_lock_t lock(header_->lock);
+  auto* entry = FindSlot(graphid);
+  if (entry && entry->graphid == graphid.value) {
+    entry->graphid = EVICTED_GRAPHID;
+  }
+}
+
+// Clears the local views, the shared segment is left for the other processes.
+void SharedTileCache::Clear() {
+  views_.clear();
+}
+
+#endif // !_MSC_VER
+
 // Constructs tile cache.
 TileCache* TileCacheFactory::createTileCache(const boost::property_tree::ptree& pt) {
   static std::mutex globalCacheMutex_;
@@ -157,6 +679,34 @@ TileCache* TileCacheFactory::createTileCache(const boost::property_tree::ptree&
 
   size_t max_cache_size = pt.get<size_t>("max_cache_size", DEFAULT_MAX_CACHE_SIZE);
 
+#ifndef _MSC_VER
+  // share the cached tile bytes with every other process on the host
+  auto shared_cache_name = pt.get_optional<std::string>("shared_cache_name");
+  if (shared_cache_name) {
+    return new SharedTileCache(*shared_cache_name, max_cache_size);
+  }
+#endif
+
+  // cache with true least-recently-used eviction
+  if (pt.get<bool>("use_lru_mem_cache", false)) {
+    if (pt.get<bool>("global_synchronized_cache", false)) {
+      static std::mutex globalLruMutex_;
+      static std::shared_ptr<TileCache> globalLruCache_;
+      if (!globalLruCache_) {
+        globalLruCache_.reset(new TileCacheLRU(max_cache_size));
+      }
+      return new SynchronizedTileCache(*globalLruCache_, globalLruMutex_);
+    }
+    return new TileCacheLRU(max_cache_size);
+  }
+
+  // concurrent cache with per-shard locking, readers never block each other
+  if (pt.get<bool>("sharded_cache", false)) {
+    return new ShardedTileCache(max_cache_size,
+                                pt.get<size_t>("cache_shards",
+                                               ShardedTileCache::kDefaultShardCount));
+  }
+
   // wrap tile cache with thread-safe version
   if (pt.get<bool>("global_synchronized_cache", false)) {
     if (!globalTileCache_) {
@@ -172,10 +722,181 @@ TileCache* TileCacheFactory::createTileCache(const boost::property_tree::ptree&
 // Constructor using separate tile files
 GraphReader::GraphReader(const boost::property_tree::ptree& pt)
     : tile_url_(pt.get<std::string>("tile_url", "")), tile_dir_(pt.get<std::string>("tile_dir")),
-      tile_extract_(get_extract_instance(pt)), cache_(TileCacheFactory::createTileCache(pt)) {
+      mmap_tiles_(pt.get<bool>("mmap_tiles", false)), tile_extract_(get_extract_instance(pt)),
+      shape_cache_size_(pt.get<size_t>("shape_cache_size", 1024)),
+      manifest_epoch_(0), update_pending_(false),
+      concurrent_(pt.get<bool>("sharded_cache", false) ||
+                  pt.get<bool>("global_synchronized_cache", false)),
+      cache_(TileCacheFactory::createTileCache(pt)) {
   // Reserve cache (based on whether using individual tile files or shared,
   // mmap'd file
   cache_->Reserve(tile_extract_->tiles.empty() ? AVERAGE_TILE_SIZE : AVERAGE_MM_TILE_SIZE);
+
+  // An extract already knows its tiles, otherwise try the sidecar index the
+  // tile build leaves behind so we can skip statting files and walking dirs
+  if (tile_extract_->tiles.empty() && tile_index_.from_file(tile_dir_)) {
+    LOG_INFO("Tile index found with " + std::to_string(tile_index_.tiles().size()) + " tiles");
+  }
+
+  // Map the live speed overlay a feeder process maintains beside the tiles.
+  // Its speeds are attached to every tile this reader caches
+  auto overlay_file = pt.get<std::string>("traffic_overlay", "");
+  if (!overlay_file.empty() && speed_overlay_.from_file(overlay_file)) {
+    LOG_INFO("Speed overlay mapped at generation " + std::to_string(speed_overlay_.generation()));
+  }
+
+  // Warm tiles ahead of the search frontier. Only safe with a cache that
+  // tolerates concurrent access
+  if (pt.get<bool>("prefetch_tiles", false) && concurrent_) {
+    prefetcher_.reset(new tile_prefetcher_t(*this));
+  }
+
+  // Watch the tile manifest so updated tiles can be hot-applied between
+  // requests. Tiles in a tar extract are one immutable mmap, no hot reload
+  auto poll_seconds = pt.get<uint64_t>("tile_manifest_poll_seconds", 0);
+  if (poll_seconds > 0 && tile_extract_->tiles.empty()) {
+    manifest_epoch_ = read_manifest_epoch(tile_dir_ + filesystem::path::preferred_separator +
+                                          TILE_MANIFEST);
+    manifest_watcher_.reset(new tile_manifest_watcher_t(*this, std::chrono::seconds(poll_seconds)));
+  }
+
+  // Optionally warm the cache before serving the first request
+  if (pt.get<bool>("preload_tiles", false)) {
+    PreloadTiles(pt.get<size_t>("preload_concurrency", 0));
+  }
+}
+
+GraphReader::~GraphReader() {
+}
+
+// Warm the cache by loading tiles up front on a pool of threads.
+size_t GraphReader::PreloadTiles(size_t concurrency) {
+  // tiles in the extract are already a single mmap, nothing to warm
+  if (!tile_extract_->tiles.empty()) {
+    return 0;
+  }
+
+  // the tiles on disk, in a deterministic order so runs are comparable
+  auto tile_set = GetTileSet();
+  std::vector<GraphId> tile_ids(tile_set.begin(), tile_set.end());
+  std::sort(tile_ids.begin(), tile_ids.end(),
+            [](const GraphId& a, const GraphId& b) { return a.value < b.value; });
+
+  if (concurrency == 0) {
+    concurrency = std::max<size_t>(1, std::thread::hardware_concurrency());
+  }
+
+  // loader threads read tiles from disk, the cache insert is serialized so
+  // this works with every cache implementation
+  std::atomic<size_t> next(0);
+  std::atomic<bool> full(false);
+  std::mutex put_lock;
+  size_t loaded = 0;
+  auto loader = [&]() {
+    size_t i;
+    while (!full.load(std::memory_order_relaxed) && (i = next.fetch_add(1)) < tile_ids.size()) {
+      GraphTile tile(tile_dir_, tile_ids[i], mmap_tiles_);
+      if (!tile.header()) {
+        continue;
+      }
+      AttachSpeedOverlay(tile, tile_ids[i]);
+      size_t size = tile.memmapped() ? AVERAGE_MM_TILE_SIZE : tile.header()->end_offset();
+      std::lock_guard<std::mutex> lock(put_lock);
+      if (cache_->OverCommitted()) {
+        full.store(true, std::memory_order_relaxed);
+        return;
+      }
+      if (!cache_->Contains(tile_ids[i])) {
+        cache_->Put(tile_ids[i], tile, size);
+        ++loaded;
+      }
+    }
+  };
+
+  std::vector<std::thread> threads;
+  threads.reserve(concurrency);
+  for (size_t t = 0; t < concurrency; ++t) {
+    threads.emplace_back(loader);
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  LOG_INFO("Preloaded " + std::to_string(loaded) + " tiles into the cache");
+  return loaded;
+}
+
+// Evict the tiles a new manifest epoch lists as changed so they reload
+// from disk on their next request. Only call between requests - in-flight
+// tile pointers would dangle
+bool GraphReader::CheckForTileUpdates() {
+  // pick up a newer speed overlay generation if the feeder swapped one in.
+  // Cached tiles point at the old generation's speeds, so drop them and let
+  // their next load attach the new ones
+  bool overlay_applied = speed_overlay_.refresh();
+  if (overlay_applied) {
+    cache_->Clear();
+    ++cache_generation();
+    LOG_INFO("Applied speed overlay generation " + std::to_string(speed_overlay_.generation()));
+  }
+
+  // cheap check so per-request callers pay next to nothing
+  if (!update_pending_.load(std::memory_order_acquire)) {
+    return overlay_applied;
+  }
+
+  auto manifest = tile_dir_ + filesystem::path::preferred_separator + TILE_MANIFEST;
+  std::ifstream file(manifest);
+  std::string tag;
+  uint64_t epoch = 0;
+  if (!(file >> tag >> epoch) || tag != "epoch" || epoch == manifest_epoch_) {
+    // the manifest went away or never changed after all, nothing to apply
+    update_pending_.store(false, std::memory_order_release);
+    return overlay_applied;
+  }
+
+  // evict each changed tile, the next request for it loads the new file
+  size_t evicted = 0;
+  std::string suffix;
+  while (file >> suffix) {
+    try {
+      auto base = GraphTile::GetTileId(suffix).Tile_Base();
+      cache_->Evict(base);
+      _404s.erase(base);
+      ++evicted;
+    } catch (...) {
+      LOG_WARN("Skipping unparseable tile manifest line: " + suffix);
+    }
+  }
+
+  // decoded shapes and per-thread tile handles may point at the old tiles
+  shape_cache_.clear();
+  shape_cache_lru_.clear();
+  ++cache_generation();
+
+  manifest_epoch_.store(epoch, std::memory_order_release);
+  update_pending_.store(false, std::memory_order_release);
+  LOG_INFO("Applied tile manifest epoch " + std::to_string(epoch) + ", evicted " +
+           std::to_string(evicted) + " updated tiles");
+  return true;
+}
+
+// Attach any live speeds the overlay has for a tile before it is cached
+void GraphReader::AttachSpeedOverlay(GraphTile& tile, const GraphId& base) const {
+  if (speed_overlay_.empty()) {
+    return;
+  }
+  auto speeds = speed_overlay_.tile_speeds(base);
+  if (speeds.speeds != nullptr) {
+    tile.SetSpeedOverlay(speeds.speeds, speeds.count, std::move(speeds.anchor));
+  }
+}
+
+// Hint that a tile is likely to be requested soon.
+void GraphReader::Prefetch(const GraphId& graphid) {
+  if (prefetcher_ && graphid.Is_Valid()) {
+    prefetcher_->Enqueue(graphid.Tile_Base());
+  }
 }
 
 // Method to test if tile exists
@@ -187,6 +908,10 @@ bool GraphReader::DoesTileExist(const GraphId& graphid) const {
   if (!tile_extract_->tiles.empty()) {
     return tile_extract_->tiles.find(graphid) != tile_extract_->tiles.cend();
   }
+  // the sidecar index knows every tile that existed at build time
+  if (!tile_index_.tiles().empty()) {
+    return tile_index_.contains(graphid);
+  }
   // otherwise check memory or disk
   if (cache_->Contains(graphid)) {
     return true;
@@ -195,6 +920,7 @@ bool GraphReader::DoesTileExist(const GraphId& graphid) const {
       tile_dir_ + filesystem::path::preferred_separator + GraphTile::FileSuffix(graphid.Tile_Base());
   struct stat buffer;
   return stat(file_location.c_str(), &buffer) == 0 ||
+         stat((file_location + ".gzs").c_str(), &buffer) == 0 ||
          stat((file_location + ".gz").c_str(), &buffer) == 0;
 }
 
@@ -213,9 +939,28 @@ bool GraphReader::DoesTileExist(const boost::property_tree::ptree& pt, const Gra
                               GraphTile::FileSuffix(graphid.Tile_Base());
   struct stat buffer;
   return stat(file_location.c_str(), &buffer) == 0 ||
+         stat((file_location + ".gzs").c_str(), &buffer) == 0 ||
          stat((file_location + ".gz").c_str(), &buffer) == 0;
 }
 
+namespace {
+// Tiny per-thread, direct-mapped cache of the tile handles a thread touched
+// last. When a reader is shared between threads this sits in front of the
+// shared (locked or sharded) cache so the tight loops that revisit the same
+// few tiles - the pattern the algorithms' current-tile locals exploit -
+// never take the shared cache's lock at all. Slots are validated against
+// the owning reader and the process-wide cache generation, so a cleared or
+// updated cache just causes a refill on the next lookup
+struct tile_handle_t {
+  const void* reader;    // the reader the handle came from
+  uint64_t generation;   // GraphReader::cache_generation() at fill time
+  uint64_t graphid;      // tile base graphid value
+  const GraphTile* tile; // the handle itself
+};
+constexpr size_t kTileHandleSlots = 16; // must be a power of two
+thread_local tile_handle_t tile_handles[kTileHandleSlots] = {};
+} // namespace
+
 // Get a pointer to a graph tile object given a GraphId. Return nullptr
 // if the tile is not found/empty
 const GraphTile* GraphReader::GetGraphTile(const GraphId& graphid) {
@@ -225,53 +970,145 @@ const GraphTile* GraphReader::GetGraphTile(const GraphId& graphid) {
   if (!graphid.Is_Valid()) {
     return nullptr;
   }
+  auto base = graphid.Tile_Base();
+
+  // When the reader is shared the per-thread handle cache short circuits
+  // the trip (and any lock) into the shared cache
+  tile_handle_t* handle = nullptr;
+  uint64_t generation = 0;
+  if (concurrent_) {
+    generation = cache_generation().load(std::memory_order_acquire);
+    handle = &tile_handles[(base.value ^ (reinterpret_cast<uintptr_t>(this) >> 4)) &
+                           (kTileHandleSlots - 1)];
+    if (handle->reader == this && handle->graphid == base.value &&
+        handle->generation == generation && handle->tile != nullptr) {
+      return handle->tile;
+    }
+  }
 
   // Check if the level/tileid combination is in the cache
-  auto base = graphid.Tile_Base();
   if (auto cached = cache_->Get(base)) {
+    RecordTileAccess(base, statistics_.hits);
+    if (handle) {
+      *handle = {this, generation, base.value, cached};
+    }
     return cached;
   }
+  RecordTileAccess(base, statistics_.misses);
 
   // Try getting it from the memmapped tar extract
   if (!tile_extract_->tiles.empty()) {
     // Do we have this tile
     auto t = tile_extract_->tiles.find(base);
     if (t == tile_extract_->tiles.cend()) {
+      BumpStatistic(statistics_.not_found);
       return nullptr;
     }
 
     // This initializes the tile from mmap
     GraphTile tile(base, t->second.first, t->second.second);
     if (!tile.header()) {
+      BumpStatistic(statistics_.not_found);
       return nullptr;
     }
 
     // Keep a copy in the cache and return it
+    AttachSpeedOverlay(tile, base);
     size_t size = AVERAGE_MM_TILE_SIZE; // tile.end_offset();  // TODO what size??
     auto inserted = cache_->Put(base, tile, size);
+    if (handle) {
+      *handle = {this, generation, base.value, inserted};
+    }
     return inserted;
   } // Try getting it from flat file
   else {
-    // This reads the tile from disk
-    GraphTile tile(tile_dir_, base);
+    // This reads the tile from disk, either copying it or mapping it read-only
+    GraphTile tile(tile_dir_, base, mmap_tiles_);
     if (!tile.header()) {
-      if (tile_url_.empty() || _404s.find(base) != _404s.end()) {
+      if (tile_url_.empty()) {
+        BumpStatistic(statistics_.not_found);
+        return nullptr;
+      }
+      // The curler is a single handle and the 404 set is per reader, so a
+      // shared reader fetches remote tiles one at a time
+      std::unique_lock<std::mutex> fetch_lock(curler_mutex_, std::defer_lock);
+      if (concurrent_) {
+        fetch_lock.lock();
+      }
+      if (_404s.find(base) != _404s.end()) {
+        BumpStatistic(statistics_.not_found);
         return nullptr;
       }
       tile = GraphTile(tile_url_, base, curler);
       if (!tile.header()) {
         _404s.insert(base);
+        BumpStatistic(statistics_.not_found);
         return nullptr;
       }
     }
 
-    // Keep a copy in the cache and return it
-    size_t size = tile.header()->end_offset();
+    // Keep a copy in the cache and return it. Mapped tiles cost the cache
+    // next to nothing since the bytes stay in the page cache
+    AttachSpeedOverlay(tile, base);
+    size_t size = tile.memmapped() ? AVERAGE_MM_TILE_SIZE : tile.header()->end_offset();
     auto inserted = cache_->Put(base, tile, size);
+    if (handle) {
+      *handle = {this, generation, base.value, inserted};
+    }
     return inserted;
   }
 }
 
+// Bump one statistics counter, locking when the reader is shared
+void GraphReader::BumpStatistic(size_t& counter) {
+  std::unique_lock<std::mutex> lock(statistics_mutex_, std::defer_lock);
+  if (concurrent_) {
+    lock.lock();
+  }
+  ++counter;
+}
+
+// Record a cache access for a tile, locking when the reader is shared
+void GraphReader::RecordTileAccess(const GraphId& base, size_t& counter) {
+  std::unique_lock<std::mutex> lock(statistics_mutex_, std::defer_lock);
+  if (concurrent_) {
+    lock.lock();
+  }
+  ++statistics_.tile_accesses[base.value];
+  ++counter;
+}
+
+// One process-wide generation for handed out tile handles. Any reader
+// dropping tiles bumps it - tile caches can be shared between readers so a
+// per-reader count could miss another reader clearing tiles under this one
+std::atomic<uint64_t>& GraphReader::cache_generation() {
+  static std::atomic<uint64_t> generation{0};
+  return generation;
+}
+
+// Get the n most frequently accessed tiles, hottest first.
+std::vector<std::pair<GraphId, uint64_t>> GraphReader::HottestTiles(size_t n) const {
+  std::unique_lock<std::mutex> lock(statistics_mutex_, std::defer_lock);
+  if (concurrent_) {
+    lock.lock();
+  }
+  std::vector<std::pair<GraphId, uint64_t>> hottest;
+  hottest.reserve(statistics_.tile_accesses.size());
+  for (const auto& access : statistics_.tile_accesses) {
+    hottest.emplace_back(GraphId(access.first), access.second);
+  }
+  auto hotter = [](const std::pair<GraphId, uint64_t>& a, const std::pair<GraphId, uint64_t>& b) {
+    return a.second > b.second;
+  };
+  if (hottest.size() > n) {
+    std::partial_sort(hottest.begin(), hottest.begin() + n, hottest.end(), hotter);
+    hottest.resize(n);
+  } else {
+    std::sort(hottest.begin(), hottest.end(), hotter);
+  }
+  return hottest;
+}
+
 // Convenience method to get an opposing directed edge graph Id.
 GraphId GraphReader::GetOpposingEdgeId(const GraphId& edgeid, const GraphTile*& tile) {
   // If you cant get the tile you get an invalid id
@@ -471,6 +1308,49 @@ std::pair<GraphId, GraphId> GraphReader::GetDirectedEdgeNodes(const GraphTile* t
   return std::make_pair(start_node, end_node);
 }
 
+// Get the decoded shape of an edge via a small per-reader LRU.
+const std::vector<midgard::PointLL>& GraphReader::edgeshape(const GraphTile* tile,
+                                                            const DirectedEdge* edge) {
+  // a shared reader cannot hand out references into per-reader scratch or
+  // reorder the lru under other threads, so each thread decodes into its
+  // own scratch instead and the shape cache sits this mode out
+  if (concurrent_) {
+    static thread_local std::vector<midgard::PointLL> shape;
+    shape = tile->edgeinfo(edge->edgeinfo_offset()).shape();
+    return shape;
+  }
+
+  // cache disabled, decode into a scratch buffer
+  if (shape_cache_size_ == 0) {
+    uncached_shape_ = tile->edgeinfo(edge->edgeinfo_offset()).shape();
+    return uncached_shape_;
+  }
+
+  // key on the tile id and edge info offset (values rather than pointers so
+  // entries remain valid if the tile cache evicts and reloads the tile)
+  uint64_t key =
+      (static_cast<uint64_t>(tile->id().Tile_Base().value) << 32) | edge->edgeinfo_offset();
+  auto cached = shape_cache_.find(key);
+  if (cached != shape_cache_.end()) {
+    // promote to most recently used
+    shape_cache_lru_.splice(shape_cache_lru_.begin(), shape_cache_lru_, cached->second.lru);
+    return cached->second.shape;
+  }
+
+  // evict the least recently used entry to make room
+  if (shape_cache_.size() >= shape_cache_size_) {
+    shape_cache_.erase(shape_cache_lru_.back());
+    shape_cache_lru_.pop_back();
+  }
+
+  // decode the shape once and remember it
+  shape_cache_lru_.push_front(key);
+  auto& entry = shape_cache_[key];
+  entry.shape = tile->edgeinfo(edge->edgeinfo_offset()).shape();
+  entry.lru = shape_cache_lru_.begin();
+  return entry.shape;
+}
+
 // Note: this will grab all road tiles and transit tiles.
 std::unordered_set<GraphId> GraphReader::GetTileSet() const {
   // either mmap'd tiles
@@ -479,6 +1359,11 @@ std::unordered_set<GraphId> GraphReader::GetTileSet() const {
     for (const auto& t : tile_extract_->tiles) {
       tiles.emplace(t.first);
     }
+  } // or the sidecar index saved us the directory walk
+  else if (!tile_index_.tiles().empty()) {
+    for (const auto& t : tile_index_.tiles()) {
+      tiles.emplace(t.first);
+    }
   } // or individually on disk
   else {
     // for each level
@@ -513,7 +1398,13 @@ std::unordered_set<GraphId> GraphReader::GetTileSet(const uint8_t level) const {
       if (static_cast<GraphId>(t.first).level() == level) {
         tiles.emplace(t.first);
       }
-    } // or individually on disk
+    } // or the sidecar index saved us the directory walk
+  } else if (!tile_index_.tiles().empty()) {
+    for (const auto& t : tile_index_.tiles()) {
+      if (static_cast<GraphId>(t.first).level() == level) {
+        tiles.emplace(t.first);
+      }
+    }
   } else {
     // crack open this level of tiles directory
     filesystem::path root_dir(tile_dir_ + filesystem::path::preferred_separator +
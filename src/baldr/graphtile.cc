@@ -7,6 +7,7 @@
 #include "midgard/pointll.h"
 #include "midgard/tiles.h"
 
+#include <array>
 #include <boost/algorithm/string.hpp>
 #include <cmath>
 #include <ctime>
@@ -14,6 +15,7 @@
 #include <iomanip>
 #include <iostream>
 #include <locale>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -36,6 +38,147 @@ constexpr float COMPRESSION_HINT = 3.5f;
 namespace valhalla {
 namespace baldr {
 
+// The deflated blocks of a sectioned compressed tile along with what is
+// needed to inflate each one into its place in the tile buffer on first
+// access
+struct GraphTile::lazy_sections_t {
+  // the deflated blocks back to back in section order
+  std::vector<char> compressed;
+  // raw ranges and deflated block sizes as read from the section table
+  std::array<SectionRecord, kSectionCount> sections;
+  // where each deflated block starts within the compressed bytes
+  std::array<uint64_t, kSectionCount> offsets;
+  // each section inflates exactly once no matter how many readers race
+  std::array<std::once_flag, kSectionCount> once;
+};
+
+// Inflate one section of a sectioned compressed tile into its place in the
+// tile buffer. Concurrent readers of a shared tile block here until the
+// bytes are resident
+void GraphTile::MaterializeSection(const size_t section) const {
+  auto& state = *lazy_sections_;
+  std::call_once(state.once[section], [&]() {
+    const auto& record = state.sections[section];
+    if (record.raw_size == 0) {
+      return;
+    }
+
+    // the whole deflated block is in memory already
+    auto src_func = [&](z_stream& s) -> void {
+      s.next_in =
+          static_cast<Byte*>(static_cast<void*>(state.compressed.data() + state.offsets[section]));
+      s.avail_in = static_cast<unsigned int>(record.comp_size);
+    };
+
+    // the exact inflated size is known so the section's slot in the tile
+    // buffer is handed out whole; a single spare byte catches blocks that
+    // inflate larger than the table claims without touching the next
+    // section's bytes
+    char spare;
+    uint64_t inflated = 0;
+    auto dst_func = [&](z_stream& s) -> int {
+      inflated = s.total_out;
+      if (s.total_out == 0) {
+        s.next_out = static_cast<Byte*>(static_cast<void*>(graphtile_->data() + record.raw_offset));
+        s.avail_out = static_cast<unsigned int>(record.raw_size);
+      } else {
+        s.next_out = static_cast<Byte*>(static_cast<void*>(&spare));
+        s.avail_out = 1;
+      }
+      return Z_NO_FLUSH;
+    };
+
+    if (!baldr::inflate(src_func, dst_func) || inflated != record.raw_size) {
+      throw std::runtime_error("Failed to inflate section " + std::to_string(section) +
+                               " of a sectioned compressed tile");
+    }
+  });
+}
+
+// Where each section starts within a flat tile. The fixed size record
+// arrays in front of the signs have no offsets in the header so their
+// extent is accumulated from the counts, the variable sized sections
+// behind them are located by their header offsets
+std::array<uint64_t, GraphTile::kSectionCount + 1>
+GraphTile::SectionBounds(const GraphTileHeader& header, const uint64_t tile_size) {
+  uint64_t signs = sizeof(GraphTileHeader) + header.nodecount() * sizeof(NodeInfo) +
+                   header.transitioncount() * sizeof(NodeTransition) +
+                   header.directededgecount() * sizeof(DirectedEdge) +
+                   (header.has_ext_directededge()
+                        ? header.directededgecount() * sizeof(DirectedEdgeExt)
+                        : 0) +
+                   header.access_restriction_count() * sizeof(AccessRestriction) +
+                   header.departurecount() * sizeof(TransitDeparture) +
+                   header.stopcount() * sizeof(TransitStop) +
+                   header.routecount() * sizeof(TransitRoute) +
+                   header.schedulecount() * sizeof(TransitSchedule) +
+                   header.transfercount() * sizeof(TransitTransfer);
+  uint64_t bins =
+      signs + header.signcount() * sizeof(Sign) + header.turnlane_count() * sizeof(TurnLanes);
+  return {{0, signs, bins, header.edgeinfo_offset(), header.textlist_offset(),
+           header.lane_connectivity_offset(), tile_size}};
+}
+
+// Load a sectioned compressed tile. The section table and the deflated
+// blocks are read into memory, the sections Initialize and path finding
+// need are inflated right away and the rest inflate on first access
+bool GraphTile::LoadSectioned(const GraphId& graphid, std::istream& file) {
+  uint32_t front[4] = {0, 0, 0, 0}; // magic, version, section count, reserved
+  file.read(reinterpret_cast<char*>(front), sizeof(front));
+  if (!file || front[0] != kSectionedTileMagic || front[1] != kSectionedTileVersion ||
+      front[2] != kSectionCount) {
+    return false;
+  }
+
+  // the table must describe contiguous sections covering the whole tile
+  auto state = std::make_shared<lazy_sections_t>();
+  file.read(reinterpret_cast<char*>(state->sections.data()),
+            sizeof(SectionRecord) * kSectionCount);
+  uint64_t raw_size = 0, comp_size = 0;
+  for (size_t i = 0; i < kSectionCount; ++i) {
+    if (!file || state->sections[i].raw_offset != raw_size) {
+      return false;
+    }
+    state->offsets[i] = comp_size;
+    raw_size += state->sections[i].raw_size;
+    comp_size += state->sections[i].comp_size;
+  }
+
+  // slurp the deflated blocks and allocate the full tile buffer. Sections
+  // that never materialize stay untouched zero pages so they cost address
+  // space but no resident memory
+  state->compressed.resize(comp_size);
+  file.read(state->compressed.data(), comp_size);
+  if (!file) {
+    return false;
+  }
+  graphtile_.reset(new std::vector<char>(raw_size));
+  lazy_sections_ = std::move(state);
+
+  // the fixed and bin sections hold everything Initialize and path finding
+  // touch, including the complex restrictions Initialize indexes. The sign
+  // section between them stays deflated until narrative generation asks
+  // for it. Transit tiles read names during Initialize which pulls that
+  // section in through the accessors
+  MaterializeSection(kSectionFixed);
+  MaterializeSection(kSectionBins);
+  Initialize(graphid, graphtile_->data(), graphtile_->size());
+
+  // if the section boundaries do not line up with this header's offsets the
+  // lazy mapping cannot be trusted, make everything resident right away
+  const auto bounds = SectionBounds(*header_, graphtile_->size());
+  for (size_t i = 0; i < kSectionCount; ++i) {
+    if (bounds[i] != lazy_sections_->sections[i].raw_offset) {
+      LOG_WARN("Sectioned tile boundaries disagree with the tile header, inflating everything");
+      for (size_t j = 0; j < kSectionCount; ++j) {
+        MaterializeSection(j);
+      }
+      break;
+    }
+  }
+  return true;
+}
+
 // Default constructor
 GraphTile::GraphTile()
     : header_(nullptr), nodes_(nullptr), directededges_(nullptr), transitions_(nullptr),
@@ -49,7 +192,8 @@ GraphTile::GraphTile()
 }
 
 // Constructor given a filename. Reads the graph data into memory.
-GraphTile::GraphTile(const std::string& tile_dir, const GraphId& graphid) : header_(nullptr) {
+GraphTile::GraphTile(const std::string& tile_dir, const GraphId& graphid, const bool memmap)
+    : header_(nullptr) {
 
   // Don't bother with invalid ids
   if (!graphid.Is_Valid() || graphid.level() > TileHierarchy::get_max_level()) {
@@ -59,6 +203,20 @@ GraphTile::GraphTile(const std::string& tile_dir, const GraphId& graphid) : head
   // Open to the end of the file so we can immediately get size;
   std::string file_location =
       tile_dir + filesystem::path::preferred_separator + FileSuffix(graphid.Tile_Base());
+
+  // Map the flat file read-only so the pages are shared across processes and
+  // fix the internal pointers up against the mapped region directly
+  if (memmap) {
+    struct stat s;
+    if (stat(file_location.c_str(), &s) == 0 && s.st_size > 0) {
+      memmap_ = std::make_shared<midgard::mem_map<char>>(file_location, s.st_size,
+                                                         POSIX_MADV_RANDOM, true);
+      Initialize(graphid, memmap_->get(), memmap_->size());
+      return;
+    }
+    // no flat file to map, fall through to the buffered/gzip path
+  }
+
   std::ifstream file(file_location, std::ios::in | std::ios::binary | std::ios::ate);
   if (file.is_open()) {
     // Read binary file into memory. TODO - protect against failure to
@@ -71,6 +229,15 @@ GraphTile::GraphTile(const std::string& tile_dir, const GraphId& graphid) : head
 
     // Set pointers to internal data structures
     Initialize(graphid, graphtile_->data(), graphtile_->size());
+  } // try to load a sectioned compressed tile, sections inflate on first use
+  else if (filesystem::exists(file_location + ".gzs")) {
+    std::ifstream file(file_location + ".gzs", std::ios::in | std::ios::binary);
+    if (!file.is_open() || !LoadSectioned(graphid, file)) {
+      LOG_WARN("Failed to load sectioned tile: " + file_location + ".gzs");
+      graphtile_.reset();
+      lazy_sections_.reset();
+      header_ = nullptr;
+    }
   } // try to load a gzipped tile
   else {
     std::ifstream file(file_location + ".gz", std::ios::in | std::ios::binary);
@@ -124,6 +291,16 @@ GraphTile::GraphTile(const GraphId& graphid, char* ptr, size_t size) : header_(n
   Initialize(graphid, ptr, size);
 }
 
+GraphTile::GraphTile(const GraphId& graphid, std::shared_ptr<std::vector<char>> memory)
+    : header_(nullptr) {
+  // Share the caller's buffer rather than copying it, then fix the internal
+  // pointers up against it
+  graphtile_ = std::move(memory);
+  if (graphtile_ && !graphtile_->empty()) {
+    Initialize(graphid, graphtile_->data(), graphtile_->size());
+  }
+}
+
 GraphTile::GraphTile(const std::string& tile_url, const GraphId& graphid, curler_t& curler) {
   // Don't bother with invalid ids
   if (!graphid.Is_Valid() || graphid.level() > TileHierarchy::get_max_level()) {
@@ -222,6 +399,12 @@ void GraphTile::Initialize(const GraphId& graphid, char* tile_ptr, const size_t
   complex_restriction_reverse_size_ =
       header_->edgeinfo_offset() - header_->complex_restriction_reverse_offset();
 
+  // Index the complex restrictions by edge Id
+  IndexComplexRestrictions();
+
+  // Index the transit departures by line Id
+  IndexDepartures();
+
   // Start of edge information and its size
   edgeinfo_ = tile_ptr + header_->edgeinfo_offset();
   edgeinfo_size_ = header_->textlist_offset() - header_->edgeinfo_offset();
@@ -247,6 +430,26 @@ void GraphTile::Initialize(const GraphId& graphid, char* tile_ptr, const size_t
     lane_connectivity_size_ = header_->end_offset() - header_->lane_connectivity_offset();
   }
 
+  // Start of the directed edge SoA mirror if this tile carries one. It is
+  // written directly after lane connectivity so trim the size computed
+  // above (which otherwise runs to the next section or the tile end)
+  if (header_->has_edge_soa()) {
+    if (header_->edge_soa_offset() > header_->lane_connectivity_offset()) {
+      lane_connectivity_size_ =
+          std::min(lane_connectivity_size_,
+                   static_cast<std::size_t>(header_->edge_soa_offset() -
+                                            header_->lane_connectivity_offset()));
+    }
+    char* soa_ptr = tile_ptr + header_->edge_soa_offset();
+    edge_soa_.endnodes = reinterpret_cast<const uint64_t*>(soa_ptr);
+    soa_ptr += header_->directededgecount() * sizeof(uint64_t);
+    edge_soa_.lengths = reinterpret_cast<const uint32_t*>(soa_ptr);
+    soa_ptr += header_->directededgecount() * sizeof(uint32_t);
+    edge_soa_.attributes = reinterpret_cast<const uint32_t*>(soa_ptr);
+    soa_ptr += header_->directededgecount() * sizeof(uint32_t);
+    edge_soa_.speeds = reinterpret_cast<const uint8_t*>(soa_ptr);
+  }
+
   // For reference - how to use the end offset to set size of an object (that
   // is not fixed size and count).
   // example_size_ = header_->end_offset() - header_->example_offset();
@@ -493,32 +696,59 @@ iterable_t<const DirectedEdge> GraphTile::GetDirectedEdges(const size_t idx) con
 
 // Get a pointer to edge info.
 EdgeInfo GraphTile::edgeinfo(const size_t offset) const {
-  return EdgeInfo(edgeinfo_ + offset, textlist_, textlist_size_);
+  // the EdgeInfo keeps the text list pointer for later name lookups so
+  // both sections have to be resident
+  EnsureSection(kSectionEdgeInfo);
+  EnsureSection(kSectionNames);
+  return EdgeInfo(edgeinfo_ + offset, textlist_, textlist_size_, header_->has_shape_indexes());
+}
+
+// Build indexes of the complex restriction sections by the edge Id each
+// restriction applies to.
+void GraphTile::IndexComplexRestrictions() {
+  size_t offset = 0;
+  while (offset < complex_restriction_forward_size_) {
+    ComplexRestriction* cr =
+        reinterpret_cast<ComplexRestriction*>(complex_restriction_forward_ + offset);
+    complex_restriction_forward_index_.emplace(cr->to_graphid().value, cr);
+    offset += cr->SizeOf();
+  }
+  offset = 0;
+  while (offset < complex_restriction_reverse_size_) {
+    ComplexRestriction* cr =
+        reinterpret_cast<ComplexRestriction*>(complex_restriction_reverse_ + offset);
+    complex_restriction_reverse_index_.emplace(cr->from_graphid().value, cr);
+    offset += cr->SizeOf();
+  }
+}
+
+// Build an index of the transit departure list by line Id. Departures are
+// sorted by line Id and then by departure time, so each line's departures
+// form one contiguous range; remembering the ranges means a schedule lookup
+// only ever searches its own line instead of the whole list.
+void GraphTile::IndexDepartures() {
+  uint32_t count = header_->departurecount();
+  departure_index_.reserve(count / 8);
+  uint32_t begin = 0;
+  for (uint32_t i = 1; i <= count; ++i) {
+    if (i == count || departures_[i].lineid() != departures_[begin].lineid()) {
+      departure_index_.emplace(departures_[begin].lineid(), std::make_pair(begin, i));
+      begin = i;
+    }
+  }
 }
 
 // Get the complex restrictions in the forward or reverse order based on
 // the id and modes.
 std::vector<ComplexRestriction*>
 GraphTile::GetRestrictions(const bool forward, const GraphId id, const uint64_t modes) const {
-  size_t offset = 0;
   std::vector<ComplexRestriction*> cr_vector;
-  if (forward) {
-    while (offset < complex_restriction_forward_size_) {
-      ComplexRestriction* cr =
-          reinterpret_cast<ComplexRestriction*>(complex_restriction_forward_ + offset);
-      if (cr->to_graphid() == id && (cr->modes() & modes)) {
-        cr_vector.push_back(cr);
-      }
-      offset += cr->SizeOf();
-    }
-  } else {
-    while (offset < complex_restriction_reverse_size_) {
-      ComplexRestriction* cr =
-          reinterpret_cast<ComplexRestriction*>(complex_restriction_reverse_ + offset);
-      if (cr->from_graphid() == id && (cr->modes() & modes)) {
-        cr_vector.push_back(cr);
-      }
-      offset += cr->SizeOf();
+  const auto& index =
+      forward ? complex_restriction_forward_index_ : complex_restriction_reverse_index_;
+  auto range = index.equal_range(id.value);
+  for (auto it = range.first; it != range.second; ++it) {
+    if (it->second->modes() & modes) {
+      cr_vector.push_back(it->second);
     }
   }
   return cr_vector;
@@ -549,6 +779,7 @@ uint16_t GraphTile::GetTypes(const uint32_t edgeinfo_offset) const {
 AdminInfo GraphTile::admininfo(const size_t idx) const {
   if (idx < header_->admincount()) {
     const Admin& admin = admins_[idx];
+    EnsureSection(kSectionNames);
     return AdminInfo(textlist_ + admin.country_offset(), textlist_ + admin.state_offset(),
                      admin.country_iso(), admin.state_iso());
   }
@@ -566,6 +797,7 @@ const Admin* GraphTile::admin(const size_t idx) const {
 // Convenience method to get the text/name for a given offset to the textlist
 std::string GraphTile::GetName(const uint32_t textlist_offset) const {
   if (textlist_offset < textlist_size_) {
+    EnsureSection(kSectionNames);
     return textlist_ + textlist_offset;
   } else {
     throw std::runtime_error("GetName: offset exceeds size of text list");
@@ -583,6 +815,7 @@ std::vector<SignInfo> GraphTile::GetSigns(const uint32_t idx) const {
 
   // Signs are sorted by edge index.
   // Binary search to find a sign with matching edge index.
+  EnsureSection(kSectionSigns);
   int32_t low = 0;
   int32_t high = count - 1;
   int32_t mid;
@@ -604,6 +837,7 @@ std::vector<SignInfo> GraphTile::GetSigns(const uint32_t idx) const {
   }
 
   // Add signs
+  EnsureSection(kSectionNames);
   for (; found < count && signs_[found].edgeindex() == idx; ++found) {
     if (signs_[found].text_offset() < textlist_size_) {
       // Skip tagged text strings (Future code is needed to handle tagged strings)
@@ -624,6 +858,7 @@ std::vector<SignInfo> GraphTile::GetSigns(const uint32_t idx) const {
 
 // Get lane connections ending on this edge.
 std::vector<LaneConnectivity> GraphTile::GetLaneConnectivity(const uint32_t idx) const {
+  EnsureSection(kSectionTail);
   uint32_t count = lane_connectivity_size_ / sizeof(LaneConnectivity);
   std::vector<LaneConnectivity> lcs;
   if (count == 0) {
@@ -663,39 +898,40 @@ std::vector<LaneConnectivity> GraphTile::GetLaneConnectivity(const uint32_t idx)
   return lcs;
 }
 
-// Get the next departure given the directed line Id and the current
-// time (seconds from midnight).
-const TransitDeparture* GraphTile::GetNextDeparture(const uint32_t lineid,
-                                                    const uint32_t current_time,
-                                                    const uint32_t day,
-                                                    const uint32_t dow,
-                                                    bool date_before_tile,
-                                                    bool wheelchair,
-                                                    bool bicycle) const {
-  uint32_t count = header_->departurecount();
-  if (count == 0) {
+// Shared implementation for the GetNextDeparture overloads - the validity
+// predicate decides whether a schedule entry applies to the service day.
+template <class validity_t>
+const TransitDeparture* GraphTile::NextDeparture(const uint32_t lineid,
+                                                 const uint32_t current_time,
+                                                 bool wheelchair,
+                                                 bool bicycle,
+                                                 const validity_t& valid) const {
+  if (header_->departurecount() == 0) {
     return nullptr;
   }
 
-  // Departures are sorted by edge Id and then by departure time.
-  // Binary search to find a departure with matching line Id.
-  int32_t low = 0;
-  int32_t high = count - 1;
+  // Only this line's contiguous range of departures needs to be searched
+  auto range = departure_index_.find(lineid);
+  if (range == departure_index_.end()) {
+    return nullptr;
+  }
+
+  // Departures within the line are sorted by departure time.
+  // Binary search to find the first departure with a workable time.
+  int32_t low = range->second.first;
+  int32_t end = range->second.second;
+  int32_t high = end - 1;
   int32_t mid;
-  int32_t found = count;
+  int32_t found = end;
   while (low <= high) {
     mid = (low + high) / 2;
     const auto& dep = departures_[mid];
-    // matching lineid and a workable time
-    if (lineid == dep.lineid() &&
-        ((current_time <= dep.departure_time() && dep.type() == kFixedSchedule) ||
-         (current_time <= dep.end_time() && dep.type() == kFrequencySchedule))) {
+    // a workable time
+    if ((current_time <= dep.departure_time() && dep.type() == kFixedSchedule) ||
+        (current_time <= dep.end_time() && dep.type() == kFrequencySchedule)) {
       found = mid;
       high = mid - 1;
-    } // need a smaller lineid
-    else if (lineid < dep.lineid()) {
-      high = mid - 1;
-    } // either need a bigger lineid or a later time
+    } // need a later time
     else {
       low = mid + 1;
     }
@@ -703,12 +939,11 @@ const TransitDeparture* GraphTile::GetNextDeparture(const uint32_t lineid,
 
   // Iterate through departures until one is found with valid date, dow or
   // calendar date, and does not have a calendar exception.
-  for (; found < count && departures_[found].lineid() == lineid; ++found) {
+  for (; found < end; ++found) {
     // Make sure valid departure time
     if (departures_[found].type() == kFixedSchedule) {
       if (departures_[found].departure_time() >= current_time &&
-          GetTransitSchedule(departures_[found].schedule_index())
-              ->IsValid(day, dow, date_before_tile) &&
+          valid(departures_[found].schedule_index()) &&
           (!wheelchair || departures_[found].wheelchair_accessible()) &&
           (!bicycle || departures_[found].bicycle_accessible())) {
         return &departures_[found];
@@ -722,8 +957,7 @@ const TransitDeparture* GraphTile::GetNextDeparture(const uint32_t lineid,
       }
 
       if (departure_time >= current_time && departure_time < end_time &&
-          GetTransitSchedule(departures_[found].schedule_index())
-              ->IsValid(day, dow, date_before_tile) &&
+          valid(departures_[found].schedule_index()) &&
           (!wheelchair || departures_[found].wheelchair_accessible()) &&
           (!bicycle || departures_[found].bicycle_accessible())) {
 
@@ -744,41 +978,84 @@ const TransitDeparture* GraphTile::GetNextDeparture(const uint32_t lineid,
   return nullptr;
 }
 
+// Get the next departure given the directed line Id and the current
+// time (seconds from midnight).
+const TransitDeparture* GraphTile::GetNextDeparture(const uint32_t lineid,
+                                                    const uint32_t current_time,
+                                                    const uint32_t day,
+                                                    const uint32_t dow,
+                                                    bool date_before_tile,
+                                                    bool wheelchair,
+                                                    bool bicycle) const {
+  return NextDeparture(lineid, current_time, wheelchair, bicycle,
+                       [&](const uint32_t schedule_index) {
+                         return GetTransitSchedule(schedule_index)
+                             ->IsValid(day, dow, date_before_tile);
+                       });
+}
+
+// Get the next departure with the schedule validity for the service day
+// already collapsed into a bitset.
+const TransitDeparture* GraphTile::GetNextDeparture(const uint32_t lineid,
+                                                    const uint32_t current_time,
+                                                    const std::vector<bool>& valid_schedules,
+                                                    bool wheelchair,
+                                                    bool bicycle) const {
+  return NextDeparture(lineid, current_time, wheelchair, bicycle,
+                       [&](const uint32_t schedule_index) {
+                         return valid_schedules[schedule_index];
+                       });
+}
+
+// Collapse every schedule entry's validity for one service day into a
+// bitset indexed by schedule index.
+std::vector<bool> GraphTile::GetScheduleValidity(const uint32_t day,
+                                                 const uint32_t dow,
+                                                 bool date_before_tile) const {
+  std::vector<bool> valid(header_->schedulecount());
+  for (uint32_t i = 0; i < header_->schedulecount(); ++i) {
+    valid[i] = transit_schedules_[i].IsValid(day, dow, date_before_tile);
+  }
+  return valid;
+}
+
 // Get the departure given the line Id and tripid
 const TransitDeparture* GraphTile::GetTransitDeparture(const uint32_t lineid,
                                                        const uint32_t tripid,
                                                        const uint32_t current_time) const {
-  uint32_t count = header_->departurecount();
-  if (count == 0) {
+  if (header_->departurecount() == 0) {
     return nullptr;
   }
 
-  // Departures are sorted by edge Id and then by departure time.
-  // Binary search to find a departure with matching line Id.
-  int32_t low = 0;
-  int32_t high = count - 1;
+  // Only this line's contiguous range of departures needs to be searched
+  auto range = departure_index_.find(lineid);
+  if (range == departure_index_.end()) {
+    return nullptr;
+  }
+
+  // Departures within the line are sorted by departure time.
+  // Binary search to find the first departure with a workable time.
+  int32_t low = range->second.first;
+  int32_t end = range->second.second;
+  int32_t high = end - 1;
   int32_t mid;
-  int32_t found = count;
+  int32_t found = end;
   while (low <= high) {
     mid = (low + high) / 2;
     const auto& dep = departures_[mid];
-    // find the first matching lineid in the list
-    if (lineid == dep.lineid() &&
-        ((current_time <= dep.departure_time() && dep.type() == kFixedSchedule) ||
-         (current_time <= dep.end_time() && dep.type() == kFrequencySchedule))) {
+    // a workable time
+    if ((current_time <= dep.departure_time() && dep.type() == kFixedSchedule) ||
+        (current_time <= dep.end_time() && dep.type() == kFrequencySchedule)) {
       found = mid;
       high = mid - 1;
-    } // need a smaller lineid
-    else if (lineid < dep.lineid()) {
-      high = mid - 1;
-    } // need a bigger lineid
+    } // need a later time
     else {
       low = mid + 1;
     }
   }
 
   // Iterate through departures until one is found with matching trip id
-  for (; found < count && departures_[found].lineid() == lineid; ++found) {
+  for (; found < end; ++found) {
     if (departures_[found].tripid() == tripid) {
 
       if (departures_[found].type() == kFixedSchedule) {
@@ -936,6 +1213,7 @@ uint32_t GraphTile::turnlanes_offset(const uint32_t idx) const {
     LOG_ERROR("No turn lanes found for idx = " + std::to_string(idx));
     return 0;
   }
+  EnsureSection(kSectionSigns);
   auto tl = std::lower_bound(&turnlanes_[0], &turnlanes_[count], TurnLanes(idx, 0));
   return tl != &turnlanes_[count] ? tl->text_offset() : 0;
 }
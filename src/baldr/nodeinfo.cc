@@ -114,6 +114,17 @@ void NodeInfo::set_edge_count(const uint32_t edge_count) {
   }
 }
 
+// Set the number of shortcut edges at the start of the edge list.
+void NodeInfo::set_shortcut_count(const uint32_t shortcut_count) {
+  if (shortcut_count > kMaxEdgesPerNode) {
+    // Log an error and set count to max.
+    LOG_ERROR("NodeInfo: shortcut count exceeds max: " + std::to_string(shortcut_count));
+    shortcut_count_ = kMaxEdgesPerNode;
+  } else {
+    shortcut_count_ = shortcut_count;
+  }
+}
+
 // Set the access modes (bit mask) allowed to pass through the node.
 void NodeInfo::set_access(const uint32_t access) {
   if (access > kAllAccess) {
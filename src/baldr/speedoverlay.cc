@@ -0,0 +1,90 @@
+#include <sys/stat.h>
+
+#include "baldr/speedoverlay.h"
+#include "midgard/logging.h"
+
+namespace {
+
+// front of the overlay file so a reader can reject foreign or stale formats
+constexpr uint32_t SPEED_OVERLAY_MAGIC = 0x64707376; // "vspd"
+constexpr uint32_t SPEED_OVERLAY_VERSION = 1;
+
+} // namespace
+
+namespace valhalla {
+namespace baldr {
+
+bool speed_overlay_t::from_file(const std::string& filename) {
+  filename_ = filename;
+  generation_ = 0;
+  mmap_.reset();
+  directory_.clear();
+  return refresh();
+}
+
+// Remap the overlay if the feeder put a newer generation in place
+bool speed_overlay_t::refresh() {
+  // nothing to refresh from
+  struct stat s;
+  if (filename_.empty() || stat(filename_.c_str(), &s) != 0 ||
+      static_cast<size_t>(s.st_size) < sizeof(header_t)) {
+    return false;
+  }
+
+  // map the whole file, the lookups are random access
+  std::shared_ptr<midgard::mem_map<char>> mmap;
+  try {
+    mmap.reset(new midgard::mem_map<char>(filename_, s.st_size, POSIX_MADV_RANDOM, true));
+  } catch (const std::exception& e) {
+    LOG_WARN("Could not map speed overlay " + filename_ + ": " + e.what());
+    return false;
+  }
+
+  // sanity check the header before trusting any of it
+  const auto* header = reinterpret_cast<const header_t*>(mmap->get());
+  if (header->magic != SPEED_OVERLAY_MAGIC || header->version != SPEED_OVERLAY_VERSION ||
+      sizeof(header_t) + header->count * sizeof(record_t) > static_cast<size_t>(s.st_size)) {
+    LOG_WARN("Unrecognized speed overlay format in " + filename_);
+    return false;
+  }
+
+  // same generation as the one we already serve
+  if (header->generation == generation_ && mmap_) {
+    return false;
+  }
+
+  // index the per tile records, dropping any whose speeds fall off the file
+  std::unordered_map<uint64_t, std::pair<uint64_t, uint32_t>> directory;
+  directory.reserve(header->count);
+  const auto* records = reinterpret_cast<const record_t*>(mmap->get() + sizeof(header_t));
+  for (uint64_t i = 0; i < header->count; ++i) {
+    const auto& record = records[i];
+    if (record.offset + record.count > static_cast<size_t>(s.st_size)) {
+      LOG_WARN("Truncated speed overlay record in " + filename_);
+      return false;
+    }
+    directory.emplace(record.graphid, std::make_pair(record.offset, record.count));
+  }
+
+  // swap the new generation in; tiles holding anchors to the old mapping
+  // keep it alive until they are evicted
+  generation_ = header->generation;
+  mmap_ = std::move(mmap);
+  directory_ = std::move(directory);
+  return true;
+}
+
+// Get the live speeds for a tile
+speed_overlay_t::tile_speeds_t speed_overlay_t::tile_speeds(const GraphId& tile_base) const {
+  tile_speeds_t speeds;
+  const auto found = directory_.find(tile_base.Tile_Base().value);
+  if (found != directory_.cend()) {
+    speeds.speeds = reinterpret_cast<const uint8_t*>(mmap_->get() + found->second.first);
+    speeds.count = found->second.second;
+    speeds.anchor = mmap_;
+  }
+  return speeds;
+}
+
+} // namespace baldr
+} // namespace valhalla
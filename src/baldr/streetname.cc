@@ -1,19 +1,45 @@
 #include <iostream>
+#include <unordered_map>
 
 #include "baldr/streetname.h"
 
+namespace {
+
+// Cap on the per thread intern pool so rare one-off names (house number
+// refs, exotic localities) cannot grow it without bound
+constexpr size_t kMaxInternedNames = 65536;
+
+// Per worker thread intern pool of street name strings. The same names are
+// decoded from the tiles request after request (tiles are immutable between
+// reloads) so each thread keeps one shared copy of every name it has seen
+// and hands out stable handles to it. Thread local so this hot path takes
+// no lock
+const std::shared_ptr<const std::string>& intern_name(const std::string& value) {
+  thread_local std::unordered_map<std::string, std::shared_ptr<const std::string>> pool;
+  auto itr = pool.find(value);
+  if (itr == pool.end()) {
+    if (pool.size() >= kMaxInternedNames) {
+      pool.clear();
+    }
+    itr = pool.emplace(value, std::make_shared<const std::string>(value)).first;
+  }
+  return itr->second;
+}
+
+} // namespace
+
 namespace valhalla {
 namespace baldr {
 
 StreetName::StreetName(const std::string& value, const bool is_route_number)
-    : value_(value), is_route_number_(is_route_number) {
+    : value_(intern_name(value)), is_route_number_(is_route_number) {
 }
 
 StreetName::~StreetName() {
 }
 
 const std::string& StreetName::value() const {
-  return value_;
+  return *value_;
 }
 
 bool StreetName::is_route_number() const {
@@ -21,17 +47,19 @@ bool StreetName::is_route_number() const {
 }
 
 bool StreetName::operator==(const StreetName& rhs) const {
-  return ((value_ == rhs.value_) && (is_route_number_ == rhs.is_route_number_));
+  // interned names from the same thread compare equal by handle alone
+  return ((value_ == rhs.value_ || *value_ == *rhs.value_) &&
+          (is_route_number_ == rhs.is_route_number_));
 }
 
 bool StreetName::StartsWith(const std::string& prefix) const {
   size_t n = prefix.size();
-  return (value_.size() < n) ? false : prefix == value_.substr(0, n);
+  return (value_->size() < n) ? false : prefix == value_->substr(0, n);
 }
 
 bool StreetName::EndsWith(const std::string& suffix) const {
   size_t n = suffix.size();
-  return (value_.size() < n) ? false : suffix == value_.substr(value_.size() - n);
+  return (value_->size() < n) ? false : suffix == value_->substr(value_->size() - n);
 }
 
 std::string StreetName::GetPreDir() const {
@@ -50,7 +78,7 @@ std::string StreetName::GetBaseName() const {
   std::string pre_dir = GetPreDir();
   std::string post_dir = GetPostDir();
 
-  return value_.substr(pre_dir.size(), (value_.size() - pre_dir.size() - post_dir.size()));
+  return value_->substr(pre_dir.size(), (value_->size() - pre_dir.size() - post_dir.size()));
 }
 
 bool StreetName::HasSameBaseName(const StreetName& rhs) const {
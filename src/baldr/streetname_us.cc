@@ -50,7 +50,7 @@ std::string StreetNameUs::GetBaseName() const {
   std::string pre_dir = GetPreDir();
   std::string post_dir = GetPostDir();
 
-  return value_.substr(pre_dir.size(), (value_.size() - pre_dir.size() - post_dir.size()));
+  return value_->substr(pre_dir.size(), (value_->size() - pre_dir.size() - post_dir.size()));
 }
 
 bool StreetNameUs::HasSameBaseName(const StreetName& rhs) const {
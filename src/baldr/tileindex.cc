@@ -0,0 +1,126 @@
+#include <cstring>
+#include <fstream>
+#include <sys/stat.h>
+#include <vector>
+
+#include <zlib.h>
+
+#include "baldr/graphtile.h"
+#include "baldr/tilehierarchy.h"
+#include "baldr/tileindex.h"
+#include "filesystem.h"
+#include "midgard/logging.h"
+
+namespace {
+
+// the index lives beside the level directories in the tile directory
+constexpr const char* TILE_INDEX_FILE = "tiles.idx";
+
+// front of the index file so a reader can reject foreign or stale formats
+constexpr uint32_t TILE_INDEX_MAGIC = 0x78697476; // "vtix"
+constexpr uint32_t TILE_INDEX_VERSION = 1;
+
+// how much of the front of each tile file the checksum covers. enough to
+// include the tile header without paying to read whole planet tiles
+constexpr size_t CHECKSUM_BYTES = 4096;
+
+struct index_header_t {
+  uint32_t magic;
+  uint32_t version;
+  uint64_t count;
+};
+
+struct index_record_t {
+  uint64_t graphid;
+  uint64_t size;
+  uint32_t checksum;
+};
+
+// crc32 of up to CHECKSUM_BYTES from the front of the file
+uint32_t checksum_front(const std::string& file_name) {
+  std::ifstream file(file_name, std::ios::in | std::ios::binary);
+  std::vector<char> bytes(CHECKSUM_BYTES);
+  file.read(bytes.data(), bytes.size());
+  auto read = file.gcount();
+  return read > 0 ? crc32(crc32(0, nullptr, 0),
+                          reinterpret_cast<const unsigned char*>(bytes.data()),
+                          static_cast<unsigned int>(read))
+                  : 0;
+}
+
+} // namespace
+
+namespace valhalla {
+namespace baldr {
+
+// Load the index in a single read
+bool tile_index_t::from_file(const std::string& tile_dir) {
+  std::ifstream file(tile_dir + filesystem::path::preferred_separator + TILE_INDEX_FILE,
+                     std::ios::in | std::ios::binary);
+  if (!file) {
+    return false;
+  }
+
+  index_header_t header{};
+  file.read(reinterpret_cast<char*>(&header), sizeof(header));
+  if (!file || header.magic != TILE_INDEX_MAGIC || header.version != TILE_INDEX_VERSION) {
+    LOG_WARN("Tile index exists but could not be understood, ignoring it");
+    return false;
+  }
+
+  std::vector<index_record_t> records(header.count);
+  file.read(reinterpret_cast<char*>(records.data()), records.size() * sizeof(index_record_t));
+  if (!file) {
+    LOG_WARN("Tile index is truncated, ignoring it");
+    return false;
+  }
+
+  tiles_.reserve(records.size());
+  for (const auto& record : records) {
+    tiles_.emplace(record.graphid, entry_t{record.size, record.checksum});
+  }
+  return true;
+}
+
+// Scan the tile directory and write the index beside the tiles
+bool tile_index_t::build(const std::string& tile_dir) {
+  // find every file that parses as a tile, the same walk GetTileSet does
+  std::vector<index_record_t> records;
+  for (uint8_t level = 0; level <= TileHierarchy::levels().rbegin()->first + 1; ++level) {
+    filesystem::path root_dir(tile_dir + filesystem::path::preferred_separator +
+                              std::to_string(level) + filesystem::path::preferred_separator);
+    if (!filesystem::exists(root_dir) || !filesystem::is_directory(root_dir)) {
+      continue;
+    }
+    for (filesystem::recursive_directory_iterator i(root_dir), end; i != end; ++i) {
+      if (!i->is_regular_file() && !i->is_symlink()) {
+        continue;
+      }
+      GraphId graphid;
+      try {
+        graphid = GraphTile::GetTileId(i->path().string());
+      } catch (...) { continue; }
+      struct stat s;
+      if (stat(i->path().string().c_str(), &s) != 0) {
+        continue;
+      }
+      records.push_back({graphid.Tile_Base().value, static_cast<uint64_t>(s.st_size),
+                         checksum_front(i->path().string())});
+    }
+  }
+
+  // write the header and the records in one go
+  std::ofstream file(tile_dir + filesystem::path::preferred_separator + TILE_INDEX_FILE,
+                     std::ios::out | std::ios::binary | std::ios::trunc);
+  if (!file) {
+    return false;
+  }
+  index_header_t header{TILE_INDEX_MAGIC, TILE_INDEX_VERSION, records.size()};
+  file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  file.write(reinterpret_cast<const char*>(records.data()),
+             records.size() * sizeof(index_record_t));
+  return static_cast<bool>(file);
+}
+
+} // namespace baldr
+} // namespace valhalla
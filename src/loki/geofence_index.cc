@@ -0,0 +1,152 @@
+#include "loki/geofence_index.h"
+#include "loki/node_search.h"
+#include "midgard/bucketed_polygon.h"
+#include "midgard/logging.h"
+
+#include <algorithm>
+#include <unordered_set>
+
+namespace vm = valhalla::midgard;
+namespace vb = valhalla::baldr;
+
+namespace {
+
+// an empty zone to hand back for names we never indexed
+const std::vector<vb::GraphId> empty_ids;
+
+} // anonymous namespace
+
+namespace valhalla {
+namespace loki {
+
+geofence_index_t::geofence_index_t(const boost::property_tree::ptree& pt,
+                                   baldr::GraphReader& reader) {
+  for (const auto& zone : pt) {
+    auto name = zone.second.get<std::string>("name");
+
+    // rectangular zones are a straight bin walk
+    auto bbox = zone.second.get_child_optional("bbox");
+    if (bbox) {
+      std::vector<float> coords;
+      for (const auto& coord : *bbox) {
+        coords.push_back(coord.second.get_value<float>());
+      }
+      if (coords.size() != 4) {
+        throw std::runtime_error("Geofence '" + name + "' bbox must have 4 coordinates");
+      }
+      add_bbox(name, vm::AABB2<vm::PointLL>(coords[0], coords[1], coords[2], coords[3]), reader);
+      continue;
+    }
+
+    // polygonal zones walk the bins of their bbox then filter exactly
+    auto polygon = zone.second.get_child_optional("polygon");
+    if (polygon) {
+      std::vector<vm::PointLL> ring;
+      for (const auto& coord : *polygon) {
+        std::vector<float> ll;
+        for (const auto& c : coord.second) {
+          ll.push_back(c.second.get_value<float>());
+        }
+        if (ll.size() != 2) {
+          throw std::runtime_error("Geofence '" + name + "' polygon vertices must be [lng, lat]");
+        }
+        ring.emplace_back(ll[0], ll[1]);
+      }
+      add_polygon(name, ring, reader);
+      continue;
+    }
+
+    throw std::runtime_error("Geofence '" + name + "' must have a bbox or a polygon");
+  }
+}
+
+void geofence_index_t::add_bbox(const std::string& name,
+                                const vm::AABB2<vm::PointLL>& bbox,
+                                baldr::GraphReader& reader) {
+  finish_zone(name, nodes_in_bbox(bbox, reader), reader);
+}
+
+void geofence_index_t::add_polygon(const std::string& name,
+                                   const std::vector<vm::PointLL>& polygon,
+                                   baldr::GraphReader& reader) {
+  if (polygon.size() < 3) {
+    throw std::runtime_error("Geofence '" + name + "' polygon must have at least 3 vertices");
+  }
+
+  // candidates from the polygon's bbox, then keep only the ones actually
+  // inside the ring. the ring is tested against every candidate so bucket
+  // its edges once up front
+  vm::BucketedPolygon ring_test(polygon);
+  auto nodes = nodes_in_bbox(ring_test.bbox(), reader);
+  std::vector<vb::GraphId> contained;
+  contained.reserve(nodes.size());
+  for (const auto node : nodes) {
+    const auto* tile = reader.GetGraphTile(node);
+    if (tile && ring_test.Contains(tile->get_node_ll(node))) {
+      contained.push_back(node);
+    }
+  }
+  finish_zone(name, std::move(contained), reader);
+}
+
+bool geofence_index_t::has_zone(const std::string& name) const {
+  return zones_.count(name) > 0;
+}
+
+bool geofence_index_t::node_in_zone(const std::string& name, const baldr::GraphId& node) const {
+  const auto zone = zones_.find(name);
+  return zone != zones_.end() &&
+         std::binary_search(zone->second.nodes.begin(), zone->second.nodes.end(), node);
+}
+
+bool geofence_index_t::edge_in_zone(const std::string& name, const baldr::GraphId& edge) const {
+  const auto zone = zones_.find(name);
+  return zone != zones_.end() &&
+         std::binary_search(zone->second.edges.begin(), zone->second.edges.end(), edge);
+}
+
+const std::vector<baldr::GraphId>& geofence_index_t::zone_nodes(const std::string& name) const {
+  const auto zone = zones_.find(name);
+  return zone != zones_.end() ? zone->second.nodes : empty_ids;
+}
+
+const std::vector<baldr::GraphId>& geofence_index_t::zone_edges(const std::string& name) const {
+  const auto zone = zones_.find(name);
+  return zone != zones_.end() ? zone->second.edges : empty_ids;
+}
+
+void geofence_index_t::finish_zone(const std::string& name,
+                                   std::vector<baldr::GraphId>&& nodes,
+                                   baldr::GraphReader& reader) {
+  // nodes_in_bbox hands back the ids sorted so membership below and the
+  // stored set are already binary searchable
+  std::unordered_set<uint64_t> node_set(nodes.size());
+  for (const auto node : nodes) {
+    node_set.emplace(node);
+  }
+
+  // an edge is contained when both of its end nodes are. the nodes arrive
+  // grouped by tile so the reader's cache soaks up the tile lookups
+  std::vector<vb::GraphId> edges;
+  for (const auto node : nodes) {
+    const auto* tile = reader.GetGraphTile(node);
+    if (tile == nullptr) {
+      continue;
+    }
+    const auto* nodeinfo = tile->node(node);
+    const auto* edge = tile->directededge(nodeinfo->edge_index());
+    for (uint32_t i = 0; i < nodeinfo->edge_count(); ++i, ++edge) {
+      if (node_set.count(edge->endnode())) {
+        edges.emplace_back(node.tileid(), node.level(), nodeinfo->edge_index() + i);
+      }
+    }
+  }
+  std::sort(edges.begin(), edges.end());
+
+  LOG_INFO("Indexed geofence '" + name + "' with " + std::to_string(nodes.size()) + " nodes and " +
+           std::to_string(edges.size()) + " edges");
+  zones_[name] = zone_t{std::move(nodes), std::move(edges)};
+}
+
+} // namespace loki
+} // namespace valhalla
@@ -28,43 +28,27 @@ std::vector<PointLL> loki_worker_t::init_height(valhalla_request_t& request) {
     throw valhalla_exception_t{312};
   };
 
+  // they want it resampled, check the resolution makes sense
+  if (request.options.has_resample_distance() &&
+      request.options.resample_distance() < min_resample) {
+    throw valhalla_exception_t{313, " " + std::to_string(min_resample) + " meters"};
+  };
+
+  // there are limits though, when resampling its the resampled count that
+  // matters and that is checked as the postings are generated
+  if (!(request.options.has_resample_distance() && request.options.shape_size() > 1) &&
+      request.options.shape_size() > max_elevation_shape) {
+    throw valhalla_exception_t{314, " (" + std::to_string(request.options.shape_size()) +
+                                        "). The limit is " + std::to_string(max_elevation_shape)};
+  }
+
   // convert back to native pointll :(
   std::vector<PointLL> shape;
+  shape.reserve(request.options.shape_size());
   for (const auto& l : request.options.shape()) {
     shape.emplace_back(to_ll(l));
   }
 
-  // resample the shape
-  bool resampled = false;
-  if (request.options.has_resample_distance()) {
-    if (request.options.resample_distance() < min_resample) {
-      throw valhalla_exception_t{313, " " + std::to_string(min_resample) + " meters"};
-    };
-    if (request.options.shape_size() > 1) {
-      // resample the shape but make sure to keep the first and last shapepoint
-      auto last = shape.back();
-      shape = midgard::resample_spherical_polyline(shape, request.options.resample_distance());
-      shape.emplace_back(std::move(last));
-      // put it back
-      request.options.clear_shape();
-      for (const auto& p : shape) {
-        from_ll(request.options.mutable_shape()->Add(), p);
-      }
-      // re-encode it for display if they sent it encoded
-      if (request.options.has_encoded_polyline()) {
-        request.options.set_encoded_polyline(midgard::encode(shape));
-      }
-      resampled = true;
-    }
-  }
-
-  // there are limits though
-  if (request.options.shape_size() > max_elevation_shape) {
-    throw valhalla_exception_t{314, " (" + std::to_string(request.options.shape_size()) +
-                                        (resampled ? " after resampling" : "") + "). The limit is " +
-                                        std::to_string(max_elevation_shape)};
-  }
-
   return shape;
 }
 
@@ -76,22 +60,51 @@ std::vector<PointLL> loki_worker_t::init_height(valhalla_request_t& request) {
 */
 std::string loki_worker_t::height(valhalla_request_t& request) {
   auto shape = init_height(request);
-  // get the elevation of each posting
-  std::vector<double> heights = sample.get_all(shape);
-  if (!request.options.do_not_track()) {
-    valhalla::midgard::logging::Log("sample_count::" + std::to_string(shape.size()), " [ANALYTICS] ");
-  }
-
-  // get the distances between the postings if desired
+  std::vector<double> heights;
   std::vector<float> ranges;
-  if (request.options.range()) {
-    ranges.reserve(shape.size());
-    ranges.emplace_back(0);
-    for (auto point = std::next(shape.cbegin()); point != shape.cend(); ++point) {
-      ranges.emplace_back(ranges.back() + point->Distance(*std::prev(point)));
+
+  // when resampling, the postings are generated, echoed back into the request,
+  // sampled and measured in one streaming pass rather than materializing the
+  // resampled shape and walking it once per product
+  if (request.options.has_resample_distance() && shape.size() > 1) {
+    bool encoded = request.options.has_encoded_polyline();
+    midgard::Shape5Encoder encoder;
+    request.options.clear_shape();
+    auto emit = [&](const PointLL& p) {
+      // there are limits though
+      if (request.options.shape_size() >= static_cast<int>(max_elevation_shape)) {
+        throw valhalla_exception_t{314, " (more than " + std::to_string(max_elevation_shape) +
+                                            " after resampling). The limit is " +
+                                            std::to_string(max_elevation_shape)};
+      }
+      // put it back as we go, re-encoding for display if they sent it encoded
+      from_ll(request.options.mutable_shape()->Add(), p);
+      if (encoded) {
+        encoder.push(p);
+      }
+    };
+    sample.get_resampled(shape, request.options.resample_distance(), emit, heights,
+                         request.options.range() ? &ranges : nullptr);
+    if (encoded) {
+      request.options.set_encoded_polyline(encoder.str());
+    }
+  } // otherwise get the elevation of each posting and measure them separately
+  else {
+    heights = sample.get_all(shape);
+    if (request.options.range()) {
+      ranges.reserve(shape.size());
+      ranges.emplace_back(0);
+      for (auto point = std::next(shape.cbegin()); point != shape.cend(); ++point) {
+        ranges.emplace_back(ranges.back() + point->Distance(*std::prev(point)));
+      }
     }
   }
 
+  if (!request.options.do_not_track()) {
+    valhalla::midgard::logging::Log("sample_count::" + std::to_string(heights.size()),
+                                    " [ANALYTICS] ");
+  }
+
   return tyr::serializeHeight(request, heights, ranges);
 }
 } // namespace loki
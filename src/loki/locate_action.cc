@@ -13,6 +13,11 @@ void loki_worker_t::init_locate(valhalla_request_t& request) {
   if (request.options.locations_size() < 1) {
     throw valhalla_exception_t{120};
   }
+  // locate batches can be much larger than routable location lists - the
+  // search shares bin reads across all of them - but still need a cap
+  if (request.options.locations_size() > max_locate_locations) {
+    throw valhalla_exception_t{150, std::to_string(max_locate_locations)};
+  }
   if (request.options.has_costing()) {
     parse_costing(request);
   } else {
@@ -2,6 +2,7 @@
 #include "baldr/tilehierarchy.h"
 #include "midgard/distanceapproximator.h"
 #include "midgard/linesegment2.h"
+#include "midgard/scratch_allocator.h"
 #include "midgard/util.h"
 
 #include <algorithm>
@@ -32,6 +33,23 @@ constexpr float SIDE_OF_STREET_SNAP =
 // cone width to use for cosine similarity comparisons for favoring heading
 constexpr float DEFAULT_ANGLE_WIDTH = 60.f;
 
+// bins holding at least this many edges get subdivided into a finer grid so
+// their scan can give up on far away corners the way the bin walk itself does
+constexpr size_t kSubdivideBinEdgeCount = 512;
+// how fine the subdivision of a dense bin is on each axis
+constexpr uint32_t kSubBinsDim = 5;
+constexpr uint32_t kSubBinCells = kSubBinsDim * kSubBinsDim;
+// at most this many subdivided bins are kept per worker thread
+constexpr size_t kMaxCachedSubBins = 256;
+
+// per worker thread backing for the short lived containers a search builds.
+// everything allocated from it dies before Search returns, so the arena is
+// reset on entry and in the steady state the same memory serves every request
+scratch_arena_t& search_arena() {
+  static thread_local scratch_arena_t arena;
+  return arena;
+}
+
 bool heading_filter(const DirectedEdge* edge,
                     const EdgeInfo& info,
                     const Location& location,
@@ -113,6 +131,12 @@ struct projector_t {
   projector_t(const Location& location, GraphReader& reader)
       : binner(make_binner(location.latlng_, reader)), location(location),
         sq_radius(location.radius_ * location.radius_),
+        unreachable(scratch_allocator<candidate_t>(search_arena())),
+        reachable(scratch_allocator<candidate_t>(search_arena())),
+        tested_edges(1024,
+                     std::hash<uint64_t>(),
+                     std::equal_to<uint64_t>(),
+                     scratch_allocator<uint64_t>(search_arena())),
         lon_scale(cosf(location.latlng_.lat() * kRadPerDeg)), lat(location.latlng_.lat()),
         lng(location.latlng_.lng()), approx(location.latlng_) {
     // TODO: something more empirical based on radius
@@ -205,8 +229,14 @@ struct projector_t {
   Location location;
   unsigned short bin_index = 0;
   double sq_radius;
-  std::vector<candidate_t> unreachable;
-  std::vector<candidate_t> reachable;
+  // the candidate batches live in the search arena and die with the search
+  scratch_vector<candidate_t> unreachable;
+  scratch_vector<candidate_t> reachable;
+
+  // edges this candidate has already projected onto. edges are listed in
+  // every bin their shape intersects so without this we would decode and
+  // project the same shapes again in each neighboring bin we visit
+  scratch_set<uint64_t> tested_edges;
 
   // critical data
   float lon_scale;
@@ -266,7 +296,8 @@ struct bin_handler_t {
   unsigned int get_reach(const DirectedEdge* edge) {
     auto itr = reach_indices.find(edge->endnode());
     if (itr == reach_indices.cend()) {
-      return 0; // TODO: if we didnt find it should we run the reachability check
+      // fall back to the upper bound precomputed into the tile, if any
+      return edge->reach();
     }
     return reaches[itr->second];
   }
@@ -491,6 +522,15 @@ struct bin_handler_t {
       return reaches[found->second];
     }
 
+    // the tiles may carry a reach precomputed at build time. it follows edges
+    // with any access so its an upper bound on what the crawl below would
+    // find; when it is below the limit (and not saturated) no crawl can do
+    // better and the edge can be discarded without expanding anything
+    auto tile_reach = edge->reach();
+    if (tile_reach > 0 && tile_reach < kMaxEdgeReach && tile_reach < max_reach_limit) {
+      return tile_reach;
+    }
+
     // we only want to waste time checking if this could become the best reachable option for a
     // given location
     bool check = false;
@@ -523,114 +563,293 @@ struct bin_handler_t {
 
   // handle a bin for the range of candidates that share it
   void handle_bin(std::vector<projector_t>::iterator begin, std::vector<projector_t>::iterator end) {
-    // iterate over the edges in the bin
     auto tile = begin->cur_tile;
     auto edges = tile->GetBin(begin->bin_index);
-    for (auto e : edges) {
-      // get the tile and edge
-      if (!reader.GetGraphTile(e, tile)) {
-        continue;
+    if (edges.size() < kSubdivideBinEdgeCount) {
+      // iterate over the edges in the bin
+      for (auto e : edges) {
+        handle_edge(e, tile, begin, end);
       }
+    } else {
+      // dense bins are walked a sub cell at a time, closest first, so the
+      // work is bounded by whats near the candidates rather than by how
+      // many edges the neighborhood packed into the bin
+      handle_dense_bin(begin, end);
+    }
 
-      // no thanks on this one or its evil twin
-      const auto* edge = tile->directededge(e);
-      if (edge_filter(edge) == 0.0f && (!(e = reader.GetOpposingEdgeId(e, tile)).Is_Valid() ||
-                                        edge_filter(edge = tile->directededge(e)) == 0.0f)) {
-        continue;
-      }
+    // bin is finished, advance the candidates to their respective next bins
+    for (auto p_itr = begin; p_itr != end; ++p_itr) {
+      p_itr->next_bin(reader);
+    }
+  }
 
-      // reset these so we know the best point along the edge
-      auto c_itr = bin_candidates.begin();
-      decltype(begin) p_itr;
-      for (p_itr = begin; p_itr != end; ++p_itr, ++c_itr) {
-        c_itr->sq_distance = std::numeric_limits<float>::max();
-      }
+  // handle a single edge of a bin for the range of candidates
+  void handle_edge(GraphId e,
+                   const GraphTile*& tile,
+                   std::vector<projector_t>::iterator begin,
+                   std::vector<projector_t>::iterator end) {
+    // skip the edge when every candidate in this range has already
+    // projected onto it from an earlier bin. any candidate entries it
+    // could add again are dropped as duplicates when we finalize anyway
+    bool unseen = false;
+    for (auto p_itr = begin; p_itr != end; ++p_itr) {
+      unseen = p_itr->tested_edges.insert(e.value).second || unseen;
+    }
+    if (!unseen) {
+      return;
+    }
 
-      // TODO: can we speed this up? the majority of edges will be short and far away enough
-      // such that the closest point on the edge will be one of the edges end points, we can get
-      // these coordinates them from the nodes in the graph. we can then find whichever end is
-      // closest to the input point p, call it n. we can then define an half plane h intersecting n
-      // so that its orthogonal to the ray from p to n. using h, we only need to test segments
-      // of the shape which are on the same side of h that p is. to make this fast we would need a
-      // a trivial half plane test as maybe a single dot product and comparison?
-
-      // get some shape of the edge
-      auto edge_info = std::make_shared<const EdgeInfo>(tile->edgeinfo(edge->edgeinfo_offset()));
-      auto shape = edge_info->lazy_shape();
-      PointLL v;
-      if (!shape.empty()) {
-        v = shape.pop();
-      }
+    // get the tile and edge
+    if (!reader.GetGraphTile(e, tile)) {
+      return;
+    }
+
+    // no thanks on this one or its evil twin
+    const auto* edge = tile->directededge(e);
+    if (edge_filter(edge) == 0.0f && (!(e = reader.GetOpposingEdgeId(e, tile)).Is_Valid() ||
+                                      edge_filter(edge = tile->directededge(e)) == 0.0f)) {
+      return;
+    }
+
+    // reset these so we know the best point along the edge
+    auto c_itr = bin_candidates.begin();
+    decltype(begin) p_itr;
+    for (p_itr = begin; p_itr != end; ++p_itr, ++c_itr) {
+      c_itr->sq_distance = std::numeric_limits<float>::max();
+    }
 
-      // iterate along this edges segments projecting each of the points
-      for (size_t i = 0; !shape.empty(); ++i) {
-        auto u = v;
-        v = shape.pop();
-        // for each input point
-        c_itr = bin_candidates.begin();
-        for (p_itr = begin; p_itr != end; ++p_itr, ++c_itr) {
-          // how close is the input to this segment
-          auto point = p_itr->project(u, v);
-          auto sq_distance = p_itr->approx.DistanceSquared(point);
+    // TODO: can we speed this up? the majority of edges will be short and far away enough
+    // such that the closest point on the edge will be one of the edges end points, we can get
+    // these coordinates them from the nodes in the graph. we can then find whichever end is
+    // closest to the input point p, call it n. we can then define an half plane h intersecting n
+    // so that its orthogonal to the ray from p to n. using h, we only need to test segments
+    // of the shape which are on the same side of h that p is. to make this fast we would need a
+    // a trivial half plane test as maybe a single dot product and comparison?
+
+    // get the decoded shape, the readers lru keeps hot edges decoded so
+    // bin spanning edges arent varint decoded over and over, and the flat
+    // buffer lets the projection below run over contiguous points
+    auto edge_info = std::make_shared<const EdgeInfo>(tile->edgeinfo(edge->edgeinfo_offset()));
+    const auto& shape_points = reader.edgeshape(tile, edge);
+
+    // a box around the shape is a lower bound on how close the edge can
+    // possibly get, so a candidate that already holds better results in
+    // both batches and whose radius the box cant reach skips the whole
+    // projection. the bound only tightens as results accumulate so a
+    // skipped edge stays skippable
+    AABB2<PointLL> shape_box(shape_points);
+
+    // for each input point project every segment, a batch of projected
+    // points at a time so the distance evaluation vectorizes
+    constexpr size_t batch_size = 16;
+    PointLL points[batch_size];
+    float distances[batch_size];
+    size_t nsegments = shape_points.empty() ? 0 : shape_points.size() - 1;
+    c_itr = bin_candidates.begin();
+    for (p_itr = begin; p_itr != end; ++p_itr, ++c_itr) {
+      if (!p_itr->reachable.empty() && !p_itr->unreachable.empty()) {
+        float sq_bound = cell_sq_distance(shape_box, *p_itr);
+        if (sq_bound > p_itr->sq_radius && sq_bound > p_itr->reachable.back().sq_distance &&
+            sq_bound > p_itr->unreachable.back().sq_distance) {
+          continue;
+        }
+      }
+      for (size_t base = 0; base < nsegments; base += batch_size) {
+        size_t count = std::min(batch_size, nsegments - base);
+        for (size_t j = 0; j < count; ++j) {
+          points[j] = p_itr->project(shape_points[base + j], shape_points[base + j + 1]);
+        }
+        p_itr->approx.DistanceSquared(points, count, distances);
+        for (size_t j = 0; j < count; ++j) {
           // do we want to keep it
-          if (sq_distance < c_itr->sq_distance) {
-            c_itr->sq_distance = sq_distance;
-            c_itr->point = std::move(point);
-            c_itr->index = i;
+          if (distances[j] < c_itr->sq_distance) {
+            c_itr->sq_distance = distances[j];
+            c_itr->point = points[j];
+            c_itr->index = base + j;
           }
         }
       }
+    }
+
+    // if we already have a better reachable candidate we can just assume this one is reachable
+    auto reachability = check_reachability(begin, end, tile, edge);
+
+    // keep the best point along this edge if it makes sense
+    c_itr = bin_candidates.begin();
+    for (p_itr = begin; p_itr != end; ++p_itr, ++c_itr) {
+      // which batch of findings
+      auto* batch = reachability < p_itr->location.minimum_reachability_ ? &p_itr->unreachable
+                                                                         : &p_itr->reachable;
+
+      // if its empty append
+      if (batch->empty()) {
+        c_itr->edge = edge;
+        c_itr->edge_id = e;
+        c_itr->edge_info = edge_info;
+        c_itr->tile = tile;
+        batch->emplace_back(std::move(*c_itr));
+        return;
+      }
 
-      // if we already have a better reachable candidate we can just assume this one is reachable
-      auto reachability = check_reachability(begin, end, tile, edge);
-
-      // keep the best point along this edge if it makes sense
-      c_itr = bin_candidates.begin();
-      for (p_itr = begin; p_itr != end; ++p_itr, ++c_itr) {
-        // which batch of findings
-        auto* batch = reachability < p_itr->location.minimum_reachability_ ? &p_itr->unreachable
-                                                                           : &p_itr->reachable;
-
-        // if its empty append
-        if (batch->empty()) {
-          c_itr->edge = edge;
-          c_itr->edge_id = e;
-          c_itr->edge_info = edge_info;
-          c_itr->tile = tile;
+      // get some info about possibilities
+      bool in_radius = c_itr->sq_distance < p_itr->sq_radius;
+      bool better = c_itr->sq_distance < batch->back().sq_distance;
+      bool last_in_radius = batch->back().sq_distance < p_itr->sq_radius;
+
+      // it has to either be better or in the radius to move on
+      if (in_radius || better) {
+        c_itr->edge = edge;
+        c_itr->edge_id = e;
+        c_itr->edge_info = edge_info;
+        c_itr->tile = tile;
+        // the last one wasnt in the radius so replace it with this one because its better or is
+        // in the radius
+        if (!last_in_radius) {
+          batch->back() = std::move(*c_itr);
+          // last one is in the radius but this one is better so put it on the end
+        } else if (better) {
           batch->emplace_back(std::move(*c_itr));
-          continue;
+          // last one is in the radius and this one is not as good so put it on before it
+        } else {
+          batch->emplace_back(std::move(*c_itr));
+          std::swap(*(batch->end() - 1), *(batch->end() - 2));
         }
+      }
+    }
+  }
+
+  // a dense bin regrouped into a finer grid, each cell listing the edges
+  // whose shape passes through it
+  struct sub_bins_t {
+    std::vector<GraphId> edges;
+    uint32_t offsets[kSubBinCells + 1];
+    AABB2<PointLL> cells[kSubBinCells];
+  };
+
+  // the squared distance from the candidate to the closest a cell could hold
+  float cell_sq_distance(const AABB2<PointLL>& cell, const projector_t& p) const {
+    PointLL closest(std::min(std::max(p.lng, cell.minx()), cell.maxx()),
+                    std::min(std::max(p.lat, cell.miny()), cell.maxy()));
+    return p.approx.DistanceSquared(closest);
+  }
+
+  // subdivide a dense bin, cached per worker thread since the same urban
+  // bins are hit over and over across requests
+  const sub_bins_t& subdivided_bin(const GraphTile* tile, size_t bin_index) {
+    static thread_local std::unordered_map<uint64_t, sub_bins_t> cache;
+    // tiles can be replaced at runtime, and a regrouping computed from an
+    // evicted tile names edge indexes the reloaded tile may not have, so
+    // the cache cannot outlive the tile cache generation it was built from
+    static thread_local uint64_t generation = 0;
+    uint64_t current_generation =
+        GraphReader::cache_generation().load(std::memory_order_acquire);
+    if (generation != current_generation) {
+      cache.clear();
+      generation = current_generation;
+    }
+    uint64_t key = (tile->id().value << 5) | bin_index;
+    auto found = cache.find(key);
+    if (found != cache.end()) {
+      return found->second;
+    }
+    if (cache.size() >= kMaxCachedSubBins) {
+      cache.clear();
+    }
+
+    // the bins subdivide the tile and the cells subdivide the bin
+    const auto& tiling = TileHierarchy::levels().rbegin()->second.tiles;
+    auto tile_bounds = tiling.TileBounds(tile->id().tileid());
+    float bin_size = tiling.SubdivisionSize();
+    float cell_size = bin_size / kSubBinsDim;
+    float minx = tile_bounds.minx() + (bin_index % kBinsDim) * bin_size;
+    float miny = tile_bounds.miny() + (bin_index / kBinsDim) * bin_size;
+    AABB2<PointLL> bin_bounds(minx, miny, minx + bin_size, miny + bin_size);
+    auto& sub = cache[key];
+    for (uint32_t c = 0; c < kSubBinCells; ++c) {
+      float cx = minx + (c % kSubBinsDim) * cell_size;
+      float cy = miny + (c / kSubBinsDim) * cell_size;
+      sub.cells[c] = AABB2<PointLL>(cx, cy, cx + cell_size, cy + cell_size);
+    }
 
-        // get some info about possibilities
-        bool in_radius = c_itr->sq_distance < p_itr->sq_radius;
-        bool better = c_itr->sq_distance < batch->back().sq_distance;
-        bool last_in_radius = batch->back().sq_distance < p_itr->sq_radius;
-
-        // it has to either be better or in the radius to move on
-        if (in_radius || better) {
-          c_itr->edge = edge;
-          c_itr->edge_id = e;
-          c_itr->edge_info = edge_info;
-          c_itr->tile = tile;
-          // the last one wasnt in the radius so replace it with this one because its better or is
-          // in the radius
-          if (!last_in_radius) {
-            batch->back() = std::move(*c_itr);
-            // last one is in the radius but this one is better so put it on the end
-          } else if (better) {
-            batch->emplace_back(std::move(*c_itr));
-            // last one is in the radius and this one is not as good so put it on before it
-          } else {
-            batch->emplace_back(std::move(*c_itr));
-            std::swap(*(batch->end() - 1), *(batch->end() - 2));
+    // sort each edge into the cells its shape passes through. this decodes
+    // every shape in the bin but only on the first visit, after which the
+    // cell walks only decode whats near the candidates
+    Tiles<PointLL> sub_tiling(bin_bounds, bin_size, kSubBinsDim, false);
+    std::vector<std::vector<GraphId>> cells(kSubBinCells);
+    const GraphTile* edge_tile = tile;
+    for (auto e : tile->GetBin(bin_index)) {
+      if (!reader.GetGraphTile(e, edge_tile)) {
+        continue;
+      }
+      const auto& shape = reader.edgeshape(edge_tile, edge_tile->directededge(e));
+      bool any = false;
+      for (const auto& entry : sub_tiling.Intersect(shape)) {
+        for (auto cell : entry.second) {
+          if (cell < kSubBinCells) {
+            cells[cell].push_back(e);
+            any = true;
           }
         }
       }
+      // numerical edge cases dont get to lose the edge, clamp it to a cell
+      if (!any && !shape.empty()) {
+        float x = std::max(0.f, (shape.front().lng() - minx) / cell_size);
+        float y = std::max(0.f, (shape.front().lat() - miny) / cell_size);
+        uint32_t col = std::min(kSubBinsDim - 1, static_cast<uint32_t>(x));
+        uint32_t row = std::min(kSubBinsDim - 1, static_cast<uint32_t>(y));
+        cells[row * kSubBinsDim + col].push_back(e);
+      }
     }
 
-    // bin is finished, advance the candidates to their respective next bins
-    for (auto p_itr = begin; p_itr != end; ++p_itr) {
-      p_itr->next_bin(reader);
+    // flatten the cells into one list with offsets
+    uint32_t offset = 0;
+    for (uint32_t c = 0; c < kSubBinCells; ++c) {
+      sub.offsets[c] = offset;
+      offset += cells[c].size();
+    }
+    sub.offsets[kSubBinCells] = offset;
+    sub.edges.reserve(offset);
+    for (const auto& cell : cells) {
+      sub.edges.insert(sub.edges.end(), cell.begin(), cell.end());
+    }
+    return sub;
+  }
+
+  // handle a dense bin by visiting its cells closest first and giving up on
+  // the rest of them with the same rule next_bin uses, so the scan stays
+  // bounded no matter how many edges the bin holds. cells within a
+  // candidate's radius are never skipped so nothing in radius can be missed
+  void handle_dense_bin(std::vector<projector_t>::iterator begin,
+                        std::vector<projector_t>::iterator end) {
+    const auto& sub = subdivided_bin(begin->cur_tile, begin->bin_index);
+
+    // order the cells by how close they could possibly be to any candidate
+    std::pair<float, uint32_t> order[kSubBinCells];
+    for (uint32_t c = 0; c < kSubBinCells; ++c) {
+      float best = std::numeric_limits<float>::max();
+      for (auto p_itr = begin; p_itr != end; ++p_itr) {
+        best = std::min(best, cell_sq_distance(sub.cells[c], *p_itr));
+      }
+      order[c] = {best, c};
+    }
+    std::sort(order, order + kSubBinCells);
+
+    // visit a cell while some candidate is still in reach of it, rechecking
+    // as we go since the candidates collect results cell by cell
+    const GraphTile* tile = begin->cur_tile;
+    for (const auto& entry : order) {
+      bool wanted = false;
+      for (auto p_itr = begin; p_itr != end && !wanted; ++p_itr) {
+        float sq = cell_sq_distance(sub.cells[entry.second], *p_itr);
+        wanted = !(p_itr->reachable.size() && sq > p_itr->sq_radius &&
+                   sq > p_itr->reachable.back().sq_distance);
+      }
+      if (!wanted) {
+        continue;
+      }
+      for (uint32_t i = sub.offsets[entry.second]; i < sub.offsets[entry.second + 1]; ++i) {
+        handle_edge(sub.edges[i], tile, begin, end);
+      }
     }
   }
 
@@ -660,7 +879,12 @@ struct bin_handler_t {
     while (pps.front().has_bin()) {
       auto range = find_best_range(pps);
       handle_bin(range.first, range.second);
-      std::sort(pps.begin(), pps.end());
+      // only the candidates whose bin we just finished moved to new bins,
+      // so sort that stretch and merge it back rather than resorting the
+      // whole batch every round
+      std::sort(range.first, range.second);
+      std::inplace_merge(pps.begin(), range.first, range.second);
+      std::inplace_merge(pps.begin(), range.second, pps.end());
     }
   }
 
@@ -764,6 +988,8 @@ std::unordered_map<Location, PathLocation> Search(const std::vector<Location>& l
   if (locations.empty()) {
     return std::unordered_map<Location, PathLocation>{};
   };
+  // nothing from the previous search outlived it so its scratch memory can back this one
+  search_arena().reset();
   // setup the unique list of locations
   bin_handler_t handler(locations, reader, edge_filter, node_filter);
   // search over the bins doing multiple locations per bin
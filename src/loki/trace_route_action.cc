@@ -115,11 +115,6 @@ namespace loki {
 void loki_worker_t::init_trace(valhalla_request_t& request) {
   parse_costing(request);
 
-  // we require shape or encoded polyline but we dont know which at first
-  if (!request.options.shape_size()) {
-    throw valhalla_exception_t{114};
-  }
-
   // Determine max factor, defaults to 1. This factor is used to increase
   // the max value when an edge_walk shape match is requested
   float max_factor = 1.0f;
@@ -127,15 +122,45 @@ void loki_worker_t::init_trace(valhalla_request_t& request) {
     max_factor = 5.0f;
   }
 
-  // Validate shape count and distance (for now, just send max_factor for distance)
-  check_shape(request.options.shape(), max_trace_shape);
-  check_distance(request.options.shape(), max_distance.find("trace")->second, max_factor);
-
-  // Validate best paths and best paths shape for `map_snap` requests
-  if (request.options.shape_match() == odin::ShapeMatch::map_snap) {
-    check_best_paths(request.options.best_paths(), max_best_paths);
-    check_best_paths_shape(request.options.best_paths(), request.options.shape(),
-                           max_best_paths_shape);
+  // a batch of traces gets each of its shapes validated against the same
+  // limits as a single trace, correlation happens per trace at match time
+  auto traces = rapidjson::get_optional<rapidjson::Value::ConstArray>(request.document, "/traces");
+  if (traces) {
+    // edge walking needs the correlated locations we only find for one shape
+    if (request.options.shape_match() == odin::ShapeMatch::edge_walk) {
+      throw valhalla_exception_t{445};
+    }
+    request.options.set_shape_match(odin::ShapeMatch::map_snap);
+    if (!traces->Size()) {
+      throw valhalla_exception_t{115};
+    }
+    if (traces->Size() > max_trace_batch_size) {
+      throw valhalla_exception_t{159, std::to_string(max_trace_batch_size)};
+    }
+    for (const auto& trace : *traces) {
+      parse_trace_shape(trace, request.options);
+      check_shape(request.options.shape(), max_trace_shape);
+      check_distance(request.options.shape(), max_distance.find("trace")->second, max_factor);
+    }
+    // each trace is reloaded into the shape when it is matched
+    request.options.clear_shape();
+    request.options.clear_encoded_polyline();
+  } else {
+    // we require shape or encoded polyline but we dont know which at first
+    if (!request.options.shape_size()) {
+      throw valhalla_exception_t{114};
+    }
+
+    // Validate shape count and distance (for now, just send max_factor for distance)
+    check_shape(request.options.shape(), max_trace_shape);
+    check_distance(request.options.shape(), max_distance.find("trace")->second, max_factor);
+
+    // Validate best paths and best paths shape for `map_snap` requests
+    if (request.options.shape_match() == odin::ShapeMatch::map_snap) {
+      check_best_paths(request.options.best_paths(), max_best_paths);
+      check_best_paths_shape(request.options.best_paths(), request.options.shape(),
+                             max_best_paths_shape);
+    }
   }
 
   // Validate optional trace options
@@ -149,8 +174,11 @@ void loki_worker_t::init_trace(valhalla_request_t& request) {
     check_turn_penalty_factor(request.options.turn_penalty_factor());
   }
 
-  // Set locations after parsing the shape
-  locations_from_shape(request);
+  // Set locations after parsing the shape. Batched traces are map matched so
+  // there is no single shape to correlate here
+  if (!traces) {
+    locations_from_shape(request);
+  }
 }
 
 void loki_worker_t::trace(valhalla_request_t& request) {
@@ -87,7 +87,7 @@ void loki_worker_t::parse_costing(valhalla_request_t& request) {
   }
 
   try {
-    cost_ptr_t c = factory.Create(costing, request.options);
+    cost_ptr_t c = factory.CreateCached(costing, request.options);
     edge_filter = c->GetEdgeFilter();
     node_filter = c->GetNodeFilter();
   } catch (const std::runtime_error&) { throw valhalla_exception_t{125, "'" + costing_str + "'"}; }
@@ -131,6 +131,8 @@ loki_worker_t::loki_worker_t(const boost::property_tree::ptree& config,
       max_contours(config.get<size_t>("service_limits.isochrone.max_contours")),
       max_time(config.get<size_t>("service_limits.isochrone.max_time")),
       max_trace_shape(config.get<size_t>("service_limits.trace.max_shape")),
+      max_trace_batch_size(config.get<size_t>("service_limits.trace.max_batch_size", 64)),
+      max_locate_locations(config.get<size_t>("service_limits.locate.max_locations", 5000)),
       sample(config.get<std::string>("additional_data.elevation", "test/data/")),
       max_elevation_shape(config.get<size_t>("service_limits.skadi.max_shape")),
       min_resample(config.get<float>("service_limits.skadi.min_resample")) {
@@ -158,6 +160,9 @@ loki_worker_t::loki_worker_t(const boost::property_tree::ptree& config,
         kv.first == "max_radius" || kv.first == "max_timedep_distance") {
       continue;
     }
+    if (kv.first == "locate") {
+      continue;
+    }
     if (kv.first != "skadi" && kv.first != "trace") {
       max_locations.emplace(kv.first,
                             config.get<size_t>("service_limits." + kv.first + ".max_locations"));
@@ -205,11 +210,112 @@ loki_worker_t::loki_worker_t(const boost::property_tree::ptree& config,
   max_best_paths = config.get<unsigned int>("service_limits.trace.max_best_paths");
   max_best_paths_shape = config.get<size_t>("service_limits.trace.max_best_paths_shape");
 
+  // Number of correlation results to keep in the in-process cache so
+  // repeated waypoints (fleet depots, popular pickup points) skip the
+  // candidate search. Defaults to disabled
+  correlation_cache_size = config.get<size_t>("loki.correlation_cache_size", 0);
+  correlation_cache_generation = 0;
+
+  // Ring for handing thor the big intermediate bodies without copying them
+  // through the sockets, when the deployment turned that on
+  message_arena = shm_message_arena_t::from_config(config);
+
   // Register standard edge/node costing methods
   factory.RegisterStandardCostingModels();
 }
 
+std::string loki_worker_t::correlation_cache_key(const baldr::Location& location,
+                                                 const valhalla_request_t& request) const {
+  // quantize the coordinates to ~0.1m so jittery depot coordinates from
+  // different devices still map to the same key
+  std::string key = std::to_string(static_cast<int64_t>(location.latlng_.lng() * 1e6)) + ',' +
+                    std::to_string(static_cast<int64_t>(location.latlng_.lat() * 1e6));
+
+  // everything the search reads from the location
+  key += '|' + std::to_string(location.minimum_reachability_) + '|' +
+         std::to_string(location.radius_);
+  if (location.heading_) {
+    key += '|' + std::to_string(*location.heading_) + '/' +
+           std::to_string(location.heading_tolerance_ ? *location.heading_tolerance_ : -1);
+  }
+  if (location.node_snap_tolerance_) {
+    key += '|' + std::to_string(*location.node_snap_tolerance_);
+  }
+  if (location.way_id_) {
+    key += '|' + std::to_string(*location.way_id_);
+  }
+
+  // the costing filters are a function of the costing and its options
+  key += '|' + odin::Costing_Name(request.options.costing());
+  if (static_cast<int>(request.options.costing()) < request.options.costing_options_size()) {
+    request.options.costing_options(static_cast<int>(request.options.costing()))
+        .AppendToString(&key);
+  }
+  return key;
+}
+
+std::unordered_map<baldr::Location, baldr::PathLocation>
+loki_worker_t::cached_search(const std::vector<baldr::Location>& locations,
+                             const valhalla_request_t& request) {
+  if (correlation_cache_size == 0) {
+    return loki::Search(locations, *reader, edge_filter, node_filter);
+  }
+
+  // cached candidates point into the tiles they were projected onto, so the
+  // whole cache goes whenever the reader dropped tiles
+  auto generation = baldr::GraphReader::cache_generation().load();
+  if (generation != correlation_cache_generation) {
+    correlation_cache.clear();
+    correlation_cache_lru.clear();
+    correlation_cache_generation = generation;
+  }
+
+  // serve what we can from the cache and search the rest
+  std::unordered_map<baldr::Location, baldr::PathLocation> projections;
+  std::vector<baldr::Location> misses;
+  for (const auto& location : locations) {
+    auto cached = correlation_cache.find(correlation_cache_key(location, request));
+    if (cached != correlation_cache.end()) {
+      // move the entry to the front of the LRU list
+      correlation_cache_lru.erase(cached->second.lru);
+      correlation_cache_lru.push_front(cached->first);
+      cached->second.lru = correlation_cache_lru.begin();
+      // graft the cached candidates onto this request's location so its
+      // other attributes (date_time, stop type) stay its own
+      PathLocation correlated(location);
+      correlated.edges = cached->second.correlated.edges;
+      correlated.filtered_edges = cached->second.correlated.filtered_edges;
+      projections.emplace(location, std::move(correlated));
+    } else {
+      misses.push_back(location);
+    }
+  }
+  if (misses.empty()) {
+    return projections;
+  }
+
+  // cache the searched results, evicting the least recently used when full
+  auto searched = loki::Search(misses, *reader, edge_filter, node_filter);
+  for (auto& kv : searched) {
+    auto key = correlation_cache_key(kv.first, request);
+    if (correlation_cache.find(key) == correlation_cache.end()) {
+      if (correlation_cache.size() >= correlation_cache_size) {
+        correlation_cache.erase(correlation_cache_lru.back());
+        correlation_cache_lru.pop_back();
+      }
+      correlation_cache_lru.push_front(key);
+      correlation_cache.emplace(std::move(key),
+                                CorrelationCacheEntry{kv.second, correlation_cache_lru.begin()});
+    }
+    projections.emplace(kv.first, std::move(kv.second));
+  }
+  return projections;
+}
+
 void loki_worker_t::cleanup() {
+  // between requests no tile pointers are in flight, so this is a safe
+  // point to pick up updated tiles
+  reader->CheckForTileUpdates();
   if (reader->OverCommitted()) {
     reader->Clear();
   }
@@ -253,12 +359,14 @@ worker_t::result_t loki_worker_t::work(const std::list<zmq::message_t>& job,
     service_worker_t::set_interrupt(interrupt_function);
 
     worker_t::result_t result{true};
+    // whether the request moves on to thor, in which case the intermediate
+    // messages are serialized after the stage timing has been recorded
+    bool forward = false;
     // do request specific processing
     switch (request.options.action()) {
       case odin::DirectionsOptions::route:
         route(request);
-        result.messages.emplace_back(rapidjson::to_string(request.document));
-        result.messages.emplace_back(request.options.SerializeAsString());
+        forward = true;
         break;
       case odin::DirectionsOptions::locate:
         result = to_response_json(locate(request), info, request);
@@ -266,19 +374,17 @@ worker_t::result_t loki_worker_t::work(const std::list<zmq::message_t>& job,
       case odin::DirectionsOptions::sources_to_targets:
       case odin::DirectionsOptions::optimized_route:
         matrix(request);
-        result.messages.emplace_back(rapidjson::to_string(request.document));
-        result.messages.emplace_back(request.options.SerializeAsString());
+        forward = true;
         break;
       case odin::DirectionsOptions::isochrone:
+      case odin::DirectionsOptions::one_to_all:
         isochrones(request);
-        result.messages.emplace_back(rapidjson::to_string(request.document));
-        result.messages.emplace_back(request.options.SerializeAsString());
+        forward = true;
         break;
       case odin::DirectionsOptions::trace_attributes:
       case odin::DirectionsOptions::trace_route:
         trace(request);
-        result.messages.emplace_back(rapidjson::to_string(request.document));
-        result.messages.emplace_back(request.options.SerializeAsString());
+        forward = true;
         break;
       case odin::DirectionsOptions::height:
         result = to_response_json(height(request), info, request);
@@ -293,6 +399,18 @@ worker_t::result_t loki_worker_t::work(const std::list<zmq::message_t>& job,
     // get processing time for loki
     auto e = std::chrono::system_clock::now();
     std::chrono::duration<float, std::milli> elapsed_time = e - s;
+    add_stage_trace(request.options, "loki", elapsed_time.count());
+    if (forward) {
+      // a big intermediate body (a long trace, the correlated candidates of
+      // a large matrix) can ride the shared memory ring with just its handle
+      // going through the proxies; small ones stay in the envelope
+      auto request_str = rapidjson::to_string(request.document);
+      auto handle = message_arena ? message_arena->stash(request_str) : std::string();
+      result.messages.emplace_back(handle.empty() ? std::move(request_str) : std::move(handle));
+      handle = message_arena ? message_arena->stash(request.options) : std::string();
+      result.messages.emplace_back(handle.empty() ? request.options.SerializeAsString()
+                                                  : std::move(handle));
+    }
     // log request if greater than X (ms)
     auto work_units = request.options.locations_size()
                           ? request.options.locations_size()
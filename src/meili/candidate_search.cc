@@ -2,6 +2,11 @@
 #include "baldr/tilehierarchy.h"
 #include "meili/geometry_helpers.h"
 
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+
 namespace valhalla {
 
 namespace meili {
@@ -53,10 +58,9 @@ CandidateQuery::WithinSquaredDistance(const midgard::PointLL& location,
       continue;
     }
 
-    // NOTE a pointer to edgeinfo is needed here because it returns
-    // an unique ptr
-    const auto edgeinfo = tile->edgeinfo(edge->edgeinfo_offset());
-    const auto& shape = edgeinfo.shape();
+    // the readers lru of decoded shapes saves re-decoding hot edges that
+    // show up under many trace points
+    const auto& shape = reader_.edgeshape(tile, edge);
     if (shape.empty()) {
       // Otherwise Project will fail
       continue;
@@ -127,6 +131,7 @@ void IndexBin(const baldr::GraphTile& tile,
               CandidateGridQuery::grid_t& grid) {
   // Get the edges within the specified bin.
   auto edge_ids = tile.GetBin(bin_index);
+  std::vector<PointLL> shape_points;
   for (const auto& edge_id : edge_ids) {
     // Get the right tile (edges in a bin can be in a different tile if they
     // pass through the tile but do not start or end in the tile). Skip if
@@ -137,24 +142,93 @@ void IndexBin(const baldr::GraphTile& tile,
       continue;
     }
 
-    // Get the edge shape and add to grid. Use lazy_shape to avoid allocations
+    // Get the edge shape and add the whole linestring to the grid in one
+    // batched pass so the edge is pushed into each square it crosses only
+    // once. The point list is reused across edges to avoid allocations
     // NOTE: bins do not contain transition edges and transit connection edges
     auto shape = bin_tile->edgeinfo(bin_tile->directededge(edge_id)->edgeinfo_offset()).lazy_shape();
-    if (!shape.empty()) {
-      PointLL v = shape.pop();
-      while (!shape.empty()) {
-        const PointLL u = v;
-        v = shape.pop();
-        grid.AddLineSegment(edge_id, {u, v});
+    shape_points.clear();
+    while (!shape.empty()) {
+      shape_points.push_back(shape.pop());
+    }
+    grid.AddLineString(edge_id, shape_points);
+  }
+}
+
+// The process wide grid cache. Grids are immutable once built for a given
+// tile generation, so readers work off an immutable snapshot swapped in
+// atomically: lookups are a lock free atomic_load of the snapshot pointer
+// while publishing a newly built grid copies the map under a mutex and swaps
+// the new snapshot in. A snapshot built against tiles that have since been
+// reloaded (the generation moved) or with a different cell size (only
+// happens when a process mixes grid configs) is simply not consulted
+struct CandidateGridQuery::shared_cache_t {
+  struct snapshot_t {
+    uint64_t generation;
+    float cell_width;
+    float cell_height;
+    std::unordered_map<int32_t, std::shared_ptr<const grid_t>> grids;
+  };
+
+  // keep roughly the configured per matcher bound worth of grids before
+  // starting over, mirroring MapMatcherFactory::ClearFullCache
+  static constexpr size_t kMaxSharedGrids = 100240;
+
+  std::shared_ptr<const snapshot_t> read() const {
+    return std::atomic_load_explicit(&snapshot_, std::memory_order_acquire);
+  }
+
+  std::shared_ptr<const grid_t> publish(const int32_t bin_id,
+                                        const uint64_t generation,
+                                        const float cell_width,
+                                        const float cell_height,
+                                        const std::shared_ptr<const grid_t>& grid) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto current = read();
+    const bool current_usable = current && current->generation == generation &&
+                                current->cell_width == cell_width &&
+                                current->cell_height == cell_height;
+    // another matcher may have raced us to this bin, share its copy instead
+    if (current_usable) {
+      const auto found = current->grids.find(bin_id);
+      if (found != current->grids.end()) {
+        return found->second;
       }
     }
+
+    // copy the entries forward unless the tiles changed underneath them or
+    // the cache outgrew its bound, in which case start over
+    auto updated = std::make_shared<snapshot_t>();
+    updated->generation = generation;
+    updated->cell_width = cell_width;
+    updated->cell_height = cell_height;
+    if (current_usable && current->grids.size() < kMaxSharedGrids) {
+      updated->grids = current->grids;
+    }
+    updated->grids[bin_id] = grid;
+    std::atomic_store_explicit(&snapshot_,
+                               std::shared_ptr<const snapshot_t>(std::move(updated)),
+                               std::memory_order_release);
+    return grid;
   }
+
+private:
+  std::shared_ptr<const snapshot_t> snapshot_;
+  std::mutex mutex_;
+};
+
+constexpr size_t CandidateGridQuery::shared_cache_t::kMaxSharedGrids;
+
+CandidateGridQuery::shared_cache_t& CandidateGridQuery::shared_cache() {
+  static shared_cache_t cache;
+  return cache;
 }
 
 CandidateGridQuery::CandidateGridQuery(baldr::GraphReader& reader,
                                        float cell_width,
                                        float cell_height)
-    : CandidateQuery(reader), cell_width_(cell_width), cell_height_(cell_height), grid_cache_() {
+    : CandidateQuery(reader), cell_width_(cell_width), cell_height_(cell_height), grid_cache_(),
+      cache_generation_(baldr::GraphReader::cache_generation().load(std::memory_order_acquire)) {
   bin_level_ = baldr::TileHierarchy::levels().rbegin()->second.level;
 }
 
@@ -165,13 +239,33 @@ inline const CandidateGridQuery::grid_t*
 CandidateGridQuery::GetGrid(const int32_t bin_id,
                             const Tiles<PointLL>& tiles,
                             const Tiles<PointLL>& bins) const {
+  // Toss handles to grids built against tiles that have since been reloaded
+  const auto generation =
+      baldr::GraphReader::cache_generation().load(std::memory_order_acquire);
+  if (generation != cache_generation_) {
+    grid_cache_.clear();
+    cache_generation_ = generation;
+  }
+
   // Check if the bin is in the cache
   const auto it = grid_cache_.find(bin_id);
   if (it != grid_cache_.end()) {
-    return &(it->second);
+    return it->second.get();
+  }
+
+  // Check the process wide cache another matcher may have filled
+  auto& shared = shared_cache();
+  auto snapshot = shared.read();
+  const bool shareable = !snapshot || (snapshot->cell_width == cell_width_ &&
+                                       snapshot->cell_height == cell_height_);
+  if (snapshot && shareable && snapshot->generation == generation) {
+    const auto found = snapshot->grids.find(bin_id);
+    if (found != snapshot->grids.end()) {
+      return grid_cache_.emplace(bin_id, found->second).first->second.get();
+    }
   }
 
-  // Not in the cache. Get the tile and Index the bin within the tile.
+  // Not cached anywhere. Get the tile and Index the bin within the tile.
   int32_t ndiv = tiles.nsubdivisions();
   auto rc = bins.GetRowColumn(bin_id);
   int32_t tile_id = tiles.TileId(rc.second / ndiv, rc.first / ndiv);
@@ -186,11 +280,15 @@ CandidateGridQuery::GetGrid(const int32_t bin_id,
   int32_t bin_col = rc.second % ndiv;
   int32_t bin_index = (bin_row * ndiv) + bin_col;
 
-  // Insert the bin into the cache and index the bin
-  const auto inserted =
-      grid_cache_.emplace(bin_id, grid_t(tile->BoundingBox(), cell_width_, cell_height_));
-  IndexBin(*tile, bin_index, reader_, inserted.first->second);
-  return &(inserted.first->second);
+  // Index the bin and publish the grid so concurrent matchers share the one
+  // copy, unless this instance's cell size disagrees with what is published
+  auto built = std::make_shared<grid_t>(tile->BoundingBox(), cell_width_, cell_height_);
+  IndexBin(*tile, bin_index, reader_, *built);
+  std::shared_ptr<const grid_t> grid = std::move(built);
+  if (shareable) {
+    grid = shared.publish(bin_id, generation, cell_width_, cell_height_, grid);
+  }
+  return grid_cache_.emplace(bin_id, std::move(grid)).first->second.get();
 }
 
 std::unordered_set<baldr::GraphId>
@@ -228,5 +326,70 @@ std::vector<baldr::PathLocation> CandidateGridQuery::Query(const midgard::PointL
   return WithinSquaredDistance(location, sq_search_radius, edgeids.begin(), edgeids.end(), filter);
 }
 
+std::vector<std::vector<baldr::PathLocation>>
+CandidateGridQuery::QueryBulk(const std::vector<midgard::PointLL>& locations,
+                              float sq_search_radius,
+                              sif::EdgeFilter filter) {
+  // not enough points or hardware to be worth the thread hand off
+  const size_t concurrency =
+      std::min<size_t>(std::thread::hardware_concurrency(), locations.size());
+  if (concurrency < 2) {
+    return CandidateQuery::QueryBulk(locations, sq_search_radius, filter);
+  }
+
+  // compute the ranges and build the grids they touch up front on this
+  // thread, the reader and the grid cache are not safe to share
+  Tiles<PointLL> tiles = baldr::TileHierarchy::levels().rbegin()->second.tiles;
+  Tiles<PointLL> bins(tiles.TileBounds(), tiles.SubdivisionSize());
+  std::vector<AABB2<PointLL>> ranges;
+  ranges.reserve(locations.size());
+  for (const auto& location : locations) {
+    if (!location.IsValid()) {
+      throw std::invalid_argument("Expect a valid location");
+    }
+    ranges.push_back(midgard::ExpandMeters(location, std::sqrt(sq_search_radius)));
+    for (auto bin_id : bins.TileList(ranges.back())) {
+      GetGrid(bin_id, tiles, bins);
+    }
+  }
+
+  // partition the points across threads, each one running its grid range
+  // queries against the now read only shared grids
+  std::vector<std::vector<baldr::GraphId>> hits(locations.size());
+  std::atomic<size_t> next(0);
+  auto ranger = [&]() {
+    size_t i;
+    while ((i = next.fetch_add(1)) < ranges.size()) {
+      std::unordered_set<baldr::GraphId> result;
+      for (auto bin_id : bins.TileList(ranges[i])) {
+        const auto grid = grid_cache_.find(bin_id);
+        if (grid != grid_cache_.end()) {
+          const auto set = grid->second->Query(ranges[i]);
+          result.insert(set.begin(), set.end());
+        }
+      }
+      hits[i].assign(result.begin(), result.end());
+    }
+  };
+  std::vector<std::thread> threads;
+  threads.reserve(concurrency);
+  for (size_t t = 0; t < concurrency; ++t) {
+    threads.emplace_back(ranger);
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  // project each point onto its candidate edges back on this thread since
+  // the projection goes through the reader's tile and shape caches
+  std::vector<std::vector<baldr::PathLocation>> results;
+  results.reserve(locations.size());
+  for (size_t i = 0; i < locations.size(); ++i) {
+    results.push_back(WithinSquaredDistance(locations[i], sq_search_radius, hits[i].begin(),
+                                            hits[i].end(), filter));
+  }
+  return results;
+}
+
 } // namespace meili
 } // namespace valhalla
@@ -4,6 +4,7 @@
 #include "meili/geometry_helpers.h"
 #include "meili/map_matcher.h"
 #include "meili/routing.h"
+#include "meili/trace_prefetcher.h"
 #include "meili/transition_cost_model.h"
 #include "midgard/distanceapproximator.h"
 
@@ -190,14 +191,10 @@ std::vector<MatchResult> InterpolateMeasurements(const MapMatcher& mapmatcher,
 // Find the match result of a state, given its previous state and next
 // state
 MatchResult FindMatchResult(const MapMatcher& mapmatcher,
-                            const std::vector<StateId>& stateids,
+                            const StateId& prev_stateid,
+                            const StateId& stateid,
+                            const StateId& next_stateid,
                             StateId::Time time) {
-  if (!(time < stateids.size())) {
-    throw std::runtime_error("reading stateid at time out of bounds");
-  }
-
-  const auto &prev_stateid = 0 < time ? stateids[time - 1] : StateId(), stateid = stateids[time],
-             next_stateid = time + 1 < stateids.size() ? stateids[time + 1] : StateId();
   const auto& measurement = mapmatcher.state_container().measurement(time);
 
   if (!stateid.IsValid()) {
@@ -244,6 +241,18 @@ MatchResult FindMatchResult(const MapMatcher& mapmatcher,
           edge.percent_along, measurement.epoch_time(), stateid};
 }
 
+// Find the match result of a state in a complete list of states
+MatchResult FindMatchResult(const MapMatcher& mapmatcher,
+                            const std::vector<StateId>& stateids,
+                            StateId::Time time) {
+  if (!(time < stateids.size())) {
+    throw std::runtime_error("reading stateid at time out of bounds");
+  }
+
+  return FindMatchResult(mapmatcher, 0 < time ? stateids[time - 1] : StateId(), stateids[time],
+                         time + 1 < stateids.size() ? stateids[time + 1] : StateId(), time);
+}
+
 // Find the corresponding match results of a list of states
 std::vector<MatchResult> FindMatchResults(const MapMatcher& mapmatcher,
                                           const std::vector<StateId>& stateids) {
@@ -292,9 +301,11 @@ MapMatcher::MapMatcher(const boost::property_tree::ptree& config,
                        baldr::GraphReader& graphreader,
                        CandidateQuery& candidatequery,
                        const sif::cost_ptr_t* mode_costing,
-                       sif::TravelMode travelmode)
+                       sif::TravelMode travelmode,
+                       TracePrefetcher* prefetcher)
     : config_(config), graphreader_(graphreader), candidatequery_(candidatequery),
-      mode_costing_(mode_costing), travelmode_(travelmode), interrupt_(nullptr), vs_(), ts_(vs_),
+      prefetcher_(prefetcher), mode_costing_(mode_costing), travelmode_(travelmode),
+      interrupt_(nullptr), vs_(), ts_(vs_),
       container_(), emission_cost_model_(graphreader_, container_, config_),
       transition_cost_model_(graphreader_,
                              vs_,
@@ -302,9 +313,16 @@ MapMatcher::MapMatcher(const boost::property_tree::ptree& config,
                              container_,
                              mode_costing_,
                              travelmode_,
-                             config_) {
+                             config_),
+      online_active_(false), online_confirmed_(0) {
   vs_.set_emission_cost_model(emission_cost_model_);
+  vs_.set_batch_emission_cost_model(emission_cost_model_);
   vs_.set_transition_cost_model(transition_cost_model_);
+  vs_.set_transition_cost_lower_bound_model([this](const StateId& lhs, const StateId& rhs) {
+    // map any topk clones back to the original states the container knows
+    return transition_cost_model_.LowerBound(ts_.GetOrigin(lhs, lhs), ts_.GetOrigin(rhs, rhs));
+  });
+  vs_.set_beam_width(config_.get<uint32_t>("beam_width", 0));
 }
 
 MapMatcher::~MapMatcher() {
@@ -314,9 +332,14 @@ void MapMatcher::Clear() {
   vs_.Clear();
   // reset cost models because they were possibly replaced by topk
   vs_.set_emission_cost_model(emission_cost_model_);
+  vs_.set_batch_emission_cost_model(emission_cost_model_);
   vs_.set_transition_cost_model(transition_cost_model_);
   ts_.Clear();
   container_.Clear();
+  online_active_ = false;
+  online_confirmed_ = 0;
+  online_last_stateid_ = StateId();
+  online_interpolated_.clear();
 }
 
 void MapMatcher::RemoveRedundancies(const std::vector<StateId>& result) {
@@ -355,9 +378,10 @@ void MapMatcher::RemoveRedundancies(const std::vector<StateId>& result) {
         continue;
       }
 
-      // If we didnt compute the paths from this loser we need to do it now
+      // If we didnt compute the paths from this loser we need to do it now,
+      // going around any route memoization since we need the labels
       if (!left_unused_candidate.routed()) {
-        vs_.transition_cost_model()(left_unused_candidate.stateid(), StateId(time + 1, 0));
+        transition_cost_model_.EnsureRoute(left_unused_candidate.stateid(), StateId(time + 1, 0));
       }
 
       // For each candidate in the right state
@@ -535,6 +559,23 @@ std::vector<MatchResults> MapMatcher::OfflineMatch(const std::vector<Measurement
 
   bool found_broken_path = false;
 
+  // Walk the trace ahead of the matcher pulling the tiles and candidate
+  // grids it is about to need, so a long haul trace overlaps its tile io
+  // with the matching instead of stalling on it point by point
+  const bool prefetching = prefetcher_ != nullptr && measurements.size() > 1;
+  if (prefetching) {
+    prefetcher_->Start(measurements);
+  }
+  // the lookahead must let go of the measurements however this match ends
+  struct prefetch_guard_t {
+    TracePrefetcher* prefetcher;
+    ~prefetch_guard_t() {
+      if (prefetcher != nullptr) {
+        prefetcher->Finish();
+      }
+    }
+  } prefetch_guard{prefetching ? prefetcher_ : nullptr};
+
   // Separate the measurements we are using for matching from the ones we'll just interpolate
   auto interpolated = AppendMeasurements(measurements);
 
@@ -586,6 +627,15 @@ std::vector<MatchResults> MapMatcher::OfflineMatch(const std::vector<Measurement
       }
     }
 
+    // Route memoization may have skipped routing between states along the
+    // winning path, route them now so the path can be reconstructed
+    for (StateId::Time time = 0; time + 1 < original_state_ids.size(); time++) {
+      if (original_state_ids[time].IsValid() && original_state_ids[time + 1].IsValid()) {
+        transition_cost_model_.EnsureRoute(original_state_ids[time],
+                                           original_state_ids[time + 1]);
+      }
+    }
+
     // Get the match result for each of the states
     auto results = FindMatchResults(*this, original_state_ids);
 
@@ -652,6 +702,128 @@ std::vector<MatchResults> MapMatcher::OfflineMatch(const std::vector<Measurement
   return best_paths;
 }
 
+std::vector<MatchResult> MapMatcher::OnlineMatch(const Measurement& measurement) {
+  const float max_search_radius = config_.get<float>("max_search_radius"),
+              sq_max_search_radius = max_search_radius * max_search_radius;
+  const float interpolation_distance = config_.get<float>("interpolation_distance"),
+              sq_interpolation_distance = interpolation_distance * interpolation_distance;
+  const auto window = std::max(config_.get<StateId::Time>("online_confirm_window", 10),
+                               static_cast<StateId::Time>(1));
+
+  // The first measurement of a trace starts the session over, it can never
+  // be confirmed before a second one arrives
+  if (!online_active_) {
+    Clear();
+    AppendMeasurement(measurement, sq_max_search_radius);
+    online_active_ = true;
+    return {};
+  }
+
+  // This one is so close to the last match that we will just interpolate it
+  // once the states on either side of it are confirmed
+  const auto last_time = static_cast<StateId::Time>(container_.size()) - 1;
+  const auto& last_measurement = container_.measurement(last_time);
+  const auto sq_distance = GreatCircleDistanceSquared(last_measurement, measurement);
+  if (sq_distance <= sq_interpolation_distance) {
+    online_interpolated_[last_time].push_back(measurement);
+    return {};
+  }
+
+  // If there were interpolated points with time information between these
+  // two match points, detect lingering the same way AppendMeasurements does
+  const auto it = online_interpolated_.find(last_time);
+  if (it != online_interpolated_.end() && it->second.back().epoch_time() != -1) {
+    auto p = it->second.back().lnglat().Project(last_measurement.lnglat(), measurement.lnglat());
+    if (p.Distance(last_measurement.lnglat()) /
+            last_measurement.lnglat().Distance(measurement.lnglat()) <
+        .2f) {
+      container_.SetMeasurementLeaveTime(last_time, it->second.back().epoch_time());
+    }
+  }
+
+  const auto time = AppendMeasurement(measurement, sq_max_search_radius);
+
+  // Confirm whatever fell out of the window
+  std::vector<MatchResult> results;
+  while (online_confirmed_ + window <= time) {
+    ConfirmOnlineResult(time, results);
+  }
+
+  return results;
+}
+
+std::vector<MatchResult> MapMatcher::OnlineMatchFinish() {
+  std::vector<MatchResult> results;
+  if (!online_active_) {
+    return results;
+  }
+
+  // If the trace ended on points we were saving for interpolation, promote
+  // the last of them to a match, like OfflineMatch always matches the last
+  // measurement
+  auto last_time = static_cast<StateId::Time>(container_.size()) - 1;
+  const auto it = online_interpolated_.find(last_time);
+  if (it != online_interpolated_.end()) {
+    const float max_search_radius = config_.get<float>("max_search_radius");
+    const auto last = it->second.back();
+    it->second.pop_back();
+    if (it->second.empty()) {
+      online_interpolated_.erase(it);
+    }
+    last_time = AppendMeasurement(last, max_search_radius * max_search_radius);
+  }
+
+  // Confirm everything that is left
+  while (online_confirmed_ <= last_time) {
+    ConfirmOnlineResult(last_time, results);
+  }
+
+  Clear();
+  return results;
+}
+
+void MapMatcher::ConfirmOnlineResult(const StateId::Time latest, std::vector<MatchResult>& results) {
+  const auto time = online_confirmed_;
+
+  // Walk the best path ending at the latest matched time back to the
+  // measurement being confirmed, mapping any topk clones (there are none in
+  // online matching but GetOrigin is cheap) back to their original states
+  std::vector<StateId> chain;
+  chain.reserve(latest - time + 1);
+  for (auto it = vs_.SearchPath(latest); chain.size() < latest - time + 1; ++it) {
+    chain.push_back(ts_.GetOrigin(*it, *it));
+  }
+  const auto& stateid = chain.back();
+  const auto& next_stateid = 2 <= chain.size() ? chain[chain.size() - 2] : StateId();
+
+  // Route memoization may have skipped routing between these states, route
+  // them now so the results can be reconstructed
+  if (online_last_stateid_.IsValid() && stateid.IsValid()) {
+    transition_cost_model_.EnsureRoute(online_last_stateid_, stateid);
+  }
+  if (stateid.IsValid() && next_stateid.IsValid()) {
+    transition_cost_model_.EnsureRoute(stateid, next_stateid);
+  }
+
+  // The points interpolated between the last confirmed measurement and this
+  // one come first, now that the states on either side of them are fixed
+  if (0 < time) {
+    const auto it = online_interpolated_.find(time - 1);
+    if (it != online_interpolated_.end()) {
+      const auto& interpolated_results =
+          InterpolateMeasurements(*this, it->second, online_last_stateid_, stateid);
+      std::copy(interpolated_results.cbegin(), interpolated_results.cend(),
+                std::back_inserter(results));
+      online_interpolated_.erase(it);
+    }
+  }
+
+  results.push_back(FindMatchResult(*this, online_last_stateid_, stateid, next_stateid, time));
+
+  online_last_stateid_ = stateid;
+  ++online_confirmed_;
+}
+
 std::unordered_map<StateId::Time, std::vector<Measurement>>
 MapMatcher::AppendMeasurements(const std::vector<Measurement>& measurements) {
   const float max_search_radius = config_.get<float>("max_search_radius"),
@@ -663,8 +835,15 @@ MapMatcher::AppendMeasurements(const std::vector<Measurement>& measurements) {
   // Always match the first measurement
   auto last = measurements.cbegin();
   auto time = AppendMeasurement(*last, sq_max_search_radius);
+  if (prefetcher_ != nullptr) {
+    prefetcher_->Advance();
+  }
   double interpolated_epoch_time = -1;
   for (auto m = std::next(last); m != measurements.end(); ++m) {
+    // one more measurement consumed, the lookahead may move up
+    if (prefetcher_ != nullptr) {
+      prefetcher_->Advance();
+    }
     const auto sq_distance = GreatCircleDistanceSquared(*last, *m);
     // Always match the last measurement and if its far enough away
     if (sq_interpolation_distance < sq_distance || std::next(m) == measurements.end()) {
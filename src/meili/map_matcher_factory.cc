@@ -10,6 +10,7 @@
 
 #include "meili/candidate_search.h"
 #include "meili/map_matcher.h"
+#include "meili/trace_prefetcher.h"
 
 #include "meili/map_matcher_factory.h"
 
@@ -27,13 +28,23 @@ namespace meili {
 
 MapMatcherFactory::MapMatcherFactory(const boost::property_tree::ptree& root,
                                      const std::shared_ptr<baldr::GraphReader>& graph_reader)
-    : config_(root.get_child("meili")), graphreader_(graph_reader),
-      max_grid_cache_size_(root.get<float>("meili.grid.cache_size")) {
+    : config_(root.get_child("meili")), default_config_(config_.get_child("default")),
+      graphreader_(graph_reader), max_grid_cache_size_(root.get<float>("meili.grid.cache_size")) {
+  // Pull the list of customizable options out of the tree once, per request
+  // merges then only touch the handful of options a request actually set
+  for (const auto& item : config_.get_child("customizable")) {
+    customizable_.insert(item.second.get_value<std::string>());
+  }
   if (!graphreader_)
     graphreader_.reset(new baldr::GraphReader(root.get_child("mjolnir")));
   candidatequery_.reset(
       new CandidateGridQuery(*graphreader_, local_tile_size() / root.get<size_t>("meili.grid.size"),
                              local_tile_size() / root.get<size_t>("meili.grid.size")));
+  // Walks long traces ahead of the matcher warming the tiles and candidate
+  // grids they are about to need. Defaults to disabled
+  if (root.get<uint32_t>("meili.lookahead_window", 0) > 0) {
+    prefetcher_.reset(new TracePrefetcher(root));
+  }
   cost_factory_.RegisterStandardCostingModels();
 }
 
@@ -51,7 +62,8 @@ MapMatcher* MapMatcherFactory::Create(const odin::Costing costing,
   mode_costing_[static_cast<uint32_t>(mode)] = cost;
 
   // TODO investigate exception safety
-  return new MapMatcher(config, *graphreader_, *candidatequery_, mode_costing_, mode);
+  return new MapMatcher(config, *graphreader_, *candidatequery_, mode_costing_, mode,
+                        prefetcher_.get());
 }
 
 MapMatcher* MapMatcherFactory::Create(const odin::DirectionsOptions& options) {
@@ -59,29 +71,24 @@ MapMatcher* MapMatcherFactory::Create(const odin::DirectionsOptions& options) {
 }
 
 boost::property_tree::ptree MapMatcherFactory::MergeConfig(const odin::DirectionsOptions& options) {
-  // Copy the default child config
-  auto config = config_.get_child("default");
-
-  // Get a list of customizable options
-  std::unordered_set<std::string> customizable;
-  for (const auto& item : config_.get_child("customizable")) {
-    customizable.insert(item.second.get_value<std::string>());
-  }
+  // Copy the default config pulled out of the tree at construction
+  auto config = default_config_;
 
   // Check for overrides of matcher related directions options. Override these values in config.
   // TODO - there are several options listed as customizable that are not documented
   // in the interface...either add them and document or remove them from config?
-  if (options.search_radius() && customizable.find("search_radius") != customizable.end()) {
+  if (options.search_radius() && customizable_.find("search_radius") != customizable_.end()) {
     config.put<float>("search_radius", options.search_radius());
   }
   if (options.turn_penalty_factor() &&
-      customizable.find("turn_penalty_factor") != customizable.end()) {
+      customizable_.find("turn_penalty_factor") != customizable_.end()) {
     config.put<float>("turn_penalty_factor", options.turn_penalty_factor());
   }
-  if (options.gps_accuracy() && customizable.find("gps_accuracy") != customizable.end()) {
+  if (options.gps_accuracy() && customizable_.find("gps_accuracy") != customizable_.end()) {
     config.put<float>("gps_accuracy", options.gps_accuracy());
   }
-  if (options.breakage_distance() && customizable.find("breakage_distance") != customizable.end()) {
+  if (options.breakage_distance() &&
+      customizable_.find("breakage_distance") != customizable_.end()) {
     config.put<float>("breakage_distance", options.breakage_distance());
   }
 
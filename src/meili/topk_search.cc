@@ -24,20 +24,19 @@ float EnlargedEmissionCostModel::operator()(const StateId& stateid) {
 // 3. origin that is not been cloned (otherwise)
 float EnlargedEmissionCostModel::calculate_cost(const StateId& stateid,
                                                 const StateId& original_stateid) const {
-  const auto& model = evs_.original_emission_cost_model();
   if (original_stateid.IsValid()) {
     // remove the last clone
     if (stateid.time() == evs_.clone_end_time()) {
       return -1.0;
     } else {
-      return model(original_stateid);
+      return evs_.OriginalEmissionCost(original_stateid);
     }
   }
   // remove the first cloned origin
   if (stateid.time() == evs_.clone_start_time() && evs_.GetClone(stateid).IsValid()) {
     return -1.0;
   } else {
-    return model(stateid);
+    return evs_.OriginalEmissionCost(stateid);
   }
 }
 
@@ -51,25 +50,23 @@ float EnlargedTransitionCostModel::operator()(const StateId& lhs, const StateId&
 }
 
 float EnlargedTransitionCostModel::calculate_cost(const StateId& lhs, const StateId& rhs) const {
-  const auto& model = evs_.original_transition_cost_model();
-
   const auto& original_lhs = evs_.GetOrigin(lhs);
   const auto& original_rhs = evs_.GetOrigin(rhs);
   if (original_lhs.IsValid()) {
     if (original_rhs.IsValid()) {
-      return model(original_lhs, original_rhs);
+      return evs_.OriginalTransitionCost(original_lhs, original_rhs);
     } else {
       if (evs_.GetClone(rhs).IsValid()) {
         return -1.0;
       } else {
-        return model(original_lhs, rhs);
+        return evs_.OriginalTransitionCost(original_lhs, rhs);
       }
     }
   } else {
     if (original_rhs.IsValid()) {
       return -1.0;
     } else {
-      return model(lhs, rhs);
+      return evs_.OriginalTransitionCost(lhs, rhs);
     }
   }
 }
@@ -125,8 +122,13 @@ void TopKSearch::RemovePath(const std::vector<StateId>& path) {
     return StateId(time, it.first->second);
   };
 
-  // Create a new enlarged viterbi search
-  evss_.emplace_back(new EnlargedViterbiSearch(vs_, claim, initial_origins_, removed_origins_));
+  // Create a new enlarged viterbi search. Only the first one wraps the real
+  // cost models, so only it gets the session wide memos - later ones wrap
+  // earlier enlargements which bottom out in the first
+  auto* emission_memo = evss_.empty() ? &shared_emission_costs_ : nullptr;
+  auto* transition_memo = evss_.empty() ? &shared_transition_costs_ : nullptr;
+  evss_.emplace_back(new EnlargedViterbiSearch(vs_, claim, initial_origins_, removed_origins_,
+                                               emission_memo, transition_memo));
 
   // Have it clone the current path
   evss_.back()->ClonePath(path);
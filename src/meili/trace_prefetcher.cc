@@ -0,0 +1,125 @@
+#include "meili/trace_prefetcher.h"
+
+#include <algorithm>
+#include <chrono>
+
+#include "baldr/tilehierarchy.h"
+
+namespace {
+
+inline float local_tile_size() {
+  const auto& tiles = valhalla::baldr::TileHierarchy::levels().rbegin()->second.tiles;
+  return tiles.TileSize();
+}
+
+} // namespace
+
+namespace valhalla {
+namespace meili {
+
+TracePrefetcher::TracePrefetcher(const boost::property_tree::ptree& root)
+    : window_(root.get<uint32_t>("meili.lookahead_window", 0)),
+      local_level_(baldr::TileHierarchy::levels().rbegin()->second.level),
+      max_grid_cache_size_(root.get<float>("meili.grid.cache_size")),
+      reader_(root.get_child("mjolnir")),
+      grid_query_(reader_,
+                  local_tile_size() / root.get<size_t>("meili.grid.size"),
+                  local_tile_size() / root.get<size_t>("meili.grid.size")),
+      measurements_(nullptr), progress_(0), active_(false), abandon_(false), stop_(false) {
+  thread_ = std::thread(&TracePrefetcher::Work, this);
+}
+
+TracePrefetcher::~TracePrefetcher() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+    signal_.notify_all();
+  }
+  thread_.join();
+}
+
+void TracePrefetcher::Start(const std::vector<Measurement>& measurements) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  measurements_ = &measurements;
+  progress_.store(0, std::memory_order_relaxed);
+  abandon_ = false;
+  active_.store(true, std::memory_order_relaxed);
+  signal_.notify_all();
+}
+
+void TracePrefetcher::Advance() {
+  // nothing to pace when no trace is being walked
+  if (!active_.load(std::memory_order_relaxed)) {
+    return;
+  }
+  progress_.fetch_add(1, std::memory_order_relaxed);
+  signal_.notify_all();
+}
+
+void TracePrefetcher::Finish() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  abandon_ = true;
+  signal_.notify_all();
+  signal_.wait(lock, [this]() { return measurements_ == nullptr; });
+  abandon_ = false;
+  // dont let the lookahead reader or its grid handles hoard memory between
+  // traces; the grids themselves live on in the shared cache
+  if (reader_.OverCommitted()) {
+    reader_.Clear();
+  }
+  if (grid_query_.size() > max_grid_cache_size_) {
+    grid_query_.Clear();
+  }
+}
+
+void TracePrefetcher::Work() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (!stop_) {
+    signal_.wait(lock, [this]() { return stop_ || measurements_ != nullptr; });
+    if (stop_) {
+      break;
+    }
+    const auto* measurements = measurements_;
+    for (size_t i = 0; i < measurements->size() && !abandon_ && !stop_; ++i) {
+      // stay a window ahead of the matcher but no further; the advance
+      // notifications are sent without the lock so a short timeout backstops
+      // the ones that race a wait
+      while (!stop_ && !abandon_ &&
+             i >= progress_.load(std::memory_order_relaxed) + window_) {
+        signal_.wait_for(lock, std::chrono::milliseconds(2));
+      }
+      if (stop_ || abandon_) {
+        break;
+      }
+      lock.unlock();
+      try {
+        Warm((*measurements)[i]);
+      } catch (...) {
+        // the lookahead is advisory, a tile it cannot pull the matcher will
+        // pull (or fail on) itself
+      }
+      lock.lock();
+    }
+    // idle again, let a waiting Finish go
+    measurements_ = nullptr;
+    active_.store(false, std::memory_order_relaxed);
+    signal_.notify_all();
+  }
+}
+
+void TracePrefetcher::Warm(const Measurement& measurement) {
+  // the tile under the point - pulling it here is the io being hidden
+  auto tile_id = baldr::TileHierarchy::GetGraphId(measurement.lnglat(), local_level_);
+  if (tile_id.Is_Valid()) {
+    reader_.GetGraphTile(tile_id);
+  }
+  // build the candidate grids around the point; they publish to the process
+  // wide shared grid cache, which is where the matcher's own query will look
+  // first. Only that side effect matters so the filter keeps nothing
+  auto sq_radius = std::max(measurement.sq_search_radius(), measurement.sq_gps_accuracy());
+  grid_query_.Query(measurement.lnglat(), sq_radius,
+                    [](const baldr::DirectedEdge*) { return 0.f; });
+}
+
+} // namespace meili
+} // namespace valhalla
@@ -6,6 +6,17 @@ inline float GreatCircleDistance(const valhalla::meili::Measurement& left,
                                  const valhalla::meili::Measurement& right) {
   return left.lnglat().Distance(right.lnglat());
 }
+
+// combine hashes in the boost fashion
+inline uint64_t HashCombine(uint64_t seed, uint64_t value) {
+  return seed ^ (value + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2));
+}
+
+// how many buckets an edge offset is quantized into when keying the route memo
+constexpr float kOffsetBuckets = 128.f;
+
+// how many memoized routes to hold before starting over
+constexpr size_t kMaxRouteMemoSize = 100000;
 } // namespace
 
 namespace valhalla {
@@ -21,12 +32,13 @@ TransitionCostModel::TransitionCostModel(baldr::GraphReader& graphreader,
                                          float breakage_distance,
                                          float max_route_distance_factor,
                                          float max_route_time_factor,
-                                         float turn_penalty_factor)
+                                         float turn_penalty_factor,
+                                         bool cache_routes)
     : graphreader_(graphreader), vs_(vs), ts_(ts), container_(container), mode_costing_(mode_costing),
       travelmode_(travelmode), beta_(beta), inv_beta_(1.f / beta_),
       breakage_distance_(breakage_distance), max_route_distance_factor_(max_route_distance_factor),
-      max_route_time_factor_(max_route_time_factor),
-      turn_penalty_factor_(turn_penalty_factor), turn_cost_table_{0.f} {
+      max_route_time_factor_(max_route_time_factor), turn_penalty_factor_(turn_penalty_factor),
+      cache_routes_(cache_routes), turn_cost_table_{0.f} {
   if (beta_ <= 0.f) {
     throw std::invalid_argument("Expect beta to be positive");
   }
@@ -59,32 +71,169 @@ TransitionCostModel::TransitionCostModel(baldr::GraphReader& graphreader,
                           config.get<float>("breakage_distance"),
                           config.get<float>("max_route_distance_factor"),
                           config.get<float>("max_route_time_factor"),
-                          config.get<float>("turn_penalty_factor")) {
+                          config.get<float>("turn_penalty_factor"),
+                          config.get<bool>("route_distance_cache", false)) {
 }
 
 float TransitionCostModel::operator()(const StateId& lhs, const StateId& rhs) const {
   const auto& left = container_.state(lhs);
   const auto& right = container_.state(rhs);
 
+  // Get some basic info about difference between the two measurements
+  const auto& distances = MeasurementDistances(lhs.time(), rhs.time());
+  const auto measurement_distance = distances.first;
+  const auto clock_distance = distances.second;
+
+  // When memoizing, key the pair of candidates by their quantized edge
+  // offsets, folding in the predecessor's candidate since the turn cost
+  // depends on the direction the previous route arrived from
+  uint64_t memo_key = 0;
+  bool use_memo = cache_routes_ && !left.routed();
+  if (use_memo) {
+    const auto& prev_stateid = vs_.Predecessor(lhs);
+    if (prev_stateid.IsValid()) {
+      const auto& original_prev_stateid = ts_.GetOrigin(prev_stateid);
+      memo_key =
+          CandidateKey(original_prev_stateid.IsValid() ? original_prev_stateid : prev_stateid);
+    }
+    memo_key = HashCombine(memo_key, CandidateKey(lhs));
+    memo_key = HashCombine(memo_key, CandidateKey(rhs));
+
+    // Stationary or crawling vehicles hit the same pair over and over, so
+    // reuse what the network told us last time if the caps still allow it
+    const auto memo = route_memo_.find(memo_key);
+    if (memo != route_memo_.end()) {
+      const auto& m = memo->second;
+      const auto max_route_distance = MaxRouteDistance(lhs, rhs);
+      const auto max_route_time = MaxRouteTime(lhs, rhs);
+      if (m.found) {
+        // the remembered path is only reachable if it fits under this
+        // measurement pair's own caps
+        if (m.distance <= max_route_distance &&
+            (max_route_time < 0.f || m.secs <= max_route_time)) {
+          return CalculateTransitionCost(m.turn_cost, m.distance, measurement_distance, m.secs,
+                                         clock_distance);
+        }
+        return -1.f;
+      }
+      // nothing was found under at least as generous caps, so nothing will
+      // be found now either
+      if (max_route_distance <= m.max_route_distance &&
+          (m.max_route_time < 0.f ||
+           (0.f <= max_route_time && max_route_time <= m.max_route_time))) {
+        return -1.f;
+      }
+      // the caps grew, we have to route after all
+    }
+  }
+
   if (!left.routed()) {
     UpdateRoute(lhs, rhs);
   }
 
   // Compute the transition cost if we found a path
   const auto label = left.last_label(right);
+
+  // Remember what the routing found, including that it found nothing
+  if (use_memo) {
+    if (kMaxRouteMemoSize <= route_memo_.size()) {
+      route_memo_.clear();
+    }
+    if (label) {
+      route_memo_[memo_key] = {true,
+                               label->turn_cost(),
+                               label->cost().cost,
+                               static_cast<float>(label->cost().secs),
+                               MaxRouteDistance(lhs, rhs),
+                               MaxRouteTime(lhs, rhs)};
+    } else {
+      route_memo_[memo_key] = {false, 0.f, 0.f, 0.f, MaxRouteDistance(lhs, rhs),
+                               MaxRouteTime(lhs, rhs)};
+    }
+  }
+
   if (label) {
-    // Get some basic info about difference between the two measurements
-    const auto& left_measurement = container_.measurement(lhs.time());
-    const auto& right_measurement = container_.measurement(rhs.time());
-    return CalculateTransitionCost(label->turn_cost(), label->cost().cost,
-                                   GreatCircleDistance(left_measurement, right_measurement),
-                                   label->cost().secs, ClockDistance(lhs.time(), rhs.time()));
+    return CalculateTransitionCost(label->turn_cost(), label->cost().cost, measurement_distance,
+                                   label->cost().secs, clock_distance);
   }
 
   // No path found
   return -1.f;
 }
 
+void TransitionCostModel::EnsureRoute(const StateId& lhs, const StateId& rhs) const {
+  if (!container_.state(lhs).routed()) {
+    UpdateRoute(lhs, rhs);
+  }
+}
+
+float TransitionCostModel::MaxRouteDistance(const StateId& lhs, const StateId& rhs) const {
+  const auto measurement_distance = MeasurementDistances(lhs.time(), rhs.time()).first;
+  // make sure the max distance is greater than 0 otherwise we wont be able
+  // to get any labels into the labelset
+  return std::ceil(
+      std::max(std::min(measurement_distance * max_route_distance_factor_, breakage_distance_), 1.f));
+}
+
+float TransitionCostModel::MaxRouteTime(const StateId& lhs, const StateId& rhs) const {
+  auto max_route_time = MeasurementDistances(lhs.time(), rhs.time()).second * max_route_time_factor_;
+  if (0 <= max_route_time) {
+    max_route_time = std::ceil(max_route_time);
+  }
+  return max_route_time;
+}
+
+const std::pair<float, float>& TransitionCostModel::MeasurementDistances(const StateId::Time lhs,
+                                                                         const StateId::Time rhs) const {
+  // A single entry suffices: each expansion prices a whole column of
+  // candidates between the same pair of times. Leave times are set before
+  // any costs between the measurements they concern are evaluated, so the
+  // cached clock distance stays valid
+  if (lhs != cached_lhs_time_ || rhs != cached_rhs_time_) {
+    cached_lhs_time_ = lhs;
+    cached_rhs_time_ = rhs;
+    cached_distances_ = {GreatCircleDistance(container_.measurement(lhs),
+                                             container_.measurement(rhs)),
+                         ClockDistance(lhs, rhs)};
+  }
+  return cached_distances_;
+}
+
+uint64_t TransitionCostModel::CandidateKey(const StateId& stateid) const {
+  const auto& candidate = container_.state(stateid).candidate();
+  uint64_t key = 0;
+  for (const auto& edge : candidate.edges) {
+    key = HashCombine(key, edge.id.value);
+    key = HashCombine(key, static_cast<uint64_t>(edge.percent_along * (kOffsetBuckets - 1.f)));
+  }
+  return key;
+}
+
+float TransitionCostModel::LowerBound(const StateId& lhs, const StateId& rhs) const {
+  const auto& left = container_.state(lhs);
+  const auto& right = container_.state(rhs);
+
+  // the straight line distance between the closest pair of projected
+  // candidate points, no route between the candidates can be shorter
+  auto candidate_distance = std::numeric_limits<float>::infinity();
+  for (const auto& left_edge : left.candidate().edges) {
+    for (const auto& right_edge : right.candidate().edges) {
+      candidate_distance =
+          std::min(candidate_distance, left_edge.projected.Distance(right_edge.projected));
+    }
+  }
+
+  // the routing between the candidates is capped at the same distance
+  // UpdateRoute uses, if the straight line already exceeds it no route
+  // will be found so the transition is impossible
+  const auto measurement_distance = MeasurementDistances(lhs.time(), rhs.time()).first;
+  if (MaxRouteDistance(lhs, rhs) < candidate_distance) {
+    return -1.f;
+  }
+
+  return std::max(candidate_distance - measurement_distance, 0.f) * inv_beta_;
+}
+
 void TransitionCostModel::UpdateRoute(const StateId& lhs, const StateId& rhs) const {
   const auto& left = container_.state(lhs);
   const auto& right = container_.state(rhs);
@@ -123,23 +272,12 @@ void TransitionCostModel::UpdateRoute(const StateId& lhs, const StateId& rhs) co
     //}
   }
 
-  const auto& left_measurement = container_.measurement(lhs.time());
   const auto& right_measurement = container_.measurement(rhs.time());
 
   const midgard::DistanceApproximator approximator(right_measurement.lnglat());
 
-  auto max_route_distance =
-      std::min(GreatCircleDistance(left_measurement, right_measurement) * max_route_distance_factor_,
-               breakage_distance_);
-  // Route, we have to make sure that the max distance is greater
-  // than 0 otherwise we wont be able to get any labels into the
-  // labelset
-  max_route_distance = std::ceil(std::max(max_route_distance, 1.f));
-
-  auto max_route_time = ClockDistance(lhs.time(), rhs.time()) * max_route_time_factor_;
-  if (0 <= max_route_time) {
-    max_route_time = std::ceil(max_route_time);
-  }
+  const auto max_route_distance = MaxRouteDistance(lhs, rhs);
+  const auto max_route_time = MaxRouteTime(lhs, rhs);
 
   labelset_ptr_t labelset = std::make_shared<LabelSet>(max_route_distance);
   const auto& results = find_shortest_path(graphreader_, locations, 0, labelset, approximator,
@@ -99,6 +99,23 @@ inline StateId NaiveViterbiSearch<Maximize>::Predecessor(const StateId& stateid)
 template <bool Maximize>
 void NaiveViterbiSearch<Maximize>::UpdateLabels(std::vector<StateLabel>& labels,
                                                 const std::vector<StateLabel>& prev_labels) const {
+  // Price the column's emission costs once up front, they do not depend on
+  // the predecessor the outer loop iterates over
+  std::vector<float> emission_costs;
+  if (batch_emission_cost_model()) {
+    std::vector<StateId> column;
+    column.reserve(labels.size());
+    for (const auto& label : labels) {
+      column.push_back(label.stateid());
+    }
+    emission_costs = batch_emission_cost_model()(column);
+  } else {
+    emission_costs.reserve(labels.size());
+    for (const auto& label : labels) {
+      emission_costs.push_back(EmissionCost(label.stateid()));
+    }
+  }
+
   for (const auto& prev_label : prev_labels) {
     const auto& prev_stateid = prev_label.stateid();
 
@@ -107,10 +124,11 @@ void NaiveViterbiSearch<Maximize>::UpdateLabels(std::vector<StateLabel>& labels,
       continue;
     }
 
-    for (auto& label : labels) {
+    for (size_t i = 0; i < labels.size(); ++i) {
+      auto& label = labels[i];
       const auto stateid = label.stateid();
 
-      const auto emission_cost = EmissionCost(stateid);
+      const auto emission_cost = emission_costs[i];
       if (kInvalidCost == emission_cost) {
         continue;
       }
@@ -259,14 +277,39 @@ void ViterbiSearch::ClearSearch() {
   earliest_time_ = 0;
   queue_.clear();
   scanned_labels_.clear();
+  scanned_counts_.clear();
+  emission_costs_.clear();
   winner_.clear();
   unreached_states_ = states_;
 }
 
+float ViterbiSearch::CachedEmissionCost(const StateId& stateid) {
+  const auto it = emission_costs_.find(stateid);
+  if (it != emission_costs_.end()) {
+    return it->second;
+  }
+
+  // Price the state's whole column in one batched pass; it is still fully
+  // populated here since states are only settled after being priced
+  if (batch_emission_cost_model()) {
+    const auto& column = unreached_states_[stateid.time()];
+    const auto costs = batch_emission_cost_model()(column);
+    for (size_t i = 0; i < column.size(); ++i) {
+      emission_costs_.emplace(column[i], costs[i]);
+    }
+    const auto priced = emission_costs_.find(stateid);
+    if (priced != emission_costs_.end()) {
+      return priced->second;
+    }
+  }
+
+  return emission_costs_.emplace(stateid, EmissionCost(stateid)).first->second;
+}
+
 void ViterbiSearch::InitQueue(const std::vector<StateId>& column) {
   queue_.clear();
   for (const auto stateid : column) {
-    const auto emission_cost = EmissionCost(stateid);
+    const auto emission_cost = CachedEmissionCost(stateid);
     if (IsInvalidCost(emission_cost)) {
       continue;
     }
@@ -294,11 +337,26 @@ void ViterbiSearch::AddSuccessorsToQueue(const StateId& stateid) {
   // Optimal states have been removed from unreached_states_ so no
   // worry about optimality
   for (const auto& next_stateid : unreached_states_[stateid.time() + 1]) {
-    const auto emission_cost = EmissionCost(next_stateid);
+    const auto emission_cost = CachedEmissionCost(next_stateid);
     if (IsInvalidCost(emission_cost)) {
       continue;
     }
 
+    // A cheap admissible bound on the transition cost lets us skip the
+    // exact computation, which may route between the candidates: an
+    // invalid bound means no transition is possible at all, and when a
+    // queued label already beats the optimistic cost the exact cost
+    // cannot improve on it either
+    const auto lower_bound = TransitionCostLowerBound(stateid, next_stateid);
+    if (IsInvalidCost(lower_bound)) {
+      continue;
+    }
+    const auto* queued = queue_.find(next_stateid);
+    if (queued != nullptr &&
+        !(CostSofar(costsofar, lower_bound, emission_cost) < queued->costsofar())) {
+      continue;
+    }
+
     const auto transition_cost = TransitionCost(stateid, next_stateid);
     if (IsInvalidCost(transition_cost)) {
       continue;
@@ -358,6 +416,18 @@ StateId::Time ViterbiSearch::IterativeSearch(StateId::Time target, bool request_
       continue;
     }
 
+    // Remove it from its column
+    auto& column = unreached_states_[stateid.time()];
+    const auto it = std::find(column.begin(), column.end(), stateid);
+    if (it == column.end()) {
+      // With the beam enabled the column may have been dropped after this
+      // label was queued, in which case the state is dead
+      if (0 < beam_width_) {
+        continue;
+      }
+      throw std::logic_error("the state must exist in the column");
+    }
+
     // Mark it as scanned and remember its cost and predecessor
     const auto& inserted = scanned_labels_.emplace(stateid, label);
     if (!inserted.second) {
@@ -365,14 +435,18 @@ StateId::Time ViterbiSearch::IterativeSearch(StateId::Time target, bool request_
                              " probably negative costs occurred");
     }
 
-    // Remove it from its column
-    auto& column = unreached_states_[stateid.time()];
-    const auto it = std::find(column.begin(), column.end(), stateid);
-    if (it == column.end()) {
-      throw std::logic_error("the state must exist in the column");
-    }
     column.erase(it);
 
+    // Once this column has settled its best beam_width states by
+    // accumulated cost, the rest of the column cannot be part of a
+    // competitive path, so drop it
+    while (scanned_counts_.size() <= stateid.time()) {
+      scanned_counts_.push_back(0);
+    }
+    if (0 < beam_width_ && beam_width_ <= ++scanned_counts_[stateid.time()]) {
+      column.clear();
+    }
+
     // Since current column is empty now, earlier labels can't reach
     // future winners in a optimal way any more, so we mark time + 1
     // as the earliest time to skip all earlier labels
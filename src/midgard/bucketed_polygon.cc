@@ -0,0 +1,77 @@
+#include "midgard/bucketed_polygon.h"
+
+#include <algorithm>
+
+namespace {
+
+// One band per this many edges keeps the per test work roughly constant
+// regardless of ring size, without letting tiny rings pay for empty bands
+constexpr size_t kEdgesPerBand = 4;
+constexpr size_t kMaxBands = 4096;
+
+} // namespace
+
+namespace valhalla {
+namespace midgard {
+
+BucketedPolygon::BucketedPolygon(const std::vector<PointLL>& ring) : bbox_(ring) {
+  size_t band_count = std::min(std::max<size_t>(ring.size() / kEdgesPerBand, 1), kMaxBands);
+  bands_.resize(band_count);
+  float height = bbox_.maxy() - bbox_.miny();
+  inv_band_height_ = height > 0.f ? band_count / height : 0.f;
+  auto band_of = [&](float y) {
+    auto band = static_cast<int32_t>((y - bbox_.miny()) * inv_band_height_);
+    return std::min(std::max(band, 0), static_cast<int32_t>(band_count) - 1);
+  };
+
+  // each edge lands in every band its latitude range overlaps. the ring may
+  // be open or closed - a closing duplicate edge is degenerate and skipped
+  for (size_t i = 0; i < ring.size(); ++i) {
+    const auto& a = ring[i];
+    const auto& b = ring[(i + 1) % ring.size()];
+    if (a == b) {
+      continue;
+    }
+    for (auto band = band_of(std::min(a.second, b.second)),
+              last = band_of(std::max(a.second, b.second));
+         band <= last; ++band) {
+      bands_[band].x1.push_back(a.first);
+      bands_[band].y1.push_back(a.second);
+      bands_[band].x2.push_back(b.first);
+      bands_[band].y2.push_back(b.second);
+    }
+  }
+}
+
+bool BucketedPolygon::Contains(const PointLL& ll) const {
+  if (!bbox_.Contains(ll)) {
+    return false;
+  }
+  auto band = static_cast<int32_t>((ll.second - bbox_.miny()) * inv_band_height_);
+  const auto& edges =
+      bands_[std::min(std::max(band, 0), static_cast<int32_t>(bands_.size()) - 1)];
+
+  // count crossings of the ray from the point toward +x. the comparisons
+  // are written branch free over the band's edge arrays so the loop
+  // vectorizes; an edge whose crossing with the ray sits exactly on the
+  // point contributes either way
+  const float x = ll.first;
+  const float y = ll.second;
+  const float* x1 = edges.x1.data();
+  const float* y1 = edges.y1.data();
+  const float* x2 = edges.x2.data();
+  const float* y2 = edges.y2.data();
+  uint32_t crossings = 0;
+  for (size_t i = 0; i < edges.x1.size(); ++i) {
+    // the edge spans the ray's latitude and the crossing is right of the
+    // point; the cross product form avoids the division for the crossing's
+    // longitude, with the sign flip when the edge heads south
+    const bool spans = (y1[i] <= y) != (y2[i] <= y);
+    const float turned = (x - x1[i]) * (y2[i] - y1[i]) - (y - y1[i]) * (x2[i] - x1[i]);
+    crossings += spans & ((turned < 0.f) == (y2[i] > y1[i]));
+  }
+  return (crossings & 1) != 0;
+}
+
+} // namespace midgard
+} // namespace valhalla
@@ -10,6 +10,22 @@
 #include <cmath>
 #include <sstream>
 
+namespace {
+// index of the lowest set bit, the masks are never zero when this is called
+inline int lowest_bit(uint64_t mask) {
+#if defined(__GNUC__) || defined(__clang__)
+  return __builtin_ctzll(mask);
+#else
+  int i = 0;
+  while ((mask & 1) == 0) {
+    mask >>= 1;
+    ++i;
+  }
+  return i;
+#endif
+}
+} // namespace
+
 namespace valhalla {
 namespace midgard {
 
@@ -19,9 +35,18 @@ GriddedData<coord_t>::GriddedData(const AABB2<coord_t>& bounds,
                                   const float tilesize,
                                   const float value)
     : Tiles<coord_t>(bounds, tilesize), max_value_(value) {
-  // Resize the data vector and fill with the value
-  data_.resize(this->nrows_ * this->ncolumns_);
-  std::fill(data_.begin(), data_.end(), value);
+  // Size the block directory but allocate no cell blocks - a block appears the
+  // first time one of its cells is written to
+  nblockcols_ = (this->ncolumns_ + kGridBlockDim - 1) / kGridBlockDim;
+  int32_t nblockrows = (this->nrows_ + kGridBlockDim - 1) / kGridBlockDim;
+  blocks_.resize(nblockrows * nblockcols_);
+  block_min_.resize(nblockrows * nblockcols_, value);
+
+  // Start with an empty dirty region - nothing has been written yet
+  dirty_min_row_ = this->nrows_;
+  dirty_max_row_ = -1;
+  dirty_min_col_ = this->ncolumns_;
+  dirty_max_col_ = -1;
 }
 
 // Generate contour lines from the isotile data.
@@ -64,205 +89,269 @@ GriddedData<coord_t>::GenerateContours(const std::vector<float>& contour_interva
                              {{0, 3, 4}, {1, 3, 1}, {4, 3, 0}},
                              {{9, 6, 7}, {5, 2, 0}, {8, 0, 0}}};
 
-  // For each cell, skipping the outer rim since its out of bounds
-  for (int row = 1; row < this->nrows_ - 1; ++row) {
-    for (int col = 1; col < this->ncolumns_ - 1; ++col) {
-      int tileid = this->TileId(col, row);
-      auto cell1 = data_[tileid];
-      auto cell2 = data_[tileid + this->ncolumns_];     // TileId(col,   row+1)];
-      auto cell3 = data_[tileid + 1];                   // TileId(col+1, row)];
-      auto cell4 = data_[tileid + this->ncolumns_ + 1]; // TileId(col+1, row+1)];
-      auto dmin = std::min(std::min(cell1, cell2), std::min(cell3, cell4));
-      auto dmax = std::max(std::max(cell1, cell2), std::max(cell3, cell4));
-
-      // Continue if outside the range of contour values
-      if (dmax < contour_intervals.front() || dmin > contour_intervals.back()) {
-        continue;
-      }
+  // For each cell, skipping the outer rim since its out of bounds. Only the
+  // region that was actually written to can hold contours - everything else
+  // still has the initial value - so scan the dirty bounds padded by one
+  // cell (a cell reads its neighbors above and to the right).
+  int min_row = std::max(1, dirty_min_row_ - 1);
+  int max_row = std::min(this->nrows_ - 1, dirty_max_row_ + 2);
+  int min_col = std::max(1, dirty_min_col_ - 1);
+  int max_col = std::min(this->ncolumns_ - 1, dirty_max_col_ + 2);
+  // a block the expansion never reached (or whose smallest value is beyond
+  // the largest interval) cannot hold a contour
+  auto block_boring = [&](const int32_t block_id) {
+    return blocks_[block_id].empty() || block_min_[block_id] > contour_intervals.back();
+  };
+  // a stand in row of values for blocks that were never written to, so the
+  // classification loop below reads through a pointer either way
+  const std::vector<float> untouched(kGridBlockDim, max_value_);
+  // where a cell row starts within its block
+  auto row_values = [&](int row, int col) -> const float* {
+    int tileid = this->TileId(col, row);
+    const auto& block = blocks_[BlockId(tileid)];
+    return block.empty() ? untouched.data() : &block[BlockOffset(tileid)];
+  };
+  const float lowest_interval = contour_intervals.front();
+  const float highest_interval = contour_intervals.back();
+  for (int row = min_row; row < max_row; ++row) {
+    for (int col = min_col; col < max_col;) {
+      // the rest of this block row, which is as far as one mask can reach
+      int span = std::min(max_col - col, kGridBlockDim - col % kGridBlockDim);
 
-      for (auto contour : contour_intervals) {
-        if (contour < dmin || contour > dmax) {
-          continue;
+      // classify the whole span up front into a bitmask of the cells whose
+      // corner values straddle some interval - the segment tracing below then
+      // touches only those. When both of the rows the cells read sit in
+      // boring blocks nothing but the last cell can cross
+      uint64_t mask = 0;
+      if (!(block_boring(BlockId(this->TileId(col, row))) &&
+            block_boring(BlockId(this->TileId(col, row + 1)))) &&
+          span > 1) {
+        // within the span the two rows of values are contiguous, so this is a
+        // tight branch free loop the compiler turns into whole registers of
+        // cell comparisons at a time
+        const float* top = row_values(row, col);
+        const float* bottom = row_values(row + 1, col);
+        for (int i = 0; i < span - 1; ++i) {
+          float dmin = std::min(std::min(top[i], top[i + 1]), std::min(bottom[i], bottom[i + 1]));
+          float dmax = std::max(std::max(top[i], top[i + 1]), std::max(bottom[i], bottom[i + 1]));
+          mask |= static_cast<uint64_t>(dmax >= lowest_interval && dmin <= highest_interval) << i;
         }
-        for (int m = 4; m >= 0; m--) {
-          if (m > 0) {
-            int newtileid = tileid + tile_inc[m - 1];
-            // Make sure the tile corner value is not set to the max_value
-            // (messes up the intersect method). Set a value slightly above
-            // the contour (e.g. 1 minute higher).
-            // TODO - the value 1 is a bit of a hack.
-            s[m] = (data_[newtileid] < max_value_) ? data_[newtileid] - contour : 1.0f;
-            tile_corners[m] = this->Base(newtileid);
-          } else {
-            s[0] = 0.25 * (s[1] + s[2] + s[3] + s[4]);
-            tile_corners[0] = this->Center(tileid);
-          }
-          if (s[m] > 0.0f) {
-            sh[m] = 1;
-          } else if (s[m] < 0.0f) {
-            sh[m] = -1;
-          } else {
-            sh[m] = 0;
-          }
-        }
-
-        /*
-         Note: at this stage the relative heights of the corners and the
-         centre are in the h array, and the corresponding coordinates are
-         in the xh and yh arrays. The centre of the box is indexed by 0
-         and the 4 corners by 1 to 4 as shown below.
-         Each triangle is then indexed by the parameter m, and the 3
-         vertices of each triangle are indexed by parameters m1,m2,and m3.
-         It is assumed that the centre of the box is always vertex 2
-         though this is important only when all 3 vertices lie exactly on
-         the same contour level, in which case only the side of the box
-         is drawn.
-            vertex 4 +-------------------+ vertex 3
-                     | \               / |
-                     |   \    m-3    /   |
-                     |     \       /     |
-                     |       \   /       |
-                     |  m=2    X   m=2   |       the centre is vertex 0
-                     |       /   \       |
-                     |     /       \     |
-                     |   /    m=1    \   |
-                     | /               \ |
-            vertex 1 +-------------------+ vertex 2
-        */
-
-        // Scan each triangle in the box
-        coord_t pt1, pt2;
-        for (int m = 1; m <= 4; m++) {
-          int m1 = m;
-          int m2 = 0;
-          int m3 = (m != 4) ? m + 1 : 1;
-          if ((case_value = case_table[sh[m1] + 1][sh[m2] + 1][sh[m3] + 1]) == 0) {
-            continue;
-          }
-
-          switch (case_value) {
-            case 1: // Line between vertices 1 and 2
-              pt1 = tile_corners[m1];
-              pt2 = tile_corners[m2];
-              break;
-            case 2: // Line between vertices 2 and 3
-              pt1 = tile_corners[m2];
-              pt2 = tile_corners[m3];
-              break;
-            case 3: // Line between vertices 3 and 1
-              pt1 = tile_corners[m3];
-              pt2 = tile_corners[m1];
-              break;
-            case 4: // Line between vertex 1 and side 2-3
-              pt1 = tile_corners[m1];
-              pt2 = intersect(m2, m3);
-              break;
-            case 5: // Line between vertex 2 and side 3-1
-              pt1 = tile_corners[m2];
-              pt2 = intersect(m3, m1);
-              break;
-            case 6: // Line between vertex 3 and side 1-2
-              pt1 = tile_corners[m3];
-              pt2 = intersect(m1, m2);
-              break;
-            case 7: // Line between sides 1-2 and 2-3
-              pt1 = intersect(m1, m2);
-              pt2 = intersect(m2, m3);
-              break;
-            case 8: // Line between sides 2-3 and 3-1
-              pt1 = intersect(m2, m3);
-              pt2 = intersect(m3, m1);
-              break;
-            case 9: // Line between sides 3-1 and 1-2
-              pt1 = intersect(m3, m1);
-              pt2 = intersect(m1, m2);
-              break;
-            default:
-              break;
-          }
+      }
+      // the last cell of the span peeks into the next block over
+      {
+        int tileid = this->TileId(col + span - 1, row);
+        auto dmin = std::min(std::min(Get(tileid), Get(tileid + this->ncolumns_)),
+                             std::min(Get(tileid + 1), Get(tileid + this->ncolumns_ + 1)));
+        auto dmax = std::max(std::max(Get(tileid), Get(tileid + this->ncolumns_)),
+                             std::max(Get(tileid + 1), Get(tileid + this->ncolumns_ + 1)));
+        mask |= static_cast<uint64_t>(dmax >= lowest_interval && dmin <= highest_interval)
+                << (span - 1);
+      }
+      int span_start = col;
+      col += span;
 
-          // this isnt a segment..
-          if (pt1 == pt2) {
-            continue;
-          }
+      // trace segments through each crossing cell
+      for (; mask != 0; mask &= mask - 1) {
+        int tileid = this->TileId(span_start + lowest_bit(mask), row);
+        auto cell1 = Get(tileid);
+        auto cell2 = Get(tileid + this->ncolumns_);     // TileId(col,   row+1)];
+        auto cell3 = Get(tileid + 1);                   // TileId(col+1, row)];
+        auto cell4 = Get(tileid + this->ncolumns_ + 1); // TileId(col+1, row+1)];
+        auto dmin = std::min(std::min(cell1, cell2), std::min(cell3, cell4));
+        auto dmax = std::max(std::max(cell1, cell2), std::max(cell3, cell4));
 
-          // see if we have anything to connect this segment to
-          typename contour_lookup_t::iterator rec_a = lookup[contour].find(pt1);
-          typename contour_lookup_t::iterator rec_b = lookup[contour].find(pt2);
-          if (rec_b != lookup[contour].end()) {
-            std::swap(pt1, pt2);
-            std::swap(rec_a, rec_b);
+        // only the span of intervals this cell's values straddle can make
+        // segments here - find it once instead of testing every interval
+        auto interval =
+            std::lower_bound(contour_intervals.cbegin(), contour_intervals.cend(), dmin);
+        for (; interval != contour_intervals.cend() && *interval <= dmax; ++interval) {
+          auto contour = *interval;
+          // the bucket of segments being assembled for this interval and the
+          // endpoint index into it, so each segment below costs no further
+          // float keyed lookups
+          auto& segments = contours[contour].front();
+          auto& contour_lookup = lookup[contour];
+          for (int m = 4; m >= 0; m--) {
+            if (m > 0) {
+              int newtileid = tileid + tile_inc[m - 1];
+              // Make sure the tile corner value is not set to the max_value
+              // (messes up the intersect method). Set a value slightly above
+              // the contour (e.g. 1 minute higher).
+              // TODO - the value 1 is a bit of a hack.
+              auto cell = Get(newtileid);
+              s[m] = (cell < max_value_) ? cell - contour : 1.0f;
+              tile_corners[m] = this->Base(newtileid);
+            } else {
+              s[0] = 0.25 * (s[1] + s[2] + s[3] + s[4]);
+              tile_corners[0] = this->Center(tileid);
+            }
+            if (s[m] > 0.0f) {
+              sh[m] = 1;
+            } else if (s[m] < 0.0f) {
+              sh[m] = -1;
+            } else {
+              sh[m] = 0;
+            }
           }
 
-          // we want to merge two records
-          if (rec_b != lookup[contour].end()) {
-            // get the segments in question and remove their lookup info
-            auto segment_a = rec_a->second;
-            bool head_a = rec_a->first == segment_a->front();
-            auto segment_b = rec_b->second;
-            bool head_b = rec_b->first == segment_b->front();
-            lookup[contour].erase(rec_a);
-            lookup[contour].erase(rec_b);
+          /*
+           Note: at this stage the relative heights of the corners and the
+           centre are in the h array, and the corresponding coordinates are
+           in the xh and yh arrays. The centre of the box is indexed by 0
+           and the 4 corners by 1 to 4 as shown below.
+           Each triangle is then indexed by the parameter m, and the 3
+           vertices of each triangle are indexed by parameters m1,m2,and m3.
+           It is assumed that the centre of the box is always vertex 2
+           though this is important only when all 3 vertices lie exactly on
+           the same contour level, in which case only the side of the box
+           is drawn.
+              vertex 4 +-------------------+ vertex 3
+                       | \               / |
+                       |   \    m-3    /   |
+                       |     \       /     |
+                       |       \   /       |
+                       |  m=2    X   m=2   |       the centre is vertex 0
+                       |       /   \       |
+                       |     /       \     |
+                       |   /    m=1    \   |
+                       | /               \ |
+              vertex 1 +-------------------+ vertex 2
+          */
 
-            // this segment is now a ring
-            if (segment_a == segment_b) {
-              segment_a->push_back(segment_a->front());
+          // Scan each triangle in the box
+          coord_t pt1, pt2;
+          for (int m = 1; m <= 4; m++) {
+            int m1 = m;
+            int m2 = 0;
+            int m3 = (m != 4) ? m + 1 : 1;
+            if ((case_value = case_table[sh[m1] + 1][sh[m2] + 1][sh[m3] + 1]) == 0) {
               continue;
             }
 
-            // erase the other lookups
-            lookup[contour].erase(lookup[contour].find(
-                pt1 == segment_a->front() ? segment_a->back() : segment_a->front()));
-            lookup[contour].erase(lookup[contour].find(
-                pt2 == segment_b->front() ? segment_b->back() : segment_b->front()));
+            switch (case_value) {
+              case 1: // Line between vertices 1 and 2
+                pt1 = tile_corners[m1];
+                pt2 = tile_corners[m2];
+                break;
+              case 2: // Line between vertices 2 and 3
+                pt1 = tile_corners[m2];
+                pt2 = tile_corners[m3];
+                break;
+              case 3: // Line between vertices 3 and 1
+                pt1 = tile_corners[m3];
+                pt2 = tile_corners[m1];
+                break;
+              case 4: // Line between vertex 1 and side 2-3
+                pt1 = tile_corners[m1];
+                pt2 = intersect(m2, m3);
+                break;
+              case 5: // Line between vertex 2 and side 3-1
+                pt1 = tile_corners[m2];
+                pt2 = intersect(m3, m1);
+                break;
+              case 6: // Line between vertex 3 and side 1-2
+                pt1 = tile_corners[m3];
+                pt2 = intersect(m1, m2);
+                break;
+              case 7: // Line between sides 1-2 and 2-3
+                pt1 = intersect(m1, m2);
+                pt2 = intersect(m2, m3);
+                break;
+              case 8: // Line between sides 2-3 and 3-1
+                pt1 = intersect(m2, m3);
+                pt2 = intersect(m3, m1);
+                break;
+              case 9: // Line between sides 3-1 and 1-2
+                pt1 = intersect(m3, m1);
+                pt2 = intersect(m1, m2);
+                break;
+              default:
+                break;
+            }
 
-            // add b to a
-            if (!head_a && head_b) {
-              segment_a->splice(segment_a->end(), *segment_b);
-              contours[contour].front().erase(segment_b);
-            } // add a to b
-            else if (!head_b && head_a) {
-              segment_b->splice(segment_b->end(), *segment_a);
-              contours[contour].front().erase(segment_a);
-              segment_a = segment_b;
-            } // flip a and add b
-            else if (head_a && head_b) {
-              segment_a->reverse();
-              segment_a->splice(segment_a->end(), *segment_b);
-              contours[contour].front().erase(segment_b);
-            } // flip b and add to a
-            else if (!head_a && !head_b) {
-              segment_b->reverse();
-              segment_a->splice(segment_a->end(), *segment_b);
-              contours[contour].front().erase(segment_b);
+            // this isnt a segment..
+            if (pt1 == pt2) {
+              continue;
             }
 
-            // update the look up
-            lookup[contour].emplace(segment_a->front(), segment_a);
-            lookup[contour].emplace(segment_a->back(), segment_a);
-          } // ap/prepend to an existing one
-          else if (rec_a != lookup[contour].end()) {
-            // it goes on the front
-            if (rec_a->second->front() == pt1) {
-              rec_a->second->push_front(pt2);
-              // it goes on the back
-            } else {
-              rec_a->second->push_back(pt2);
+            // see if we have anything to connect this segment to
+            typename contour_lookup_t::iterator rec_a = contour_lookup.find(pt1);
+            typename contour_lookup_t::iterator rec_b = contour_lookup.find(pt2);
+            if (rec_b != contour_lookup.end()) {
+              std::swap(pt1, pt2);
+              std::swap(rec_a, rec_b);
             }
 
-            // update the lookup table
-            lookup[contour].emplace(pt2, rec_a->second);
-            lookup[contour].erase(rec_a);
-          } // this is an orphan segment for now
-          else {
-            contours[contour].front().push_front(contour_t{pt1, pt2});
-            lookup[contour].emplace(pt1, contours[contour].front().begin());
-            lookup[contour].emplace(pt2, contours[contour].front().begin());
+            // we want to merge two records
+            if (rec_b != contour_lookup.end()) {
+              // get the segments in question and remove their lookup info
+              auto segment_a = rec_a->second;
+              bool head_a = rec_a->first == segment_a->front();
+              auto segment_b = rec_b->second;
+              bool head_b = rec_b->first == segment_b->front();
+              contour_lookup.erase(rec_a);
+              contour_lookup.erase(rec_b);
+
+              // this segment is now a ring
+              if (segment_a == segment_b) {
+                segment_a->push_back(segment_a->front());
+                continue;
+              }
+
+              // erase the other lookups
+              contour_lookup.erase(contour_lookup.find(
+                  pt1 == segment_a->front() ? segment_a->back() : segment_a->front()));
+              contour_lookup.erase(contour_lookup.find(
+                  pt2 == segment_b->front() ? segment_b->back() : segment_b->front()));
+
+              // add b to a
+              if (!head_a && head_b) {
+                segment_a->splice(segment_a->end(), *segment_b);
+                segments.erase(segment_b);
+              } // add a to b
+              else if (!head_b && head_a) {
+                segment_b->splice(segment_b->end(), *segment_a);
+                segments.erase(segment_a);
+                segment_a = segment_b;
+              } // flip a and add b
+              else if (head_a && head_b) {
+                segment_a->reverse();
+                segment_a->splice(segment_a->end(), *segment_b);
+                segments.erase(segment_b);
+              } // flip b and add to a
+              else if (!head_a && !head_b) {
+                segment_b->reverse();
+                segment_a->splice(segment_a->end(), *segment_b);
+                segments.erase(segment_b);
+              }
+
+              // update the look up
+              contour_lookup.emplace(segment_a->front(), segment_a);
+              contour_lookup.emplace(segment_a->back(), segment_a);
+            } // ap/prepend to an existing one
+            else if (rec_a != contour_lookup.end()) {
+              // it goes on the front
+              if (rec_a->second->front() == pt1) {
+                rec_a->second->push_front(pt2);
+                // it goes on the back
+              } else {
+                rec_a->second->push_back(pt2);
+              }
+
+              // update the lookup table
+              contour_lookup.emplace(pt2, rec_a->second);
+              contour_lookup.erase(rec_a);
+            } // this is an orphan segment for now
+            else {
+              segments.push_front(contour_t{pt1, pt2});
+              contour_lookup.emplace(pt1, segments.begin());
+              contour_lookup.emplace(pt2, segments.begin());
+            }
           }
-        }
-      } // Each contour
-    }   // Each tile col
-  }     // Each tile row
+        } // Each contour
+      }   // Each crossing cell
+    }     // Each tile col
+  }       // Each tile row
 
   // If the generalization value equals kOptimalGeneralization then set
   // the generalization factor to 1/4 of the grid size
@@ -270,6 +359,10 @@ GriddedData<coord_t>::GenerateContours(const std::vector<float>& contour_interva
   if (generalize == kOptimalGeneralization) {
     gen_factor = this->tilesize_ * 0.25f * kMetersPerDegreeLat;
   }
+  // The tolerance is specified in meters but Generalize compares it against
+  // distances in coordinate space, so scale it. This is approximate (degrees
+  // of longitude shrink away from the equator) but so is the tolerance
+  float gen_epsilon = gen_factor / kMetersPerDegreeLat;
 
   // some info about the area the image covers
   auto c = this->TileBounds().Center();
@@ -298,7 +391,7 @@ GriddedData<coord_t>::GenerateContours(const std::vector<float>& contour_interva
     for (auto& line : contour) {
       // TODO: generalizing makes self intersections which makes other libraries unhappy
       if (gen_factor > 0.f) {
-        Polyline2<coord_t>::Generalize(line, gen_factor);
+        Polyline2<coord_t>::Generalize(line, gen_epsilon);
       }
       // if this ends up as an inner we'll undo this later
       if (cache[&line] > 0) {
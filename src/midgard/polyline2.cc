@@ -1,4 +1,5 @@
 #include "valhalla/midgard/polyline2.h"
+#include "valhalla/midgard/util.h"
 
 #include <functional>
 #include <list>
@@ -139,7 +140,12 @@ Polyline2<coord_t> Polyline2<coord_t>::ClippedPolyline(const AABB2<coord_t>& box
 template class Polyline2<Point2>;
 template class Polyline2<PointLL>;
 
-template float Polyline2<PointLL>::Length(const std::vector<PointLL>&);
+// lat,lng vectors take the one pass length that reuses per vertex trig
+template <>
+template <>
+float Polyline2<PointLL>::Length<std::vector<PointLL>>(const std::vector<PointLL>& pts) {
+  return length(pts);
+}
 template float Polyline2<Point2>::Length(const std::vector<Point2>&);
 template float Polyline2<PointLL>::Length(const std::list<PointLL>&);
 template float Polyline2<Point2>::Length(const std::list<Point2>&);
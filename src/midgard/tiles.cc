@@ -161,9 +161,12 @@ Tiles<coord_t>::Tiles(const AABB2<coord_t>& bounds,
     : tilebounds_(bounds), tilesize_(tilesize), nsubdivisions_(subdivisions), wrapx_(wrapx) {
   tilebounds_ = bounds;
   tilesize_ = tilesize;
+  tilesize_inv_ = 1.0f / tilesize_;
   subdivision_size_ = tilesize_ / nsubdivisions_;
   ncolumns_ = static_cast<int32_t>(std::ceil((bounds.maxx() - bounds.minx()) / tilesize_));
   nrows_ = static_cast<int32_t>(std::ceil((bounds.maxy() - bounds.miny()) / tilesize_));
+  subpixels_per_x_ = (ncolumns_ * nsubdivisions_) / tilebounds_.Width();
+  subpixels_per_y_ = (nrows_ * nsubdivisions_) / tilebounds_.Height();
 }
 
 // Get the list of tiles that lie within the specified bounding box.
@@ -312,11 +315,12 @@ Tiles<coord_t>::Intersect(const container_t& linestring) const {
     }
     ui = vi;
 
-    // figure out global subdivision start and end points
-    auto x0 = (u.first - tilebounds_.minx()) / tilebounds_.Width() * ncolumns_ * nsubdivisions_;
-    auto y0 = (u.second - tilebounds_.miny()) / tilebounds_.Height() * nrows_ * nsubdivisions_;
-    auto x1 = (v.first - tilebounds_.minx()) / tilebounds_.Width() * ncolumns_ * nsubdivisions_;
-    auto y1 = (v.second - tilebounds_.miny()) / tilebounds_.Height() * nrows_ * nsubdivisions_;
+    // figure out global subdivision start and end points with the
+    // precomputed pixels per unit scales
+    auto x0 = (u.first - tilebounds_.minx()) * subpixels_per_x_;
+    auto y0 = (u.second - tilebounds_.miny()) * subpixels_per_y_;
+    auto x1 = (v.first - tilebounds_.minx()) * subpixels_per_x_;
+    auto y1 = (v.second - tilebounds_.miny()) * subpixels_per_y_;
 
     int ix0 = std::floor(x0), ix1 = std::floor(x1);
     int iy0 = std::floor(y0), iy1 = std::floor(y1);
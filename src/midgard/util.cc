@@ -53,6 +53,39 @@ Vector2 operator*(float s, const Vector2& v) {
   return Vector2(v.x() * s, v.y() * s);
 }
 
+// One pass polyline length over a decoded shape. Each vertex's sin/cos is
+// computed once and shared by the segments on either side of it, which sums
+// the exact same per segment values as PointLL::Distance (same math, clamps
+// and rounding) at nearly half the trig calls.
+float length(const std::vector<PointLL>& pts) {
+  if (pts.size() < 2) {
+    return 0.0f;
+  }
+  float length = 0.0f;
+  double sin0 = sin(pts[0].lat() * RAD_PER_DEG);
+  double cos0 = cos(pts[0].lat() * RAD_PER_DEG);
+  for (size_t i = 1; i < pts.size(); ++i) {
+    double sin1 = sin(pts[i].lat() * RAD_PER_DEG);
+    double cos1 = cos(pts[i].lat() * RAD_PER_DEG);
+    // coincident points contribute nothing, otherwise the law of cosines.
+    // the longitude delta is taken in float first to match Distance exactly
+    if (!(pts[i] == pts[i - 1])) {
+      double deltalng = (pts[i].lng() - pts[i - 1].lng()) * RAD_PER_DEG;
+      double cosb = sin0 * sin1 + cos0 * cos1 * cos(deltalng);
+      if (cosb >= 1.0) {
+        length += 0.00001f;
+      } else if (cosb <= -1.0) {
+        length += kPi * kRadEarthMeters;
+      } else {
+        length += (float)(acos(cosb) * kRadEarthMeters);
+      }
+    }
+    sin0 = sin1;
+    cos0 = cos1;
+  }
+  return length;
+}
+
 // Trim the front of a polyline (represented as a list or vector of Point2).
 // Returns the trimmed portion of the polyline. The supplied polyline is
 // altered (the trimmed part is removed).
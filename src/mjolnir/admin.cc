@@ -1,11 +1,27 @@
 #include "mjolnir/admin.h"
 #include "baldr/datetime.h"
 #include "midgard/logging.h"
+#include <algorithm>
 #include <boost/filesystem/operations.hpp>
 #include <spatialite.h>
 #include <sqlite3.h>
 #include <unordered_map>
 
+namespace {
+
+// Convert a boost geometry ring to the point vector the bucketed test takes
+std::vector<valhalla::midgard::PointLL>
+to_ring(const valhalla::mjolnir::polygon_type::ring_type& ring) {
+  std::vector<valhalla::midgard::PointLL> points;
+  points.reserve(ring.size());
+  for (const auto& point : ring) {
+    points.emplace_back(point.x(), point.y());
+  }
+  return points;
+}
+
+} // namespace
+
 namespace valhalla {
 namespace mjolnir {
 
@@ -45,6 +61,44 @@ sqlite3* GetDBHandle(const std::string& database) {
   return db_handle;
 }
 
+// Build the r-tree over the bounding boxes of the polys and the bucketed
+// rings the containment tests run against. The packing constructor is used
+// since the set of polys never changes after the load
+MultiPolyIndex::MultiPolyIndex(const std::unordered_multimap<uint32_t, multi_polygon_type>& polys) {
+  std::vector<rtree_value_type> values;
+  for (const auto& poly : polys) {
+    // each polygon of the multi polygon indexes separately so a lookup only
+    // tests the one whose box covers the point
+    for (const auto& polygon : poly.second) {
+      indexed_poly_t indexed{poly.first, midgard::BucketedPolygon(to_ring(polygon.outer())), {}};
+      indexed.inners.reserve(polygon.inners().size());
+      for (const auto& inner : polygon.inners()) {
+        indexed.inners.emplace_back(to_ring(inner));
+      }
+      values.emplace_back(boost::geometry::return_envelope<box_type>(polygon), polys_.size());
+      polys_.push_back(std::move(indexed));
+    }
+  }
+  rtree_ = boost::geometry::index::rtree<rtree_value_type, boost::geometry::index::quadratic<16>>(
+      values.begin(), values.end());
+}
+
+// Get the polygon index of the poly covering the point. The r-tree narrows
+// the candidates to the polys whose boxes cover the point before running
+// the banded crossing test over the prebuilt rings
+uint32_t MultiPolyIndex::GetMultiPolyId(const midgard::PointLL& ll) const {
+  point_type p(ll.lng(), ll.lat());
+  for (auto it = rtree_.qbegin(boost::geometry::index::intersects(p)); it != rtree_.qend(); ++it) {
+    const auto& indexed = polys_[it->second];
+    if (indexed.outer.Contains(ll) &&
+        std::none_of(indexed.inners.begin(), indexed.inners.end(),
+                     [&ll](const midgard::BucketedPolygon& hole) { return hole.Contains(ll); })) {
+      return indexed.id;
+    }
+  }
+  return 0;
+}
+
 // Get the polygon index.  Used by tz and admin areas.  Checks if the pointLL is covered_by the
 // poly.
 uint32_t GetMultiPolyId(const std::unordered_multimap<uint32_t, multi_polygon_type>& polys,
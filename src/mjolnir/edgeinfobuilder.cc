@@ -63,6 +63,7 @@ void EdgeInfoBuilder::AddNameInfo(const baldr::NameInfo& info) {
 // Set the shape of the edge. Encode the vector of lat,lng to a string.
 template <class shape_container_t> void EdgeInfoBuilder::set_shape(const shape_container_t& shape) {
   encoded_shape_ = midgard::encode7<shape_container_t>(shape);
+  shape_index_built_ = false;
 }
 template void EdgeInfoBuilder::set_shape<std::vector<PointLL>>(const std::vector<PointLL>&);
 template void EdgeInfoBuilder::set_shape<std::list<PointLL>>(const std::list<PointLL>&);
@@ -70,6 +71,72 @@ template void EdgeInfoBuilder::set_shape<std::list<PointLL>>(const std::list<Poi
 // Set the encoded shape string.
 void EdgeInfoBuilder::set_encoded_shape(const std::string& encoded_shape) {
   std::copy(encoded_shape.begin(), encoded_shape.end(), back_inserter(encoded_shape_));
+  shape_index_built_ = false;
+}
+
+// Request that a vertex checkpoint index be written after the shape.
+void EdgeInfoBuilder::set_index_shape(const bool index) {
+  index_shape_ = index;
+  shape_index_built_ = false;
+}
+
+// Does this edge info actually write any index bytes?
+bool EdgeInfoBuilder::index_shape() const {
+  return !shape_index().empty();
+}
+
+// Build the packed checkpoint index from the encoded shape. Walks the varint
+// stream tracking where each vertex's encoding begins and records one
+// checkpoint every kShapeIndexSampleRate vertices.
+const std::string& EdgeInfoBuilder::shape_index() const {
+  if (shape_index_built_) {
+    return shape_index_;
+  }
+  shape_index_built_ = true;
+  shape_index_.clear();
+
+  // shapes that get truncated at write time cannot be indexed reliably
+  if (!index_shape_ || encoded_shape_.size() > kMaxEncodedShapeSize) {
+    return shape_index_;
+  }
+
+  // walk the stream a vertex (a lat and a lon varint) at a time, the same
+  // way Shape7Decoder does
+  std::string records;
+  uint16_t count = 0;
+  int32_t lat = 0, lon = 0;
+  uint32_t vertex = 0;
+  size_t pos = 0;
+  auto next = [&](const int32_t previous) -> int32_t {
+    int32_t byte, shift = 0, result = 0;
+    do {
+      byte = static_cast<int32_t>(encoded_shape_[pos++]);
+      result |= (byte & 0x7f) << shift;
+      shift += 7;
+    } while (byte & 0x80);
+    return previous + ((result & 1 ? ~result : result) >> 1);
+  };
+  while (pos < encoded_shape_.size()) {
+    // a checkpoint records where this vertex's encoding begins and the
+    // coordinate accumulated through the one before it
+    if (vertex > 0 && vertex % kShapeIndexSampleRate == 0) {
+      const uint16_t offset = static_cast<uint16_t>(pos);
+      records.append(reinterpret_cast<const char*>(&offset), sizeof(offset));
+      records.append(reinterpret_cast<const char*>(&lat), sizeof(lat));
+      records.append(reinterpret_cast<const char*>(&lon), sizeof(lon));
+      ++count;
+    }
+    lat = next(lat);
+    lon = next(lon);
+    ++vertex;
+  }
+
+  // short shapes have no checkpoints and so no index at all
+  if (count > 0) {
+    shape_index_.append(reinterpret_cast<const char*>(&count), sizeof(count));
+    shape_index_.append(records);
+  }
+  return shape_index_;
 }
 
 // Get the size of the edge info (including name offsets and shape string)
@@ -78,6 +145,7 @@ std::size_t EdgeInfoBuilder::BaseSizeOf() const {
   size += sizeof(baldr::EdgeInfo::PackedItem);
   size += (name_info_list_.size() * sizeof(NameInfo));
   size += (encoded_shape_.size() * sizeof(std::string::value_type));
+  size += shape_index().size();
   return size;
 }
 
@@ -95,8 +163,10 @@ std::size_t EdgeInfoBuilder::SizeOf() const {
 
 // Output edge info to output stream
 std::ostream& operator<<(std::ostream& os, const EdgeInfoBuilder& eib) {
-  // Pack the name count and encoded shape size. Check against limits.
-  baldr::EdgeInfo::PackedItem item;
+  // Pack the name count and encoded shape size. Check against limits. Zero
+  // initialized so the spare bits are clean and readers can trust the shape
+  // index flag
+  baldr::EdgeInfo::PackedItem item{};
   uint32_t name_count = eib.name_info_list_.size();
   if (name_count > kMaxNamesPerEdge) {
     LOG_WARN("Exceeding max names per edge: " + std::to_string(name_count));
@@ -112,12 +182,17 @@ std::ostream& operator<<(std::ostream& os, const EdgeInfoBuilder& eib) {
     item.encoded_shape_size = static_cast<uint32_t>(eib.encoded_shape_.size());
   }
 
+  // The vertex checkpoint index follows the shape when there is one
+  const auto& shape_index = eib.shape_index();
+  item.has_shape_index = !shape_index.empty();
+
   // Write out the bytes
   os.write(reinterpret_cast<const char*>(&eib.w0_.value_), sizeof(uint64_t));
   os.write(reinterpret_cast<const char*>(&item), sizeof(baldr::EdgeInfo::PackedItem));
   os.write(reinterpret_cast<const char*>(eib.name_info_list_.data()),
            (name_count * sizeof(NameInfo)));
   os << eib.encoded_shape_;
+  os << shape_index;
 
   // Pad to an 8 byte boundary
   std::size_t n = (eib.BaseSizeOf() % 8);
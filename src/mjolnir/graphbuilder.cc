@@ -348,11 +348,18 @@ uint32_t CreateSimpleTurnRestriction(const uint32_t wayid,
 }
 
 // Add an access restriction. Returns the mode(s) that have access
-// restrictions on this edge.
+// restrictions on this edge. While the restrictions are in hand they are
+// also resolved against the default truck envelope: default_truck_ok comes
+// back true only when every truck restriction is a static dimensional limit
+// the envelope passes, so costing with default attributes can skip the
+// restriction walk on this edge. Timed restrictions need runtime evaluation
+// and clear the flag.
 uint32_t AddAccessRestrictions(const uint32_t edgeid,
                                const uint32_t wayid,
                                const OSMData& osmdata,
-                               GraphTileBuilder& graphtile) {
+                               GraphTileBuilder& graphtile,
+                               bool& default_truck_ok) {
+  default_truck_ok = true;
   auto res = osmdata.access_restrictions.equal_range(wayid);
   if (res.first == osmdata.access_restrictions.end()) {
     return 0;
@@ -364,6 +371,41 @@ uint32_t AddAccessRestrictions(const uint32_t edgeid,
                                          r->second.value());
     graphtile.AddAccessRestriction(access_restriction);
     modes |= r->second.modes();
+
+    // the comparisons mirror the ones truck costing makes at runtime
+    if (r->second.modes() & kTruckAccess) {
+      auto value = r->second.value();
+      switch (r->second.type()) {
+        case AccessType::kHazmat:
+          // the default envelope carries no hazardous materials
+          default_truck_ok = default_truck_ok && value == 0;
+          break;
+        case AccessType::kMaxAxleLoad:
+          default_truck_ok =
+              default_truck_ok && !(kDefaultTruckAxleLoad > static_cast<float>(value * 0.01));
+          break;
+        case AccessType::kMaxHeight:
+          default_truck_ok =
+              default_truck_ok && !(kDefaultTruckHeight > static_cast<float>(value * 0.01));
+          break;
+        case AccessType::kMaxLength:
+          default_truck_ok =
+              default_truck_ok && !(kDefaultTruckLength > static_cast<float>(value * 0.01));
+          break;
+        case AccessType::kMaxWeight:
+          default_truck_ok =
+              default_truck_ok && !(kDefaultTruckWeight > static_cast<float>(value * 0.01));
+          break;
+        case AccessType::kMaxWidth:
+          default_truck_ok =
+              default_truck_ok && !(kDefaultTruckWidth > static_cast<float>(value * 0.01));
+          break;
+        default:
+          // timed or unknown restrictions cannot be resolved at build time
+          default_truck_ok = false;
+          break;
+      }
+    }
   }
   return modes;
 }
@@ -383,12 +425,14 @@ void BuildTileSet(const std::string& ways_file,
                   const boost::property_tree::ptree& pt,
                   std::promise<DataQuality>& result) {
 
-  sequence<OSMWay> ways(ways_file, false);
-  sequence<OSMWayNode> way_nodes(way_nodes_file, false);
-  sequence<Edge> edges(edges_file, false);
-  sequence<Node> nodes(nodes_file, false);
-  sequence<OSMRestriction> complex_restrictions_from(complex_restriction_from_file, false);
-  sequence<OSMRestriction> complex_restrictions_to(complex_restriction_to_file, false);
+  // the tile build only consumes the intermediate data, so map it readonly
+  // and every build thread pages the same cached copy in on demand
+  sequence<OSMWay> ways(ways_file, false, true);
+  sequence<OSMWayNode> way_nodes(way_nodes_file, false, true);
+  sequence<Edge> edges(edges_file, false, true);
+  sequence<Node> nodes(nodes_file, false, true);
+  sequence<OSMRestriction> complex_restrictions_from(complex_restriction_from_file, false, true);
+  sequence<OSMRestriction> complex_restrictions_to(complex_restriction_to_file, false, true);
 
   auto database = pt.get_optional<std::string>("admin");
   // Initialize the admin DB (if it exists)
@@ -476,6 +520,11 @@ void BuildTileSet(const std::string& ways_file,
         }
       }
 
+      // Spatial indexes over the admin and tz polys so the per node lookups
+      // only test the polys whose bounding boxes cover the node
+      MultiPolyIndex admin_poly_index(admin_polys);
+      MultiPolyIndex tz_poly_index(tz_polys);
+
       // Iterate through the nodes
       uint32_t idx = 0; // Current directed edge index
 
@@ -504,7 +553,7 @@ void BuildTileSet(const std::string& ways_file,
 
         // Get the admin index
         uint32_t admin_index = (tile_within_one_admin) ? admin_polys.begin()->first
-                                                       : GetMultiPolyId(admin_polys, node_ll);
+                                                       : admin_poly_index.GetMultiPolyId(node_ll);
 
         // Look for potential duplicates
         // CheckForDuplicates(nodeid, node, edgelengths, nodes, edges, osmdata.ways, stats);
@@ -848,9 +897,12 @@ void BuildTileSet(const std::string& ways_file,
           // Add restrictions..For now only storing access restrictions for trucks
           // TODO - support more than one mode
           if (directededge.forwardaccess()) {
-            uint32_t ar_modes = AddAccessRestrictions(idx, w.way_id(), osmdata, graphtile);
+            bool default_truck_ok = true;
+            uint32_t ar_modes =
+                AddAccessRestrictions(idx, w.way_id(), osmdata, graphtile, default_truck_ok);
             if (ar_modes) {
               directededge.set_access_restriction(ar_modes);
+              directededge.set_default_truck_ok(default_truck_ok);
             }
           }
 
@@ -986,7 +1038,7 @@ void BuildTileSet(const std::string& ways_file,
 
         // Set the time zone index
         uint32_t tz_index =
-            (tile_within_one_tz) ? tz_polys.begin()->first : GetMultiPolyId(tz_polys, node_ll);
+            (tile_within_one_tz) ? tz_polys.begin()->first : tz_poly_index.GetMultiPolyId(node_ll);
 
         graphtile.nodes().back().set_timezone(tz_index);
 
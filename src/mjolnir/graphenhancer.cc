@@ -4,6 +4,7 @@
 #include "mjolnir/graphtilebuilder.h"
 #include "mjolnir/util.h"
 
+#include <algorithm>
 #include <cinttypes>
 #include <future>
 #include <limits>
@@ -16,6 +17,7 @@
 #include <thread>
 #include <unordered_map>
 #include <unordered_set>
+#include <utility>
 #include <vector>
 
 #include <boost/filesystem/operations.hpp>
@@ -978,7 +980,7 @@ bool ConsistentNames(const std::string& country_code,
 
 // We make sure to lock on reading and writing because we dont want to race
 // since difference threads, use for the tilequeue as well
-void enhance(const boost::property_tree::ptree& pt,
+void enhance(const std::unordered_map<std::string, std::vector<int>>& country_access,
              const std::string& access_file,
              const boost::property_tree::ptree& hierarchy_properties,
              std::queue<GraphId>& tilequeue,
@@ -986,19 +988,9 @@ void enhance(const boost::property_tree::ptree& pt,
              std::promise<enhancer_stats>& result) {
 
   auto less_than = [](const OSMAccess& a, const OSMAccess& b) { return a.way_id() < b.way_id(); };
-  sequence<OSMAccess> access_tags(access_file, false);
-
-  auto database = pt.get_optional<std::string>("admin");
-  // Initialize the admin DB (if it exists)
-  sqlite3* admin_db_handle = database ? GetDBHandle(*database) : nullptr;
-  if (!database) {
-    LOG_WARN("Admin db not found.  Not saving admin information.");
-  } else if (!admin_db_handle) {
-    LOG_WARN("Admin db " + *database + " not found.  Not saving admin information.");
-  }
-
-  std::unordered_map<std::string, std::vector<int>> country_access =
-      GetCountryAccess(admin_db_handle);
+  // only searched, never written - map it readonly so the enhancer threads
+  // share the page cache and skip the write buffering
+  sequence<OSMAccess> access_tags(access_file, false, true);
 
   // Local Graphreader
   GraphReader reader(hierarchy_properties);
@@ -1166,6 +1158,27 @@ void enhance(const boost::property_tree::ptree& pt,
           end_node_code = endnodetile->admin(end_admin_index)->country_iso();
         }
 
+        // Mark a state/province crossing when the admin records at the end
+        // nodes differ, so runtime admin logic becomes a flag test. Within
+        // the tile differing indexes mean differing records; across tiles
+        // the records themselves are compared
+        bool admin_changed;
+        if (endnodetile == nullptr) {
+          admin_changed = admin_index != end_admin_index;
+        } else {
+          const Admin* start_admin = tile->admin(admin_index);
+          const Admin* end_admin = endnodetile->admin(end_admin_index);
+          admin_changed = start_admin->country_iso() != end_admin->country_iso() ||
+                          start_admin->state_iso() != end_admin->state_iso() ||
+                          tile->GetName(start_admin->country_offset()) !=
+                              endnodetile->GetName(end_admin->country_offset()) ||
+                          tile->GetName(start_admin->state_offset()) !=
+                              endnodetile->GetName(end_admin->state_offset());
+        }
+        if (admin_changed) {
+          directededge.set_st_crossing(true);
+        }
+
         // only process country access logic if the iso country codes match.
         if (country_code == end_node_code) {
 
@@ -1345,6 +1358,10 @@ void enhance(const boost::property_tree::ptree& pt,
     }
     tilebuilder.AddAccessRestrictions(access_restrictions);
 
+    // Every edge's admin crossing flags were computed above, so readers of
+    // this tile can trust them
+    tilebuilder.header_builder().set_has_admin_crossings(true);
+
     // Write the new file
     lock.lock();
     tilebuilder.StoreTileData();
@@ -1357,10 +1374,6 @@ void enhance(const boost::property_tree::ptree& pt,
     lock.unlock();
   }
 
-  if (admin_db_handle) {
-    sqlite3_close(admin_db_handle);
-  }
-
   // Send back the statistics
   result.set_value(stats);
 }
@@ -1382,16 +1395,50 @@ void GraphEnhancer::Enhance(const boost::property_tree::ptree& pt, const std::st
   // A place to hold the results of those threads, exceptions or otherwise
   std::list<std::promise<enhancer_stats>> results;
 
-  // Create a randomized queue of tiles to work from
-  std::deque<GraphId> tempqueue;
+  // Open the admin db and load the country access rules once. Every thread
+  // reads the same table so there is no reason for each to open its own
+  // connection and run the same query again
   boost::property_tree::ptree hierarchy_properties = pt.get_child("mjolnir");
+  auto database = hierarchy_properties.get_optional<std::string>("admin");
+  sqlite3* admin_db_handle = database ? GetDBHandle(*database) : nullptr;
+  if (!database) {
+    LOG_WARN("Admin db not found.  Not saving admin information.");
+  } else if (!admin_db_handle) {
+    LOG_WARN("Admin db " + *database + " not found.  Not saving admin information.");
+  }
+  std::unordered_map<std::string, std::vector<int>> country_access =
+      GetCountryAccess(admin_db_handle);
+  if (admin_db_handle) {
+    sqlite3_close(admin_db_handle);
+  }
+
+  // Create a queue of tiles to work from, largest tile first. The threads
+  // share the queue so ordering by size keeps a dense tile from being picked
+  // up last and running alone at the end while the other threads sit idle
+  std::deque<GraphId> tempqueue;
   auto local_level = TileHierarchy::levels().rbegin()->second.level;
   GraphReader reader(hierarchy_properties);
   auto local_tiles = reader.GetTileSet(local_level);
+  // in a distributed build only this host's shard of the tiles is enhanced
+  tile_shard_t shard(hierarchy_properties);
+  std::vector<std::pair<uint32_t, GraphId>> tile_order;
+  tile_order.reserve(local_tiles.size());
   for (const auto& tile_id : local_tiles) {
-    tempqueue.emplace_back(tile_id);
+    if (!shard.contains(tile_id)) {
+      continue;
+    }
+    tile_order.emplace_back(reader.GetGraphTile(tile_id)->header()->directededgecount(), tile_id);
+    if (reader.OverCommitted()) {
+      reader.Clear();
+    }
+  }
+  std::sort(tile_order.begin(), tile_order.end(),
+            [](const std::pair<uint32_t, GraphId>& a, const std::pair<uint32_t, GraphId>& b) {
+              return a.first > b.first;
+            });
+  for (const auto& ordered : tile_order) {
+    tempqueue.emplace_back(ordered.second);
   }
-  std::random_shuffle(tempqueue.begin(), tempqueue.end());
   std::queue<GraphId> tilequeue(tempqueue);
 
   // An atomic object we can use to do the synchronization
@@ -1400,8 +1447,8 @@ void GraphEnhancer::Enhance(const boost::property_tree::ptree& pt, const std::st
   // Start the threads
   for (auto& thread : threads) {
     results.emplace_back();
-    thread.reset(new std::thread(enhance, std::cref(hierarchy_properties), std::cref(access_file),
-                                 std::ref(hierarchy_properties), std::ref(tilequeue), std::ref(lock),
+    thread.reset(new std::thread(enhance, std::cref(country_access), std::cref(access_file),
+                                 std::cref(hierarchy_properties), std::ref(tilequeue), std::ref(lock),
                                  std::ref(results.back())));
   }
 
@@ -12,11 +12,45 @@
 #include <set>
 #include <stdexcept>
 
+#include <cstring>
+
 using namespace valhalla::baldr;
 
 namespace valhalla {
 namespace mjolnir {
 
+namespace {
+
+// serialize the directed edge SoA mirror for the given edges: parallel
+// arrays of end node graphids, lengths, packed attribute words and speeds,
+// with the section padded out to an 8 byte boundary
+std::vector<char> SerializeEdgeSoA(const DirectedEdge* edges, const size_t count) {
+  const size_t lengths_start = count * sizeof(uint64_t);
+  const size_t attributes_start = lengths_start + count * sizeof(uint32_t);
+  const size_t speeds_start = attributes_start + count * sizeof(uint32_t);
+  std::vector<char> bytes(((speeds_start + count * sizeof(uint8_t)) + 7) / 8 * 8, 0);
+  auto* endnodes = reinterpret_cast<uint64_t*>(bytes.data());
+  auto* lengths = reinterpret_cast<uint32_t*>(bytes.data() + lengths_start);
+  auto* attributes = reinterpret_cast<uint32_t*>(bytes.data() + attributes_start);
+  auto* speeds = reinterpret_cast<uint8_t*>(bytes.data() + speeds_start);
+  for (size_t i = 0; i < count; i++) {
+    endnodes[i] = edges[i].endnode().value;
+    lengths[i] = edges[i].length();
+    attributes[i] = EdgeSoA::pack_attributes(edges[i]);
+    speeds[i] = edges[i].speed();
+  }
+  return bytes;
+}
+
+} // namespace
+
+// The global default for writing the SoA mirror into newly stored tiles
+bool GraphTileBuilder::default_include_edge_soa_ = false;
+
+void GraphTileBuilder::set_include_edge_soa(const bool include) {
+  default_include_edge_soa_ = include;
+}
+
 // Constructor given an existing tile. This is used to read in the tile
 // data and then add to it (e.g. adding node connections between hierarchy
 // levels. If the deserialize flag is set then all objects are serialized
@@ -33,6 +67,9 @@ GraphTileBuilder::GraphTileBuilder(const std::string& tile_dir,
   }
   header_builder_.set_graphid(graphid);
 
+  // Keep the SoA mirror through rebuilds of tiles that already carry it
+  include_edge_soa_ = default_include_edge_soa_ || (header_ && header_->has_edge_soa());
+
   // Done if not deserializing and creating builders for everything
   if (!deserialize) {
     textlistbuilder_.emplace_back("");
@@ -137,8 +174,10 @@ GraphTileBuilder::GraphTileBuilder(const std::string& tile_dir,
                " current ei offset= " + std::to_string(edge_info_offset_));
     }
 
-    EdgeInfo ei(edgeinfo_ + offset, textlist_, textlist_size_);
+    EdgeInfo ei(edgeinfo_ + offset, textlist_, textlist_size_, header_->has_shape_indexes());
     EdgeInfoBuilder eib;
+    // keep the shape index (or its absence) so sizes and offsets round trip
+    eib.set_index_shape(ei.has_shape_index());
     eib.set_wayid(ei.wayid());
     eib.set_mean_elevation(ei.mean_elevation());
     for (uint32_t nm = 0; nm < ei.name_count(); nm++) {
@@ -189,23 +228,27 @@ void GraphTileBuilder::StoreTileData() {
   }
 
   // Open file and truncate
-  std::stringstream in_mem;
   std::ofstream file(filename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
   if (file.is_open()) {
+    // Write the current header as a placeholder. The sections stream straight
+    // to the file behind it rather than being assembled in memory first, and
+    // once the offsets are all known the header is written again in place
+    file.write(reinterpret_cast<const char*>(&header_builder_), sizeof(GraphTileHeader));
+
     // Write the nodes
     header_builder_.set_nodecount(nodes_builder_.size());
-    in_mem.write(reinterpret_cast<const char*>(nodes_builder_.data()),
-                 nodes_builder_.size() * sizeof(NodeInfo));
+    file.write(reinterpret_cast<const char*>(nodes_builder_.data()),
+               nodes_builder_.size() * sizeof(NodeInfo));
 
     // Write the node transitions
     header_builder_.set_transitioncount(transitions_builder_.size());
-    in_mem.write(reinterpret_cast<const char*>(transitions_builder_.data()),
-                 transitions_builder_.size() * sizeof(NodeTransition));
+    file.write(reinterpret_cast<const char*>(transitions_builder_.data()),
+               transitions_builder_.size() * sizeof(NodeTransition));
 
     // Write the directed edges
     header_builder_.set_directededgecount(directededges_builder_.size());
-    in_mem.write(reinterpret_cast<const char*>(directededges_builder_.data()),
-                 directededges_builder_.size() * sizeof(DirectedEdge));
+    file.write(reinterpret_cast<const char*>(directededges_builder_.data()),
+               directededges_builder_.size() * sizeof(DirectedEdge));
 
     // Write extended directed edge attributes if they exist.
     if (directededges_ext_builder_.size() > 0) {
@@ -213,7 +256,7 @@ void GraphTileBuilder::StoreTileData() {
         LOG_ERROR("DirectedEdge extended attributes not same size as directed edges");
       } else {
         header_builder_.set_has_ext_directededge(true);
-        in_mem.write(reinterpret_cast<const char*>(directededges_ext_builder_.data()),
+        file.write(reinterpret_cast<const char*>(directededges_ext_builder_.data()),
                      directededges_ext_builder_.size() * sizeof(DirectedEdgeExt));
       }
     }
@@ -221,47 +264,47 @@ void GraphTileBuilder::StoreTileData() {
     // Sort and write the access restrictions
     header_builder_.set_access_restriction_count(access_restriction_builder_.size());
     std::sort(access_restriction_builder_.begin(), access_restriction_builder_.end());
-    in_mem.write(reinterpret_cast<const char*>(access_restriction_builder_.data()),
-                 access_restriction_builder_.size() * sizeof(AccessRestriction));
+    file.write(reinterpret_cast<const char*>(access_restriction_builder_.data()),
+               access_restriction_builder_.size() * sizeof(AccessRestriction));
 
     // Sort and write the transit departures
     header_builder_.set_departurecount(departure_builder_.size());
     std::sort(departure_builder_.begin(), departure_builder_.end());
-    in_mem.write(reinterpret_cast<const char*>(departure_builder_.data()),
-                 departure_builder_.size() * sizeof(TransitDeparture));
+    file.write(reinterpret_cast<const char*>(departure_builder_.data()),
+               departure_builder_.size() * sizeof(TransitDeparture));
 
     // Sort write the transit stops
     header_builder_.set_stopcount(stop_builder_.size());
-    in_mem.write(reinterpret_cast<const char*>(stop_builder_.data()),
-                 stop_builder_.size() * sizeof(TransitStop));
+    file.write(reinterpret_cast<const char*>(stop_builder_.data()),
+               stop_builder_.size() * sizeof(TransitStop));
 
     // Write the transit routes
     header_builder_.set_routecount(route_builder_.size());
-    in_mem.write(reinterpret_cast<const char*>(route_builder_.data()),
-                 route_builder_.size() * sizeof(TransitRoute));
+    file.write(reinterpret_cast<const char*>(route_builder_.data()),
+               route_builder_.size() * sizeof(TransitRoute));
 
     // Write transit schedules
     header_builder_.set_schedulecount(schedule_builder_.size());
-    in_mem.write(reinterpret_cast<const char*>(schedule_builder_.data()),
-                 schedule_builder_.size() * sizeof(TransitSchedule));
+    file.write(reinterpret_cast<const char*>(schedule_builder_.data()),
+               schedule_builder_.size() * sizeof(TransitSchedule));
 
     // TODO add transfers later
     header_builder_.set_transfercount(0);
 
     // Write the signs
     header_builder_.set_signcount(signs_builder_.size());
-    in_mem.write(reinterpret_cast<const char*>(signs_builder_.data()),
-                 signs_builder_.size() * sizeof(Sign));
+    file.write(reinterpret_cast<const char*>(signs_builder_.data()),
+               signs_builder_.size() * sizeof(Sign));
 
     // Write turn lanes
     header_builder_.set_turnlane_count(turnlanes_builder_.size());
-    in_mem.write(reinterpret_cast<const char*>(turnlanes_builder_.data()),
-                 turnlanes_builder_.size() * sizeof(TurnLanes));
+    file.write(reinterpret_cast<const char*>(turnlanes_builder_.data()),
+               turnlanes_builder_.size() * sizeof(TurnLanes));
 
     // Write the admins
     header_builder_.set_admincount(admins_builder_.size());
-    in_mem.write(reinterpret_cast<const char*>(admins_builder_.data()),
-                 admins_builder_.size() * sizeof(Admin));
+    file.write(reinterpret_cast<const char*>(admins_builder_.data()),
+               admins_builder_.size() * sizeof(Admin));
 
     // Edge bins can only be added after you've stored the tile
 
@@ -281,7 +324,7 @@ void GraphTileBuilder::StoreTileData() {
         (admins_builder_.size() * sizeof(Admin)));
     uint32_t forward_restriction_size = 0;
     for (auto& complex_restriction : complex_restriction_forward_builder_) {
-      in_mem << complex_restriction;
+      file << complex_restriction;
       forward_restriction_size += complex_restriction.SizeOf();
     }
 
@@ -290,47 +333,66 @@ void GraphTileBuilder::StoreTileData() {
         header_builder_.complex_restriction_forward_offset() + forward_restriction_size);
     uint32_t reverse_restriction_size = 0;
     for (auto& complex_restriction : complex_restriction_reverse_builder_) {
-      in_mem << complex_restriction;
+      file << complex_restriction;
       reverse_restriction_size += complex_restriction.SizeOf();
     }
 
-    // Write the edge data
+    // Write the edge data. Everything written here has clean spare packed
+    // bits so the per edge shape index flags can be trusted
+    header_builder_.set_has_shape_indexes(true);
     header_builder_.set_edgeinfo_offset(header_builder_.complex_restriction_reverse_offset() +
                                         reverse_restriction_size);
     for (const auto& edgeinfo : edgeinfo_list_) {
-      in_mem << edgeinfo;
+      file << edgeinfo;
     }
 
     // Write the names
     header_builder_.set_textlist_offset(header_builder_.edgeinfo_offset() + edge_info_offset_);
     for (const auto& text : textlistbuilder_) {
-      in_mem << text << '\0';
+      file << text << '\0';
     }
 
     // Add padding (if needed) to align to 8-byte word.
-    int tmp = in_mem.tellp() % 8;
+    int tmp = (file.tellp() - static_cast<std::streamoff>(sizeof(GraphTileHeader))) % 8;
     int padding = (tmp > 0) ? 8 - tmp : 0;
     if (padding > 0 && padding < 8) {
-      in_mem.write("\0\0\0\0\0\0\0\0", padding);
+      file.write("\0\0\0\0\0\0\0\0", padding);
     }
 
     // Write lane connections
     header_builder_.set_lane_connectivity_offset(header_builder_.textlist_offset() +
                                                  text_list_offset_ + padding);
     std::sort(lane_connectivity_builder_.begin(), lane_connectivity_builder_.end());
-    in_mem.write(reinterpret_cast<const char*>(lane_connectivity_builder_.data()),
-                 lane_connectivity_builder_.size() * sizeof(LaneConnectivity));
-
-    // Set the end offset
-    header_builder_.set_end_offset(header_builder_.lane_connectivity_offset() +
-                                   (lane_connectivity_builder_.size() * sizeof(LaneConnectivity)));
+    file.write(reinterpret_cast<const char*>(lane_connectivity_builder_.data()),
+               lane_connectivity_builder_.size() * sizeof(LaneConnectivity));
+
+    uint32_t after_lanes = header_builder_.lane_connectivity_offset() +
+                           (lane_connectivity_builder_.size() * sizeof(LaneConnectivity));
+
+    // Write the directed edge SoA mirror when requested, padded so the 8
+    // byte end node ids that lead the section are aligned. Otherwise mark
+    // the section absent the way legacy tiles do (slot == end offset)
+    if (include_edge_soa_ && !directededges_builder_.empty()) {
+      int soa_padding = (after_lanes % 8) ? 8 - (after_lanes % 8) : 0;
+      if (soa_padding > 0) {
+        file.write("\0\0\0\0\0\0\0\0", soa_padding);
+      }
+      header_builder_.set_edge_soa_offset(after_lanes + soa_padding);
+      const auto soa =
+          SerializeEdgeSoA(directededges_builder_.data(), directededges_builder_.size());
+      file.write(soa.data(), soa.size());
+      header_builder_.set_end_offset(header_builder_.edge_soa_offset() + soa.size());
+    } else {
+      // Set the end offset
+      header_builder_.set_end_offset(after_lanes);
+      header_builder_.set_edge_soa_offset(after_lanes);
+    }
 
     // Sanity check for the end offset
-    uint32_t curr =
-        static_cast<uint32_t>(in_mem.tellp()) + static_cast<uint32_t>(sizeof(GraphTileHeader));
+    uint32_t curr = static_cast<uint32_t>(file.tellp());
     if (header_builder_.end_offset() != curr) {
       LOG_ERROR("Mismatch in end offset " + std::to_string(header_builder_.end_offset()) +
-                " vs in_mem stream " + std::to_string(curr) +
+                " vs file stream " + std::to_string(curr) +
                 " padding = " + std::to_string(padding));
     }
 
@@ -345,9 +407,9 @@ void GraphTileBuilder::StoreTileData() {
                route_builder_.size())
                   .str());
 
-    // Write the header then the rest of the tile from the in memory buffer
+    // Backpatch the header now that the offsets and counts are known
+    file.seekp(0, std::ios_base::beg);
     file.write(reinterpret_cast<const char*>(&header_builder_), sizeof(GraphTileHeader));
-    file << in_mem.rdbuf();
     file.close();
   } else {
     throw std::runtime_error("Failed to open file " + filename.string());
@@ -393,16 +455,84 @@ void GraphTileBuilder::Update(const std::vector<NodeInfo>& nodes,
     // If there are extended directed edge attributes they would need to be written out here
     // (and likely added to the method)
 
-    // Write the rest of the tiles
+    // Write the rest of the tiles. When the tile carries the directed edge
+    // SoA mirror regenerate it from the updated edges so it does not go
+    // stale, preserving anything appended after it
     auto begin = reinterpret_cast<const char*>(&access_restrictions_[0]);
     auto end = reinterpret_cast<const char*>(header()) + header()->end_offset();
-    file.write(begin, end - begin);
+    if (header_->has_edge_soa()) {
+      auto soa_begin = reinterpret_cast<const char*>(header()) + header_->edge_soa_offset();
+      file.write(begin, soa_begin - begin);
+      const auto soa = SerializeEdgeSoA(directededges.data(), directededges.size());
+      file.write(soa.data(), soa.size());
+      file.write(soa_begin + soa.size(), end - (soa_begin + soa.size()));
+    } else {
+      file.write(begin, end - begin);
+    }
     file.close();
   } else {
     throw std::runtime_error("GraphTileBuilder::Update - Failed to open file " + filename.string());
   }
 }
 
+// Patch directed edges in place within the stored tile file. Only the given
+// records and the header (with a bumped update generation) are rewritten.
+void GraphTileBuilder::PatchDirectedEdges(
+    const std::vector<std::pair<uint32_t, DirectedEdge>>& edges) {
+  // Get the name of the file
+  boost::filesystem::path filename =
+      tile_dir_ + filesystem::path::preferred_separator + GraphTile::FileSuffix(header_->graphid());
+
+  // Open the existing file for writing in place - no truncation
+  std::fstream file(filename.c_str(), std::ios::in | std::ios::out | std::ios::binary);
+  if (!file.is_open()) {
+    throw std::runtime_error("GraphTileBuilder::PatchDirectedEdges - Failed to open file " +
+                             filename.string());
+  }
+
+  // Where the fixed size directed edge records start within the file
+  size_t edge_section = sizeof(GraphTileHeader) + header_->nodecount() * sizeof(NodeInfo) +
+                        header_->transitioncount() * sizeof(NodeTransition);
+  for (const auto& edge : edges) {
+    if (edge.first >= header_->directededgecount()) {
+      throw std::runtime_error("GraphTileBuilder::PatchDirectedEdges - edge index out of range");
+    }
+    file.seekp(edge_section + edge.first * sizeof(DirectedEdge), std::ios::beg);
+    file.write(reinterpret_cast<const char*>(&edge.second), sizeof(DirectedEdge));
+  }
+
+  // Keep the directed edge SoA mirror (when present) in sync with the
+  // patched records
+  if (header_->has_edge_soa()) {
+    const size_t count = header_->directededgecount();
+    const size_t endnodes_start = header_->edge_soa_offset();
+    const size_t lengths_start = endnodes_start + count * sizeof(uint64_t);
+    const size_t attributes_start = lengths_start + count * sizeof(uint32_t);
+    const size_t speeds_start = attributes_start + count * sizeof(uint32_t);
+    for (const auto& edge : edges) {
+      const uint64_t endnode = edge.second.endnode().value;
+      const uint32_t length = edge.second.length();
+      const uint32_t attributes = EdgeSoA::pack_attributes(edge.second);
+      const uint8_t speed = edge.second.speed();
+      file.seekp(endnodes_start + edge.first * sizeof(uint64_t), std::ios::beg);
+      file.write(reinterpret_cast<const char*>(&endnode), sizeof(endnode));
+      file.seekp(lengths_start + edge.first * sizeof(uint32_t), std::ios::beg);
+      file.write(reinterpret_cast<const char*>(&length), sizeof(length));
+      file.seekp(attributes_start + edge.first * sizeof(uint32_t), std::ios::beg);
+      file.write(reinterpret_cast<const char*>(&attributes), sizeof(attributes));
+      file.seekp(speeds_start + edge.first * sizeof(uint8_t), std::ios::beg);
+      file.write(reinterpret_cast<const char*>(&speed), sizeof(speed));
+    }
+  }
+
+  // Bump the update generation so readers can detect the tile changed and
+  // store the patched header
+  header_builder_.set_update_generation(header_builder_.update_generation() + 1);
+  file.seekp(0, std::ios::beg);
+  file.write(reinterpret_cast<const char*>(&header_builder_), sizeof(GraphTileHeader));
+  file.close();
+}
+
 // Gets a reference to the header builder.
 GraphTileHeader& GraphTileBuilder::header_builder() {
   return header_builder_;
@@ -516,6 +646,7 @@ uint32_t GraphTileBuilder::AddEdgeInfo(const uint32_t edgeindex,
     edgeinfo.set_bike_network(bike_network);
     edgeinfo.set_speed_limit(speed_limit);
     edgeinfo.set_shape(lls);
+    edgeinfo.set_index_shape(true);
 
     // Add names to the common text/name list. Skip blank names.
     std::vector<NameInfo> name_info_list;
@@ -609,6 +740,7 @@ uint32_t GraphTileBuilder::AddEdgeInfo(const uint32_t edgeindex,
     edgeinfo.set_bike_network(bike_network);
     edgeinfo.set_speed_limit(speed_limit);
     edgeinfo.set_encoded_shape(llstr);
+    edgeinfo.set_index_shape(true);
 
     // Add names to the common text/name list. Skip blank names.
     std::vector<NameInfo> name_info_list;
@@ -908,6 +1040,10 @@ void GraphTileBuilder::AddBins(const std::string& tile_dir,
   header.set_edgeinfo_offset(header.edgeinfo_offset() + shift);
   header.set_textlist_offset(header.textlist_offset() + shift);
   header.set_lane_connectivity_offset(header.lane_connectivity_offset() + shift);
+  // shift the SoA mirror along with everything else, keeping an absent
+  // section marked absent (its slot tracks the end offset)
+  header.set_edge_soa_offset(header.has_edge_soa() ? header.edge_soa_offset() + shift
+                                                   : header.end_offset() + shift);
   header.set_end_offset(header.end_offset() + shift);
   // rewrite the tile
   boost::filesystem::path filename =
@@ -1006,10 +1142,20 @@ void GraphTileBuilder::UpdatePredictedSpeeds(const std::vector<DirectedEdge>& di
     file.write(reinterpret_cast<const char*>(directededges.data()),
                directededges.size() * sizeof(DirectedEdge));
 
-    // Write out data from access restrictions to the end of lane connectivity data.
+    // Write out data from access restrictions to the end of lane connectivity
+    // data, regenerating the directed edge SoA mirror (when present) from the
+    // updated edges so the mirrored speeds and access do not go stale.
     auto begin = reinterpret_cast<const char*>(&access_restrictions_[0]);
     auto end = reinterpret_cast<const char*>(header()) + offset;
-    file.write(begin, end - begin);
+    if (header_->has_edge_soa()) {
+      auto soa_begin = reinterpret_cast<const char*>(header()) + header_->edge_soa_offset();
+      file.write(begin, soa_begin - begin);
+      const auto soa = SerializeEdgeSoA(directededges.data(), directededges.size());
+      file.write(soa.data(), soa.size());
+      file.write(soa_begin + soa.size(), end - (soa_begin + soa.size()));
+    } else {
+      file.write(begin, end - begin);
+    }
 
     // Append the speed profile indexes and profiles.
     file.write(reinterpret_cast<const char*>(speed_profile_offset_builder_.data()),
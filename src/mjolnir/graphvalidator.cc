@@ -5,6 +5,7 @@
 
 #include <boost/filesystem/operations.hpp>
 #include <boost/format.hpp>
+#include <deque>
 #include <future>
 #include <iostream>
 #include <list>
@@ -17,9 +18,13 @@
 #include <string>
 #include <thread>
 #include <tuple>
+#include <unordered_map>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
+#include "baldr/connectivity_map.h"
+#include "baldr/tileindex.h"
 #include "baldr/graphconstants.h"
 #include "baldr/graphid.h"
 #include "baldr/graphreader.h"
@@ -248,6 +253,60 @@ uint32_t GetOpposingEdgeIndex(const GraphId& startnode,
   return opp_index;
 }
 
+// Approximate the reach of an edge - how many nodes can be reached from its
+// end node following edges with any access - capped at kMaxEdgeReach.
+// Transitions are followed (and counted) so the estimate crosses hierarchy
+// levels the same way the loki reachability crawl does. Since the result only
+// depends on the end node, a per thread cache amortizes the breadth first
+// expansions over the edges of a tile that share end nodes.
+uint32_t ApproximateReach(GraphReader& reader,
+                          std::mutex& lock,
+                          std::unordered_map<uint64_t, uint32_t>& cache,
+                          const GraphId& start_node) {
+  auto cached = cache.find(start_node.value);
+  if (cached != cache.cend()) {
+    return cached->second;
+  }
+
+  std::unordered_set<uint64_t> visited{start_node.value};
+  std::deque<GraphId> expand{start_node};
+  while (!expand.empty() && visited.size() < kMaxEdgeReach) {
+    GraphId node_id = expand.front();
+    expand.pop_front();
+    lock.lock();
+    const GraphTile* tile = reader.GetGraphTile(node_id);
+    lock.unlock();
+    if (tile == nullptr) {
+      continue;
+    }
+
+    // Expand along the edges anything at all could take
+    const NodeInfo* nodeinfo = tile->node(node_id);
+    const DirectedEdge* edge = tile->directededge(nodeinfo->edge_index());
+    for (uint32_t i = 0; i < nodeinfo->edge_count() && visited.size() < kMaxEdgeReach;
+         ++i, ++edge) {
+      if (edge->is_shortcut() || !edge->forwardaccess()) {
+        continue;
+      }
+      if (visited.insert(edge->endnode().value).second) {
+        expand.push_back(edge->endnode());
+      }
+    }
+
+    // Cross to the other hierarchy levels as well
+    const NodeTransition* trans = tile->transition(nodeinfo->transition_index());
+    for (uint32_t i = 0; i < nodeinfo->transition_count() && visited.size() < kMaxEdgeReach;
+         ++i, ++trans) {
+      if (visited.insert(trans->endnode().value).second) {
+        expand.push_back(trans->endnode());
+      }
+    }
+  }
+
+  cache.emplace(start_node.value, visited.size());
+  return visited.size();
+}
+
 using tweeners_t = GraphTileBuilder::tweeners_t;
 void validate(
     const boost::property_tree::ptree& pt,
@@ -297,6 +356,9 @@ void validate(
     // Get the tile
     GraphTileBuilder tilebuilder(graph_reader.tile_dir(), tile_id, false);
 
+    // Reach values computed for the end nodes seen in this tile
+    std::unordered_map<uint64_t, uint32_t> reach_cache;
+
     // Update nodes and directed edges as needed
     std::vector<NodeInfo> nodes;
     std::vector<DirectedEdge> directededges;
@@ -427,6 +489,14 @@ void validate(
           directededge.set_start_restriction(modes);
         }
 
+        // Store the approximate reach so loki can cheaply discard candidates
+        // that cannot carry a route anywhere. Transit edges keep 0 (unknown)
+        // as reach has no meaning for them
+        if (level != transit_level && !directededge.is_shortcut()) {
+          directededge.set_reach(
+              ApproximateReach(graph_reader, lock, reach_cache, directededge.endnode()));
+        }
+
         // Add the directed edge to the local list
         directededges.emplace_back(std::move(directededge));
       }
@@ -611,6 +681,21 @@ void GraphValidator::Validate(const boost::property_tree::ptree& pt) {
   }
   LOG_INFO("Finished");
 
+  // Precompute the connectivity colors and write them beside the tiles so
+  // services can construct the connectivity map without scanning the tiles
+  LOG_INFO("Writing connectivity map...");
+  connectivity_map_t connectivity(pt.get_child("mjolnir"), false);
+  connectivity.to_file(tile_dir);
+  LOG_INFO("Finished");
+
+  // Index the tiles that were just built so readers can learn which tiles
+  // exist in a single read instead of walking the tile directory
+  LOG_INFO("Writing tile index...");
+  if (!tile_index_t::build(tile_dir)) {
+    LOG_WARN("Could not write the tile index, readers will fall back to scanning");
+  }
+  LOG_INFO("Finished");
+
   // print dupcount and find densities
   for (uint8_t level = 0; level < TileHierarchy::levels().size(); level++) {
     // Print duplicates info for level
@@ -27,12 +27,20 @@
 
 // This is largely based off of: https://github.com/CanalTP/libosmpbfreader
 // there have been some minor changes for our own purposes but its largely the same
+#include <algorithm>
+#include <condition_variable>
 #include <cstdint>
 #ifdef _MSC_VER
 #include <winsock2.h> // ntohl
 #else
 #include <netinet/in.h>
 #endif
+#include <exception>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 #include <zlib.h>
@@ -81,33 +89,16 @@ BlobHeader read_header(char* buffer, std::ifstream& file, bool& finished) {
   return result;
 }
 
-int32_t read_blob(char* buffer, char* unpack_buffer, std::ifstream& file, const BlobHeader& header) {
-  Blob blob;
-
-  // is the size of the following blob sane
-  int32_t sz = header.datasize();
-  if (sz > MAX_UNCOMPRESSED_BLOB_SIZE) {
-    throw std::runtime_error("blob-size is bigger than allowed");
-  }
-
-  // pull out the bytes
-  if (!file.read(buffer, sz)) {
-    throw std::runtime_error("unable to read blob from file");
-  }
-
-  // turn it into a protobuf object
-  if (!blob.ParseFromArray(buffer, sz)) {
-    throw std::runtime_error("unable to parse blob");
-  }
-
+int32_t unpack_blob(const Blob& blob, char* unpack_buffer) {
   // if the blob was uncompressed
+  int32_t sz;
   if (blob.has_raw()) {
     // check that raw_size is set correctly and move it to the final buffer
     sz = blob.raw().size();
     if (sz != blob.raw_size()) {
       LOG_WARN("blob reports wrong raw_size: " + std::to_string(blob.raw_size()) + " bytes");
     }
-    memcpy(unpack_buffer, buffer, sz);
+    memcpy(unpack_buffer, blob.raw().data(), sz);
     return sz;
   } // if the blob was zlib compressed
   else if (blob.has_zlib_data()) {
@@ -139,6 +130,28 @@ int32_t read_blob(char* buffer, char* unpack_buffer, std::ifstream& file, const
   throw std::runtime_error("Unsupported blob data format");
 }
 
+int32_t read_blob(char* buffer, char* unpack_buffer, std::ifstream& file, const BlobHeader& header) {
+  Blob blob;
+
+  // is the size of the following blob sane
+  int32_t sz = header.datasize();
+  if (sz > MAX_UNCOMPRESSED_BLOB_SIZE) {
+    throw std::runtime_error("blob-size is bigger than allowed");
+  }
+
+  // pull out the bytes
+  if (!file.read(buffer, sz)) {
+    throw std::runtime_error("unable to read blob from file");
+  }
+
+  // turn it into a protobuf object
+  if (!blob.ParseFromArray(buffer, sz)) {
+    throw std::runtime_error("unable to parse blob");
+  }
+
+  return unpack_blob(blob, unpack_buffer);
+}
+
 template <class T> OSMPBF::Tags get_tags(const T& object, const OSMPBF::PrimitiveBlock& primblock) {
   OSMPBF::Tags result(object.keys_size());
   for (int i = 0; i < object.keys_size(); ++i) {
@@ -151,16 +164,9 @@ template <class T> OSMPBF::Tags get_tags(const T& object, const OSMPBF::Primitiv
   return result;
 }
 
-void parse_primitive_block(char* unpack_buffer,
-                           int32_t sz,
-                           const Interest interest,
-                           Callback& callback) {
-  // turn the blob bytes into a protobuf object
-  PrimitiveBlock primblock;
-  if (!primblock.ParseFromArray(unpack_buffer, sz)) {
-    throw std::runtime_error("unable to parse primitive block");
-  }
-
+void walk_primitive_block(const PrimitiveBlock& primblock,
+                          const Interest interest,
+                          Callback& callback) {
   // for each primitive group
   for (const auto& primitive_group : primblock.primitivegroup()) {
 
@@ -262,6 +268,18 @@ void parse_primitive_block(char* unpack_buffer,
   }
 }
 
+void parse_primitive_block(char* unpack_buffer,
+                           int32_t sz,
+                           const Interest interest,
+                           Callback& callback) {
+  // turn the blob bytes into a protobuf object
+  PrimitiveBlock primblock;
+  if (!primblock.ParseFromArray(unpack_buffer, sz)) {
+    throw std::runtime_error("unable to parse primitive block");
+  }
+  walk_primitive_block(primblock, interest, callback);
+}
+
 void parse_header_block(char* unpack_buffer, int32_t sz) {
   // turn the blob bytes into a protobuf object
   HeaderBlock header_block;
@@ -272,6 +290,40 @@ void parse_header_block(char* unpack_buffer, int32_t sz) {
   // TODO: do something with replication information?
 }
 
+// a blob pulled off the file in order, waiting for a decoder thread
+struct pending_blob_t {
+  uint64_t sequence;
+  std::string type;
+  std::vector<char> bytes;
+};
+
+// the original single threaded parse loop, kept for when there is no parallelism to be had
+void parse_serial(std::ifstream& file, const Interest interest, Callback& callback) {
+  std::vector<char> buffer(MAX_UNCOMPRESSED_BLOB_SIZE);
+  std::vector<char> unpack_buffer(MAX_UNCOMPRESSED_BLOB_SIZE);
+
+  // while there is more to read
+  while (!file.eof()) {
+    // grab the blob header
+    bool finished = false;
+    BlobHeader header = read_header(buffer.data(), file, finished);
+    // if we didnt hit the end
+    if (!finished) {
+      // grab the blob that goes with the blob header
+      int32_t sz = read_blob(buffer.data(), unpack_buffer.data(), file, header);
+      // if its data parse it
+      if (header.type() == "OSMData") {
+        parse_primitive_block(unpack_buffer.data(), sz, interest, callback);
+        // if its something other than a header
+      } else if (header.type() == "OSMHeader") {
+        parse_header_block(unpack_buffer.data(), sz);
+      } else {
+        LOG_WARN("Unknown blob type: " + header.type());
+      }
+    }
+  }
+}
+
 } // namespace
 
 // extend the protobuf osmpbf namespace
@@ -286,41 +338,256 @@ Member::Member(Member&& other)
 }
 
 void Parser::parse(std::ifstream& file, const Interest interest, Callback& callback) {
-  char* buffer = new char[MAX_UNCOMPRESSED_BLOB_SIZE];
-  char* unpack_buffer = new char[MAX_UNCOMPRESSED_BLOB_SIZE];
-
   // start from the top
   file.clear();
   file.seekg(0, std::ios::beg);
 
-  // while there is more to read
-  while (!file.eof()) {
-    // grab the blob header
-    bool finished = false;
-    BlobHeader header = read_header(buffer, file, finished);
-    // if we didnt hit the end
-    if (!finished) {
-      // grab the blob that goes with the blob header
-      int32_t sz = read_blob(buffer, unpack_buffer, file, header);
-      // if its data parse it
-      if (header.type() == "OSMData") {
-        parse_primitive_block(unpack_buffer, sz, interest, callback);
-        // if its something other than a header
-      } else if (header.type() == "OSMHeader") {
-        parse_header_block(unpack_buffer, sz);
-      } else {
-        LOG_WARN("Unknown blob type: " + header.type());
+  // the callbacks are not thread safe and have to see the objects in file
+  // order so they stay on this thread, but inflating and decoding the blobs
+  // is where most of the time goes and every blob is independent, so that
+  // work is pipelined over a pool of decoder threads
+  size_t thread_count = std::max<size_t>(1, std::thread::hardware_concurrency());
+  if (thread_count < 2) {
+    parse_serial(file, interest, callback);
+    return;
+  }
+
+  // how many blobs may be read ahead of the one the callbacks are on, this
+  // bounds the memory held by blobs waiting to be decoded or called back
+  const uint64_t max_pending = thread_count * 2;
+
+  std::mutex lock;
+  std::condition_variable have_work, have_decoded;
+  std::list<pending_blob_t> pending;
+  std::map<uint64_t, std::unique_ptr<PrimitiveBlock>> decoded;
+  bool no_more_blobs = false;
+  std::exception_ptr failure;
+
+  // decoder threads pull blobs off the queue and turn them into primitive blocks
+  std::vector<std::shared_ptr<std::thread>> threads(thread_count);
+  for (auto& thread : threads) {
+    thread.reset(new std::thread([&]() {
+      std::vector<char> unpack_buffer(MAX_UNCOMPRESSED_BLOB_SIZE);
+      while (true) {
+        pending_blob_t blob;
+        {
+          std::unique_lock<std::mutex> l(lock);
+          have_work.wait(l, [&]() { return !pending.empty() || no_more_blobs || failure; });
+          if (failure || pending.empty()) {
+            return;
+          }
+          blob = std::move(pending.front());
+          pending.pop_front();
+        }
+        // decode outside the lock, only data blobs leave something to call back
+        std::unique_ptr<PrimitiveBlock> primblock;
+        try {
+          Blob b;
+          if (!b.ParseFromArray(blob.bytes.data(), static_cast<int>(blob.bytes.size()))) {
+            throw std::runtime_error("unable to parse blob");
+          }
+          int32_t sz = unpack_blob(b, unpack_buffer.data());
+          if (blob.type == "OSMData") {
+            primblock.reset(new PrimitiveBlock);
+            if (!primblock->ParseFromArray(unpack_buffer.data(), sz)) {
+              throw std::runtime_error("unable to parse primitive block");
+            }
+          } else if (blob.type == "OSMHeader") {
+            parse_header_block(unpack_buffer.data(), sz);
+          } else {
+            LOG_WARN("Unknown blob type: " + blob.type);
+          }
+        } catch (...) {
+          std::unique_lock<std::mutex> l(lock);
+          if (!failure) {
+            failure = std::current_exception();
+          }
+          have_decoded.notify_all();
+          have_work.notify_all();
+          return;
+        }
+        {
+          std::unique_lock<std::mutex> l(lock);
+          decoded.emplace(blob.sequence, std::move(primblock));
+          have_decoded.notify_all();
+        }
       }
+    }));
+  }
+
+  // this thread reads blobs off the file and walks the decoded primitive
+  // blocks through the callbacks in file order
+  uint64_t read_sequence = 0;
+  uint64_t callback_sequence = 0;
+  bool finished = false;
+  std::vector<char> header_buffer(MAX_BLOB_HEADER_SIZE);
+  try {
+    while (true) {
+      // read ahead a bounded number of blobs so the decoders stay busy
+      while (!finished && read_sequence - callback_sequence < max_pending) {
+        BlobHeader header = read_header(header_buffer.data(), file, finished);
+        if (finished) {
+          break;
+        }
+        int32_t sz = header.datasize();
+        if (sz > MAX_UNCOMPRESSED_BLOB_SIZE) {
+          throw std::runtime_error("blob-size is bigger than allowed");
+        }
+        pending_blob_t blob{read_sequence, header.type(), std::vector<char>(sz)};
+        if (!file.read(blob.bytes.data(), sz)) {
+          throw std::runtime_error("unable to read blob from file");
+        }
+        {
+          std::unique_lock<std::mutex> l(lock);
+          pending.emplace_back(std::move(blob));
+          have_work.notify_one();
+        }
+        ++read_sequence;
+      }
+
+      // everything read has been called back
+      if (finished && callback_sequence == read_sequence) {
+        break;
+      }
+
+      // wait for the next blob in file order then hand it to the callbacks
+      std::unique_ptr<PrimitiveBlock> primblock;
+      {
+        std::unique_lock<std::mutex> l(lock);
+        have_decoded.wait(l, [&]() { return decoded.count(callback_sequence) > 0 || failure; });
+        if (failure) {
+          break;
+        }
+        auto next = decoded.find(callback_sequence);
+        primblock = std::move(next->second);
+        decoded.erase(next);
+      }
+      if (primblock) {
+        walk_primitive_block(*primblock, interest, callback);
+      }
+      ++callback_sequence;
+    }
+  } catch (...) {
+    std::unique_lock<std::mutex> l(lock);
+    if (!failure) {
+      failure = std::current_exception();
     }
   }
 
-  // done with protobuf and buffers
-  delete[] buffer;
-  delete[] unpack_buffer;
+  // wind down the decoders and surface the first failure if there was one
+  {
+    std::unique_lock<std::mutex> l(lock);
+    no_more_blobs = true;
+    have_work.notify_all();
+  }
+  for (const auto& thread : threads) {
+    thread->join();
+  }
+  if (failure) {
+    std::rethrow_exception(failure);
+  }
 }
 
 void Parser::free() {
   google::protobuf::ShutdownProtobufLibrary();
 }
 
+ThreadedCallback::ThreadedCallback(Callback& callback, size_t buffer_size)
+    : callback_(callback), ring_(buffer_size), failed_(false) {
+  // replay the primitives in order on the consumer thread until the ring
+  // closes. if the wrapped callback throws we have to keep draining so the
+  // producer's pushes dont block forever, the failure is remembered and
+  // everything after it is dropped
+  consumer_ = std::thread([this]() {
+    message m;
+    while (ring_.pop(m)) {
+      if (failed_.load(std::memory_order_relaxed)) {
+        continue;
+      }
+      try {
+        switch (m.type) {
+          case message::primitive::node:
+            callback_.node_callback(m.osmid, m.lng, m.lat, m.tags);
+            break;
+          case message::primitive::way:
+            callback_.way_callback(m.osmid, m.tags, m.nodes);
+            break;
+          case message::primitive::relation:
+            callback_.relation_callback(m.osmid, m.tags, m.members);
+            break;
+          case message::primitive::changeset:
+            callback_.changeset_callback(m.osmid);
+            break;
+        }
+      } catch (...) {
+        failure_ = std::current_exception();
+        failed_.store(true, std::memory_order_release);
+      }
+    }
+  });
+}
+
+ThreadedCallback::~ThreadedCallback() {
+  ring_.close();
+  consumer_.join();
+  // a failure on the consumer's last few primitives has no push left to
+  // surface it, all we can do from a destructor is make some noise
+  if (failed_.load(std::memory_order_acquire)) {
+    LOG_ERROR("ThreadedCallback: the wrapped callback failed");
+  }
+}
+
+void ThreadedCallback::enqueue(message&& m) {
+  if (failed_.load(std::memory_order_acquire)) {
+    std::rethrow_exception(failure_);
+  }
+  ring_.push(std::move(m));
+}
+
+void ThreadedCallback::node_callback(const uint64_t osmid,
+                                     const double lng,
+                                     const double lat,
+                                     const Tags& tags) {
+  message m;
+  m.type = message::primitive::node;
+  m.osmid = osmid;
+  m.lng = lng;
+  m.lat = lat;
+  m.tags = tags;
+  enqueue(std::move(m));
+}
+
+void ThreadedCallback::way_callback(const uint64_t osmid,
+                                    const Tags& tags,
+                                    const std::vector<uint64_t>& nodes) {
+  message m;
+  m.type = message::primitive::way;
+  m.osmid = osmid;
+  m.tags = tags;
+  m.nodes = nodes;
+  enqueue(std::move(m));
+}
+
+void ThreadedCallback::relation_callback(const uint64_t osmid,
+                                         const Tags& tags,
+                                         const std::vector<Member>& members) {
+  message m;
+  m.type = message::primitive::relation;
+  m.osmid = osmid;
+  m.tags = tags;
+  // members arent copyable so they are rebuilt piecewise
+  m.members.reserve(members.size());
+  for (const auto& member : members) {
+    m.members.emplace_back(member.member_type, member.member_id, member.role);
+  }
+  enqueue(std::move(m));
+}
+
+void ThreadedCallback::changeset_callback(const uint64_t changeset_id) {
+  message m;
+  m.type = message::primitive::changeset;
+  m.osmid = changeset_id;
+  enqueue(std::move(m));
+}
+
 } // namespace OSMPBF
@@ -11,10 +11,13 @@
 #include <boost/format.hpp>
 #include <future>
 #include <thread>
+#include <unordered_set>
 #include <utility>
 
 #include "baldr/tilehierarchy.h"
 #include "midgard/logging.h"
+#include "midgard/pointll.h"
+#include "midgard/sequence.h"
 
 using namespace valhalla::midgard;
 using namespace valhalla::baldr;
@@ -41,6 +44,11 @@ public:
         lua_(std::string(lua_admin_lua, lua_admin_lua + lua_admin_lua_len)) {
   }
 
+  // Swap out the sequence the member ways' shape is being written to
+  void reset(sequence<OSMWayNode>* way_nodes) {
+    way_nodes_.reset(way_nodes);
+  }
+
   virtual void
   node_callback(const uint64_t osmid, double lng, double lat, const OSMPBF::Tags& tags) override {
     // Check if it is in the list of nodes used by ways
@@ -48,12 +56,26 @@ public:
       return;
     }
 
-    ++osmdata_.osm_node_count;
-
-    osmdata_.shape_map.emplace(osmid, PointLL(lng, lat));
+    // Fill the coordinate into every way shape entry that references this
+    // node. The sequence was sorted by node id so they are all contiguous
+    OSMNode n{osmid};
+    n.set_latlng({lng, lat});
+    current_way_node_index_ =
+        way_nodes_->find_first_of(OSMWayNode{{osmid}}, WayNodeEquals, current_way_node_index_);
+    if (current_way_node_index_ >= way_nodes_->size()) {
+      throw std::runtime_error("Didn't find OSMWayNode for node id: " + std::to_string(osmid));
+    }
+    OSMWayNode way_node;
+    sequence<OSMWayNode>::iterator element = (*way_nodes_)[current_way_node_index_];
+    while (current_way_node_index_ < way_nodes_->size() &&
+           (way_node = element = (*way_nodes_)[current_way_node_index_]).node.osmid == osmid) {
+      way_node.node = n;
+      element = way_node;
+      ++current_way_node_index_;
+    }
 
-    if (osmdata_.shape_map.size() % 500000 == 0) {
-      LOG_INFO("Processed " + std::to_string(osmdata_.shape_map.size()) + " nodes on ways");
+    if (++osmdata_.osm_node_count % 500000 == 0) {
+      LOG_INFO("Processed " + std::to_string(osmdata_.osm_node_count) + " nodes on ways");
     }
   }
 
@@ -66,13 +88,23 @@ public:
       return;
     }
 
+    // A way can show up in more than one input file; only write its shape once
+    if (!ways_written_.insert(osmid).second) {
+      return;
+    }
+
+    size_t shape_node_index = 0;
     for (const auto node : nodes) {
       ++osmdata_.node_count;
       // Mark the nodes that we will care about when processing nodes
       shape_.set(node);
+      // The coordinate is filled in when the node shows up in the node pass.
+      // Ways whose nodes were clipped out of the extract keep the invalid
+      // lat,lng and their relations are skipped when polygons are assembled
+      OSMWayNode way_node{{node}, osmid, shape_node_index++};
+      way_node.node.set_latlng(PointLL());
+      way_nodes_->push_back(way_node);
     }
-
-    osmdata_.way_map.emplace(osmid, std::list<uint64_t>(nodes.begin(), nodes.end()));
   }
 
   virtual void relation_callback(const uint64_t osmid,
@@ -133,6 +165,16 @@ public:
 
   // Pointer to all the OSM data (for use by callbacks)
   OSMData& osmdata_;
+
+  // Disk backed list of the member ways' shape nodes, keyed by the way id so
+  // the polygon assembly can pull one way's shape in at a time
+  std::unique_ptr<sequence<OSMWayNode>> way_nodes_;
+
+  // Where the node pass is in filling the shape coordinates in
+  size_t current_way_node_index_ = 0;
+
+  // The ways whose shape has already been written to the sequence
+  std::unordered_set<uint64_t> ways_written_;
 };
 
 } // namespace
@@ -141,11 +183,13 @@ namespace valhalla {
 namespace mjolnir {
 
 OSMData PBFAdminParser::Parse(const boost::property_tree::ptree& pt,
-                              const std::vector<std::string>& input_files) {
+                              const std::vector<std::string>& input_files,
+                              const std::string& way_nodes_file) {
   // Create OSM data. Set the member pointer so that the parsing callback
   // methods can use it.
   OSMData osmdata{};
   admin_callback callback(pt, osmdata);
+  callback.reset(new sequence<OSMWayNode>(way_nodes_file, true));
 
   LOG_INFO("Parsing files: " + boost::algorithm::join(input_files, ", "));
 
@@ -170,7 +214,8 @@ OSMData PBFAdminParser::Parse(const boost::property_tree::ptree& pt,
   LOG_INFO("Finished with " + std::to_string(osmdata.admins_.size()) +
            " admin polygons comprised of " + std::to_string(osmdata.osm_way_count) + " ways");
 
-  // Parse the ways.
+  // Parse the ways. Member way shapes are streamed to the disk backed
+  // sequence rather than held in memory
   LOG_INFO("Parsing ways...");
   for (auto& file_handle : file_handles) {
     OSMPBF::Parser::parse(file_handle,
@@ -178,20 +223,49 @@ OSMData PBFAdminParser::Parse(const boost::property_tree::ptree& pt,
                                                         OSMPBF::Interest::CHANGESETS),
                           callback);
   }
-  LOG_INFO("Finished with " + std::to_string(osmdata.way_map.size()) + " ways comprised of " +
-           std::to_string(osmdata.node_count) + " nodes");
+  LOG_INFO("Finished with " + std::to_string(callback.ways_written_.size()) +
+           " ways comprised of " + std::to_string(osmdata.node_count) + " nodes");
+
+  // we need to sort the refs so that we can easily (sequentially) update them
+  // during node processing
+  LOG_INFO("Sorting osm way node references by node id...");
+  {
+    callback.reset(nullptr);
+    sequence<OSMWayNode> way_nodes(way_nodes_file, false);
+    way_nodes.sort(
+        [](const OSMWayNode& a, const OSMWayNode& b) { return a.node.osmid < b.node.osmid; });
+  }
 
   // Parse node in all the input files. Skip any that are not marked from
   // being used in a way.
   LOG_INFO("Parsing nodes...");
   for (auto& file_handle : file_handles) {
+    // each time we parse nodes we have to run through the way nodes file from
+    // the beginning because osm node ids are only sorted at the single pbf
+    // file level
+    callback.reset(new sequence<OSMWayNode>(way_nodes_file, false));
+    callback.current_way_node_index_ = 0;
     OSMPBF::Parser::parse(file_handle,
                           static_cast<OSMPBF::Interest>(OSMPBF::Interest::NODES |
                                                         OSMPBF::Interest::CHANGESETS),
                           callback);
   }
+  callback.reset(nullptr);
   LOG_INFO("Finished with " + std::to_string(osmdata.osm_node_count) + " nodes");
 
+  // we need to sort the refs so the assembly can binary search a way id and
+  // walk its shape nodes in order
+  LOG_INFO("Sorting osm way node references by way id and node shape index...");
+  {
+    sequence<OSMWayNode> way_nodes(way_nodes_file, false);
+    way_nodes.sort([](const OSMWayNode& a, const OSMWayNode& b) {
+      if (a.way_index == b.way_index) {
+        return a.way_shape_node_index < b.way_shape_node_index;
+      }
+      return a.way_index < b.way_index;
+    });
+  }
+
   // Return OSM data
   return osmdata;
 }
@@ -12,6 +12,7 @@
 #include <boost/range/algorithm/remove_if.hpp>
 #include <future>
 #include <thread>
+#include <unordered_set>
 #include <utility>
 
 #include "baldr/complexrestriction.h"
@@ -40,6 +41,49 @@ constexpr uint64_t kMaxOSMNodeId = 6500000000;
 // Absurd classification.
 constexpr uint32_t kAbsurdRoadClass = 777777;
 
+// The default graph.lua throws out ways with no highway tag that are not a
+// ferry or rail shuttle, unless one of a handful of keys can turn a travel
+// mode back on (driveways, contraflow bike and bus lanes and the like).
+// Checking those keys here lets the parser reject the bulk of a planet's
+// ways (buildings, landuse, etc.) without a round trip through the lua
+// interpreter. Must be kept in sync with filter_tags_generic in graph.lua
+bool DefaultLuaFiltersWay(const OSMPBF::Tags& tags) {
+  // ways_proc rejects a way with no tags outright
+  if (tags.empty()) {
+    return true;
+  }
+
+  // a highway tag or a routable route tag means the lua has to look at it
+  if (tags.find("highway") != tags.end()) {
+    return false;
+  }
+  auto route = tags.find("route");
+  if (route != tags.end() && (route->second == "ferry" || route->second == "shuttle_train")) {
+    return false;
+  }
+
+  // keys that can resurrect a way that has neither of the above
+  static const std::unordered_set<std::string> kModeOverrideKeys = {
+      "service",        "cycleway",       "cycleway:left",      "cycleway:right",
+      "bicycle:backward", "oneway:bicycle", "busway",           "busway:left",
+      "busway:right",   "lanes:psv:backward", "moped:backward", "mofa:backward",
+      "oneway:moped",   "oneway:mofa",    "motorcycle:backward", "oneway:motorcycle"};
+  for (const auto& tag : tags) {
+    if (kModeOverrideKeys.find(tag.first) != kModeOverrideKeys.end()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// The default graph.lua only ever keeps relations whose type is
+// connectivity, route or restriction. Must be kept in sync with rels_proc
+bool DefaultLuaFiltersRelation(const OSMPBF::Tags& tags) {
+  auto type = tags.find("type");
+  return type == tags.end() || (type->second != "connectivity" && type->second != "route" &&
+                                type->second != "restriction");
+}
+
 // Construct PBFGraphParser based on properties file and input PBF extract
 struct graph_callback : public OSMPBF::Callback {
 public:
@@ -61,6 +105,10 @@ public:
     }
 
     include_driveways_ = pt.get<bool>("include_driveways", true);
+
+    // The lua shortcutting filters above only describe the embedded script,
+    // a custom one may keep elements they would reject
+    default_lua_ = !pt.get_optional<std::string>("graph_lua_name");
   }
 
   static std::string get_lua(const boost::property_tree::ptree& pt) {
@@ -219,7 +267,11 @@ public:
     }
 
     // Transform tags. If no results that means the way does not have tags
-    // suitable for use in routing.
+    // suitable for use in routing. Skip the lua entirely when we can prove
+    // the default script would reject the way
+    if (default_lua_ && DefaultLuaFiltersWay(tags)) {
+      return;
+    }
     Tags results = lua_.Transform(OSMType::kWay, tags);
     if (results.size() == 0) {
       return;
@@ -1099,7 +1151,11 @@ public:
   virtual void relation_callback(const uint64_t osmid,
                                  const OSMPBF::Tags& tags,
                                  const std::vector<OSMPBF::Member>& members) override {
-    // Get tags
+    // Get tags. Skip the lua entirely when we can prove the default script
+    // would reject the relation
+    if (default_lua_ && DefaultLuaFiltersRelation(tags)) {
+      return;
+    }
     Tags results = lua_.Transform(OSMType::kRelation, tags);
     if (results.size() == 0) {
       return;
@@ -1525,6 +1581,10 @@ public:
   // Lua Tag Transformation class
   LuaTagTransform lua_;
 
+  // Whether the embedded graph.lua is in use, enabling the c++ fast path
+  // that skips the interpreter for elements the script provably rejects
+  bool default_lua_;
+
   // Pointer to all the OSM data (for use by callbacks)
   OSMData& osmdata_;
 
@@ -1598,10 +1658,14 @@ OSMData PBFGraphParser::Parse(const boost::property_tree::ptree& pt,
   for (auto& file_handle : file_handles) {
     callback.current_way_node_index_ = callback.last_node_ = callback.last_way_ =
         callback.last_relation_ = 0;
+    // tag transformation and sequence writes run on the threaded callback's
+    // consumer thread, overlapping with the pbf decoding. its destruction at
+    // the end of the iteration drains everything before we touch the state
+    OSMPBF::ThreadedCallback threaded(callback);
     OSMPBF::Parser::parse(file_handle,
                           static_cast<OSMPBF::Interest>(OSMPBF::Interest::WAYS |
                                                         OSMPBF::Interest::CHANGESETS),
-                          callback);
+                          threaded);
   }
   callback.output_loops();
   LOG_INFO("Finished with " + std::to_string(osmdata.osm_way_count) + " routable ways containing " +
@@ -1619,10 +1683,11 @@ OSMData PBFGraphParser::Parse(const boost::property_tree::ptree& pt,
   for (auto& file_handle : file_handles) {
     callback.current_way_node_index_ = callback.last_node_ = callback.last_way_ =
         callback.last_relation_ = 0;
+    OSMPBF::ThreadedCallback threaded(callback);
     OSMPBF::Parser::parse(file_handle,
                           static_cast<OSMPBF::Interest>(OSMPBF::Interest::RELATIONS |
                                                         OSMPBF::Interest::CHANGESETS),
-                          callback);
+                          threaded);
   }
   LOG_INFO("Finished with " + std::to_string(osmdata.restrictions.size()) + " simple restrictions");
   LOG_INFO("Finished with " + std::to_string(osmdata.lane_connectivity_map.size()) +
@@ -1665,10 +1730,11 @@ OSMData PBFGraphParser::Parse(const boost::property_tree::ptree& pt,
                    nullptr);
     callback.current_way_node_index_ = callback.last_node_ = callback.last_way_ =
         callback.last_relation_ = 0;
+    OSMPBF::ThreadedCallback threaded(callback);
     OSMPBF::Parser::parse(file_handle,
                           static_cast<OSMPBF::Interest>(OSMPBF::Interest::NODES |
                                                         OSMPBF::Interest::CHANGESETS),
-                          callback);
+                          threaded);
   }
   uint64_t max_osm_id = callback.last_node_;
   callback.reset(nullptr, nullptr, nullptr, nullptr, nullptr);
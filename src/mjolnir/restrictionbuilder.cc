@@ -241,8 +241,10 @@ void build(const std::string& complex_restriction_from_file,
            std::queue<GraphId>& tilequeue,
            std::mutex& lock,
            std::promise<DataQuality>& result) {
-  sequence<OSMRestriction> complex_restrictions_from(complex_restriction_from_file, false);
-  sequence<OSMRestriction> complex_restrictions_to(complex_restriction_to_file, false);
+  // only searched, never written - map the restrictions readonly so the
+  // builder threads share the page cache
+  sequence<OSMRestriction> complex_restrictions_from(complex_restriction_from_file, false, true);
+  sequence<OSMRestriction> complex_restrictions_to(complex_restriction_to_file, false, true);
 
   GraphReader reader(hierarchy_properties);
   DataQuality stats;
@@ -4,12 +4,16 @@
 #include <boost/filesystem/operations.hpp>
 #include <boost/format.hpp>
 #include <boost/property_tree/ptree.hpp>
+#include <future>
 #include <iostream>
 #include <map>
+#include <mutex>
 #include <ostream>
+#include <queue>
 #include <set>
 #include <sstream>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -141,9 +145,12 @@ bool EdgesMatch(const GraphTile* tile, const DirectedEdge* edge1, const Directed
 GraphId GetOpposingEdge(const GraphId& node,
                         const DirectedEdge* edge,
                         GraphReader& reader,
+                        std::mutex& lock,
                         const uint32_t wayid) {
   // Get the tile at the end node
+  lock.lock();
   const GraphTile* tile = reader.GetGraphTile(edge->endnode());
+  lock.unlock();
   const NodeInfo* nodeinfo = tile->node(edge->endnode().id());
 
   // Get the directed edges and return when the end node matches
@@ -170,8 +177,10 @@ GraphId GetOpposingEdge(const GraphId& node,
 }
 
 // Get the ISO country code at the end node
-std::string EndNodeIso(const DirectedEdge* edge, GraphReader& reader) {
+std::string EndNodeIso(const DirectedEdge* edge, GraphReader& reader, std::mutex& lock) {
+  lock.lock();
   const GraphTile* tile = reader.GetGraphTile(edge->endnode());
+  lock.unlock();
   const NodeInfo* nodeinfo = tile->node(edge->endnode().id());
   return tile->admininfo(nodeinfo->admin_index()).country_iso();
 }
@@ -179,6 +188,7 @@ std::string EndNodeIso(const DirectedEdge* edge, GraphReader& reader) {
 /**
  * Test if the node is eligible to be contracted (part of a shortcut).
  * @param reader    Graph reader.
+ * @param lock      Mutex for locking while tiles are retrieved.
  * @param tile      Current tile.
  * @param nodeinfo  Node information.
  * @param node      Node id.
@@ -187,6 +197,7 @@ std::string EndNodeIso(const DirectedEdge* edge, GraphReader& reader) {
  *          false if not.
  */
 bool CanContract(GraphReader& reader,
+                 std::mutex& lock,
                  const GraphTile* tile,
                  const GraphId& node,
                  EdgePairs& edgepairs) {
@@ -273,10 +284,12 @@ bool CanContract(GraphReader& reader,
   uint32_t wayid1 = tile->edgeinfo(edge1->edgeinfo_offset()).wayid();
   const DirectedEdge* edge2 = tile->directededge(edges[match.second]);
   uint32_t wayid2 = tile->edgeinfo(edge2->edgeinfo_offset()).wayid();
-  GraphId oppedge1 = GetOpposingEdge(node, edge1, reader, wayid1);
-  GraphId oppedge2 = GetOpposingEdge(node, edge2, reader, wayid2);
+  GraphId oppedge1 = GetOpposingEdge(node, edge1, reader, lock, wayid1);
+  GraphId oppedge2 = GetOpposingEdge(node, edge2, reader, lock, wayid2);
+  lock.lock();
   const DirectedEdge* oppdiredge1 = reader.GetGraphTile(oppedge1)->directededge(oppedge1);
   const DirectedEdge* oppdiredge2 = reader.GetGraphTile(oppedge2)->directededge(oppedge2);
+  lock.unlock();
 
   // If either opposing directed edge has exit signs return false
   if (oppdiredge1->exitsign() || oppdiredge2->exitsign()) {
@@ -298,8 +311,8 @@ bool CanContract(GraphReader& reader,
 
   // ISO country codes at the end nodes must equal this node
   std::string iso = tile->admininfo(nodeinfo->admin_index()).country_iso();
-  std::string e1_iso = EndNodeIso(edge1, reader);
-  std::string e2_iso = EndNodeIso(edge2, reader);
+  std::string e1_iso = EndNodeIso(edge1, reader, lock);
+  std::string e2_iso = EndNodeIso(edge2, reader, lock);
   if (e1_iso != iso || e2_iso != iso) {
     return false;
   }
@@ -332,17 +345,37 @@ bool CanContract(GraphReader& reader,
 
 // Connect 2 edges shape and update the next end node in the new level
 uint32_t ConnectEdges(GraphReader& reader,
+                      std::mutex& lock,
                       const GraphId& startnode,
                       const GraphId& edgeid,
                       std::list<PointLL>& shape,
                       GraphId& endnode,
                       uint32_t& opp_local_idx,
                       uint32_t& restrictions,
-                      float& average_density) {
+                      float& average_density,
+                      float& average_grade,
+                      DirectedEdge& newedge) {
   // Get the tile and directed edge.
+  lock.lock();
   const GraphTile* tile = reader.GetGraphTile(startnode);
+  lock.unlock();
   const DirectedEdge* directededge = tile->directededge(edgeid);
 
+  // Mode specific attributes that the bicycle and pedestrian costings read
+  // per edge are copied onto the shortcut from its first constituent. When
+  // they vary along the chain the shortcut cannot be costed faithfully for
+  // that mode, so drop its access and leave the mode on the superseded edges
+  if (directededge->cyclelane() != newedge.cyclelane() ||
+      directededge->dismount() != newedge.dismount() ||
+      directededge->use_sidepath() != newedge.use_sidepath()) {
+    newedge.set_forwardaccess(newedge.forwardaccess() & ~kBicycleAccess);
+    newedge.set_reverseaccess(newedge.reverseaccess() & ~kBicycleAccess);
+  }
+  if (directededge->sac_scale() != newedge.sac_scale()) {
+    newedge.set_forwardaccess(newedge.forwardaccess() & ~kPedestrianAccess);
+    newedge.set_reverseaccess(newedge.reverseaccess() & ~kPedestrianAccess);
+  }
+
   // Copy the restrictions and opposing local index. Want to set the shortcut
   // edge's restrictions and opp_local_idx to the last directed edge in the chain
   opp_local_idx = directededge->opp_local_idx();
@@ -360,8 +393,15 @@ uint32_t ConnectEdges(GraphReader& reader,
   edgeshape.pop_front();
   shape.splice(shape.end(), edgeshape);
 
-  // Add to the weighted average
+  // Add to the weighted averages. The grade code is decoded back to percent
+  // so the shortcut can carry the length weighted grade of the chain rather
+  // than whatever the first constituent edge had
   average_density += directededge->length() * directededge->density();
+  average_grade += directededge->length() * ((directededge->weighted_grade() - 6.5f) / 0.6f);
+
+  // Keep the worst slopes seen along the chain
+  newedge.set_max_up_slope(std::max(newedge.max_up_slope(), directededge->max_up_slope()));
+  newedge.set_max_down_slope(std::min(newedge.max_down_slope(), directededge->max_down_slope()));
 
   // Update the end node and return the length
   endnode = directededge->endnode();
@@ -369,16 +409,22 @@ uint32_t ConnectEdges(GraphReader& reader,
 }
 
 // Check if the edge is entering a contracted node
-bool IsEnteringEdgeOfContractedNode(GraphReader& reader, const GraphId& nodeid, const GraphId& edge) {
+bool IsEnteringEdgeOfContractedNode(GraphReader& reader,
+                                    std::mutex& lock,
+                                    const GraphId& nodeid,
+                                    const GraphId& edge) {
   EdgePairs edgepairs;
+  lock.lock();
   const GraphTile* tile = reader.GetGraphTile(nodeid);
-  bool c = CanContract(reader, tile, nodeid, edgepairs);
+  lock.unlock();
+  bool c = CanContract(reader, lock, tile, nodeid, edgepairs);
   return c && (edgepairs.edge1.first == edge || edgepairs.edge2.first == edge);
 }
 
 // Add shortcut edges (if they should exist) from the specified node
 // TODO - need to add access restrictions?
 uint32_t AddShortcutEdges(GraphReader& reader,
+                          std::mutex& lock,
                           const GraphTile* tile,
                           GraphTileBuilder& tilebuilder,
                           const GraphId& start_node,
@@ -389,13 +435,14 @@ uint32_t AddShortcutEdges(GraphReader& reader,
   // Shortcut edges have to start at a node that is not contracted - return if
   // this node can be contracted.
   EdgePairs edgepairs;
-  if (CanContract(reader, tile, start_node, edgepairs)) {
+  if (CanContract(reader, lock, tile, start_node, edgepairs)) {
     return 0;
   }
 
   // Check if this is the last edge in a shortcut (if the endnode cannot be contracted).
-  auto last_edge = [&reader](const GraphTile* tile, const GraphId& endnode, EdgePairs& edgepairs) {
-    return !CanContract(reader, tile, endnode, edgepairs);
+  auto last_edge = [&reader, &lock](const GraphTile* tile, const GraphId& endnode,
+                                    EdgePairs& edgepairs) {
+    return !CanContract(reader, lock, tile, endnode, edgepairs);
   };
 
   // Iterate through directed edges of the base node
@@ -414,13 +461,14 @@ uint32_t AddShortcutEdges(GraphReader& reader,
     // Get the end node and check if the edge is set as a matching, entering
     // edge of the contracted node.
     GraphId end_node = directededge->endnode();
-    if (IsEnteringEdgeOfContractedNode(reader, end_node, edge_id)) {
+    if (IsEnteringEdgeOfContractedNode(reader, lock, end_node, edge_id)) {
       // Form a shortcut edge.
       DirectedEdge newedge = *directededge;
       uint32_t length = newedge.length();
 
-      // For computing weighted density along the shortcut
+      // For computing weighted density and grade along the shortcut
       float average_density = length * newedge.density();
+      float average_grade = length * ((newedge.weighted_grade() - 6.5f) / 0.6f);
 
       // Get the shape for this edge. If this initial directed edge is not
       // forward - reverse the shape so the edge info stored is forward for
@@ -453,7 +501,9 @@ uint32_t AddShortcutEdges(GraphReader& reader,
       GraphId next_edge_id = edge_id;
       while (true) {
         EdgePairs edgepairs;
+        lock.lock();
         const GraphTile* tile = reader.GetGraphTile(end_node);
+        lock.unlock();
         if (last_edge(tile, end_node, edgepairs)) {
           break;
         }
@@ -478,8 +528,8 @@ uint32_t AddShortcutEdges(GraphReader& reader,
         // end node in the new level). Keep track of the last restriction
         // on the connected shortcut - need to set that so turn restrictions
         // off of shortcuts work properly
-        length += ConnectEdges(reader, end_node, next_edge_id, shape, end_node, opp_local_idx, rst,
-                               average_density);
+        length += ConnectEdges(reader, lock, end_node, next_edge_id, shape, end_node, opp_local_idx,
+                               rst, average_density, average_grade, newedge);
       }
 
       // Add the edge info. Use length and number of shape points to match an
@@ -521,8 +571,13 @@ uint32_t AddShortcutEdges(GraphReader& reader,
           tilebuilder.set_mean_elevation(std::get<3>(grades));
         }
       } else {
-        // Set the default weighted grade for the edge. No edge elevation is added.
-        newedge.set_weighted_grade(6);
+        // No elevation was sampled along the shape. Rather than flattening
+        // the shortcut to the default grade, which makes grade sensitive
+        // costings price it differently than the path it supersedes, carry
+        // the length weighted grade of the base edges. The max slopes were
+        // kept as the chain maxima while connecting the edges
+        newedge.set_weighted_grade(
+            static_cast<uint32_t>(average_grade / static_cast<float>(length) * .6 + 6.5));
       }
 
       // Sanity check - should never see a shortcut with signs
@@ -532,8 +587,10 @@ uint32_t AddShortcutEdges(GraphReader& reader,
 
       // Get turn lanes from the base directed edge. Add them if this is the last edge otherwise
       // set the turnlanes flag to false;
-      if (directededge->turnlanes() && last_edge(reader.GetGraphTile(directededge->endnode()),
-                                                 directededge->endnode(), edgepairs)) {
+      lock.lock();
+      const GraphTile* end_tile = reader.GetGraphTile(directededge->endnode());
+      lock.unlock();
+      if (directededge->turnlanes() && last_edge(end_tile, directededge->endnode(), edgepairs)) {
         uint32_t offset = tile->turnlanes_offset(edge_id.id());
         tilebuilder.AddTurnLanes(tilebuilder.directededges().size(), tile->GetName(offset));
         newedge.set_turnlanes(true);
@@ -569,28 +626,44 @@ uint32_t AddShortcutEdges(GraphReader& reader,
   return shortcut_count;
 }
 
-// Form shortcuts for tiles in this level.
-uint32_t FormShortcuts(GraphReader& reader,
-                       const TileLevel& level,
-                       const std::unique_ptr<const valhalla::skadi::sample>& sample) {
-  // Iterate through the tiles at this level (TODO - can we mark the tiles
-  // the tiles that shortcuts end within?)
-  reader.Clear();
+// Form shortcuts for tiles pulled from the shared queue. Each thread uses
+// its own local GraphReader. The lock guards the queue and all tile reads
+// and writes so a tile is never read while another thread is storing one.
+void build_shortcuts(const boost::property_tree::ptree& hierarchy_properties,
+                     const TileLevel& level,
+                     std::queue<GraphId>& tilequeue,
+                     std::mutex& lock,
+                     const std::unique_ptr<const valhalla::skadi::sample>& sample,
+                     std::promise<uint32_t>& result) {
+  // Local Graphreader
+  GraphReader reader(hierarchy_properties);
+
   bool added = false;
   uint32_t shortcut_count = 0;
-  uint32_t ntiles = level.tiles.TileCount();
   uint32_t tile_level = (uint32_t)level.level;
-  const GraphTile* tile = nullptr;
-  for (uint32_t tileid = 0; tileid < ntiles; tileid++) {
+  while (true) {
+    // Get the next tile Id from the queue. Lock while we access the queue
+    // and read the tile
+    lock.lock();
+    if (tilequeue.empty()) {
+      lock.unlock();
+      break;
+    }
+    GraphId tile_id = tilequeue.front();
+    tilequeue.pop();
+    uint32_t tileid = tile_id.tileid();
+
     // Get the graph tile. Skip if no tile exists (common case)
-    tile = reader.GetGraphTile(GraphId(tileid, tile_level, 0));
+    const GraphTile* tile = reader.GetGraphTile(tile_id);
     if (tile == nullptr || tile->header()->nodecount() == 0) {
+      lock.unlock();
       continue;
     }
 
     // Create GraphTileBuilder for the new tile
     GraphId new_tile(tileid, tile_level, 0);
     GraphTileBuilder tilebuilder(reader.tile_dir(), new_tile, false);
+    lock.unlock();
 
     // Since the old tile is not serialized we must copy any data that is not
     // dependent on edge Id into the new builders (e.g., node transitions)
@@ -618,10 +691,13 @@ uint32_t FormShortcuts(GraphReader& reader,
       // Current edge count
       size_t edge_count = tilebuilder.directededges().size();
 
-      // Add shortcut edges first.
+      // Add shortcut edges first and record how many lead the edge list so
+      // the expansion can partition the walk without testing each edge
       std::unordered_map<uint32_t, uint32_t> shortcuts;
-      shortcut_count += AddShortcutEdges(reader, tile, tilebuilder, node_id, old_edge_index,
-                                         old_edge_count, shortcuts, sample);
+      uint32_t node_shortcuts = AddShortcutEdges(reader, lock, tile, tilebuilder, node_id,
+                                                 old_edge_index, old_edge_count, shortcuts, sample);
+      nodeinfo.set_shortcut_count(node_shortcuts);
+      shortcut_count += node_shortcuts;
 
       // Copy the rest of the directed edges from this node
       GraphId edgeid(tileid, tile_level, old_edge_index);
@@ -698,7 +774,9 @@ uint32_t FormShortcuts(GraphReader& reader,
       tilebuilder.nodes().emplace_back(std::move(nodeinfo));
     }
 
-    // Store the new tile
+    // Store the new tile. Lock so no other thread reads the tile file
+    // while it is being written
+    lock.lock();
     tilebuilder.StoreTileData();
     LOG_DEBUG((boost::format("ShortcutBuilder created tile %1%: %2% bytes") % tile %
                tilebuilder.header_builder().end_offset())
@@ -708,6 +786,57 @@ uint32_t FormShortcuts(GraphReader& reader,
     if (reader.OverCommitted()) {
       reader.Clear();
     }
+    lock.unlock();
+  }
+
+  // Send back the shortcut count
+  result.set_value(shortcut_count);
+}
+
+// Form shortcuts for all tiles at this level. A shortcut is stored in the
+// tile its first base edge starts in, so each tile can be rebuilt on its
+// own given read access to its neighbors. CanContract already skips
+// shortcut edges when a traversal walks into a tile that has been rebuilt.
+uint32_t FormShortcuts(const boost::property_tree::ptree& hierarchy_properties,
+                       const unsigned int thread_count,
+                       const TileLevel& level,
+                       const std::unique_ptr<const valhalla::skadi::sample>& sample) {
+  // A place to hold worker threads and their results, exceptions or otherwise
+  std::vector<std::shared_ptr<std::thread>> threads(thread_count);
+
+  // A place to hold the results of those threads
+  std::vector<std::promise<uint32_t>> results(threads.size());
+
+  // Create a queue of the tiles that exist at this level. In a distributed
+  // build only this host's shard of the tiles gets its shortcuts built
+  tile_shard_t shard(hierarchy_properties);
+  std::queue<GraphId> tilequeue;
+  for (uint32_t tileid = 0; tileid < level.tiles.TileCount(); tileid++) {
+    GraphId tile_id(tileid, level.level, 0);
+    if (shard.contains(tile_id) && GraphReader::DoesTileExist(hierarchy_properties, tile_id)) {
+      tilequeue.emplace(tile_id);
+    }
+  }
+
+  // An atomic object we can use to do the synchronization
+  std::mutex lock;
+
+  // Start the threads
+  for (size_t i = 0; i < threads.size(); ++i) {
+    threads[i].reset(new std::thread(build_shortcuts, std::cref(hierarchy_properties),
+                                     std::cref(level), std::ref(tilequeue), std::ref(lock),
+                                     std::cref(sample), std::ref(results[i])));
+  }
+
+  // Wait for them to finish up their work
+  for (auto& thread : threads) {
+    thread->join();
+  }
+
+  // Total up the shortcut counts. If a thread threw this rethrows it
+  uint32_t shortcut_count = 0;
+  for (auto& result : results) {
+    shortcut_count += result.get_future().get();
   }
   return shortcut_count;
 }
@@ -722,12 +851,11 @@ namespace mjolnir {
 // attributes. Shortcut edges are inserted before regular edges.
 void ShortcutBuilder::Build(const boost::property_tree::ptree& pt) {
 
-  // TODO: thread this. would need to make sure we dont make shortcuts
-  // across tile boundaries so that we are only messing with one tile
-  // in one thread at a time
-
-  // Get GraphReader
-  GraphReader reader(pt.get_child("mjolnir"));
+  // Number of threads to use and the tile properties the readers need
+  auto thread_count =
+      std::max(static_cast<unsigned int>(1),
+               pt.get<unsigned int>("mjolnir.concurrency", std::thread::hardware_concurrency()));
+  boost::property_tree::ptree hierarchy_properties = pt.get_child("mjolnir");
 
   // Crack open some elevation data if its there
   boost::optional<std::string> elevation = pt.get_optional<std::string>("additional_data.elevation");
@@ -739,10 +867,12 @@ void ShortcutBuilder::Build(const boost::property_tree::ptree& pt) {
   auto level = TileHierarchy::levels().rbegin();
   level++;
   for (; level != TileHierarchy::levels().rend(); ++level) {
-    // Create shortcuts on this level
+    // Create shortcuts on this level. Levels are done one at a time since
+    // a lower level could add transitions into one still being built
     auto tile_level = level->second;
-    LOG_INFO("Creating shortcuts on level " + std::to_string(tile_level.level));
-    uint32_t count = FormShortcuts(reader, tile_level, sample);
+    LOG_INFO("Creating shortcuts on level " + std::to_string(tile_level.level) + " with " +
+             std::to_string(thread_count) + " threads...");
+    uint32_t count = FormShortcuts(hierarchy_properties, thread_count, tile_level, sample);
     LOG_INFO("Finished with " + std::to_string(count) + " shortcuts");
   }
 }
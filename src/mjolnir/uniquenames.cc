@@ -1,12 +1,28 @@
 #include "mjolnir/uniquenames.h"
 
+#include <cstring>
+
 #include "midgard/logging.h"
 
 namespace valhalla {
 namespace mjolnir {
 
+// FNV-1a over the null terminated name beginning at the offset
+size_t UniqueNames::NameHash::operator()(const uint32_t offset) const {
+  size_t hash = 14695981039346656037ULL;
+  for (const char* c = arena->data() + offset; *c != '\0'; ++c) {
+    hash = (hash ^ static_cast<unsigned char>(*c)) * 1099511628211ULL;
+  }
+  return hash;
+}
+
+bool UniqueNames::NameEqual::operator()(const uint32_t lhs, const uint32_t rhs) const {
+  return std::strcmp(arena->data() + lhs, arena->data() + rhs) == 0;
+}
+
 // Constructor
-UniqueNames::UniqueNames() {
+UniqueNames::UniqueNames()
+    : arena_(new std::vector<char>()), names_(0, NameHash{arena_.get()}, NameEqual{arena_.get()}) {
   // Insert dummy so index 0 is never used
   index("");
 }
@@ -14,35 +30,38 @@ UniqueNames::UniqueNames() {
 // Get an index given a name. Add the name if it is not in the current list
 // of unique names
 uint32_t UniqueNames::index(const std::string& name) {
-  // Find the name in the map. If it is there return the index.
-  uint32_t index = 0;
-  auto it = names_.find(name);
+  // Tentatively append the name to the arena so the map functors can see it
+  // and look it up. If it was already there truncate the append back off
+  uint32_t offset = static_cast<uint32_t>(arena_->size());
+  arena_->insert(arena_->end(), name.c_str(), name.c_str() + name.size() + 1);
+  auto it = names_.find(offset);
   if (it != names_.end()) {
-    index = it->second;
-  } else {
-    // Not in the map, add index and update
-    it = names_.insert(it, NamesMap::value_type(name, 0));
-    indexes_.push_back(it);
-    index = indexes_.size() - 1;
-    it->second = index;
+    arena_->resize(offset);
+    return it->second;
   }
+
+  // Not in the map, add index and update
+  indexes_.push_back(offset);
+  uint32_t index = static_cast<uint32_t>(indexes_.size() - 1);
+  names_.emplace(offset, index);
   return index;
 }
 
 // Get the name given the index
-const std::string& UniqueNames::name(const uint32_t index) const {
+std::string UniqueNames::name(const uint32_t index) const {
   if (index < (uint32_t)indexes_.size()) {
-    return indexes_[index]->first;
+    return std::string(arena_->data() + indexes_[index]);
   }
 
   // Return the empty string in the index 0 location
-  return indexes_[0]->first;
+  return std::string(arena_->data() + indexes_[0]);
 }
 
 // Clear the unique names list
 void UniqueNames::Clear() {
   names_.clear();
   indexes_.clear();
+  arena_->clear();
 }
 
 // Get the number of unique names. Since a blank name is added as the first
@@ -57,6 +76,7 @@ size_t UniqueNames::Size() const {
 void UniqueNames::Log() const {
   LOG_DEBUG("Number of names: " + std::to_string(Size()));
   LOG_DEBUG("Number of indexes: " + std::to_string(indexes_.size()));
+  LOG_DEBUG("Arena bytes: " + std::to_string(arena_->size()));
 }
 
 } // namespace mjolnir
@@ -9,6 +9,7 @@
 #include "mjolnir/graphbuilder.h"
 #include "mjolnir/graphenhancer.h"
 #include "mjolnir/graphfilter.h"
+#include "mjolnir/graphtilebuilder.h"
 #include "mjolnir/graphvalidator.h"
 #include "mjolnir/hierarchybuilder.h"
 #include "mjolnir/osmpbfparser.h"
@@ -22,9 +23,101 @@
 #include <boost/filesystem/operations.hpp>
 #include <boost/property_tree/ptree.hpp>
 
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <sys/resource.h>
+#include <thread>
+#include <unordered_set>
+
+namespace {
+
+// Name of the checkpoint manifest kept in the tile directory while a
+// checkpointed build is in flight
+constexpr const char* kCheckpointManifest = ".build_checkpoint";
+
+// Read the names of the completed stages from the checkpoint manifest.
+// Each line holds the stage name followed by its timing information
+std::unordered_set<std::string> ReadCheckpoint(const std::string& manifest) {
+  std::unordered_set<std::string> completed;
+  std::ifstream file(manifest);
+  std::string line;
+  while (std::getline(file, line)) {
+    auto pos = line.find(' ');
+    completed.emplace(line.substr(0, pos));
+  }
+  return completed;
+}
+
+// Run one build stage unless it already completed. Times the stage, logs
+// the duration along with the peak rss so far, and appends a line to the
+// manifest so a restarted build can pick up at the failed stage
+void RunStage(const std::string& stage,
+              const bool skip,
+              const std::string& manifest,
+              const std::function<void()>& work) {
+  if (skip) {
+    LOG_INFO("Skipping " + stage + " stage, already completed in a previous run");
+    return;
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  work();
+  auto secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  // Peak rss is cumulative over the process but still shows which stage
+  // pushed it up
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  auto peak_mb = usage.ru_maxrss / 1024;
+  LOG_INFO(stage + " stage took " + std::to_string(secs) + " seconds, peak rss " +
+           std::to_string(peak_mb) + "MB");
+
+  if (!manifest.empty()) {
+    std::ofstream file(manifest, std::ios::app);
+    file << stage << ' ' << secs << ' ' << peak_mb << std::endl;
+  }
+}
+
+// Block until the shared manifest records every named stage. This is the
+// only coordination between the hosts of a distributed build: the host
+// responsible for a stage appends its line when the stage lands and the
+// hosts that depend on it poll for the line to appear
+void WaitForStages(const std::string& manifest, const std::vector<std::string>& stages) {
+  bool logged = false;
+  while (true) {
+    auto completed = ReadCheckpoint(manifest);
+    auto missing = std::find_if(stages.begin(), stages.end(), [&completed](const std::string& s) {
+      return completed.count(s) == 0;
+    });
+    if (missing == stages.end()) {
+      return;
+    }
+    if (!logged) {
+      LOG_INFO("Waiting for the " + *missing + " stage to be recorded in " + manifest);
+      logged = true;
+    }
+    std::this_thread::sleep_for(std::chrono::seconds(10));
+  }
+}
+
+} // namespace
+
 namespace valhalla {
 namespace mjolnir {
 
+tile_shard_t::tile_shard_t(const boost::property_tree::ptree& config)
+    : count(config.get<uint32_t>("shard_count", 1)), index(config.get<uint32_t>("shard_index", 0)) {
+  if (count == 0 || index >= count) {
+    throw std::runtime_error("shard_index must name one of the shard_count shards");
+  }
+}
+
+bool tile_shard_t::contains(const baldr::GraphId& tile_id) const {
+  return tile_id.tileid() % count == index;
+}
+
 /**
  * Splits a tag into a vector of strings.  Delim defaults to ;
  */
@@ -119,68 +212,153 @@ void build_tile_set(const boost::property_tree::ptree& config,
     throw std::runtime_error("Tiles cannot be directly built into a tar extract");
   }
 
-  // set up the directories and purge old tiles
   auto tile_dir = config.get<std::string>("mjolnir.tile_dir");
-  for (const auto& level : valhalla::baldr::TileHierarchy::levels()) {
-    auto level_dir = tile_dir + filesystem::path::preferred_separator + std::to_string(level.first);
+
+  // optionally mirror the hot directed edge fields into per tile SoA
+  // arrays for the dense matrix/isochrone scans. Set before any tiles are
+  // written so every stage (and level) carries the section
+  GraphTileBuilder::set_include_edge_soa(config.get<bool>("mjolnir.include_edge_soa", false));
+
+  // In a distributed build several hosts share the tile directory (and the
+  // sequence intermediates, if their paths point at shared storage). The
+  // tile parallel stages run on every host over disjoint shards of the tile
+  // set while the rest run on shard 0 alone, with the manifest as the job
+  // queue: each host appends a line as its stage lands and blocks on the
+  // lines of the stages it depends on
+  tile_shard_t shard(config.get_child("mjolnir"));
+  const bool distributed = shard.count > 1;
+  if (distributed && !config.get<bool>("mjolnir.checkpoint", false)) {
+    throw std::runtime_error(
+        "A distributed build requires mjolnir.checkpoint so the shards can coordinate "
+        "through the shared manifest");
+  }
+
+  // When checkpointing is enabled and a manifest from an earlier run is
+  // present, skip the stages it records as complete and keep the tiles
+  // those stages already wrote. A failed stage re-runs from its start
+  auto manifest =
+      tile_dir + filesystem::path::preferred_separator + std::string(kCheckpointManifest);
+  std::unordered_set<std::string> completed;
+  if (config.get<bool>("mjolnir.checkpoint", false)) {
+    if (boost::filesystem::exists(manifest)) {
+      completed = ReadCheckpoint(manifest);
+      LOG_INFO("Resuming tile build from checkpoint manifest " + manifest);
+    }
+  } else {
+    manifest = "";
+  }
+
+  // set up the directories and purge old tiles unless we are resuming.
+  // Shards other than 0 never purge - they expect shard 0 to have prepared
+  // the shared tile directory
+  if (completed.empty() && shard.index == 0) {
+    for (const auto& level : valhalla::baldr::TileHierarchy::levels()) {
+      auto level_dir =
+          tile_dir + filesystem::path::preferred_separator + std::to_string(level.first);
+      if (boost::filesystem::exists(level_dir) && !boost::filesystem::is_empty(level_dir)) {
+        LOG_WARN("Non-empty " + level_dir + " will be purged of tiles");
+        boost::filesystem::remove_all(level_dir);
+      }
+    }
+
+    // check for transit level.
+    auto level_dir =
+        tile_dir + filesystem::path::preferred_separator +
+        std::to_string(valhalla::baldr::TileHierarchy::levels().rbegin()->second.level + 1);
     if (boost::filesystem::exists(level_dir) && !boost::filesystem::is_empty(level_dir)) {
       LOG_WARN("Non-empty " + level_dir + " will be purged of tiles");
       boost::filesystem::remove_all(level_dir);
     }
-  }
 
-  // check for transit level.
-  auto level_dir =
-      tile_dir + filesystem::path::preferred_separator +
-      std::to_string(valhalla::baldr::TileHierarchy::levels().rbegin()->second.level + 1);
-  if (boost::filesystem::exists(level_dir) && !boost::filesystem::is_empty(level_dir)) {
-    LOG_WARN("Non-empty " + level_dir + " will be purged of tiles");
-    boost::filesystem::remove_all(level_dir);
+    boost::filesystem::create_directories(tile_dir);
+    if (!manifest.empty() && boost::filesystem::exists(manifest)) {
+      boost::filesystem::remove(manifest);
+    }
   }
 
-  boost::filesystem::create_directories(tile_dir);
-
   // Read the OSM protocol buffer file. Callbacks for nodes, ways, and
-  // relations are defined within the PBFParser class
-  auto osm_data =
-      PBFGraphParser::Parse(config.get_child("mjolnir"), input_files, bin_file_prefix + "ways.bin",
-                            bin_file_prefix + "way_nodes.bin", bin_file_prefix + "access.bin",
-                            bin_file_prefix + "complex_from_restrictions.bin",
-                            bin_file_prefix + "complex_to_restrictions.bin");
+  // relations are defined within the PBFParser class. The parse result
+  // only lives in memory so the parse stage must re-run when the build
+  // stage has not completed yet - only skip it once build has
+  // Run a stage that needs the whole graph on shard 0, or block until the
+  // manifest records that shard 0 finished it
+  auto single_host_stage = [&](const std::string& stage, const std::function<void()>& work) {
+    if (shard.index == 0) {
+      RunStage(stage, completed.count(stage) != 0, manifest, work);
+    } else {
+      WaitForStages(manifest, {stage});
+    }
+  };
 
-  // Optionally free all protobuf memory but also you cant use the protobuffer lib after this!
-  if (free_protobuf) {
-    OSMPBF::Parser::free();
-  }
+  // Run this host's shard of a tile parallel stage, then block until every
+  // shard of it has landed so the next single host stage sees all the tiles
+  auto sharded_stage = [&](const std::string& stage, const std::function<void()>& work) {
+    auto name = distributed ? stage + "#" + std::to_string(shard.index) : stage;
+    RunStage(name, completed.count(name) != 0, manifest, work);
+    if (distributed) {
+      std::vector<std::string> shards;
+      for (uint32_t i = 0; i < shard.count; ++i) {
+        shards.push_back(stage + "#" + std::to_string(i));
+      }
+      WaitForStages(manifest, shards);
+    }
+  };
 
-  // Build the graph using the OSMNodes and OSMWays from the parser
-  GraphBuilder::Build(config, osm_data, bin_file_prefix + "ways.bin",
-                      bin_file_prefix + "way_nodes.bin",
-                      bin_file_prefix + "complex_from_restrictions.bin",
-                      bin_file_prefix + "complex_to_restrictions.bin");
+  OSMData osm_data;
+  if (shard.index != 0) {
+    WaitForStages(manifest, {"build"});
+  } else if (!completed.count("build")) {
+    RunStage("parse", false, manifest, [&]() {
+      osm_data = PBFGraphParser::Parse(config.get_child("mjolnir"), input_files,
+                                       bin_file_prefix + "ways.bin",
+                                       bin_file_prefix + "way_nodes.bin",
+                                       bin_file_prefix + "access.bin",
+                                       bin_file_prefix + "complex_from_restrictions.bin",
+                                       bin_file_prefix + "complex_to_restrictions.bin");
+    });
+
+    // Optionally free all protobuf memory but also you cant use the protobuffer lib after this!
+    if (free_protobuf) {
+      OSMPBF::Parser::free();
+    }
+
+    // Build the graph using the OSMNodes and OSMWays from the parser
+    RunStage("build", false, manifest, [&]() {
+      GraphBuilder::Build(config, osm_data, bin_file_prefix + "ways.bin",
+                          bin_file_prefix + "way_nodes.bin",
+                          bin_file_prefix + "complex_from_restrictions.bin",
+                          bin_file_prefix + "complex_to_restrictions.bin");
+    });
+  } else {
+    LOG_INFO("Skipping parse and build stages, already completed in a previous run");
+  }
 
   // Enhance the local level of the graph. This adds information to the local
   // level that is usable across all levels (density, administrative
   // information (and country based attribution), edge transition logic, etc.
-  GraphEnhancer::Enhance(config, bin_file_prefix + "access.bin");
+  // Enhancement writes each tile in place so the shards can split the tile
+  // set between them
+  sharded_stage("enhance",
+                [&]() { GraphEnhancer::Enhance(config, bin_file_prefix + "access.bin"); });
 
   // Perform optional edge filtering (remove edges and nodes for specific access modes)
-  GraphFilter::Filter(config);
+  single_host_stage("filter", [&]() { GraphFilter::Filter(config); });
 
   // Add transit
-  TransitBuilder::Build(config);
+  single_host_stage("transit", [&]() { TransitBuilder::Build(config); });
 
   // Builds additional hierarchies if specified within config file. Connections
   // (directed edges) are formed between nodes at adjacent levels.
   auto build_hierarchy = config.get<bool>("mjolnir.hierarchy", true);
   if (build_hierarchy) {
-    HierarchyBuilder::Build(config);
+    single_host_stage("hierarchy", [&]() { HierarchyBuilder::Build(config); });
 
     // Build shortcuts if specified in the config file. Shortcuts can only be
-    // applied if hierarchies are also generated.
+    // applied if hierarchies are also generated. Each tile's shortcuts are
+    // rebuilt into that tile alone so this stage shards as well
     auto build_shortcuts = config.get<bool>("mjolnir.shortcuts", true);
     if (build_shortcuts) {
-      ShortcutBuilder::Build(config);
+      sharded_stage("shortcuts", [&]() { ShortcutBuilder::Build(config); });
     } else {
       LOG_INFO("Skipping shortcut builder");
     }
@@ -188,13 +366,28 @@ void build_tile_set(const boost::property_tree::ptree& config,
     LOG_INFO("Skipping hierarchy builder and shortcut builder");
   }
 
+  // The stitching stages that remain run on shard 0 alone; the other hosts
+  // are done once their slice of the tiles has landed
+  if (shard.index != 0) {
+    return;
+  }
+
   // Build the Complex Restrictions
-  RestrictionBuilder::Build(config, bin_file_prefix + "complex_from_restrictions.bin",
-                            "complex_to_restrictions.bin");
+  RunStage("restrictions", completed.count("restrictions"), manifest, [&]() {
+    RestrictionBuilder::Build(config, bin_file_prefix + "complex_from_restrictions.bin",
+                              "complex_to_restrictions.bin");
+  });
 
   // Validate the graph and add information that cannot be added until
   // full graph is formed.
-  GraphValidator::Validate(config);
+  RunStage("validate", completed.count("validate"), manifest,
+           [&]() { GraphValidator::Validate(config); });
+
+  // The build made it all the way through - the manifest only matters for
+  // picking up a partial build so drop it
+  if (!manifest.empty() && boost::filesystem::exists(manifest)) {
+    boost::filesystem::remove(manifest);
+  }
 }
 
 } // namespace mjolnir
@@ -50,6 +50,8 @@ using namespace valhalla::baldr;
 #include <ostream>
 
 #include "midgard/logging.h"
+#include "midgard/pointll.h"
+#include "midgard/sequence.h"
 
 namespace bpo = boost::program_options;
 using namespace valhalla::midgard;
@@ -138,6 +140,14 @@ int polygondata_comparearea(const void* vp1, const void* vp2) {
   }
   return 1;
 }
+
+// The way shape file is sorted by way id then shape node index
+const auto WayNodeLess = [](const OSMWayNode& a, const OSMWayNode& b) {
+  if (a.way_index == b.way_index) {
+    return a.way_shape_node_index < b.way_shape_node_index;
+  }
+  return a.way_index < b.way_index;
+};
 } // anonymous namespace
 
 std::vector<std::string> GetWkts(std::unique_ptr<Geometry>& mline) {
@@ -259,13 +269,6 @@ std::vector<std::string> GetWkts(std::unique_ptr<Geometry>& mline) {
 void BuildAdminFromPBF(const boost::property_tree::ptree& pt,
                        const std::vector<std::string>& input_files) {
 
-  // Read the OSM protocol buffer file. Callbacks for nodes, ways, and
-  // relations are defined within the PBFParser class
-  OSMData osmdata = PBFAdminParser::Parse(pt, input_files);
-
-  // done with the protobuffer library, cant use it again after this
-  OSMPBF::Parser::free();
-
   // Bail if bad path
   auto database = pt.get_optional<std::string>("admin");
 
@@ -287,6 +290,18 @@ void BuildAdminFromPBF(const boost::property_tree::ptree& pt,
     boost::filesystem::remove(*database);
   }
 
+  // The member way shapes are streamed to a disk backed file next to the
+  // database so a planet admin build keeps a bounded working set
+  std::string way_nodes_file =
+      (boost::filesystem::path(*database).parent_path() / "admin_way_nodes.bin").string();
+
+  // Read the OSM protocol buffer file. Callbacks for nodes, ways, and
+  // relations are defined within the PBFParser class
+  OSMData osmdata = PBFAdminParser::Parse(pt, input_files, way_nodes_file);
+
+  // done with the protobuffer library, cant use it again after this
+  OSMPBF::Parser::free();
+
   spatialite_init(0);
 
   sqlite3* db_handle;
@@ -430,6 +445,11 @@ void BuildAdminFromPBF(const boost::property_tree::ptree& pt,
 
   try {
 
+    // The way shapes were sorted by way id and shape node index so each
+    // member way is a binary search and a sequential read; only one way's
+    // coordinates are in memory at a time
+    sequence<OSMWayNode> way_nodes(way_nodes_file, false, true);
+
     for (const auto& admin : osmdata.admins_) {
 
       std::unique_ptr<Geometry> geom;
@@ -438,27 +458,38 @@ void BuildAdminFromPBF(const boost::property_tree::ptree& pt,
 
       for (const auto memberid : admin.ways()) {
 
-        auto itr = osmdata.way_map.find(memberid);
+        auto way_node_itr = way_nodes.find({{}, memberid, 0}, WayNodeLess);
 
         // A relation may be included in an extract but it's members may not.
         // Example:  PA extract can contain a NY relation.
-        if (itr == osmdata.way_map.end()) {
+        if (way_node_itr == way_nodes.end()) {
           has_data = false;
           break;
         }
 
         std::unique_ptr<CoordinateSequence> coords(
             gf->getCoordinateSequenceFactory()->create((size_t)0, (size_t)2));
-        size_t j = 0;
 
-        for (const auto ref_id : itr->second) {
-
-          const PointLL ll = osmdata.shape_map.at(ref_id);
+        // Walk this way's shape. A node that was clipped out of the extract
+        // never had its coordinate filled in, in which case the geometry
+        // cannot be assembled
+        OSMWayNode way_node;
+        while (way_node_itr != way_nodes.end() &&
+               (way_node = *way_node_itr).way_index == memberid) {
+          const PointLL ll(way_node.node.lng, way_node.node.lat);
+          if (!ll.IsValid()) {
+            has_data = false;
+            break;
+          }
 
           Coordinate c;
           c.x = ll.lng();
           c.y = ll.lat();
           coords->add(c, 0);
+          ++way_node_itr;
+        }
+        if (!has_data) {
+          break;
         }
 
         if (coords->getSize() > 1) {
@@ -648,6 +679,9 @@ void BuildAdminFromPBF(const boost::property_tree::ptree& pt,
 
   sqlite3_close(db_handle);
 
+  // done with the way shapes
+  boost::filesystem::remove(way_nodes_file);
+
   LOG_INFO("Finished.");
 }
 
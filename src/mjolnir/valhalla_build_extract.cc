@@ -0,0 +1,179 @@
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "baldr/graphreader.h"
+#include "baldr/graphtile.h"
+#include "config.h"
+#include "filesystem.h"
+#include "midgard/logging.h"
+#include "midgard/sequence.h"
+
+#include "baldr/rapidjson_utils.h"
+#include <boost/filesystem/operations.hpp>
+#include <boost/program_options.hpp>
+#include <boost/property_tree/ptree.hpp>
+
+namespace bpo = boost::program_options;
+using namespace valhalla::baldr;
+using namespace valhalla::midgard;
+
+namespace {
+
+boost::filesystem::path config_file_path;
+std::string extract_file;
+
+// tar blocks are fixed size and archive entries are padded out to block size
+constexpr size_t BLOCK_SIZE = sizeof(tar::header_t);
+static_assert(sizeof(tar::header_t) == 512, "tar header must be exactly one block");
+
+// write a number into one of the fixed width octal fields of a tar header
+void octal_field(char* dst, size_t size, uint64_t value) {
+  // leave room for the terminating NUL the format requires
+  snprintf(dst, size, "%0*llo", static_cast<int>(size - 1),
+           static_cast<unsigned long long>(value));
+}
+
+// fill out a ustar header for a regular file of the given name and size
+tar::header_t make_header(const std::string& name, size_t file_size, time_t mtime) {
+  tar::header_t header{};
+  strncpy(header.name, name.c_str(), sizeof(header.name) - 1);
+  octal_field(header.mode, sizeof(header.mode), 0644);
+  octal_field(header.uid, sizeof(header.uid), 0);
+  octal_field(header.gid, sizeof(header.gid), 0);
+  octal_field(header.size, sizeof(header.size), file_size);
+  octal_field(header.mtime, sizeof(header.mtime), mtime);
+  header.typeflag = '0';
+  memcpy(header.magic, "ustar", 6);
+  memcpy(header.version, "00", 2);
+
+  // the checksum is computed with the checksum field itself filled with spaces
+  memset(header.chksum, ' ', sizeof(header.chksum));
+  uint64_t sum = 0;
+  for (size_t i = 0; i < sizeof(tar::header_t); ++i) {
+    sum += reinterpret_cast<const unsigned char*>(&header)[i];
+  }
+  snprintf(header.chksum, sizeof(header.chksum), "%06llo", static_cast<unsigned long long>(sum));
+  header.chksum[7] = ' ';
+  return header;
+}
+
+bool ParseArguments(int argc, char* argv[]) {
+  bpo::options_description options(
+      "valhalla_build_extract " VALHALLA_VERSION "\n"
+      "\n"
+      " Usage: valhalla_build_extract [options]\n"
+      "\n"
+      "valhalla_build_extract packs an existing tile directory into a single "
+      "tar extract that the graph reader can mmap at startup, avoiding the "
+      "per-tile open/stat cost of the loose tile tree."
+      "\n"
+      "\n");
+
+  options.add_options()("help,h", "Print this help message.")(
+      "version,v", "Print the version of this software.")(
+      "config,c",
+      boost::program_options::value<boost::filesystem::path>(&config_file_path)->required(),
+      "Path to the json configuration file.")(
+      "extract,e", boost::program_options::value<std::string>(&extract_file),
+      "Path of the tar extract to write. Defaults to mjolnir.tile_extract from the config.");
+
+  bpo::variables_map vm;
+  try {
+    bpo::store(bpo::command_line_parser(argc, argv).options(options).run(), vm);
+    bpo::notify(vm);
+  } catch (std::exception& e) {
+    std::cerr << "Unable to parse command line options because: " << e.what() << "\n"
+              << "This is a bug, please report it at " PACKAGE_BUGREPORT << "\n";
+    return false;
+  }
+
+  if (vm.count("help")) {
+    std::cout << options << "\n";
+    return true;
+  }
+
+  if (vm.count("version")) {
+    std::cout << "valhalla_build_extract " << VALHALLA_VERSION << "\n";
+    return true;
+  }
+
+  if (vm.count("config")) {
+    if (boost::filesystem::is_regular_file(config_file_path)) {
+      return true;
+    } else {
+      std::cerr << "Configuration file is required\n\n" << options << "\n\n";
+    }
+  }
+
+  return false;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  if (!ParseArguments(argc, argv)) {
+    return EXIT_FAILURE;
+  }
+
+  // Get the tile directory and default extract location from the config
+  boost::property_tree::ptree pt;
+  rapidjson::read_json(config_file_path.c_str(), pt);
+  std::string tile_dir = pt.get<std::string>("mjolnir.tile_dir");
+  if (extract_file.empty()) {
+    extract_file = pt.get<std::string>("mjolnir.tile_extract", "");
+  }
+  if (extract_file.empty()) {
+    LOG_ERROR("No extract path given and no mjolnir.tile_extract in the config");
+    return EXIT_FAILURE;
+  }
+
+  // Use the reader to enumerate the tiles actually on disk. The reader is
+  // pointed at the loose tile tree, not at any preexisting extract
+  boost::property_tree::ptree reader_pt = pt.get_child("mjolnir");
+  reader_pt.erase("tile_extract");
+  GraphReader reader(reader_pt);
+
+  std::ofstream tar_file(extract_file, std::ios::binary | std::ios::trunc);
+  if (!tar_file.is_open()) {
+    LOG_ERROR("Could not open " + extract_file + " for writing");
+    return EXIT_FAILURE;
+  }
+
+  // Concatenate every tile, each preceded by its tar header and padded out
+  // to block size so mmapped tile starts stay block aligned
+  size_t tile_count = 0;
+  std::vector<char> padding(BLOCK_SIZE, 0);
+  for (const auto& tile_id : reader.GetTileSet()) {
+    std::string suffix = GraphTile::FileSuffix(tile_id);
+    std::string file_location = tile_dir + filesystem::path::preferred_separator + suffix;
+    std::ifstream file(file_location, std::ios::in | std::ios::binary | std::ios::ate);
+    if (!file.is_open()) {
+      LOG_WARN("Could not open tile " + file_location);
+      continue;
+    }
+    size_t file_size = file.tellg();
+    file.seekg(0, std::ios::beg);
+    std::vector<char> contents(file_size);
+    file.read(contents.data(), file_size);
+
+    auto header = make_header(suffix, file_size, time(nullptr));
+    tar_file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    tar_file.write(contents.data(), file_size);
+    if (file_size % BLOCK_SIZE) {
+      tar_file.write(padding.data(), BLOCK_SIZE - (file_size % BLOCK_SIZE));
+    }
+    ++tile_count;
+  }
+
+  // Most tars end with two empty blocks
+  tar_file.write(padding.data(), padding.size());
+  tar_file.write(padding.data(), padding.size());
+  tar_file.close();
+
+  LOG_INFO("Wrote " + std::to_string(tile_count) + " tiles to " + extract_file);
+  return EXIT_SUCCESS;
+}
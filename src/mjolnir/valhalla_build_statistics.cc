@@ -22,6 +22,7 @@
 #include "baldr/graphconstants.h"
 #include "baldr/graphid.h"
 #include "baldr/graphreader.h"
+#include "mjolnir/graphtilebuilder.h"
 #include "baldr/nodeinfo.h"
 #include "baldr/tilehierarchy.h"
 #include "midgard/aabb2.h"
@@ -409,10 +410,18 @@ void build(const boost::property_tree::ptree& pt,
     float roadlength = 0.0f;
     uint32_t nodecount = tile->header()->nodecount();
     GraphId node = tile_id;
+
+    // Per tile routing statistics destined for the tile header - edge
+    // counts by road class and the node densities for the percentiles
+    uint32_t class_counts[8] = {};
+    std::vector<uint8_t> node_densities;
+    node_densities.reserve(nodecount);
+
     for (uint64_t i = 0; i < nodecount; i++, ++node) {
       // The node we will modify
       const NodeInfo* nodeinfo = tile->node(node);
       std::string begin_node_iso = tile->admin(nodeinfo->admin_index())->country_iso();
+      node_densities.push_back(nodeinfo->density());
 
       // Go through directed edges
       uint32_t idx = nodeinfo->edge_index();
@@ -465,6 +474,7 @@ void build(const boost::property_tree::ptree& pt,
         }
         // The edge we will modify
         const DirectedEdge* directededge = tile->directededge(nodeinfo->edge_index() + j);
+        class_counts[static_cast<uint32_t>(directededge->classification()) & 0x7]++;
 
         // Road Length and some variables for statistics
         float edge_length;
@@ -491,6 +501,26 @@ void build(const boost::property_tree::ptree& pt,
     stats.add_tile_area(tileid, area);
     stats.add_tile_geom(tileid, tiles.TileBounds(tileid));
 
+    // Write the computed statistics back into the tile header spare words
+    // so thor can read them at request time. Transit tiles are skipped -
+    // the tile builder only handles the routing levels
+    if (level <= TileHierarchy::levels().rbegin()->second.level && nodecount > 0) {
+      GraphTileBuilder tilebuilder(graph_reader.tile_dir(), tile_id, true);
+      auto& header = tilebuilder.header_builder();
+      uint32_t total_edges = tile->header()->directededgecount();
+      for (uint32_t rc = 0; rc < 8; rc++) {
+        header.set_edge_class_percent(rc, total_edges ? class_counts[rc] * 100 / total_edges : 0);
+      }
+      std::sort(node_densities.begin(), node_densities.end());
+      header.set_node_density_p50(node_densities[node_densities.size() / 2]);
+      header.set_node_density_p90(node_densities[(node_densities.size() * 9) / 10]);
+      header.set_branching_factor(static_cast<float>(total_edges) / nodecount);
+      header.set_has_stats(true);
+      lock.lock();
+      tilebuilder.StoreTileData();
+      lock.unlock();
+    }
+
     // Check if we need to clear the tile cache
     lock.lock();
     if (graph_reader.OverCommitted()) {
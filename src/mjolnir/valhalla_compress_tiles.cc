@@ -0,0 +1,195 @@
+#include <cstdint>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "config.h"
+
+#include "baldr/rapidjson_utils.h"
+#include <boost/filesystem/operations.hpp>
+#include <boost/program_options.hpp>
+#include <boost/property_tree/ptree.hpp>
+#include <iostream>
+
+#include "baldr/compression_utils.h"
+#include "baldr/graphid.h"
+#include "baldr/graphreader.h"
+#include "baldr/graphtile.h"
+#include "midgard/logging.h"
+
+namespace bpo = boost::program_options;
+
+using namespace valhalla::baldr;
+
+boost::filesystem::path config_file_path;
+bool remove_flat = false;
+
+bool ParseArguments(int argc, char* argv[]) {
+
+  bpo::options_description options(
+      "compress_tiles " VALHALLA_VERSION "\n"
+      "\n"
+      " Usage: compress_tiles [options]\n"
+      "\n"
+      "compress_tiles rewrites the flat graph tiles in the tile directory "
+      "into the sectioned compressed format (.gzs). Each tile section is "
+      "deflated as its own block so a reader only inflates the sections a "
+      "request actually touches."
+      "\n"
+      "\n");
+
+  options.add_options()("help,h", "Print this help message.")(
+      "version,v", "Print the version of this software.")(
+      "config,c",
+      boost::program_options::value<boost::filesystem::path>(&config_file_path)->required(),
+      "Path to the json configuration file.")(
+      "remove,r", bpo::bool_switch(&remove_flat),
+      "Remove each flat tile file once its compressed version is written.");
+
+  bpo::variables_map vm;
+  try {
+    bpo::store(bpo::command_line_parser(argc, argv).options(options).run(), vm);
+    bpo::notify(vm);
+
+  } catch (std::exception& e) {
+    std::cerr << "Unable to parse command line options because: " << e.what() << "\n"
+              << "This is a bug, please report it at " PACKAGE_BUGREPORT << "\n";
+    return false;
+  }
+
+  if (vm.count("help")) {
+    std::cout << options << "\n";
+    return true;
+  }
+
+  if (vm.count("version")) {
+    std::cout << "compress_tiles " << VALHALLA_VERSION << "\n";
+    return true;
+  }
+
+  if (vm.count("config")) {
+    if (boost::filesystem::is_regular_file(config_file_path)) {
+      return true;
+    } else {
+      std::cerr << "Configuration file is required\n\n" << options << "\n\n";
+    }
+  }
+
+  return false;
+}
+
+// Deflate one raw range of a tile onto the end of the blocks buffer.
+// Returns the size of the deflated block
+uint64_t DeflateSection(const char* bytes, const uint64_t size, std::vector<char>& blocks) {
+  const auto start = blocks.size();
+  constexpr size_t chunk = 16384;
+  uint64_t written = 0;
+
+  // the whole section is in memory so hand it over in one go
+  auto src_func = [&](z_stream& s) -> int {
+    s.next_in = static_cast<Byte*>(static_cast<void*>(const_cast<char*>(bytes)));
+    s.avail_in = static_cast<unsigned int>(size);
+    return Z_FINISH;
+  };
+
+  // grow the block buffer a chunk at a time as output lands
+  auto dst_func = [&](z_stream& s) -> void {
+    written = s.total_out;
+    blocks.resize(start + written + chunk);
+    s.next_out = static_cast<Byte*>(static_cast<void*>(blocks.data() + start + written));
+    s.avail_out = chunk;
+  };
+
+  if (!valhalla::baldr::deflate(src_func, dst_func)) {
+    throw std::runtime_error("Could not deflate a tile section");
+  }
+
+  // drop the unused tail of the last chunk
+  blocks.resize(start + written);
+  return written;
+}
+
+// Main application to rewrite flat graph tiles as sectioned compressed
+// tiles. The section boundaries come from the offsets in each tile's
+// header and must match the lazy section mapping in GraphTile.
+int main(int argc, char** argv) {
+  // Parse command line arguments
+  if (!ParseArguments(argc, argv)) {
+    return EXIT_FAILURE;
+  }
+
+  // Get the config to find the tiles
+  boost::property_tree::ptree pt;
+  rapidjson::read_json(config_file_path.c_str(), pt);
+  GraphReader reader(pt.get_child("mjolnir"));
+  auto tile_dir = pt.get<std::string>("mjolnir.tile_dir");
+
+  size_t compressed_count = 0;
+  uint64_t raw_bytes = 0, comp_bytes = 0;
+  for (const auto& tile_id : reader.GetTileSet()) {
+    // only flat files need rewriting, anything already compressed is skipped
+    auto file_name = tile_dir + '/' + GraphTile::FileSuffix(tile_id);
+    std::ifstream file(file_name, std::ios::in | std::ios::binary | std::ios::ate);
+    if (!file.is_open()) {
+      continue;
+    }
+    std::vector<char> bytes(file.tellg());
+    file.seekg(0, std::ios::beg);
+    file.read(bytes.data(), bytes.size());
+    file.close();
+
+    // fix a tile up over the bytes to get at the offsets in its header
+    GraphTile tile(tile_id, bytes.data(), bytes.size());
+    const auto* header = tile.header();
+    if (!header) {
+      LOG_WARN("Skipping unreadable tile: " + file_name);
+      continue;
+    }
+
+    // section boundaries, the order matches GraphTile::TileSection
+    const auto bounds = GraphTile::SectionBounds(*header, bytes.size());
+    bool sane = true;
+    for (size_t i = 0; i < GraphTile::kSectionCount; ++i) {
+      sane = sane && bounds[i] <= bounds[i + 1];
+    }
+    if (!sane) {
+      LOG_WARN("Skipping tile with out of order section offsets: " + file_name);
+      continue;
+    }
+
+    // deflate each section into its own block
+    GraphTile::SectionRecord records[GraphTile::kSectionCount];
+    std::vector<char> blocks;
+    for (size_t i = 0; i < GraphTile::kSectionCount; ++i) {
+      records[i].raw_offset = bounds[i];
+      records[i].raw_size = bounds[i + 1] - bounds[i];
+      records[i].comp_size = DeflateSection(bytes.data() + bounds[i], records[i].raw_size, blocks);
+    }
+
+    // front matter, section table, then the blocks back to back
+    std::ofstream out(file_name + ".gzs", std::ios::out | std::ios::binary | std::ios::trunc);
+    const uint32_t front[4] = {GraphTile::kSectionedTileMagic, GraphTile::kSectionedTileVersion,
+                               GraphTile::kSectionCount, 0};
+    out.write(reinterpret_cast<const char*>(front), sizeof(front));
+    out.write(reinterpret_cast<const char*>(records), sizeof(records));
+    out.write(blocks.data(), blocks.size());
+    if (!out) {
+      LOG_ERROR("Could not write: " + file_name + ".gzs");
+      return EXIT_FAILURE;
+    }
+    out.close();
+
+    raw_bytes += bytes.size();
+    comp_bytes += sizeof(front) + sizeof(records) + blocks.size();
+    ++compressed_count;
+    if (remove_flat) {
+      boost::filesystem::remove(file_name);
+    }
+  }
+
+  LOG_INFO("Compressed " + std::to_string(compressed_count) + " tiles, " +
+           std::to_string(raw_bytes) + " bytes into " + std::to_string(comp_bytes));
+
+  return EXIT_SUCCESS;
+}
@@ -938,6 +938,60 @@ void AddToGraph(GraphTileBuilder& tilebuilder_transit,
            " nodes. time = " + std::to_string(msecs) + " ms");
 }
 
+// Collapse regular runs of fixed departures into frequency records. A run of
+// departures on the same line whose trip attributes all match and whose headway
+// is constant behaves exactly like a GTFS frequency entry, which every schedule
+// lookup already handles, so storing the run as one record shrinks the
+// departure table and lets the next departure search stop at a single entry.
+// Departures that break the pattern are kept as fixed records. Runs have to be
+// long enough to be worth the trade of per trip ids for one representative id
+uint32_t CollapseHeadwayRuns(std::vector<TransitDeparture>& departures,
+                             GraphTileBuilder& tilebuilder) {
+  constexpr size_t kMinHeadwayRun = 4;
+  std::sort(departures.begin(), departures.end());
+  uint32_t collapsed = 0;
+  for (size_t begin = 0; begin < departures.size();) {
+    const auto& first = departures[begin];
+    // extend the run while the headway holds and the trip attributes match
+    size_t end = begin + 1;
+    uint32_t headway = 0;
+    while (end < departures.size()) {
+      const auto& prev = departures[end - 1];
+      const auto& next = departures[end];
+      uint32_t gap = next.departure_time() - prev.departure_time();
+      if (next.lineid() != first.lineid() || next.routeid() != first.routeid() ||
+          next.blockid() != first.blockid() || next.headsign_offset() != first.headsign_offset() ||
+          next.schedule_index() != first.schedule_index() ||
+          next.elapsed_time() != first.elapsed_time() ||
+          next.wheelchair_accessible() != first.wheelchair_accessible() ||
+          next.bicycle_accessible() != first.bicycle_accessible() || gap == 0 ||
+          (headway != 0 && gap != headway)) {
+        break;
+      }
+      headway = gap;
+      ++end;
+    }
+
+    // the end time is exclusive so the last departure in the run needs one more
+    // headway of room before the bitfield tops out
+    uint32_t last_time = departures[end - 1].departure_time();
+    if (end - begin >= kMinHeadwayRun && last_time + headway <= kMaxEndTime) {
+      TransitDeparture run(first.lineid(), first.tripid(), first.routeid(), first.blockid(),
+                           first.headsign_offset(), first.departure_time(), last_time + headway,
+                           headway, first.elapsed_time(), first.schedule_index(),
+                           first.wheelchair_accessible(), first.bicycle_accessible());
+      tilebuilder.AddTransitDeparture(std::move(run));
+      collapsed += end - begin;
+    } else {
+      for (size_t i = begin; i < end; ++i) {
+        tilebuilder.AddTransitDeparture(departures[i]);
+      }
+    }
+    begin = end;
+  }
+  return collapsed;
+}
+
 // We make sure to lock on reading and writing since tiles are now being
 // written. Also lock on queue access since shared by different threads.
 void build_tiles(const boost::property_tree::ptree& pt,
@@ -1096,11 +1150,13 @@ void build_tiles(const boost::property_tree::ptree& pt,
 
         try {
           if (dep.frequency == 0) {
-            // Form transit departures -- fixed departure time
-            TransitDeparture td(lineid, dep.trip, dep.route, dep.blockid, dep.headsign_offset,
-                                dep.dep_time, dep.elapsed_time, dep.schedule_index,
-                                dep.wheelchair_accessible, dep.bicycle_accessible);
-            tilebuilder_transit.AddTransitDeparture(std::move(td));
+            // Form transit departures -- fixed departure time. These are held
+            // back so regular headway runs can be collapsed once the whole
+            // tile's schedule is known
+            transit_departures.emplace_back(lineid, dep.trip, dep.route, dep.blockid,
+                                            dep.headsign_offset, dep.dep_time, dep.elapsed_time,
+                                            dep.schedule_index, dep.wheelchair_accessible,
+                                            dep.bicycle_accessible);
           } else {
 
             // Form transit departures -- frequency departure time
@@ -1122,6 +1178,13 @@ void build_tiles(const boost::property_tree::ptree& pt,
       stop_edge_map.insert({platform_pbf_graphid, stopedges});
     }
 
+    // Fold regular fixed schedules into frequency records before they hit the tile
+    uint32_t collapsed = CollapseHeadwayRuns(transit_departures, tilebuilder_transit);
+    if (collapsed > 0) {
+      LOG_DEBUG("Tile " + std::to_string(tile_id.tileid()) + ": collapsed " +
+                std::to_string(collapsed) + " fixed departures into headway runs");
+    }
+
     // Add routes to the tile. Get vector of route types.
     std::vector<uint32_t> route_types = AddRoutes(transit, tilebuilder_transit);
     auto filter = tiles.TileBounds(tile_id.tileid());
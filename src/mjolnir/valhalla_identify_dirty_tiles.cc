@@ -0,0 +1,218 @@
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "config.h"
+
+#include "baldr/rapidjson_utils.h"
+#include <boost/filesystem/operations.hpp>
+#include <boost/optional.hpp>
+#include <boost/program_options.hpp>
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/xml_parser.hpp>
+#include <iostream>
+
+#include "baldr/directededge.h"
+#include "baldr/edgeinfo.h"
+#include "baldr/graphid.h"
+#include "baldr/graphreader.h"
+#include "baldr/graphtile.h"
+#include "baldr/tilehierarchy.h"
+#include "midgard/logging.h"
+#include "midgard/pointll.h"
+
+namespace bpo = boost::program_options;
+
+using namespace valhalla::baldr;
+using namespace valhalla::midgard;
+
+boost::filesystem::path config_file_path;
+std::vector<std::string> input_files;
+
+bool ParseArguments(int argc, char* argv[]) {
+
+  bpo::options_description options(
+      "identify_dirty_tiles " VALHALLA_VERSION "\n"
+      "\n"
+      " Usage: identify_dirty_tiles [options] <osc_change_file> ...\n"
+      "\n"
+      "identify_dirty_tiles is a program that reads OSM change (.osc) files "
+      "and writes the list of graph tiles those changes touch, so a rebuild "
+      "can be limited to just the dirty tiles."
+      "\n"
+      "\n");
+
+  options.add_options()("help,h", "Print this help message.")("version,v",
+                                                              "Print the version of this software.")(
+      "config,c",
+      boost::program_options::value<boost::filesystem::path>(&config_file_path)->required(),
+      "Path to the json configuration file.")
+      // positional arguments
+      ("input_files",
+       boost::program_options::value<std::vector<std::string>>(&input_files)->multitoken());
+
+  bpo::positional_options_description pos_options;
+  pos_options.add("input_files", 16);
+
+  bpo::variables_map vm;
+  try {
+    bpo::store(bpo::command_line_parser(argc, argv).options(options).positional(pos_options).run(),
+               vm);
+    bpo::notify(vm);
+
+  } catch (std::exception& e) {
+    std::cerr << "Unable to parse command line options because: " << e.what() << "\n"
+              << "This is a bug, please report it at " PACKAGE_BUGREPORT << "\n";
+    return false;
+  }
+
+  if (vm.count("help")) {
+    std::cout << options << "\n";
+    return true;
+  }
+
+  if (vm.count("version")) {
+    std::cout << "identify_dirty_tiles " << VALHALLA_VERSION << "\n";
+    return true;
+  }
+
+  if (vm.count("config")) {
+    if (boost::filesystem::is_regular_file(config_file_path)) {
+      if (input_files.empty()) {
+        std::cerr << "At least one change file is required\n\n" << options << "\n\n";
+        return false;
+      }
+      return true;
+    } else {
+      std::cerr << "Configuration file is required\n\n" << options << "\n\n";
+    }
+  }
+
+  return false;
+}
+
+// Pull the changed object ids and node locations out of a single change file.
+// A change file carries the full new version of every created or modified
+// object so nodes come with their location. Deleted nodes may come with just
+// an id but a node cannot be deleted while a way still uses it, so the way
+// scan covers whatever those deletions touch.
+void ParseChangeFile(const std::string& file_name,
+                     const Tiles<PointLL>& tiles,
+                     std::unordered_set<uint64_t>& changed_ways,
+                     std::unordered_set<uint32_t>& dirty_local_tiles) {
+  boost::property_tree::ptree chng;
+  boost::property_tree::read_xml(file_name, chng);
+  for (const auto& action : chng.get_child("osmChange")) {
+    // the actions we care about hold objects, anything else is metadata
+    if (action.first != "create" && action.first != "modify" && action.first != "delete") {
+      continue;
+    }
+    for (const auto& object : action.second) {
+      if (object.first == "node") {
+        // a located node dirties the tile its location falls in
+        auto lat = object.second.get_optional<double>("<xmlattr>.lat");
+        auto lng = object.second.get_optional<double>("<xmlattr>.lon");
+        if (lat && lng) {
+          dirty_local_tiles.emplace(tiles.TileId(PointLL(*lng, *lat)));
+        }
+      } else if (object.first == "way") {
+        changed_ways.emplace(object.second.get<uint64_t>("<xmlattr>.id"));
+      } else if (object.first == "relation") {
+        // a changed relation (e.g. a turn restriction) dirties the tiles of
+        // its member ways
+        for (const auto& member : object.second) {
+          if (member.first == "member" &&
+              member.second.get<std::string>("<xmlattr>.type", "") == "way") {
+            changed_ways.emplace(member.second.get<uint64_t>("<xmlattr>.ref"));
+          }
+        }
+      }
+    }
+  }
+}
+
+// Main application to identify which graph tiles a set of OSM change files
+// touch. Tiles on the upper levels that cover a dirty local tile are included
+// since their shortcuts and transition edges are derived from the local level.
+int main(int argc, char** argv) {
+  // Parse command line arguments
+  if (!ParseArguments(argc, argv)) {
+    return EXIT_FAILURE;
+  }
+
+  // Get the config to see which coverage we are using
+  boost::property_tree::ptree pt;
+  rapidjson::read_json(config_file_path.c_str(), pt);
+
+  // Get something we can use to fetch tiles
+  auto tile_properties = pt.get_child("mjolnir");
+  auto local_level = TileHierarchy::levels().rbegin()->second.level;
+  auto tiles = TileHierarchy::levels().rbegin()->second.tiles;
+
+  // Collect the changed way ids and the tiles dirtied by changed node locations
+  std::unordered_set<uint64_t> changed_ways;
+  std::unordered_set<uint32_t> dirty_local_tiles;
+  for (const auto& input_file : input_files) {
+    ParseChangeFile(input_file, tiles, changed_ways, dirty_local_tiles);
+  }
+  LOG_INFO("Changed ways: " + std::to_string(changed_ways.size()));
+
+  // Iterate through tiles at the local level and mark the ones carrying edges
+  // of a changed way. The end node tile is marked as well since an edge ending
+  // in the neighboring tile leaves way geometry on both sides of the boundary
+  GraphReader reader(pt.get_child("mjolnir"));
+  for (uint32_t id = 0; id < tiles.TileCount(); id++) {
+    // If tile exists scan its edges
+    GraphId edge_id(id, local_level, 0);
+    if (!reader.DoesTileExist(tile_properties, edge_id)) {
+      continue;
+    }
+
+    const GraphTile* tile = reader.GetGraphTile(edge_id);
+    for (uint32_t n = 0; n < tile->header()->directededgecount(); n++, ++edge_id) {
+      const DirectedEdge* edge = tile->directededge(edge_id);
+      if (edge->IsTransitLine() || edge->use() == Use::kTransitConnection ||
+          edge->use() == Use::kEgressConnection || edge->use() == Use::kPlatformConnection) {
+        continue;
+      }
+
+      // Get the way Id
+      uint64_t wayid = tile->edgeinfo(edge->edgeinfo_offset()).wayid();
+      if (changed_ways.find(wayid) != changed_ways.end()) {
+        dirty_local_tiles.emplace(id);
+        dirty_local_tiles.emplace(edge->endnode().tileid());
+      }
+    }
+    if (reader.OverCommitted()) {
+      reader.Clear();
+    }
+  }
+  LOG_INFO("Dirty local tiles: " + std::to_string(dirty_local_tiles.size()));
+
+  // A dirty local tile dirties the tile covering it on every upper level since
+  // shortcuts and transitions there are built from the local edges
+  std::unordered_set<uint64_t> dirty_tiles;
+  for (const auto& id : dirty_local_tiles) {
+    dirty_tiles.emplace(GraphId(id, local_level, 0));
+    auto center = tiles.TileBounds(id).Center();
+    for (const auto& level : TileHierarchy::levels()) {
+      if (level.second.level != local_level) {
+        dirty_tiles.emplace(GraphId(level.second.tiles.TileId(center), level.second.level, 0));
+      }
+    }
+  }
+
+  // Write them out, one tile file per line
+  std::ofstream dirty_file;
+  std::string fname = pt.get<std::string>("mjolnir.tile_dir") + "/dirty_tiles.txt";
+  dirty_file.open(fname, std::ofstream::out | std::ofstream::trunc);
+  for (const auto& id : dirty_tiles) {
+    dirty_file << GraphTile::FileSuffix(GraphId(id)) << std::endl;
+  }
+  dirty_file.close();
+  LOG_INFO("Wrote " + std::to_string(dirty_tiles.size()) + " dirty tiles to " + fname);
+
+  return EXIT_SUCCESS;
+}
@@ -1719,6 +1719,27 @@ bool ManeuversBuilder::IsTee(int node_index,
   return false;
 }
 
+bool ManeuversBuilder::HasCommonBaseNames(int node_index,
+                                          EnhancedTripPath_Edge* prev_edge,
+                                          EnhancedTripPath_Edge* curr_edge) const {
+  // The tile build already intersected the names at this transition - when
+  // the trip path carries that bit a test replaces the string comparisons.
+  // The build time flag is also set when both edges are unnamed, which does
+  // not count as a common name here
+  if (curr_edge->has_name_consistency()) {
+    return curr_edge->name_consistency() && (curr_edge->name_size() > 0);
+  }
+
+  // Fall back to intersecting the name sets
+  std::unique_ptr<StreetNames> prev_edge_names =
+      StreetNamesFactory::Create(trip_path_->GetCountryCode(node_index), prev_edge->GetNameList());
+
+  std::unique_ptr<StreetNames> curr_edge_names =
+      StreetNamesFactory::Create(trip_path_->GetCountryCode(node_index), curr_edge->GetNameList());
+
+  return !(prev_edge_names->FindCommonBaseNames(*curr_edge_names)->empty());
+}
+
 bool ManeuversBuilder::IsLeftPencilPointUturn(int node_index,
                                               EnhancedTripPath_Edge* prev_edge,
                                               EnhancedTripPath_Edge* curr_edge) const {
@@ -1741,20 +1762,11 @@ bool ManeuversBuilder::IsLeftPencilPointUturn(int node_index,
     node->CalculateRightLeftIntersectingEdgeCounts(prev_edge->end_heading(), prev_edge->travel_mode(),
                                                    xedge_counts);
 
-    std::unique_ptr<StreetNames> prev_edge_names =
-        StreetNamesFactory::Create(trip_path_->GetCountryCode(node_index), prev_edge->GetNameList());
-
-    std::unique_ptr<StreetNames> curr_edge_names =
-        StreetNamesFactory::Create(trip_path_->GetCountryCode(node_index), curr_edge->GetNameList());
-
-    // Process common base names
-    std::unique_ptr<StreetNames> common_base_names =
-        prev_edge_names->FindCommonBaseNames(*curr_edge_names);
-
     // If no intersecting traversable left road exists
     // and the from and to edges have a common base name
     // then it is a left pencil point u-turn
-    if ((xedge_counts.left_traversable_outbound == 0) && !common_base_names->empty()) {
+    if ((xedge_counts.left_traversable_outbound == 0) &&
+        HasCommonBaseNames(node_index, prev_edge, curr_edge)) {
       return true;
     }
   }
@@ -1784,20 +1796,11 @@ bool ManeuversBuilder::IsRightPencilPointUturn(int node_index,
     node->CalculateRightLeftIntersectingEdgeCounts(prev_edge->end_heading(), prev_edge->travel_mode(),
                                                    xedge_counts);
 
-    std::unique_ptr<StreetNames> prev_edge_names =
-        StreetNamesFactory::Create(trip_path_->GetCountryCode(node_index), prev_edge->GetNameList());
-
-    std::unique_ptr<StreetNames> curr_edge_names =
-        StreetNamesFactory::Create(trip_path_->GetCountryCode(node_index), curr_edge->GetNameList());
-
-    // Process common base names
-    std::unique_ptr<StreetNames> common_base_names =
-        prev_edge_names->FindCommonBaseNames(*curr_edge_names);
-
     // If no intersecting traversable right road exists
     // and the from and to edges have a common base name
     // then it is a right pencil point u-turn
-    if ((xedge_counts.right_traversable_outbound == 0) && !common_base_names->empty()) {
+    if ((xedge_counts.right_traversable_outbound == 0) &&
+        HasCommonBaseNames(node_index, prev_edge, curr_edge)) {
       return true;
     }
   }
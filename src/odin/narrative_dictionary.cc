@@ -30,11 +30,84 @@ std::unordered_map<K, V> as_unordered_map(boost::property_tree::ptree const& pt,
   return items;
 }
 
+// Repeated maneuver patterns form the same phrase over and over so each worker
+// thread keeps a memo of recently formed phrases. Bound how many are kept
+// since street names are an open vocabulary
+constexpr size_t kFormedPhraseMemoMax = 4096;
+
 } // namespace
 
 namespace valhalla {
 namespace odin {
 
+PhraseTemplate::PhraseTemplate(const std::string& phrase) {
+  size_t begin = 0;
+  while (true) {
+    // a tag runs from an opening angle bracket to the next closing one
+    size_t open = phrase.find('<', begin);
+    size_t close = (open != std::string::npos) ? phrase.find('>', open + 1) : std::string::npos;
+    if (close == std::string::npos) {
+      // the remaining text has no complete tag
+      pieces.emplace_back(phrase, begin, phrase.size() - begin);
+      break;
+    }
+    pieces.emplace_back(phrase, begin, open - begin);
+    pieces.emplace_back(phrase, open, close + 1 - open);
+    begin = close + 1;
+  }
+}
+
+std::string
+PhraseSet::FormPhrase(uint32_t phrase_id,
+                      std::initializer_list<std::pair<const char*, const std::string&>> values)
+    const {
+  // check the memo first, the key encodes the phrase set, the phrase id and
+  // every tag and value of the signature so a hit is always exact
+  thread_local std::unordered_map<std::string, std::string> formed_phrases;
+  std::string key = std::to_string(reinterpret_cast<uintptr_t>(this)) + '|' +
+                    std::to_string(phrase_id);
+  for (const auto& value : values) {
+    key += '\0';
+    key += value.first;
+    key += '\0';
+    key += value.second;
+  }
+  auto memoized = formed_phrases.find(key);
+  if (memoized != formed_phrases.end()) {
+    return memoized->second;
+  }
+
+  const auto& pieces = templates.at(phrase_id).pieces;
+  // which value, if any, goes with the specified tag
+  auto value_for = [&values](const std::string& tag) -> const std::string* {
+    for (const auto& value : values) {
+      if (tag == value.first) {
+        return &value.second;
+      }
+    }
+    return nullptr;
+  };
+  // total up the piece sizes so the phrase is assembled with a single allocation
+  size_t length = 0;
+  for (size_t i = 0; i < pieces.size(); ++i) {
+    const std::string* value = (i % 2 == 1) ? value_for(pieces[i]) : nullptr;
+    length += value ? value->size() : pieces[i].size();
+  }
+  std::string phrase;
+  phrase.reserve(length);
+  for (size_t i = 0; i < pieces.size(); ++i) {
+    const std::string* value = (i % 2 == 1) ? value_for(pieces[i]) : nullptr;
+    phrase.append(value ? *value : pieces[i]);
+  }
+
+  // memoize for the next identical signature
+  if (formed_phrases.size() >= kFormedPhraseMemoMax) {
+    formed_phrases.clear();
+  }
+  formed_phrases.emplace(std::move(key), phrase);
+  return phrase;
+}
+
 NarrativeDictionary::NarrativeDictionary(const std::string& language_tag,
                                          const boost::property_tree::ptree& narrative_pt) {
   this->language_tag = language_tag;
@@ -331,6 +404,12 @@ void NarrativeDictionary::Load(PhraseSet& phrase_handle,
                                const boost::property_tree::ptree& phrase_pt) {
 
   phrase_handle.phrases = as_unordered_map<std::string, std::string>(phrase_pt, kPhrasesKey);
+
+  // Precompile each phrase into its template pieces; the phrase keys are
+  // numeric strings so the templates are keyed by the numeric id directly
+  for (const auto& phrase : phrase_handle.phrases) {
+    phrase_handle.templates.emplace(std::stoul(phrase.first), PhraseTemplate(phrase.second));
+  }
 }
 
 void NarrativeDictionary::Load(StartSubset& start_handle,
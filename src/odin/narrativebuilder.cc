@@ -505,13 +505,11 @@ std::string NarrativeBuilder::FormStartInstruction(Maneuver& maneuver) {
     phrase_id += 16;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.start_subset.phrases.at(std::to_string(phrase_id));
-
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kCardinalDirectionTag, cardinal_direction);
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
-  boost::replace_all(instruction, kBeginStreetNamesTag, begin_street_names);
+  // Set instruction to the determined tagged phrase with the tag values
+  instruction =
+      dictionary_.start_subset.FormPhrase(phrase_id, {{kCardinalDirectionTag, cardinal_direction},
+                                                      {kStreetNamesTag, street_names},
+                                                      {kBeginStreetNamesTag, begin_street_names}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -563,16 +561,19 @@ std::string NarrativeBuilder::FormVerbalStartInstruction(Maneuver& maneuver,
     phrase_id += 16;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.start_verbal_subset.phrases.at(std::to_string(phrase_id));
+  // Set length value
+  std::string length =
+      FormLength(maneuver,
+                 dictionary_.start_verbal_subset.metric_lengths,
+                 dictionary_.start_verbal_subset.us_customary_lengths);
 
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kCardinalDirectionTag, cardinal_direction);
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
-  boost::replace_all(instruction, kBeginStreetNamesTag, begin_street_names);
-  boost::replace_all(instruction, kLengthTag,
-                     FormLength(maneuver, dictionary_.start_verbal_subset.metric_lengths,
-                                dictionary_.start_verbal_subset.us_customary_lengths));
+  // Set instruction to the determined tagged phrase with the tag values
+  instruction =
+      dictionary_.start_verbal_subset
+          .FormPhrase(phrase_id, {{kCardinalDirectionTag, cardinal_direction},
+                                  {kStreetNamesTag, street_names},
+                                  {kBeginStreetNamesTag, begin_street_names},
+                                  {kLengthTag, length}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -616,14 +617,11 @@ std::string NarrativeBuilder::FormDestinationInstruction(Maneuver& maneuver) {
     relative_direction = dictionary_.destination_subset.relative_directions.at(1);
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.destination_subset.phrases.at(std::to_string(phrase_id));
-
-  if (phrase_id > 0) {
-    // Replace phrase tags with values
-    boost::replace_all(instruction, kRelativeDirectionTag, relative_direction);
-    boost::replace_all(instruction, kDestinationTag, destination);
-  }
+  // Set instruction to the determined tagged phrase with the tag values
+  instruction =
+      dictionary_.destination_subset
+          .FormPhrase(phrase_id, {{kRelativeDirectionTag, relative_direction},
+                                  {kDestinationTag, destination}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -672,14 +670,11 @@ std::string NarrativeBuilder::FormVerbalAlertDestinationInstruction(Maneuver& ma
     relative_direction = dictionary_.destination_subset.relative_directions.at(1);
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.destination_verbal_alert_subset.phrases.at(std::to_string(phrase_id));
-
-  if (phrase_id > 0) {
-    // Replace phrase tags with values
-    boost::replace_all(instruction, kRelativeDirectionTag, relative_direction);
-    boost::replace_all(instruction, kDestinationTag, destination);
-  }
+  // Set instruction to the determined tagged phrase with the tag values
+  instruction =
+      dictionary_.destination_verbal_alert_subset
+          .FormPhrase(phrase_id, {{kRelativeDirectionTag, relative_direction},
+                                  {kDestinationTag, destination}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -728,14 +723,11 @@ std::string NarrativeBuilder::FormVerbalDestinationInstruction(Maneuver& maneuve
     relative_direction = dictionary_.destination_subset.relative_directions.at(1);
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.destination_verbal_subset.phrases.at(std::to_string(phrase_id));
-
-  if (phrase_id > 0) {
-    // Replace phrase tags with values
-    boost::replace_all(instruction, kRelativeDirectionTag, relative_direction);
-    boost::replace_all(instruction, kDestinationTag, destination);
-  }
+  // Set instruction to the determined tagged phrase with the tag values
+  instruction =
+      dictionary_.destination_verbal_subset
+          .FormPhrase(phrase_id, {{kRelativeDirectionTag, relative_direction},
+                                  {kDestinationTag, destination}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -758,12 +750,11 @@ std::string NarrativeBuilder::FormBecomesInstruction(Maneuver& maneuver, Maneuve
   // Determine which phrase to use
   uint8_t phrase_id = 0;
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.becomes_subset.phrases.at(std::to_string(phrase_id));
-
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kPreviousStreetNamesTag, prev_street_names);
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
+  // Set instruction to the determined tagged phrase with the tag values
+  instruction =
+      dictionary_.becomes_subset
+          .FormPhrase(phrase_id, {{kPreviousStreetNamesTag, prev_street_names},
+                                  {kStreetNamesTag, street_names}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -793,12 +784,11 @@ std::string NarrativeBuilder::FormVerbalBecomesInstruction(Maneuver& maneuver,
   // Determine which phrase to use
   uint8_t phrase_id = 0;
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.becomes_verbal_subset.phrases.at(std::to_string(phrase_id));
-
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kPreviousStreetNamesTag, prev_street_names);
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
+  // Set instruction to the determined tagged phrase with the tag values
+  instruction =
+      dictionary_.becomes_verbal_subset
+          .FormPhrase(phrase_id, {{kPreviousStreetNamesTag, prev_street_names},
+                                  {kStreetNamesTag, street_names}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -826,11 +816,9 @@ std::string NarrativeBuilder::FormContinueInstruction(Maneuver& maneuver) {
     phrase_id = 1;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.continue_subset.phrases.at(std::to_string(phrase_id));
-
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
+  // Set instruction to the determined tagged phrase with the tag values
+  instruction =
+      dictionary_.continue_subset.FormPhrase(phrase_id, {{kStreetNamesTag, street_names}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -861,11 +849,10 @@ std::string NarrativeBuilder::FormVerbalAlertContinueInstruction(Maneuver& maneu
     phrase_id = 1;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.continue_verbal_alert_subset.phrases.at(std::to_string(phrase_id));
-
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
+  // Set instruction to the determined tagged phrase with the tag values
+  instruction =
+      dictionary_.continue_verbal_alert_subset
+          .FormPhrase(phrase_id, {{kStreetNamesTag, street_names}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -897,14 +884,16 @@ std::string NarrativeBuilder::FormVerbalContinueInstruction(Maneuver& maneuver,
     phrase_id = 1;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.continue_verbal_subset.phrases.at(std::to_string(phrase_id));
+  // Set length value
+  std::string length =
+      FormLength(maneuver,
+                 dictionary_.continue_verbal_subset.metric_lengths,
+                 dictionary_.continue_verbal_subset.us_customary_lengths);
 
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kLengthTag,
-                     FormLength(maneuver, dictionary_.continue_verbal_subset.metric_lengths,
-                                dictionary_.continue_verbal_subset.us_customary_lengths));
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
+  // Set instruction to the determined tagged phrase with the tag values
+  instruction =
+      dictionary_.continue_verbal_subset.FormPhrase(phrase_id, {{kLengthTag, length},
+                                                                {kStreetNamesTag, street_names}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -959,14 +948,14 @@ std::string NarrativeBuilder::FormTurnInstruction(Maneuver& maneuver, Maneuver*
     phrase_id = 3;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = subset->phrases.at(std::to_string(phrase_id));
+  // Set relative_direction value
+  std::string relative_direction =
+      FormRelativeTwoDirection(maneuver.type(), subset->relative_directions);
 
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kRelativeDirectionTag,
-                     FormRelativeTwoDirection(maneuver.type(), subset->relative_directions));
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
-  boost::replace_all(instruction, kBeginStreetNamesTag, begin_street_names);
+  // Set instruction to the determined tagged phrase with the tag values
+  instruction = subset->FormPhrase(phrase_id, {{kRelativeDirectionTag, relative_direction},
+                                               {kStreetNamesTag, street_names},
+                                               {kBeginStreetNamesTag, begin_street_names}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -1040,14 +1029,14 @@ std::string NarrativeBuilder::FormVerbalTurnInstruction(Maneuver& maneuver,
     phrase_id = 3;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = subset->phrases.at(std::to_string(phrase_id));
+  // Set relative_direction value
+  std::string relative_direction =
+      FormRelativeTwoDirection(maneuver.type(), subset->relative_directions);
 
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kRelativeDirectionTag,
-                     FormRelativeTwoDirection(maneuver.type(), subset->relative_directions));
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
-  boost::replace_all(instruction, kBeginStreetNamesTag, begin_street_names);
+  // Set instruction to the determined tagged phrase with the tag values
+  instruction = subset->FormPhrase(phrase_id, {{kRelativeDirectionTag, relative_direction},
+                                               {kStreetNamesTag, street_names},
+                                               {kBeginStreetNamesTag, begin_street_names}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -1088,15 +1077,15 @@ std::string NarrativeBuilder::FormUturnInstruction(Maneuver& maneuver, Maneuver*
     phrase_id += 3;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.uturn_subset.phrases.at(std::to_string(phrase_id));
+  // Set relative_direction value
+  std::string relative_direction =
+      FormRelativeTwoDirection(maneuver.type(), dictionary_.uturn_subset.relative_directions);
 
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kRelativeDirectionTag,
-                     FormRelativeTwoDirection(maneuver.type(),
-                                              dictionary_.uturn_subset.relative_directions));
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
-  boost::replace_all(instruction, kCrossStreetNamesTag, cross_street_names);
+  // Set instruction to the determined tagged phrase with the tag values
+  instruction =
+      dictionary_.uturn_subset.FormPhrase(phrase_id, {{kRelativeDirectionTag, relative_direction},
+                                                      {kStreetNamesTag, street_names},
+                                                      {kCrossStreetNamesTag, cross_street_names}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -1199,13 +1188,12 @@ std::string NarrativeBuilder::FormVerbalUturnInstruction(uint8_t phrase_id,
   std::string instruction;
   instruction.reserve(kInstructionInitialCapacity);
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.uturn_verbal_subset.phrases.at(std::to_string(phrase_id));
-
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kRelativeDirectionTag, relative_dir);
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
-  boost::replace_all(instruction, kCrossStreetNamesTag, cross_street_names);
+  // Set instruction to the determined tagged phrase with the tag values
+  instruction =
+      dictionary_.uturn_verbal_subset
+          .FormPhrase(phrase_id, {{kRelativeDirectionTag, relative_dir},
+                                  {kStreetNamesTag, street_names},
+                                  {kCrossStreetNamesTag, cross_street_names}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -1251,13 +1239,11 @@ std::string NarrativeBuilder::FormRampStraightInstruction(Maneuver& maneuver,
         maneuver.signs().GetExitNameString(element_max_count, limit_by_consecutive_count);
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.ramp_straight_subset.phrases.at(std::to_string(phrase_id));
-
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kBranchSignTag, exit_branch_sign);
-  boost::replace_all(instruction, kTowardSignTag, exit_toward_sign);
-  boost::replace_all(instruction, kNameSignTag, exit_name_sign);
+  // Set instruction to the determined tagged phrase with the tag values
+  instruction =
+      dictionary_.ramp_straight_subset.FormPhrase(phrase_id, {{kBranchSignTag, exit_branch_sign},
+                                                              {kTowardSignTag, exit_toward_sign},
+                                                              {kNameSignTag, exit_name_sign}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -1354,13 +1340,12 @@ std::string NarrativeBuilder::FormVerbalRampStraightInstruction(uint8_t phrase_i
   std::string instruction;
   instruction.reserve(kInstructionInitialCapacity);
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.ramp_straight_verbal_subset.phrases.at(std::to_string(phrase_id));
-
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kBranchSignTag, exit_branch_sign);
-  boost::replace_all(instruction, kTowardSignTag, exit_toward_sign);
-  boost::replace_all(instruction, kNameSignTag, exit_name_sign);
+  // Set instruction to the determined tagged phrase with the tag values
+  instruction =
+      dictionary_.ramp_straight_verbal_subset
+          .FormPhrase(phrase_id, {{kBranchSignTag, exit_branch_sign},
+                                  {kTowardSignTag, exit_toward_sign},
+                                  {kNameSignTag, exit_name_sign}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -1417,16 +1402,16 @@ std::string NarrativeBuilder::FormRampInstruction(Maneuver& maneuver,
         maneuver.signs().GetExitNameString(element_max_count, limit_by_consecutive_count);
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.ramp_subset.phrases.at(std::to_string(phrase_id));
+  // Set relative_direction value
+  std::string relative_direction =
+      FormRelativeTwoDirection(maneuver.type(), dictionary_.ramp_subset.relative_directions);
 
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kRelativeDirectionTag,
-                     FormRelativeTwoDirection(maneuver.type(),
-                                              dictionary_.ramp_subset.relative_directions));
-  boost::replace_all(instruction, kBranchSignTag, exit_branch_sign);
-  boost::replace_all(instruction, kTowardSignTag, exit_toward_sign);
-  boost::replace_all(instruction, kNameSignTag, exit_name_sign);
+  // Set instruction to the determined tagged phrase with the tag values
+  instruction =
+      dictionary_.ramp_subset.FormPhrase(phrase_id, {{kRelativeDirectionTag, relative_direction},
+                                                     {kBranchSignTag, exit_branch_sign},
+                                                     {kTowardSignTag, exit_toward_sign},
+                                                     {kNameSignTag, exit_name_sign}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -1549,14 +1534,12 @@ std::string NarrativeBuilder::FormVerbalRampInstruction(uint8_t phrase_id,
   std::string instruction;
   instruction.reserve(kInstructionInitialCapacity);
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.ramp_verbal_subset.phrases.at(std::to_string(phrase_id));
-
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kRelativeDirectionTag, relative_dir);
-  boost::replace_all(instruction, kBranchSignTag, exit_branch_sign);
-  boost::replace_all(instruction, kTowardSignTag, exit_toward_sign);
-  boost::replace_all(instruction, kNameSignTag, exit_name_sign);
+  // Set instruction to the determined tagged phrase with the tag values
+  instruction =
+      dictionary_.ramp_verbal_subset.FormPhrase(phrase_id, {{kRelativeDirectionTag, relative_dir},
+                                                            {kBranchSignTag, exit_branch_sign},
+                                                            {kTowardSignTag, exit_toward_sign},
+                                                            {kNameSignTag, exit_name_sign}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -1615,17 +1598,17 @@ std::string NarrativeBuilder::FormExitInstruction(Maneuver& maneuver,
         maneuver.signs().GetExitNameString(element_max_count, limit_by_consecutive_count);
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.exit_subset.phrases.at(std::to_string(phrase_id));
+  // Set relative_direction value
+  std::string relative_direction =
+      FormRelativeTwoDirection(maneuver.type(), dictionary_.exit_subset.relative_directions);
 
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kRelativeDirectionTag,
-                     FormRelativeTwoDirection(maneuver.type(),
-                                              dictionary_.exit_subset.relative_directions));
-  boost::replace_all(instruction, kNumberSignTag, exit_number_sign);
-  boost::replace_all(instruction, kBranchSignTag, exit_branch_sign);
-  boost::replace_all(instruction, kTowardSignTag, exit_toward_sign);
-  boost::replace_all(instruction, kNameSignTag, exit_name_sign);
+  // Set instruction to the determined tagged phrase with the tag values
+  instruction =
+      dictionary_.exit_subset.FormPhrase(phrase_id, {{kRelativeDirectionTag, relative_direction},
+                                                     {kNumberSignTag, exit_number_sign},
+                                                     {kBranchSignTag, exit_branch_sign},
+                                                     {kTowardSignTag, exit_toward_sign},
+                                                     {kNameSignTag, exit_name_sign}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -1751,15 +1734,13 @@ std::string NarrativeBuilder::FormVerbalExitInstruction(uint8_t phrase_id,
   std::string instruction;
   instruction.reserve(kInstructionInitialCapacity);
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.exit_verbal_subset.phrases.at(std::to_string(phrase_id));
-
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kRelativeDirectionTag, relative_dir);
-  boost::replace_all(instruction, kNumberSignTag, exit_number_sign);
-  boost::replace_all(instruction, kBranchSignTag, exit_branch_sign);
-  boost::replace_all(instruction, kTowardSignTag, exit_toward_sign);
-  boost::replace_all(instruction, kNameSignTag, exit_name_sign);
+  // Set instruction to the determined tagged phrase with the tag values
+  instruction =
+      dictionary_.exit_verbal_subset.FormPhrase(phrase_id, {{kRelativeDirectionTag, relative_dir},
+                                                            {kNumberSignTag, exit_number_sign},
+                                                            {kBranchSignTag, exit_branch_sign},
+                                                            {kTowardSignTag, exit_toward_sign},
+                                                            {kNameSignTag, exit_name_sign}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -1816,16 +1797,16 @@ std::string NarrativeBuilder::FormKeepInstruction(Maneuver& maneuver,
         maneuver.signs().GetExitTowardString(element_max_count, limit_by_consecutive_count);
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.keep_subset.phrases.at(std::to_string(phrase_id));
+  // Set relative_direction value
+  std::string relative_direction =
+      FormRelativeThreeDirection(maneuver.type(), dictionary_.keep_subset.relative_directions);
 
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kRelativeDirectionTag,
-                     FormRelativeThreeDirection(maneuver.type(),
-                                                dictionary_.keep_subset.relative_directions));
-  boost::replace_all(instruction, kNumberSignTag, exit_number_sign);
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
-  boost::replace_all(instruction, kTowardSignTag, exit_toward_sign);
+  // Set instruction to the determined tagged phrase with the tag values
+  instruction =
+      dictionary_.keep_subset.FormPhrase(phrase_id, {{kRelativeDirectionTag, relative_direction},
+                                                     {kNumberSignTag, exit_number_sign},
+                                                     {kStreetNamesTag, street_names},
+                                                     {kTowardSignTag, exit_toward_sign}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -1949,14 +1930,12 @@ std::string NarrativeBuilder::FormVerbalKeepInstruction(uint8_t phrase_id,
   std::string instruction;
   instruction.reserve(kInstructionInitialCapacity);
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.keep_verbal_subset.phrases.at(std::to_string(phrase_id));
-
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kRelativeDirectionTag, relative_dir);
-  boost::replace_all(instruction, kNumberSignTag, exit_number_sign);
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
-  boost::replace_all(instruction, kTowardSignTag, exit_toward_sign);
+  // Set instruction to the determined tagged phrase with the tag values
+  instruction =
+      dictionary_.keep_verbal_subset.FormPhrase(phrase_id, {{kRelativeDirectionTag, relative_dir},
+                                                            {kNumberSignTag, exit_number_sign},
+                                                            {kStreetNamesTag, street_names},
+                                                            {kTowardSignTag, exit_toward_sign}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -2001,16 +1980,18 @@ std::string NarrativeBuilder::FormKeepToStayOnInstruction(Maneuver& maneuver,
         maneuver.signs().GetExitTowardString(element_max_count, limit_by_consecutive_count);
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.keep_to_stay_on_subset.phrases.at(std::to_string(phrase_id));
+  // Set relative_direction value
+  std::string relative_direction =
+      FormRelativeThreeDirection(maneuver.type(),
+                                 dictionary_.keep_to_stay_on_subset.relative_directions);
 
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kRelativeDirectionTag,
-                     FormRelativeThreeDirection(maneuver.type(), dictionary_.keep_to_stay_on_subset
-                                                                     .relative_directions));
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
-  boost::replace_all(instruction, kNumberSignTag, exit_number_sign);
-  boost::replace_all(instruction, kTowardSignTag, exit_toward_sign);
+  // Set instruction to the determined tagged phrase with the tag values
+  instruction =
+      dictionary_.keep_to_stay_on_subset
+          .FormPhrase(phrase_id, {{kRelativeDirectionTag, relative_direction},
+                                  {kStreetNamesTag, street_names},
+                                  {kNumberSignTag, exit_number_sign},
+                                  {kTowardSignTag, exit_toward_sign}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -2091,14 +2072,13 @@ std::string NarrativeBuilder::FormVerbalKeepToStayOnInstruction(uint8_t phrase_i
   std::string instruction;
   instruction.reserve(kInstructionInitialCapacity);
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.keep_to_stay_on_verbal_subset.phrases.at(std::to_string(phrase_id));
-
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kRelativeDirectionTag, relative_dir);
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
-  boost::replace_all(instruction, kNumberSignTag, exit_number_sign);
-  boost::replace_all(instruction, kTowardSignTag, exit_toward_sign);
+  // Set instruction to the determined tagged phrase with the tag values
+  instruction =
+      dictionary_.keep_to_stay_on_verbal_subset
+          .FormPhrase(phrase_id, {{kRelativeDirectionTag, relative_dir},
+                                  {kStreetNamesTag, street_names},
+                                  {kNumberSignTag, exit_number_sign},
+                                  {kTowardSignTag, exit_toward_sign}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -2126,11 +2106,8 @@ std::string NarrativeBuilder::FormMergeInstruction(Maneuver& maneuver) {
     phrase_id = 1;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.merge_subset.phrases.at(std::to_string(phrase_id));
-
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
+  // Set instruction to the determined tagged phrase with the tag values
+  instruction = dictionary_.merge_subset.FormPhrase(phrase_id, {{kStreetNamesTag, street_names}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -2170,11 +2147,9 @@ std::string NarrativeBuilder::FormVerbalMergeInstruction(Maneuver& maneuver,
     phrase_id = 1;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.merge_verbal_subset.phrases.at(std::to_string(phrase_id));
-
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
+  // Set instruction to the determined tagged phrase with the tag values
+  instruction =
+      dictionary_.merge_verbal_subset.FormPhrase(phrase_id, {{kStreetNamesTag, street_names}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -2202,11 +2177,10 @@ std::string NarrativeBuilder::FormEnterRoundaboutInstruction(Maneuver& maneuver)
         dictionary_.enter_roundabout_subset.ordinal_values.at(maneuver.roundabout_exit_count() - 1);
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.enter_roundabout_subset.phrases.at(std::to_string(phrase_id));
-
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kOrdinalValueTag, ordinal_value);
+  // Set instruction to the determined tagged phrase with the tag values
+  instruction =
+      dictionary_.enter_roundabout_subset
+          .FormPhrase(phrase_id, {{kOrdinalValueTag, ordinal_value}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -2236,11 +2210,10 @@ std::string NarrativeBuilder::FormVerbalAlertEnterRoundaboutInstruction(Maneuver
         maneuver.roundabout_exit_count() - 1);
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.enter_roundabout_verbal_subset.phrases.at(std::to_string(phrase_id));
-
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kOrdinalValueTag, ordinal_value);
+  // Set instruction to the determined tagged phrase with the tag values
+  instruction =
+      dictionary_.enter_roundabout_verbal_subset
+          .FormPhrase(phrase_id, {{kOrdinalValueTag, ordinal_value}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -2270,11 +2243,10 @@ std::string NarrativeBuilder::FormVerbalEnterRoundaboutInstruction(Maneuver& man
         maneuver.roundabout_exit_count() - 1);
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.enter_roundabout_verbal_subset.phrases.at(std::to_string(phrase_id));
-
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kOrdinalValueTag, ordinal_value);
+  // Set instruction to the determined tagged phrase with the tag values
+  instruction =
+      dictionary_.enter_roundabout_verbal_subset
+          .FormPhrase(phrase_id, {{kOrdinalValueTag, ordinal_value}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -2310,12 +2282,11 @@ std::string NarrativeBuilder::FormExitRoundaboutInstruction(Maneuver& maneuver)
     phrase_id = 1;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.exit_roundabout_subset.phrases.at(std::to_string(phrase_id));
-
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
-  boost::replace_all(instruction, kBeginStreetNamesTag, begin_street_names);
+  // Set instruction to the determined tagged phrase with the tag values
+  instruction =
+      dictionary_.exit_roundabout_subset
+          .FormPhrase(phrase_id, {{kStreetNamesTag, street_names},
+                                  {kBeginStreetNamesTag, begin_street_names}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -2355,12 +2326,11 @@ std::string NarrativeBuilder::FormVerbalExitRoundaboutInstruction(Maneuver& mane
     phrase_id = 1;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.exit_roundabout_verbal_subset.phrases.at(std::to_string(phrase_id));
-
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
-  boost::replace_all(instruction, kBeginStreetNamesTag, begin_street_names);
+  // Set instruction to the determined tagged phrase with the tag values
+  instruction =
+      dictionary_.exit_roundabout_verbal_subset
+          .FormPhrase(phrase_id, {{kStreetNamesTag, street_names},
+                                  {kBeginStreetNamesTag, begin_street_names}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -2394,12 +2364,10 @@ std::string NarrativeBuilder::FormEnterFerryInstruction(Maneuver& maneuver) {
     }
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.enter_ferry_subset.phrases.at(std::to_string(phrase_id));
-
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
-  boost::replace_all(instruction, kFerryLabelTag, ferry_label);
+  // Set instruction to the determined tagged phrase with the tag values
+  instruction =
+      dictionary_.enter_ferry_subset.FormPhrase(phrase_id, {{kStreetNamesTag, street_names},
+                                                            {kFerryLabelTag, ferry_label}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -2446,12 +2414,10 @@ std::string NarrativeBuilder::FormVerbalEnterFerryInstruction(Maneuver& maneuver
     }
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.enter_ferry_verbal_subset.phrases.at(std::to_string(phrase_id));
-
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
-  boost::replace_all(instruction, kFerryLabelTag, ferry_label);
+  // Set instruction to the determined tagged phrase with the tag values
+  instruction =
+      dictionary_.enter_ferry_verbal_subset.FormPhrase(phrase_id, {{kStreetNamesTag, street_names},
+                                                                   {kFerryLabelTag, ferry_label}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -2507,13 +2473,12 @@ std::string NarrativeBuilder::FormExitFerryInstruction(Maneuver& maneuver) {
     phrase_id += 16;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.exit_ferry_subset.phrases.at(std::to_string(phrase_id));
-
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kCardinalDirectionTag, cardinal_direction);
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
-  boost::replace_all(instruction, kBeginStreetNamesTag, begin_street_names);
+  // Set instruction to the determined tagged phrase with the tag values
+  instruction =
+      dictionary_.exit_ferry_subset
+          .FormPhrase(phrase_id, {{kCardinalDirectionTag, cardinal_direction},
+                                  {kStreetNamesTag, street_names},
+                                  {kBeginStreetNamesTag, begin_street_names}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -2592,13 +2557,12 @@ std::string NarrativeBuilder::FormVerbalExitFerryInstruction(Maneuver& maneuver,
     phrase_id += 16;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.exit_ferry_verbal_subset.phrases.at(std::to_string(phrase_id));
-
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kCardinalDirectionTag, cardinal_direction);
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
-  boost::replace_all(instruction, kBeginStreetNamesTag, begin_street_names);
+  // Set instruction to the determined tagged phrase with the tag values
+  instruction =
+      dictionary_.exit_ferry_verbal_subset
+          .FormPhrase(phrase_id, {{kCardinalDirectionTag, cardinal_direction},
+                                  {kStreetNamesTag, street_names},
+                                  {kBeginStreetNamesTag, begin_street_names}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -2631,12 +2595,11 @@ std::string NarrativeBuilder::FormTransitConnectionStartInstruction(Maneuver& ma
     }
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.transit_connection_start_subset.phrases.at(std::to_string(phrase_id));
-
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kTransitPlatformTag, transit_stop);
-  boost::replace_all(instruction, kStationLabelTag, station_label);
+  // Set instruction to the determined tagged phrase with the tag values
+  instruction =
+      dictionary_.transit_connection_start_subset
+          .FormPhrase(phrase_id, {{kTransitPlatformTag, transit_stop},
+                                  {kStationLabelTag, station_label}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -2669,13 +2632,11 @@ std::string NarrativeBuilder::FormVerbalTransitConnectionStartInstruction(Maneuv
     }
   }
 
-  // Set instruction to the determined tagged phrase
+  // Set instruction to the determined tagged phrase with the tag values
   instruction =
-      dictionary_.transit_connection_start_verbal_subset.phrases.at(std::to_string(phrase_id));
-
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kTransitPlatformTag, transit_stop);
-  boost::replace_all(instruction, kStationLabelTag, station_label);
+      dictionary_.transit_connection_start_verbal_subset
+          .FormPhrase(phrase_id, {{kTransitPlatformTag, transit_stop},
+                                  {kStationLabelTag, station_label}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -2708,12 +2669,11 @@ std::string NarrativeBuilder::FormTransitConnectionTransferInstruction(Maneuver&
     }
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.transit_connection_transfer_subset.phrases.at(std::to_string(phrase_id));
-
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kTransitPlatformTag, transit_stop);
-  boost::replace_all(instruction, kStationLabelTag, station_label);
+  // Set instruction to the determined tagged phrase with the tag values
+  instruction =
+      dictionary_.transit_connection_transfer_subset
+          .FormPhrase(phrase_id, {{kTransitPlatformTag, transit_stop},
+                                  {kStationLabelTag, station_label}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -2746,13 +2706,11 @@ std::string NarrativeBuilder::FormVerbalTransitConnectionTransferInstruction(Man
     }
   }
 
-  // Set instruction to the determined tagged phrase
+  // Set instruction to the determined tagged phrase with the tag values
   instruction =
-      dictionary_.transit_connection_transfer_verbal_subset.phrases.at(std::to_string(phrase_id));
-
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kTransitPlatformTag, transit_stop);
-  boost::replace_all(instruction, kStationLabelTag, station_label);
+      dictionary_.transit_connection_transfer_verbal_subset
+          .FormPhrase(phrase_id, {{kTransitPlatformTag, transit_stop},
+                                  {kStationLabelTag, station_label}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -2785,13 +2743,11 @@ std::string NarrativeBuilder::FormTransitConnectionDestinationInstruction(Maneuv
     }
   }
 
-  // Set instruction to the determined tagged phrase
+  // Set instruction to the determined tagged phrase with the tag values
   instruction =
-      dictionary_.transit_connection_destination_subset.phrases.at(std::to_string(phrase_id));
-
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kTransitPlatformTag, transit_stop);
-  boost::replace_all(instruction, kStationLabelTag, station_label);
+      dictionary_.transit_connection_destination_subset
+          .FormPhrase(phrase_id, {{kTransitPlatformTag, transit_stop},
+                                  {kStationLabelTag, station_label}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -2824,13 +2780,11 @@ std::string NarrativeBuilder::FormVerbalTransitConnectionDestinationInstruction(
     }
   }
 
-  // Set instruction to the determined tagged phrase
+  // Set instruction to the determined tagged phrase with the tag values
   instruction =
-      dictionary_.transit_connection_destination_verbal_subset.phrases.at(std::to_string(phrase_id));
-
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kTransitPlatformTag, transit_stop);
-  boost::replace_all(instruction, kStationLabelTag, station_label);
+      dictionary_.transit_connection_destination_verbal_subset
+          .FormPhrase(phrase_id, {{kTransitPlatformTag, transit_stop},
+                                  {kStationLabelTag, station_label}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -2853,13 +2807,14 @@ std::string NarrativeBuilder::FormDepartInstruction(Maneuver& maneuver) {
     phrase_id = 1;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.depart_subset.phrases.at(std::to_string(phrase_id));
+  // Set time value
+  std::string time =
+      get_localized_time(maneuver.GetTransitDepartureTime(), dictionary_.GetLocale());
 
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kTransitPlatformTag, transit_stop_name);
-  boost::replace_all(instruction, kTimeTag,
-                     get_localized_time(maneuver.GetTransitDepartureTime(), dictionary_.GetLocale()));
+  // Set instruction to the determined tagged phrase with the tag values
+  instruction =
+      dictionary_.depart_subset.FormPhrase(phrase_id, {{kTransitPlatformTag, transit_stop_name},
+                                                       {kTimeTag, time}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -2882,13 +2837,15 @@ std::string NarrativeBuilder::FormVerbalDepartInstruction(Maneuver& maneuver) {
     phrase_id = 1;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.depart_verbal_subset.phrases.at(std::to_string(phrase_id));
+  // Set time value
+  std::string time =
+      get_localized_time(maneuver.GetTransitDepartureTime(), dictionary_.GetLocale());
 
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kTransitPlatformTag, transit_stop_name);
-  boost::replace_all(instruction, kTimeTag,
-                     get_localized_time(maneuver.GetTransitDepartureTime(), dictionary_.GetLocale()));
+  // Set instruction to the determined tagged phrase with the tag values
+  instruction =
+      dictionary_.depart_verbal_subset
+          .FormPhrase(phrase_id, {{kTransitPlatformTag, transit_stop_name},
+                                  {kTimeTag, time}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -2911,13 +2868,13 @@ std::string NarrativeBuilder::FormArriveInstruction(Maneuver& maneuver) {
     phrase_id = 1;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.arrive_subset.phrases.at(std::to_string(phrase_id));
+  // Set time value
+  std::string time = get_localized_time(maneuver.GetTransitArrivalTime(), dictionary_.GetLocale());
 
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kTransitPlatformTag, transit_stop_name);
-  boost::replace_all(instruction, kTimeTag,
-                     get_localized_time(maneuver.GetTransitArrivalTime(), dictionary_.GetLocale()));
+  // Set instruction to the determined tagged phrase with the tag values
+  instruction =
+      dictionary_.arrive_subset.FormPhrase(phrase_id, {{kTransitPlatformTag, transit_stop_name},
+                                                       {kTimeTag, time}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -2940,13 +2897,14 @@ std::string NarrativeBuilder::FormVerbalArriveInstruction(Maneuver& maneuver) {
     phrase_id = 1;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.arrive_verbal_subset.phrases.at(std::to_string(phrase_id));
+  // Set time value
+  std::string time = get_localized_time(maneuver.GetTransitArrivalTime(), dictionary_.GetLocale());
 
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kTransitPlatformTag, transit_stop_name);
-  boost::replace_all(instruction, kTimeTag,
-                     get_localized_time(maneuver.GetTransitArrivalTime(), dictionary_.GetLocale()));
+  // Set instruction to the determined tagged phrase with the tag values
+  instruction =
+      dictionary_.arrive_verbal_subset
+          .FormPhrase(phrase_id, {{kTransitPlatformTag, transit_stop_name},
+                                  {kTimeTag, time}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -2973,16 +2931,20 @@ std::string NarrativeBuilder::FormTransitInstruction(Maneuver& maneuver) {
     phrase_id = 1;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.transit_subset.phrases.at(std::to_string(phrase_id));
+  // Set transit_name value
+  std::string transit_name =
+      FormTransitName(maneuver, dictionary_.transit_subset.empty_transit_name_labels);
 
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kTransitNameTag,
-                     FormTransitName(maneuver, dictionary_.transit_subset.empty_transit_name_labels));
-  boost::replace_all(instruction, kTransitHeadSignTag, transit_headsign);
-  boost::replace_all(instruction, kTransitPlatformCountTag,
-                     std::to_string(stop_count)); // TODO: locale specific numerals
-  boost::replace_all(instruction, kTransitPlatformCountLabelTag, stop_count_label);
+  // Set transit_stop_count value
+  std::string transit_stop_count = std::to_string(stop_count); // TODO: locale specific numerals
+
+  // Set instruction to the determined tagged phrase with the tag values
+  instruction =
+      dictionary_.transit_subset
+          .FormPhrase(phrase_id, {{kTransitNameTag, transit_name},
+                                  {kTransitHeadSignTag, transit_headsign},
+                                  {kTransitPlatformCountTag, transit_stop_count},
+                                  {kTransitPlatformCountLabelTag, stop_count_label}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3005,14 +2967,15 @@ std::string NarrativeBuilder::FormVerbalTransitInstruction(Maneuver& maneuver) {
     phrase_id = 1;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.transit_verbal_subset.phrases.at(std::to_string(phrase_id));
+  // Set transit_name value
+  std::string transit_name =
+      FormTransitName(maneuver, dictionary_.transit_verbal_subset.empty_transit_name_labels);
 
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kTransitNameTag,
-                     FormTransitName(maneuver,
-                                     dictionary_.transit_verbal_subset.empty_transit_name_labels));
-  boost::replace_all(instruction, kTransitHeadSignTag, transit_headsign);
+  // Set instruction to the determined tagged phrase with the tag values
+  instruction =
+      dictionary_.transit_verbal_subset
+          .FormPhrase(phrase_id, {{kTransitNameTag, transit_name},
+                                  {kTransitHeadSignTag, transit_headsign}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3040,17 +3003,20 @@ std::string NarrativeBuilder::FormTransitRemainOnInstruction(Maneuver& maneuver)
     phrase_id = 1;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.transit_remain_on_subset.phrases.at(std::to_string(phrase_id));
+  // Set transit_name value
+  std::string transit_name =
+      FormTransitName(maneuver, dictionary_.transit_remain_on_subset.empty_transit_name_labels);
 
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kTransitNameTag,
-                     FormTransitName(maneuver,
-                                     dictionary_.transit_remain_on_subset.empty_transit_name_labels));
-  boost::replace_all(instruction, kTransitHeadSignTag, transit_headsign);
-  boost::replace_all(instruction, kTransitPlatformCountTag,
-                     std::to_string(stop_count)); // TODO: locale specific numerals
-  boost::replace_all(instruction, kTransitPlatformCountLabelTag, stop_count_label);
+  // Set transit_stop_count value
+  std::string transit_stop_count = std::to_string(stop_count); // TODO: locale specific numerals
+
+  // Set instruction to the determined tagged phrase with the tag values
+  instruction =
+      dictionary_.transit_remain_on_subset
+          .FormPhrase(phrase_id, {{kTransitNameTag, transit_name},
+                                  {kTransitHeadSignTag, transit_headsign},
+                                  {kTransitPlatformCountTag, transit_stop_count},
+                                  {kTransitPlatformCountLabelTag, stop_count_label}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3073,14 +3039,16 @@ std::string NarrativeBuilder::FormVerbalTransitRemainOnInstruction(Maneuver& man
     phrase_id = 1;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.transit_remain_on_verbal_subset.phrases.at(std::to_string(phrase_id));
+  // Set transit_name value
+  std::string transit_name =
+      FormTransitName(maneuver,
+                      dictionary_.transit_remain_on_verbal_subset.empty_transit_name_labels);
 
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kTransitNameTag,
-                     FormTransitName(maneuver, dictionary_.transit_remain_on_verbal_subset
-                                                   .empty_transit_name_labels));
-  boost::replace_all(instruction, kTransitHeadSignTag, transit_headsign);
+  // Set instruction to the determined tagged phrase with the tag values
+  instruction =
+      dictionary_.transit_remain_on_verbal_subset
+          .FormPhrase(phrase_id, {{kTransitNameTag, transit_name},
+                                  {kTransitHeadSignTag, transit_headsign}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3108,17 +3076,20 @@ std::string NarrativeBuilder::FormTransitTransferInstruction(Maneuver& maneuver)
     phrase_id = 1;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.transit_transfer_subset.phrases.at(std::to_string(phrase_id));
+  // Set transit_name value
+  std::string transit_name =
+      FormTransitName(maneuver, dictionary_.transit_transfer_subset.empty_transit_name_labels);
 
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kTransitNameTag,
-                     FormTransitName(maneuver,
-                                     dictionary_.transit_transfer_subset.empty_transit_name_labels));
-  boost::replace_all(instruction, kTransitHeadSignTag, transit_headsign);
-  boost::replace_all(instruction, kTransitPlatformCountTag,
-                     std::to_string(stop_count)); // TODO: locale specific numerals
-  boost::replace_all(instruction, kTransitPlatformCountLabelTag, stop_count_label);
+  // Set transit_stop_count value
+  std::string transit_stop_count = std::to_string(stop_count); // TODO: locale specific numerals
+
+  // Set instruction to the determined tagged phrase with the tag values
+  instruction =
+      dictionary_.transit_transfer_subset
+          .FormPhrase(phrase_id, {{kTransitNameTag, transit_name},
+                                  {kTransitHeadSignTag, transit_headsign},
+                                  {kTransitPlatformCountTag, transit_stop_count},
+                                  {kTransitPlatformCountLabelTag, stop_count_label}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3141,14 +3112,16 @@ std::string NarrativeBuilder::FormVerbalTransitTransferInstruction(Maneuver& man
     phrase_id = 1;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.transit_transfer_verbal_subset.phrases.at(std::to_string(phrase_id));
+  // Set transit_name value
+  std::string transit_name =
+      FormTransitName(maneuver,
+                      dictionary_.transit_transfer_verbal_subset.empty_transit_name_labels);
 
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kTransitNameTag,
-                     FormTransitName(maneuver, dictionary_.transit_transfer_verbal_subset
-                                                   .empty_transit_name_labels));
-  boost::replace_all(instruction, kTransitHeadSignTag, transit_headsign);
+  // Set instruction to the determined tagged phrase with the tag values
+  instruction =
+      dictionary_.transit_transfer_verbal_subset
+          .FormPhrase(phrase_id, {{kTransitNameTag, transit_name},
+                                  {kTransitHeadSignTag, transit_headsign}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3207,14 +3180,12 @@ std::string NarrativeBuilder::FormPostTransitConnectionDestinationInstruction(Ma
     phrase_id += 16;
   }
 
-  // Set instruction to the determined tagged phrase
+  // Set instruction to the determined tagged phrase with the tag values
   instruction =
-      dictionary_.post_transit_connection_destination_subset.phrases.at(std::to_string(phrase_id));
-
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kCardinalDirectionTag, cardinal_direction);
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
-  boost::replace_all(instruction, kBeginStreetNamesTag, begin_street_names);
+      dictionary_.post_transit_connection_destination_subset
+          .FormPhrase(phrase_id, {{kCardinalDirectionTag, cardinal_direction},
+                                  {kStreetNamesTag, street_names},
+                                  {kBeginStreetNamesTag, begin_street_names}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3278,14 +3249,12 @@ NarrativeBuilder::FormVerbalPostTransitConnectionDestinationInstruction(Maneuver
     phrase_id += 16;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.post_transit_connection_destination_verbal_subset.phrases.at(
-      std::to_string(phrase_id));
-
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kCardinalDirectionTag, cardinal_direction);
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
-  boost::replace_all(instruction, kBeginStreetNamesTag, begin_street_names);
+  // Set instruction to the determined tagged phrase with the tag values
+  instruction =
+      dictionary_.post_transit_connection_destination_verbal_subset
+          .FormPhrase(phrase_id, {{kCardinalDirectionTag, cardinal_direction},
+                                  {kStreetNamesTag, street_names},
+                                  {kBeginStreetNamesTag, begin_street_names}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3317,14 +3286,17 @@ std::string NarrativeBuilder::FormVerbalPostTransitionInstruction(Maneuver& mane
     phrase_id = 1;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.post_transition_verbal_subset.phrases.at(std::to_string(phrase_id));
+  // Set length value
+  std::string length =
+      FormLength(maneuver,
+                 dictionary_.post_transition_verbal_subset.metric_lengths,
+                 dictionary_.post_transition_verbal_subset.us_customary_lengths);
 
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kLengthTag,
-                     FormLength(maneuver, dictionary_.post_transition_verbal_subset.metric_lengths,
-                                dictionary_.post_transition_verbal_subset.us_customary_lengths));
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
+  // Set instruction to the determined tagged phrase with the tag values
+  instruction =
+      dictionary_.post_transition_verbal_subset
+          .FormPhrase(phrase_id, {{kLengthTag, length},
+                                  {kStreetNamesTag, street_names}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3345,14 +3317,14 @@ std::string NarrativeBuilder::FormVerbalPostTransitionTransitInstruction(Maneuve
       FormTransitPlatformCountLabel(stop_count, dictionary_.post_transition_transit_verbal_subset
                                                     .transit_stop_count_labels);
 
-  // Set instruction to the determined tagged phrase
-  instruction =
-      dictionary_.post_transition_transit_verbal_subset.phrases.at(std::to_string(phrase_id));
+  // Set transit_stop_count value
+  std::string transit_stop_count = std::to_string(stop_count); // TODO: locale specific numerals
 
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kTransitPlatformCountTag,
-                     std::to_string(stop_count)); // TODO: locale specific numerals
-  boost::replace_all(instruction, kTransitPlatformCountLabelTag, stop_count_label);
+  // Set instruction to the determined tagged phrase with the tag values
+  instruction =
+      dictionary_.post_transition_transit_verbal_subset
+          .FormPhrase(phrase_id, {{kTransitPlatformCountTag, transit_stop_count},
+                                  {kTransitPlatformCountLabelTag, stop_count_label}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3667,11 +3639,9 @@ std::string NarrativeBuilder::FormVerbalMultiCue(Maneuver* maneuver, Maneuver& n
                                     : next_maneuver.verbal_pre_transition_instruction();
 
   // Set instruction to the verbal multi-cue
-  instruction = dictionary_.verbal_multi_cue_subset.phrases.at("0");
-
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kCurrentVerbalCueTag, current_verbal_cue);
-  boost::replace_all(instruction, kNextVerbalCueTag, next_verbal_cue);
+  instruction =
+      dictionary_.verbal_multi_cue_subset.FormPhrase(0, {{kCurrentVerbalCueTag, current_verbal_cue},
+                                                         {kNextVerbalCueTag, next_verbal_cue}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -1,8 +1,12 @@
+#include <chrono>
 #include <cstdint>
+#include <exception>
 #include <functional>
+#include <memory>
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 
@@ -26,22 +30,65 @@ using namespace valhalla::baldr;
 namespace valhalla {
 namespace odin {
 
-odin_worker_t::odin_worker_t(const boost::property_tree::ptree& config) {
+odin_worker_t::odin_worker_t(const boost::property_tree::ptree& config)
+    : concurrency(
+          config.get<unsigned int>("odin.concurrency", std::thread::hardware_concurrency())),
+      message_arena(shm_message_arena_t::from_config(config)) {
 }
 
 odin_worker_t::~odin_worker_t() {
 }
 
 void odin_worker_t::cleanup() {
+  // the directions were serialized before cleanup runs so the arena backing
+  // the parsed legs may be recycled for the next request
+  arena.Reset();
 }
 
 std::list<TripDirections> odin_worker_t::narrate(const valhalla_request_t& request,
-                                                 std::list<TripPath>& legs) const {
+                                                 std::list<TripPath*>& legs) const {
   // get some annotated directions
   std::list<TripDirections> narrated;
   try {
-    for (auto& leg : legs) {
-      narrated.emplace_back(odin::DirectionsBuilder().Build(request.options, leg));
+    // single leg trips are annotated inline to skip the thread start cost
+    if (legs.size() < 2 || concurrency < 2) {
+      for (auto* leg : legs) {
+        narrated.emplace_back(odin::DirectionsBuilder().Build(request.options, *leg));
+        LOG_INFO("maneuver_count::" + std::to_string(narrated.back().maneuver_size()));
+      }
+      return narrated;
+    }
+
+    // the legs of a trip are independent of one another once the paths are
+    // built so they can be annotated concurrently, which bounds the latency
+    // of a many leg trip by its longest leg rather than the sum of its legs
+    std::vector<TripPath*> leg_paths(legs.begin(), legs.end());
+    std::vector<TripDirections> narrated_legs(leg_paths.size());
+    size_t thread_count = std::min<size_t>(concurrency, leg_paths.size());
+    std::vector<std::shared_ptr<std::thread>> threads(thread_count);
+    std::vector<std::exception_ptr> failures(thread_count);
+    for (size_t t = 0; t < threads.size(); ++t) {
+      threads[t].reset(new std::thread(
+          [&request, &leg_paths, &narrated_legs, thread_count](size_t start,
+                                                               std::exception_ptr& failure) {
+            try {
+              for (size_t i = start; i < leg_paths.size(); i += thread_count) {
+                narrated_legs[i] = odin::DirectionsBuilder().Build(request.options, *leg_paths[i]);
+              }
+            } catch (...) { failure = std::current_exception(); }
+          },
+          t, std::ref(failures[t])));
+    }
+    for (const auto& thread : threads) {
+      thread->join();
+    }
+    for (const auto& failure : failures) {
+      if (failure) {
+        std::rethrow_exception(failure);
+      }
+    }
+    for (auto& narrated_leg : narrated_legs) {
+      narrated.emplace_back(std::move(narrated_leg));
       LOG_INFO("maneuver_count::" + std::to_string(narrated.back().maneuver_size()));
     }
   } catch (...) { throw valhalla_exception_t{202}; }
@@ -52,31 +99,58 @@ std::list<TripDirections> odin_worker_t::narrate(const valhalla_request_t& reque
 worker_t::result_t odin_worker_t::work(const std::list<zmq::message_t>& job,
                                        void* request_info,
                                        const std::function<void()>& interrupt_function) {
+  // get time for start of request
+  auto s = std::chrono::system_clock::now();
   auto& info = *static_cast<http_request_info_t*>(request_info);
   LOG_INFO("Got Odin Request " + std::to_string(info.id));
   valhalla_request_t request;
   try {
-    // crack open the original request
+    // crack open the original request, either of its parts may be a handle
+    // to bytes an earlier stage stashed in shared memory
     std::string request_str(static_cast<const char*>(job.front().data()), job.front().size());
     std::string serialized_options(static_cast<const char*>((++job.cbegin())->data()),
                                    (++job.cbegin())->size());
+    if (message_arena && shm_message_arena_t::is_handle(request_str) &&
+        !message_arena->fetch(request_str, request_str)) {
+      return jsonify_error({200}, info, request);
+    }
+    if (message_arena && shm_message_arena_t::is_handle(serialized_options) &&
+        !message_arena->fetch(serialized_options, serialized_options)) {
+      return jsonify_error({200}, info, request);
+    }
     request.parse(request_str, serialized_options);
 
     // Set the interrupt function
     service_worker_t::set_interrupt(interrupt_function);
 
-    // parse each leg
-    std::list<TripPath> legs;
+    // parse each leg onto the arena - a long leg otherwise costs thousands
+    // of small heap allocations
+    std::list<TripPath*> legs;
     for (auto leg = ++(++job.cbegin()); leg != job.cend(); ++leg) {
       // crack open the path
-      legs.emplace_back();
+      legs.emplace_back(google::protobuf::Arena::CreateMessage<TripPath>(&arena));
+      // a big leg may have been stashed in shared memory by thor, in which
+      // case it parses straight from the mapped bytes
+      if (message_arena && shm_message_arena_t::is_handle(leg->data(), leg->size())) {
+        std::string handle(static_cast<const char*>(leg->data()), leg->size());
+        if (!message_arena->fetch(handle, [&legs](const void* data, size_t size) {
+              return legs.back()->ParseFromArray(data, static_cast<int>(size));
+            })) {
+          return jsonify_error({201}, info, request);
+        }
+        continue;
+      }
       try {
-        legs.back().ParseFromArray(leg->data(), static_cast<int>(leg->size()));
+        legs.back()->ParseFromArray(leg->data(), static_cast<int>(leg->size()));
       } catch (...) { return jsonify_error({201}, info, request); }
     }
 
-    // narrate them and serialize them along
+    // narrate them and serialize them along. the narration time is recorded
+    // before serialization so the serializer can surface the full pipeline
     auto narrated = narrate(request, legs);
+    add_stage_trace(request.options, "odin",
+                    std::chrono::duration<float, std::milli>(std::chrono::system_clock::now() - s)
+                        .count());
     auto response = tyr::serializeDirections(request, legs, narrated);
     auto* to_response =
         request.options.format() == DirectionsOptions::gpx ? to_response_xml : to_response_json;
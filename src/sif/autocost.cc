@@ -5,6 +5,7 @@
 #include "baldr/directededge.h"
 #include "baldr/nodeinfo.h"
 #include "midgard/constants.h"
+#include "midgard/logging.h"
 #include "midgard/util.h"
 
 #ifdef INLINE_TEST
@@ -39,6 +40,19 @@ constexpr float kDefaultUseFerry = 0.5f;    // Factor between 0 and 1
 constexpr float kDefaultUseHighways = 1.0f; // Factor between 0 and 1
 constexpr float kDefaultUseTolls = 0.5f;    // Factor between 0 and 1
 
+#ifdef FIXED_COSTING_PROFILES
+// A fixed costing profile build bakes the default auto options in at
+// compile time, so the factors below are constants the compiler folds into
+// the edge costing instead of members loaded per edge. The derivations
+// mirror what the constructor computes from the defaults
+constexpr float kFixedSurfaceFactor = 0.5f; // the default car profile
+constexpr float kFixedHighwayFactor = 1.0f - kDefaultUseHighways;
+constexpr float kFixedTollFactor = kDefaultUseTolls < 0.5f
+                                       ? (2.0f - 4 * kDefaultUseTolls)
+                                       : (0.5f - kDefaultUseTolls) * 0.03f;
+constexpr float kFixedFerryFactor = 1.5f - kDefaultUseFerry;
+#endif
+
 // Default turn costs
 constexpr float kTCStraight = 0.5f;
 constexpr float kTCSlight = 0.75f;
@@ -203,6 +217,20 @@ public:
    */
   virtual Cost EdgeCost(const baldr::DirectedEdge* edge, const uint32_t speed) const;
 
+  /**
+   * Get the costs to traverse a batch of directed edges from a single graph
+   * tile. Overridden with a loop over the pure table and factor math so the
+   * compiler can vectorize it.
+   * @param   edges   Pointers to the directed edges (from one graph tile).
+   * @param   speeds  Speed (kph) to use for each edge.
+   * @param   count   Number of edges to cost.
+   * @param   costs   Output array of costs, sized to hold count entries.
+   */
+  virtual void EdgeCosts(const baldr::DirectedEdge** edges,
+                         const uint32_t* speeds,
+                         const size_t count,
+                         Cost* costs) const;
+
   /**
    * Returns the cost to make the transition from the predecessor edge.
    * Defaults to 0. Costing models that wish to include edge transition
@@ -234,6 +262,44 @@ public:
                                      const baldr::DirectedEdge* edge,
                                      const bool has_traffic = false) const;
 
+  /**
+   * Evaluate an edge for forward expansion in a single dispatch, with the
+   * access check and cost math statically bound to this costing.
+   */
+  virtual bool EvaluateForward(const baldr::DirectedEdge* edge,
+                               const baldr::NodeInfo* node,
+                               const EdgeLabel& pred,
+                               const baldr::GraphTile*& tile,
+                               const baldr::GraphId& edgeid,
+                               const uint64_t current_time,
+                               const uint32_t tz_index,
+                               const uint32_t speed,
+                               Cost& transition_cost,
+                               Cost& newcost) const {
+    return EvaluateForwardImpl(*this, edge, node, pred, tile, edgeid, current_time, tz_index, speed,
+                               transition_cost, newcost);
+  }
+
+  /**
+   * Evaluate an edge for reverse expansion in a single dispatch, with the
+   * access check and cost math statically bound to this costing.
+   */
+  virtual bool EvaluateReverse(const baldr::DirectedEdge* edge,
+                               const EdgeLabel& pred,
+                               const baldr::DirectedEdge* opp_edge,
+                               const baldr::NodeInfo* node,
+                               const baldr::DirectedEdge* opp_pred_edge,
+                               const baldr::GraphTile*& tile,
+                               const baldr::GraphId& opp_edgeid,
+                               const uint64_t current_time,
+                               const uint32_t tz_index,
+                               const uint32_t speed,
+                               Cost& transition_cost,
+                               Cost& newcost) const {
+    return EvaluateReverseImpl(*this, edge, pred, opp_edge, node, opp_pred_edge, tile, opp_edgeid,
+                               current_time, tz_index, speed, transition_cost, newcost);
+  }
+
   /**
    * Get the cost factor for A* heuristics. This factor is multiplied
    * with the distance to the destination to produce an estimate of the
@@ -264,7 +330,7 @@ public:
   virtual const EdgeFilter GetEdgeFilter() const {
     // Throw back a lambda that checks the access for this type of costing
     return [](const baldr::DirectedEdge* edge) {
-      if (edge->is_shortcut() || !(edge->forwardaccess() & kAutoAccess)) {
+      if (edge->is_shortcut() || !edge->forwardaccess_allowed<kAutoAccess>()) {
         return 0.0f;
       } else {
         // TODO - use classification/use to alter the factor
@@ -295,6 +361,13 @@ public:
 
   // Density factor used in edge transition costing
   std::vector<float> trans_density_factor_;
+
+  // Turn cost factors (density factor * turn cost) precomputed at
+  // construction over side of street, density and turn type so the
+  // transition cost in the expansion loop collapses to a table fetch
+  // and a multiply by stop impact
+  float turn_cost_factor_[2][16][8];
+  float crossing_cost_factor_[16];
 };
 
 // Constructor
@@ -350,6 +423,26 @@ AutoCost::AutoCost(const odin::Costing costing, const odin::DirectionsOptions& o
   for (uint32_t d = 0; d < 16; d++) {
     density_factor_[d] = 0.85f + (d * 0.025f);
   }
+
+  // Precompute turn cost factors by side of street, density and turn type
+  // so TransitionCost does not redo the turn type branching and density
+  // multiply per node transition
+  for (uint32_t d = 0; d < 16; d++) {
+    crossing_cost_factor_[d] = trans_density_factor_[d] * kTCCrossing;
+    for (uint32_t t = 0; t < 8; t++) {
+      turn_cost_factor_[0][d][t] = trans_density_factor_[d] * kLeftSideTurnCosts[t];
+      turn_cost_factor_[1][d][t] = trans_density_factor_[d] * kRightSideTurnCosts[t];
+    }
+  }
+
+#ifdef FIXED_COSTING_PROFILES
+  // the edge costing uses the baked factors, a request asking for different
+  // ones is costed with the fixed profile so at least say so
+  if (surface_factor_ != kFixedSurfaceFactor || highway_factor_ != kFixedHighwayFactor ||
+      toll_factor_ != kFixedTollFactor || ferry_factor_ != kFixedFerryFactor) {
+    LOG_WARN("Fixed costing profile build ignores the requested auto costing factors");
+  }
+#endif
 }
 
 // Check if access is allowed on the specified edge.
@@ -363,7 +456,7 @@ bool AutoCost::Allowed(const baldr::DirectedEdge* edge,
   // Allow U-turns at dead-end nodes in case the origin is inside
   // a not thru region and a heading selected an edge entering the
   // region.
-  if (!(edge->forwardaccess() & kAutoAccess) ||
+  if (!edge->forwardaccess_allowed<kAutoAccess>() ||
       (!pred.deadend() && pred.opp_local_idx() == edge->localedgeidx()) ||
       (pred.restrictions() & (1 << edge->localedgeidx())) ||
       edge->surface() == Surface::kImpassable || IsUserAvoidEdge(edgeid) ||
@@ -402,7 +495,7 @@ bool AutoCost::AllowedReverse(const baldr::DirectedEdge* edge,
                               const uint32_t tz_index) const {
   // Check access, U-turn, and simple turn restriction.
   // Allow U-turns at dead-end nodes.
-  if (!(opp_edge->forwardaccess() & kAutoAccess) ||
+  if (!opp_edge->forwardaccess_allowed<kAutoAccess>() ||
       (!pred.deadend() && pred.opp_local_idx() == edge->localedgeidx()) ||
       (opp_edge->restrictions() & (1 << pred.opp_local_idx())) ||
       opp_edge->surface() == Surface::kImpassable || IsUserAvoidEdge(opp_edgeid) ||
@@ -432,18 +525,52 @@ bool AutoCost::AllowedReverse(const baldr::DirectedEdge* edge,
 
 // Get the cost to traverse the edge in seconds
 Cost AutoCost::EdgeCost(const DirectedEdge* edge, const uint32_t speed) const {
-  float factor = (edge->use() == Use::kFerry) ? ferry_factor_ : density_factor_[edge->density()];
+#ifdef FIXED_COSTING_PROFILES
+  constexpr float ferry_factor = kFixedFerryFactor, highway_factor = kFixedHighwayFactor,
+                  surface_factor = kFixedSurfaceFactor, toll_factor = kFixedTollFactor;
+#else
+  const float ferry_factor = ferry_factor_, highway_factor = highway_factor_,
+              surface_factor = surface_factor_, toll_factor = toll_factor_;
+#endif
+  float factor = (edge->use() == Use::kFerry) ? ferry_factor : density_factor_[edge->density()];
 
-  factor += highway_factor_ * kHighwayFactor[static_cast<uint32_t>(edge->classification())] +
-            surface_factor_ * kSurfaceFactor[static_cast<uint32_t>(edge->surface())];
+  factor += highway_factor * kHighwayFactor[static_cast<uint32_t>(edge->classification())] +
+            surface_factor * kSurfaceFactor[static_cast<uint32_t>(edge->surface())];
   if (edge->toll()) {
-    factor += toll_factor_;
+    factor += toll_factor;
   }
 
   float sec = (edge->length() * speedfactor_[speed]);
   return Cost(sec * factor, sec);
 }
 
+// Get the costs to traverse a batch of directed edges from a single tile.
+// The edge cost is pure table and factor math, so the loop is a candidate
+// for vectorization and avoids a virtual dispatch per edge.
+void AutoCost::EdgeCosts(const baldr::DirectedEdge** edges,
+                         const uint32_t* speeds,
+                         const size_t count,
+                         Cost* costs) const {
+#ifdef FIXED_COSTING_PROFILES
+  constexpr float ferry_factor = kFixedFerryFactor, highway_factor = kFixedHighwayFactor,
+                  surface_factor = kFixedSurfaceFactor, toll_factor = kFixedTollFactor;
+#else
+  const float ferry_factor = ferry_factor_, highway_factor = highway_factor_,
+              surface_factor = surface_factor_, toll_factor = toll_factor_;
+#endif
+  for (size_t i = 0; i < count; i++) {
+    const DirectedEdge* edge = edges[i];
+    float factor = (edge->use() == Use::kFerry) ? ferry_factor : density_factor_[edge->density()];
+    factor += highway_factor * kHighwayFactor[static_cast<uint32_t>(edge->classification())] +
+              surface_factor * kSurfaceFactor[static_cast<uint32_t>(edge->surface())];
+    if (edge->toll()) {
+      factor += toll_factor;
+    }
+    float sec = (edge->length() * speedfactor_[speeds[i]]);
+    costs[i] = Cost(sec * factor, sec);
+  }
+}
+
 // Returns the time (in seconds) to make the transition from the predecessor
 Cost AutoCost::TransitionCost(const baldr::DirectedEdge* edge,
                               const baldr::NodeInfo* node,
@@ -457,22 +584,26 @@ Cost AutoCost::TransitionCost(const baldr::DirectedEdge* edge,
   // Intersection transition time = factor * stopimpact * turncost. Factor depends
   // on density and whether traffic is available
   if (edge->stopimpact(idx) > 0) {
-    float turn_cost;
-    if (edge->edge_to_right(idx) && edge->edge_to_left(idx)) {
-      turn_cost = kTCCrossing;
-    } else {
-      turn_cost = (node->drive_on_right())
-                      ? kRightSideTurnCosts[static_cast<uint32_t>(edge->turntype(idx))]
-                      : kLeftSideTurnCosts[static_cast<uint32_t>(edge->turntype(idx))];
-    }
-
     // Separate time and penalty when traffic is present. With traffic, edge speeds account for
     // much of the intersection transition time (TODO - evaluate different elapsed time settings).
     // Still want to add a penalty so routes avoid high cost intersections.
     if (has_traffic) {
+      float turn_cost;
+      if (edge->edge_to_right(idx) && edge->edge_to_left(idx)) {
+        turn_cost = kTCCrossing;
+      } else {
+        turn_cost = (node->drive_on_right())
+                        ? kRightSideTurnCosts[static_cast<uint32_t>(edge->turntype(idx))]
+                        : kLeftSideTurnCosts[static_cast<uint32_t>(edge->turntype(idx))];
+      }
       c.cost += turn_cost * edge->stopimpact(idx);
     } else {
-      float seconds = trans_density_factor_[node->density()] * turn_cost * edge->stopimpact(idx);
+      // The density factor and turn cost are fused in the precomputed table
+      float factor = (edge->edge_to_right(idx) && edge->edge_to_left(idx))
+                         ? crossing_cost_factor_[node->density()]
+                         : turn_cost_factor_[node->drive_on_right()][node->density()]
+                                            [static_cast<uint32_t>(edge->turntype(idx))];
+      float seconds = factor * edge->stopimpact(idx);
       c.cost += seconds;
       c.secs += seconds;
     }
@@ -493,17 +624,14 @@ Cost AutoCost::TransitionCostReverse(const uint32_t idx,
   // destination only, alley, maneuver penalty
   Cost c = base_transition_cost(node, edge, pred, idx);
 
-  // Transition time = densityfactor * stopimpact * turncost
+  // Transition time = densityfactor * stopimpact * turncost, with the
+  // density factor and turn cost fused in the precomputed table
   if (edge->stopimpact(idx) > 0) {
-    float turn_cost;
-    if (edge->edge_to_right(idx) && edge->edge_to_left(idx)) {
-      turn_cost = kTCCrossing;
-    } else {
-      turn_cost = (node->drive_on_right())
-                      ? kRightSideTurnCosts[static_cast<uint32_t>(edge->turntype(idx))]
-                      : kLeftSideTurnCosts[static_cast<uint32_t>(edge->turntype(idx))];
-    }
-    float seconds = trans_density_factor_[node->density()] * edge->stopimpact(idx) * turn_cost;
+    float factor = (edge->edge_to_right(idx) && edge->edge_to_left(idx))
+                       ? crossing_cost_factor_[node->density()]
+                       : turn_cost_factor_[node->drive_on_right()][node->density()]
+                                          [static_cast<uint32_t>(edge->turntype(idx))];
+    float seconds = factor * edge->stopimpact(idx);
     c.secs += seconds;
     c.cost += seconds;
   }
@@ -647,6 +775,44 @@ public:
                 edge->length() * speedfactor_[speed]);
   }
 
+  /**
+   * Evaluate an edge for forward expansion in a single dispatch, with the
+   * access check and cost math statically bound to this costing.
+   */
+  virtual bool EvaluateForward(const baldr::DirectedEdge* edge,
+                               const baldr::NodeInfo* node,
+                               const EdgeLabel& pred,
+                               const baldr::GraphTile*& tile,
+                               const baldr::GraphId& edgeid,
+                               const uint64_t current_time,
+                               const uint32_t tz_index,
+                               const uint32_t speed,
+                               Cost& transition_cost,
+                               Cost& newcost) const {
+    return EvaluateForwardImpl(*this, edge, node, pred, tile, edgeid, current_time, tz_index, speed,
+                               transition_cost, newcost);
+  }
+
+  /**
+   * Evaluate an edge for reverse expansion in a single dispatch, with the
+   * access check and cost math statically bound to this costing.
+   */
+  virtual bool EvaluateReverse(const baldr::DirectedEdge* edge,
+                               const EdgeLabel& pred,
+                               const baldr::DirectedEdge* opp_edge,
+                               const baldr::NodeInfo* node,
+                               const baldr::DirectedEdge* opp_pred_edge,
+                               const baldr::GraphTile*& tile,
+                               const baldr::GraphId& opp_edgeid,
+                               const uint64_t current_time,
+                               const uint32_t tz_index,
+                               const uint32_t speed,
+                               Cost& transition_cost,
+                               Cost& newcost) const {
+    return EvaluateReverseImpl(*this, edge, pred, opp_edge, node, opp_pred_edge, tile, opp_edgeid,
+                               current_time, tz_index, speed, transition_cost, newcost);
+  }
+
   /**
    * Get the cost factor for A* heuristics. This factor is multiplied
    * with the distance to the destination to produce an estimate of the
@@ -759,6 +925,44 @@ public:
     return (node->access() & kBusAccess);
   }
 
+  /**
+   * Evaluate an edge for forward expansion in a single dispatch, with the
+   * access check and cost math statically bound to this costing.
+   */
+  virtual bool EvaluateForward(const baldr::DirectedEdge* edge,
+                               const baldr::NodeInfo* node,
+                               const EdgeLabel& pred,
+                               const baldr::GraphTile*& tile,
+                               const baldr::GraphId& edgeid,
+                               const uint64_t current_time,
+                               const uint32_t tz_index,
+                               const uint32_t speed,
+                               Cost& transition_cost,
+                               Cost& newcost) const {
+    return EvaluateForwardImpl(*this, edge, node, pred, tile, edgeid, current_time, tz_index, speed,
+                               transition_cost, newcost);
+  }
+
+  /**
+   * Evaluate an edge for reverse expansion in a single dispatch, with the
+   * access check and cost math statically bound to this costing.
+   */
+  virtual bool EvaluateReverse(const baldr::DirectedEdge* edge,
+                               const EdgeLabel& pred,
+                               const baldr::DirectedEdge* opp_edge,
+                               const baldr::NodeInfo* node,
+                               const baldr::DirectedEdge* opp_pred_edge,
+                               const baldr::GraphTile*& tile,
+                               const baldr::GraphId& opp_edgeid,
+                               const uint64_t current_time,
+                               const uint32_t tz_index,
+                               const uint32_t speed,
+                               Cost& transition_cost,
+                               Cost& newcost) const {
+    return EvaluateReverseImpl(*this, edge, pred, opp_edge, node, opp_pred_edge, tile, opp_edgeid,
+                               current_time, tz_index, speed, transition_cost, newcost);
+  }
+
   /**
    * Returns a function/functor to be used in location searching which will
    * exclude and allow ranking results from the search by looking at each
@@ -769,7 +973,7 @@ public:
   virtual const EdgeFilter GetEdgeFilter() const {
     // Throw back a lambda that checks the access for this type of costing
     return [](const baldr::DirectedEdge* edge) {
-      if (!(edge->forwardaccess() & kBusAccess)) {
+      if (!edge->forwardaccess_allowed<kBusAccess>()) {
         return 0.0f;
       } else {
         // TODO - use classification/use to alter the factor
@@ -800,7 +1004,7 @@ bool BusCost::Allowed(const baldr::DirectedEdge* edge,
 
   // Check access, U-turn, and simple turn restriction.
   // Allow U-turns at dead-end nodes.
-  if (!(edge->forwardaccess() & kBusAccess) ||
+  if (!edge->forwardaccess_allowed<kBusAccess>() ||
       (!pred.deadend() && pred.opp_local_idx() == edge->localedgeidx()) ||
       (pred.restrictions() & (1 << edge->localedgeidx())) ||
       edge->surface() == Surface::kImpassable || IsUserAvoidEdge(edgeid) ||
@@ -839,7 +1043,7 @@ bool BusCost::AllowedReverse(const baldr::DirectedEdge* edge,
                              const uint32_t tz_index) const {
   // Check access, U-turn, and simple turn restriction.
   // Allow U-turns at dead-end nodes.
-  if (!(opp_edge->forwardaccess() & kBusAccess) ||
+  if (!opp_edge->forwardaccess_allowed<kBusAccess>() ||
       (!pred.deadend() && pred.opp_local_idx() == edge->localedgeidx()) ||
       (opp_edge->restrictions() & (1 << pred.opp_local_idx())) ||
       opp_edge->surface() == Surface::kImpassable || IsUserAvoidEdge(opp_edgeid) ||
@@ -960,7 +1164,7 @@ public:
    */
   virtual Cost EdgeCost(const baldr::DirectedEdge* edge, const uint32_t speed) const {
     float factor = (edge->use() == Use::kFerry) ? ferry_factor_ : density_factor_[edge->density()];
-    if ((edge->forwardaccess() & kHOVAccess) && !(edge->forwardaccess() & kAutoAccess)) {
+    if (edge->forwardaccess_allowed<kHOVAccess>() && !edge->forwardaccess_allowed<kAutoAccess>()) {
       factor *= kHOVFactor;
     }
     float sec = (edge->length() * speedfactor_[speed]);
@@ -977,6 +1181,44 @@ public:
     return (node->access() & kHOVAccess);
   }
 
+  /**
+   * Evaluate an edge for forward expansion in a single dispatch, with the
+   * access check and cost math statically bound to this costing.
+   */
+  virtual bool EvaluateForward(const baldr::DirectedEdge* edge,
+                               const baldr::NodeInfo* node,
+                               const EdgeLabel& pred,
+                               const baldr::GraphTile*& tile,
+                               const baldr::GraphId& edgeid,
+                               const uint64_t current_time,
+                               const uint32_t tz_index,
+                               const uint32_t speed,
+                               Cost& transition_cost,
+                               Cost& newcost) const {
+    return EvaluateForwardImpl(*this, edge, node, pred, tile, edgeid, current_time, tz_index, speed,
+                               transition_cost, newcost);
+  }
+
+  /**
+   * Evaluate an edge for reverse expansion in a single dispatch, with the
+   * access check and cost math statically bound to this costing.
+   */
+  virtual bool EvaluateReverse(const baldr::DirectedEdge* edge,
+                               const EdgeLabel& pred,
+                               const baldr::DirectedEdge* opp_edge,
+                               const baldr::NodeInfo* node,
+                               const baldr::DirectedEdge* opp_pred_edge,
+                               const baldr::GraphTile*& tile,
+                               const baldr::GraphId& opp_edgeid,
+                               const uint64_t current_time,
+                               const uint32_t tz_index,
+                               const uint32_t speed,
+                               Cost& transition_cost,
+                               Cost& newcost) const {
+    return EvaluateReverseImpl(*this, edge, pred, opp_edge, node, opp_pred_edge, tile, opp_edgeid,
+                               current_time, tz_index, speed, transition_cost, newcost);
+  }
+
   /**
    * Returns a function/functor to be used in location searching which will
    * exclude and allow ranking results from the search by looking at each
@@ -987,7 +1229,7 @@ public:
   virtual const EdgeFilter GetEdgeFilter() const {
     // Throw back a lambda that checks the access for this type of costing
     return [](const baldr::DirectedEdge* edge) {
-      if (!(edge->forwardaccess() & kHOVAccess)) {
+      if (!edge->forwardaccess_allowed<kHOVAccess>()) {
         return 0.0f;
       } else {
         // TODO - use classification/use to alter the factor
@@ -1020,7 +1262,7 @@ bool HOVCost::Allowed(const baldr::DirectedEdge* edge,
   // Allow U-turns at dead-end nodes in case the origin is inside
   // a not thru region and a heading selected an edge entering the
   // region.
-  if (!(edge->forwardaccess() & kHOVAccess) ||
+  if (!edge->forwardaccess_allowed<kHOVAccess>() ||
       (!pred.deadend() && pred.opp_local_idx() == edge->localedgeidx()) ||
       (pred.restrictions() & (1 << edge->localedgeidx())) ||
       edge->surface() == Surface::kImpassable || IsUserAvoidEdge(edgeid) ||
@@ -1060,7 +1302,7 @@ bool HOVCost::AllowedReverse(const baldr::DirectedEdge* edge,
 
   // Check access, U-turn, and simple turn restriction.
   // Allow U-turns at dead-end nodes.
-  if (!(opp_edge->forwardaccess() & kHOVAccess) ||
+  if (!opp_edge->forwardaccess_allowed<kHOVAccess>() ||
       (!pred.deadend() && pred.opp_local_idx() == edge->localedgeidx()) ||
       (opp_edge->restrictions() & (1 << pred.opp_local_idx())) ||
       opp_edge->surface() == Surface::kImpassable || IsUserAvoidEdge(opp_edgeid) ||
@@ -1140,7 +1382,8 @@ public:
                        const uint32_t tz_index) const {
     // Check access and return false (not allowed if no auto access is allowed in either
     // direction. Also disallow simple U-turns except at dead-end nodes.
-    if (!((edge->forwardaccess() & kAutoAccess) || (edge->reverseaccess() & kAutoAccess)) ||
+    if (!(edge->forwardaccess_allowed<kAutoAccess>() ||
+          edge->reverseaccess_allowed<kAutoAccess>()) ||
         (!pred.deadend() && pred.opp_local_idx() == edge->localedgeidx()) ||
         edge->surface() == Surface::kImpassable || IsUserAvoidEdge(edgeid) ||
         (!allow_destination_only_ && !pred.destonly() && edge->destonly())) {
@@ -1149,6 +1392,44 @@ public:
     return true;
   }
 
+  /**
+   * Evaluate an edge for forward expansion in a single dispatch, with the
+   * access check and cost math statically bound to this costing.
+   */
+  virtual bool EvaluateForward(const baldr::DirectedEdge* edge,
+                               const baldr::NodeInfo* node,
+                               const EdgeLabel& pred,
+                               const baldr::GraphTile*& tile,
+                               const baldr::GraphId& edgeid,
+                               const uint64_t current_time,
+                               const uint32_t tz_index,
+                               const uint32_t speed,
+                               Cost& transition_cost,
+                               Cost& newcost) const {
+    return EvaluateForwardImpl(*this, edge, node, pred, tile, edgeid, current_time, tz_index, speed,
+                               transition_cost, newcost);
+  }
+
+  /**
+   * Evaluate an edge for reverse expansion in a single dispatch, with the
+   * access check and cost math statically bound to this costing.
+   */
+  virtual bool EvaluateReverse(const baldr::DirectedEdge* edge,
+                               const EdgeLabel& pred,
+                               const baldr::DirectedEdge* opp_edge,
+                               const baldr::NodeInfo* node,
+                               const baldr::DirectedEdge* opp_pred_edge,
+                               const baldr::GraphTile*& tile,
+                               const baldr::GraphId& opp_edgeid,
+                               const uint64_t current_time,
+                               const uint32_t tz_index,
+                               const uint32_t speed,
+                               Cost& transition_cost,
+                               Cost& newcost) const {
+    return EvaluateReverseImpl(*this, edge, pred, opp_edge, node, opp_pred_edge, tile, opp_edgeid,
+                               current_time, tz_index, speed, transition_cost, newcost);
+  }
+
   /**
    * Returns a function/functor to be used in location searching which will
    * exclude and allow ranking results from the search by looking at each
@@ -1160,7 +1441,8 @@ public:
     // Throw back a lambda that checks the access for this type of costing
     return [](const baldr::DirectedEdge* edge) {
       // Do not allow edges with no auto access in either direction
-      if (!((edge->forwardaccess() & kAutoAccess) || (edge->reverseaccess() & kAutoAccess))) {
+      if (!(edge->forwardaccess_allowed<kAutoAccess>() ||
+            edge->reverseaccess_allowed<kAutoAccess>())) {
         return 0.0f;
       } else {
         return 1.0f;
@@ -327,6 +327,44 @@ public:
                                      const baldr::DirectedEdge* edge,
                                      const bool has_traffic = false) const;
 
+  /**
+   * Evaluate an edge for forward expansion in a single dispatch, with the
+   * access check and cost math statically bound to this costing.
+   */
+  virtual bool EvaluateForward(const baldr::DirectedEdge* edge,
+                               const baldr::NodeInfo* node,
+                               const EdgeLabel& pred,
+                               const baldr::GraphTile*& tile,
+                               const baldr::GraphId& edgeid,
+                               const uint64_t current_time,
+                               const uint32_t tz_index,
+                               const uint32_t speed,
+                               Cost& transition_cost,
+                               Cost& newcost) const {
+    return EvaluateForwardImpl(*this, edge, node, pred, tile, edgeid, current_time, tz_index, speed,
+                               transition_cost, newcost);
+  }
+
+  /**
+   * Evaluate an edge for reverse expansion in a single dispatch, with the
+   * access check and cost math statically bound to this costing.
+   */
+  virtual bool EvaluateReverse(const baldr::DirectedEdge* edge,
+                               const EdgeLabel& pred,
+                               const baldr::DirectedEdge* opp_edge,
+                               const baldr::NodeInfo* node,
+                               const baldr::DirectedEdge* opp_pred_edge,
+                               const baldr::GraphTile*& tile,
+                               const baldr::GraphId& opp_edgeid,
+                               const uint64_t current_time,
+                               const uint32_t tz_index,
+                               const uint32_t speed,
+                               Cost& transition_cost,
+                               Cost& newcost) const {
+    return EvaluateReverseImpl(*this, edge, pred, opp_edge, node, opp_pred_edge, tile, opp_edgeid,
+                               current_time, tz_index, speed, transition_cost, newcost);
+  }
+
   /**
    * Get the cost factor for A* heuristics. This factor is multiplied
    * with the distance to the destination to produce an estimate of the
@@ -391,7 +429,7 @@ protected:
     // Throw back a lambda that checks the access for this type of costing
     Surface s = worst_allowed_surface_;
     return [s](const baldr::DirectedEdge* edge) {
-      if (edge->is_shortcut() || !(edge->forwardaccess() & kBicycleAccess) ||
+      if (edge->is_shortcut() || !edge->forwardaccess_allowed<kBicycleAccess>() ||
           edge->use() == Use::kSteps || edge->surface() > s) {
         return 0.0f;
       } else {
@@ -505,8 +543,9 @@ bool BicycleCost::Allowed(const baldr::DirectedEdge* edge,
                           const uint32_t tz_index) const {
   // Check bicycle access and turn restrictions. Bicycles should obey
   // vehicular turn restrictions. Allow Uturns at dead ends only.
-  // Skip impassable edges and shortcut edges.
-  if (!(edge->forwardaccess() & kBicycleAccess) || edge->is_shortcut() ||
+  // Skip impassable edges. Shortcuts are allowed - the shortcut builder
+  // drops bicycle access from any whose attributes vary along the chain.
+  if (!edge->forwardaccess_allowed<kBicycleAccess>() ||
       (!pred.deadend() && pred.opp_local_idx() == edge->localedgeidx()) ||
       (pred.restrictions() & (1 << edge->localedgeidx())) || IsUserAvoidEdge(edgeid)) {
     return false;
@@ -553,7 +592,7 @@ bool BicycleCost::AllowedReverse(const baldr::DirectedEdge* edge,
                                  const uint32_t tz_index) const {
   // Check access, U-turn (allow at dead-ends), and simple turn restriction.
   // Do not allow transit connection edges.
-  if (!(opp_edge->forwardaccess() & kBicycleAccess) || opp_edge->is_shortcut() ||
+  if (!opp_edge->forwardaccess_allowed<kBicycleAccess>() ||
       opp_edge->use() == Use::kTransitConnection || opp_edge->use() == Use::kEgressConnection ||
       opp_edge->use() == Use::kPlatformConnection ||
       (!pred.deadend() && pred.opp_local_idx() == edge->localedgeidx()) ||
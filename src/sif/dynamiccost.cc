@@ -14,10 +14,14 @@ DynamicCost::DynamicCost(const odin::DirectionsOptions& options, const TravelMod
     hierarchy_limits_.emplace_back(HierarchyLimits(level));
   }
 
-  // Add avoid edges to internal set
+  // Add avoid edges to the internal per tile bitmaps
   for (auto& edgeid : options.avoid_edges()) {
-    user_avoid_edges_.insert(GraphId(edgeid));
+    AddUserAvoidEdge(GraphId(edgeid));
   }
+
+  // Capture a baseline of the mutable state. The factory snapshots again
+  // once the most derived constructor has finished
+  SnapshotDefaultState();
 }
 
 DynamicCost::~DynamicCost() {
@@ -47,6 +51,18 @@ Cost DynamicCost::EdgeCost(const baldr::DirectedEdge* edge, const uint32_t speed
   return {0.0f, 0.0f};
 }
 
+// Get the costs to traverse a batch of directed edges from a single tile.
+// Prices the edges one at a time - costings with table driven edge cost
+// math may override with a vectorizable loop.
+void DynamicCost::EdgeCosts(const baldr::DirectedEdge** edges,
+                            const uint32_t* speeds,
+                            const size_t count,
+                            Cost* costs) const {
+  for (size_t i = 0; i < count; i++) {
+    costs[i] = EdgeCost(edges[i], speeds[i]);
+  }
+}
+
 // Returns the cost to make the transition from the predecessor edge.
 // Defaults to 0. Costing models that wish to include edge transition
 // costs (i.e., intersection/turn costs) must override this method.
@@ -129,6 +145,24 @@ void DynamicCost::RelaxHierarchyLimits(const float factor, const float expansion
   }
 }
 
+// Snapshot the per request mutable state as the defaults for this costing.
+void DynamicCost::SnapshotDefaultState() {
+  default_pass_ = pass_;
+  default_allow_transit_connections_ = allow_transit_connections_;
+  default_allow_destination_only_ = allow_destination_only_;
+  default_travel_mode_ = travel_mode_;
+  default_hierarchy_limits_ = hierarchy_limits_;
+}
+
+// Restore the per request mutable state captured by SnapshotDefaultState.
+void DynamicCost::RestoreDefaultState() {
+  pass_ = default_pass_;
+  allow_transit_connections_ = default_allow_transit_connections_;
+  allow_destination_only_ = default_allow_destination_only_;
+  travel_mode_ = default_travel_mode_;
+  hierarchy_limits_ = default_hierarchy_limits_;
+}
+
 // Set the current travel mode.
 void DynamicCost::set_travel_mode(const TravelMode mode) {
   travel_mode_ = mode;
@@ -172,8 +206,18 @@ bool DynamicCost::IsExcluded(const baldr::GraphTile*& tile, const baldr::NodeInf
 // Adds a list of edges (GraphIds) to the user specified avoid list.
 void DynamicCost::AddUserAvoidEdges(const std::vector<GraphId>& avoid_edges) {
   for (auto edgeid : avoid_edges) {
-    user_avoid_edges_.insert(edgeid);
+    AddUserAvoidEdge(edgeid);
+  }
+}
+
+// Set the bit for a single avoided edge in its tile's bitmap.
+void DynamicCost::AddUserAvoidEdge(const GraphId& edgeid) {
+  auto& mask = user_avoid_edges_[edgeid.Tile_Base().value];
+  const uint64_t word = edgeid.id() >> 6;
+  if (mask.size() <= word) {
+    mask.resize(word + 1, 0);
   }
+  mask[word] |= uint64_t(1) << (edgeid.id() & 63);
 }
 
 } // namespace sif
@@ -278,6 +278,44 @@ public:
                                      const baldr::DirectedEdge* edge,
                                      const bool has_traffic = false) const;
 
+  /**
+   * Evaluate an edge for forward expansion in a single dispatch, with the
+   * access check and cost math statically bound to this costing.
+   */
+  virtual bool EvaluateForward(const baldr::DirectedEdge* edge,
+                               const baldr::NodeInfo* node,
+                               const EdgeLabel& pred,
+                               const baldr::GraphTile*& tile,
+                               const baldr::GraphId& edgeid,
+                               const uint64_t current_time,
+                               const uint32_t tz_index,
+                               const uint32_t speed,
+                               Cost& transition_cost,
+                               Cost& newcost) const {
+    return EvaluateForwardImpl(*this, edge, node, pred, tile, edgeid, current_time, tz_index, speed,
+                               transition_cost, newcost);
+  }
+
+  /**
+   * Evaluate an edge for reverse expansion in a single dispatch, with the
+   * access check and cost math statically bound to this costing.
+   */
+  virtual bool EvaluateReverse(const baldr::DirectedEdge* edge,
+                               const EdgeLabel& pred,
+                               const baldr::DirectedEdge* opp_edge,
+                               const baldr::NodeInfo* node,
+                               const baldr::DirectedEdge* opp_pred_edge,
+                               const baldr::GraphTile*& tile,
+                               const baldr::GraphId& opp_edgeid,
+                               const uint64_t current_time,
+                               const uint32_t tz_index,
+                               const uint32_t speed,
+                               Cost& transition_cost,
+                               Cost& newcost) const {
+    return EvaluateReverseImpl(*this, edge, pred, opp_edge, node, opp_pred_edge, tile, opp_edgeid,
+                               current_time, tz_index, speed, transition_cost, newcost);
+  }
+
   /**
    * Get the cost factor for A* heuristics. This factor is multiplied
    * with the distance to the destination to produce an estimate of the
@@ -307,7 +345,7 @@ public:
   virtual const EdgeFilter GetEdgeFilter() const {
     // Throw back a lambda that checks the access for this type of costing
     return [](const baldr::DirectedEdge* edge) {
-      if (edge->is_shortcut() || !(edge->forwardaccess() & kMopedAccess) ||
+      if (edge->is_shortcut() || !edge->forwardaccess_allowed<kMopedAccess>() ||
           edge->surface() > kMinimumScooterSurface) {
         return 0.0f;
       } else {
@@ -398,7 +436,7 @@ bool MotorScooterCost::Allowed(const baldr::DirectedEdge* edge,
                                const uint32_t tz_index) const {
   // Check access, U-turn, and simple turn restriction.
   // Allow U-turns at dead-end nodes.
-  if (!(edge->forwardaccess() & kMopedAccess) ||
+  if (!edge->forwardaccess_allowed<kMopedAccess>() ||
       (!pred.deadend() && pred.opp_local_idx() == edge->localedgeidx()) ||
       (pred.restrictions() & (1 << edge->localedgeidx())) || IsUserAvoidEdge(edgeid) ||
       (!allow_destination_only_ && !pred.destonly() && edge->destonly())) {
@@ -437,7 +475,7 @@ bool MotorScooterCost::AllowedReverse(const baldr::DirectedEdge* edge,
                                       const uint32_t tz_index) const {
   // Check access, U-turn, and simple turn restriction.
   // Allow U-turns at dead-end nodes.
-  if (!(opp_edge->forwardaccess() & kMopedAccess) ||
+  if (!opp_edge->forwardaccess_allowed<kMopedAccess>() ||
       (!pred.deadend() && pred.opp_local_idx() == edge->localedgeidx()) ||
       (opp_edge->restrictions() & (1 << pred.opp_local_idx())) || IsUserAvoidEdge(opp_edgeid) ||
       (!allow_destination_only_ && !pred.destonly() && opp_edge->destonly())) {
@@ -307,6 +307,44 @@ public:
                                      const baldr::DirectedEdge* edge,
                                      const bool has_traffic = false) const;
 
+  /**
+   * Evaluate an edge for forward expansion in a single dispatch, with the
+   * access check and cost math statically bound to this costing.
+   */
+  virtual bool EvaluateForward(const baldr::DirectedEdge* edge,
+                               const baldr::NodeInfo* node,
+                               const EdgeLabel& pred,
+                               const baldr::GraphTile*& tile,
+                               const baldr::GraphId& edgeid,
+                               const uint64_t current_time,
+                               const uint32_t tz_index,
+                               const uint32_t speed,
+                               Cost& transition_cost,
+                               Cost& newcost) const {
+    return EvaluateForwardImpl(*this, edge, node, pred, tile, edgeid, current_time, tz_index, speed,
+                               transition_cost, newcost);
+  }
+
+  /**
+   * Evaluate an edge for reverse expansion in a single dispatch, with the
+   * access check and cost math statically bound to this costing.
+   */
+  virtual bool EvaluateReverse(const baldr::DirectedEdge* edge,
+                               const EdgeLabel& pred,
+                               const baldr::DirectedEdge* opp_edge,
+                               const baldr::NodeInfo* node,
+                               const baldr::DirectedEdge* opp_pred_edge,
+                               const baldr::GraphTile*& tile,
+                               const baldr::GraphId& opp_edgeid,
+                               const uint64_t current_time,
+                               const uint32_t tz_index,
+                               const uint32_t speed,
+                               Cost& transition_cost,
+                               Cost& newcost) const {
+    return EvaluateReverseImpl(*this, edge, pred, opp_edge, node, opp_pred_edge, tile, opp_edgeid,
+                               current_time, tz_index, speed, transition_cost, newcost);
+  }
+
   /**
    * Get the cost factor for A* heuristics. This factor is multiplied
    * with the distance to the destination to produce an estimate of the
@@ -418,7 +456,7 @@ public:
                                  const uint32_t idx) const {
     // Cases with both time and penalty: country crossing, ferry, gate, toll booth
     sif::Cost c;
-    if (node->type() == baldr::NodeType::kBorderControl) {
+    if (node->type() == baldr::NodeType::kBorderControl || edge->ctry_crossing()) {
       c += country_crossing_cost_;
     }
     if (node->type() == baldr::NodeType::kGate) {
@@ -463,7 +501,7 @@ public:
                                  const uint32_t idx) const {
     // Cases with both time and penalty: country crossing, ferry, gate, toll booth
     sif::Cost c;
-    if (node->type() == baldr::NodeType::kBorderControl) {
+    if (node->type() == baldr::NodeType::kBorderControl || edge->ctry_crossing()) {
       c += country_crossing_cost_;
     }
     if (node->type() == baldr::NodeType::kGate) {
@@ -560,9 +598,11 @@ bool PedestrianCost::Allowed(const baldr::DirectedEdge* edge,
                              const baldr::GraphId& edgeid,
                              const uint64_t current_time,
                              const uint32_t tz_index) const {
+  // max_down_slope is stored as a negative grade so negate it before comparing
   if (!(edge->forwardaccess() & access_mask_) || (edge->surface() > minimal_allowed_surface_) ||
-      edge->is_shortcut() || IsUserAvoidEdge(edgeid) || edge->sac_scale() > max_hiking_difficulty_ ||
-      //      (edge->max_up_slope() > max_grade_ || edge->max_down_slope() > max_grade_) ||
+      IsUserAvoidEdge(edgeid) || edge->sac_scale() > max_hiking_difficulty_ ||
+      edge->max_up_slope() > static_cast<int>(max_grade_) ||
+      -edge->max_down_slope() > static_cast<int>(max_grade_) ||
       ((pred.path_distance() + edge->length()) > max_distance_)) {
     return false;
   }
@@ -609,9 +649,10 @@ bool PedestrianCost::AllowedReverse(const baldr::DirectedEdge* edge,
   // transit connections. Assume this method is never used in
   // multimodal routes).
   if (!(opp_edge->forwardaccess() & access_mask_) ||
-      (opp_edge->surface() > minimal_allowed_surface_) || opp_edge->is_shortcut() ||
+      (opp_edge->surface() > minimal_allowed_surface_) ||
       IsUserAvoidEdge(opp_edgeid) || edge->sac_scale() > max_hiking_difficulty_ ||
-      //      (opp_edge->max_up_slope() > max_grade_ || opp_edge->max_down_slope() > max_grade_) ||
+      opp_edge->max_up_slope() > static_cast<int>(max_grade_) ||
+      -opp_edge->max_down_slope() > static_cast<int>(max_grade_) ||
       opp_edge->use() == Use::kTransitConnection || opp_edge->use() == Use::kEgressConnection ||
       opp_edge->use() == Use::kPlatformConnection) {
     return false;
@@ -4,6 +4,7 @@
 #include "baldr/directededge.h"
 #include "baldr/nodeinfo.h"
 #include "midgard/constants.h"
+#include "midgard/logging.h"
 #include "midgard/util.h"
 
 #ifdef INLINE_TEST
@@ -45,12 +46,15 @@ constexpr float kTCUnfavorable = 2.5f;
 constexpr float kTCUnfavorableSharp = 3.5f;
 constexpr float kTCReverse = 5.0f;
 
-// Default truck attributes
-constexpr float kDefaultTruckWeight = 21.77f;  // Metric Tons (48,000 lbs)
-constexpr float kDefaultTruckAxleLoad = 9.07f; // Metric Tons (20,000 lbs)
-constexpr float kDefaultTruckHeight = 4.11f;   // Meters (13 feet 6 inches)
-constexpr float kDefaultTruckWidth = 2.6f;     // Meters (102.36 inches)
-constexpr float kDefaultTruckLength = 21.64f;  // Meters (71 feet)
+// Default truck attributes live in baldr/graphconstants.h so the graph build
+// can pre-resolve static access restrictions against the same envelope
+
+#ifdef FIXED_COSTING_PROFILES
+// A fixed costing profile build bakes the default truck attributes in at
+// compile time, so the access restriction checks and the low class road
+// penalty compare and add constants instead of loading members per edge
+constexpr bool kFixedHazmat = false;
+#endif
 
 // Turn costs based on side of street driving
 constexpr float kRightSideTurnCosts[] = {kTCStraight,       kTCSlight,  kTCFavorable,
@@ -228,6 +232,44 @@ public:
                                      const baldr::DirectedEdge* edge,
                                      const bool has_traffic = false) const;
 
+  /**
+   * Evaluate an edge for forward expansion in a single dispatch, with the
+   * access check and cost math statically bound to this costing.
+   */
+  virtual bool EvaluateForward(const baldr::DirectedEdge* edge,
+                               const baldr::NodeInfo* node,
+                               const EdgeLabel& pred,
+                               const baldr::GraphTile*& tile,
+                               const baldr::GraphId& edgeid,
+                               const uint64_t current_time,
+                               const uint32_t tz_index,
+                               const uint32_t speed,
+                               Cost& transition_cost,
+                               Cost& newcost) const {
+    return EvaluateForwardImpl(*this, edge, node, pred, tile, edgeid, current_time, tz_index, speed,
+                               transition_cost, newcost);
+  }
+
+  /**
+   * Evaluate an edge for reverse expansion in a single dispatch, with the
+   * access check and cost math statically bound to this costing.
+   */
+  virtual bool EvaluateReverse(const baldr::DirectedEdge* edge,
+                               const EdgeLabel& pred,
+                               const baldr::DirectedEdge* opp_edge,
+                               const baldr::NodeInfo* node,
+                               const baldr::DirectedEdge* opp_pred_edge,
+                               const baldr::GraphTile*& tile,
+                               const baldr::GraphId& opp_edgeid,
+                               const uint64_t current_time,
+                               const uint32_t tz_index,
+                               const uint32_t speed,
+                               Cost& transition_cost,
+                               Cost& newcost) const {
+    return EvaluateReverseImpl(*this, edge, pred, opp_edge, node, opp_pred_edge, tile, opp_edgeid,
+                               current_time, tz_index, speed, transition_cost, newcost);
+  }
+
   /**
    * Get the cost factor for A* heuristics. This factor is multiplied
    * with the distance to the destination to produce an estimate of the
@@ -254,7 +296,7 @@ public:
   virtual const EdgeFilter GetEdgeFilter() const {
     // Throw back a lambda that checks the access for this type of costing
     return [](const baldr::DirectedEdge* edge) {
-      if (edge->is_shortcut() || !(edge->forwardaccess() & kTruckAccess)) {
+      if (edge->is_shortcut() || !edge->forwardaccess_allowed<kTruckAccess>()) {
         return 0.0f;
       } else {
         // TODO - use classification/use to alter the factor
@@ -287,6 +329,10 @@ public:
   float width_;     // Vehicle width in meters
   float length_;    // Vehicle length in meters
 
+  // Is this truck the default envelope? If so, edges whose static access
+  // restrictions were pre-resolved at build time need no restriction walk
+  bool default_envelope_;
+
   // Density factor used in edge transition costing
   std::vector<float> trans_density_factor_;
 };
@@ -316,6 +362,16 @@ TruckCost::TruckCost(const odin::Costing costing, const odin::DirectionsOptions&
   width_ = costing_options.width();
   length_ = costing_options.length();
 
+  // when this truck is the default envelope the restriction bit the build
+  // pre-resolved on each edge applies to it directly
+#ifdef FIXED_COSTING_PROFILES
+  default_envelope_ = true;
+#else
+  default_envelope_ = !hazmat_ && weight_ == kDefaultTruckWeight &&
+                      axle_load_ == kDefaultTruckAxleLoad && height_ == kDefaultTruckHeight &&
+                      width_ == kDefaultTruckWidth && length_ == kDefaultTruckLength;
+#endif
+
   // Create speed cost table
   speedfactor_[0] = kSecPerHour; // TODO - what to make speed=0?
   for (uint32_t s = 1; s <= kMaxSpeedKph; s++) {
@@ -324,6 +380,17 @@ TruckCost::TruckCost(const odin::Costing costing, const odin::DirectionsOptions&
   for (uint32_t d = 0; d < 16; d++) {
     density_factor_[d] = 0.85f + (d * 0.025f);
   }
+
+#ifdef FIXED_COSTING_PROFILES
+  // the restriction checks use the baked attributes, a request asking for a
+  // different truck is costed with the fixed profile so at least say so
+  if (hazmat_ != kFixedHazmat || weight_ != kDefaultTruckWeight ||
+      axle_load_ != kDefaultTruckAxleLoad || height_ != kDefaultTruckHeight ||
+      width_ != kDefaultTruckWidth || length_ != kDefaultTruckLength ||
+      low_class_penalty_ != kDefaultLowClassPenalty) {
+    LOG_WARN("Fixed costing profile build ignores the requested truck attributes");
+  }
+#endif
 }
 
 // Destructor
@@ -355,7 +422,8 @@ bool TruckCost::Allowed(const baldr::DirectedEdge* edge,
                         const uint32_t tz_index) const {
   // Check access, U-turn, and simple turn restriction.
   // TODO - perhaps allow U-turns at dead-end nodes?
-  if (!(edge->forwardaccess() & kTruckAccess) || (pred.opp_local_idx() == edge->localedgeidx()) ||
+  if (!edge->forwardaccess_allowed<kTruckAccess>() ||
+      (pred.opp_local_idx() == edge->localedgeidx()) ||
       (pred.restrictions() & (1 << edge->localedgeidx())) ||
       edge->surface() == Surface::kImpassable || IsUserAvoidEdge(edgeid) ||
       (!allow_destination_only_ && !pred.destonly() && edge->destonly())) {
@@ -363,6 +431,23 @@ bool TruckCost::Allowed(const baldr::DirectedEdge* edge,
   }
 
   if (edge->access_restriction()) {
+    // the build pre-resolved static restrictions against the default truck
+    // envelope; when that is the truck being costed and the edge says they
+    // all pass (timed restrictions clear the bit) the walk below would only
+    // rediscover that
+    if (default_envelope_ && edge->default_truck_ok()) {
+      return true;
+    }
+#ifdef FIXED_COSTING_PROFILES
+    constexpr bool hazmat = kFixedHazmat;
+    constexpr float weight = kDefaultTruckWeight, axle_load = kDefaultTruckAxleLoad,
+                    height = kDefaultTruckHeight, width = kDefaultTruckWidth,
+                    length = kDefaultTruckLength;
+#else
+    const bool hazmat = hazmat_;
+    const float weight = weight_, axle_load = axle_load_, height = height_, width = width_,
+                length = length_;
+#endif
     const std::vector<baldr::AccessRestriction>& restrictions =
         tile->GetAccessRestrictions(edgeid.id(), kTruckAccess);
 
@@ -381,32 +466,32 @@ bool TruckCost::Allowed(const baldr::DirectedEdge* edge,
                      : false;
           break;
         case AccessType::kHazmat:
-          if (hazmat_ != restriction.value()) {
+          if (hazmat != restriction.value()) {
             return false;
           }
           break;
         case AccessType::kMaxAxleLoad:
-          if (axle_load_ > static_cast<float>(restriction.value() * 0.01)) {
+          if (axle_load > static_cast<float>(restriction.value() * 0.01)) {
             return false;
           }
           break;
         case AccessType::kMaxHeight:
-          if (height_ > static_cast<float>(restriction.value() * 0.01)) {
+          if (height > static_cast<float>(restriction.value() * 0.01)) {
             return false;
           }
           break;
         case AccessType::kMaxLength:
-          if (length_ > static_cast<float>(restriction.value() * 0.01)) {
+          if (length > static_cast<float>(restriction.value() * 0.01)) {
             return false;
           }
           break;
         case AccessType::kMaxWeight:
-          if (weight_ > static_cast<float>(restriction.value() * 0.01)) {
+          if (weight > static_cast<float>(restriction.value() * 0.01)) {
             return false;
           }
           break;
         case AccessType::kMaxWidth:
-          if (width_ > static_cast<float>(restriction.value() * 0.01)) {
+          if (width > static_cast<float>(restriction.value() * 0.01)) {
             return false;
           }
           break;
@@ -430,7 +515,7 @@ bool TruckCost::AllowedReverse(const baldr::DirectedEdge* edge,
                                const uint32_t tz_index) const {
   // Check access, U-turn, and simple turn restriction.
   // TODO - perhaps allow U-turns at dead-end nodes?
-  if (!(opp_edge->forwardaccess() & kTruckAccess) || (pred.opp_local_idx() == edge->localedgeidx()) ||
+  if (!opp_edge->forwardaccess_allowed<kTruckAccess>() || (pred.opp_local_idx() == edge->localedgeidx()) ||
       (opp_edge->restrictions() & (1 << pred.opp_local_idx())) ||
       opp_edge->surface() == Surface::kImpassable || IsUserAvoidEdge(opp_edgeid) ||
       (!allow_destination_only_ && !pred.destonly() && opp_edge->destonly())) {
@@ -438,6 +523,21 @@ bool TruckCost::AllowedReverse(const baldr::DirectedEdge* edge,
   }
 
   if (edge->access_restriction()) {
+    // same build time pre-resolution as the forward direction, read from the
+    // opposing edge since its restriction list is the one walked below
+    if (default_envelope_ && opp_edge->default_truck_ok()) {
+      return true;
+    }
+#ifdef FIXED_COSTING_PROFILES
+    constexpr bool hazmat = kFixedHazmat;
+    constexpr float weight = kDefaultTruckWeight, axle_load = kDefaultTruckAxleLoad,
+                    height = kDefaultTruckHeight, width = kDefaultTruckWidth,
+                    length = kDefaultTruckLength;
+#else
+    const bool hazmat = hazmat_;
+    const float weight = weight_, axle_load = axle_load_, height = height_, width = width_,
+                length = length_;
+#endif
     const std::vector<baldr::AccessRestriction>& restrictions =
         tile->GetAccessRestrictions(opp_edgeid.id(), kTruckAccess);
 
@@ -457,32 +557,32 @@ bool TruckCost::AllowedReverse(const baldr::DirectedEdge* edge,
                        : false;
             break;
           case AccessType::kHazmat:
-            if (hazmat_ != restriction.value()) {
+            if (hazmat != restriction.value()) {
               return false;
             }
             break;
           case AccessType::kMaxAxleLoad:
-            if (axle_load_ > static_cast<float>(restriction.value() * 0.01)) {
+            if (axle_load > static_cast<float>(restriction.value() * 0.01)) {
               return false;
             }
             break;
           case AccessType::kMaxHeight:
-            if (height_ > static_cast<float>(restriction.value() * 0.01)) {
+            if (height > static_cast<float>(restriction.value() * 0.01)) {
               return false;
             }
             break;
           case AccessType::kMaxLength:
-            if (length_ > static_cast<float>(restriction.value() * 0.01)) {
+            if (length > static_cast<float>(restriction.value() * 0.01)) {
               return false;
             }
             break;
           case AccessType::kMaxWeight:
-            if (weight_ > static_cast<float>(restriction.value() * 0.01)) {
+            if (weight > static_cast<float>(restriction.value() * 0.01)) {
               return false;
             }
             break;
           case AccessType::kMaxWidth:
-            if (width_ > static_cast<float>(restriction.value() * 0.01)) {
+            if (width > static_cast<float>(restriction.value() * 0.01)) {
               return false;
             }
             break;
@@ -526,7 +626,11 @@ Cost TruckCost::TransitionCost(const baldr::DirectedEdge* edge,
   // Penalty to transition onto low class roads.
   if (edge->classification() == RoadClass::kResidential ||
       edge->classification() == RoadClass::kServiceOther) {
+#ifdef FIXED_COSTING_PROFILES
+    c.cost += kDefaultLowClassPenalty;
+#else
     c.cost += low_class_penalty_;
+#endif
   }
 
   // Transition time = densityfactor * stopimpact * turncost
@@ -562,7 +666,11 @@ Cost TruckCost::TransitionCostReverse(const uint32_t idx,
   // Penalty to transition onto low class roads.
   if (edge->classification() == RoadClass::kResidential ||
       edge->classification() == RoadClass::kServiceOther) {
+#ifdef FIXED_COSTING_PROFILES
+    c.cost += kDefaultLowClassPenalty;
+#else
     c.cost += low_class_penalty_;
+#endif
   }
 
   // Transition time = densityfactor * stopimpact * turncost
@@ -1,19 +1,24 @@
 #include "skadi/sample.h"
 
+#include <algorithm>
 #include <cmath>
 #include <cstddef>
 #include <fstream>
+#include <iterator>
 #include <limits>
 #include <list>
 #include <regex>
 #include <stdexcept>
 #include <string>
+#include <utility>
+#include <vector>
 #include <sys/stat.h>
 
 #include <boost/optional.hpp>
 
 #include "baldr/compression_utils.h"
 #include "filesystem.h"
+#include "midgard/constants.h"
 #include "midgard/logging.h"
 #include "midgard/pointll.h"
 
@@ -28,7 +33,14 @@ constexpr size_t HGT_BYTES = sizeof(int16_t) * HGT_PIXELS;
 constexpr int16_t NO_DATA_VALUE = -32768;
 constexpr int16_t NO_DATA_HIGH = 16384;
 constexpr int16_t NO_DATA_LOW = -16384;
+
+// the spherical geometry constants the resampler uses
+constexpr double RAD_PER_METER = 1.0 / 6378160.187;
+constexpr double RAD_PER_DEG = valhalla::midgard::kPiDouble / 180.0;
+constexpr double DEG_PER_RAD = 180.0 / valhalla::midgard::kPiDouble;
 constexpr size_t TILE_COUNT = 180 * 360;
+// how many unzipped tiles to keep resident at once, each one is about 25MB
+constexpr size_t UNZIPPED_TILES_MAX = 4;
 
 // macro is faster than inline function for this..
 #define out_of_range(v) v > NO_DATA_HIGH || v < NO_DATA_LOW
@@ -101,14 +113,89 @@ uint64_t file_size(const std::string& file_name) {
   return rc == 0 ? s.st_size : -1;
 }
 
+// bilinear interpolation of the postings surrounding the coord within tile data t
+template <class coord_t> double sample_posting(const int16_t* t, const coord_t& coord) {
+  auto lon = std::floor(coord.first);
+  auto lat = std::floor(coord.second);
+
+  // figure out what row and column we need from the array of data
+  // NOTE: data is arranged from upper left to bottom right, so y is flipped
+
+  // fractional pixel
+  double u = (coord.first - lon) * (HGT_DIM - 1);
+  double v = (1.0 - (coord.second - lat)) * (HGT_DIM - 1);
+
+  // integer pixel, both offsets are non negative so truncation is the floor
+  size_t x = static_cast<size_t>(u);
+  size_t y = static_cast<size_t>(v);
+
+  // coefficients
+  double u_ratio = u - x;
+  double v_ratio = v - y;
+  double u_inv = 1 - u_ratio;
+  double v_inv = 1 - v_ratio;
+
+  // the top row of values
+  auto a = flip(t[y * HGT_DIM + x]);
+  auto b = flip(t[y * HGT_DIM + x + 1]);
+
+  // only use the second row if you aren't right on the last row
+  // this also protects from a corner case where you sample past the end of the image
+  if (y < HGT_DIM - 1) {
+    auto c = flip(t[(y + 1) * HGT_DIM + x]);
+    auto d = flip(t[(y + 1) * HGT_DIM + x + 1]);
+    // all four postings are valid in nearly every sample, blend them directly
+    if (!(out_of_range(a)) && !(out_of_range(b)) && !(out_of_range(c)) && !(out_of_range(d))) {
+      return (a * u_inv + b * u_ratio) * v_inv + (c * u_inv + d * u_ratio) * v_ratio;
+    }
+    // some postings have no data, drop them and adjust by the coefficients kept
+    double a_coef = u_inv * v_inv;
+    double b_coef = u_ratio * v_inv;
+    double c_coef = u_inv * v_ratio;
+    double d_coef = u_ratio * v_ratio;
+    if (out_of_range(a)) {
+      a_coef = 0;
+    }
+    if (out_of_range(b)) {
+      b_coef = 0;
+    }
+    if (out_of_range(c)) {
+      c_coef = 0;
+    }
+    if (out_of_range(d)) {
+      d_coef = 0;
+    }
+    double adjust = a_coef + b_coef + c_coef + d_coef;
+    // if we are missing everything then give up
+    if (adjust == 0) {
+      return NO_DATA_VALUE;
+    }
+    return (a * a_coef + b * b_coef + c * c_coef + d * d_coef) / adjust;
+  }
+
+  // right on the last row, interpolate along it with whatever has data
+  double a_coef = u_inv * v_inv;
+  double b_coef = u_ratio * v_inv;
+  if (out_of_range(a)) {
+    a_coef = 0;
+  }
+  if (out_of_range(b)) {
+    b_coef = 0;
+  }
+  double adjust = a_coef + b_coef;
+  if (adjust == 0) {
+    return NO_DATA_VALUE;
+  }
+  return (a * a_coef + b * b_coef) / adjust;
+}
+
 } // namespace
 
 namespace valhalla {
 namespace skadi {
 
 ::valhalla::skadi::sample::sample(const std::string& data_source)
-    : mapped_cache(TILE_COUNT), unzipped_cache(-1, std::vector<int16_t>(HGT_PIXELS)),
-      data_source(data_source) {
+    : mapped_cache(TILE_COUNT), data_source(data_source) {
   // messy but needed
   while (this->data_source.size() &&
          this->data_source.back() == filesystem::path::preferred_separator) {
@@ -156,9 +243,20 @@ const int16_t* sample::source(uint16_t index) const {
     return static_cast<const int16_t*>(static_cast<const void*>(mapped.second.get()));
   }
 
-  // if we have it already unzipped
-  if (unzipped_cache.first == index) {
-    return unzipped_cache.second.data();
+  // if we have it unzipped already, move it to the front of the line
+  auto unzipped = unzipped_index.find(index);
+  if (unzipped != unzipped_index.end()) {
+    unzipped_cache.splice(unzipped_cache.begin(), unzipped_cache, unzipped->second);
+    return unzipped->second->second.data();
+  }
+
+  // evict the stalest tile and reuse its buffer, or make room for a new one
+  if (unzipped_cache.size() >= UNZIPPED_TILES_MAX) {
+    unzipped_index.erase(unzipped_cache.back().first);
+    unzipped_cache.splice(unzipped_cache.begin(), unzipped_cache, std::prev(unzipped_cache.end()));
+    unzipped_cache.front().first = index;
+  } else {
+    unzipped_cache.emplace_front(index, std::vector<int16_t>(HGT_PIXELS));
   }
 
   // for setting where to read compressed data from
@@ -169,7 +267,7 @@ const int16_t* sample::source(uint16_t index) const {
 
   // for setting where to write the uncompressed data to
   auto dst_func = [this](z_stream& s) -> int {
-    s.next_out = static_cast<Byte*>(static_cast<void*>(unzipped_cache.second.data()));
+    s.next_out = static_cast<Byte*>(static_cast<void*>(unzipped_cache.front().second.data()));
     s.avail_out = HGT_BYTES;
     return Z_FINISH; // we know the output will hold all the input
   };
@@ -177,14 +275,13 @@ const int16_t* sample::source(uint16_t index) const {
   // we have to unzip it
   if (!baldr::inflate(src_func, dst_func)) {
     LOG_WARN("Corrupt compressed elevation data");
-    unzipped_cache.first = -1;
+    unzipped_cache.pop_front();
     return nullptr;
   }
 
-  // update the simple cache
-  // TODO: LRU
-  unzipped_cache.first = index;
-  return unzipped_cache.second.data();
+  // remember which tile this entry now holds
+  unzipped_index.emplace(index, unzipped_cache.begin());
+  return unzipped_cache.front().second.data();
 }
 
 template <class coord_t> double sample::get(const coord_t& coord) const {
@@ -199,74 +296,130 @@ template <class coord_t> double sample::get(const coord_t& coord) const {
     return NO_DATA_VALUE;
   }
 
-  // figure out what row and column we need from the array of data
-  // NOTE: data is arranged from upper left to bottom right, so y is flipped
-
-  // fractional pixel
-  double u = (coord.first - lon) * (HGT_DIM - 1);
-  double v = (1.0 - (coord.second - lat)) * (HGT_DIM - 1);
+  return sample_posting(t, coord);
+}
 
-  // integer pixel
-  size_t x = std::floor(u);
-  size_t y = std::floor(v);
+template <class coords_t> std::vector<double> sample::get_all(const coords_t& coords) const {
+  using coord_t = typename coords_t::value_type;
 
-  // coefficients
-  double u_ratio = u - x;
-  double v_ratio = v - y;
-  double u_inv = 1 - u_ratio;
-  double v_inv = 1 - v_ratio;
-  double a_coef = u_inv * v_inv;
-  double b_coef = u_ratio * v_inv;
-  double c_coef = u_inv * v_ratio;
-  double d_coef = u_ratio * v_ratio;
+  // figure out which tile each posting lives in, remembering where it was
+  std::vector<const coord_t*> postings;
+  postings.reserve(coords.size());
+  std::vector<std::pair<uint16_t, uint32_t>> tile_order;
+  tile_order.reserve(coords.size());
+  for (const auto& coord : coords) {
+    auto lon = std::floor(coord.first);
+    auto lat = std::floor(coord.second);
+    auto index = static_cast<uint16_t>(lat + 90) * 360 + static_cast<uint16_t>(lon + 180);
+    tile_order.emplace_back(index, static_cast<uint32_t>(postings.size()));
+    postings.push_back(&coord);
+  }
 
-  // values
-  double adjust = 0;
-  auto a = flip(t[y * HGT_DIM + x]);
-  auto b = flip(t[y * HGT_DIM + x + 1]);
-  if (out_of_range(a)) {
-    a_coef = 0;
+  // sample the postings a tile at a time so a batch that straddles tiles
+  // resolves each tile once instead of bouncing between them, which matters
+  // most when compressed tiles have to be unzipped into the single entry
+  // cache. ties keep their original order so results can go back in place
+  std::sort(tile_order.begin(), tile_order.end());
+  std::vector<double> values(postings.size(), NO_DATA_VALUE);
+  const int16_t* t = nullptr;
+  bool have_tile = false;
+  uint16_t current = 0;
+  for (const auto& tile_posting : tile_order) {
+    if (!have_tile || tile_posting.first != current) {
+      t = source(tile_posting.first);
+      current = tile_posting.first;
+      have_tile = true;
+    }
+    if (t != nullptr) {
+      values[tile_posting.second] = sample_posting(t, *postings[tile_posting.second]);
+    }
   }
-  if (out_of_range(b)) {
-    b_coef = 0;
+  return values;
+}
+
+template <class coords_t>
+void sample::get_resampled(const coords_t& polyline,
+                           double resolution,
+                           const std::function<void(const midgard::PointLL&)>& emit,
+                           std::vector<double>& heights,
+                           std::vector<float>* ranges) const {
+  if (polyline.size() == 0) {
+    return;
   }
 
-  // first part of the bilinear interpolation
-  auto value = a * a_coef + b * b_coef;
-  adjust += a_coef + b_coef;
-  // LOG_INFO('{' + std::to_string(y * HGT_DIM + x) + ',' + std::to_string(a) + '}');
-  // LOG_INFO('{' + std::to_string(y * HGT_DIM + x + 1) + ',' + std::to_string(b) + '}');
-  // only need the second part if you aren't right on the row
-  // this also protects from a corner case where you sample past the end of the image
-  if (y < HGT_DIM - 1) {
-    auto c = flip(t[(y + 1) * HGT_DIM + x]);
-    auto d = flip(t[(y + 1) * HGT_DIM + x + 1]);
-    if (out_of_range(c)) {
-      c_coef = 0;
+  // resampled corridors are spatially coherent so instead of batching the
+  // postings and sorting them by tile we just remember the tile from last time
+  const int16_t* t = nullptr;
+  bool have_tile = false;
+  uint16_t current = 0;
+  // cumulative great circle arc from the start of the shape, in radians
+  double walked = 0;
+  auto posting = [&](const midgard::PointLL& p) {
+    emit(p);
+    auto lon = std::floor(p.first);
+    auto lat = std::floor(p.second);
+    auto index = static_cast<uint16_t>(lat + 90) * 360 + static_cast<uint16_t>(lon + 180);
+    if (!have_tile || index != current) {
+      t = source(index);
+      current = index;
+      have_tile = true;
     }
-    if (out_of_range(d)) {
-      d_coef = 0;
+    heights.push_back(t == nullptr ? NO_DATA_VALUE : sample_posting(t, p));
+    if (ranges != nullptr) {
+      ranges->push_back(walked / RAD_PER_METER);
     }
-    // LOG_INFO('{' + std::to_string((y + 1) * HGT_DIM + x) + ',' + std::to_string(c) + '}');
-    // LOG_INFO('{' + std::to_string((y + 1) * HGT_DIM + x + 1) + ',' + std::to_string(d) + '}');
-    value += c * c_coef + d * d_coef;
-    adjust += c_coef + d_coef;
-  }
-  // if we are missing everything then give up
-  if (adjust == 0) {
-    return NO_DATA_VALUE;
+  };
+
+  // the first posting is the first input point
+  midgard::PointLL last(polyline.front().first, polyline.front().second);
+  posting(last);
+  if (polyline.size() == 1) {
+    return;
   }
-  // if we were missing some we need to adjust by that
-  return value / adjust;
-}
 
-template <class coords_t> std::vector<double> sample::get_all(const coords_t& coords) const {
-  std::vector<double> values;
-  values.reserve(coords.size());
-  for (const auto& coord : coords) {
-    values.emplace_back(get(coord));
+  // walk the input segments the same way resample_spherical_polyline does,
+  // handing out a posting every resolution meters along the great circle
+  resolution *= RAD_PER_METER;
+  double remaining = resolution;
+  for (auto p = std::next(polyline.cbegin()); p != polyline.cend(); ++p) {
+    // radians
+    auto lon2 = p->first * -RAD_PER_DEG;
+    auto lat2 = p->second * RAD_PER_DEG;
+    // how much do we have left on this segment from where we are (in great arc radians)
+    auto d = acos(sin(last.second * RAD_PER_DEG) * sin(lat2) +
+                  cos(last.second * RAD_PER_DEG) * cos(lat2) * cos(last.first * -RAD_PER_DEG - lon2));
+    // keep placing points while we can fit them
+    while (d > remaining) {
+      // some precomputed stuff
+      auto lon1 = last.first * -RAD_PER_DEG;
+      auto lat1 = last.second * RAD_PER_DEG;
+      auto sd = sin(d);
+      auto a = sin(d - remaining) / sd;
+      auto acs1 = a * cos(lat1);
+      auto b = sin(remaining) / sd;
+      auto bcs2 = b * cos(lat2);
+      // find the interpolated point along the arc
+      auto x = acs1 * cos(lon1) + bcs2 * cos(lon2);
+      auto y = acs1 * sin(lon1) + bcs2 * sin(lon2);
+      auto z = a * sin(lat1) + b * sin(lat2);
+      last.first = atan2(y, x) * -DEG_PER_RAD;
+      last.second = atan2(z, sqrt(x * x + y * y)) * DEG_PER_RAD;
+      walked += remaining;
+      posting(last);
+      // we just consumed a bit
+      d -= remaining;
+      // we need another bit
+      remaining = resolution;
+    }
+    // we're going to the next point so consume whatever's left
+    remaining -= d;
+    walked += d;
+    last.first = p->first;
+    last.second = p->second;
   }
-  return values;
+
+  // the last input point is always the last posting
+  posting(last);
 }
 
 double sample::get_no_data_value() {
@@ -294,6 +447,12 @@ template std::vector<double>
 sample::get_all<std::list<midgard::Point2>>(const std::list<midgard::Point2>&) const;
 template std::vector<double>
 sample::get_all<std::vector<midgard::Point2>>(const std::vector<midgard::Point2>&) const;
+template void sample::get_resampled<std::vector<midgard::PointLL>>(
+    const std::vector<midgard::PointLL>&,
+    double,
+    const std::function<void(const midgard::PointLL&)>&,
+    std::vector<double>&,
+    std::vector<float>*) const;
 
 } // namespace skadi
 } // namespace valhalla
@@ -16,13 +16,17 @@ namespace thor {
 
 constexpr uint64_t kInitialEdgeLabelCount = 500000;
 
+// Number of nodes the guidance lower bound search may settle. Keeps the
+// bounding search a small fraction of the cost of the search it guides.
+constexpr uint32_t kLowerBoundNodeBudget = 25000;
+
 // Number of iterations to allow with no convergence to the destination
 constexpr uint32_t kMaxIterationsWithoutConvergence = 200000;
 
 // Default constructor
 AStarPathAlgorithm::AStarPathAlgorithm()
     : PathAlgorithm(), mode_(TravelMode::kDrive), travel_type_(0), adjacencylist_(nullptr),
-      max_label_count_(std::numeric_limits<uint32_t>::max()) {
+      max_label_count_(std::numeric_limits<uint32_t>::max()), bound_horizon_(0.0f) {
 }
 
 // Destructor
@@ -34,15 +38,131 @@ AStarPathAlgorithm::~AStarPathAlgorithm() {
 void AStarPathAlgorithm::Clear() {
   // Clear the edge labels and destination list. Reset the adjacency list
   // and clear edge status.
-  edgelabels_.clear();
+  sif::ClearLabels(edgelabels_);
   destinations_.clear();
-  adjacencylist_.reset();
   edgestatus_.clear();
 
+  // Empty the adjacency list but keep its bucket storage for the next
+  // request
+  if (adjacencylist_) {
+    adjacencylist_->clear();
+  }
+
+  // Clear any guidance lower bounds and memoized predicted speeds
+  node_bounds_.clear();
+  bound_horizon_ = 0.0f;
+  speed_memo_.clear();
+
   // Set the ferry flag to false
   has_ferry_ = false;
 }
 
+// Get the speed for an edge at a time of the week. Predicted speeds are
+// memoized per edge and 5 minute bucket - decompressing the DCT encoded
+// profile costs far more than the hash lookup and edges are commonly
+// relaxed several times from different predecessors within a bucket.
+uint32_t AStarPathAlgorithm::MemoizedSpeed(const GraphTile* tile,
+                                           const DirectedEdge* de,
+                                           const GraphId& edgeid,
+                                           const uint32_t seconds_of_week) {
+  if (!de->predicted_speed()) {
+    return tile->GetSpeed(de, edgeid, seconds_of_week);
+  }
+
+  // The profile is queried at bucket granularity so the bucket joins the
+  // edge Id (46 bits) to form the key
+  uint64_t key =
+      (static_cast<uint64_t>(seconds_of_week / kSpeedBucketSizeSeconds) << 46) | edgeid.value;
+  auto memo = speed_memo_.emplace(key, 0);
+  if (memo.second) {
+    memo.first->second = tile->GetSpeed(de, edgeid, seconds_of_week);
+  }
+  return memo.first->second;
+}
+
+// Form cost lower bounds around the search target with a bounded Dijkstra
+// over the lower bound graph.
+void AStarPathAlgorithm::ComputeLowerBounds(GraphReader& graphreader, const odin::Location& target) {
+  node_bounds_.clear();
+  bound_horizon_ = 0.0f;
+  float factor = costing_->AStarCostFactor();
+  if (factor <= 0.0f) {
+    return;
+  }
+
+  // Labels for the bounding search - just a node and its cost
+  struct BoundLabel {
+    uint64_t node;
+    float cost;
+  };
+  std::vector<BoundLabel> labels;
+  std::unordered_map<uint64_t, uint32_t> node_label;
+  const auto boundcost = [&labels](const uint32_t label) { return labels[label].cost; };
+  uint32_t bucketsize = costing_->UnitSize();
+  DoubleBucketQueue adjlist(0.0f, kBucketCount * bucketsize, bucketsize, boundcost);
+
+  // Add a node to the queue or lower its cost if it already has a label
+  const auto relax = [&](const GraphId& node, const float cost) {
+    auto existing = node_label.find(node.value);
+    if (existing == node_label.end()) {
+      uint32_t idx = labels.size();
+      labels.push_back({node.value, cost});
+      node_label[node.value] = idx;
+      adjlist.add(idx);
+    } else if (cost < labels[existing->second].cost) {
+      adjlist.decrease(existing->second, cost);
+      labels[existing->second].cost = cost;
+    }
+  };
+
+  // Seed both end nodes of each candidate edge at no cost
+  for (const auto& edge : target.path_edges()) {
+    GraphId edgeid(edge.graph_id());
+    const GraphTile* tile = graphreader.GetGraphTile(edgeid);
+    if (tile == nullptr) {
+      continue;
+    }
+    relax(tile->directededge(edgeid)->endnode(), 0.0f);
+    const DirectedEdge* opp = graphreader.GetOpposingEdge(edgeid);
+    if (opp != nullptr) {
+      relax(opp->endnode(), 0.0f);
+    }
+  }
+
+  // Settle nodes in cost order until the budget is exhausted. The cost of
+  // the last settled node becomes the bound for everything left unsettled
+  while (node_bounds_.size() < kLowerBoundNodeBudget) {
+    uint32_t idx = adjlist.pop();
+    if (idx == kInvalidLabel) {
+      break;
+    }
+    const BoundLabel lab = labels[idx];
+    if (!node_bounds_.emplace(lab.node, lab.cost).second) {
+      continue;
+    }
+    bound_horizon_ = lab.cost;
+
+    // Relax the end node of each edge leaving the node and cross any
+    // transitions at no cost
+    GraphId node(lab.node);
+    const GraphTile* tile = graphreader.GetGraphTile(node);
+    if (tile == nullptr) {
+      continue;
+    }
+    const NodeInfo* nodeinfo = tile->node(node);
+    for (const auto& directededge : tile->GetDirectedEdges(nodeinfo)) {
+      if (node_bounds_.find(directededge.endnode().value) == node_bounds_.end()) {
+        relax(directededge.endnode(), lab.cost + directededge.length() * factor);
+      }
+    }
+    for (const auto& trans : tile->GetNodeTransitions(nodeinfo)) {
+      if (node_bounds_.find(trans.endnode().value) == node_bounds_.end()) {
+        relax(trans.endnode(), lab.cost);
+      }
+    }
+  }
+}
+
 // Initialize prior to finding best path
 void AStarPathAlgorithm::Init(const PointLL& origll, const PointLL& destll) {
   LOG_TRACE("Orig LL = " + std::to_string(origll.lat()) + "," + std::to_string(origll.lng()));
@@ -66,7 +186,11 @@ void AStarPathAlgorithm::Init(const PointLL& origll, const PointLL& destll) {
   // Set bucket size and cost range based on DynamicCost.
   uint32_t bucketsize = costing_->UnitSize();
   float range = kBucketCount * bucketsize;
-  adjacencylist_.reset(new DoubleBucketQueue(mincost, range, bucketsize, edgecost));
+  if (adjacencylist_) {
+    adjacencylist_->reuse(mincost, range, bucketsize, edgecost);
+  } else {
+    adjacencylist_.reset(new DoubleBucketQueue(mincost, range, bucketsize, edgecost));
+  }
   edgestatus_.clear();
 
   // Get hierarchy limits from the costing. Get a copy since we increment
@@ -129,8 +253,9 @@ void AStarPathAlgorithm::ExpandForward(GraphReader& graphreader,
   uint32_t max_shortcut_length = static_cast<uint32_t>(pred.distance() * 0.5f);
   GraphId edgeid(node.tileid(), node.level(), nodeinfo->edge_index());
   EdgeStatusInfo* es = edgestatus_.GetPtr(edgeid, tile);
-  const DirectedEdge* directededge = tile->directededge(nodeinfo->edge_index());
-  for (uint32_t i = 0; i < nodeinfo->edge_count(); ++i, ++directededge, ++edgeid, ++es) {
+  auto edges = tile->GetDirectedEdges(nodeinfo);
+  for (const DirectedEdge* directededge = edges.begin(); directededge != edges.end();
+       ++directededge, ++edgeid, ++es) {
     // Skip shortcut edges until we have stopped expanding on the next level.
     // Also skip shortcut edges when near the destination. Always skip within
     // 10km but also reject long shortcut edges outside this distance.
@@ -149,18 +274,26 @@ void AStarPathAlgorithm::ExpandForward(GraphReader& graphreader,
       continue;
     }
 
+    // Hint the neighboring tile before the costing work so an async reader
+    // can pull it in while this edge is still being evaluated
+    if (directededge->leaves_tile()) {
+      graphreader.Prefetch(directededge->endnode());
+    }
+
     // Skip this edge if permanently labeled (best path already found to this
-    // directed edge), if no access is allowed to this edge (based on costing method),
-    // or if a complex restriction exists.
+    // directed edge) or if a complex restriction exists.
     if (es->set() == EdgeSet::kPermanent ||
-        !costing_->Allowed(directededge, pred, tile, edgeid, 0, 0) ||
         costing_->Restricted(directededge, pred, edgelabels_, tile, edgeid, true)) {
       continue;
     }
 
-    // Compute the cost to the end of this edge
-    Cost newcost = pred.cost() + costing_->EdgeCost(directededge, tile->GetSpeed(directededge)) +
-                   costing_->TransitionCost(directededge, nodeinfo, pred);
+    // Check access and compute the cost to the end of this edge in a single
+    // dispatch into the costing
+    Cost tc, newcost;
+    if (!costing_->EvaluateForward(directededge, nodeinfo, pred, tile, edgeid, 0, 0,
+                                   tile->GetSpeed(directededge), tc, newcost)) {
+      continue;
+    }
 
     // If this edge is a destination, subtract the partial/remainder cost
     // (cost from the dest. location to the end of the edge).
@@ -223,14 +356,13 @@ void AStarPathAlgorithm::ExpandForward(GraphReader& graphreader,
   }
 
   // Handle transitions - expand from the end node of each transition
-  if (!from_transition && nodeinfo->transition_count() > 0) {
-    const NodeTransition* trans = tile->transition(nodeinfo->transition_index());
-    for (uint32_t i = 0; i < nodeinfo->transition_count(); ++i, ++trans) {
-      if (trans->up()) {
+  if (!from_transition) {
+    for (const auto& trans : tile->GetNodeTransitions(nodeinfo)) {
+      if (trans.up()) {
         hierarchy_limits_[node.level()].up_transition_count++;
-        ExpandForward(graphreader, trans->endnode(), pred, pred_idx, true, destination, best_path);
-      } else if (!hierarchy_limits_[trans->endnode().level()].StopExpanding(pred.distance())) {
-        ExpandForward(graphreader, trans->endnode(), pred, pred_idx, true, destination, best_path);
+        ExpandForward(graphreader, trans.endnode(), pred, pred_idx, true, destination, best_path);
+      } else if (!hierarchy_limits_[trans.endnode().level()].StopExpanding(pred.distance())) {
+        ExpandForward(graphreader, trans.endnode(), pred, pred_idx, true, destination, best_path);
       }
     }
   }
@@ -312,6 +444,7 @@ AStarPathAlgorithm::GetBestPath(odin::Location& origin,
     if (!pred.origin()) {
       edgestatus_.Update(pred.edgeid(), EdgeSet::kPermanent);
     }
+    RecordExpansion(pred.edgeid(), pred.cost().cost);
 
     // Check that distance is converging towards the destination. Return route
     // failure if no convergence for TODO iterations
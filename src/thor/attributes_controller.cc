@@ -5,6 +5,106 @@
 namespace valhalla {
 namespace thor {
 
+// Every attribute key, for compiling the attributes map into the masks
+const Attribute* const kAllAttributes[] = {
+    &kEdgeNames,
+    &kEdgeLength,
+    &kEdgeSpeed,
+    &kEdgeRoadClass,
+    &kEdgeBeginHeading,
+    &kEdgeEndHeading,
+    &kEdgeBeginShapeIndex,
+    &kEdgeEndShapeIndex,
+    &kEdgeTraversability,
+    &kEdgeUse,
+    &kEdgeToll,
+    &kEdgeUnpaved,
+    &kEdgeTunnel,
+    &kEdgeBridge,
+    &kEdgeRoundabout,
+    &kEdgeInternalIntersection,
+    &kEdgeDriveOnRight,
+    &kEdgeSurface,
+    &kEdgeSignExitNumber,
+    &kEdgeSignExitBranch,
+    &kEdgeSignExitToward,
+    &kEdgeSignExitName,
+    &kEdgeTravelMode,
+    &kEdgeVehicleType,
+    &kEdgePedestrianType,
+    &kEdgeBicycleType,
+    &kEdgeTransitType,
+    &kEdgeTransitRouteInfoOnestopId,
+    &kEdgeTransitRouteInfoBlockId,
+    &kEdgeTransitRouteInfoTripId,
+    &kEdgeTransitRouteInfoShortName,
+    &kEdgeTransitRouteInfoLongName,
+    &kEdgeTransitRouteInfoHeadsign,
+    &kEdgeTransitRouteInfoColor,
+    &kEdgeTransitRouteInfoTextColor,
+    &kEdgeTransitRouteInfoDescription,
+    &kEdgeTransitRouteInfoOperatorOnestopId,
+    &kEdgeTransitRouteInfoOperatorName,
+    &kEdgeTransitRouteInfoOperatorUrl,
+    &kEdgeId,
+    &kEdgeWayId,
+    &kEdgeWeightedGrade,
+    &kEdgeMaxUpwardGrade,
+    &kEdgeMaxDownwardGrade,
+    &kEdgeMeanElevation,
+    &kEdgeLaneCount,
+    &kEdgeLaneConnectivity,
+    &kEdgeCycleLane,
+    &kEdgeBicycleNetwork,
+    &kEdgeSidewalk,
+    &kEdgeDensity,
+    &kEdgeSpeedLimit,
+    &kEdgeTruckSpeed,
+    &kEdgeTruckRoute,
+    &kEdgeNameConsistency,
+    &kNodeIntersectingEdgeBeginHeading,
+    &kNodeIntersectingEdgeFromEdgeNameConsistency,
+    &kNodeIntersectingEdgeToEdgeNameConsistency,
+    &kNodeIntersectingEdgeDriveability,
+    &kNodeIntersectingEdgeCyclability,
+    &kNodeIntersectingEdgeWalkability,
+    &kNodeElapsedTime,
+    &kNodeaAdminIndex,
+    &kNodeType,
+    &kNodeFork,
+    &kNodeTransitPlatformInfoType,
+    &kNodeTransitPlatformInfoOnestopId,
+    &kNodeTransitPlatformInfoName,
+    &kNodeTransitPlatformInfoStationOnestopId,
+    &kNodeTransitPlatformInfoStationName,
+    &kNodeTransitPlatformInfoArrivalDateTime,
+    &kNodeTransitPlatformInfoDepartureDateTime,
+    &kNodeTransitPlatformInfoIsParentStop,
+    &kNodeTransitPlatformInfoAssumedSchedule,
+    &kNodeTransitPlatformInfoLatLon,
+    &kNodeTransitStationInfoOnestopId,
+    &kNodeTransitStationInfoName,
+    &kNodeTransitStationInfoLatLon,
+    &kNodeTransitEgressInfoOnestopId,
+    &kNodeTransitEgressInfoName,
+    &kNodeTransitEgressInfoLatLon,
+    &kNodeTimeZone,
+    &kOsmChangeset,
+    &kAdminCountryCode,
+    &kAdminCountryText,
+    &kAdminStateCode,
+    &kAdminStateText,
+    &kShape,
+    &kMatchedPoint,
+    &kMatchedType,
+    &kMatchedEdgeIndex,
+    &kMatchedBeginRouteDiscontinuity,
+    &kMatchedEndRouteDiscontinuity,
+    &kMatchedDistanceAlongEdge,
+    &kMatchedDistanceFromTracePoint,
+    &kConfidenceScore,
+    &kRawScore};
+
 const std::unordered_map<std::string, bool> AttributesController::kRouteAttributes = {
     // Edge keys
     {kEdgeNames, true},
@@ -61,6 +161,7 @@ const std::unordered_map<std::string, bool> AttributesController::kRouteAttribut
     {kEdgeSpeedLimit, true},
     {kEdgeTruckSpeed, true},
     {kEdgeTruckRoute, true},
+    {kEdgeNameConsistency, true},
 
     // Node keys
     {kNodeIntersectingEdgeBeginHeading, true},
@@ -113,18 +214,33 @@ const std::unordered_map<std::string, bool> AttributesController::kRouteAttribut
 AttributesController::AttributesController(
     const std::unordered_map<std::string, bool>& new_attributes) {
   attributes = new_attributes;
+  compile();
 }
 
 void AttributesController::enable_all() {
   for (auto& pair : attributes) {
     pair.second = true;
   }
+  compile();
 }
 
 void AttributesController::disable_all() {
   for (auto& pair : attributes) {
     pair.second = false;
   }
+  compile();
+}
+
+void AttributesController::compile() {
+  for (size_t group = 0; group < kGroupCount; ++group) {
+    masks_[group] = 0;
+  }
+  for (const auto* attribute : kAllAttributes) {
+    auto found = attributes.find(attribute->name);
+    if (found != attributes.cend() && found->second) {
+      masks_[attribute->group] |= attribute->mask;
+    }
+  }
 }
 
 bool AttributesController::category_attribute_enabled(const std::string& category) const {
@@ -1,8 +1,10 @@
 #include "thor/bidirectional_astar.h"
 #include "baldr/datetime.h"
 #include "midgard/logging.h"
+#include "midgard/util.h"
 #include <algorithm>
 #include <map>
+#include <unordered_set>
 
 using namespace valhalla::baldr;
 using namespace valhalla::sif;
@@ -12,19 +14,23 @@ namespace thor {
 
 constexpr uint64_t kInitialEdgeLabelCountBD = 1000000;
 
-// Threshold (seconds) to extend search once the first connection has been found.
-// TODO - this is currently set based on some exceptional cases (e.g. routes taking
-// the PA Turnpike which have very long edges). Using a metric based on maximum edge
-// cost creates large performance drops - so perhaps some other metric can be found?
-constexpr float kThresholdDelta = 420.0f;
+// Limits for accepting a candidate connection as an alternate path: its cost
+// may exceed the best path cost by at most the stretch factor and its path may
+// share at most the sharing fraction of its edges with the best path and any
+// alternate already accepted.
+constexpr float kMaxAlternateStretch = 1.25f;
+constexpr float kMaxAlternateSharing = 0.75f;
 
 // Default constructor
 BidirectionalAStar::BidirectionalAStar() : PathAlgorithm() {
-  threshold_ = 0;
+  expansions_at_best_ = 0;
   mode_ = TravelMode::kDrive;
   access_mode_ = kAutoAccess;
   travel_type_ = 0;
-  cost_diff_ = 0.0f;
+  potential_forward_offset_ = 0.0f;
+  potential_reverse_offset_ = 0.0f;
+  adaptive_hierarchy_limits_ = false;
+  max_alternates_ = 0;
   adjacencylist_forward_ = nullptr;
   adjacencylist_reverse_ = nullptr;
 }
@@ -36,12 +42,19 @@ BidirectionalAStar::~BidirectionalAStar() {
 
 // Clear the temporary information generated during path construction.
 void BidirectionalAStar::Clear() {
-  edgelabels_forward_.clear();
-  edgelabels_reverse_.clear();
-  adjacencylist_forward_.reset();
-  adjacencylist_reverse_.reset();
+  sif::ClearLabels(edgelabels_forward_);
+  sif::ClearLabels(edgelabels_reverse_);
+  // Empty the adjacency lists but keep their bucket storage for the next
+  // request
+  if (adjacencylist_forward_) {
+    adjacencylist_forward_->clear();
+  }
+  if (adjacencylist_reverse_) {
+    adjacencylist_reverse_->clear();
+  }
   edgestatus_forward_.clear();
   edgestatus_reverse_.clear();
+  candidate_connections_.clear();
 
   // Set the ferry flag to false
   has_ferry_ = false;
@@ -68,32 +81,85 @@ void BidirectionalAStar::Init(const PointLL& origll, const PointLL& destll) {
     return edgelabels_reverse_[label].sortcost();
   };
 
+  // Set the per direction potential offsets: each balanced potential is
+  // shifted to be zero at its own target, which makes the two searches start
+  // from the same sort cost (no "evening" of the directions is needed)
+  float mincostf = astarheuristic_forward_.Get(origll);
+  float mincostr = astarheuristic_reverse_.Get(destll);
+  potential_forward_offset_ = 0.5f * mincostr;
+  potential_reverse_offset_ = 0.5f * mincostf;
+  float mincost = potential_forward_offset_ + potential_reverse_offset_;
+
   // Construct adjacency list and initialize edge status lookup.
   // Set bucket size and cost range based on DynamicCost.
   uint32_t bucketsize = costing_->UnitSize();
   float range = kBucketCount * bucketsize;
-  float mincostf = astarheuristic_forward_.Get(origll);
-  adjacencylist_forward_.reset(new DoubleBucketQueue(mincostf, range, bucketsize, forward_edgecost));
-  float mincostr = astarheuristic_reverse_.Get(destll);
-  adjacencylist_reverse_.reset(new DoubleBucketQueue(mincostr, range, bucketsize, reverse_edgecost));
+  if (adjacencylist_forward_) {
+    adjacencylist_forward_->reuse(mincost, range, bucketsize, forward_edgecost);
+  } else {
+    adjacencylist_forward_.reset(new DoubleBucketQueue(mincost, range, bucketsize, forward_edgecost));
+  }
+  if (adjacencylist_reverse_) {
+    adjacencylist_reverse_->reuse(mincost, range, bucketsize, reverse_edgecost);
+  } else {
+    adjacencylist_reverse_.reset(new DoubleBucketQueue(mincost, range, bucketsize, reverse_edgecost));
+  }
   edgestatus_forward_.clear();
   edgestatus_reverse_.clear();
 
-  // Set the cost diff between forward and reverse searches (due to distance
-  // approximator differences). This is used to "even" the forward and reverse
-  // searches.
-  cost_diff_ = mincostf - mincostr;
-
-  // Initialize best connection with max cost
+  // Initialize best connection with max cost. Candidates from a prior
+  // search do not carry over.
   best_connection_ = {GraphId(), GraphId(), std::numeric_limits<float>::max()};
+  candidate_connections_.clear();
+  expansions_at_best_ = 0;
 
-  // Set the cost threshold to the maximum float value. Once the initial connection is found
-  // the threshold is set.
-  threshold_ = std::numeric_limits<float>::max();
-
-  // Support for hierarchy transitions
+  // Support for hierarchy transitions. Optionally scale the transition
+  // counts by the origin to destination distance so short routes do not
+  // spend the full budget near one endpoint.
   hierarchy_limits_forward_ = costing_->GetHierarchyLimits();
   hierarchy_limits_reverse_ = costing_->GetHierarchyLimits();
+  if (adaptive_hierarchy_limits_) {
+    float distance = origll.Distance(destll);
+    for (auto& limits : hierarchy_limits_forward_) {
+      limits.ScaleMaxUpTransitions(distance);
+    }
+    for (auto& limits : hierarchy_limits_reverse_) {
+      limits.ScaleMaxUpTransitions(distance);
+    }
+  }
+
+  // Reset the per level expansion telemetry
+  std::fill(std::begin(expansions_forward_), std::end(expansions_forward_), 0);
+  std::fill(std::begin(expansions_reverse_), std::end(expansions_reverse_), 0);
+}
+
+// Scale the hierarchy transition budgets by the statistics the endpoint
+// tiles carry. A dense metro grid reaches the upper hierarchy in far fewer
+// expansions than a sparse rural tile, so its budget can be tightened
+// without losing route quality.
+void BidirectionalAStar::ScaleLimitsByTileStats(GraphReader& graphreader,
+                                                const odin::Location& origin,
+                                                const odin::Location& destination) {
+  const GraphTile* origin_tile =
+      graphreader.GetGraphTile(GraphId(origin.path_edges(0).graph_id()));
+  const GraphTile* dest_tile =
+      graphreader.GetGraphTile(GraphId(destination.path_edges(0).graph_id()));
+  if (origin_tile == nullptr || dest_tile == nullptr || !origin_tile->header()->has_stats() ||
+      !dest_tile->header()->has_stats()) {
+    return;
+  }
+
+  // The denser endpoint bounds how quickly its search reaches the upper
+  // levels. Scale the budgets down to half for the densest tiles
+  uint32_t density = std::max(origin_tile->header()->node_density_p90(),
+                              dest_tile->header()->node_density_p90());
+  float factor = 1.0f - 0.5f * static_cast<float>(density) / kMaxDensity;
+  for (auto& limits : hierarchy_limits_forward_) {
+    limits.ScaleByFactor(factor);
+  }
+  for (auto& limits : hierarchy_limits_reverse_) {
+    limits.ScaleByFactor(factor);
+  }
 }
 
 // Expand from a node in the forward direction
@@ -113,16 +179,38 @@ void BidirectionalAStar::ExpandForward(GraphReader& graphreader,
     return;
   }
 
+  // Count the expansion against the node's level
+  expansions_forward_[node.level()]++;
+
   // Expand from end node in forward direction.
   uint32_t shortcuts = 0;
   GraphId edgeid = {node.tileid(), node.level(), nodeinfo->edge_index()};
   EdgeStatusInfo* es = edgestatus_forward_.GetPtr(edgeid, tile);
   const DirectedEdge* directededge = tile->directededge(edgeid);
-  for (uint32_t i = 0; i < nodeinfo->edge_count(); ++i, ++directededge, ++edgeid, ++es) {
-    // Skip shortcut edges until we have stopped expanding on the next level. Use regular
-    // edges while still expanding on the next level since we can still transition down to
-    // that level. If using a shortcut, set the shortcuts mask. Skip if this is a regular
-    // edge superseded by a shortcut.
+
+  // Bring the directed edge and edge status records for this node into
+  // cache ahead of the walk below - the loop otherwise stalls on its first
+  // touch of each record
+  midgard::prefetch_range(directededge, nodeinfo->edge_count() * sizeof(DirectedEdge));
+  midgard::prefetch_range(es, nodeinfo->edge_count() * sizeof(EdgeStatusInfo));
+
+  // Shortcuts lead the node's edge list and their count is recorded, so the
+  // walk only covers the relevant range: until the next level up has stopped
+  // expanding no shortcut is usable and the prefix is stepped over outright,
+  // afterwards each shortcut is taken and its mask collected so the regular
+  // edges it supersedes drop out
+  uint32_t i = 0;
+  const uint32_t shortcut_count = nodeinfo->shortcut_count();
+  if (shortcut_count > 0 && !hierarchy_limits_forward_[node.level() + 1].StopExpanding()) {
+    i = shortcut_count;
+    directededge += shortcut_count;
+    edgeid = edgeid + shortcut_count;
+    es += shortcut_count;
+  }
+  for (; i < nodeinfo->edge_count(); ++i, ++directededge, ++edgeid, ++es) {
+    // Take a shortcut (only usable ones remain in the walk, tiles built
+    // before the count was recorded still skip them here) or skip a regular
+    // edge superseded by a shortcut already taken
     if (directededge->is_shortcut()) {
       if (hierarchy_limits_forward_[edgeid.level() + 1].StopExpanding()) {
         shortcuts |= directededge->shortcut();
@@ -134,18 +222,20 @@ void BidirectionalAStar::ExpandForward(GraphReader& graphreader,
     }
 
     // Skip this edge if edge is permanently labeled (best path already found
-    // to this directed edge), if no access is allowed (based on costing method),
-    // or if a complex restriction prevents transition onto this edge.
+    // to this directed edge) or if a complex restriction prevents transition
+    // onto this edge.
     if (es->set() == EdgeSet::kPermanent ||
-        !costing_->Allowed(directededge, pred, tile, edgeid, 0, 0) ||
         costing_->Restricted(directededge, pred, edgelabels_forward_, tile, edgeid, true)) {
       continue;
     }
 
-    // Get cost. Separate out transition cost.
-    Cost tc = costing_->TransitionCost(directededge, nodeinfo, pred);
-    Cost newcost = pred.cost() + tc + costing_->EdgeCost(directededge, tile->GetSpeed(directededge));
-    ;
+    // Check access and get the cost, with the transition cost separated out,
+    // in a single dispatch into the costing
+    Cost tc, newcost;
+    if (!costing_->EvaluateForward(directededge, nodeinfo, pred, tile, edgeid, 0, 0,
+                                   tile->GetSpeed(directededge), tc, newcost)) {
+      continue;
+    }
 
     // Check if edge is temporarily labeled and this path has less cost. If
     // less cost the predecessor is updated and the sort cost is decremented
@@ -172,7 +262,7 @@ void BidirectionalAStar::ExpandForward(GraphReader& graphreader,
     // end node of the directed edge.
     float dist = 0.0f;
     float sortcost =
-        newcost.cost + astarheuristic_forward_.Get(t2->get_node_ll(directededge->endnode()), dist);
+        newcost.cost + ForwardPotential(t2->get_node_ll(directededge->endnode()), dist);
 
     // Add edge label, add to the adjacency list and set edge status
     uint32_t idx = edgelabels_forward_.size();
@@ -215,16 +305,38 @@ void BidirectionalAStar::ExpandReverse(GraphReader& graphreader,
     return;
   }
 
+  // Count the expansion against the node's level
+  expansions_reverse_[node.level()]++;
+
   // Expand from end node in reverse direction.
   uint32_t shortcuts = 0;
   GraphId edgeid = {node.tileid(), node.level(), nodeinfo->edge_index()};
   EdgeStatusInfo* es = edgestatus_reverse_.GetPtr(edgeid, tile);
   const DirectedEdge* directededge = tile->directededge(edgeid);
-  for (uint32_t i = 0; i < nodeinfo->edge_count(); ++i, ++directededge, ++edgeid, ++es) {
-    // Skip shortcut edges until we have stopped expanding on the next level. Use regular
-    // edges while still expanding on the next level since we can still transition down to
-    // that level. If using a shortcut, set the shortcuts mask. Skip if this is a regular
-    // edge superseded by a shortcut.
+
+  // Bring the directed edge and edge status records for this node into
+  // cache ahead of the walk below - the loop otherwise stalls on its first
+  // touch of each record
+  midgard::prefetch_range(directededge, nodeinfo->edge_count() * sizeof(DirectedEdge));
+  midgard::prefetch_range(es, nodeinfo->edge_count() * sizeof(EdgeStatusInfo));
+
+  // Shortcuts lead the node's edge list and their count is recorded, so the
+  // walk only covers the relevant range: until the next level up has stopped
+  // expanding no shortcut is usable and the prefix is stepped over outright,
+  // afterwards each shortcut is taken and its mask collected so the regular
+  // edges it supersedes drop out
+  uint32_t i = 0;
+  const uint32_t shortcut_count = nodeinfo->shortcut_count();
+  if (shortcut_count > 0 && !hierarchy_limits_reverse_[node.level() + 1].StopExpanding()) {
+    i = shortcut_count;
+    directededge += shortcut_count;
+    edgeid = edgeid + shortcut_count;
+    es += shortcut_count;
+  }
+  for (; i < nodeinfo->edge_count(); ++i, ++directededge, ++edgeid, ++es) {
+    // Take a shortcut (only usable ones remain in the walk, tiles built
+    // before the count was recorded still skip them here) or skip a regular
+    // edge superseded by a shortcut already taken
     if (directededge->is_shortcut()) {
       if (hierarchy_limits_reverse_[edgeid.level() + 1].StopExpanding()) {
         shortcuts |= directededge->shortcut();
@@ -241,28 +353,35 @@ void BidirectionalAStar::ExpandReverse(GraphReader& graphreader,
       continue;
     }
 
-    // Get end node tile, opposing edge Id, and opposing directed edge.
+    // Get end node tile, opposing edge Id, and opposing directed edge. An
+    // edge that was already labeled recorded its opposing edge id, so the
+    // walk over the end node's edge list to find it is only done the first
+    // time the edge is reached (it otherwise repeats for every incoming
+    // edge that relaxes the label at a dense intersection)
     const GraphTile* t2 =
         directededge->leaves_tile() ? graphreader.GetGraphTile(directededge->endnode()) : tile;
     if (t2 == nullptr) {
       continue;
     }
-    GraphId oppedge = t2->GetOpposingEdgeId(directededge);
+    GraphId oppedge = es->set() == EdgeSet::kUnreached
+                          ? t2->GetOpposingEdgeId(directededge)
+                          : edgelabels_reverse_[es->index()].opp_edgeid();
     const DirectedEdge* opp_edge = t2->directededge(oppedge);
 
-    // Skip this edge if no access is allowed (based on costing method)
-    // or if a complex restriction prevents transition onto this edge.
-    if (!costing_->AllowedReverse(directededge, pred, opp_edge, t2, oppedge, 0, 0) ||
-        costing_->Restricted(directededge, pred, edgelabels_reverse_, tile, edgeid, false)) {
+    // Skip this edge if a complex restriction prevents transition onto this
+    // edge.
+    if (costing_->Restricted(directededge, pred, edgelabels_reverse_, tile, edgeid, false)) {
       continue;
     }
 
-    // Get cost. Use opposing edge for EdgeCost. Separate the transition seconds so we
-    // can properly recover elapsed time on the reverse path.
-    Cost tc = costing_->TransitionCostReverse(directededge->localedgeidx(), nodeinfo, opp_edge,
-                                              opp_pred_edge);
-    Cost newcost = pred.cost() + costing_->EdgeCost(opp_edge, tile->GetSpeed(opp_edge));
-    newcost.cost += tc.cost;
+    // Check access and get the cost in a single dispatch into the costing.
+    // Uses the opposing edge for EdgeCost and separates the transition
+    // seconds so we can properly recover elapsed time on the reverse path.
+    Cost tc, newcost;
+    if (!costing_->EvaluateReverse(directededge, pred, opp_edge, nodeinfo, opp_pred_edge, t2,
+                                   oppedge, 0, 0, tile->GetSpeed(opp_edge), tc, newcost)) {
+      continue;
+    }
 
     // Check if edge is temporarily labeled and this path has less cost. If
     // less cost the predecessor is updated and the sort cost is decremented
@@ -281,7 +400,7 @@ void BidirectionalAStar::ExpandReverse(GraphReader& graphreader,
     // end node of the directed edge.
     float dist = 0.0f;
     float sortcost =
-        newcost.cost + astarheuristic_reverse_.Get(t2->get_node_ll(directededge->endnode()), dist);
+        newcost.cost + ReversePotential(t2->get_node_ll(directededge->endnode()), dist);
 
     // Add edge label, add to the adjacency list and set edge status
     uint32_t idx = edgelabels_reverse_.size();
@@ -325,6 +444,12 @@ BidirectionalAStar::GetBestPath(odin::Location& origin,
   PointLL destination_new(destination.path_edges(0).ll().lng(), destination.path_edges(0).ll().lat());
   Init(origin_new, destination_new);
 
+  // When the endpoint tiles carry build time statistics, let the measured
+  // density tighten the hierarchy budgets beyond the distance scaling
+  if (adaptive_hierarchy_limits_) {
+    ScaleLimitsByTileStats(graphreader, origin, destination);
+  }
+
   // Set origin and destination locations - seeds the adj. lists
   // Note: because we can correlate to more than one place for a given
   // PathLocation using edges.front here means we are only setting the
@@ -350,15 +475,23 @@ BidirectionalAStar::GetBestPath(odin::Location& origin,
     }
     n++;
 
+    // The cost any remaining connection can reach before it is no longer
+    // worth finding. When alternates were requested the search runs on to
+    // the stretch limit to expose more meeting plateaus
+    const float cost_bound = max_alternates_ > 0 ? best_connection_.cost * kMaxAlternateStretch
+                                                 : best_connection_.cost;
+
     // Get the next predecessor (based on which direction was expanded in prior step)
     if (expand_forward) {
       forward_pred_idx = adjacencylist_forward_->pop();
       if (forward_pred_idx != kInvalidLabel) {
         fwd_pred = edgelabels_forward_[forward_pred_idx];
 
-        // Terminate if the cost threshold has been exceeded.
-        if (fwd_pred.sortcost() + cost_diff_ > threshold_) {
-          return FormPath(graphreader);
+        // Start loading the label the next iteration will pop while this
+        // one is processed
+        uint32_t next = adjacencylist_forward_->peek();
+        if (next != kInvalidLabel) {
+          midgard::prefetch_range(&edgelabels_forward_[next], sizeof(BDEdgeLabel));
         }
 
         // Check if the edge on the forward search connects to a settled edge on the
@@ -387,9 +520,11 @@ BidirectionalAStar::GetBestPath(odin::Location& origin,
       if (reverse_pred_idx != kInvalidLabel) {
         rev_pred = edgelabels_reverse_[reverse_pred_idx];
 
-        // Terminate if the cost threshold has been exceeded.
-        if (rev_pred.sortcost() > threshold_) {
-          return FormPath(graphreader);
+        // Start loading the label the next iteration will pop while this
+        // one is processed
+        uint32_t next = adjacencylist_reverse_->peek();
+        if (next != kInvalidLabel) {
+          midgard::prefetch_range(&edgelabels_reverse_[next], sizeof(BDEdgeLabel));
         }
 
         // Check if the edge on the reverse search connects to a settled edge on the
@@ -414,14 +549,26 @@ BidirectionalAStar::GetBestPath(odin::Location& origin,
       }
     }
 
-    // Expand from the search direction with lower sort cost.
-    if ((fwd_pred.sortcost() + cost_diff_) < rev_pred.sortcost()) {
+    // The balanced potentials give the two searches one shared stopping
+    // rule: every forward/reverse label pair carries the potential offsets'
+    // sum of heuristic in excess of its true path cost, so once the queue
+    // tops sum to the bound plus that constant no pair of labels can form a
+    // better connection and the best one found is optimal
+    if (fwd_pred.sortcost() + rev_pred.sortcost() >=
+        cost_bound + potential_forward_offset_ + potential_reverse_offset_) {
+      return FormPath(graphreader);
+    }
+
+    // Expand from the search direction with lower sort cost. The balanced
+    // potentials make the sort costs directly comparable across directions.
+    if (fwd_pred.sortcost() < rev_pred.sortcost()) {
       // Expand forward - set to get next edge from forward adj. list on the next pass
       expand_forward = true;
       expand_reverse = false;
 
       // Settle this edge.
       edgestatus_forward_.Update(fwd_pred.edgeid(), EdgeSet::kPermanent);
+      RecordExpansion(fwd_pred.edgeid(), fwd_pred.cost().cost);
 
       // Prune path if predecessor is not a through edge or if the maximum
       // number of upward transitions has been exceeded on this hierarchy level.
@@ -439,6 +586,7 @@ BidirectionalAStar::GetBestPath(odin::Location& origin,
 
       // Settle this edge
       edgestatus_reverse_.Update(rev_pred.edgeid(), EdgeSet::kPermanent);
+      RecordExpansion(rev_pred.edgeid(), rev_pred.cost().cost);
 
       // Prune path if predecessor is not a through edge
       if ((rev_pred.not_thru() && rev_pred.not_thru_pruning()) ||
@@ -492,12 +640,14 @@ bool BidirectionalAStar::SetForwardConnection(const BDEdgeLabel& pred) {
   // Set best_connection if cost is less than the best cost so far.
   if (c < best_connection_.cost) {
     best_connection_ = {pred.edgeid(), oppedge, c};
+    expansions_at_best_ = total_expansions();
   }
 
-  // Set a threshold to extend search
-  if (threshold_ == std::numeric_limits<float>::max()) {
-    threshold_ = pred.sortcost() + cost_diff_ + kThresholdDelta;
+  // Retain the candidate so an alternate path can be formed through it
+  if (max_alternates_ > 0) {
+    candidate_connections_.push_back({pred.edgeid(), oppedge, c});
   }
+
   return true;
 }
 
@@ -534,12 +684,14 @@ bool BidirectionalAStar::SetReverseConnection(const BDEdgeLabel& pred) {
   // Set best_connection if cost is less than the best cost so far.
   if (c < best_connection_.cost) {
     best_connection_ = {oppedge, pred.edgeid(), c};
+    expansions_at_best_ = total_expansions();
   }
 
-  // Set a threshold to extend search
-  if (threshold_ == std::numeric_limits<float>::max()) {
-    threshold_ = pred.sortcost() + kThresholdDelta;
+  // Retain the candidate so an alternate path can be formed through it
+  if (max_alternates_ > 0) {
+    candidate_connections_.push_back({oppedge, pred.edgeid(), c});
   }
+
   return true;
 }
 
@@ -588,8 +740,9 @@ void BidirectionalAStar::SetOrigin(GraphReader& graphreader, odin::Location& ori
     // We assume the slowest speed you could travel to cover that distance to start/end the route
     // TODO: assumes 1m/s which is a maximum penalty this could vary per costing model
     cost.cost += edge.distance();
-    float dist = astarheuristic_forward_.GetDistance(nodeinfo->latlng(endtile->header()->base_ll()));
-    float sortcost = cost.cost + astarheuristic_forward_.Get(dist);
+    float dist = 0.0f;
+    float sortcost =
+        cost.cost + ForwardPotential(nodeinfo->latlng(endtile->header()->base_ll()), dist);
 
     // Add EdgeLabel to the adjacency list. Set the predecessor edge index
     // to invalid to indicate the origin of the path.
@@ -652,8 +805,8 @@ void BidirectionalAStar::SetDestination(GraphReader& graphreader, const odin::Lo
     // We assume the slowest speed you could travel to cover that distance to start/end the route
     // TODO: assumes 1m/s which is a maximum penalty this could vary per costing model
     cost.cost += edge.distance();
-    float dist = astarheuristic_reverse_.GetDistance(tile->get_node_ll(opp_dir_edge->endnode()));
-    float sortcost = cost.cost + astarheuristic_reverse_.Get(dist);
+    float dist = 0.0f;
+    float sortcost = cost.cost + ReversePotential(tile->get_node_ll(opp_dir_edge->endnode()), dist);
 
     // Add EdgeLabel to the adjacency list. Set the predecessor edge index
     // to invalid to indicate the origin of the path. Make sure the opposing
@@ -671,11 +824,17 @@ void BidirectionalAStar::SetDestination(GraphReader& graphreader, const odin::Lo
   }
 }
 
-// Form the path from the adjacency list.
+// Form the path from the adjacency list using the best connection.
 std::vector<PathInfo> BidirectionalAStar::FormPath(GraphReader& graphreader) {
+  return FormPath(graphreader, best_connection_);
+}
+
+// Form the path from the adjacency list for the given connection.
+std::vector<PathInfo> BidirectionalAStar::FormPath(GraphReader& graphreader,
+                                                   const CandidateConnection& connection) {
   // Get the indexes where the connection occurs.
-  uint32_t idx1 = edgestatus_forward_.Get(best_connection_.edgeid).index();
-  uint32_t idx2 = edgestatus_reverse_.Get(best_connection_.opp_edgeid).index();
+  uint32_t idx1 = edgestatus_forward_.Get(connection.edgeid).index();
+  uint32_t idx2 = edgestatus_reverse_.Get(connection.opp_edgeid).index();
 
   // Metrics (TODO - more accurate cost)
   uint32_t pathcost = edgelabels_forward_[idx1].cost().cost + edgelabels_reverse_[idx2].cost().cost;
@@ -683,6 +842,23 @@ std::vector<PathInfo> BidirectionalAStar::FormPath(GraphReader& graphreader) {
   LOG_DEBUG("FormPath path_iterations::" + std::to_string(edgelabels_forward_.size()) + "," +
             std::to_string(edgelabels_reverse_.size()));
 
+  // Per level expansion and upward transition counts (forward/reverse) to
+  // support tuning of the hierarchy limits
+#if defined(LOGGING_LEVEL_DEBUG) || defined(LOGGING_LEVEL_ALL)
+  std::string expansions;
+  for (size_t level = 0; level < hierarchy_limits_forward_.size(); ++level) {
+    expansions += std::to_string(level) + ":" + std::to_string(expansions_forward_[level]) + "/" +
+                  std::to_string(expansions_reverse_[level]) + "," +
+                  std::to_string(hierarchy_limits_forward_[level].up_transition_count) + "/" +
+                  std::to_string(hierarchy_limits_reverse_[level].up_transition_count) + " ";
+  }
+  LOG_DEBUG("hierarchy_expansions::" + expansions);
+
+  // Expansion spent proving the connection optimal (or collecting alternate
+  // candidates); what the cost bound termination is keeping small
+  LOG_DEBUG("expansions_past_best::" + std::to_string(total_expansions() - expansions_at_best_));
+#endif
+
   // Work backwards on the forward path
   std::vector<PathInfo> path;
   for (auto edgelabel_index = idx1; edgelabel_index != kInvalidLabel;
@@ -751,5 +927,60 @@ std::vector<PathInfo> BidirectionalAStar::FormPath(GraphReader& graphreader) {
   return path;
 }
 
+// Form alternate paths from the candidate connections found during the last
+// search. Every place the two search trees met is a potential detour point,
+// so the candidates are walked in cost order and kept when they are cheap
+// enough and distinct enough from the paths already taken.
+std::vector<std::vector<PathInfo>>
+BidirectionalAStar::GetAlternatePaths(GraphReader& graphreader) {
+  std::vector<std::vector<PathInfo>> alternates;
+  if (max_alternates_ == 0 || best_connection_.cost == std::numeric_limits<float>::max()) {
+    return alternates;
+  }
+
+  // Consider the cheapest candidates first
+  std::sort(candidate_connections_.begin(), candidate_connections_.end(),
+            [](const CandidateConnection& a, const CandidateConnection& b) {
+              return a.cost < b.cost;
+            });
+
+  // Edges used by the best path and by the alternates accepted so far. Note
+  // that a candidate found from both search directions forms the same path
+  // twice - the duplicate shares every edge so the sharing limit rejects it.
+  std::unordered_set<uint64_t> used_edges;
+  for (const auto& info : FormPath(graphreader)) {
+    used_edges.insert(info.edgeid.value);
+  }
+
+  float max_cost = best_connection_.cost * kMaxAlternateStretch;
+  for (const auto& candidate : candidate_connections_) {
+    if (alternates.size() == max_alternates_ || candidate.cost > max_cost) {
+      break;
+    }
+    // The best connection is the best path itself
+    if (candidate.edgeid == best_connection_.edgeid &&
+        candidate.opp_edgeid == best_connection_.opp_edgeid) {
+      continue;
+    }
+
+    // Form the path and see how much of it retraces the paths already taken
+    auto path = FormPath(graphreader, candidate);
+    size_t shared = 0;
+    for (const auto& info : path) {
+      shared += used_edges.count(info.edgeid.value);
+    }
+    if (path.empty() || shared > path.size() * kMaxAlternateSharing) {
+      continue;
+    }
+
+    // Distinct enough to keep - its edges now count as taken
+    for (const auto& info : path) {
+      used_edges.insert(info.edgeid.value);
+    }
+    alternates.emplace_back(std::move(path));
+  }
+  return alternates;
+}
+
 } // namespace thor
 } // namespace valhalla
@@ -0,0 +1,345 @@
+#include "thor/contractionhierarchy.h"
+
+#include <algorithm>
+#include <queue>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace {
+
+// Cap the witness searches so contracting a dense node cannot degenerate
+// into repeated full Dijkstras. Missing a witness only costs an extra
+// shortcut, never correctness.
+constexpr uint32_t kMaxWitnessSettled = 500;
+
+constexpr float kInfiniteCost = std::numeric_limits<float>::infinity();
+
+// (cost, node) min-heap entry
+using heap_entry_t = std::pair<float, uint32_t>;
+using min_heap_t = std::priority_queue<heap_entry_t, std::vector<heap_entry_t>, std::greater<heap_entry_t>>;
+
+} // namespace
+
+namespace valhalla {
+namespace thor {
+
+constexpr uint32_t ContractionHierarchy::kInvalidNode;
+
+ContractionHierarchy::ContractionHierarchy(const uint32_t node_count)
+    : forward_(node_count), reverse_(node_count), order_(node_count, 0),
+      contracted_(node_count, false), depth_(node_count, 0), shortcut_count_(0), built_(false) {
+}
+
+void ContractionHierarchy::AddEdge(const uint32_t source,
+                                   const uint32_t target,
+                                   const float weight) {
+  if (built_) {
+    throw std::logic_error("ContractionHierarchy edges must be added before Build");
+  }
+  forward_[source].push_back({target, weight, kInvalidNode});
+  reverse_[target].push_back({source, weight, kInvalidNode});
+}
+
+// Witness search: bounded forward Dijkstra from source avoiding the node
+// being contracted.
+bool ContractionHierarchy::HasWitness(const uint32_t source,
+                                      const uint32_t target,
+                                      const uint32_t excluded,
+                                      const float max_weight) const {
+  std::unordered_map<uint32_t, float> costs;
+  min_heap_t queue;
+  queue.emplace(0.0f, source);
+  costs[source] = 0.0f;
+  uint32_t settled = 0;
+  while (!queue.empty() && settled < kMaxWitnessSettled) {
+    auto top = queue.top();
+    queue.pop();
+    if (top.first > costs[top.second]) {
+      continue; // stale entry
+    }
+    if (top.second == target) {
+      return true;
+    }
+    if (top.first > max_weight) {
+      return false; // everything left is costlier than the shortcut
+    }
+    ++settled;
+    for (const auto& edge : forward_[top.second]) {
+      if (edge.target == excluded || contracted_[edge.target]) {
+        continue;
+      }
+      float cost = top.first + edge.weight;
+      auto inserted = costs.emplace(edge.target, cost);
+      if (inserted.second || cost < inserted.first->second) {
+        inserted.first->second = cost;
+        queue.emplace(cost, edge.target);
+      }
+    }
+  }
+  return false;
+}
+
+// Edge difference (shortcuts we would add minus edges we remove) plus the
+// depth term that keeps contraction spatially spread out.
+int32_t ContractionHierarchy::ContractionPriority(const uint32_t node) const {
+  int32_t removed = 0;
+  for (const auto& edge : forward_[node]) {
+    removed += !contracted_[edge.target];
+  }
+  for (const auto& edge : reverse_[node]) {
+    removed += !contracted_[edge.target];
+  }
+  int32_t added = 0;
+  for (const auto& in : reverse_[node]) {
+    if (contracted_[in.target]) {
+      continue;
+    }
+    for (const auto& out : forward_[node]) {
+      if (contracted_[out.target] || in.target == out.target) {
+        continue;
+      }
+      // assume the shortcut is needed, witness searches happen at
+      // contraction time. Overestimating only perturbs the order
+      ++added;
+    }
+  }
+  return added - removed + static_cast<int32_t>(depth_[node]);
+}
+
+// Contract one node, adding shortcuts between its remaining neighbors.
+void ContractionHierarchy::Contract(const uint32_t node) {
+  for (const auto& in : reverse_[node]) {
+    if (contracted_[in.target]) {
+      continue;
+    }
+    for (const auto& out : forward_[node]) {
+      if (contracted_[out.target] || in.target == out.target) {
+        continue;
+      }
+      float weight = in.weight + out.weight;
+      if (!HasWitness(in.target, out.target, node, weight)) {
+        forward_[in.target].push_back({out.target, weight, node});
+        reverse_[out.target].push_back({in.target, weight, node});
+        ++shortcut_count_;
+      }
+    }
+  }
+  contracted_[node] = true;
+  for (const auto& edge : forward_[node]) {
+    depth_[edge.target] = std::max(depth_[edge.target], depth_[node] + 1);
+  }
+  for (const auto& edge : reverse_[node]) {
+    depth_[edge.target] = std::max(depth_[edge.target], depth_[node] + 1);
+  }
+}
+
+void ContractionHierarchy::Build() {
+  if (built_) {
+    return;
+  }
+
+  // lazy-update priority queue over contraction priorities
+  using priority_entry_t = std::pair<int32_t, uint32_t>;
+  std::priority_queue<priority_entry_t, std::vector<priority_entry_t>,
+                      std::greater<priority_entry_t>>
+      queue;
+  for (uint32_t node = 0; node < forward_.size(); ++node) {
+    queue.emplace(ContractionPriority(node), node);
+  }
+
+  uint32_t next_order = 0;
+  while (!queue.empty()) {
+    auto top = queue.top();
+    queue.pop();
+    if (contracted_[top.second]) {
+      continue;
+    }
+    // neighbors contracted since this entry was pushed may have changed the
+    // priority, reinsert unless it is still the minimum
+    int32_t priority = ContractionPriority(top.second);
+    if (!queue.empty() && priority > queue.top().first) {
+      queue.emplace(priority, top.second);
+      continue;
+    }
+    order_[top.second] = next_order++;
+    Contract(top.second);
+  }
+  built_ = true;
+}
+
+// Bidirectional upward search. Both directions only relax edges leading to
+// more important nodes; the best meeting node gives the shortest path.
+float ContractionHierarchy::Cost(const uint32_t source, const uint32_t target) const {
+  if (!built_) {
+    throw std::logic_error("ContractionHierarchy must be built before querying");
+  }
+  std::unordered_map<uint32_t, float> forward_costs, reverse_costs;
+  min_heap_t forward_queue, reverse_queue;
+  forward_queue.emplace(0.0f, source);
+  forward_costs[source] = 0.0f;
+  reverse_queue.emplace(0.0f, target);
+  reverse_costs[target] = 0.0f;
+
+  float best = kInfiniteCost;
+  while (!forward_queue.empty() || !reverse_queue.empty()) {
+    // alternate directions, settling the cheaper frontier first
+    bool use_forward = !forward_queue.empty() &&
+                       (reverse_queue.empty() || forward_queue.top() <= reverse_queue.top());
+    auto& queue = use_forward ? forward_queue : reverse_queue;
+    auto& costs = use_forward ? forward_costs : reverse_costs;
+    auto& other_costs = use_forward ? reverse_costs : forward_costs;
+    const auto& edges = use_forward ? forward_ : reverse_;
+
+    auto top = queue.top();
+    queue.pop();
+    if (top.first > costs[top.second]) {
+      continue; // stale entry
+    }
+    if (top.first >= best) {
+      // nothing cheaper can be settled in this direction
+      if (use_forward) {
+        forward_queue = min_heap_t();
+      } else {
+        reverse_queue = min_heap_t();
+      }
+      continue;
+    }
+    auto met = other_costs.find(top.second);
+    if (met != other_costs.end()) {
+      best = std::min(best, top.first + met->second);
+    }
+    for (const auto& edge : edges[top.second]) {
+      // upward only
+      if (order_[edge.target] < order_[top.second]) {
+        continue;
+      }
+      float cost = top.first + edge.weight;
+      auto inserted = costs.emplace(edge.target, cost);
+      if (inserted.second || cost < inserted.first->second) {
+        inserted.first->second = cost;
+        queue.emplace(cost, edge.target);
+      }
+    }
+  }
+  return best;
+}
+
+// Recursively unpack a hierarchy edge into original graph nodes. Appends
+// everything after source up to and including target.
+void ContractionHierarchy::Unpack(const uint32_t source,
+                                  const uint32_t target,
+                                  const uint32_t via,
+                                  std::vector<uint32_t>& path) const {
+  if (via == kInvalidNode) {
+    path.push_back(target);
+    return;
+  }
+  // find the cheapest constituent halves of the shortcut
+  auto find_half = [this](const uint32_t from, const uint32_t to) -> const edge_t* {
+    const edge_t* found = nullptr;
+    for (const auto& edge : forward_[from]) {
+      if (edge.target == to && (found == nullptr || edge.weight < found->weight)) {
+        found = &edge;
+      }
+    }
+    return found;
+  };
+  const edge_t* first = find_half(source, via);
+  const edge_t* second = find_half(via, target);
+  Unpack(source, via, first ? first->via : kInvalidNode, path);
+  Unpack(via, target, second ? second->via : kInvalidNode, path);
+}
+
+std::vector<uint32_t> ContractionHierarchy::Path(const uint32_t source,
+                                                 const uint32_t target) const {
+  if (!built_) {
+    throw std::logic_error("ContractionHierarchy must be built before querying");
+  }
+  // same search as Cost but with parent pointers so the up-down path over
+  // the hierarchy can be rebuilt, then shortcut edges get unpacked
+  struct label_t {
+    float cost;
+    uint32_t pred;
+    uint32_t via; // shortcut middle node of the edge from pred
+  };
+  std::unordered_map<uint32_t, label_t> forward_labels, reverse_labels;
+  min_heap_t forward_queue, reverse_queue;
+  forward_queue.emplace(0.0f, source);
+  forward_labels[source] = {0.0f, kInvalidNode, kInvalidNode};
+  reverse_queue.emplace(0.0f, target);
+  reverse_labels[target] = {0.0f, kInvalidNode, kInvalidNode};
+
+  float best = kInfiniteCost;
+  uint32_t meeting = kInvalidNode;
+  while (!forward_queue.empty() || !reverse_queue.empty()) {
+    bool use_forward = !forward_queue.empty() &&
+                       (reverse_queue.empty() || forward_queue.top() <= reverse_queue.top());
+    auto& queue = use_forward ? forward_queue : reverse_queue;
+    auto& labels = use_forward ? forward_labels : reverse_labels;
+    auto& other_labels = use_forward ? reverse_labels : forward_labels;
+    const auto& edges = use_forward ? forward_ : reverse_;
+
+    auto top = queue.top();
+    queue.pop();
+    if (top.first > labels[top.second].cost) {
+      continue;
+    }
+    if (top.first >= best) {
+      if (use_forward) {
+        forward_queue = min_heap_t();
+      } else {
+        reverse_queue = min_heap_t();
+      }
+      continue;
+    }
+    auto met = other_labels.find(top.second);
+    if (met != other_labels.end() && top.first + met->second.cost < best) {
+      best = top.first + met->second.cost;
+      meeting = top.second;
+    }
+    for (const auto& edge : edges[top.second]) {
+      if (order_[edge.target] < order_[top.second]) {
+        continue;
+      }
+      float cost = top.first + edge.weight;
+      auto inserted = labels.emplace(edge.target, label_t{cost, top.second, edge.via});
+      if (inserted.second || cost < inserted.first->second.cost) {
+        inserted.first->second = {cost, top.second, edge.via};
+        queue.emplace(cost, edge.target);
+      }
+    }
+  }
+
+  std::vector<uint32_t> path;
+  if (meeting == kInvalidNode) {
+    return path;
+  }
+
+  // walk the forward tree back to the source, then unpack towards the meeting
+  std::vector<std::pair<uint32_t, uint32_t>> forward_hops; // (node, via from pred)
+  for (uint32_t node = meeting; node != kInvalidNode;) {
+    const auto& label = forward_labels[node];
+    forward_hops.emplace_back(node, label.via);
+    node = label.pred;
+  }
+  std::reverse(forward_hops.begin(), forward_hops.end());
+  path.push_back(forward_hops.front().first);
+  for (size_t i = 1; i < forward_hops.size(); ++i) {
+    Unpack(forward_hops[i - 1].first, forward_hops[i].first, forward_hops[i].second, path);
+  }
+
+  // then walk the reverse tree from the meeting down to the target
+  for (uint32_t node = meeting; node != kInvalidNode;) {
+    const auto& label = reverse_labels[node];
+    if (label.pred == kInvalidNode) {
+      break;
+    }
+    // reverse edges run target->source, unpack them in forward orientation
+    Unpack(node, label.pred, label.via, path);
+    node = label.pred;
+  }
+  return path;
+}
+
+} // namespace thor
+} // namespace valhalla
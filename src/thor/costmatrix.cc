@@ -1,9 +1,13 @@
 #include <algorithm>
+#include <atomic>
 #include <cmath>
+#include <exception>
+#include <thread>
 #include <vector>
 
 #include "midgard/logging.h"
 #include "thor/costmatrix.h"
+#include "thor/pathalgorithm.h"
 #include "worker.h"
 
 using namespace valhalla::baldr;
@@ -30,9 +34,10 @@ namespace valhalla {
 namespace thor {
 
 // Constructor with cost threshold.
-CostMatrix::CostMatrix()
-    : mode_(TravelMode::kDrive), access_mode_(kAutoAccess), source_count_(0), remaining_sources_(0),
-      target_count_(0), remaining_targets_(0), current_cost_threshold_(0) {
+CostMatrix::CostMatrix(const uint32_t concurrency)
+    : interrupt_(nullptr), memory_budget_(0), nthreads_(std::max(concurrency, 1u)),
+      mode_(TravelMode::kDrive), access_mode_(kAutoAccess), source_count_(0),
+      remaining_sources_(0), target_count_(0), remaining_targets_(0), current_cost_threshold_(0) {
 }
 
 float CostMatrix::GetCostThreshold(const float max_matrix_distance) {
@@ -97,6 +102,41 @@ void CostMatrix::Clear() {
   target_hierarchy_limits_.clear();
   source_status_.clear();
   target_status_.clear();
+  source_remap_.clear();
+  target_remap_.clear();
+}
+
+// Collapse locations that correlated to the identical set of graph edges
+// into one representative each. The key covers exactly what SetSources,
+// SetTargets and Initialize consume, so locations that collapse together
+// are guaranteed the same search tree and the same best connections.
+google::protobuf::RepeatedPtrField<odin::Location>
+CostMatrix::DedupLocations(const google::protobuf::RepeatedPtrField<odin::Location>& locations,
+                           std::vector<uint32_t>& remap) {
+  remap.clear();
+  remap.reserve(locations.size());
+  std::unordered_map<std::string, uint32_t> unique_indices;
+  google::protobuf::RepeatedPtrField<odin::Location> unique;
+  for (const auto& location : locations) {
+    std::string key;
+    key.reserve(sizeof(double) * 2 + location.path_edges_size() * 17);
+    double ll[2] = {location.ll().lng(), location.ll().lat()};
+    key.append(reinterpret_cast<const char*>(ll), sizeof(ll));
+    for (const auto& edge : location.path_edges()) {
+      uint64_t id = edge.graph_id();
+      float along[2] = {edge.percent_along(), edge.distance()};
+      char at_node = edge.end_node();
+      key.append(reinterpret_cast<const char*>(&id), sizeof(id));
+      key.append(reinterpret_cast<const char*>(along), sizeof(along));
+      key.append(&at_node, sizeof(at_node));
+    }
+    auto inserted = unique_indices.emplace(std::move(key), unique.size());
+    if (inserted.second) {
+      *unique.Add() = location;
+    }
+    remap.push_back(inserted.first->second);
+  }
+  return unique;
 }
 
 // Form a time distance matrix from the set of source locations
@@ -115,48 +155,62 @@ std::vector<TimeDistance> CostMatrix::SourceToTarget(
 
   current_cost_threshold_ = GetCostThreshold(max_matrix_distance);
 
-  // Set the source and target locations
+  // Set the source and target locations. Sources or targets that correlated
+  // to the identical set of edges (vehicles parked at one depot) would grow
+  // identical search trees, so run each unique one once and fan the result
+  // rows and columns back out when the matrix is formed below.
   Clear();
-  SetSources(graphreader, source_location_list);
-  SetTargets(graphreader, target_location_list);
+  auto unique_sources = DedupLocations(source_location_list, source_remap_);
+  auto unique_targets = DedupLocations(target_location_list, target_remap_);
+  SetSources(graphreader, unique_sources);
+  SetTargets(graphreader, unique_targets);
 
   // Initialize best connections and status. Any locations that are the
   // same get set to 0 time, distance and are not added to the remaining
   // location set.
-  Initialize(source_location_list, target_location_list);
+  Initialize(unique_sources, unique_targets);
 
   // Perform backward search from all target locations. Perform forward
   // search from all source locations. Connections between the 2 search
   // spaces is checked during the forward search.
   int n = 0;
+  size_t pops = 0;
   while (true) {
-    // Iterate all target locations in a backwards search
-    for (uint32_t i = 0; i < target_count_; i++) {
-      if (target_status_[i].threshold > 0) {
-        target_status_[i].threshold--;
-        BackwardSearch(i, graphreader);
-        if (target_status_[i].threshold == 0) {
-          target_status_[i].threshold = -1;
-          if (remaining_targets_ > 0) {
-            remaining_targets_--;
-          }
+    // Periodically check for the abort condition and the memory budget,
+    // amortized over the pops every active location search did since the
+    // last check
+    pops += remaining_sources_ + remaining_targets_;
+    if (pops >= kInterruptIterationsInterval) {
+      pops = 0;
+      if (interrupt_) {
+        (*interrupt_)();
+      }
+      // Total up what the search trees hold against the budget - stopping
+      // with the connections found so far beats the process being killed
+      if (memory_budget_ != 0) {
+        uint64_t labels = 0;
+        for (const auto& el : source_edgelabel_) {
+          labels += el.size();
+        }
+        for (const auto& el : target_edgelabel_) {
+          labels += el.size();
+        }
+        if (labels * sizeof(sif::BDEdgeLabel) > memory_budget_) {
+          LOG_WARN("CostMatrix exhausted its memory budget, returning partial results");
+          break;
         }
       }
     }
 
+    // Iterate all target locations in a backwards search. The backward and
+    // forward phases are kept separate so each phase only reads the trees
+    // the other phase grew in the prior phase.
+    RunPhase(target_status_, target_count_, remaining_targets_,
+             [this, &graphreader](const uint32_t i) { BackwardSearch(i, graphreader); });
+
     // Iterate all source locations in a forward search
-    for (uint32_t i = 0; i < source_count_; i++) {
-      if (source_status_[i].threshold > 0) {
-        source_status_[i].threshold--;
-        ForwardSearch(i, n, graphreader);
-        if (source_status_[i].threshold == 0) {
-          source_status_[i].threshold = -1;
-          if (remaining_sources_ > 0) {
-            remaining_sources_--;
-          }
-        }
-      }
-    }
+    RunPhase(source_status_, source_count_, remaining_sources_,
+             [this, n, &graphreader](const uint32_t i) { ForwardSearch(i, n, graphreader); });
 
     // Break out when remaining sources and targets to expand are both 0
     if (remaining_sources_ == 0 && remaining_targets_ == 0) {
@@ -172,16 +226,169 @@ std::vector<TimeDistance> CostMatrix::SourceToTarget(
     n++;
   }
 
-  // Form the time, distance matrix from the destinations list
-  uint32_t idx = 0;
+  // Form the time, distance matrix from the best connections, fanning the
+  // unique rows and columns back out to any collapsed duplicate locations
   std::vector<TimeDistance> td;
-  for (const auto& connection : best_connection_) {
-    td.emplace_back(std::round(connection.cost.secs), std::round(connection.distance));
-    idx++;
+  td.reserve(static_cast<size_t>(source_location_list.size()) * target_location_list.size());
+  for (int source = 0; source < source_location_list.size(); ++source) {
+    for (int target = 0; target < target_location_list.size(); ++target) {
+      const auto& connection =
+          best_connection_[source_remap_[source] * target_count_ + target_remap_[target]];
+      td.emplace_back(std::round(connection.cost.secs), std::round(connection.distance));
+    }
   }
   return td;
 }
 
+// Form the path for a source-target pair by replaying the predecessor links
+// the matrix search recorded. Follows the same recovery as the bidirectional
+// path algorithm - walk the forward tree back from the connection edge, then
+// append the opposing edges of the reverse tree.
+std::vector<PathInfo>
+CostMatrix::FormPath(uint32_t source, uint32_t target, GraphReader& graphreader) const {
+  // Callers pass original location indexes; map them to the unique
+  // representatives the matrix was actually run with
+  source = source_remap_[source];
+  target = target_remap_[target];
+
+  // Bail if the matrix never connected this pair
+  const auto& connection = best_connection_[source * target_count_ + target];
+  if (connection.cost.secs >= kMaxCost) {
+    return {};
+  }
+
+  // Get the indexes where the connection occurs
+  const auto forward_status = source_edgestatus_[source].Get(connection.edgeid);
+  const auto reverse_status = target_edgestatus_[target].Get(connection.opp_edgeid);
+  if (forward_status.set() == EdgeSet::kUnreached || reverse_status.set() == EdgeSet::kUnreached) {
+    return {};
+  }
+  const auto& forward_labels = source_edgelabel_[source];
+  const auto& reverse_labels = target_edgelabel_[target];
+
+  // Work backwards on the forward path
+  std::vector<PathInfo> path;
+  for (auto edgelabel_index = forward_status.index(); edgelabel_index != kInvalidLabel;
+       edgelabel_index = forward_labels[edgelabel_index].predecessor()) {
+    const BDEdgeLabel& edgelabel = forward_labels[edgelabel_index];
+    path.emplace_back(edgelabel.mode(), edgelabel.cost().secs, edgelabel.edgeid(), 0);
+  }
+
+  // Reverse the list
+  std::reverse(path.begin(), path.end());
+
+  // Special case code if the last edge of the forward path is
+  // the destination edge - update the elapsed time
+  const BDEdgeLabel& opp_label = reverse_labels[reverse_status.index()];
+  if (opp_label.predecessor() == kInvalidLabel) {
+    if (path.size() > 1) {
+      path.back().elapsed_time = path[path.size() - 2].elapsed_time + opp_label.cost().secs;
+    } else {
+      path.back().elapsed_time = opp_label.cost().secs;
+    }
+    return path;
+  }
+
+  // Get the elapsed time at the end of the forward path. NOTE: PathInfo
+  // stores elapsed time as uint32_t but EdgeLabels uses float. Need to
+  // accumulate in float and cast to int so we do not accumulate roundoff
+  // error.
+  float secs = path.back().elapsed_time;
+
+  // Get the transition cost at the last edge of the reverse path
+  float tc = opp_label.transition_secs();
+
+  // Append the reverse path from the destination - use opposing edges
+  // The first edge on the reverse path is the same as the last on the forward
+  // path, so get the predecessor.
+  uint32_t edgelabel_index = opp_label.predecessor();
+  while (edgelabel_index != kInvalidLabel) {
+    const BDEdgeLabel& edgelabel = reverse_labels[edgelabel_index];
+    GraphId oppedge = graphreader.GetOpposingEdgeId(edgelabel.edgeid());
+
+    // Get elapsed time on the edge, then add the transition cost at
+    // prior edge.
+    uint32_t predidx = edgelabel.predecessor();
+    if (predidx == kInvalidLabel) {
+      secs += edgelabel.cost().secs;
+    } else {
+      secs += edgelabel.cost().secs - reverse_labels[predidx].cost().secs;
+    }
+    secs += tc;
+    path.emplace_back(edgelabel.mode(), secs, oppedge, 0);
+
+    // Update edgelabel_index and transition cost to apply at next iteration
+    edgelabel_index = predidx;
+    tc = edgelabel.transition_secs();
+  }
+  return path;
+}
+
+// Run one search iteration for every location that can still be expanded,
+// spreading the searches across the worker threads.
+void CostMatrix::RunPhase(std::vector<LocationStatus>& status,
+                          const uint32_t count,
+                          uint32_t& remaining,
+                          const std::function<void(const uint32_t)>& search) {
+  // Decrement thresholds on the calling thread and collect the locations
+  // that can still be expanded
+  std::vector<uint32_t> eligible;
+  for (uint32_t i = 0; i < count; i++) {
+    if (status[i].threshold > 0) {
+      status[i].threshold--;
+      eligible.push_back(i);
+    }
+  }
+
+  // Run the search iterations. Each location owns its edge labels,
+  // adjacency list, and edge status so the searches only contend on the
+  // shared status and target edge bookkeeping, which is locked.
+  if (nthreads_ > 1 && eligible.size() > 1) {
+    std::atomic<size_t> next(0);
+    size_t thread_count = std::min<size_t>(nthreads_, eligible.size());
+    std::vector<std::thread> threads;
+    threads.reserve(thread_count);
+    // a throw escaping a thread entry function terminates the process, so
+    // each thread parks its exception and the calling thread rethrows the
+    // first one after the joins
+    std::vector<std::exception_ptr> failures(thread_count);
+    for (size_t t = 0; t < thread_count; t++) {
+      threads.emplace_back(
+          [&next, &eligible, &search](std::exception_ptr& failure) {
+            try {
+              size_t i;
+              while ((i = next.fetch_add(1)) < eligible.size()) {
+                search(eligible[i]);
+              }
+            } catch (...) { failure = std::current_exception(); }
+          },
+          std::ref(failures[t]));
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    for (const auto& failure : failures) {
+      if (failure) {
+        std::rethrow_exception(failure);
+      }
+    }
+  } else {
+    for (const auto i : eligible) {
+      search(i);
+    }
+  }
+
+  // Retire locations whose search was exhausted or hit its threshold
+  for (const auto i : eligible) {
+    if (status[i].threshold == 0) {
+      status[i].threshold = -1;
+      if (remaining > 0) {
+        remaining--;
+      }
+    }
+  }
+}
+
 // Initialize all time distance to "not found". Any locations that
 // are the same get set to 0 time, distance and do not add to the
 // remaining locations set.
@@ -243,6 +450,7 @@ void CostMatrix::ForwardSearch(const uint32_t index, const uint32_t n, GraphRead
     for (uint32_t target = 0; target < target_count_; target++) {
       UpdateStatus(index, target);
     }
+    std::lock_guard<std::mutex> lock(status_lock_);
     source_status_[index].threshold = 0;
     return;
   }
@@ -250,6 +458,7 @@ void CostMatrix::ForwardSearch(const uint32_t index, const uint32_t n, GraphRead
   // Get edge label and check cost threshold
   BDEdgeLabel pred = edgelabels[pred_idx];
   if (pred.cost().secs > current_cost_threshold_) {
+    std::lock_guard<std::mutex> lock(status_lock_);
     source_status_[index].threshold = 0;
     return;
   }
@@ -284,8 +493,41 @@ void CostMatrix::ForwardSearch(const uint32_t index, const uint32_t n, GraphRead
     uint32_t shortcuts = 0;
     GraphId edgeid = {node.tileid(), node.level(), nodeinfo->edge_index()};
     EdgeStatusInfo* es = edgestate.GetPtr(edgeid, tile);
-    const DirectedEdge* directededge = tile->directededge(nodeinfo->edge_index());
+    const DirectedEdge* directededge = tile->GetDirectedEdges(nodeinfo).begin();
+
+    // Batch the edge costs for all edges leaving the node. They do not
+    // depend on the predecessor so they can be priced together up front,
+    // letting the costing run its factor math over the contiguous edges.
+    // When the tile carries the directed edge SoA mirror its packed
+    // attribute words prefilter settled and mode inaccessible edges first,
+    // so their full records are never pulled into cache or priced
+    const DirectedEdge* edges[kMaxEdgesPerNode];
+    uint32_t speeds[kMaxEdgesPerNode];
+    Cost edge_costs[kMaxEdgesPerNode];
+    uint32_t cost_idx[kMaxEdgesPerNode];
+    const uint32_t* soa_attributes =
+        tile->has_edge_soa() ? tile->edge_soa().attributes + nodeinfo->edge_index() : nullptr;
+    uint32_t priced = 0;
+    for (uint32_t i = 0; i < nodeinfo->edge_count(); i++) {
+      if (soa_attributes != nullptr && !EdgeSoA::is_shortcut(soa_attributes[i]) &&
+          ((es + i)->set() == EdgeSet::kPermanent ||
+           !(EdgeSoA::forwardaccess(soa_attributes[i]) & access_mode_))) {
+        cost_idx[i] = kMaxEdgesPerNode;
+        continue;
+      }
+      cost_idx[i] = priced;
+      edges[priced] = directededge + i;
+      speeds[priced] = tile->GetSpeed(directededge + i);
+      priced++;
+    }
+    costing_->EdgeCosts(edges, speeds, priced, edge_costs);
+
     for (uint32_t i = 0; i < nodeinfo->edge_count(); i++, directededge++, ++edgeid, ++es) {
+      // Skip edges the SoA prefilter pruned without touching the record
+      if (cost_idx[i] == kMaxEdgesPerNode) {
+        continue;
+      }
+
       // Skip shortcut edges until we have stopped expanding on the next level. Use regular
       // edges while still expanding on the next level since we can still transition down to
       // that level. If using a shortcut, set the shortcuts mask. Skip if this is a regular
@@ -315,8 +557,7 @@ void CostMatrix::ForwardSearch(const uint32_t index, const uint32_t n, GraphRead
 
       // Get cost. Separate out transition cost.
       Cost tc = costing_->TransitionCost(directededge, nodeinfo, pred);
-      Cost newcost =
-          pred.cost() + tc + costing_->EdgeCost(directededge, tile->GetSpeed(directededge));
+      Cost newcost = pred.cost() + tc + edge_costs[cost_idx[i]];
 
       // Check if edge is temporarily labeled and this path has less cost. If
       // less cost the predecessor is updated along with new cost and distance.
@@ -348,17 +589,16 @@ void CostMatrix::ForwardSearch(const uint32_t index, const uint32_t n, GraphRead
     }
 
     // Handle transitions - expand from the end node of the transition
-    if (!from_transition && nodeinfo->transition_count() > 0) {
-      const NodeTransition* trans = tile->transition(nodeinfo->transition_index());
-      for (uint32_t i = 0; i < nodeinfo->transition_count(); ++i, ++trans) {
-        if (trans->up()) {
+    if (!from_transition) {
+      for (const auto& trans : tile->GetNodeTransitions(nodeinfo)) {
+        if (trans.up()) {
           hierarchy_limits[node.level()].up_transition_count++;
-        } else if (hierarchy_limits[trans->endnode().level()].StopExpanding()) {
+        } else if (hierarchy_limits[trans.endnode().level()].StopExpanding()) {
           continue;
         }
 
         // Expand from end node of this transition.
-        GraphId node = trans->endnode();
+        GraphId node = trans.endnode();
         const GraphTile* endtile = graphreader.GetGraphTile(node);
         if (endtile != nullptr) {
           expand(endtile, node, endtile->node(node), pred, pred_idx, true);
@@ -467,6 +707,10 @@ void CostMatrix::CheckForwardConnections(const uint32_t source,
 
 // Update status when a connection is found.
 void CostMatrix::UpdateStatus(const uint32_t source, const uint32_t target) {
+  // The remaining location sets and thresholds are shared between the
+  // searches running within a phase
+  std::lock_guard<std::mutex> lock(status_lock_);
+
   // Remove the target from the source status
   auto& s = source_status_[source].remaining_locations;
   auto it = s.find(target);
@@ -506,6 +750,7 @@ void CostMatrix::BackwardSearch(const uint32_t index, GraphReader& graphreader)
     for (uint32_t source = 0; source < source_count_; source++) {
       UpdateStatus(source, index);
     }
+    std::lock_guard<std::mutex> lock(status_lock_);
     target_status_[index].threshold = 0;
     return;
   }
@@ -513,6 +758,7 @@ void CostMatrix::BackwardSearch(const uint32_t index, GraphReader& graphreader)
   // Copy predecessor, check cost threshold
   BDEdgeLabel pred = edgelabels[pred_idx];
   if (pred.cost().secs > current_cost_threshold_) {
+    std::lock_guard<std::mutex> lock(status_lock_);
     target_status_[index].threshold = 0;
     return;
   }
@@ -545,8 +791,20 @@ void CostMatrix::BackwardSearch(const uint32_t index, GraphReader& graphreader)
     uint32_t shortcuts = 0;
     GraphId edgeid(node.tileid(), node.level(), nodeinfo->edge_index());
     EdgeStatusInfo* es = edgestate.GetPtr(edgeid, tile);
-    const DirectedEdge* directededge = tile->directededge(nodeinfo->edge_index());
-    for (uint32_t i = 0; i < nodeinfo->edge_count(); i++, directededge++, ++edgeid, ++es) {
+    auto edges = tile->GetDirectedEdges(nodeinfo);
+    // The SoA mirror (when the tile carries it) prunes settled and mode
+    // inaccessible edges without pulling their full records into cache
+    const uint32_t* soa_attributes =
+        tile->has_edge_soa() ? tile->edge_soa().attributes + nodeinfo->edge_index() : nullptr;
+    uint32_t idx = 0;
+    for (const DirectedEdge* directededge = edges.begin(); directededge != edges.end();
+         ++directededge, ++edgeid, ++es, ++idx) {
+      if (soa_attributes != nullptr && !EdgeSoA::is_shortcut(soa_attributes[idx]) &&
+          (es->set() == EdgeSet::kPermanent ||
+           !(EdgeSoA::reverseaccess(soa_attributes[idx]) & access_mode_))) {
+        continue;
+      }
+
       // Skip shortcut edges until we have stopped expanding on the next level. Use regular
       // edges while still expanding on the next level since we can still transition down to
       // that level. If using a shortcut, set the shortcuts mask. Skip if this is a regular
@@ -610,27 +868,30 @@ void CostMatrix::BackwardSearch(const uint32_t index, GraphReader& graphreader)
                               (pred.not_thru_pruning() || !directededge->not_thru()));
       adj->add(idx);
 
-      // Add to the list of targets that have reached this edge
-      targets_[edgeid].push_back(index);
+      // Add to the list of targets that have reached this edge. The map is
+      // shared between the backward searches; the forward phase reads it
+      // only after the backward phase has finished.
+      {
+        std::lock_guard<std::mutex> lock(targets_lock_);
+        targets_[edgeid].push_back(index);
+      }
     }
 
     // Handle transitions - expand from the end node of the transition
-    if (!from_transition && nodeinfo->transition_count() > 0) {
-      const NodeTransition* trans = tile->transition(nodeinfo->transition_index());
-      for (uint32_t i = 0; i < nodeinfo->transition_count(); ++i, ++trans) {
-        if (trans->up()) {
+    if (!from_transition) {
+      for (const auto& trans : tile->GetNodeTransitions(nodeinfo)) {
+        if (trans.up()) {
           hierarchy_limits[node.level()].up_transition_count++;
-        } else if (hierarchy_limits[trans->endnode().level()].StopExpanding()) {
+        } else if (hierarchy_limits[trans.endnode().level()].StopExpanding()) {
           continue;
         }
 
         // Expand from end node of this transition edge.
-        GraphId node = trans->endnode();
+        GraphId node = trans.endnode();
         const GraphTile* endtile = graphreader.GetGraphTile(node);
         if (endtile != nullptr) {
           expand(endtile, node, endtile->node(node), index, pred, pred_idx, opp_pred_edge, true);
         }
-        continue;
       }
     }
   };
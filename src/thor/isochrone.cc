@@ -1,8 +1,10 @@
 #include "thor/isochrone.h"
 #include "baldr/datetime.h"
+#include "thor/pathalgorithm.h"
 #include "midgard/distanceapproximator.h"
 #include "midgard/logging.h"
 #include <algorithm>
+#include <cmath>
 #include <iostream> // TODO remove if not needed
 #include <map>
 
@@ -35,18 +37,35 @@ uint32_t GetOperatorId(const GraphTile* tile,
   return 0;
 }
 
+// Pull the settled edges out of one expansion label set. Edges still in the
+// adjacency list are skipped since they may not have their lowest cost yet.
+template <typename labels_t>
+void HarvestExpansionEdges(const valhalla::thor::EdgeStatus& edgestatus,
+                           const labels_t& edgelabels,
+                           std::vector<valhalla::thor::ExpansionEdge>& edges) {
+  edges.reserve(edgelabels.size());
+  for (const auto& edgelabel : edgelabels) {
+    if (edgestatus.Get(edgelabel.edgeid()).set() == valhalla::thor::EdgeSet::kPermanent) {
+      edges.emplace_back(edgelabel.edgeid(),
+                         static_cast<uint32_t>(std::round(edgelabel.cost().secs)),
+                         edgelabel.path_distance());
+    }
+  }
+}
+
 } // namespace
 
 namespace valhalla {
 namespace thor {
 
-constexpr uint32_t kBucketCount = 20000;
+// kBucketCount and kInterruptIterationsInterval come from pathalgorithm.h
 constexpr uint32_t kInitialEdgeLabelCount = 500000;
 
 // Default constructor
 Isochrone::Isochrone()
-    : has_date_time_(false), start_tz_index_(0), access_mode_(kAutoAccess), shape_interval_(50.0f),
-      mode_(TravelMode::kDrive), adjacencylist_(nullptr) {
+    : interrupt_(nullptr), memory_budget_(0), has_date_time_(false), start_tz_index_(0),
+      access_mode_(kAutoAccess), shape_interval_(50.0f), mode_(TravelMode::kDrive),
+      adjacencylist_(nullptr) {
 }
 
 // Destructor
@@ -58,13 +77,31 @@ Isochrone::~Isochrone() {
 void Isochrone::Clear() {
   // Clear the edge labels, edge status flags, and adjacency list
   // TODO - clear only the edge label set that was used?
-  edgelabels_.clear();
-  bdedgelabels_.clear();
-  mmedgelabels_.clear();
-  adjacencylist_.reset();
+  sif::ClearLabels(edgelabels_);
+  sif::ClearLabels(bdedgelabels_);
+  sif::ClearLabels(mmedgelabels_);
+  // Empty the adjacency list but keep its bucket storage for the next
+  // request
+  if (adjacencylist_) {
+    adjacencylist_->clear();
+  }
   edgestatus_.clear();
 }
 
+// Export the per-edge cost surface of the last expansion. Whichever label
+// set the last Compute* call used holds the expansion tree.
+std::vector<ExpansionEdge> Isochrone::GetExpansionEdges() const {
+  std::vector<ExpansionEdge> edges;
+  if (!edgelabels_.empty()) {
+    HarvestExpansionEdges(edgestatus_, edgelabels_, edges);
+  } else if (!bdedgelabels_.empty()) {
+    HarvestExpansionEdges(edgestatus_, bdedgelabels_, edges);
+  } else if (!mmedgelabels_.empty()) {
+    HarvestExpansionEdges(edgestatus_, mmedgelabels_, edges);
+  }
+  return edges;
+}
+
 // Construct the isotile. Use a fixed grid size. Convert time in minutes to
 // a max distance in meters based on an estimate of max average speed for
 // the travel mode.
@@ -124,6 +161,26 @@ void Isochrone::ConstructIsoTile(
     grid_size = static_cast<float>(r) * 0.001f;
   }
 
+  // When a request memory budget is set, coarsen the grid until its full
+  // allocation fits within a quarter of it (the expansion's edge labels and
+  // edge status need the rest). A coarser isochrone beats the process being
+  // killed mid request
+  if (memory_budget_ != 0) {
+    auto grid_bytes = [&](const float size) {
+      return static_cast<uint64_t>((loc_bounds.Width() + 2.0f * dlon) / size) *
+             static_cast<uint64_t>((loc_bounds.Height() + 2.0f * dlat) / size) * sizeof(float);
+    };
+    float coarsened = grid_size;
+    while (grid_bytes(coarsened) > memory_budget_ / 4 && coarsened < 1.0f) {
+      coarsened *= 2.0f;
+    }
+    if (coarsened != grid_size) {
+      LOG_WARN("Isochrone grid coarsened from " + std::to_string(grid_size) + " to " +
+               std::to_string(coarsened) + " degrees to fit the memory budget");
+      grid_size = coarsened;
+    }
+  }
+
   // Set the shape interval in meters
   shape_interval_ = grid_size * kMetersPerDegreeLat * 0.25f;
 
@@ -159,7 +216,11 @@ void Isochrone::Initialize(const uint32_t bucketsize) {
   const auto edgecost = [this](const uint32_t label) { return edgelabels_[label].sortcost(); };
 
   float range = kBucketCount * bucketsize;
-  adjacencylist_.reset(new DoubleBucketQueue(0.0f, range, bucketsize, edgecost));
+  if (adjacencylist_) {
+    adjacencylist_->reuse(0.0f, range, bucketsize, edgecost);
+  } else {
+    adjacencylist_.reset(new DoubleBucketQueue(0.0f, range, bucketsize, edgecost));
+  }
   edgestatus_.clear();
 }
 
@@ -172,7 +233,11 @@ void Isochrone::InitializeReverse(const uint32_t bucketsize) {
   const auto edgecost = [this](const uint32_t label) { return bdedgelabels_[label].sortcost(); };
 
   float range = kBucketCount * bucketsize;
-  adjacencylist_.reset(new DoubleBucketQueue(0.0f, range, bucketsize, edgecost));
+  if (adjacencylist_) {
+    adjacencylist_->reuse(0.0f, range, bucketsize, edgecost);
+  } else {
+    adjacencylist_.reset(new DoubleBucketQueue(0.0f, range, bucketsize, edgecost));
+  }
   edgestatus_.clear();
 }
 
@@ -185,7 +250,11 @@ void Isochrone::InitializeMultiModal(const uint32_t bucketsize) {
   const auto edgecost = [this](const uint32_t label) { return mmedgelabels_[label].sortcost(); };
 
   float range = kBucketCount * bucketsize;
-  adjacencylist_.reset(new DoubleBucketQueue(0.0f, range, bucketsize, edgecost));
+  if (adjacencylist_) {
+    adjacencylist_->reuse(0.0f, range, bucketsize, edgecost);
+  } else {
+    adjacencylist_.reset(new DoubleBucketQueue(0.0f, range, bucketsize, edgecost));
+  }
   edgestatus_.clear();
 }
 
@@ -219,8 +288,8 @@ void Isochrone::ExpandForward(GraphReader& graphreader,
   if (nodeinfo->timezone() != start_tz_index_) {
     // Get the difference in seconds between the origin tz and current tz
     int tz_diff =
-        DateTime::timezone_diff(localtime, DateTime::get_tz_db().from_index(start_tz_index_),
-                                DateTime::get_tz_db().from_index(nodeinfo->timezone()));
+        tz_diff_cache_.diff(localtime, DateTime::get_tz_db().from_index(start_tz_index_),
+                            DateTime::get_tz_db().from_index(nodeinfo->timezone()));
     localtime += tz_diff;
     seconds_of_week = DateTime::normalize_seconds_of_week(seconds_of_week + tz_diff);
   }
@@ -318,7 +387,9 @@ Isochrone::Compute(google::protobuf::RepeatedPtrField<valhalla::odin::Location>&
   uint64_t start_time = 0;
   const auto& origin = origin_locations.Get(0);
   if (origin.has_date_time() && edgelabels_.size() > 0) {
-    // Set the origin timezone to be the timezone at the end node
+    // Set the origin timezone to be the timezone at the end node. Clear any
+    // timezone differences cached by a prior request.
+    tz_diff_cache_.clear();
     start_tz_index_ =
         edgelabels_.size() == 0 ? 0 : GetTimezone(graphreader, edgelabels_[0].endnode());
     if (start_tz_index_ == 0) {
@@ -340,6 +411,17 @@ Isochrone::Compute(google::protobuf::RepeatedPtrField<valhalla::odin::Location>&
   // Compute the isotile
   uint32_t n = 0;
   while (true) {
+    // Periodically check whether we should abort; hand back the partial
+    // grid since the cells settled so far are exact
+    if (interrupt_ && (n % kInterruptIterationsInterval) == 0) {
+      try {
+        (*interrupt_)();
+      } catch (...) {
+        LOG_WARN("Isochrone expansion interrupted, returning partial grid");
+        return isotile_;
+      }
+    }
+
     // Get next element from adjacency list. Check that it is valid. An
     // invalid label indicates there are no edges that can be expanded.
     uint32_t predindex = adjacencylist_->pop();
@@ -402,8 +484,8 @@ void Isochrone::ExpandReverse(GraphReader& graphreader,
   if (nodeinfo->timezone() != start_tz_index_) {
     // Get the difference in seconds between the origin tz and current tz
     int tz_diff =
-        DateTime::timezone_diff(localtime, DateTime::get_tz_db().from_index(start_tz_index_),
-                                DateTime::get_tz_db().from_index(nodeinfo->timezone()));
+        tz_diff_cache_.diff(localtime, DateTime::get_tz_db().from_index(start_tz_index_),
+                            DateTime::get_tz_db().from_index(nodeinfo->timezone()));
     localtime += tz_diff;
     seconds_of_week = DateTime::normalize_seconds_of_week(seconds_of_week + tz_diff);
   }
@@ -514,7 +596,9 @@ std::shared_ptr<const GriddedData<PointLL>> Isochrone::ComputeReverse(
   uint64_t start_time = 0;
   const auto& dest = dest_locations.Get(0);
   if (dest.has_date_time() && bdedgelabels_.size() > 0) {
-    // Set the timezone to be the timezone at the end node
+    // Set the timezone to be the timezone at the end node. Clear any
+    // timezone differences cached by a prior request.
+    tz_diff_cache_.clear();
     start_tz_index_ =
         bdedgelabels_.size() == 0 ? 0 : GetTimezone(graphreader, bdedgelabels_[0].endnode());
     if (start_tz_index_ == 0) {
@@ -536,6 +620,17 @@ std::shared_ptr<const GriddedData<PointLL>> Isochrone::ComputeReverse(
   // Compute the isotile
   uint32_t n = 0;
   while (true) {
+    // Periodically check whether we should abort; hand back the partial
+    // grid since the cells settled so far are exact
+    if (interrupt_ && (n % kInterruptIterationsInterval) == 0) {
+      try {
+        (*interrupt_)();
+      } catch (...) {
+        LOG_WARN("Isochrone expansion interrupted, returning partial grid");
+        return isotile_;
+      }
+    }
+
     // Get next element from adjacency list. Check that it is valid. An
     // invalid label indicates there are no edges that can be expanded.
     uint32_t predindex = adjacencylist_->pop();
@@ -608,8 +703,8 @@ bool Isochrone::ExpandForwardMM(GraphReader& graphreader,
   uint32_t localtime = start_time_ + pred.cost().secs;
   if (nodeinfo->timezone() != start_tz_index_) {
     // Get the difference in seconds between the origin tz and current tz
-    localtime += DateTime::timezone_diff(localtime, DateTime::get_tz_db().from_index(start_tz_index_),
-                                         DateTime::get_tz_db().from_index(nodeinfo->timezone()));
+    localtime += tz_diff_cache_.diff(localtime, DateTime::get_tz_db().from_index(start_tz_index_),
+                                     DateTime::get_tz_db().from_index(nodeinfo->timezone()));
   }
 
   // Set a default transfer penalty at a stop (if not same trip Id and block Id)
@@ -697,10 +792,20 @@ bool Isochrone::ExpandForwardMM(GraphReader& graphreader,
         continue;
       }
 
+      // Collapse this tile's schedule validity onto the service day once per
+      // request so each departure candidate below costs a single bit test
+      auto vs = schedule_validity_.find(tile->id().tileid());
+      if (vs == schedule_validity_.end()) {
+        vs = schedule_validity_
+                 .emplace(tile->id().tileid(),
+                          tile->GetScheduleValidity(day_, dow_, date_before_tile_))
+                 .first;
+      }
+
       // Look up the next departure along this edge
       const TransitDeparture* departure =
-          tile->GetNextDeparture(directededge->lineid(), localtime, day_, dow_, date_before_tile_,
-                                 tc->wheelchair(), tc->bicycle());
+          tile->GetNextDeparture(directededge->lineid(), localtime, vs->second, tc->wheelchair(),
+                                 tc->bicycle());
       if (departure) {
         // Check if there has been a mode change
         mode_change = (mode_ == TravelMode::kPedestrian);
@@ -723,8 +828,8 @@ bool Isochrone::ExpandForwardMM(GraphReader& graphreader,
             // departure.
             // TODO - is there a better way?
             if (localtime + 30 > departure->departure_time()) {
-              departure = tile->GetNextDeparture(directededge->lineid(), localtime + 30, day_, dow_,
-                                                 date_before_tile_, tc->wheelchair(), tc->bicycle());
+              departure = tile->GetNextDeparture(directededge->lineid(), localtime + 30,
+                                                 vs->second, tc->wheelchair(), tc->bicycle());
               if (!departure) {
                 continue;
               }
@@ -887,7 +992,9 @@ std::shared_ptr<const GriddedData<PointLL>> Isochrone::ComputeMultiModal(
   date_set_ = false;
   date_before_tile_ = false;
   if (origin_locations.Get(0).has_date_time()) {
-    // Set the timezone to be the timezone at the end node
+    // Set the timezone to be the timezone at the end node. Clear any
+    // timezone differences cached by a prior request.
+    tz_diff_cache_.clear();
     start_tz_index_ =
         mmedgelabels_.size() == 0 ? 0 : GetTimezone(graphreader, mmedgelabels_[0].endnode());
     if (start_tz_index_ == 0) {
@@ -904,10 +1011,23 @@ std::shared_ptr<const GriddedData<PointLL>> Isochrone::ComputeMultiModal(
   // Clear operators and processed tiles
   operators_.clear();
   processed_tiles_.clear();
+  schedule_validity_.clear();
 
   // Expand using adjacency list until we exceed threshold
+  uint32_t n = 0;
   const GraphTile* tile;
   while (true) {
+    // Periodically check whether we should abort; hand back the partial
+    // grid since the cells settled so far are exact
+    if (interrupt_ && (n++ % kInterruptIterationsInterval) == 0) {
+      try {
+        (*interrupt_)();
+      } catch (...) {
+        LOG_WARN("Isochrone expansion interrupted, returning partial grid");
+        return isotile_;
+      }
+    }
+
     // Get next element from adjacency list. Check that it is valid. An
     // invalid label indicates there are no edges that can be expanded.
     uint32_t predindex = adjacencylist_->pop();
@@ -1001,12 +1121,14 @@ void Isochrone::UpdateIsoTile(const EdgeLabel& pred,
   float minutes = secs0 * kMinPerSec;
   float delta = ((secs1 - secs0) / (resampled.size() - 1)) * kMinPerSec;
   auto itr1 = resampled.begin();
+  auto tile1 = isotile_->TileId(*itr1);
   for (auto itr2 = itr1 + 1; itr2 < resampled.end(); itr1++, itr2++) {
     minutes += delta;
 
-    // Mark tiles that intersect the segment. Optimize this to avoid calling the Intersect
-    // method unless more than 2 tiles are crossed by the segment.
-    auto tile1 = isotile_->TileId(*itr1);
+    // Mark tiles that intersect the segment. The start of this segment is
+    // the end of the prior one so its tile Id is carried over. Optimize
+    // this to avoid calling the Intersect method unless more than 2 tiles
+    // are crossed by the segment.
     auto tile2 = isotile_->TileId(*itr2);
     if (tile1 == tile2) {
       isotile_->SetIfLessThan(tile1, minutes);
@@ -1022,6 +1144,7 @@ void Isochrone::UpdateIsoTile(const EdgeLabel& pred,
         isotile_->SetIfLessThan(t.first, minutes);
       }
     }
+    tile1 = tile2;
   }
 }
 
@@ -9,6 +9,10 @@ namespace valhalla {
 namespace thor {
 
 std::string thor_worker_t::isochrones(valhalla_request_t& request) {
+  return isochrones_deferred(request)(request);
+}
+
+thor_worker_t::deferred_json_t thor_worker_t::isochrones_deferred(valhalla_request_t& request) {
   parse_locations(request);
   auto costing = parse_costing(request);
 
@@ -25,23 +29,64 @@ std::string thor_worker_t::isochrones(valhalla_request_t& request) {
     request.options.set_generalize(kOptimalGeneralization);
   }
 
-  // get the raster
+  // Abort the expansion when the client goes away
+  isochrone_gen.set_interrupt(interrupt);
+
   // Extend the times in the 2-D grid to be 10 minutes beyond the highest contour time.
   // Cost (including penalties) is used when adding to the adjacency list but the elapsed
   // time in seconds is used when terminating the search. The + 10 minutes adds a buffer for edges
   // where there has been a higher cost that might still be marked in the isochrone
-  auto grid = (costing == "multimodal" || costing == "transit")
-                  ? isochrone_gen.ComputeMultiModal(*request.options.mutable_locations(),
-                                                    contours.back() + 10, *reader, mode_costing, mode)
-                  : isochrone_gen.Compute(*request.options.mutable_locations(), contours.back() + 10,
-                                          *reader, mode_costing, mode);
+  float max_seconds = contours.back() + 10;
+
+  // A contour time slider re-sends the same origin and costing with a
+  // different time. The grid from the last request is marked out to the time
+  // it was computed with, so when the key matches and the grid reaches far
+  // enough only the contour tracing below needs to run. The reverse flag
+  // changes what the grid means so it salts the key
+  bool cacheable = route_cacheable(request);
+  std::string cache_key;
+  std::shared_ptr<const GriddedData<PointLL>> grid;
+  if (cacheable) {
+    cache_key =
+        route_cache_key(request, costing + (request.options.reverse() ? "|reverse" : ""));
+    if (iso_grid && iso_grid_key == cache_key && iso_grid_seconds >= max_seconds) {
+      grid = iso_grid;
+    }
+  }
+
+  // get the raster
+  // All locations are seeded into a single expansion writing one grid, so
+  // multi-depot coverage is computed in one pass. The reverse option expands
+  // towards the locations (how long to reach them) rather than away from
+  // them; multimodal has no reverse equivalent.
+  if (!grid) {
+    grid = (costing == "multimodal" || costing == "transit")
+               ? isochrone_gen.ComputeMultiModal(*request.options.mutable_locations(), max_seconds,
+                                                 *reader, mode_costing, mode)
+               : request.options.reverse()
+                     ? isochrone_gen.ComputeReverse(*request.options.mutable_locations(),
+                                                    max_seconds, *reader, mode_costing, mode)
+                     : isochrone_gen.Compute(*request.options.mutable_locations(), max_seconds,
+                                             *reader, mode_costing, mode);
+    // retain it for the next slider value
+    if (cacheable) {
+      iso_grid_key = cache_key;
+      iso_grid_seconds = max_seconds;
+      iso_grid = grid;
+    }
+  }
 
-  // turn it into geojson
+  // trace the contour lines through the grid; the grid itself is not needed
+  // past this point so only the contours (and colors) ride along into the
+  // deferred geojson serialization
   auto isolines = grid->GenerateContours(contours, request.options.polygons(),
                                          request.options.denoise(), request.options.generalize());
 
-  return tyr::serializeIsochrones<PointLL>(request, isolines, request.options.polygons(), colors,
-                                           request.options.show_locations());
+  return [isolines = std::move(isolines),
+          colors = std::move(colors)](const valhalla_request_t& request) {
+    return tyr::serializeIsochrones<PointLL>(request, isolines, request.options.polygons(), colors,
+                                             request.options.show_locations());
+  };
 }
 
 } // namespace thor
@@ -24,6 +24,10 @@ namespace thor {
 constexpr uint32_t kCostMatrixThreshold = 5;
 
 std::string thor_worker_t::matrix(valhalla_request_t& request) {
+  return matrix_deferred(request)(request);
+}
+
+thor_worker_t::deferred_json_t thor_worker_t::matrix_deferred(valhalla_request_t& request) {
   parse_locations(request);
   auto costing = parse_costing(request);
 
@@ -39,19 +43,8 @@ std::string thor_worker_t::matrix(valhalla_request_t& request) {
     distance_scale = kMilePerMeter;
   }
 
-  json::MapPtr json;
-  // do the real work
-  std::vector<TimeDistance> time_distances;
-  auto costmatrix = [&]() {
-    thor::CostMatrix matrix;
-    return matrix.SourceToTarget(request.options.sources(), request.options.targets(), *reader,
-                                 mode_costing, mode, max_matrix_distance.find(costing)->second);
-  };
-  auto timedistancematrix = [&]() {
-    thor::TimeDistanceMatrix matrix;
-    return matrix.SourceToTarget(request.options.sources(), request.options.targets(), *reader,
-                                 mode_costing, mode, max_matrix_distance.find(costing)->second);
-  };
+  // Pick the algorithm for the job
+  bool use_costmatrix = true;
   switch (source_to_target_algorithm) {
     case SELECT_OPTIMAL:
       // TODO - Do further performance testing to pick the best algorithm for the job
@@ -60,28 +53,67 @@ std::string thor_worker_t::matrix(valhalla_request_t& request) {
         case TravelMode::kBicycle:
           // Use CostMatrix if number of sources and number of targets
           // exceeds some threshold
-          if (request.options.sources().size() > kCostMatrixThreshold &&
-              request.options.targets().size() > kCostMatrixThreshold) {
-            time_distances = costmatrix();
-          } else {
-            time_distances = timedistancematrix();
-          }
+          use_costmatrix = request.options.sources().size() > kCostMatrixThreshold &&
+                           request.options.targets().size() > kCostMatrixThreshold;
           break;
         case TravelMode::kPublicTransit:
-          time_distances = timedistancematrix();
+          use_costmatrix = false;
           break;
         default:
-          time_distances = costmatrix();
+          use_costmatrix = true;
       }
       break;
     case COST_MATRIX:
-      time_distances = costmatrix();
+      use_costmatrix = true;
       break;
     case TIME_DISTANCE_MATRIX:
-      time_distances = timedistancematrix();
+      use_costmatrix = false;
       break;
   }
-  return tyr::serializeMatrix(request, time_distances, distance_scale);
+
+  // For large matrices hand completed rows to the serializer as they settle
+  // rather than accumulating the full result. CostMatrix settles its
+  // bidirectional searches out of row order so streaming only applies to the
+  // time+distance algorithm.
+  const uint32_t matrix_size =
+      request.options.sources_size() * request.options.targets_size();
+  if (!use_costmatrix && matrix_streaming_threshold > 0 &&
+      matrix_size >= matrix_streaming_threshold) {
+    thor::TimeDistanceMatrix matrix;
+    matrix.set_interrupt(interrupt);
+    auto compute_rows = [&](const tyr::MatrixRowCallback& row_callback) {
+      matrix.SourceToTarget(request.options.sources(), request.options.targets(), *reader,
+                            mode_costing, mode, max_matrix_distance.find(costing)->second,
+                            row_callback);
+    };
+    auto json = tyr::serializeMatrix(request, compute_rows, distance_scale);
+    // streaming already interleaved the serialization with the computation
+    // so there is nothing left to defer
+    return [json = std::move(json)](const valhalla_request_t&) { return json; };
+  }
+
+  // do the real work
+  std::vector<TimeDistance> time_distances;
+  if (use_costmatrix) {
+    thor::CostMatrix matrix(costmatrix_concurrency);
+    matrix.set_interrupt(interrupt);
+    matrix.set_memory_budget(request_memory_budget);
+    time_distances =
+        matrix.SourceToTarget(request.options.sources(), request.options.targets(), *reader,
+                              mode_costing, mode, max_matrix_distance.find(costing)->second);
+  } else {
+    thor::TimeDistanceMatrix matrix;
+    matrix.set_interrupt(interrupt);
+    time_distances =
+        matrix.SourceToTarget(request.options.sources(), request.options.targets(), *reader,
+                              mode_costing, mode, max_matrix_distance.find(costing)->second);
+  }
+  // the search is done, only the serialization over the time distances is
+  // left and it needs nothing of the worker's state
+  return [time_distances = std::move(time_distances),
+          distance_scale](const valhalla_request_t& request) {
+    return tyr::serializeMatrix(request, time_distances, distance_scale);
+  };
 }
 } // namespace thor
 } // namespace valhalla
@@ -4,6 +4,7 @@
 #include "worker.h"
 #include <algorithm>
 #include <map>
+#include <thread>
 
 using namespace valhalla::baldr;
 using namespace valhalla::sif;
@@ -43,7 +44,8 @@ constexpr uint64_t kInitialEdgeLabelCount = 200000;
 // Default constructor
 MultiModalPathAlgorithm::MultiModalPathAlgorithm()
     : PathAlgorithm(), walking_distance_(0), mode_(TravelMode::kPedestrian), travel_type_(0),
-      adjacencylist_(nullptr), max_label_count_(std::numeric_limits<uint32_t>::max()) {
+      adjacencylist_(nullptr), max_label_count_(std::numeric_limits<uint32_t>::max()),
+      parallel_reachability_(false) {
 }
 
 // Destructor
@@ -69,7 +71,11 @@ void MultiModalPathAlgorithm::Init(const PointLL& origll,
   // Set bucket size and cost range based on DynamicCost.
   uint32_t bucketsize = costing->UnitSize();
   float range = kBucketCount * bucketsize;
-  adjacencylist_.reset(new DoubleBucketQueue(0.0f, range, bucketsize, edgecost));
+  if (adjacencylist_) {
+    adjacencylist_->reuse(0.0f, range, bucketsize, edgecost);
+  } else {
+    adjacencylist_.reset(new DoubleBucketQueue(0.0f, range, bucketsize, edgecost));
+  }
   edgestatus_.clear();
 
   // Get hierarchy limits from the costing. Get a copy since we increment
@@ -79,12 +85,15 @@ void MultiModalPathAlgorithm::Init(const PointLL& origll,
 
 // Clear the temporary information generated during path construction.
 void MultiModalPathAlgorithm::Clear() {
-  // Clear the edge labels and destination list
-  edgelabels_.clear();
+  // Clear the edge labels and destination list, recycling the label arena
+  sif::ClearLabels(edgelabels_);
   destinations_.clear();
 
-  // Clear elements from the adjacency list
-  adjacencylist_.reset();
+  // Empty the adjacency list but keep its bucket storage for the next
+  // request
+  if (adjacencylist_) {
+    adjacencylist_->clear();
+  }
 
   // Clear the edge status flags
   edgestatus_.clear();
@@ -129,10 +138,34 @@ MultiModalPathAlgorithm::GetBestPath(odin::Location& origin,
   float mindist = astarheuristic_.GetDistance(origin_new);
 
   // Check if there no possible path to destination based on mode to the
-  // destination - for now assume pedestrian
+  // destination - for now assume pedestrian. The check is a self contained
+  // search so when enabled it runs on a second thread, overlapped with the
+  // origin and destination initialization below
   // TODO - some means of setting destination mode
   disable_transit_ = false;
-  if (!CanReachDestination(destination, graphreader, TravelMode::kPedestrian, pc)) {
+  bool dest_reachable = false;
+  std::thread reachability;
+  if (parallel_reachability_) {
+    reachability = std::thread([&]() {
+      dest_reachable = CanReachDestination(destination, graphreader, TravelMode::kPedestrian, pc);
+    });
+  } else {
+    dest_reachable = CanReachDestination(destination, graphreader, TravelMode::kPedestrian, pc);
+  }
+
+  // Initialize the origin and destination locations. Initialize the
+  // destination first in case the origin edge includes a destination edge.
+  // Access to the destination is assumed to be pedestrian.
+  mode_ = TravelMode::kPedestrian;
+  SetDestination(graphreader, destination, costing);
+  SetOrigin(graphreader, origin, destination, costing);
+
+  // Join the reachability check - transit must not be disabled (or the route
+  // rejected) until its result is known.
+  if (reachability.joinable()) {
+    reachability.join();
+  }
+  if (!dest_reachable) {
     // Return if distance exceeds maximum distance set for the starting distance
     // of a multimodal route (TODO - add methods to costing to support this).
     if (mindist > 2000) {
@@ -144,11 +177,6 @@ MultiModalPathAlgorithm::GetBestPath(odin::Location& origin,
     }
   }
 
-  // Initialize the origin and destination locations. Initialize the
-  // destination first in case the origin edge includes a destination edge.
-  SetDestination(graphreader, destination, costing);
-  SetOrigin(graphreader, origin, destination, costing);
-
   // Set route start time (seconds from midnight) and timezone.
   // NOTe: already made sure origin has date_time set.
   date_before_tile_ = false;
@@ -156,6 +184,7 @@ MultiModalPathAlgorithm::GetBestPath(odin::Location& origin,
   origin_date_time_ = origin.date_time();
 
   start_time_ = DateTime::seconds_from_midnight(origin_date_time_);
+  tz_diff_cache_.clear();
   start_tz_index_ = edgelabels_.size() == 0 ? 0 : GetTimezone(graphreader, edgelabels_[0].endnode());
   if (start_tz_index_ == 0) {
     // TODO - should we throw an exception and return an error
@@ -166,6 +195,7 @@ MultiModalPathAlgorithm::GetBestPath(odin::Location& origin,
   // Clear operators and processed tiles
   operators_.clear();
   processed_tiles_.clear();
+  schedule_validity_.clear();
 
   // Find shortest path
   uint32_t nc = 0; // Count of iterations with no convergence
@@ -209,6 +239,7 @@ MultiModalPathAlgorithm::GetBestPath(odin::Location& origin,
     if (!pred.origin()) {
       edgestatus_.Update(pred.edgeid(), EdgeSet::kPermanent);
     }
+    RecordExpansion(pred.edgeid(), pred.cost().cost);
 
     // Check that distance is converging towards the destination. Return route
     // failure if no convergence for TODO iterations
@@ -263,8 +294,8 @@ bool MultiModalPathAlgorithm::ExpandForward(GraphReader& graphreader,
   if (nodeinfo->timezone() != start_tz_index_) {
     // Get the difference in seconds between the origin tz and current tz
     int tz_diff =
-        DateTime::timezone_diff(localtime, DateTime::get_tz_db().from_index(start_tz_index_),
-                                DateTime::get_tz_db().from_index(nodeinfo->timezone()));
+        tz_diff_cache_.diff(localtime, DateTime::get_tz_db().from_index(start_tz_index_),
+                            DateTime::get_tz_db().from_index(nodeinfo->timezone()));
     localtime += tz_diff;
   }
 
@@ -364,10 +395,20 @@ bool MultiModalPathAlgorithm::ExpandForward(GraphReader& graphreader,
         continue;
       }
 
+      // Collapse this tile's schedule validity onto the service day once per
+      // request so each departure candidate below costs a single bit test
+      auto vs = schedule_validity_.find(tile->id().tileid());
+      if (vs == schedule_validity_.end()) {
+        vs = schedule_validity_
+                 .emplace(tile->id().tileid(),
+                          tile->GetScheduleValidity(day_, dow_, date_before_tile_))
+                 .first;
+      }
+
       // Look up the next departure along this edge
       const TransitDeparture* departure =
-          tile->GetNextDeparture(directededge->lineid(), localtime, day_, dow_, date_before_tile_,
-                                 tc->wheelchair(), tc->bicycle());
+          tile->GetNextDeparture(directededge->lineid(), localtime, vs->second, tc->wheelchair(),
+                                 tc->bicycle());
 
       if (departure) {
         // Check if there has been a mode change
@@ -391,8 +432,8 @@ bool MultiModalPathAlgorithm::ExpandForward(GraphReader& graphreader,
             // departure.
             // TODO - is there a better way?
             if (localtime + 30 > departure->departure_time()) {
-              departure = tile->GetNextDeparture(directededge->lineid(), localtime + 30, day_, dow_,
-                                                 date_before_tile_, tc->wheelchair(), tc->bicycle());
+              departure = tile->GetNextDeparture(directededge->lineid(), localtime + 30,
+                                                 vs->second, tc->wheelchair(), tc->bicycle());
               if (!departure) {
                 continue;
               }
@@ -738,7 +779,7 @@ bool MultiModalPathAlgorithm::ExpandFromNode(baldr::GraphReader& graphreader,
 
     // Add edge label, add to the adjacency list and set edge status
     uint32_t idx = edgelabels.size();
-    edgelabels.emplace_back(pred_idx, edgeid, directededge, newcost, newcost.cost, 0.0f, mode_,
+    edgelabels.emplace_back(pred_idx, edgeid, directededge, newcost, newcost.cost, 0.0f, pred.mode(),
                             walking_distance);
     *es = {EdgeSet::kTemporary, idx};
     adjlist.add(idx);
@@ -763,10 +804,8 @@ bool MultiModalPathAlgorithm::CanReachDestination(const odin::Location& destinat
                                                   GraphReader& graphreader,
                                                   const TravelMode dest_mode,
                                                   const std::shared_ptr<DynamicCost>& costing) {
-  // Assume pedestrian mode for now
-  mode_ = dest_mode;
-
-  // Local edge labels and edge status info
+  // Local edge labels and edge status info. No member state is touched so
+  // this check can run concurrently with origin/destination initialization.
   EdgeStatus edgestatus;
   std::vector<EdgeLabel> edgelabels;
 
@@ -789,7 +828,8 @@ bool MultiModalPathAlgorithm::CanReachDestination(const odin::Location& destinat
     const DirectedEdge* diredge = tile->directededge(oppedge);
     uint32_t length = static_cast<uint32_t>(diredge->length()) * ratio;
     Cost cost = costing->EdgeCost(diredge, tile->GetSpeed(diredge)) * ratio;
-    edgelabels.emplace_back(kInvalidLabel, oppedge, diredge, cost, cost.cost, 0.0f, mode_, length);
+    edgelabels.emplace_back(kInvalidLabel, oppedge, diredge, cost, cost.cost, 0.0f, dest_mode,
+                            length);
     adjlist.add(label_idx);
     edgestatus.Set(oppedge, EdgeSet::kTemporary, label_idx, tile);
     label_idx++;
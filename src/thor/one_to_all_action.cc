@@ -0,0 +1,71 @@
+#include "thor/worker.h"
+
+#include <algorithm>
+
+using namespace valhalla::baldr;
+using namespace valhalla::midgard;
+
+namespace {
+
+// The response is little endian fixed width records so batch accessibility
+// jobs can mmap or stream it without a json parse:
+//   uint32_t version (currently 1)
+//   uint32_t record count
+// then one record per settled edge:
+//   uint64_t graph id, uint32_t seconds, uint32_t meters
+constexpr uint32_t kCostSurfaceVersion = 1;
+
+template <typename T> void append(std::string& body, const T value) {
+  body.append(static_cast<const char*>(static_cast<const void*>(&value)), sizeof(value));
+}
+
+} // namespace
+
+namespace valhalla {
+namespace thor {
+
+std::string thor_worker_t::one_to_all(valhalla_request_t& request) {
+  parse_locations(request);
+  auto costing = parse_costing(request);
+
+  // The largest contour time bounds the expansion just as it does for the
+  // isochrone action - the two actions share loki's validation
+  float max_minutes = 0.0f;
+  for (const auto& contour : request.options.contours()) {
+    max_minutes = std::max(max_minutes, contour.time());
+  }
+
+  // Abort the expansion when the client goes away
+  isochrone_gen.set_interrupt(interrupt);
+
+  // Run the expansion. The grid is a byproduct here - the cost surface is
+  // read straight off the search tree the expansion leaves behind. The
+  // reverse option reports costs towards the locations rather than away
+  // from them; multimodal has no reverse equivalent.
+  if (costing == "multimodal" || costing == "transit") {
+    isochrone_gen.ComputeMultiModal(*request.options.mutable_locations(), max_minutes, *reader,
+                                    mode_costing, mode);
+  } else if (request.options.reverse()) {
+    isochrone_gen.ComputeReverse(*request.options.mutable_locations(), max_minutes, *reader,
+                                 mode_costing, mode);
+  } else {
+    isochrone_gen.Compute(*request.options.mutable_locations(), max_minutes, *reader, mode_costing,
+                          mode);
+  }
+
+  // Pack the per edge costs
+  auto edges = isochrone_gen.GetExpansionEdges();
+  std::string body;
+  body.reserve(sizeof(uint32_t) * 2 + edges.size() * 16);
+  append(body, kCostSurfaceVersion);
+  append(body, static_cast<uint32_t>(edges.size()));
+  for (const auto& edge : edges) {
+    append(body, static_cast<uint64_t>(edge.edgeid));
+    append(body, edge.secs);
+    append(body, edge.dist);
+  }
+  return body;
+}
+
+} // namespace thor
+} // namespace valhalla
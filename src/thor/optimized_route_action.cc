@@ -17,7 +17,7 @@ using namespace valhalla::thor;
 namespace valhalla {
 namespace thor {
 
-std::list<valhalla::odin::TripPath> thor_worker_t::optimized_route(valhalla_request_t& request) {
+std::list<valhalla::odin::TripPath*> thor_worker_t::optimized_route(valhalla_request_t& request) {
   parse_locations(request);
   auto costing = parse_costing(request);
 
@@ -27,6 +27,8 @@ std::list<valhalla::odin::TripPath> thor_worker_t::optimized_route(valhalla_requ
 
   // Use CostMatrix to find costs from each location to every other location
   CostMatrix costmatrix;
+  costmatrix.set_interrupt(interrupt);
+  costmatrix.set_memory_budget(request_memory_budget);
   std::vector<thor::TimeDistance> td =
       costmatrix.SourceToTarget(request.options.sources(), request.options.targets(), *reader,
                                 mode_costing, mode, max_matrix_distance.find(costing)->second);
@@ -61,7 +63,72 @@ std::list<valhalla::odin::TripPath> thor_worker_t::optimized_route(valhalla_requ
     request.options.mutable_locations()->Add()->CopyFrom(correlated.Get(optimal_order[i]));
   }
 
-  return path_depart_at(*request.options.mutable_locations(), costing);
+  // The matrix search already explored the paths between every pair, so try
+  // to build each leg by replaying the recorded predecessor links instead of
+  // running a full route search per leg. Fall back to the per leg searches
+  // if any leg cannot be replayed
+  std::vector<std::vector<thor::PathInfo>> leg_paths;
+  leg_paths.reserve(optimal_order.size() - 1);
+  for (size_t i = 0; i + 1 < optimal_order.size(); ++i) {
+    auto leg_path = costmatrix.FormPath(optimal_order[i], optimal_order[i + 1], *reader);
+    if (leg_path.empty()) {
+      return path_depart_at(*request.options.mutable_locations(), costing);
+    }
+    leg_paths.emplace_back(std::move(leg_path));
+  }
+
+  // Merge the legs and build a trip path per break, the same way
+  // path_depart_at does with searched legs
+  std::vector<thor::PathInfo> path;
+  std::list<valhalla::odin::TripPath*> trip_paths;
+  auto& locations = *request.options.mutable_locations();
+  locations.begin()->set_type(odin::Location::kBreak);
+  locations.rbegin()->set_type(odin::Location::kBreak);
+  size_t leg = 0;
+  for (auto destination = ++locations.begin(); destination != locations.end(); ++destination) {
+    auto origin = std::prev(destination);
+    auto temp_path = std::move(leg_paths[leg++]);
+
+    // Merge through legs by updating the time and splicing the lists
+    if (!path.empty()) {
+      auto offset = path.back().elapsed_time;
+      std::for_each(temp_path.begin(), temp_path.end(),
+                    [offset](PathInfo& i) { i.elapsed_time += offset; });
+      if (path.back().edgeid == temp_path.front().edgeid) {
+        path.pop_back();
+      }
+      path.insert(path.end(), temp_path.begin(), temp_path.end());
+    } // Didnt need to merge
+    else {
+      path.swap(temp_path);
+    }
+
+    // Build trip path for this leg and add to the result if this
+    // location is a BREAK or if this is the last location
+    if (destination->type() == odin::Location::kBreak) {
+      // Move origin back to the last break and collect the throughs
+      std::list<odin::Location> throughs;
+      while (origin->type() != odin::Location::kBreak) {
+        throughs.push_front(*origin);
+        --origin;
+      }
+
+      // Create controller for default route attributes
+      AttributesController controller;
+
+      // Form output information based on path edges
+      auto* trip_path =
+          thor::TripPathBuilder::Build(controller, *reader, mode_costing, path, *origin,
+                                       *destination, throughs, interrupt, nullptr, &arena);
+      path.clear();
+
+      // Keep the protobuf path
+      trip_paths.emplace_back(trip_path);
+    }
+  }
+
+  // return the trip paths
+  return trip_paths;
 }
 
 } // namespace thor
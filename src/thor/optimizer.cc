@@ -1,9 +1,16 @@
 #include "thor/optimizer.h"
 #include "midgard/logging.h"
+#include <thread>
 
 namespace valhalla {
 namespace thor {
 
+namespace {
+// Minimum cost change for a local search move to count as an improvement.
+// Guards against cycling on floating point noise.
+constexpr float kMinImprovement = 0.001f;
+} // namespace
+
 // Optimize the tour through a set of locations given the cost matrix
 // among all locations. The first location (origin) and last location
 // (destination) remain fixed in the tour.
@@ -21,6 +28,12 @@ std::vector<uint32_t> Optimizer::Solve(const uint32_t count, const std::vector<f
     return (TourCost(costs, tour1) < TourCost(costs, tour2)) ? tour1 : tour2;
   }
 
+  // Larger tours use the local search engine - annealing does not scale
+  // much past 50 locations.
+  if (count_ >= kLocalSearchMinCount) {
+    return SolveLocalSearch(costs);
+  }
+
   // Populate the initial tour with a random order. The first and last
   // locations must remain fixed as the tour begin and end locations do not
   // change.
@@ -99,6 +112,228 @@ uint32_t Optimizer::Anneal(const std::vector<float>& costs, float temperature) {
   return success_count;
 }
 
+// Solve the tour with multi-restart local search over candidate neighbor
+// lists.
+std::vector<uint32_t> Optimizer::SolveLocalSearch(const std::vector<float>& costs) {
+  auto neighbors = BuildNeighborLists(costs);
+
+  // Draw the restart seeds up front so results are repeatable (given a
+  // seeded generator) regardless of how the restarts are scheduled
+  std::vector<uint64_t> seeds(kLocalSearchRestarts);
+  for (auto& seed : seeds) {
+    seed = random_generator_();
+  }
+
+  // Each restart forms a randomized greedy tour and improves it until
+  // neither move type finds an improvement
+  std::vector<std::vector<uint32_t>> tours(kLocalSearchRestarts);
+  std::vector<float> tour_costs(kLocalSearchRestarts);
+  const auto restart = [&](const uint32_t r) {
+    std::mt19937_64 rng(seeds[r]);
+    std::vector<uint32_t> tour = NearestNeighborTour(costs, rng);
+    bool improved = true;
+    while (improved) {
+      improved = TwoOptPass(costs, neighbors, tour);
+      improved = OrOptPass(costs, neighbors, tour) || improved;
+    }
+    tour_costs[r] = TourCost(costs, tour);
+    tours[r] = std::move(tour);
+  };
+
+  // Restarts are independent - run them across the hardware threads
+  uint32_t nthreads = std::min(kLocalSearchRestarts, std::max(1u, std::thread::hardware_concurrency()));
+  if (nthreads > 1) {
+    std::vector<std::thread> threads;
+    threads.reserve(nthreads);
+    for (uint32_t t = 0; t < nthreads; ++t) {
+      threads.emplace_back([&restart, t, nthreads]() {
+        for (uint32_t r = t; r < kLocalSearchRestarts; r += nthreads) {
+          restart(r);
+        }
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+  } else {
+    for (uint32_t r = 0; r < kLocalSearchRestarts; ++r) {
+      restart(r);
+    }
+  }
+
+  // Keep the best tour over all restarts (first among ties so the result
+  // does not depend on thread scheduling)
+  uint32_t best = 0;
+  for (uint32_t r = 1; r < kLocalSearchRestarts; ++r) {
+    if (tour_costs[r] < tour_costs[best]) {
+      best = r;
+    }
+  }
+  best_cost_ = tour_costs[best];
+  LOG_DEBUG("Best tour cost = " + std::to_string(best_cost_));
+  return tours[best];
+}
+
+// Build the candidate neighbor lists - the nearest locations by cost.
+std::vector<std::vector<uint32_t>>
+Optimizer::BuildNeighborLists(const std::vector<float>& costs) const {
+  uint32_t nsize = std::min(kNeighborListSize, count_ - 1);
+  std::vector<std::vector<uint32_t>> neighbors(count_);
+  std::vector<uint32_t> others;
+  others.reserve(count_ - 1);
+  for (uint32_t i = 0; i < count_; ++i) {
+    others.clear();
+    for (uint32_t j = 0; j < count_; ++j) {
+      if (j != i) {
+        others.push_back(j);
+      }
+    }
+    std::partial_sort(others.begin(), others.begin() + nsize, others.end(),
+                      [&](const uint32_t a, const uint32_t b) {
+                        return Cost(costs, i, a) < Cost(costs, i, b);
+                      });
+    neighbors[i].assign(others.begin(), others.begin() + nsize);
+  }
+  return neighbors;
+}
+
+// Form an initial tour greedily - move to one of the three cheapest
+// unvisited locations, chosen at random.
+std::vector<uint32_t> Optimizer::NearestNeighborTour(const std::vector<float>& costs,
+                                                     std::mt19937_64& rng) const {
+  std::vector<bool> visited(count_, false);
+  visited[0] = true;
+  visited[count_ - 1] = true;
+  std::vector<uint32_t> tour;
+  tour.reserve(count_);
+  tour.push_back(0);
+  uint32_t current = 0;
+  for (uint32_t step = 1; step < count_ - 1; ++step) {
+    // Keep the three cheapest unvisited locations
+    uint32_t cand[3];
+    float cand_cost[3];
+    uint32_t ncand = 0;
+    for (uint32_t j = 1; j < count_ - 1; ++j) {
+      if (visited[j]) {
+        continue;
+      }
+      float c = Cost(costs, current, j);
+      uint32_t k = ncand < 3 ? ncand : 3;
+      while (k > 0 && c < cand_cost[k - 1]) {
+        if (k < 3) {
+          cand[k] = cand[k - 1];
+          cand_cost[k] = cand_cost[k - 1];
+        }
+        k--;
+      }
+      if (k < 3) {
+        cand[k] = j;
+        cand_cost[k] = c;
+      }
+      if (ncand < 3) {
+        ncand++;
+      }
+    }
+
+    // Pick one at random so each restart forms a different tour
+    current = cand[rng() % ncand];
+    visited[current] = true;
+    tour.push_back(current);
+  }
+  tour.push_back(count_ - 1);
+  return tour;
+}
+
+// One 2-opt improvement pass over the tour.
+bool Optimizer::TwoOptPass(const std::vector<float>& costs,
+                           const std::vector<std::vector<uint32_t>>& neighbors,
+                           std::vector<uint32_t>& tour) const {
+  // Position of each location within the tour
+  std::vector<uint32_t> pos(count_);
+  for (uint32_t i = 0; i < count_; ++i) {
+    pos[tour[i]] = i;
+  }
+
+  bool improved = false;
+  for (uint32_t i = 1; i + 1 < count_; ++i) {
+    uint32_t a = tour[i - 1];
+    uint32_t b = tour[i];
+    for (const auto c : neighbors[a]) {
+      // Candidate move: connect a to c and reverse the span from b to c
+      uint32_t j = pos[c];
+      if (j < i || j + 1 >= count_) {
+        continue;
+      }
+      uint32_t d = tour[j + 1];
+
+      // Screen with the boundary arcs before paying for the exact change
+      float delta = Cost(costs, a, c) + Cost(costs, b, d) - Cost(costs, a, b) - Cost(costs, c, d);
+      if (delta > -kMinImprovement) {
+        continue;
+      }
+
+      // The cost matrix may be asymmetric - add the change from traversing
+      // the reversed span in the other direction
+      for (uint32_t k = i; k < j; ++k) {
+        delta += Cost(costs, tour[k + 1], tour[k]) - Cost(costs, tour[k], tour[k + 1]);
+      }
+      if (delta < -kMinImprovement) {
+        std::reverse(tour.begin() + i, tour.begin() + j + 1);
+        for (uint32_t k = i; k <= j; ++k) {
+          pos[tour[k]] = k;
+        }
+        b = tour[i];
+        improved = true;
+      }
+    }
+  }
+  return improved;
+}
+
+// One Or-opt improvement pass over the tour.
+bool Optimizer::OrOptPass(const std::vector<float>& costs,
+                          const std::vector<std::vector<uint32_t>>& neighbors,
+                          std::vector<uint32_t>& tour) const {
+  // Position of each location within the tour
+  std::vector<uint32_t> pos(count_);
+  for (uint32_t i = 0; i < count_; ++i) {
+    pos[tour[i]] = i;
+  }
+
+  bool improved = false;
+  for (uint32_t len = 1; len <= 3 && len + 2 < count_; ++len) {
+    for (uint32_t i = 1; i + len < count_; ++i) {
+      // The span tour[i, i+len) keeps its orientation; removing it closes
+      // the gap between its former prior and next locations
+      uint32_t s0 = tour[i];
+      uint32_t s1 = tour[i + len - 1];
+      float removal = Cost(costs, tour[i - 1], s0) + Cost(costs, s1, tour[i + len]) -
+                      Cost(costs, tour[i - 1], tour[i + len]);
+      for (const auto c : neighbors[s0]) {
+        // Candidate move: place the span right after c
+        uint32_t j = pos[c];
+        if ((j + 1 >= i && j < i + len) || j + 1 >= count_) {
+          continue;
+        }
+        uint32_t d = tour[j + 1];
+        float delta = Cost(costs, c, s0) + Cost(costs, s1, d) - Cost(costs, c, d) - removal;
+        if (delta < -kMinImprovement) {
+          std::vector<uint32_t> span(tour.begin() + i, tour.begin() + i + len);
+          tour.erase(tour.begin() + i, tour.begin() + i + len);
+          uint32_t insert_at = (j > i) ? j - len + 1 : j + 1;
+          tour.insert(tour.begin() + insert_at, span.begin(), span.end());
+          for (uint32_t k = 0; k < count_; ++k) {
+            pos[tour[k]] = k;
+          }
+          improved = true;
+          break;
+        }
+      }
+    }
+  }
+  return improved;
+}
+
 // Create a random initial tour. The first and last locations must remain
 // fixed as the tour begin and end locations do not change.
 void Optimizer::CreateRandomTour() {
@@ -1,5 +1,8 @@
 #include "thor/worker.h"
 #include <cstdint>
+#include <future>
+#include <mutex>
+#include <unordered_map>
 
 #include "baldr/json.h"
 #include "midgard/constants.h"
@@ -27,23 +30,279 @@ namespace thor {
 // A* can take excessive time for longer paths - so exclude them to protect the service.
 constexpr float kPedestrianMultipassThreshold = 50000.0f; // 50km
 
-std::list<valhalla::odin::TripPath> thor_worker_t::route(valhalla_request_t& request) {
+namespace {
+
+// Process wide statistics about first pass outcomes, shared by all worker
+// threads and keyed by a coarse origin region and the travel mode. In regions
+// where first passes keep failing (sparse networks, islands, gated
+// communities) the retry with relaxed limits doubles the worst case latency,
+// so once a region's failure rate is established the first pass is skipped
+// and the search starts relaxed. A periodic probe still runs the normal first
+// pass so the statistics can recover when the region stops failing.
+constexpr uint32_t kRegionMinSamples = 16;    // samples before the policy kicks in
+constexpr uint32_t kRegionDecayWindow = 256;  // halve the counters at this many samples
+constexpr uint32_t kRegionProbeInterval = 16; // every nth preempt runs a normal first pass
+
+struct pass_stats_t {
+  uint32_t attempts;
+  uint32_t failures;
+  uint32_t preempts;
+};
+std::mutex pass_stats_mutex;
+std::unordered_map<uint64_t, pass_stats_t> pass_stats;
+
+// Half degree cells accumulate samples quickly but still isolate a poorly
+// connected region from its neighbors
+uint64_t pass_stats_key(const odin::Location& origin, const sif::TravelMode mode) {
+  uint64_t row = static_cast<uint64_t>((origin.ll().lat() + 90.0f) * 2.0f);
+  uint64_t col = static_cast<uint64_t>((origin.ll().lng() + 180.0f) * 2.0f);
+  return (row * 720 + col) * 4 + static_cast<uint64_t>(mode);
+}
+
+// Should this request skip the first pass and start with relaxed limits
+bool preempt_first_pass(const uint64_t key) {
+  std::lock_guard<std::mutex> lock(pass_stats_mutex);
+  auto& stats = pass_stats[key];
+  if (stats.attempts < kRegionMinSamples || stats.failures * 2 < stats.attempts) {
+    return false;
+  }
+  // every so often let the first pass run anyway so the stats can recover
+  return ++stats.preempts % kRegionProbeInterval != 0;
+}
+
+// Record how a genuine first pass went, decaying the counters so old failures
+// do not condemn a region forever
+void record_first_pass(const uint64_t key, const bool failed) {
+  std::lock_guard<std::mutex> lock(pass_stats_mutex);
+  auto& stats = pass_stats[key];
+  ++stats.attempts;
+  stats.failures += failed;
+  if (stats.attempts >= kRegionDecayWindow) {
+    stats.attempts /= 2;
+    stats.failures /= 2;
+  }
+}
+
+// The costing a fastest/shortest toggle requests right after this one.
+// Returns the input when it has no pair
+odin::Costing paired_costing(const odin::Costing costing) {
+  switch (costing) {
+    case odin::Costing::auto_:
+      return odin::Costing::auto_shorter;
+    case odin::Costing::auto_shorter:
+      return odin::Costing::auto_;
+    default:
+      return costing;
+  }
+}
+
+} // namespace
+
+std::list<valhalla::odin::TripPath*> thor_worker_t::route(valhalla_request_t& request) {
   parse_locations(request);
   auto costing = parse_costing(request);
 
+  // Check the route cache - repeated near identical requests (e.g. preview
+  // requests as a location is dragged) return the prior result without
+  // re-running the path algorithm
+  bool cacheable = route_cache_size > 0 && route_cacheable(request);
+  std::string cache_key;
+  if (cacheable) {
+    cache_key = route_cache_key(request, costing);
+    auto cached = route_cache.find(cache_key);
+    if (cached != route_cache.end()) {
+      // Move the entry to the front of the LRU list
+      route_cache_lru.erase(cached->second.lru);
+      route_cache_lru.push_front(cache_key);
+      cached->second.lru = route_cache_lru.begin();
+      // Hand back arena copies so the cached originals stay untouched
+      std::list<valhalla::odin::TripPath*> trippaths;
+      for (const auto& tp : cached->second.trippaths) {
+        auto* copy = google::protobuf::Arena::CreateMessage<odin::TripPath>(&arena);
+        copy->CopyFrom(tp);
+        trippaths.push_back(copy);
+      }
+      if (!request.options.do_not_track()) {
+        for (const auto* tp : trippaths) {
+          log_admin(*tp);
+        }
+      }
+      return trippaths;
+    }
+  }
+
+  // Speculatively run the paired fastest/shortest costing on another thread
+  // while the requested one runs below, so the follow up request a toggle UI
+  // issues is answered from the cache at ~1x a single request's wall clock.
+  // The speculation shares only the tile cache with the main search; its
+  // cost object, algorithm and locations are all its own
+  std::future<std::list<odin::TripPath>> speculation;
+  std::string paired_key;
+  if (speculative_dual_costing && cacheable && request.options.locations_size() == 2 &&
+      !request.options.locations(0).has_date_time() &&
+      !request.options.locations(1).has_date_time()) {
+    auto paired = paired_costing(request.options.costing());
+    if (paired != request.options.costing()) {
+      paired_key = route_cache_key(request, odin::Costing_Name(paired));
+      if (route_cache.find(paired_key) == route_cache.end()) {
+        // Copies are taken here, before the main search can mutate the
+        // request, and the cost is created here so the factory stays single
+        // threaded
+        speculation = std::async(std::launch::async,
+                                 [this, origin = request.options.locations(0),
+                                  destination = request.options.locations(1),
+                                  cost = get_costing(paired, request.options)] {
+                                   return speculative_route(origin, destination, cost);
+                                 });
+      }
+    }
+  }
+
   auto trippaths = (request.options.has_date_time_type() &&
                     request.options.date_time_type() == odin::DirectionsOptions::arrive_by)
                        ? path_arrive_by(*request.options.mutable_locations(), costing)
                        : path_depart_at(*request.options.mutable_locations(), costing);
 
+  // Cache the result, evicting the least recently used entry when full
+  if (cacheable) {
+    if (route_cache.size() >= route_cache_size) {
+      route_cache.erase(route_cache_lru.back());
+      route_cache_lru.pop_back();
+    }
+    route_cache_lru.push_front(cache_key);
+    // The cache owns plain copies since the arena is reset between requests
+    std::list<odin::TripPath> copies;
+    for (const auto* tp : trippaths) {
+      copies.emplace_back(*tp);
+    }
+    route_cache.emplace(cache_key, RouteCacheEntry{std::move(copies), route_cache_lru.begin()});
+  }
+
+  // Collect the speculative paired result and seed the cache with it. A
+  // failed speculation comes back empty and the paired request, if it ever
+  // arrives, simply runs its own search
+  if (speculation.valid()) {
+    auto paired_paths = speculation.get();
+    if (!paired_paths.empty()) {
+      if (route_cache.size() >= route_cache_size) {
+        route_cache.erase(route_cache_lru.back());
+        route_cache_lru.pop_back();
+      }
+      route_cache_lru.push_front(paired_key);
+      route_cache.emplace(paired_key,
+                          RouteCacheEntry{std::move(paired_paths), route_cache_lru.begin()});
+    }
+  }
+
   if (!request.options.do_not_track()) {
-    for (const auto& tp : trippaths) {
-      log_admin(tp);
+    for (const auto* tp : trippaths) {
+      log_admin(*tp);
     }
   }
   return trippaths;
 }
 
+bool thor_worker_t::route_cacheable(const valhalla_request_t& request) const {
+  for (const auto& location : request.options.locations()) {
+    if (location.has_date_time() && location.date_time() == "current") {
+      return false;
+    }
+  }
+  return true;
+}
+
+std::string thor_worker_t::route_cache_key(const valhalla_request_t& request,
+                                           const std::string& costing) const {
+  std::string key = costing;
+  if (request.options.has_date_time_type()) {
+    key += '|' + std::to_string(request.options.date_time_type());
+  }
+  for (const auto& costing_options : request.options.costing_options()) {
+    key += '|' + costing_options.SerializeAsString();
+  }
+  // the costings consume the avoided edges too, so requests differing only
+  // in them must not share a result
+  for (auto edgeid : request.options.avoid_edges()) {
+    key += '|';
+    key.append(reinterpret_cast<const char*>(&edgeid), sizeof(edgeid));
+  }
+  for (const auto& location : request.options.locations()) {
+    key += '|';
+    if (location.has_date_time()) {
+      key += location.date_time();
+    }
+    // Quantize the distance along each candidate edge to 1/128ths so tiny
+    // input coordinate jitter still hits the cache
+    for (const auto& edge : location.path_edges()) {
+      key += '|' + std::to_string(edge.graph_id()) + '/' +
+             std::to_string(static_cast<uint32_t>(edge.percent_along() * 128.0f));
+    }
+  }
+  // the key is used whole - a hash of it could let two different requests
+  // collide and serve each other's routes
+  return key;
+}
+
+std::list<valhalla::odin::TripPath> thor_worker_t::speculative_route(odin::Location origin,
+                                                                    odin::Location destination,
+                                                                    sif::cost_ptr_t cost) const {
+  try {
+    // Everything the search mutates lives on this thread's stack. Only the
+    // tile cache is shared with the main search
+    auto travel_mode = cost->travel_mode();
+    sif::cost_ptr_t costings[static_cast<int>(sif::TravelMode::kMaxTravelMode)];
+    costings[static_cast<uint32_t>(travel_mode)] = cost;
+
+    // Same trivial case rule as get_path_algorithm, with local instances.
+    // Locations with date_times never get here so the time dependent
+    // algorithms are not needed
+    bool trivial = false;
+    for (const auto& edge1 : origin.path_edges()) {
+      for (const auto& edge2 : destination.path_edges()) {
+        trivial = trivial || edge1.graph_id() == edge2.graph_id();
+      }
+    }
+    AStarPathAlgorithm astar_local;
+    BidirectionalAStar bidir_local;
+    PathAlgorithm* path_algorithm = trivial ? static_cast<PathAlgorithm*>(&astar_local)
+                                            : static_cast<PathAlgorithm*>(&bidir_local);
+
+    // First pass, then the relaxed retry, as get_path does for the main
+    // search but without the shared pass statistics
+    if (!trivial) {
+      cost->set_allow_destination_only(false);
+    }
+    cost->set_pass(0);
+    auto path = path_algorithm->GetBestPath(origin, destination, *reader, costings, travel_mode);
+    if (path.empty() && cost->AllowMultiPass()) {
+      origin.mutable_path_edges()->MergeFrom(origin.filtered_edges());
+      destination.mutable_path_edges()->MergeFrom(destination.filtered_edges());
+      path_algorithm->Clear();
+      cost->set_pass(1);
+      cost->RelaxHierarchyLimits(trivial ? 16.0f : 8.0f, trivial ? 4.0f : 2.0f);
+      cost->set_allow_destination_only(true);
+      path = path_algorithm->GetBestPath(origin, destination, *reader, costings, travel_mode);
+    }
+    if (path.empty()) {
+      return {};
+    }
+
+    // Build the leg on the heap rather than the worker's arena; the cache
+    // owns plain copies anyway
+    AttributesController controller;
+    std::list<odin::Location> throughs;
+    std::unique_ptr<odin::TripPath> trip_path(
+        TripPathBuilder::Build(controller, *reader, costings, path, origin, destination, throughs));
+    std::list<valhalla::odin::TripPath> trip_paths;
+    trip_paths.emplace_back();
+    trip_paths.back().Swap(trip_path.get());
+    return trip_paths;
+  } catch (...) {
+    // a failed speculation only costs the paired request its own search
+    return {};
+  }
+}
+
 thor::PathAlgorithm* thor_worker_t::get_path_algorithm(const std::string& routetype,
                                                        const odin::Location& origin,
                                                        const odin::Location& destination) {
@@ -99,8 +358,28 @@ std::vector<thor::PathInfo> thor_worker_t::get_path(PathAlgorithm* path_algorith
   if (path_algorithm == &bidir_astar) {
     cost->set_allow_destination_only(false);
   }
-  cost->set_pass(0);
+  bool using_astar = (path_algorithm == &astar);
+  float relax_factor = using_astar ? 16.0f : 8.0f;
+  float expansion_within_factor = using_astar ? 4.0f : 2.0f;
+
+  // If first passes from this origin's region keep failing, skip the doomed
+  // first pass and start with the relaxed limits the retry would have used
+  auto stats_key = pass_stats_key(origin, mode);
+  bool preempted = cost->AllowMultiPass() && preempt_first_pass(stats_key);
+  if (preempted) {
+    origin.mutable_path_edges()->MergeFrom(origin.filtered_edges());
+    destination.mutable_path_edges()->MergeFrom(destination.filtered_edges());
+    cost->set_pass(1);
+    cost->RelaxHierarchyLimits(relax_factor, expansion_within_factor);
+    cost->set_allow_destination_only(true);
+  } else {
+    cost->set_pass(0);
+  }
   auto path = path_algorithm->GetBestPath(origin, destination, *reader, mode_costing, mode);
+  expanded_labels += path_algorithm->expanded_label_count();
+  if (!preempted) {
+    record_first_pass(stats_key, path.empty());
+  }
 
   // Check if we should run a second pass pedestrian route with different A*
   // (to look for better routes where a ferry is taken)
@@ -117,21 +396,19 @@ std::vector<thor::PathInfo> thor_worker_t::get_path(PathAlgorithm* path_algorith
   // If path is not found try again with relaxed limits (if allowed). Use less aggressive
   // hierarchy transition limits, and retry with more candidate edges (add those filtered
   // by heading on first pass).
-  if ((path.empty() || ped_second_pass) && cost->AllowMultiPass()) {
+  if ((path.empty() || ped_second_pass) && !preempted && cost->AllowMultiPass()) {
     // add filtered edges to candidate edges for origin and destination
     origin.mutable_path_edges()->MergeFrom(origin.filtered_edges());
     destination.mutable_path_edges()->MergeFrom(destination.filtered_edges());
 
     path_algorithm->Clear();
     cost->set_pass(1);
-    bool using_astar = (path_algorithm == &astar);
-    float relax_factor = using_astar ? 16.0f : 8.0f;
-    float expansion_within_factor = using_astar ? 4.0f : 2.0f;
     cost->RelaxHierarchyLimits(relax_factor, expansion_within_factor);
     cost->set_allow_destination_only(true);
 
     // Get the best path. Return if not empty (else return the original path)
     auto path2 = path_algorithm->GetBestPath(origin, destination, *reader, mode_costing, mode);
+    expanded_labels += path_algorithm->expanded_label_count();
     if (!path2.empty()) {
       return path2;
     }
@@ -144,12 +421,12 @@ std::vector<thor::PathInfo> thor_worker_t::get_path(PathAlgorithm* path_algorith
   return path;
 }
 
-std::list<valhalla::odin::TripPath> thor_worker_t::path_arrive_by(
+std::list<valhalla::odin::TripPath*> thor_worker_t::path_arrive_by(
     google::protobuf::RepeatedPtrField<valhalla::odin::Location>& correlated,
     const std::string& costing) {
   // Things we'll need
   std::vector<thor::PathInfo> path;
-  std::list<valhalla::odin::TripPath> trip_paths;
+  std::list<valhalla::odin::TripPath*> trip_paths;
   correlated.begin()->set_type(odin::Location::kBreak);
   correlated.rbegin()->set_type(odin::Location::kBreak);
 
@@ -198,12 +475,13 @@ std::list<valhalla::odin::TripPath> thor_worker_t::path_arrive_by(
       AttributesController controller;
 
       // Form output information based on path edges
-      auto trip_path = thor::TripPathBuilder::Build(controller, *reader, mode_costing, path, *origin,
-                                                    *destination, throughs, interrupt);
+      auto* trip_path =
+          thor::TripPathBuilder::Build(controller, *reader, mode_costing, path, *origin,
+                                       *destination, throughs, interrupt, nullptr, &arena);
       path.clear();
 
       // Keep the protobuf path
-      trip_paths.emplace_back(std::move(trip_path));
+      trip_paths.emplace_back(trip_path);
     }
   }
 
@@ -211,12 +489,12 @@ std::list<valhalla::odin::TripPath> thor_worker_t::path_arrive_by(
   return trip_paths;
 }
 
-std::list<valhalla::odin::TripPath> thor_worker_t::path_depart_at(
+std::list<valhalla::odin::TripPath*> thor_worker_t::path_depart_at(
     google::protobuf::RepeatedPtrField<valhalla::odin::Location>& correlated,
     const std::string& costing) {
   // Things we'll need
   std::vector<thor::PathInfo> path;
-  std::list<valhalla::odin::TripPath> trip_paths;
+  std::list<valhalla::odin::TripPath*> trip_paths;
   correlated.begin()->set_type(odin::Location::kBreak);
   correlated.rbegin()->set_type(odin::Location::kBreak);
 
@@ -267,12 +545,13 @@ std::list<valhalla::odin::TripPath> thor_worker_t::path_depart_at(
       AttributesController controller;
 
       // Form output information based on path edges
-      auto trip_path = thor::TripPathBuilder::Build(controller, *reader, mode_costing, path, *origin,
-                                                    *destination, throughs, interrupt);
+      auto* trip_path =
+          thor::TripPathBuilder::Build(controller, *reader, mode_costing, path, *origin,
+                                       *destination, throughs, interrupt, nullptr, &arena);
       path.clear();
 
       // Keep the protobuf path
-      trip_paths.emplace_back(std::move(trip_path));
+      trip_paths.emplace_back(trip_path);
     }
   }
 
@@ -17,6 +17,11 @@ constexpr uint64_t kInitialEdgeLabelCount = 500000;
 // Number of iterations to allow with no convergence to the destination
 constexpr uint32_t kMaxIterationsWithoutConvergence = 200000;
 
+// Minimum distance between the locations where forming guidance lower
+// bounds pays for itself. Short searches settle few enough edges that the
+// bounding search would dominate.
+constexpr float kLowerBoundMinDistance = 10000.0f;
+
 // Default constructor
 TimeDepForward::TimeDepForward() : AStarPathAlgorithm() {
   mode_ = TravelMode::kDrive;
@@ -60,8 +65,8 @@ void TimeDepForward::ExpandForward(GraphReader& graphreader,
   if (nodeinfo->timezone() != origin_tz_index_) {
     // Get the difference in seconds between the origin tz and current tz
     int tz_diff =
-        DateTime::timezone_diff(localtime, DateTime::get_tz_db().from_index(origin_tz_index_),
-                                DateTime::get_tz_db().from_index(nodeinfo->timezone()));
+        tz_diff_cache_.diff(localtime, DateTime::get_tz_db().from_index(origin_tz_index_),
+                            DateTime::get_tz_db().from_index(nodeinfo->timezone()));
     localtime += tz_diff;
     seconds_of_week = DateTime::normalize_seconds_of_week(seconds_of_week + tz_diff);
   }
@@ -86,7 +91,7 @@ void TimeDepForward::ExpandForward(GraphReader& graphreader,
     bool has_traffic = directededge->predicted_speed() || directededge->constrained_flow_speed() > 0;
     Cost newcost =
         pred.cost() +
-        costing_->EdgeCost(directededge, tile->GetSpeed(directededge, edgeid, seconds_of_week)) +
+        costing_->EdgeCost(directededge, MemoizedSpeed(tile, directededge, edgeid, seconds_of_week)) +
         costing_->TransitionCost(directededge, nodeinfo, pred, has_traffic);
 
     // If this edge is a destination, subtract the partial/remainder cost
@@ -139,7 +144,8 @@ void TimeDepForward::ExpandForward(GraphReader& graphreader,
       if (t2 == nullptr) {
         continue;
       }
-      sortcost += astarheuristic_.Get(t2->get_node_ll(directededge->endnode()), dist);
+      float heuristic = astarheuristic_.Get(t2->get_node_ll(directededge->endnode()), dist);
+      sortcost += SortCostBound(directededge->endnode(), heuristic);
     }
 
     // Add to the adjacency list and edge labels.
@@ -197,7 +203,9 @@ std::vector<PathInfo> TimeDepForward::GetBestPath(odin::Location& origin,
   uint32_t density = SetDestination(graphreader, destination);
   SetOrigin(graphreader, origin, destination);
 
-  // Set the origin timezone to be the timezone at the end node
+  // Set the origin timezone to be the timezone at the end node. Clear any
+  // timezone differences cached by a prior request.
+  tz_diff_cache_.clear();
   origin_tz_index_ = edgelabels_.size() == 0 ? 0 : GetTimezone(graphreader, edgelabels_[0].endnode());
   if (origin_tz_index_ == 0) {
     // TODO - do not throw exception at this time
@@ -216,6 +224,13 @@ std::vector<PathInfo> TimeDepForward::GetBestPath(odin::Location& origin,
   // Update hierarchy limits
   ModifyHierarchyLimits(mindist, density);
 
+  // For longer routes, guide the search with network lower bounds formed
+  // around the destination. These are tighter than the straight line
+  // heuristic so fewer edges are settled before the destination is reached.
+  if (mindist > kLowerBoundMinDistance) {
+    ComputeLowerBounds(graphreader, destination);
+  }
+
   // Find shortest path
   uint32_t nc = 0; // Count of iterations with no convergence
                    // towards destination
@@ -264,6 +279,7 @@ std::vector<PathInfo> TimeDepForward::GetBestPath(odin::Location& origin,
     if (!pred.origin()) {
       edgestatus_.Update(pred.edgeid(), EdgeSet::kPermanent);
     }
+    RecordExpansion(pred.edgeid(), pred.cost().cost);
 
     // Check that distance is converging towards the destination. Return route
     // failure if no convergence for TODO iterations. NOTE: due to somewhat high
@@ -15,6 +15,11 @@ namespace thor {
 // TODO - compute initial label count based on estimated route length
 constexpr uint64_t kInitialEdgeLabelCount = 500000;
 
+// Minimum distance between the locations where forming guidance lower
+// bounds pays for itself. Short searches settle few enough edges that the
+// bounding search would dominate.
+constexpr float kLowerBoundMinDistance = 10000.0f;
+
 // Default constructor
 TimeDepReverse::TimeDepReverse() : AStarPathAlgorithm() {
   mode_ = TravelMode::kDrive;
@@ -52,7 +57,11 @@ void TimeDepReverse::Init(const PointLL& origll, const PointLL& destll) {
   // Set bucket size and cost range based on DynamicCost.
   uint32_t bucketsize = costing_->UnitSize();
   float range = kBucketCount * bucketsize;
-  adjacencylist_.reset(new DoubleBucketQueue(mincost, range, bucketsize, edgecost));
+  if (adjacencylist_) {
+    adjacencylist_->reuse(mincost, range, bucketsize, edgecost);
+  } else {
+    adjacencylist_.reset(new DoubleBucketQueue(mincost, range, bucketsize, edgecost));
+  }
   edgestatus_.clear();
 
   // Get hierarchy limits from the costing. Get a copy since we increment
@@ -89,8 +98,8 @@ void TimeDepReverse::ExpandReverse(GraphReader& graphreader,
   if (nodeinfo->timezone() != dest_tz_index_) {
     // Get the difference in seconds between the destination tz and current tz
     int tz_diff =
-        DateTime::timezone_diff(localtime, DateTime::get_tz_db().from_index(nodeinfo->timezone()),
-                                DateTime::get_tz_db().from_index(dest_tz_index_));
+        tz_diff_cache_.diff(localtime, DateTime::get_tz_db().from_index(nodeinfo->timezone()),
+                            DateTime::get_tz_db().from_index(dest_tz_index_));
     localtime += tz_diff;
     seconds_of_week = DateTime::normalize_seconds_of_week(seconds_of_week + tz_diff);
   }
@@ -129,8 +138,9 @@ void TimeDepReverse::ExpandReverse(GraphReader& graphreader,
         opp_pred_edge->predicted_speed() || opp_pred_edge->constrained_flow_speed() > 0;
     Cost tc = costing_->TransitionCostReverse(directededge->localedgeidx(), nodeinfo, opp_edge,
                                               opp_pred_edge, has_traffic);
-    Cost newcost = pred.cost() +
-                   costing_->EdgeCost(opp_edge, t2->GetSpeed(directededge, edgeid, seconds_of_week));
+    Cost newcost =
+        pred.cost() +
+        costing_->EdgeCost(opp_edge, MemoizedSpeed(t2, directededge, edgeid, seconds_of_week));
     newcost.cost += tc.cost;
 
     // If this edge is a destination, subtract the partial/remainder cost
@@ -183,7 +193,8 @@ void TimeDepReverse::ExpandReverse(GraphReader& graphreader,
       if (t2 == nullptr) {
         continue;
       }
-      sortcost += astarheuristic_.Get(t2->get_node_ll(directededge->endnode()), dist);
+      float heuristic = astarheuristic_.Get(t2->get_node_ll(directededge->endnode()), dist);
+      sortcost += SortCostBound(directededge->endnode(), heuristic);
     }
 
     // Add edge label, add to the adjacency list and set edge status
@@ -243,7 +254,9 @@ std::vector<PathInfo> TimeDepReverse::GetBestPath(odin::Location& origin,
   uint32_t density = SetDestination(graphreader, origin);
   SetOrigin(graphreader, destination, origin);
 
-  // Set the destination timezone
+  // Set the destination timezone. Clear any timezone differences cached by
+  // a prior request.
+  tz_diff_cache_.clear();
   dest_tz_index_ =
       edgelabels_rev_.size() == 0 ? 0 : GetTimezone(graphreader, edgelabels_rev_[0].endnode());
   if (dest_tz_index_ == 0) {
@@ -254,6 +267,14 @@ std::vector<PathInfo> TimeDepReverse::GetBestPath(odin::Location& origin,
   // Update hierarchy limits
   ModifyHierarchyLimits(mindist, density);
 
+  // For longer routes, guide the search with network lower bounds formed
+  // around the origin (the target of the reverse search). These are tighter
+  // than the straight line heuristic so fewer edges are settled before the
+  // origin is reached.
+  if (mindist > kLowerBoundMinDistance) {
+    ComputeLowerBounds(graphreader, origin);
+  }
+
   // Set route start time (seconds from epoch)
   uint64_t start_time =
       DateTime::seconds_since_epoch(destination.date_time(),
@@ -312,6 +333,7 @@ std::vector<PathInfo> TimeDepReverse::GetBestPath(odin::Location& origin,
     if (!pred.origin()) {
       edgestatus_.Update(pred.edgeid(), EdgeSet::kPermanent);
     }
+    RecordExpansion(pred.edgeid(), pred.cost().cost);
 
     // Check that distance is converging towards the destination. Return route
     // failure if no convergence for TODO iterations
@@ -1,6 +1,9 @@
 #include "thor/timedistancematrix.h"
+#include "baldr/tilehierarchy.h"
 #include "midgard/logging.h"
+#include "thor/pathalgorithm.h"
 #include <algorithm>
+#include <cmath>
 #include <vector>
 
 using namespace valhalla::baldr;
@@ -28,7 +31,8 @@ namespace thor {
 
 // Constructor with cost threshold.
 TimeDistanceMatrix::TimeDistanceMatrix()
-    : mode_(TravelMode::kDrive), settled_count_(0), current_cost_threshold_(0) {
+    : interrupt_(nullptr), mode_(TravelMode::kDrive), settled_count_(0), current_cost_threshold_(0),
+      cost_factor_(0.0f) {
 }
 
 float TimeDistanceMatrix::GetCostThreshold(const float max_matrix_distance) const {
@@ -48,16 +52,58 @@ float TimeDistanceMatrix::GetCostThreshold(const float max_matrix_distance) cons
   return cost_threshold;
 }
 
+// Get a cost lower bound from the graph tile containing a node to the
+// nearest destination.
+float TimeDistanceMatrix::TileDestinationBound(const GraphId& node) {
+  // A non-positive factor (e.g. transit) cannot form a bound
+  if (cost_factor_ <= 0.0f || dest_ll_.empty()) {
+    return 0.0f;
+  }
+
+  // Look for a cached bound for this tile, computing it on first touch
+  auto bound = tile_dest_bound_.emplace(node.Tile_Base().value, 0.0f);
+  if (bound.second) {
+    // Get the closest point within the tile bounds to each destination and
+    // keep the least distance
+    const auto& tiles = TileHierarchy::levels().find(node.level())->second.tiles;
+    midgard::AABB2<midgard::PointLL> bbox = tiles.TileBounds(node.tileid());
+    float min_dist = std::numeric_limits<float>::max();
+    for (const auto& ll : dest_ll_) {
+      midgard::PointLL closest(std::min(std::max(ll.lng(), bbox.minx()), bbox.maxx()),
+                               std::min(std::max(ll.lat(), bbox.miny()), bbox.maxy()));
+      float dist = ll.Distance(closest);
+      if (dist < min_dist) {
+        min_dist = dist;
+      }
+    }
+    bound.first->second = min_dist * cost_factor_;
+  }
+  return bound.first->second;
+}
+
 // Clear the temporary information generated during time + distance matrix
 // construction.
 void TimeDistanceMatrix::Clear() {
-  // Clear the edge labels and destination list
-  edgelabels_.clear();
+  // Clear the search state and everything known about the destinations
+  ClearSearch();
   destinations_.clear();
+  destinations_setup_.clear();
   dest_edges_.clear();
+  dest_ll_.clear();
+  tile_dest_bound_.clear();
+}
+
+// Clear only what a single search dirtied, keeping the destination set up
+// for the next source of a many to many
+void TimeDistanceMatrix::ClearSearch() {
+  // Clear the edge labels, recycling the label arena
+  sif::ClearLabels(edgelabels_);
 
-  // Clear elements from the adjacency list
-  adjacencylist_.reset();
+  // Empty the adjacency list but keep its bucket storage for the next
+  // request
+  if (adjacencylist_) {
+    adjacencylist_->clear();
+  }
 
   // Clear the edge status flags
   edgestatus_.clear();
@@ -143,9 +189,19 @@ TimeDistanceMatrix::OneToMany(const odin::Location& origin,
                               const std::shared_ptr<DynamicCost>* mode_costing,
                               const TravelMode mode,
                               const float max_matrix_distance) {
-  // Set the mode and costing
+  // Set the mode and costing, set up the destinations and run the search
   mode_ = mode;
   costing_ = mode_costing[static_cast<uint32_t>(mode_)];
+  SetDestinations(graphreader, locations);
+  return ComputeOneToMany(origin, locations, graphreader, max_matrix_distance);
+}
+
+// Run the search for one origin against destinations that are already set up
+std::vector<TimeDistance> TimeDistanceMatrix::ComputeOneToMany(
+    const odin::Location& origin,
+    const google::protobuf::RepeatedPtrField<odin::Location>& locations,
+    GraphReader& graphreader,
+    const float max_matrix_distance) {
   current_cost_threshold_ = GetCostThreshold(max_matrix_distance);
 
   // Construct adjacency list, edge status, and done set. Set bucket size and
@@ -155,17 +211,27 @@ TimeDistanceMatrix::OneToMany(const odin::Location& origin,
   uint32_t bucketsize = costing_->UnitSize();
   // Set up lambda to get sort costs
   const auto edgecost = [this](const uint32_t label) { return edgelabels_[label].sortcost(); };
-  adjacencylist_.reset(new DoubleBucketQueue(0.0f, current_cost_threshold_, bucketsize, edgecost));
+  if (adjacencylist_) {
+    adjacencylist_->reuse(0.0f, current_cost_threshold_, bucketsize, edgecost);
+  } else {
+    adjacencylist_.reset(
+        new DoubleBucketQueue(0.0f, current_cost_threshold_, bucketsize, edgecost));
+  }
   edgestatus_.clear();
 
-  // Initialize the origin and destination locations
+  // Initialize the origin
   settled_count_ = 0;
   SetOriginOneToMany(graphreader, origin);
-  SetDestinations(graphreader, locations);
 
   // Find shortest path
+  uint32_t n = 0;
   const GraphTile* tile;
   while (true) {
+    // Periodically check for the abort condition
+    if (interrupt_ && (n++ % kInterruptIterationsInterval) == 0) {
+      (*interrupt_)();
+    }
+
     // Get next element from adjacency list. Check that it is valid. An
     // invalid label indicates there are no edges that can be expanded.
     uint32_t predindex = adjacencylist_->pop();
@@ -201,6 +267,13 @@ TimeDistanceMatrix::OneToMany(const odin::Location& origin,
       return FormTimeDistanceMatrix();
     }
 
+    // Skip expansion when the cost plus a lower bound to the nearest
+    // destination exceeds the threshold - nothing past this edge can
+    // improve a destination that would not already be reported not found
+    if (pred.cost().cost + TileDestinationBound(pred.endnode()) > current_cost_threshold_) {
+      continue;
+    }
+
     // Expand forward from the end node of the predecessor edge.
     ExpandForward(graphreader, pred.endnode(), pred, predindex, false);
   }
@@ -303,9 +376,20 @@ TimeDistanceMatrix::ManyToOne(const odin::Location& dest,
                               const std::shared_ptr<DynamicCost>* mode_costing,
                               const TravelMode mode,
                               const float max_matrix_distance) {
-  // Set the mode and costing
+  // Set the mode and costing, set up the destinations and run the search
   mode_ = mode;
   costing_ = mode_costing[static_cast<uint32_t>(mode_)];
+  SetDestinationsManyToOne(graphreader, locations);
+  return ComputeManyToOne(dest, locations, graphreader, max_matrix_distance);
+}
+
+// Run the reverse search for one destination against origins that are
+// already set up
+std::vector<TimeDistance> TimeDistanceMatrix::ComputeManyToOne(
+    const odin::Location& dest,
+    const google::protobuf::RepeatedPtrField<odin::Location>& locations,
+    GraphReader& graphreader,
+    const float max_matrix_distance) {
   current_cost_threshold_ = GetCostThreshold(max_matrix_distance);
 
   // Construct adjacency list, edge status, and done set. Set bucket size and
@@ -314,17 +398,27 @@ TimeDistanceMatrix::ManyToOne(const odin::Location& dest,
   astarheuristic_.Init({dest.ll().lng(), dest.ll().lat()}, 0.0f);
   uint32_t bucketsize = costing_->UnitSize();
   const auto edgecost = [this](const uint32_t label) { return edgelabels_[label].sortcost(); };
-  adjacencylist_.reset(new DoubleBucketQueue(0.0f, current_cost_threshold_, bucketsize, edgecost));
+  if (adjacencylist_) {
+    adjacencylist_->reuse(0.0f, current_cost_threshold_, bucketsize, edgecost);
+  } else {
+    adjacencylist_.reset(
+        new DoubleBucketQueue(0.0f, current_cost_threshold_, bucketsize, edgecost));
+  }
   edgestatus_.clear();
 
-  // Initialize the origin and destination locations
+  // Initialize the origin
   settled_count_ = 0;
   SetOriginManyToOne(graphreader, dest);
-  SetDestinationsManyToOne(graphreader, locations);
 
   // Find shortest path
+  uint32_t n = 0;
   const GraphTile* tile;
   while (true) {
+    // Periodically check for the abort condition
+    if (interrupt_ && (n++ % kInterruptIterationsInterval) == 0) {
+      (*interrupt_)();
+    }
+
     // Get next element from adjacency list. Check that it is valid. An
     // invalid label indicates there are no edges that can be expanded.
     uint32_t predindex = adjacencylist_->pop();
@@ -360,6 +454,13 @@ TimeDistanceMatrix::ManyToOne(const odin::Location& dest,
       return FormTimeDistanceMatrix();
     }
 
+    // Skip expansion when the cost plus a lower bound to the nearest
+    // destination exceeds the threshold - nothing past this edge can
+    // improve a destination that would not already be reported not found
+    if (pred.cost().cost + TileDestinationBound(pred.endnode()) > current_cost_threshold_) {
+      continue;
+    }
+
     // Expand forward from the end node of the predecessor edge.
     ExpandReverse(graphreader, pred.endnode(), pred, predindex, false);
   }
@@ -384,26 +485,67 @@ std::vector<TimeDistance> TimeDistanceMatrix::SourceToTarget(
     const std::shared_ptr<sif::DynamicCost>* mode_costing,
     const sif::TravelMode mode,
     const float max_matrix_distance) {
-  // Run a series of one to many calls and concatenate the results.
+  // Run a series of one to many calls and concatenate the results. The
+  // destination set is the same for every row, so it is set up once and the
+  // working list restored between rows instead of repeating the graph
+  // lookups per source.
   std::vector<TimeDistance> many_to_many;
+  mode_ = mode;
+  costing_ = mode_costing[static_cast<uint32_t>(mode)];
   if (source_location_list.size() <= target_location_list.size()) {
+    SetDestinations(graphreader, target_location_list);
+    destinations_setup_ = destinations_;
     for (const auto& origin : source_location_list) {
-      std::vector<TimeDistance> td = OneToMany(origin, target_location_list, graphreader,
-                                               mode_costing, mode, max_matrix_distance);
+      std::vector<TimeDistance> td =
+          ComputeOneToMany(origin, target_location_list, graphreader, max_matrix_distance);
       many_to_many.insert(many_to_many.end(), td.begin(), td.end());
-      Clear();
+      ClearSearch();
+      destinations_ = destinations_setup_;
     }
   } else {
+    SetDestinationsManyToOne(graphreader, source_location_list);
+    destinations_setup_ = destinations_;
     for (const auto& destination : target_location_list) {
-      std::vector<TimeDistance> td = ManyToOne(destination, source_location_list, graphreader,
-                                               mode_costing, mode, max_matrix_distance);
+      std::vector<TimeDistance> td =
+          ComputeManyToOne(destination, source_location_list, graphreader, max_matrix_distance);
       many_to_many.insert(many_to_many.end(), td.begin(), td.end());
-      Clear();
+      ClearSearch();
+      destinations_ = destinations_setup_;
     }
   }
+  Clear();
   return many_to_many;
 }
 
+// Form a time distance matrix, handing each completed row to the callback
+// as it settles.
+void TimeDistanceMatrix::SourceToTarget(
+    const google::protobuf::RepeatedPtrField<odin::Location>& source_location_list,
+    const google::protobuf::RepeatedPtrField<odin::Location>& target_location_list,
+    baldr::GraphReader& graphreader,
+    const std::shared_ptr<sif::DynamicCost>* mode_costing,
+    const sif::TravelMode mode,
+    const float max_matrix_distance,
+    const std::function<void(const uint32_t source_index, const std::vector<TimeDistance>& row)>&
+        row_callback) {
+  // Rows must be delivered in source order, so always run one source at a
+  // time even when there are fewer targets than sources. The destination
+  // set up is shared across rows as in the accumulating variant.
+  mode_ = mode;
+  costing_ = mode_costing[static_cast<uint32_t>(mode)];
+  SetDestinations(graphreader, target_location_list);
+  destinations_setup_ = destinations_;
+  uint32_t source_index = 0;
+  for (const auto& origin : source_location_list) {
+    std::vector<TimeDistance> td =
+        ComputeOneToMany(origin, target_location_list, graphreader, max_matrix_distance);
+    row_callback(source_index++, td);
+    ClearSearch();
+    destinations_ = destinations_setup_;
+  }
+  Clear();
+}
+
 // Add edges at the origin to the adjacency list
 void TimeDistanceMatrix::SetOriginOneToMany(GraphReader& graphreader, const odin::Location& origin) {
   // Only skip inbound edges if we have other options
@@ -502,6 +644,14 @@ void TimeDistanceMatrix::SetOriginManyToOne(GraphReader& graphreader, const odin
 void TimeDistanceMatrix::SetDestinations(
     GraphReader& graphreader,
     const google::protobuf::RepeatedPtrField<odin::Location>& locations) {
+  // Keep the destination locations and the admissible costing factor so
+  // expansions can be pruned against a cost lower bound to the nearest
+  // destination
+  cost_factor_ = costing_->AStarCostFactor();
+  for (const auto& loc : locations) {
+    dest_ll_.emplace_back(loc.ll().lng(), loc.ll().lat());
+  }
+
   // For each destination
   uint32_t idx = 0;
   for (const auto& loc : locations) {
@@ -541,6 +691,14 @@ void TimeDistanceMatrix::SetDestinations(
 void TimeDistanceMatrix::SetDestinationsManyToOne(
     GraphReader& graphreader,
     const google::protobuf::RepeatedPtrField<odin::Location>& locations) {
+  // Keep the destination locations and the admissible costing factor so
+  // expansions can be pruned against a cost lower bound to the nearest
+  // destination
+  cost_factor_ = costing_->AStarCostFactor();
+  for (const auto& loc : locations) {
+    dest_ll_.emplace_back(loc.ll().lng(), loc.ll().lat());
+  }
+
   // For each destination
   uint32_t idx = 0;
   for (const auto& loc : locations) {
@@ -1,5 +1,6 @@
 #include <algorithm>
 #include <cstdint>
+#include <sstream>
 #include <string>
 #include <tuple>
 #include <vector>
@@ -7,6 +8,7 @@
 #include "baldr/directededge.h"
 #include "baldr/graphconstants.h"
 #include "baldr/json.h"
+#include "baldr/rapidjson_utils.h"
 #include "midgard/constants.h"
 #include "midgard/logging.h"
 #include "odin/enhancedtrippath.h"
@@ -62,6 +64,8 @@ void thor_worker_t::filter_attributes(const valhalla_request_t& request,
   } else {
     controller.enable_all();
   }
+  // the builders test the compiled masks, not the map
+  controller.compile();
 }
 
 /*
@@ -71,6 +75,10 @@ void thor_worker_t::filter_attributes(const valhalla_request_t& request,
  * path as well as any intersections along the path.
  */
 std::string thor_worker_t::trace_attributes(valhalla_request_t& request) {
+  // A batch of traces shares the matcher factory, costing and tile cache
+  if (rapidjson::get_child_optional(request.document, "/traces")) {
+    return trace_attributes_batch(request);
+  }
 
   // Parse request
   parse_locations(request);
@@ -83,8 +91,8 @@ std::string thor_worker_t::trace_attributes(valhalla_request_t& request) {
    * Valhalla will allow an efficient “edge-walking” algorithm rather than a more extensive
    * map-matching method. If true, this enforces to only use exact route match algorithm.
    */
-  odin::TripPath trip_path;
-  std::vector<std::tuple<float, float, std::vector<thor::MatchResult>, odin::TripPath>>
+  odin::TripPath* trip_path = nullptr;
+  std::vector<std::tuple<float, float, std::vector<thor::MatchResult>, odin::TripPath*>>
       map_match_results;
   AttributesController controller;
   filter_attributes(request, controller);
@@ -95,7 +103,7 @@ std::string thor_worker_t::trace_attributes(valhalla_request_t& request) {
     case odin::ShapeMatch::edge_walk:
       try {
         trip_path = route_match(request, controller);
-        if (trip_path.node().size() == 0) {
+        if (trip_path->node().size() == 0) {
           throw std::exception{};
         };
         map_match_results.emplace_back(1.0f, 0.0f, std::vector<thor::MatchResult>{}, trip_path);
@@ -123,7 +131,7 @@ std::string thor_worker_t::trace_attributes(valhalla_request_t& request) {
     // available.
     case odin::ShapeMatch::walk_or_snap:
       trip_path = route_match(request, controller);
-      if (trip_path.node().size() == 0) {
+      if (trip_path->node().size() == 0) {
         LOG_WARN(odin::ShapeMatch_Name(request.options.shape_match()) +
                  " algorithm failed to find exact route match; Falling back to map_match...");
         try {
@@ -140,11 +148,68 @@ std::string thor_worker_t::trace_attributes(valhalla_request_t& request) {
   }
 
   if (map_match_results.empty() ||
-      std::get<kTripPathIndex>(map_match_results.at(0)).node().size() == 0) {
+      std::get<kTripPathIndex>(map_match_results.at(0))->node().size() == 0) {
     throw valhalla_exception_t{442};
   }
   return tyr::serializeTraceAttributes(request, controller, map_match_results);
 }
 
+/*
+ * The batched form of trace_attributes takes a traces array and map matches
+ * each one in turn, reusing the matcher factory, the costing objects and the
+ * tile cache warmth across the whole batch instead of paying the per request
+ * setup for every trace. A failed trace produces an error entry in its slot
+ * rather than failing the batch.
+ */
+std::string thor_worker_t::trace_attributes_batch(valhalla_request_t& request) {
+  parse_costing(request);
+
+  AttributesController controller;
+  filter_attributes(request, controller);
+
+  auto traces = rapidjson::get_optional<rapidjson::Value::ConstArray>(request.document, "/traces");
+  if (!traces || !traces->Size()) {
+    throw valhalla_exception_t{115};
+  }
+
+  // the results are already serialized json so the batch is assembled as text
+  std::string results = "{\"results\":[";
+  bool first = true;
+  for (const auto& trace_object : *traces) {
+    if (!first) {
+      results += ',';
+    }
+    first = false;
+    try {
+      // load this trace into the options and make its measurements
+      parse_trace_shape(trace_object, request.options);
+      trace.clear();
+      parse_measurements(request);
+
+      // batched traces are always map matched, loki enforced that upstream
+      auto map_match_results = map_match(request, controller, request.options.best_paths());
+      if (map_match_results.empty() ||
+          std::get<kTripPathIndex>(map_match_results.at(0))->node().size() == 0) {
+        throw valhalla_exception_t{442};
+      }
+      results += tyr::serializeTraceAttributes(request, controller, map_match_results);
+    } catch (const valhalla_exception_t& e) {
+      auto error = baldr::json::map(
+          {{"error_code", static_cast<uint64_t>(e.code)}, {"error", std::string(e.message)}});
+      std::stringstream ss;
+      ss << *error;
+      results += ss.str();
+    } catch (const std::exception& e) {
+      auto error = baldr::json::map(
+          {{"error_code", static_cast<uint64_t>(444)}, {"error", std::string(e.what())}});
+      std::stringstream ss;
+      ss << *error;
+      results += ss.str();
+    }
+  }
+  results += "]}";
+  return results;
+}
+
 } // namespace thor
 } // namespace valhalla
@@ -46,7 +46,7 @@ namespace thor {
 /*
  * The trace_route action takes a GPS trace and turns it into a route result.
  */
-odin::TripPath thor_worker_t::trace_route(valhalla_request_t& request) {
+odin::TripPath* thor_worker_t::trace_route(valhalla_request_t& request) {
 
   // Parse request
   parse_locations(request);
@@ -54,7 +54,7 @@ odin::TripPath thor_worker_t::trace_route(valhalla_request_t& request) {
   parse_measurements(request);
 
   // Initialize the controller
-  odin::TripPath trip_path;
+  odin::TripPath* trip_path = nullptr;
   AttributesController controller;
 
   switch (request.options.shape_match()) {
@@ -63,7 +63,7 @@ odin::TripPath thor_worker_t::trace_route(valhalla_request_t& request) {
     case odin::ShapeMatch::edge_walk:
       try {
         trip_path = route_match(request, controller);
-        if (trip_path.node().size() == 0) {
+        if (trip_path->node().size() == 0) {
           throw std::exception{};
         }
       } catch (...) {
@@ -89,7 +89,7 @@ odin::TripPath thor_worker_t::trace_route(valhalla_request_t& request) {
     // available.
     case odin::ShapeMatch::walk_or_snap:
       trip_path = route_match(request, controller);
-      if (trip_path.node().size() == 0) {
+      if (trip_path->node().size() == 0) {
         LOG_WARN(odin::ShapeMatch_Name(request.options.shape_match()) +
                  " algorithm failed to find exact route match; Falling back to map_match...");
         try {
@@ -103,7 +103,7 @@ odin::TripPath thor_worker_t::trace_route(valhalla_request_t& request) {
   }
 
   if (!request.options.do_not_track()) {
-    log_admin(trip_path);
+    log_admin(*trip_path);
   }
 
   return trip_path;
@@ -116,9 +116,9 @@ odin::TripPath thor_worker_t::trace_route(valhalla_request_t& request) {
  * form the list of edges. It will return no nodes if path not found.
  *
  */
-odin::TripPath thor_worker_t::route_match(valhalla_request_t& request,
-                                          const AttributesController& controller) {
-  odin::TripPath trip_path;
+odin::TripPath* thor_worker_t::route_match(valhalla_request_t& request,
+                                           const AttributesController& controller) {
+  odin::TripPath* trip_path = google::protobuf::Arena::CreateMessage<odin::TripPath>(&arena);
   std::vector<PathInfo> path_infos;
   if (RouteMatcher::FormPath(mode_costing, mode, *reader, trace, request.options.locations(),
                              path_infos)) {
@@ -126,7 +126,8 @@ odin::TripPath thor_worker_t::route_match(valhalla_request_t& request,
     trip_path = thor::TripPathBuilder::Build(controller, *reader, mode_costing, path_infos,
                                              *request.options.mutable_locations()->begin(),
                                              *request.options.mutable_locations()->rbegin(),
-                                             std::list<odin::Location>{}, interrupt);
+                                             std::list<odin::Location>{}, interrupt, nullptr,
+                                             &arena);
   }
 
   return trip_path;
@@ -136,11 +137,11 @@ odin::TripPath thor_worker_t::route_match(valhalla_request_t& request,
 // PathInfo is primarily a list of edge Ids but it also include elapsed time to the end
 // of each edge. We will need to use the existing costing method to form the elapsed time
 // the path. We will start with just using edge costs and will add transition costs.
-std::vector<std::tuple<float, float, std::vector<thor::MatchResult>, odin::TripPath>>
+std::vector<std::tuple<float, float, std::vector<thor::MatchResult>, odin::TripPath*>>
 thor_worker_t::map_match(valhalla_request_t& request,
                          const AttributesController& controller,
                          uint32_t best_paths) {
-  std::vector<std::tuple<float, float, std::vector<thor::MatchResult>, odin::TripPath>>
+  std::vector<std::tuple<float, float, std::vector<thor::MatchResult>, odin::TripPath*>>
       map_match_results;
 
   // Call Meili for map matching to get a collection of Location Edges
@@ -156,7 +157,7 @@ thor_worker_t::map_match(valhalla_request_t& request,
     const auto& match_results = result.results;
     const auto& edge_segments = result.segments;
     std::vector<thor::MatchResult> enhanced_match_results;
-    odin::TripPath trip_path;
+    odin::TripPath* trip_path = nullptr;
     std::unordered_map<size_t, std::pair<RouteDiscontinuity, RouteDiscontinuity>>
         route_discontinuities;
 
@@ -177,6 +178,9 @@ thor_worker_t::map_match(valhalla_request_t& request,
     if (request.options.action() == odin::DirectionsOptions::trace_route &&
         request.options.format() == odin::DirectionsOptions::osrm) {
       const GraphTile* tile = nullptr;
+      // consecutive match results usually lie on the same edge, decode each
+      // unique edge's name list only once
+      std::unordered_map<uint64_t, std::vector<std::string>> interned_names;
       for (int i = 0; i < match_results.size(); ++i) {
         // Get the match
         const auto& match = match_results[i];
@@ -189,7 +193,13 @@ thor_worker_t::map_match(valhalla_request_t& request,
         auto* pe = request.options.mutable_shape(i)->mutable_path_edges()->Add();
         pe->mutable_ll()->set_lat(match.lnglat.lat());
         pe->mutable_ll()->set_lng(match.lnglat.lng());
-        for (const auto& n : reader->edgeinfo(match.edgeid).GetNames()) {
+        auto interned = interned_names.find(match.edgeid.value);
+        if (interned == interned_names.end()) {
+          interned = interned_names
+                         .emplace(match.edgeid.value, reader->edgeinfo(match.edgeid).GetNames())
+                         .first;
+        }
+        for (const auto& n : interned->second) {
           pe->mutable_names()->Add()->assign(n);
         }
 
@@ -449,7 +459,7 @@ thor_worker_t::map_match(valhalla_request_t& request,
       trip_path =
           thor::TripPathBuilder::Build(controller, matcher->graphreader(), mode_costing, path_edges,
                                        origin, destination, std::list<odin::Location>{}, interrupt,
-                                       &route_discontinuities);
+                                       &route_discontinuities, &arena);
     } else {
       throw valhalla_exception_t{442};
     }
@@ -140,22 +140,22 @@ void AssignAdmins(const AttributesController& controller,
       TripPath_Admin* trip_admin = trip_path.add_admin();
 
       // Set country code if requested
-      if (controller.attributes.at(kAdminCountryCode)) {
+      if (controller(kAdminCountryCode)) {
         trip_admin->set_country_code(admin_info.country_iso());
       }
 
       // Set country text if requested
-      if (controller.attributes.at(kAdminCountryText)) {
+      if (controller(kAdminCountryText)) {
         trip_admin->set_country_text(admin_info.country_text());
       }
 
       // Set state code if requested
-      if (controller.attributes.at(kAdminStateCode)) {
+      if (controller(kAdminStateCode)) {
         trip_admin->set_state_code(admin_info.state_iso());
       }
 
       // Set state text if requested
-      if (controller.attributes.at(kAdminStateText)) {
+      if (controller(kAdminStateText)) {
         trip_admin->set_state_text(admin_info.state_text());
       }
     }
@@ -427,13 +427,13 @@ void SetHeadings(TripPath_Edge* trip_edge,
                  const DirectedEdge* edge,
                  const std::vector<PointLL>& shape,
                  const uint32_t begin_index) {
-  if (controller.attributes.at(kEdgeBeginHeading) || controller.attributes.at(kEdgeEndHeading)) {
+  if (controller(kEdgeBeginHeading) || controller(kEdgeEndHeading)) {
     float offset = GetOffsetForHeading(edge->classification(), edge->use());
-    if (controller.attributes.at(kEdgeBeginHeading)) {
+    if (controller(kEdgeBeginHeading)) {
       trip_edge->set_begin_heading(
           std::round(PointLL::HeadingAlongPolyline(shape, offset, begin_index, shape.size() - 1)));
     }
-    if (controller.attributes.at(kEdgeEndHeading)) {
+    if (controller(kEdgeEndHeading)) {
       trip_edge->set_end_heading(
           std::round(PointLL::HeadingAtEndOfPolyline(shape, offset, begin_index, shape.size() - 1)));
     }
@@ -465,20 +465,20 @@ void AddTransitNodes(TripPath_Node* trip_node,
 
     if (transit_station) {
       // Set onstop_id if requested
-      if (controller.attributes.at(kNodeTransitStationInfoOnestopId) &&
+      if (controller(kNodeTransitStationInfoOnestopId) &&
           transit_station->one_stop_offset()) {
         transit_station_info->set_onestop_id(graphtile->GetName(transit_station->one_stop_offset()));
       }
 
       // Set name if requested
-      if (controller.attributes.at(kNodeTransitStationInfoName) && transit_station->name_offset()) {
+      if (controller(kNodeTransitStationInfoName) && transit_station->name_offset()) {
         transit_station_info->set_name(graphtile->GetName(transit_station->name_offset()));
       }
 
       // Set latitude and longitude
       odin::LatLng* stop_ll = transit_station_info->mutable_ll();
       // Set transit stop lat/lon if requested
-      if (controller.attributes.at(kNodeTransitStationInfoLatLon)) {
+      if (controller(kNodeTransitStationInfoLatLon)) {
         PointLL ll = node->latlng(start_tile->header()->base_ll());
         stop_ll->set_lat(ll.lat());
         stop_ll->set_lng(ll.lng());
@@ -493,20 +493,20 @@ void AddTransitNodes(TripPath_Node* trip_node,
 
     if (transit_egress) {
       // Set onstop_id if requested
-      if (controller.attributes.at(kNodeTransitEgressInfoOnestopId) &&
+      if (controller(kNodeTransitEgressInfoOnestopId) &&
           transit_egress->one_stop_offset()) {
         transit_egress_info->set_onestop_id(graphtile->GetName(transit_egress->one_stop_offset()));
       }
 
       // Set name if requested
-      if (controller.attributes.at(kNodeTransitEgressInfoName) && transit_egress->name_offset()) {
+      if (controller(kNodeTransitEgressInfoName) && transit_egress->name_offset()) {
         transit_egress_info->set_name(graphtile->GetName(transit_egress->name_offset()));
       }
 
       // Set latitude and longitude
       odin::LatLng* stop_ll = transit_egress_info->mutable_ll();
       // Set transit stop lat/lon if requested
-      if (controller.attributes.at(kNodeTransitEgressInfoLatLon)) {
+      if (controller(kNodeTransitEgressInfoLatLon)) {
         PointLL ll = node->latlng(start_tile->header()->base_ll());
         stop_ll->set_lat(ll.lat());
         stop_ll->set_lng(ll.lng());
@@ -529,7 +529,7 @@ TripPathBuilder::~TripPathBuilder() {
 // For now just find the length of the path!
 // TODO - probably need the location information passed in - to
 // add to the TripPath
-TripPath
+TripPath*
 TripPathBuilder::Build(const AttributesController& controller,
                        GraphReader& graphreader,
                        const std::shared_ptr<sif::DynamicCost>* mode_costing,
@@ -539,14 +539,18 @@ TripPathBuilder::Build(const AttributesController& controller,
                        const std::list<odin::Location>& through_loc,
                        const std::function<void()>* interrupt_callback,
                        std::unordered_map<size_t, std::pair<RouteDiscontinuity, RouteDiscontinuity>>*
-                           route_discontinuities) {
+                           route_discontinuities,
+                       google::protobuf::Arena* arena) {
   // Test interrupt prior to building trip path
   if (interrupt_callback) {
     (*interrupt_callback)();
   }
 
-  // TripPath is a protocol buffer that contains information about the trip
-  TripPath trip_path;
+  // TripPath is a protocol buffer that contains information about the trip.
+  // Build it on the arena when one is provided so the thousands of nested
+  // messages in a long leg do not hit the allocator one by one
+  TripPath* trip_path_ptr = google::protobuf::Arena::CreateMessage<TripPath>(arena);
+  TripPath& trip_path = *trip_path_ptr;
 
   // Set origin, any through locations, and destination. Origin and
   // destination are assumed to be breaks.
@@ -631,7 +635,7 @@ TripPathBuilder::Build(const AttributesController& controller,
 
     // Get the shape. Reverse if the directed edge direction does
     // not match the traversal direction (based on start and end percent).
-    auto shape = tile->edgeinfo(edge->edgeinfo_offset()).shape();
+    auto shape = graphreader.edgeshape(tile, edge);
     if (edge->forward() != (start_pct < end_pct)) {
       std::reverse(shape.begin(), shape.end());
     }
@@ -672,11 +676,11 @@ TripPathBuilder::Build(const AttributesController& controller,
                     trip_path.add_node(), tile, current_time, std::abs(end_pct - start_pct));
 
     // Set begin shape index if requested
-    if (controller.attributes.at(kEdgeBeginShapeIndex)) {
+    if (controller(kEdgeBeginShapeIndex)) {
       trip_edge->set_begin_shape_index(0);
     }
     // Set end shape index if requested
-    if (controller.attributes.at(kEdgeEndShapeIndex)) {
+    if (controller(kEdgeEndShapeIndex)) {
       trip_edge->set_end_shape_index(shape.size() - 1);
     }
 
@@ -685,17 +689,17 @@ TripPathBuilder::Build(const AttributesController& controller,
     SetHeadings(trip_edge, controller, edge, shape, 0);
 
     auto* node = trip_path.add_node();
-    if (controller.attributes.at(kNodeElapsedTime)) {
+    if (controller(kNodeElapsedTime)) {
       node->set_elapsed_time(path.front().elapsed_time);
     }
 
     const GraphTile* end_tile = graphreader.GetGraphTile(edge->endnode());
     if (end_tile == nullptr) {
-      if (controller.attributes.at(kNodeaAdminIndex)) {
+      if (controller(kNodeaAdminIndex)) {
         node->set_admin_index(0);
       }
     } else {
-      if (controller.attributes.at(kNodeaAdminIndex)) {
+      if (controller(kNodeaAdminIndex)) {
         node->set_admin_index(
             GetAdminIndex(end_tile->admininfo(end_tile->node(edge->endnode())->admin_index()),
                           admin_info_map, admin_info_list));
@@ -743,17 +747,17 @@ TripPathBuilder::Build(const AttributesController& controller,
     SetBoundingBox(trip_path, shape);
 
     // Set shape if requested
-    if (controller.attributes.at(kShape)) {
+    if (controller(kShape)) {
       trip_path.set_shape(encode<std::vector<PointLL>>(shape));
     }
 
-    if (controller.attributes.at(kOsmChangeset)) {
+    if (controller(kOsmChangeset)) {
       trip_path.set_osm_changeset(tile->header()->dataset_id());
     }
 
     // Assign the trip path admins
     AssignAdmins(controller, trip_path, admin_info_list);
-    return trip_path;
+    return trip_path_ptr;
   }
 
   // Iterate through path
@@ -761,20 +765,50 @@ TripPathBuilder::Build(const AttributesController& controller,
   uint32_t elapsedtime = 0;
   uint32_t block_id = 0;
   uint32_t prior_opp_local_index = -1;
-  std::vector<PointLL> trip_shape;
+  // Reuse the shape buffer across requests - clearing keeps its capacity so
+  // only the longest route this thread has seen pays for growth
+  static thread_local std::vector<PointLL> trip_shape;
+  trip_shape.clear();
+
+  // Resolve every path edge's tile and directed edge record up front.
+  // Consecutive path edges nearly always share a tile, so this pass walks
+  // each tile's directed edge array in order and the loops below get their
+  // records without a tile lookup per edge
+  static thread_local std::vector<std::pair<const GraphTile*, const DirectedEdge*>> path_records;
+  path_records.clear();
+  path_records.reserve(path.size());
+  {
+    const GraphTile* tile = nullptr;
+    for (const auto& path_edge : path) {
+      graphreader.GetGraphTile(path_edge.edgeid, tile);
+      path_records.emplace_back(tile, tile->directededge(path_edge.edgeid));
+    }
+  }
+
+  // Reserve from the encoded shape sizes: a varint encoded point takes at
+  // least two bytes so half the encoded bytes bounds the point count
+  size_t encoded_shape_bytes = 0;
+  for (const auto& record : path_records) {
+    encoded_shape_bytes +=
+        record.first->edgeinfo(record.second->edgeinfo_offset()).encoded_shape_size();
+  }
+  trip_shape.reserve(encoded_shape_bytes / 2);
   std::string arrival_time;
   bool assumed_schedule = false;
   sif::TravelMode prev_mode = sif::TravelMode::kPedestrian;
   uint64_t osmchangeset = 0;
   size_t edge_index = 0;
   const DirectedEdge* prev_de = nullptr;
+  // Last trip admin index assigned - between flagged admin crossings it can
+  // be reused without building another AdminInfo to hash
+  uint32_t last_admin_index = 0;
   // TODO: this is temp until we use transit stop type from transitland
   TransitPlatformInfo_Type prev_transit_node_type = TransitPlatformInfo_Type_kStop;
   for (auto edge_itr = path.begin(); edge_itr != path.end(); ++edge_itr, ++edge_index) {
     const GraphId& edge = edge_itr->edgeid;
     const uint32_t trip_id = edge_itr->trip_id;
-    const GraphTile* graphtile = graphreader.GetGraphTile(edge);
-    const DirectedEdge* directededge = graphtile->directededge(edge);
+    const GraphTile* graphtile = path_records[edge_index].first;
+    const DirectedEdge* directededge = path_records[edge_index].second;
     const sif::TravelMode mode = edge_itr->mode;
     const uint8_t travel_type = travel_types[static_cast<uint32_t>(mode)];
 
@@ -785,16 +819,16 @@ TripPathBuilder::Build(const AttributesController& controller,
     const GraphTile* start_tile = graphreader.GetGraphTile(startnode);
     const NodeInfo* node = start_tile->node(startnode);
 
-    if (osmchangeset == 0 && controller.attributes.at(kOsmChangeset)) {
+    if (osmchangeset == 0 && controller(kOsmChangeset)) {
       osmchangeset = start_tile->header()->dataset_id();
     }
 
-    if (controller.attributes.at(kNodeType)) {
+    if (controller(kNodeType)) {
       trip_node->set_type(GetTripPathNodeType(node->type()));
     }
 
     if (node->intersection() == IntersectionType::kFork) {
-      if (controller.attributes.at(kNodeFork)) {
+      if (controller(kNodeFork)) {
         trip_node->set_fork(true);
       }
     }
@@ -806,17 +840,25 @@ TripPathBuilder::Build(const AttributesController& controller,
     }
 
     // Assign the elapsed time from the start of the leg
-    if (controller.attributes.at(kNodeElapsedTime)) {
+    if (controller(kNodeElapsedTime)) {
       trip_node->set_elapsed_time(elapsedtime);
     }
 
-    // Assign the admin index
-    if (controller.attributes.at(kNodeaAdminIndex)) {
-      trip_node->set_admin_index(
-          GetAdminIndex(start_tile->admininfo(node->admin_index()), admin_info_map, admin_info_list));
+    // Assign the admin index. The edge arriving here carries build time
+    // admin crossing flags - when it crossed no country or state line the
+    // admin is the one already assigned at the previous node
+    if (controller(kNodeaAdminIndex)) {
+      if (prev_de != nullptr && !prev_de->ctry_crossing() && !prev_de->st_crossing() &&
+          start_tile->header()->has_admin_crossings()) {
+        trip_node->set_admin_index(last_admin_index);
+      } else {
+        last_admin_index = GetAdminIndex(start_tile->admininfo(node->admin_index()), admin_info_map,
+                                         admin_info_list);
+        trip_node->set_admin_index(last_admin_index);
+      }
     }
 
-    if (controller.attributes.at(kNodeTimeZone)) {
+    if (controller(kNodeTimeZone)) {
       auto tz = DateTime::get_tz_db().from_index(node->timezone());
       if (tz) {
         trip_node->set_time_zone(tz->name());
@@ -839,18 +881,18 @@ TripPathBuilder::Build(const AttributesController& controller,
       // Set type
       if (directededge->use() == Use::kRail) {
         // Set node transit info type if requested
-        if (controller.attributes.at(kNodeTransitPlatformInfoType)) {
+        if (controller(kNodeTransitPlatformInfoType)) {
           transit_platform_info->set_type(TransitPlatformInfo_Type_kStation);
         }
         prev_transit_node_type = TransitPlatformInfo_Type_kStation;
       } else if (directededge->use() == Use::kPlatformConnection) {
         // Set node transit info type if requested
-        if (controller.attributes.at(kNodeTransitPlatformInfoType)) {
+        if (controller(kNodeTransitPlatformInfoType)) {
           transit_platform_info->set_type(prev_transit_node_type);
         }
       } else { // bus logic
         // Set node transit info type if requested
-        if (controller.attributes.at(kNodeTransitPlatformInfoType)) {
+        if (controller(kNodeTransitPlatformInfoType)) {
           transit_platform_info->set_type(TransitPlatformInfo_Type_kStop);
         }
         prev_transit_node_type = TransitPlatformInfo_Type_kStop;
@@ -858,14 +900,14 @@ TripPathBuilder::Build(const AttributesController& controller,
 
       if (transit_platform) {
         // Set onstop_id if requested
-        if (controller.attributes.at(kNodeTransitPlatformInfoOnestopId) &&
+        if (controller(kNodeTransitPlatformInfoOnestopId) &&
             transit_platform->one_stop_offset()) {
           transit_platform_info->set_onestop_id(
               graphtile->GetName(transit_platform->one_stop_offset()));
         }
 
         // Set name if requested
-        if (controller.attributes.at(kNodeTransitPlatformInfoName) &&
+        if (controller(kNodeTransitPlatformInfoName) &&
             transit_platform->name_offset()) {
           transit_platform_info->set_name(graphtile->GetName(transit_platform->name_offset()));
         }
@@ -881,14 +923,14 @@ TripPathBuilder::Build(const AttributesController& controller,
             const TransitStop* transit_station = endtile->GetTransitStop(nodeinfo2->stop_index());
 
             // Set station onstop_id if requested
-            if (controller.attributes.at(kNodeTransitPlatformInfoStationOnestopId) &&
+            if (controller(kNodeTransitPlatformInfoStationOnestopId) &&
                 transit_station->one_stop_offset()) {
               transit_platform_info->set_station_onestop_id(
                   endtile->GetName(transit_station->one_stop_offset()));
             }
 
             // Set station name if requested
-            if (controller.attributes.at(kNodeTransitPlatformInfoStationName) &&
+            if (controller(kNodeTransitPlatformInfoStationName) &&
                 transit_station->name_offset()) {
               transit_platform_info->set_station_name(
                   endtile->GetName(transit_station->name_offset()));
@@ -902,7 +944,7 @@ TripPathBuilder::Build(const AttributesController& controller,
         // Set latitude and longitude
         odin::LatLng* stop_ll = transit_platform_info->mutable_ll();
         // Set transit stop lat/lon if requested
-        if (controller.attributes.at(kNodeTransitPlatformInfoLatLon)) {
+        if (controller(kNodeTransitPlatformInfoLatLon)) {
           PointLL ll = node->latlng(start_tile->header()->base_ll());
           stop_ll->set_lat(ll.lat());
           stop_ll->set_lng(ll.lng());
@@ -911,7 +953,7 @@ TripPathBuilder::Build(const AttributesController& controller,
 
       // Set the arrival time at this node (based on schedule from last trip
       // departure) if requested
-      if (controller.attributes.at(kNodeTransitPlatformInfoArrivalDateTime) &&
+      if (controller(kNodeTransitPlatformInfoArrivalDateTime) &&
           !arrival_time.empty()) {
         transit_platform_info->set_arrival_date_time(arrival_time);
       }
@@ -930,7 +972,7 @@ TripPathBuilder::Build(const AttributesController& controller,
 
           if (graphtile->header()->date_created() > date) {
             // Set assumed schedule if requested
-            if (controller.attributes.at(kNodeTransitPlatformInfoAssumedSchedule)) {
+            if (controller(kNodeTransitPlatformInfoAssumedSchedule)) {
               transit_platform_info->set_assumed_schedule(true);
             }
             assumed_schedule = true;
@@ -938,7 +980,7 @@ TripPathBuilder::Build(const AttributesController& controller,
             day = date - graphtile->header()->date_created();
             if (day > graphtile->GetTransitSchedule(transit_departure->schedule_index())->end_day()) {
               // Set assumed schedule if requested
-              if (controller.attributes.at(kNodeTransitPlatformInfoAssumedSchedule)) {
+              if (controller(kNodeTransitPlatformInfoAssumedSchedule)) {
                 transit_platform_info->set_assumed_schedule(true);
               }
               assumed_schedule = true;
@@ -959,7 +1001,7 @@ TripPathBuilder::Build(const AttributesController& controller,
           }
 
           // Set departure time from this transit stop if requested
-          if (controller.attributes.at(kNodeTransitPlatformInfoDepartureDateTime)) {
+          if (controller(kNodeTransitPlatformInfoDepartureDateTime)) {
             transit_platform_info->set_departure_date_time(dt);
           }
 
@@ -989,7 +1031,7 @@ TripPathBuilder::Build(const AttributesController& controller,
         block_id = 0;
 
         // Set assumed schedule if requested
-        if (controller.attributes.at(kNodeTransitPlatformInfoAssumedSchedule) && assumed_schedule) {
+        if (controller(kNodeTransitPlatformInfoAssumedSchedule) && assumed_schedule) {
           transit_platform_info->set_assumed_schedule(true);
         }
         assumed_schedule = false;
@@ -1003,6 +1045,13 @@ TripPathBuilder::Build(const AttributesController& controller,
         AddTripEdge(controller, edge, trip_id, block_id, mode, travel_type, directededge,
                     node->drive_on_right(), trip_node, graphtile, current_time, length_pct);
 
+    // The enhancer already compared this edge's names against the arriving
+    // edge's, so odin can test a bit instead of intersecting name sets
+    if (controller(kEdgeNameConsistency)) {
+      trip_edge->set_name_consistency(prev_de != nullptr &&
+                                      prev_de->name_consistency(directededge->localedgeidx()));
+    }
+
     // Get the shape and set shape indexes (directed edge forward flag
     // determines whether shape is traversed forward or reverse).
     auto edgeinfo = graphtile->edgeinfo(directededge->edgeinfo_offset());
@@ -1012,7 +1061,7 @@ TripPathBuilder::Build(const AttributesController& controller,
     if (route_discontinuities && !route_discontinuities->empty() &&
         route_discontinuities->count(edge_index) > 0) {
       // Get edge shape
-      auto edge_shape = edgeinfo.shape();
+      auto edge_shape = graphreader.edgeshape(graphtile, directededge);
 
       // Reverse edge shape if directed edge is not forward
       if (!directededge->forward()) {
@@ -1060,14 +1109,18 @@ TripPathBuilder::Build(const AttributesController& controller,
       // is not full length
       float length = std::max(static_cast<float>(directededge->length()) * length_pct, 1.0f);
       if (directededge->forward() == is_last_edge) {
-        AddPartialShape<std::vector<PointLL>::const_iterator>(trip_shape, edgeinfo.shape().begin(),
-                                                              edgeinfo.shape().end(), length,
-                                                              is_last_edge,
+        // only the leading piece of the shape is kept so the decode can stop
+        // once it has covered the partial length
+        auto partial = edgeinfo.shape_head(length);
+        AddPartialShape<std::vector<PointLL>::const_iterator>(trip_shape, partial.begin(),
+                                                              partial.end(), length, is_last_edge,
                                                               is_last_edge ? end_vrt : start_vrt);
       } else {
-        AddPartialShape<std::vector<PointLL>::const_reverse_iterator>(trip_shape,
-                                                                      edgeinfo.shape().rbegin(),
-                                                                      edgeinfo.shape().rend(), length,
+        // only the trailing piece is kept; when the tile has a shape index
+        // the decode skips everything before the last needed checkpoint
+        auto partial = edgeinfo.shape_tail(length);
+        AddPartialShape<std::vector<PointLL>::const_reverse_iterator>(trip_shape, partial.rbegin(),
+                                                                      partial.rend(), length,
                                                                       is_last_edge,
                                                                       is_last_edge ? end_vrt
                                                                                    : start_vrt);
@@ -1082,12 +1135,12 @@ TripPathBuilder::Build(const AttributesController& controller,
     }
 
     // Set begin shape index if requested
-    if (controller.attributes.at(kEdgeBeginShapeIndex)) {
+    if (controller(kEdgeBeginShapeIndex)) {
       trip_edge->set_begin_shape_index(begin_index);
     }
 
     // Set end shape index if requested
-    if (controller.attributes.at(kEdgeEndShapeIndex)) {
+    if (controller(kEdgeEndShapeIndex)) {
       trip_edge->set_end_shape_index(trip_shape.size() - 1);
     }
 
@@ -1229,14 +1282,20 @@ TripPathBuilder::Build(const AttributesController& controller,
     tp_orig->set_date_time(origin_date);
   }
 
-  // Add the last node
+  // Add the last node. The final edge's crossing flags tell whether its
+  // admin differs from the node before it
   auto* node = trip_path.add_node();
-  if (controller.attributes.at(kNodeaAdminIndex)) {
-    node->set_admin_index(
-        GetAdminIndex(last_tile->admininfo(last_tile->node(startnode)->admin_index()), admin_info_map,
-                      admin_info_list));
+  if (controller(kNodeaAdminIndex)) {
+    if (prev_de != nullptr && !prev_de->ctry_crossing() && !prev_de->st_crossing() &&
+        last_tile->header()->has_admin_crossings()) {
+      node->set_admin_index(last_admin_index);
+    } else {
+      node->set_admin_index(
+          GetAdminIndex(last_tile->admininfo(last_tile->node(startnode)->admin_index()),
+                        admin_info_map, admin_info_list));
+    }
   }
-  if (controller.attributes.at(kNodeElapsedTime)) {
+  if (controller(kNodeElapsedTime)) {
     node->set_elapsed_time(elapsedtime);
   }
 
@@ -1247,16 +1306,16 @@ TripPathBuilder::Build(const AttributesController& controller,
   SetBoundingBox(trip_path, trip_shape);
 
   // Set shape if requested
-  if (controller.attributes.at(kShape)) {
+  if (controller(kShape)) {
     trip_path.set_shape(encode<std::vector<PointLL>>(trip_shape));
   }
 
-  if (osmchangeset != 0 && controller.attributes.at(kOsmChangeset)) {
+  if (osmchangeset != 0 && controller(kOsmChangeset)) {
     trip_path.set_osm_changeset(osmchangeset);
   }
 
   // hand it back
-  return trip_path;
+  return trip_path_ptr;
 } // namespace thor
 
 // Add a trip edge to the trip node and set its attributes
@@ -1281,9 +1340,10 @@ TripPath_Edge* TripPathBuilder::AddTripEdge(const AttributesController& controll
   // Get the edgeinfo
   auto edgeinfo = graphtile->edgeinfo(directededge->edgeinfo_offset());
 
-  // Add names to edge if requested
-  if (controller.attributes.at(kEdgeNames)) {
-    auto names_and_types = edgeinfo.GetNamesAndTypes();
+  // Add names to edge if requested. The names go straight from the tile's
+  // text list into the message without an intermediate string per name
+  if (controller(kEdgeNames)) {
+    auto names_and_types = edgeinfo.GetNamePointersAndTypes();
     for (const auto& name_and_type : names_and_types) {
       auto* trip_edge_name = trip_edge->mutable_name()->Add();
       trip_edge_name->set_value(name_and_type.first);
@@ -1303,7 +1363,7 @@ TripPath_Edge* TripPathBuilder::AddTripEdge(const AttributesController& controll
       for (const auto& sign : signs) {
         switch (sign.type()) {
           case Sign::Type::kExitNumber: {
-            if (controller.attributes.at(kEdgeSignExitNumber)) {
+            if (controller(kEdgeSignExitNumber)) {
               auto* trip_exit_number = trip_exit->mutable_exit_numbers()->Add();
               trip_exit_number->set_text(sign.text());
               trip_exit_number->set_is_route_number(sign.is_route_num());
@@ -1311,7 +1371,7 @@ TripPath_Edge* TripPathBuilder::AddTripEdge(const AttributesController& controll
             break;
           }
           case Sign::Type::kExitBranch: {
-            if (controller.attributes.at(kEdgeSignExitBranch)) {
+            if (controller(kEdgeSignExitBranch)) {
               auto* trip_exit_onto_street = trip_exit->mutable_exit_onto_streets()->Add();
               trip_exit_onto_street->set_text(sign.text());
               trip_exit_onto_street->set_is_route_number(sign.is_route_num());
@@ -1319,7 +1379,7 @@ TripPath_Edge* TripPathBuilder::AddTripEdge(const AttributesController& controll
             break;
           }
           case Sign::Type::kExitToward: {
-            if (controller.attributes.at(kEdgeSignExitToward)) {
+            if (controller(kEdgeSignExitToward)) {
               auto* trip_exit_toward_location = trip_exit->mutable_exit_toward_locations()->Add();
               trip_exit_toward_location->set_text(sign.text());
               trip_exit_toward_location->set_is_route_number(sign.is_route_num());
@@ -1327,7 +1387,7 @@ TripPath_Edge* TripPathBuilder::AddTripEdge(const AttributesController& controll
             break;
           }
           case Sign::Type::kExitName: {
-            if (controller.attributes.at(kEdgeSignExitName)) {
+            if (controller(kEdgeSignExitName)) {
               auto* trip_exit_name = trip_exit->mutable_exit_names()->Add();
               trip_exit_name->set_text(sign.text());
               trip_exit_name->set_is_route_number(sign.is_route_num());
@@ -1346,18 +1406,18 @@ TripPath_Edge* TripPathBuilder::AddTripEdge(const AttributesController& controll
   }
 
   // Set road class if requested
-  if (controller.attributes.at(kEdgeRoadClass)) {
+  if (controller(kEdgeRoadClass)) {
     trip_edge->set_road_class(GetTripPathRoadClass(directededge->classification()));
   }
 
   // Set length if requested. Convert to km
-  if (controller.attributes.at(kEdgeLength)) {
+  if (controller(kEdgeLength)) {
     float km = std::max((directededge->length() * 0.001f * length_percentage), 0.001f);
     trip_edge->set_length(km);
   }
 
   // Set speed if requested
-  if (controller.attributes.at(kEdgeSpeed)) {
+  if (controller(kEdgeSpeed)) {
     trip_edge->set_speed(graphtile->GetSpeed(directededge));
   }
 
@@ -1373,7 +1433,7 @@ TripPath_Edge* TripPathBuilder::AddTripEdge(const AttributesController& controll
   // Test whether edge is traversed forward or reverse
   if (directededge->forward()) {
     // Set traversability for forward directededge if requested
-    if (controller.attributes.at(kEdgeTraversability)) {
+    if (controller(kEdgeTraversability)) {
       if ((directededge->forwardaccess() & kAccess) && (directededge->reverseaccess() & kAccess)) {
         trip_edge->set_traversability(TripPath_Traversability::TripPath_Traversability_kBoth);
       } else if ((directededge->forwardaccess() & kAccess) &&
@@ -1388,7 +1448,7 @@ TripPath_Edge* TripPathBuilder::AddTripEdge(const AttributesController& controll
     }
   } else {
     // Set traversability for reverse directededge if requested
-    if (controller.attributes.at(kEdgeTraversability)) {
+    if (controller(kEdgeTraversability)) {
       if ((directededge->forwardaccess() & kAccess) && (directededge->reverseaccess() & kAccess)) {
         trip_edge->set_traversability(TripPath_Traversability::TripPath_Traversability_kBoth);
       } else if (!(directededge->forwardaccess() & kAccess) &&
@@ -1404,47 +1464,47 @@ TripPath_Edge* TripPathBuilder::AddTripEdge(const AttributesController& controll
   }
 
   // Set the trip path use based on directed edge use if requested
-  if (controller.attributes.at(kEdgeUse)) {
+  if (controller(kEdgeUse)) {
     trip_edge->set_use(GetTripPathUse(directededge->use()));
   }
 
   // Set toll flag if requested
-  if (directededge->toll() && controller.attributes.at(kEdgeToll)) {
+  if (directededge->toll() && controller(kEdgeToll)) {
     trip_edge->set_toll(true);
   }
 
   // Set unpaved flag if requested
-  if (directededge->unpaved() && controller.attributes.at(kEdgeUnpaved)) {
+  if (directededge->unpaved() && controller(kEdgeUnpaved)) {
     trip_edge->set_unpaved(true);
   }
 
   // Set tunnel flag if requested
-  if (directededge->tunnel() && controller.attributes.at(kEdgeTunnel)) {
+  if (directededge->tunnel() && controller(kEdgeTunnel)) {
     trip_edge->set_tunnel(true);
   }
 
   // Set bridge flag if requested
-  if (directededge->bridge() && controller.attributes.at(kEdgeBridge)) {
+  if (directededge->bridge() && controller(kEdgeBridge)) {
     trip_edge->set_bridge(true);
   }
 
   // Set roundabout flag if requested
-  if (directededge->roundabout() && controller.attributes.at(kEdgeRoundabout)) {
+  if (directededge->roundabout() && controller(kEdgeRoundabout)) {
     trip_edge->set_roundabout(true);
   }
 
   // Set internal intersection flag if requested
-  if (directededge->internal() && controller.attributes.at(kEdgeInternalIntersection)) {
+  if (directededge->internal() && controller(kEdgeInternalIntersection)) {
     trip_edge->set_internal_intersection(true);
   }
 
   // Set drive_on_right if requested
-  if (controller.attributes.at(kEdgeDriveOnRight)) {
+  if (controller(kEdgeDriveOnRight)) {
     trip_edge->set_drive_on_right(drive_on_right);
   }
 
   // Set surface if requested
-  if (controller.attributes.at(kEdgeSurface)) {
+  if (controller(kEdgeSurface)) {
     trip_edge->set_surface(GetTripPathSurface(directededge->surface()));
   }
 
@@ -1452,64 +1512,64 @@ TripPath_Edge* TripPathBuilder::AddTripEdge(const AttributesController& controll
   if (mode == sif::TravelMode::kBicycle) {
     // Override bicycle mode with pedestrian if dismount flag or steps
     if (directededge->dismount() || directededge->use() == Use::kSteps) {
-      if (controller.attributes.at(kEdgeTravelMode)) {
+      if (controller(kEdgeTravelMode)) {
         trip_edge->set_travel_mode(TripPath_TravelMode::TripPath_TravelMode_kPedestrian);
       }
-      if (controller.attributes.at(kEdgePedestrianType)) {
+      if (controller(kEdgePedestrianType)) {
         trip_edge->set_pedestrian_type(odin::TripPath_PedestrianType::TripPath_PedestrianType_kFoot);
       }
     } else {
-      if (controller.attributes.at(kEdgeTravelMode)) {
+      if (controller(kEdgeTravelMode)) {
         trip_edge->set_travel_mode(TripPath_TravelMode::TripPath_TravelMode_kBicycle);
       }
-      if (controller.attributes.at(kEdgeBicycleType)) {
+      if (controller(kEdgeBicycleType)) {
         trip_edge->set_bicycle_type(GetTripPathBicycleType(travel_type));
       }
     }
   } else if (mode == sif::TravelMode::kDrive) {
-    if (controller.attributes.at(kEdgeTravelMode)) {
+    if (controller(kEdgeTravelMode)) {
       trip_edge->set_travel_mode(TripPath_TravelMode::TripPath_TravelMode_kDrive);
     }
-    if (controller.attributes.at(kEdgeVehicleType)) {
+    if (controller(kEdgeVehicleType)) {
       trip_edge->set_vehicle_type(GetTripPathVehicleType(travel_type));
     }
   } else if (mode == sif::TravelMode::kPedestrian) {
-    if (controller.attributes.at(kEdgeTravelMode)) {
+    if (controller(kEdgeTravelMode)) {
       trip_edge->set_travel_mode(TripPath_TravelMode::TripPath_TravelMode_kPedestrian);
     }
-    if (controller.attributes.at(kEdgePedestrianType)) {
+    if (controller(kEdgePedestrianType)) {
       trip_edge->set_pedestrian_type(GetTripPathPedestrianType(travel_type));
     }
   } else if (mode == sif::TravelMode::kPublicTransit) {
-    if (controller.attributes.at(kEdgeTravelMode)) {
+    if (controller(kEdgeTravelMode)) {
       trip_edge->set_travel_mode(TripPath_TravelMode::TripPath_TravelMode_kTransit);
     }
   }
 
   // Set edge id (graphid value) if requested
-  if (controller.attributes.at(kEdgeId)) {
+  if (controller(kEdgeId)) {
     trip_edge->set_id(edge.value);
   }
 
   // Set way id (base data id) if requested
-  if (controller.attributes.at(kEdgeWayId)) {
+  if (controller(kEdgeWayId)) {
     trip_edge->set_way_id(edgeinfo.wayid());
   }
 
   // Set weighted grade if requested
-  if (controller.attributes.at(kEdgeWeightedGrade)) {
+  if (controller(kEdgeWeightedGrade)) {
     trip_edge->set_weighted_grade((directededge->weighted_grade() - 6.f) / 0.6f);
   }
 
   // Set maximum upward and downward grade if requested (set to kNoElevationData if unavailable)
-  if (controller.attributes.at(kEdgeMaxUpwardGrade)) {
+  if (controller(kEdgeMaxUpwardGrade)) {
     if (graphtile->header()->has_elevation()) {
       trip_edge->set_max_upward_grade(directededge->max_up_slope());
     } else {
       trip_edge->set_max_upward_grade(kNoElevationData);
     }
   }
-  if (controller.attributes.at(kEdgeMaxDownwardGrade)) {
+  if (controller(kEdgeMaxDownwardGrade)) {
     if (graphtile->header()->has_elevation()) {
       trip_edge->set_max_downward_grade(directededge->max_down_slope());
     } else {
@@ -1518,7 +1578,7 @@ TripPath_Edge* TripPathBuilder::AddTripEdge(const AttributesController& controll
   }
 
   // Set mean elevation if requested (set to kNoElevationData if unavailable)
-  if (controller.attributes.at(kEdgeMeanElevation)) {
+  if (controller(kEdgeMeanElevation)) {
     if (graphtile->header()->has_elevation()) {
       trip_edge->set_mean_elevation(edgeinfo.mean_elevation());
     } else {
@@ -1526,11 +1586,11 @@ TripPath_Edge* TripPathBuilder::AddTripEdge(const AttributesController& controll
     }
   }
 
-  if (controller.attributes.at(kEdgeLaneCount)) {
+  if (controller(kEdgeLaneCount)) {
     trip_edge->set_lane_count(directededge->lanecount());
   }
 
-  if (directededge->laneconnectivity() && controller.attributes.at(kEdgeLaneConnectivity)) {
+  if (directededge->laneconnectivity() && controller(kEdgeLaneConnectivity)) {
     for (const auto& l : graphtile->GetLaneConnectivity(idx)) {
       TripPath_LaneConnectivity* path_lane = trip_edge->add_lane_connectivity();
       path_lane->set_from_way_id(l.from());
@@ -1539,15 +1599,15 @@ TripPath_Edge* TripPathBuilder::AddTripEdge(const AttributesController& controll
     }
   }
 
-  if (directededge->cyclelane() != CycleLane::kNone && controller.attributes.at(kEdgeCycleLane)) {
+  if (directededge->cyclelane() != CycleLane::kNone && controller(kEdgeCycleLane)) {
     trip_edge->set_cycle_lane(GetTripPathCycleLane(directededge->cyclelane()));
   }
 
-  if (controller.attributes.at(kEdgeBicycleNetwork)) {
+  if (controller(kEdgeBicycleNetwork)) {
     trip_edge->set_bicycle_network(directededge->bike_network());
   }
 
-  if (controller.attributes.at(kEdgeSidewalk)) {
+  if (controller(kEdgeSidewalk)) {
     if (directededge->sidewalk_left() && directededge->sidewalk_right()) {
       trip_edge->set_sidewalk(TripPath_Sidewalk::TripPath_Sidewalk_kBothSides);
     } else if (directededge->sidewalk_left()) {
@@ -1557,19 +1617,19 @@ TripPath_Edge* TripPathBuilder::AddTripEdge(const AttributesController& controll
     }
   }
 
-  if (controller.attributes.at(kEdgeDensity)) {
+  if (controller(kEdgeDensity)) {
     trip_edge->set_density(directededge->density());
   }
 
-  if (controller.attributes.at(kEdgeSpeedLimit)) {
+  if (controller(kEdgeSpeedLimit)) {
     trip_edge->set_speed_limit(edgeinfo.speed_limit());
   }
 
-  if (controller.attributes.at(kEdgeTruckSpeed)) {
+  if (controller(kEdgeTruckSpeed)) {
     trip_edge->set_truck_speed(directededge->truck_speed());
   }
 
-  if (directededge->truck_route() && controller.attributes.at(kEdgeTruckRoute)) {
+  if (directededge->truck_route() && controller(kEdgeTruckRoute)) {
     trip_edge->set_truck_route(true);
   }
 
@@ -1580,12 +1640,12 @@ TripPath_Edge* TripPathBuilder::AddTripEdge(const AttributesController& controll
     TripPath_TransitRouteInfo* transit_route_info = trip_edge->mutable_transit_route_info();
 
     // Set block_id if requested
-    if (controller.attributes.at(kEdgeTransitRouteInfoBlockId)) {
+    if (controller(kEdgeTransitRouteInfoBlockId)) {
       transit_route_info->set_block_id(block_id);
     }
 
     // Set trip_id if requested
-    if (controller.attributes.at(kEdgeTransitRouteInfoTripId)) {
+    if (controller(kEdgeTransitRouteInfoTripId)) {
       transit_route_info->set_trip_id(trip_id);
     }
 
@@ -1595,7 +1655,7 @@ TripPath_Edge* TripPathBuilder::AddTripEdge(const AttributesController& controll
     if (transit_departure) {
 
       // Set headsign if requested
-      if (controller.attributes.at(kEdgeTransitRouteInfoHeadsign) &&
+      if (controller(kEdgeTransitRouteInfoHeadsign) &&
           transit_departure->headsign_offset()) {
         transit_route_info->set_headsign(graphtile->GetName(transit_departure->headsign_offset()));
       }
@@ -1604,60 +1664,60 @@ TripPath_Edge* TripPathBuilder::AddTripEdge(const AttributesController& controll
 
       if (transit_route) {
         // Set transit type if requested
-        if (controller.attributes.at(kEdgeTransitType)) {
+        if (controller(kEdgeTransitType)) {
           trip_edge->set_transit_type(GetTripPathTransitType(transit_route->route_type()));
         }
 
         // Set onestop_id if requested
-        if (controller.attributes.at(kEdgeTransitRouteInfoOnestopId) &&
+        if (controller(kEdgeTransitRouteInfoOnestopId) &&
             transit_route->one_stop_offset()) {
           transit_route_info->set_onestop_id(graphtile->GetName(transit_route->one_stop_offset()));
         }
 
         // Set short_name if requested
-        if (controller.attributes.at(kEdgeTransitRouteInfoShortName) &&
+        if (controller(kEdgeTransitRouteInfoShortName) &&
             transit_route->short_name_offset()) {
           transit_route_info->set_short_name(graphtile->GetName(transit_route->short_name_offset()));
         }
 
         // Set long_name if requested
-        if (controller.attributes.at(kEdgeTransitRouteInfoLongName) &&
+        if (controller(kEdgeTransitRouteInfoLongName) &&
             transit_route->long_name_offset()) {
           transit_route_info->set_long_name(graphtile->GetName(transit_route->long_name_offset()));
         }
 
         // Set color if requested
-        if (controller.attributes.at(kEdgeTransitRouteInfoColor)) {
+        if (controller(kEdgeTransitRouteInfoColor)) {
           transit_route_info->set_color(transit_route->route_color());
         }
 
         // Set text_color if requested
-        if (controller.attributes.at(kEdgeTransitRouteInfoTextColor)) {
+        if (controller(kEdgeTransitRouteInfoTextColor)) {
           transit_route_info->set_text_color(transit_route->route_text_color());
         }
 
         // Set description if requested
-        if (controller.attributes.at(kEdgeTransitRouteInfoDescription) &&
+        if (controller(kEdgeTransitRouteInfoDescription) &&
             transit_route->desc_offset()) {
           transit_route_info->set_description(graphtile->GetName(transit_route->desc_offset()));
         }
 
         // Set operator_onestop_id if requested
-        if (controller.attributes.at(kEdgeTransitRouteInfoOperatorOnestopId) &&
+        if (controller(kEdgeTransitRouteInfoOperatorOnestopId) &&
             transit_route->op_by_onestop_id_offset()) {
           transit_route_info->set_operator_onestop_id(
               graphtile->GetName(transit_route->op_by_onestop_id_offset()));
         }
 
         // Set operator_name if requested
-        if (controller.attributes.at(kEdgeTransitRouteInfoOperatorName) &&
+        if (controller(kEdgeTransitRouteInfoOperatorName) &&
             transit_route->op_by_name_offset()) {
           transit_route_info->set_operator_name(
               graphtile->GetName(transit_route->op_by_name_offset()));
         }
 
         // Set operator_url if requested
-        if (controller.attributes.at(kEdgeTransitRouteInfoOperatorUrl) &&
+        if (controller(kEdgeTransitRouteInfoOperatorUrl) &&
             transit_route->op_by_website_offset()) {
           transit_route_info->set_operator_url(
               graphtile->GetName(transit_route->op_by_website_offset()));
@@ -1679,7 +1739,7 @@ void TripPathBuilder::AddTripIntersectingEdge(const AttributesController& contro
   TripPath_IntersectingEdge* itersecting_edge = trip_node->add_intersecting_edge();
 
   // Set the heading for the intersecting edge if requested
-  if (controller.attributes.at(kNodeIntersectingEdgeBeginHeading)) {
+  if (controller(kNodeIntersectingEdgeBeginHeading)) {
     itersecting_edge->set_begin_heading(nodeinfo->heading(local_edge_index));
   }
 
@@ -1696,7 +1756,7 @@ void TripPathBuilder::AddTripIntersectingEdge(const AttributesController& contro
     }
   }
   // Set the walkability flag for the intersecting edge if requested
-  if (controller.attributes.at(kNodeIntersectingEdgeWalkability)) {
+  if (controller(kNodeIntersectingEdgeWalkability)) {
     itersecting_edge->set_walkability(GetTripPathTraversability(traversability));
   }
 
@@ -1711,25 +1771,25 @@ void TripPathBuilder::AddTripIntersectingEdge(const AttributesController& contro
     }
   }
   // Set the cyclability flag for the intersecting edge if requested
-  if (controller.attributes.at(kNodeIntersectingEdgeCyclability)) {
+  if (controller(kNodeIntersectingEdgeCyclability)) {
     itersecting_edge->set_cyclability(GetTripPathTraversability(traversability));
   }
 
   // Set the driveability flag for the intersecting edge if requested
-  if (controller.attributes.at(kNodeIntersectingEdgeDriveability)) {
+  if (controller(kNodeIntersectingEdgeDriveability)) {
     itersecting_edge->set_driveability(
         GetTripPathTraversability(nodeinfo->local_driveability(local_edge_index)));
   }
 
   // Set the previous/intersecting edge name consistency if requested
-  if (controller.attributes.at(kNodeIntersectingEdgeFromEdgeNameConsistency)) {
+  if (controller(kNodeIntersectingEdgeFromEdgeNameConsistency)) {
     bool name_consistency =
         (prev_de == nullptr) ? false : prev_de->name_consistency(local_edge_index);
     itersecting_edge->set_prev_name_consistency(name_consistency);
   }
 
   // Set the current/intersecting edge name consistency if requested
-  if (controller.attributes.at(kNodeIntersectingEdgeToEdgeNameConsistency)) {
+  if (controller(kNodeIntersectingEdgeToEdgeNameConsistency)) {
     itersecting_edge->set_curr_name_consistency(directededge->name_consistency(local_edge_index));
   }
 }
@@ -1,5 +1,7 @@
+#include <atomic>
 #include <cstdint>
 #include <functional>
+#include <memory>
 #include <sstream>
 #include <stdexcept>
 #include <string>
@@ -48,6 +50,32 @@ const std::unordered_map<std::string, float> kMaxDistances = {
 constexpr float kDistanceScale = 10.f;
 constexpr double kMilePerMeter = 0.000621371;
 
+// Heavy requests in flight across all the worker threads of this process.
+// Keeping the count process wide means a burst of batch matrices can take
+// at most max_heavy_requests threads while the rest keep serving
+// interactive routes
+std::atomic<uint32_t> heavy_in_flight(0);
+
+// A slot in the process wide heavy request budget, released when the
+// request finishes no matter how it finishes
+struct heavy_slot_t {
+  bool held;
+  heavy_slot_t() : held(false) {
+  }
+  void acquire(const uint32_t cap) {
+    if (heavy_in_flight.fetch_add(1, std::memory_order_acq_rel) >= cap) {
+      heavy_in_flight.fetch_sub(1, std::memory_order_acq_rel);
+      throw valhalla::valhalla_exception_t{431};
+    }
+    held = true;
+  }
+  ~heavy_slot_t() {
+    if (held) {
+      heavy_in_flight.fetch_sub(1, std::memory_order_acq_rel);
+    }
+  }
+};
+
 } // namespace
 
 namespace valhalla {
@@ -88,6 +116,96 @@ thor_worker_t::thor_worker_t(const boost::property_tree::ptree& config,
 
   max_timedep_distance =
       config.get<float>("service_limits.max_timedep_distance", kDefaultMaxTimeDependentDistance);
+
+  // Number of threads CostMatrix may use to expand the per-location search
+  // trees. Defaults to single threaded; only worth raising when the tile
+  // cache is safe to share between threads (a tile extract or one of the
+  // thread-safe caches)
+  costmatrix_concurrency = config.get<uint32_t>("thor.costmatrix_concurrency", 1);
+
+  // Matrix cell count (sources x targets) at or above which matrix rows are
+  // serialized as they settle instead of accumulating the whole result
+  // first. Defaults to 0 (disabled)
+  matrix_streaming_threshold = config.get<uint32_t>("thor.matrix_streaming_threshold", 0);
+
+  // A per request memory budget that the big allocators degrade against
+  // (coarser isochrone grids, partial matrix results, capped route search
+  // trees) instead of growing until the kernel kills the process and every
+  // co-tenant request with it. Defaults to 0 (disabled)
+  request_memory_budget =
+      config.get<uint64_t>("thor.request_memory_budget_mb", 0) * 1024 * 1024;
+  if (request_memory_budget != 0) {
+    isochrone_gen.set_memory_budget(request_memory_budget);
+    // route searches that would outgrow the budget fail outright via the
+    // existing label cap, sized with the larger bidirectional label as a
+    // conservative per label cost
+    uint32_t max_labels = request_memory_budget / sizeof(sif::BDEdgeLabel);
+    astar.set_max_label_count(max_labels);
+    timedep_forward.set_max_label_count(max_labels);
+    timedep_reverse.set_max_label_count(max_labels);
+  }
+
+  // Overlap the multimodal destination reachability check with origin and
+  // destination initialization. Like the option above this requires a tile
+  // cache that is safe to share between threads
+  multi_modal_astar.set_parallel_reachability(
+      config.get<bool>("thor.multimodal_parallel_reachability", false));
+
+  // Number of route results to keep in the in-process route cache. Defaults
+  // to disabled
+  route_cache_size = config.get<uint32_t>("thor.route_cache_size", 0);
+
+  // Map UIs that show a fastest/shortest toggle issue the paired request
+  // right after the first; computing the pair concurrently turns that
+  // follow up into a route cache hit. Like costmatrix_concurrency this
+  // requires a tile cache that is safe to share between threads. Defaults
+  // to disabled
+  speculative_dual_costing =
+      route_cache_size > 0 && config.get<bool>("thor.speculative_dual_costing", false);
+
+  // the isochrone grid cache starts empty
+  iso_grid_key.clear();
+  iso_grid_seconds = 0.f;
+
+  // Scale hierarchy limits by the origin to destination distance so short
+  // routes spend fewer upward transitions. Defaults to disabled
+  bidir_astar.set_adaptive_hierarchy_limits(
+      config.get<bool>("thor.adaptive_hierarchy_limits", false));
+
+  // Admission control for heavy requests so a burst of batch matrices
+  // cannot occupy every worker thread. Defaults to disabled
+  max_heavy_requests = config.get<uint32_t>("thor.max_heavy_requests", 0);
+  heavy_matrix_cells = config.get<uint32_t>("thor.heavy_matrix_cells", 10000);
+  heavy_isochrone_minutes = config.get<uint32_t>("thor.heavy_isochrone_minutes", 120);
+
+  // Sampled expansion telemetry, dumped to the log when a request trips the
+  // long request threshold. Cheap enough to leave on a canary fleet.
+  // Defaults to disabled
+  auto telemetry_size = config.get<uint32_t>("thor.expansion_telemetry_size", 0);
+  auto telemetry_rate = config.get<uint32_t>("thor.expansion_telemetry_sample_rate", 64);
+  astar.set_expansion_telemetry(telemetry_size, telemetry_rate);
+  bidir_astar.set_expansion_telemetry(telemetry_size, telemetry_rate);
+  multi_modal_astar.set_expansion_telemetry(telemetry_size, telemetry_rate);
+  timedep_forward.set_expansion_telemetry(telemetry_size, telemetry_rate);
+  timedep_reverse.set_expansion_telemetry(telemetry_size, telemetry_rate);
+
+#ifdef HAVE_HTTP
+  // Serializer threads take over turning finished matrix and isochrone
+  // results into responses so this thread can start its next search while a
+  // big response is still being written; the responses ship straight to the
+  // loopback. Defaults to disabled (serialization runs inline)
+  auto serializer_threads = config.get<size_t>("thor.serializer_threads", 0);
+  auto loopback = config.get<std::string>("httpd.service.loopback", "");
+  if (serializer_threads > 0 && !loopback.empty()) {
+    response_executor.reset(new response_executor_t(loopback, serializer_threads));
+  }
+#endif
+
+  // Ring the big intermediate bodies come and go in when the deployment
+  // turned shared memory messaging on
+  message_arena = shm_message_arena_t::from_config(config);
+
+  expanded_labels = 0;
 }
 
 thor_worker_t::~thor_worker_t() {
@@ -103,54 +221,115 @@ worker_t::result_t thor_worker_t::work(const std::list<zmq::message_t>& job,
   LOG_INFO("Got Thor Request " + std::to_string(info.id));
   valhalla_request_t request;
   try {
-    // crack open the original request
+    // crack open the original request, either of its parts may be a handle
+    // to bytes the loki stage stashed in shared memory
     std::string request_str(static_cast<const char*>(job.front().data()), job.front().size());
     std::string serialized_options(static_cast<const char*>(job.back().data()), job.back().size());
+    if (message_arena && shm_message_arena_t::is_handle(request_str) &&
+        !message_arena->fetch(request_str, request_str)) {
+      throw valhalla_exception_t{401};
+    }
+    if (message_arena && shm_message_arena_t::is_handle(serialized_options) &&
+        !message_arena->fetch(serialized_options, serialized_options)) {
+      throw valhalla_exception_t{401};
+    }
     request.parse(request_str, serialized_options);
 
     // Set the interrupt function
     service_worker_t::set_interrupt(interrupt_function);
 
+    // Cap how many heavy requests may run at once so batch matrix load
+    // cannot occupy every worker thread and head of line block the
+    // interactive requests; over budget ones get a 503 to retry later
+    heavy_slot_t heavy_slot;
+    if (max_heavy_requests > 0 && heavy_request(request)) {
+      heavy_slot.acquire(max_heavy_requests);
+    }
+
+    // per request search effort counter the path algorithms feed
+    expanded_labels = 0;
+
     worker_t::result_t result{true};
+    // when set, the serialization of the computed result was split off to be
+    // run on the response executor once the bookkeeping below is done
+    deferred_json_t serializer;
     double denominator = 0;
+    // records the stage sample exactly once, and before the options are
+    // reserialized for odin in the cases that forward them
+    bool traced = false;
+    auto trace_stage = [&]() {
+      if (!traced) {
+        traced = true;
+        auto elapsed =
+            std::chrono::duration<float, std::milli>(std::chrono::system_clock::now() - s).count();
+        add_stage_trace(request.options, "thor", elapsed, expanded_labels);
+      }
+    };
+    // forward an intermediate message to odin; a large one is stashed in
+    // shared memory (serialized straight into the ring) so only its handle
+    // rides the envelope through the proxies
+    auto forward_message = [this, &result](std::string&& bytes) {
+      auto handle = message_arena ? message_arena->stash(bytes) : std::string();
+      result.messages.emplace_back(handle.empty() ? std::move(bytes) : std::move(handle));
+    };
+    auto forward_pbf = [this, &result](const google::protobuf::MessageLite& message) {
+      auto handle = message_arena ? message_arena->stash(message) : std::string();
+      result.messages.emplace_back(handle.empty() ? message.SerializeAsString()
+                                                  : std::move(handle));
+    };
     // do request specific processing
     switch (request.options.action()) {
       case odin::DirectionsOptions::sources_to_targets:
-        result = to_response_json(matrix(request), info, request);
+        if (response_executor) {
+          serializer = matrix_deferred(request);
+        } else {
+          result = to_response_json(matrix(request), info, request);
+        }
         denominator = request.options.sources_size() + request.options.targets_size();
         break;
       case odin::DirectionsOptions::optimized_route: {
         // Forward the original request
-        result.messages.emplace_back(std::move(request_str));
+        forward_message(std::move(request_str));
         auto trip_paths = optimized_route(request);
-        result.messages.emplace_back(request.options.SerializeAsString());
+        trace_stage();
+        forward_pbf(request.options);
         for (auto& trippath : trip_paths) {
-          result.messages.emplace_back(trippath.SerializeAsString());
+          forward_pbf(*trippath);
         }
         denominator = std::max(request.options.sources_size(), request.options.targets_size());
         break;
       }
       case odin::DirectionsOptions::isochrone:
-        result = to_response_json(isochrones(request), info, request);
+        if (response_executor) {
+          serializer = isochrones_deferred(request);
+        } else {
+          result = to_response_json(isochrones(request), info, request);
+        }
         denominator = request.options.sources_size() * request.options.targets_size();
         break;
+      case odin::DirectionsOptions::one_to_all:
+        result = to_response_binary(one_to_all(request), info, request);
+        denominator = request.options.locations_size();
+        break;
       case odin::DirectionsOptions::route: {
         // Forward the original request
-        result.messages.emplace_back(std::move(request_str));
+        forward_message(std::move(request_str));
         auto trip_paths = route(request);
-        result.messages.emplace_back(request.options.SerializeAsString());
+        trace_stage();
+        forward_pbf(request.options);
         for (const auto& trippath : trip_paths) {
-          result.messages.emplace_back(trippath.SerializeAsString());
+          forward_pbf(*trippath);
         }
         denominator = request.options.locations_size();
         break;
       }
       case odin::DirectionsOptions::trace_route: {
         // Forward the original request
-        result.messages.emplace_back(std::move(request_str));
+        forward_message(std::move(request_str));
         auto trip_path = trace_route(request);
-        result.messages.emplace_back(request.options.SerializeAsString());
-        result.messages.emplace_back(trip_path.SerializeAsString());
+        trace_stage();
+        forward_pbf(request.options);
+        forward_pbf(*trip_path);
         denominator = trace.size() / 1100;
         break;
       }
@@ -161,6 +340,7 @@ worker_t::result_t thor_worker_t::work(const std::list<zmq::message_t>& job,
       default:
         throw valhalla_exception_t{400}; // this should never happen
     }
+    trace_stage();
 
     double elapsed_time =
         std::chrono::duration<float, std::milli>(std::chrono::system_clock::now() - s).count();
@@ -172,6 +352,25 @@ worker_t::result_t thor_worker_t::work(const std::list<zmq::message_t>& job,
       midgard::logging::Log("valhalla_thor_long_request_" +
                                 odin::DirectionsOptions_Action_Name(request.options.action()),
                             " [ANALYTICS] ");
+      dump_expansion_telemetry();
+    }
+
+    // hand the serialization (and the request it reads its options from) to
+    // the executor; the response goes to the loopback from there so this
+    // thread has nothing left to send
+    if (serializer) {
+      // the request rides along behind a shared_ptr since the task has to be
+      // copyable and the parsed document is not
+      auto deferred_request = std::make_shared<valhalla_request_t>(std::move(request));
+      response_executor->post([serializer = std::move(serializer), deferred_request,
+                               info]() mutable -> worker_t::result_t {
+        try {
+          return to_response_json(serializer(*deferred_request), info, *deferred_request);
+        } catch (const std::exception& e) {
+          return jsonify_error({499, std::string(e.what())}, info, *deferred_request);
+        }
+      });
+      return worker_t::result_t{false};
     }
 
     return result;
@@ -212,7 +411,9 @@ void run_service(const boost::property_tree::ptree& config) {
 // Creates the cost in the cost factory
 valhalla::sif::cost_ptr_t thor_worker_t::get_costing(const odin::Costing costing,
                                                      const odin::DirectionsOptions& options) {
-  return factory.Create(costing, options);
+  // the worker serves one request at a time, so identical profiles can
+  // reuse a pooled cost object rather than re-parsing the options
+  return factory.CreateCached(costing, options);
 }
 
 std::string thor_worker_t::parse_costing(const valhalla_request_t& request) {
@@ -322,14 +523,79 @@ void thor_worker_t::log_admin(const valhalla::odin::TripPath& trip_path) {
   }
 }
 
+bool thor_worker_t::heavy_request(const valhalla_request_t& request) const {
+  switch (request.options.action()) {
+    // matrix style requests are heavy by cell count since the expansion
+    // work scales with the product of sources and targets
+    case odin::DirectionsOptions::sources_to_targets:
+    case odin::DirectionsOptions::optimized_route:
+      return static_cast<uint32_t>(request.options.sources_size()) *
+                 static_cast<uint32_t>(request.options.targets_size()) >=
+             heavy_matrix_cells;
+    // isochrones and cost surfaces are heavy by their largest contour since
+    // the expanded area grows with the square of the time
+    case odin::DirectionsOptions::isochrone:
+    case odin::DirectionsOptions::one_to_all: {
+      float max_minutes = 0.0f;
+      for (const auto& contour : request.options.contours()) {
+        max_minutes = std::max(max_minutes, contour.time());
+      }
+      return max_minutes >= heavy_isochrone_minutes;
+    }
+    default:
+      return false;
+  }
+}
+
+void thor_worker_t::dump_expansion_telemetry() const {
+  const std::pair<const char*, const PathAlgorithm*> algorithms[] =
+      {{"astar", &astar},
+       {"bidir_astar", &bidir_astar},
+       {"multi_modal", &multi_modal_astar},
+       {"timedep_forward", &timedep_forward},
+       {"timedep_reverse", &timedep_reverse}};
+  for (const auto& algorithm : algorithms) {
+    auto events = algorithm.second->expansion_events();
+    if (events.empty()) {
+      continue;
+    }
+    // compact edgeid/level/cost triples, chunked so no single log line is
+    // unreasonably long
+    std::string line;
+    for (size_t i = 0; i < events.size(); ++i) {
+      line += std::to_string(events[i].edgeid) + '/' + std::to_string(events[i].level) + '/' +
+              std::to_string(static_cast<uint32_t>(events[i].cost)) + ' ';
+      if (line.size() > 3500 || i == events.size() - 1) {
+        LOG_WARN("thor::expansion telemetry " + std::string(algorithm.first) + "::" + line);
+        line.clear();
+      }
+    }
+  }
+}
+
 void thor_worker_t::cleanup() {
+  // The trip paths were serialized before cleanup runs so the arena backing
+  // them may be recycled for the next request
+  arena.Reset();
   astar.Clear();
   bidir_astar.Clear();
   multi_modal_astar.Clear();
   trace.clear();
   isochrone_gen.Clear();
   matcher_factory.ClearFullCache();
+  // between requests is the safe point to pick up updated tiles. Cached
+  // route results may have been formed from the old tile versions
+  if (reader->CheckForTileUpdates()) {
+    route_cache.clear();
+    route_cache_lru.clear();
+    iso_grid.reset();
+  }
   if (reader->OverCommitted()) {
+    // Cached route results were formed from the tiles being dropped - do not
+    // let them outlive the tile cache they came from
+    route_cache.clear();
+    route_cache_lru.clear();
+    iso_grid.reset();
     reader->Clear();
   }
 }
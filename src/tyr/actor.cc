@@ -134,6 +134,25 @@ std::string actor_t::isochrone(const std::string& request_str,
   return json;
 }
 
+std::string actor_t::one_to_all(const std::string& request_str,
+                                const std::function<void()>& interrupt) {
+  // set the interrupts
+  pimpl->set_interrupts(interrupt);
+  // parse the request
+  valhalla_request_t request;
+  request.parse(request_str, odin::DirectionsOptions::one_to_all);
+  // check the request and locate the locations in the graph, the bounds and
+  // costing checks are the same as for isochrones
+  pimpl->loki_worker.isochrones(request);
+  // compute the one to all cost surface
+  auto bytes = pimpl->thor_worker.one_to_all(request);
+  // if they want you do to do the cleanup automatically
+  if (auto_cleanup) {
+    cleanup();
+  }
+  return bytes;
+}
+
 std::string actor_t::trace_route(const std::string& request_str,
                                  const std::function<void()>& interrupt) {
   // set the interrupts
@@ -144,7 +163,7 @@ std::string actor_t::trace_route(const std::string& request_str,
   // check the request and locate the locations in the graph
   pimpl->loki_worker.trace(request);
   // route between the locations in the graph to find the best path
-  std::list<TripPath> legs{pimpl->thor_worker.trace_route(request)};
+  std::list<TripPath*> legs{pimpl->thor_worker.trace_route(request)};
   // get some directions back from them
   auto directions = pimpl->odin_worker.narrate(request, legs);
   // serialize them out to json string
@@ -25,9 +25,30 @@ serializeIsochrones(const valhalla_request_t& request,
                     bool polygons,
                     const std::unordered_map<float, std::string>& colors,
                     bool show_locations) {
+  // this can be megabytes of geometry so stream it straight into the response
+  // buffer rather than building the intermediate json tree first
+  size_t coord_count = 0;
+  for (const auto& interval : grid_contours) {
+    for (const auto& feature : interval.second) {
+      for (const auto& contour : feature) {
+        coord_count += contour.size();
+      }
+    }
+  }
+  // a coordinate pair serializes to about 22 bytes, the properties are noise
+  Writer writer(coord_count * 22 + 1024);
+  writer.start_object();
+  writer.key("type");
+  writer.value("FeatureCollection");
+  if (request.options.has_id()) {
+    writer.key("id");
+    writer.value(request.options.id());
+  }
+  writer.key("features");
+  writer.start_array();
+
   // for each contour interval
   int i = 0;
-  auto features = array({});
   for (const auto& interval : grid_contours) {
     auto color_itr = colors.find(interval.first);
     // color was supplied
@@ -50,65 +71,87 @@ serializeIsochrones(const valhalla_request_t& request,
 
     // for each feature on that interval
     for (const auto& feature : interval.second) {
-      // for each contour in that feature
-      auto geom = array({});
-      for (const auto& contour : feature) {
-        // make some geometry
-        auto coords = array({});
-        for (const auto& coord : contour) {
-          coords->push_back(array({fp_t{coord.first, 6}, fp_t{coord.second, 6}}));
+      writer.start_object();
+      writer.key("type");
+      writer.value("Feature");
+      writer.key("geometry");
+      writer.start_object();
+      writer.key("type");
+      writer.value(polygons ? "Polygon" : "LineString");
+      writer.key("coordinates");
+      if (polygons) {
+        // each contour in the feature is a ring of the polygon
+        writer.start_array();
+        for (const auto& contour : feature) {
+          writer.start_array();
+          for (const auto& coord : contour) {
+            writer.start_array();
+            writer.value(fp_t{coord.first, 6});
+            writer.value(fp_t{coord.second, 6});
+            writer.end_array();
+          }
+          writer.end_array();
         }
-        // its either a ring
-        if (polygons) {
-          geom->emplace_back(coords);
-          // or a single line, if someone has more than one contour per feature they messed up
-        } else {
-          geom = coords;
+        writer.end_array();
+      } else {
+        // its a single line, if someone has more than one contour per feature
+        // they messed up - the last one wins as it did with the tree builder
+        writer.start_array();
+        for (const auto& coord : feature.back()) {
+          writer.start_array();
+          writer.value(fp_t{coord.first, 6});
+          writer.value(fp_t{coord.second, 6});
+          writer.end_array();
         }
+        writer.end_array();
       }
-      // add a feature
-      features->emplace_back(map({
-          {"type", std::string("Feature")},
-          {"geometry", map({
-                           {"type", std::string(polygons ? "Polygon" : "LineString")},
-                           {"coordinates", geom},
-                       })},
-          {"properties", map({
-                             {"contour", static_cast<uint64_t>(interval.first)},
-                             {"color", hex.str()},            // lines
-                             {"fill", hex.str()},             // geojson.io polys
-                             {"fillColor", hex.str()},        // leaflet polys
-                             {"opacity", fp_t{.33f, 2}},      // lines
-                             {"fill-opacity", fp_t{.33f, 2}}, // geojson.io polys
-                             {"fillOpacity", fp_t{.33f, 2}},  // leaflet polys
-                         })},
-      }));
+      writer.end_object();
+      writer.key("properties");
+      writer.start_object();
+      writer.key("contour");
+      writer.value(static_cast<uint64_t>(interval.first));
+      writer.key("color"); // lines
+      writer.value(hex.str());
+      writer.key("fill"); // geojson.io polys
+      writer.value(hex.str());
+      writer.key("fillColor"); // leaflet polys
+      writer.value(hex.str());
+      writer.key("opacity"); // lines
+      writer.value(fp_t{.33f, 2});
+      writer.key("fill-opacity"); // geojson.io polys
+      writer.value(fp_t{.33f, 2});
+      writer.key("fillOpacity"); // leaflet polys
+      writer.value(fp_t{.33f, 2});
+      writer.end_object();
+      writer.end_object();
     }
   }
   // Add original locations to the geojson
   if (show_locations) {
     for (const auto& location : request.options.locations()) {
-      features->emplace_back(
-          map({{"type", std::string("Feature")},
-               {"properties", map({})},
-               {"geometry", map({{"type", std::string("Point")},
-                                 {"coordinates", array({fp_t{location.ll().lng(), 6},
-                                                        fp_t{location.ll().lat(), 6}})}})}}));
+      writer.start_object();
+      writer.key("type");
+      writer.value("Feature");
+      writer.key("properties");
+      writer.start_object();
+      writer.end_object();
+      writer.key("geometry");
+      writer.start_object();
+      writer.key("type");
+      writer.value("Point");
+      writer.key("coordinates");
+      writer.start_array();
+      writer.value(fp_t{location.ll().lng(), 6});
+      writer.value(fp_t{location.ll().lat(), 6});
+      writer.end_array();
+      writer.end_object();
+      writer.end_object();
     }
   }
-  // make the collection
-  auto feature_collection = map({
-      {"type", std::string("FeatureCollection")},
-      {"features", features},
-  });
-
-  if (request.options.has_id()) {
-    feature_collection->emplace("id", request.options.id());
-  }
 
-  std::stringstream ss;
-  ss << *feature_collection;
-  return ss.str();
+  writer.end_array();
+  writer.end_object();
+  return writer.document();
 }
 
 template std::string
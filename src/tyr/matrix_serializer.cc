@@ -69,6 +69,31 @@ json::MapPtr serialize(const valhalla_request_t& request,
   json->emplace("distances", distance);
   return json;
 }
+
+// Serialize route response in OSRM compatible format, consuming matrix rows
+// as they are computed. Duration rows stream directly into the response;
+// distance rows are kept as serialized text until the durations array is
+// complete since the two arrays are siblings in the output.
+std::string serialize_streaming(const valhalla_request_t& request,
+                                const std::function<void(const tyr::MatrixRowCallback&)>& compute_rows,
+                                double distance_scale) {
+  std::stringstream ss;
+  ss << "{\"code\":\"Ok\",\"sources\":" << *osrm::waypoints(request.options.sources())
+     << ",\"destinations\":" << *osrm::waypoints(request.options.targets()) << ",\"durations\":[";
+  std::string distances;
+  compute_rows([&](const uint32_t source_index, const std::vector<TimeDistance>& row) {
+    if (source_index > 0) {
+      ss << ',';
+      distances += ',';
+    }
+    ss << *serialize_duration(row, 0, row.size());
+    std::stringstream ds;
+    ds << *serialize_distance(row, 0, row.size(), source_index, 0, distance_scale);
+    distances += ds.str();
+  });
+  ss << "],\"distances\":[" << distances << "]}";
+  return ss.str();
+}
 } // namespace osrm_serializers
 
 namespace valhalla_serializers {
@@ -133,6 +158,37 @@ json::MapPtr serialize(const valhalla_request_t& request,
   }
   return json;
 }
+
+// Serialize the response row by row as the rows are computed. Each settled
+// row is appended to the response text immediately so only one row of
+// results is in memory at a time.
+std::string serialize_streaming(const valhalla_request_t& request,
+                                const std::function<void(const tyr::MatrixRowCallback&)>& compute_rows,
+                                double distance_scale) {
+  std::stringstream ss;
+  ss << "{\"sources_to_targets\":[";
+  compute_rows([&](const uint32_t source_index, const std::vector<TimeDistance>& row) {
+    if (source_index > 0) {
+      ss << ',';
+    }
+    ss << *serialize_row(row, 0, row.size(), source_index, 0, distance_scale);
+  });
+
+  // The remaining fields are small and fixed - form them as a map and splice
+  // it in after the streamed rows
+  auto json = json::map({
+      {"units", odin::DirectionsOptions_Units_Name(request.options.units())},
+  });
+  json->emplace("targets", json::array({locations(request.options.targets())}));
+  json->emplace("sources", json::array({locations(request.options.sources())}));
+  if (request.options.has_id()) {
+    json->emplace("id", request.options.id());
+  }
+  std::stringstream trailer;
+  trailer << *json;
+  ss << "]," << trailer.str().substr(1);
+  return ss.str();
+}
 } // namespace valhalla_serializers
 
 namespace valhalla {
@@ -151,5 +207,13 @@ std::string serializeMatrix(const valhalla_request_t& request,
   return ss.str();
 }
 
+std::string serializeMatrix(const valhalla_request_t& request,
+                            const std::function<void(const MatrixRowCallback&)>& compute_rows,
+                            double distance_scale) {
+  return request.options.format() == odin::DirectionsOptions::osrm
+             ? osrm_serializers::serialize_streaming(request, compute_rows, distance_scale)
+             : valhalla_serializers::serialize_streaming(request, compute_rows, distance_scale);
+}
+
 } // namespace tyr
 } // namespace valhalla
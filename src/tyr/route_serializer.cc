@@ -27,16 +27,16 @@ namespace {
  * @param  legs  The legs of the route
  * @return the gpx string
  */
-std::string pathToGPX(const std::list<odin::TripPath>& legs) {
+std::string pathToGPX(const std::list<odin::TripPath*>& legs) {
   // start the gpx, we'll use 6 digits of precision
   std::stringstream gpx;
   gpx << std::setprecision(6) << std::fixed;
   gpx << R"(<?xml version="1.0" encoding="UTF-8" standalone="no"?><gpx version="1.1" creator="libvalhalla"><metadata/>)";
 
   // for each leg
-  for (const auto& leg : legs) {
+  for (const auto* leg : legs) {
     // decode the shape for this leg
-    auto wpts = midgard::decode<std::vector<PointLL>>(leg.shape());
+    auto wpts = midgard::decode<std::vector<PointLL>>(leg->shape());
 
     // throw the shape points in as way points
     // TODO: add time to each, need transition time at nodes
@@ -48,7 +48,7 @@ std::string pathToGPX(const std::list<odin::TripPath>& legs) {
     // TODO: add time to each, need transition time at nodes
     gpx << "<rte>";
     uint64_t last_id = -1;
-    for (const auto& node : leg.node()) {
+    for (const auto& node : leg->node()) {
       // if this isnt the last node we want the begin shape index of the edge
       size_t shape_idx = wpts.size() - 1;
       if (node.has_edge()) {
@@ -75,7 +75,7 @@ namespace valhalla {
 namespace tyr {
 
 std::string serializeDirections(const valhalla_request_t& request,
-                                const std::list<TripPath>& path_legs,
+                                const std::list<TripPath*>& path_legs,
                                 const std::list<TripDirections>& directions_legs) {
   // serialize them
   switch (request.options.format()) {
@@ -5,8 +5,10 @@
 #include <vector>
 
 #include "baldr/json.h"
+#include "midgard/constants.h"
 #include "midgard/encoded.h"
 #include "midgard/pointll.h"
+#include "midgard/polyline2.h"
 #include "odin/util.h"
 #include "tyr/serializers.h"
 
@@ -24,6 +26,16 @@ namespace {
 const std::string kSignElementDelimiter = ", ";
 const std::string kDestinationsDelimiter = ": ";
 
+// Generalization tolerance for the geometry in the response. The option is
+// specified in meters but Generalize compares it against distances in
+// coordinate space, so scale it. This is approximate (degrees of longitude
+// shrink away from the equator) but so is the tolerance
+float generalize_epsilon(const valhalla::odin::DirectionsOptions& directions_options) {
+  return directions_options.has_generalize() && directions_options.generalize() > 0.0f
+             ? directions_options.generalize() / midgard::kMetersPerDegreeLat
+             : 0.0f;
+}
+
 namespace osrm_serializers {
 /*
 OSRM output is described in: http://project-osrm.org/docs/v5.5.1/api/
@@ -164,13 +176,17 @@ void route_summary(json::MapPtr& route, const std::list<valhalla::odin::TripDire
   route->emplace("weight_name", std::string("Valhalla default"));
 }
 
-// Generate full shape of the route. TODO - different encodings, generalization
+// Generate full shape of the route. TODO - different encodings
 std::string full_shape(const std::list<valhalla::odin::TripDirections>& legs,
                        const valhalla::odin::DirectionsOptions& directions_options) {
 
-  // TODO - support 5 digit encoding, support generalization
+  // TODO - support 5 digit encoding
 
-  if (legs.size() == 1) {
+  // simplifying the overview geometry to the requested tolerance spares
+  // map display clients the transfer and decode of points they would
+  // discard at low zoom anyway
+  float epsilon = generalize_epsilon(directions_options);
+  if (legs.size() == 1 && epsilon == 0.0f) {
     return legs.front().shape();
   }
 
@@ -186,6 +202,9 @@ std::string full_shape(const std::list<valhalla::odin::TripDirections>& legs,
     decoded.insert(decoded.end(), decoded.size() ? decoded_leg.begin() + 1 : decoded_leg.begin(),
                    decoded_leg.end());
   }
+  if (epsilon > 0.0f) {
+    Polyline2<PointLL>::Generalize(decoded, epsilon);
+  }
   return midgard::encode(decoded);
 }
 
@@ -232,7 +251,7 @@ struct IntersectionEdges {
 
 // Add intersections along a step/maneuver.
 json::ArrayPtr intersections(const valhalla::odin::TripDirections::Maneuver& maneuver,
-                             std::list<odin::TripPath>::const_iterator path_leg,
+                             std::list<odin::TripPath*>::const_iterator path_leg,
                              const std::vector<PointLL>& shape,
                              uint32_t& count,
                              const bool arrive) {
@@ -244,8 +263,8 @@ json::ArrayPtr intersections(const valhalla::odin::TripDirections::Maneuver& man
     auto intersection = json::map({});
 
     // Get the node from the path leg
-    auto node = path_leg->node(i);
-    auto prior_node = (i > 0) ? path_leg->node(i - 1) : path_leg->node(0);
+    auto node = (*path_leg)->node(i);
+    auto prior_node = (i > 0) ? (*path_leg)->node(i - 1) : (*path_leg)->node(0);
 
     // Add the node location (lon, lat). Use the last shape point for
     // the arrive step
@@ -550,15 +569,15 @@ std::string turn_modifier(const valhalla::odin::TripDirections::Maneuver& maneuv
 // in a motorway.
 std::string ramp_type(const odin::TripPath::Edge& prior_edge,
                       const uint32_t idx,
-                      std::list<odin::TripPath>::const_iterator path_leg) {
+                      std::list<odin::TripPath*>::const_iterator path_leg) {
   if (prior_edge.use() == odin::TripPath_Use_kRoadUse) {
     if (prior_edge.road_class() == odin::TripPath_RoadClass_kMotorway) {
       return std::string("off ramp");
     } else if (prior_edge.road_class() != odin::TripPath_RoadClass_kMotorway) {
       // Check that next road is a motorway
-      for (uint32_t i = idx + 1; i < path_leg->node().size(); ++i) {
-        if (path_leg->node(i).edge().use() == odin::TripPath_Use_kRoadUse) {
-          if (path_leg->node(i).edge().road_class() == odin::TripPath_RoadClass_kMotorway) {
+      for (uint32_t i = idx + 1; i < (*path_leg)->node().size(); ++i) {
+        if ((*path_leg)->node(i).edge().use() == odin::TripPath_Use_kRoadUse) {
+          if ((*path_leg)->node(i).edge().road_class() == odin::TripPath_RoadClass_kMotorway) {
             return std::string("on ramp");
           }
           break;
@@ -571,7 +590,7 @@ std::string ramp_type(const odin::TripPath::Edge& prior_edge,
 
 // Populate the OSRM maneuver record within a step.
 json::MapPtr osrm_maneuver(const valhalla::odin::TripDirections::Maneuver& maneuver,
-                           std::list<odin::TripPath>::const_iterator path_leg,
+                           std::list<odin::TripPath*>::const_iterator path_leg,
                            const PointLL& man_ll,
                            const bool depart,
                            const bool arrive,
@@ -590,7 +609,7 @@ json::MapPtr osrm_maneuver(const valhalla::odin::TripDirections::Maneuver& maneu
   // prior edge from the TripPath. Compute turn modifier. TODO - reconcile
   // turn degrees between Valhalla and OSRM
   uint32_t idx = maneuver.begin_path_index();
-  uint32_t in_brg = (idx > 0) ? path_leg->node(idx - 1).edge().end_heading() : 0;
+  uint32_t in_brg = (idx > 0) ? (*path_leg)->node(idx - 1).edge().end_heading() : 0;
   uint32_t out_brg = maneuver.begin_heading();
   osrm_man->emplace("bearing_before", static_cast<uint64_t>(in_brg));
   osrm_man->emplace("bearing_after", static_cast<uint64_t>(out_brg));
@@ -620,12 +639,12 @@ json::MapPtr osrm_maneuver(const valhalla::odin::TripDirections::Maneuver& maneu
     maneuver_type = "exit roundabout";
   } else {
     // Special cases
-    const auto& prior_edge = path_leg->node(idx - 1).edge();
-    const auto& current_edge = path_leg->node(idx).edge();
+    const auto& prior_edge = (*path_leg)->node(idx - 1).edge();
+    const auto& current_edge = (*path_leg)->node(idx).edge();
     bool new_name = maneuver.type() == odin::TripDirections_Maneuver_Type_kContinue ||
                     maneuver.type() == odin::TripDirections_Maneuver_Type_kBecomes;
     bool ramp = current_edge.use() == odin::TripPath_Use_kRampUse;
-    bool fork = path_leg->node(idx).fork();
+    bool fork = (*path_leg)->node(idx).fork();
     bool merge = prior_edge.use() == odin::TripPath_Use_kRampUse &&
                  current_edge.use() == odin::TripPath_Use_kRoadUse &&
                  (current_edge.road_class() == odin::TripPath_RoadClass_kMotorway ||
@@ -641,7 +660,7 @@ json::MapPtr osrm_maneuver(const valhalla::odin::TripDirections::Maneuver& maneu
     }
 
     // Are there any intersecting edges
-    bool false_node = path_leg->node(idx).intersecting_edge().size() == 0;
+    bool false_node = (*path_leg)->node(idx).intersecting_edge().size() == 0;
 
     // Fall through case if maneuver not set by special cases above
     new_name = false;
@@ -652,12 +671,12 @@ json::MapPtr osrm_maneuver(const valhalla::odin::TripDirections::Maneuver& maneu
       // onto a new road name, and have passed at least 1 intersection to
       // get there.
       bool road_ends = (count > 1 && prior_edge.use() != odin::TripPath_Use_kRampUse &&
-                        path_leg->node(idx).intersecting_edge().size() == 1);
+                        (*path_leg)->node(idx).intersecting_edge().size() == 1);
       if (road_ends) {
         // TODO what about a doubly digitized road ending at a T (would be
         // 2 intersecting edges)? What if there is a driveway or path as
         // an intersecting edge?
-        const auto& intsct_edge = path_leg->node(idx).intersecting_edge(0);
+        const auto& intsct_edge = (*path_leg)->node(idx).intersecting_edge(0);
         if (intsct_edge.prev_name_consistency()) {
           road_ends = false;
         } else {
@@ -705,18 +724,24 @@ json::MapPtr osrm_maneuver(const valhalla::odin::TripDirections::Maneuver& maneu
 // TODO - encoding options
 std::string maneuver_geometry(const uint32_t begin_idx,
                               const uint32_t end_idx,
-                              const std::vector<PointLL>& shape) {
+                              const std::vector<PointLL>& shape,
+                              const float epsilon) {
   // Must add one to the end range since it is exclusive
   std::vector<PointLL> maneuver_shape(shape.begin() + begin_idx, shape.begin() + end_idx + 1);
+  // Simplify each step geometry on its own so the maneuver endpoints, which
+  // generalization always keeps, stay aligned with the step boundaries
+  if (epsilon > 0.0f) {
+    Polyline2<PointLL>::Generalize(maneuver_shape, epsilon);
+  }
   return std::string(midgard::encode(maneuver_shape));
 }
 
 // Get the mode
 std::string get_mode(const valhalla::odin::TripDirections::Maneuver& maneuver,
-                     std::list<odin::TripPath>::const_iterator path_leg) {
+                     std::list<odin::TripPath*>::const_iterator path_leg) {
   // Return ferry if the edge use is Ferry
   uint32_t idx = maneuver.begin_path_index();
-  if (path_leg->node(idx).edge().use() == odin::TripPath::Use::TripPath_Use_kFerryUse) {
+  if ((*path_leg)->node(idx).edge().use() == odin::TripPath::Use::TripPath_Use_kFerryUse) {
     return "ferry";
   }
 
@@ -761,7 +786,7 @@ names_and_refs(const valhalla::odin::TripDirections::Maneuver& maneuver) {
 }
 
 // Add annotations to the leg
-json::MapPtr annotations(std::list<odin::TripPath>::const_iterator path_leg) {
+json::MapPtr annotations(std::list<odin::TripPath*>::const_iterator path_leg) {
   auto annotations = json::map({});
 
   // Create distance and duration arrays. Iterate through trip edges and
@@ -771,10 +796,11 @@ json::MapPtr annotations(std::list<odin::TripPath>::const_iterator path_leg) {
   uint32_t elapsed_time = 0;
   auto distances = json::array({});
   auto durations = json::array({});
-  for (uint32_t idx = 0; idx < path_leg->node().size() - 1; ++idx) {
-    distances->emplace_back(json::fp_t{path_leg->node(idx).edge().length() * 1000.0f, 1});
-    uint32_t t = path_leg->node(idx + 1).elapsed_time() > path_leg->node(idx).elapsed_time()
-                     ? path_leg->node(idx + 1).elapsed_time() - path_leg->node(idx).elapsed_time()
+  for (uint32_t idx = 0; idx < (*path_leg)->node().size() - 1; ++idx) {
+    distances->emplace_back(json::fp_t{(*path_leg)->node(idx).edge().length() * 1000.0f, 1});
+    uint32_t t = (*path_leg)->node(idx + 1).elapsed_time() > (*path_leg)->node(idx).elapsed_time()
+                     ? (*path_leg)->node(idx + 1).elapsed_time() -
+                           (*path_leg)->node(idx).elapsed_time()
                      : 0;
     durations->emplace_back(static_cast<uint64_t>(t));
   }
@@ -787,7 +813,8 @@ json::MapPtr annotations(std::list<odin::TripPath>::const_iterator path_leg) {
 
 // Serialize each leg
 json::ArrayPtr serialize_legs(const std::list<valhalla::odin::TripDirections>& legs,
-                              const std::list<odin::TripPath>& path_legs) {
+                              const std::list<odin::TripPath*>& path_legs,
+                              const float epsilon) {
   auto output_legs = json::array({});
 
   // TODO: verify that path_legs is same size as legs
@@ -816,7 +843,7 @@ json::ArrayPtr serialize_legs(const std::list<valhalla::odin::TripDirections>& l
 
       // Add geometry for this maneuver
       step->emplace("geometry", maneuver_geometry(maneuver.begin_shape_index(),
-                                                  maneuver.end_shape_index(), shape));
+                                                  maneuver.end_shape_index(), shape, epsilon));
 
       // Add mode, driving side, weight, distance, duration, name
       float distance = maneuver.length() * 1000.0f;
@@ -901,7 +928,7 @@ json::ArrayPtr serialize_legs(const std::list<valhalla::odin::TripDirections>& l
     // NOTE: Valhalla outputs annotations per edge not between node Id
     // pairs like OSRM does.
     // Protect against empty trip path
-    if (path_leg->node().size() > 0) {
+    if ((*path_leg)->node().size() > 0) {
       output_leg->emplace("annotation", annotations(path_leg));
     }
 
@@ -929,7 +956,7 @@ json::ArrayPtr serialize_legs(const std::list<valhalla::odin::TripDirections>& l
 //     TripPath protocol buffer
 //     TripDirections protocol buffer
 std::string serialize(const valhalla::odin::DirectionsOptions& directions_options,
-                      const std::list<TripPath>& path_legs,
+                      const std::list<TripPath*>& path_legs,
                       const std::list<valhalla::odin::TripDirections>& legs) {
   auto json = json::map({});
 
@@ -965,7 +992,7 @@ std::string serialize(const valhalla::odin::DirectionsOptions& directions_option
     route_summary(route, legs);
 
     // Serialize route legs
-    route->emplace("legs", serialize_legs(legs, path_legs));
+    route->emplace("legs", serialize_legs(legs, path_legs, generalize_epsilon(directions_options)));
 
     routes->emplace_back(route);
   }
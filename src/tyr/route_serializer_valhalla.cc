@@ -564,6 +564,20 @@ std::string serialize(const valhalla::odin::DirectionsOptions& directions_option
     json->emplace("id", directions_options.id());
   }
 
+  // surface the per stage samples the workers recorded on the way here
+  if (directions_options.stage_trace() && directions_options.stage_traces_size()) {
+    auto stages = json::array({});
+    for (const auto& stage : directions_options.stage_traces()) {
+      auto entry = json::map(
+          {{"stage", stage.stage()}, {"elapsed_ms", json::fp_t{stage.elapsed_ms(), 3}}});
+      if (stage.has_labels_expanded()) {
+        entry->emplace("labels_expanded", static_cast<uint64_t>(stage.labels_expanded()));
+      }
+      stages->emplace_back(entry);
+    }
+    json->emplace("debug", json::map({{"stages", stages}}));
+  }
+
   std::stringstream ss;
   ss << *json;
   return ss.str();
@@ -65,6 +65,9 @@ json::ArrayPtr serialize_edges(const AttributesController& controller,
       if (edge.has_truck_route()) {
         edge_map->emplace("truck_route", static_cast<bool>(edge.truck_route()));
       }
+      if (edge.has_name_consistency()) {
+        edge_map->emplace("name_consistency", static_cast<bool>(edge.name_consistency()));
+      }
       if (edge.has_truck_speed() && (edge.truck_speed() > 0)) {
         edge_map->emplace("truck_speed",
                           static_cast<uint64_t>(std::round(edge.truck_speed() * scale)));
@@ -337,13 +340,13 @@ json::ArrayPtr serialize_matched_points(const AttributesController& controller,
     auto match_points_map = json::map({});
 
     // Process matched point
-    if (controller.attributes.at(kMatchedPoint)) {
+    if (controller(kMatchedPoint)) {
       match_points_map->emplace("lon", json::fp_t{match_result.lnglat.first, 6});
       match_points_map->emplace("lat", json::fp_t{match_result.lnglat.second, 6});
     }
 
     // Process matched type
-    if (controller.attributes.at(kMatchedType)) {
+    if (controller(kMatchedType)) {
       switch (match_result.type) {
         case thor::MatchResult::Type::kMatched:
           match_points_map->emplace("type", std::string("matched"));
@@ -358,32 +361,32 @@ json::ArrayPtr serialize_matched_points(const AttributesController& controller,
     }
 
     // Process matched point edge index
-    if (controller.attributes.at(kMatchedEdgeIndex) && match_result.HasEdgeIndex()) {
+    if (controller(kMatchedEdgeIndex) && match_result.HasEdgeIndex()) {
       match_points_map->emplace("edge_index", static_cast<uint64_t>(match_result.edge_index));
     }
 
     // Process matched point begin route discontinuity
-    if (controller.attributes.at(kMatchedBeginRouteDiscontinuity) &&
+    if (controller(kMatchedBeginRouteDiscontinuity) &&
         match_result.begin_route_discontinuity) {
       match_points_map->emplace("begin_route_discontinuity",
                                 static_cast<bool>(match_result.begin_route_discontinuity));
     }
 
     // Process matched point end route discontinuity
-    if (controller.attributes.at(kMatchedEndRouteDiscontinuity) &&
+    if (controller(kMatchedEndRouteDiscontinuity) &&
         match_result.end_route_discontinuity) {
       match_points_map->emplace("end_route_discontinuity",
                                 static_cast<bool>(match_result.end_route_discontinuity));
     }
 
     // Process matched point distance along edge
-    if (controller.attributes.at(kMatchedDistanceAlongEdge) &&
+    if (controller(kMatchedDistanceAlongEdge) &&
         (match_result.type != thor::MatchResult::Type::kUnmatched)) {
       match_points_map->emplace("distance_along_edge", json::fp_t{match_result.distance_along, 3});
     }
 
     // Process matched point distance from trace point
-    if (controller.attributes.at(kMatchedDistanceFromTracePoint) &&
+    if (controller(kMatchedDistanceFromTracePoint) &&
         (match_result.type != thor::MatchResult::Type::kUnmatched)) {
       match_points_map->emplace("distance_from_trace_point",
                                 json::fp_t{match_result.distance_from, 3});
@@ -398,10 +401,10 @@ void append_trace_info(
     const json::MapPtr& json,
     const AttributesController& controller,
     const DirectionsOptions& directions_options,
-    const std::tuple<float, float, std::vector<thor::MatchResult>, TripPath>& map_match_result) {
+    const std::tuple<float, float, std::vector<thor::MatchResult>, TripPath*>& map_match_result) {
   // Set trip path and match results
   const auto& match_results = std::get<kMatchResultsIndex>(map_match_result);
-  const auto& trip_path = std::get<kTripPathIndex>(map_match_result);
+  const auto& trip_path = *std::get<kTripPathIndex>(map_match_result);
 
   // Add osm_changeset
   if (trip_path.has_osm_changeset()) {
@@ -414,13 +417,13 @@ void append_trace_info(
   }
 
   // Add confidence_score
-  if (controller.attributes.at(kConfidenceScore)) {
+  if (controller(kConfidenceScore)) {
     json->emplace("confidence_score",
                   json::fp_t{std::get<kConfidenceScoreIndex>(map_match_result), 3});
   }
 
   // Add raw_score
-  if (controller.attributes.at(kRawScore)) {
+  if (controller(kRawScore)) {
     json->emplace("raw_score", json::fp_t{std::get<kRawScoreIndex>(map_match_result), 3});
   }
 
@@ -445,7 +448,7 @@ namespace tyr {
 std::string serializeTraceAttributes(
     const valhalla_request_t& request,
     const AttributesController& controller,
-    std::vector<std::tuple<float, float, std::vector<thor::MatchResult>, TripPath>>&
+    std::vector<std::tuple<float, float, std::vector<thor::MatchResult>, TripPath*>>&
         map_match_results) {
 
   // Create json map to return
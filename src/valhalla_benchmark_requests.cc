@@ -0,0 +1,361 @@
+#include "config.h"
+
+#include "midgard/logging.h"
+#include "midgard/util.h"
+#include "tyr/actor.h"
+
+#include "baldr/rapidjson_utils.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <boost/filesystem/operations.hpp>
+#include <boost/optional.hpp>
+#include <boost/program_options.hpp>
+#include <boost/property_tree/ptree.hpp>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <list>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace bpo = boost::program_options;
+
+boost::filesystem::path config_file_path;
+size_t threads =
+    std::max(static_cast<size_t>(std::thread::hardware_concurrency()), static_cast<size_t>(1));
+std::string default_action = "route";
+double qps = 0;
+bool expansions = false;
+std::vector<std::string> input_files;
+
+// a request body to replay and the actor method to replay it with
+struct request_t {
+  std::string action;
+  std::string body;
+};
+std::vector<request_t> requests;
+std::atomic<size_t> request_index(0);
+
+// when pacing, every request has a scheduled send time relative to this so the
+// offered load stays at the target rate no matter which thread picks it up
+std::chrono::steady_clock::time_point schedule_start;
+
+// latency histogram with power of two millisecond buckets, the last bucket is
+// everything at or over 2^(kHistogramBuckets-2) ms
+constexpr size_t kHistogramBuckets = 16;
+
+// per action statistics a thread collected
+struct action_result_t {
+  std::vector<double> times;
+  std::array<size_t, kHistogramBuckets> histogram{};
+  size_t failures = 0;
+  // edge labels the path algorithms allocated, summed over the responses that
+  // reported them in their stage trace debug block
+  uint64_t labels_expanded = 0;
+  size_t labeled_responses = 0;
+};
+using result_t = std::map<std::string, action_result_t>;
+
+bool ParseArguments(int argc, char* argv[]) {
+  bpo::options_description options(
+      "benchmark " VALHALLA_VERSION "\n"
+      "\n"
+      " Usage: valhalla_benchmark_requests [options] <request_log_file> ...\n"
+      "\n"
+      "valhalla_benchmark_requests is a load generator that replays request logs "
+      "end-to-end against tiled route data at a controlled concurrency and request "
+      "rate, and reports per action latency histograms so capacity can be validated "
+      "before traffic shifts. The input is a text file with one json request per "
+      "line; a line may name its actor method in an \"action\" member, lines that "
+      "do not use the --action default."
+      "\n"
+      "\n");
+
+  options.add_options()("help,h",
+                        "Print this help message.")("version,v",
+                                                    "Print the version of this software.")(
+      "config,c", boost::program_options::value<boost::filesystem::path>(&config_file_path),
+      "Path to the json configuration file.")(
+      "threads,t", boost::program_options::value<size_t>(&threads),
+      "Concurrency to use.")("action,a",
+                             boost::program_options::value<std::string>(&default_action),
+                             "Actor method for requests that do not name one: route, locate, "
+                             "matrix, optimized_route, isochrone, one_to_all, trace_route, "
+                             "trace_attributes, height or transit_available.")(
+      "qps,q", boost::program_options::value<double>(&qps),
+      "Target requests per second over all threads. 0 (the default) replays as "
+      "fast as the concurrency allows.")(
+      "expansions,e", boost::program_options::value<bool>(&expansions),
+      "Set stage_trace on every request and aggregate the expanded edge label "
+      "counters the responses report in their debug block.")
+      // positional arguments
+      ("input_files",
+       boost::program_options::value<std::vector<std::string>>(&input_files)->multitoken());
+
+  bpo::positional_options_description pos_options;
+  pos_options.add("input_files", 16);
+
+  bpo::variables_map vm;
+  try {
+    bpo::store(bpo::command_line_parser(argc, argv).options(options).positional(pos_options).run(),
+               vm);
+    bpo::notify(vm);
+
+  } catch (std::exception& e) {
+    std::cerr << "Unable to parse command line options because: " << e.what() << "\n"
+              << "This is a bug, please report it at " PACKAGE_BUGREPORT << "\n";
+    return false;
+  }
+
+  if (vm.count("help")) {
+    std::cout << options << "\n";
+    return true;
+  }
+
+  if (vm.count("version")) {
+    std::cout << "valhalla_benchmark_requests " << VALHALLA_VERSION << "\n";
+    return true;
+  }
+
+  // argument checking and verification
+  for (const auto& arg : std::vector<std::string>{"config", "input_files"}) {
+    if (vm.count(arg) == 0) {
+      std::cerr << "The <" << arg << "> argument was not provided, but is mandatory\n\n";
+      std::cerr << options << "\n";
+      return false;
+    }
+  }
+
+  return true;
+}
+
+// a log line is a json request, optionally carrying the actor method it was
+// served by in an "action" member; the request parsers ignore unknown members
+// so the body can be replayed as is
+bool parse_request_line(const std::string& line, request_t& request) {
+  rapidjson::Document doc;
+  doc.Parse(line.c_str());
+  if (doc.HasParseError() || !doc.IsObject()) {
+    return false;
+  }
+  auto action = rapidjson::get_optional<std::string>(doc, "/action");
+  request.action = action ? *action : default_action;
+  if (expansions) {
+    doc.AddMember("stage_trace", true, doc.GetAllocator());
+    request.body = rapidjson::to_string(doc);
+  } else {
+    request.body = line;
+  }
+  return true;
+}
+
+// sum the expanded label counters from the response's debug block. a string
+// scan keeps the bookkeeping off the dom parser since responses can be large
+uint64_t parse_labels_expanded(const std::string& response) {
+  const std::string key = "\"labels_expanded\":";
+  uint64_t labels = 0;
+  for (auto pos = response.find(key); pos != std::string::npos;
+       pos = response.find(key, pos + key.size())) {
+    labels += std::strtoull(response.c_str() + pos + key.size(), nullptr, 10);
+  }
+  return labels;
+}
+
+size_t histogram_bucket(double ms) {
+  size_t bucket = 0;
+  while (bucket < kHistogramBuckets - 1 && ms >= static_cast<double>(1u << bucket)) {
+    ++bucket;
+  }
+  return bucket;
+}
+
+void work(const boost::property_tree::ptree& config, std::promise<result_t>& promise) {
+  // each thread gets its own worker objects but they share the tile cache
+  // behavior the service would have with the same configuration
+  valhalla::tyr::actor_t actor(config, true);
+  auto act = [&actor](const request_t& request) {
+    if (request.action == "route") {
+      return actor.route(request.body);
+    } else if (request.action == "locate") {
+      return actor.locate(request.body);
+    } else if (request.action == "matrix" || request.action == "sources_to_targets") {
+      return actor.matrix(request.body);
+    } else if (request.action == "optimized_route") {
+      return actor.optimized_route(request.body);
+    } else if (request.action == "isochrone") {
+      return actor.isochrone(request.body);
+    } else if (request.action == "one_to_all") {
+      return actor.one_to_all(request.body);
+    } else if (request.action == "trace_route") {
+      return actor.trace_route(request.body);
+    } else if (request.action == "trace_attributes") {
+      return actor.trace_attributes(request.body);
+    } else if (request.action == "height") {
+      return actor.height(request.body);
+    } else if (request.action == "transit_available") {
+      return actor.transit_available(request.body);
+    }
+    throw std::runtime_error("Unsupported action: " + request.action);
+  };
+
+  // pull work off and do it
+  result_t result;
+  size_t i;
+  while ((i = request_index.fetch_add(1)) < requests.size()) {
+    const auto& request = requests[i];
+    auto& stats = result[request.action];
+    // hold the request back until its scheduled send time so the offered load
+    // matches the target rate; a backlogged schedule just sends immediately,
+    // which shows up as the achieved throughput falling short of the target
+    if (qps > 0) {
+      std::this_thread::sleep_until(schedule_start +
+                                    std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                        std::chrono::duration<double>(i / qps)));
+    }
+    auto start = std::chrono::high_resolution_clock::now();
+    try {
+      auto response = act(request);
+      auto end = std::chrono::high_resolution_clock::now();
+      auto ms = std::chrono::duration<double, std::milli>(end - start).count();
+      stats.times.push_back(ms);
+      ++stats.histogram[histogram_bucket(ms)];
+      if (expansions) {
+        auto labels = parse_labels_expanded(response);
+        if (labels > 0) {
+          stats.labels_expanded += labels;
+          ++stats.labeled_responses;
+        }
+      }
+    } catch (...) {
+      ++stats.failures;
+    }
+  }
+
+  // return the statistics
+  promise.set_value(std::move(result));
+}
+
+int main(int argc, char** argv) {
+
+  if (!ParseArguments(argc, argv)) {
+    return EXIT_FAILURE;
+  }
+
+  // config file
+  boost::property_tree::ptree pt;
+  rapidjson::read_json(config_file_path.c_str(), pt);
+
+  // configure logging
+  boost::optional<boost::property_tree::ptree&> logging_subtree =
+      pt.get_child_optional("thor.logging");
+  if (logging_subtree) {
+    auto logging_config =
+        valhalla::midgard::ToMap<const boost::property_tree::ptree&,
+                                 std::unordered_map<std::string, std::string>>(logging_subtree.get());
+    valhalla::midgard::logging::Configure(logging_config);
+  }
+
+  // fill up the queue with work
+  size_t skipped = 0;
+  for (const auto& file : input_files) {
+    std::ifstream stream(file);
+    std::string line;
+    while (std::getline(stream, line)) {
+      request_t request;
+      if (parse_request_line(line, request)) {
+        requests.emplace_back(std::move(request));
+      } else if (!line.empty()) {
+        ++skipped;
+      }
+      line.clear();
+    }
+  }
+  if (skipped) {
+    LOG_WARN(std::to_string(skipped) + " lines were not json objects and were skipped");
+  }
+  if (requests.empty()) {
+    LOG_ERROR("No requests were found in the input files");
+    return EXIT_FAILURE;
+  }
+  LOG_INFO("Replaying " + std::to_string(requests.size()) + " requests over " +
+           std::to_string(threads) + " thread(s)" +
+           (qps > 0 ? " at " + std::to_string(qps) + " requests/second" : " unthrottled"));
+
+  // start up the threads
+  std::list<std::thread> pool;
+  std::vector<std::promise<result_t>> pool_results(threads);
+  schedule_start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < threads; ++i) {
+    pool.emplace_back(work, std::cref(pt), std::ref(pool_results[i]));
+  }
+
+  // let the threads finish up
+  for (auto& thread : pool) {
+    thread.join();
+  }
+  auto elapsed =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - schedule_start).count();
+
+  // merge the per thread results by action
+  result_t results;
+  for (auto& thread_result : pool_results) {
+    auto result = thread_result.get_future().get();
+    for (auto& action_result : result) {
+      auto& merged = results[action_result.first];
+      auto& partial = action_result.second;
+      merged.times.insert(merged.times.end(), partial.times.begin(), partial.times.end());
+      for (size_t bucket = 0; bucket < kHistogramBuckets; ++bucket) {
+        merged.histogram[bucket] += partial.histogram[bucket];
+      }
+      merged.failures += partial.failures;
+      merged.labels_expanded += partial.labels_expanded;
+      merged.labeled_responses += partial.labeled_responses;
+    }
+  }
+
+  size_t succeeded = 0;
+  for (const auto& action_result : results) {
+    succeeded += action_result.second.times.size();
+  }
+  LOG_INFO("Overall throughput: " + std::to_string(succeeded / elapsed) + " requests/second");
+
+  for (auto& action_result : results) {
+    auto& stats = action_result.second;
+    std::sort(stats.times.begin(), stats.times.end());
+    LOG_INFO("Action: " + action_result.first);
+    LOG_INFO("--------------------------------");
+    LOG_INFO("Succeeded: " + std::to_string(stats.times.size()));
+    LOG_INFO("Failed: " + std::to_string(stats.failures));
+    if (!stats.times.empty()) {
+      auto quantile = [&stats](double q) {
+        return stats.times[static_cast<size_t>(q * (stats.times.size() - 1))];
+      };
+      LOG_INFO("p50: " + std::to_string(quantile(0.5)) + "ms");
+      LOG_INFO("p90: " + std::to_string(quantile(0.9)) + "ms");
+      LOG_INFO("p99: " + std::to_string(quantile(0.99)) + "ms");
+      LOG_INFO("Maximum: " + std::to_string(stats.times.back()) + "ms");
+      for (size_t bucket = 0; bucket < kHistogramBuckets; ++bucket) {
+        if (stats.histogram[bucket] == 0) {
+          continue;
+        }
+        std::string bound = bucket == kHistogramBuckets - 1
+                                ? ">= " + std::to_string(1u << (kHistogramBuckets - 2)) + "ms"
+                                : "< " + std::to_string(1u << bucket) + "ms";
+        LOG_INFO("  " + bound + ": " + std::to_string(stats.histogram[bucket]));
+      }
+      if (stats.labeled_responses > 0) {
+        LOG_INFO("Expanded labels: " + std::to_string(stats.labels_expanded) + " total, " +
+                 std::to_string(stats.labels_expanded / stats.labeled_responses) +
+                 " mean over " + std::to_string(stats.labeled_responses) + " responses");
+      }
+    }
+    LOG_INFO("--------------------------------\n\n");
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,121 @@
+#include <boost/program_options.hpp>
+#include <cstdint>
+#include <ctime>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "config.h"
+#include "midgard/encoded.h"
+#include "midgard/logging.h"
+#include "midgard/pointll.h"
+
+using namespace valhalla::midgard;
+
+namespace bpo = boost::program_options;
+
+/**
+ * Benchmark of polyline shape encoding and decoding. Builds a synthetic
+ * shape resembling a long route (many small offsets between successive
+ * points) and times repeated encode/decode round trips for both the 5 bit
+ * (polyline) and 7 bit (varint) codecs. Shape decode dominates route and
+ * isochrone response serialization so these kernels are worth watching.
+ */
+int Benchmark(const uint32_t npoints, const uint32_t iterations) {
+  // Create a random walk shape - deltas are small as they are along edges
+  std::mt19937 gen(120783);
+  std::uniform_real_distribution<> dis(-0.001, 0.001);
+  std::vector<PointLL> shape;
+  shape.reserve(npoints);
+  double lng = -76.5, lat = 40.5;
+  for (uint32_t i = 0; i < npoints; i++) {
+    shape.emplace_back(lng, lat);
+    lng += dis(gen);
+    lat += dis(gen);
+  }
+
+  // Encode with the 5 bit codec
+  std::clock_t start = std::clock();
+  std::string encoded;
+  for (uint32_t i = 0; i < iterations; i++) {
+    encoded = encode<std::vector<PointLL>>(shape);
+  }
+  uint32_t ms = (std::clock() - start) / static_cast<double>(CLOCKS_PER_SEC / 1000);
+  LOG_INFO("encode: " + std::to_string(iterations) + " x " + std::to_string(npoints) +
+           " points (" + std::to_string(encoded.size()) + " bytes) in " + std::to_string(ms) +
+           " ms");
+
+  // Decode with the 5 bit codec
+  start = std::clock();
+  size_t count = 0;
+  for (uint32_t i = 0; i < iterations; i++) {
+    count += decode<std::vector<PointLL>>(encoded).size();
+  }
+  ms = (std::clock() - start) / static_cast<double>(CLOCKS_PER_SEC / 1000);
+  LOG_INFO("decode: " + std::to_string(count) + " points in " + std::to_string(ms) + " ms");
+
+  // Encode with the 7 bit codec
+  start = std::clock();
+  for (uint32_t i = 0; i < iterations; i++) {
+    encoded = encode7<std::vector<PointLL>>(shape);
+  }
+  ms = (std::clock() - start) / static_cast<double>(CLOCKS_PER_SEC / 1000);
+  LOG_INFO("encode7: " + std::to_string(iterations) + " x " + std::to_string(npoints) +
+           " points (" + std::to_string(encoded.size()) + " bytes) in " + std::to_string(ms) +
+           " ms");
+
+  // Decode with the 7 bit codec
+  start = std::clock();
+  count = 0;
+  for (uint32_t i = 0; i < iterations; i++) {
+    count += decode7<std::vector<PointLL>>(encoded).size();
+  }
+  ms = (std::clock() - start) / static_cast<double>(CLOCKS_PER_SEC / 1000);
+  LOG_INFO("decode7: " + std::to_string(count) + " points in " + std::to_string(ms) + " ms");
+  return 0;
+}
+
+int main(int argc, char* argv[]) {
+
+  bpo::options_description options(
+      "valhalla " VALHALLA_VERSION "\n"
+      "\n"
+      " Usage: shapebenchmark [options]\n"
+      "\n"
+      "shapebenchmark times the polyline and varint shape codecs on a synthetic"
+      "route shape. Useful when touching midgard/encoded.h or shape_decoder.h."
+      "\n"
+      "\n");
+
+  options.add_options()("help,h", "Print this help message.")("version,v",
+                                                              "Print the version of this software.");
+
+  bpo::variables_map vm;
+  try {
+    bpo::store(bpo::command_line_parser(argc, argv).options(options).run(), vm);
+    bpo::notify(vm);
+
+  } catch (std::exception& e) {
+    std::cerr << "Unable to parse command line options because: " << e.what() << "\n"
+              << "This is a bug, please report it at " PACKAGE_BUGREPORT << "\n";
+    return EXIT_FAILURE;
+  }
+
+  if (vm.count("help")) {
+    std::cout << options << "\n";
+    return EXIT_SUCCESS;
+  }
+
+  if (vm.count("version")) {
+    std::cout << "ShapeBenchmark " << VALHALLA_VERSION << "\n";
+    return EXIT_SUCCESS;
+  }
+
+  // A shape about the size of a long cross country route, then a short one
+  Benchmark(100000, 100);
+  Benchmark(1000, 10000);
+  LOG_INFO("Done Benchmark!");
+
+  return EXIT_SUCCESS;
+}
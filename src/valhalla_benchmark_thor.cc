@@ -0,0 +1,254 @@
+#include "config.h"
+
+#include "midgard/logging.h"
+#include "midgard/util.h"
+#include "tyr/actor.h"
+
+#include "baldr/rapidjson_utils.h"
+#include <algorithm>
+#include <atomic>
+#include <boost/filesystem/operations.hpp>
+#include <boost/optional.hpp>
+#include <boost/program_options.hpp>
+#include <boost/property_tree/ptree.hpp>
+#include <chrono>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <list>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace bpo = boost::program_options;
+
+boost::filesystem::path config_file_path;
+size_t threads =
+    std::max(static_cast<size_t>(std::thread::hardware_concurrency()), static_cast<size_t>(1));
+std::string action = "route";
+size_t iterations = 1;
+std::vector<std::string> input_files;
+
+// the request bodies to replay, shared read-only by the worker threads
+std::vector<std::string> requests;
+std::atomic<size_t> request_index(0);
+
+struct result_t {
+  // per request latencies in milliseconds, in completion order
+  std::vector<double> times;
+  size_t failures = 0;
+};
+
+bool ParseArguments(int argc, char* argv[]) {
+  bpo::options_description options(
+      "benchmark " VALHALLA_VERSION "\n"
+      "\n"
+      " Usage: valhalla_benchmark_thor [options] <request_input_file> ...\n"
+      "\n"
+      "valhalla_benchmark_thor replays canned requests end-to-end (loki, thor and "
+      "odin) against tiled route data and reports throughput and latency quantiles. "
+      "The input is a text file with one json request per line, in the same format "
+      "as the files in test_requests/ (a leading -j and quoting are tolerated)."
+      "\n"
+      "\n");
+
+  options.add_options()("help,h", "Print this help message.")("version,v",
+                                                              "Print the version of this software.")(
+      "config,c", boost::program_options::value<boost::filesystem::path>(&config_file_path),
+      "Path to the json configuration file.")(
+      "threads,t", boost::program_options::value<size_t>(&threads),
+      "Concurrency to use.")("action,a", boost::program_options::value<std::string>(&action),
+                             "Which action to benchmark: route, matrix, optimized_route, "
+                             "isochrone, trace_route or trace_attributes.")(
+      "iterations,i", boost::program_options::value<size_t>(&iterations),
+      "How many passes to make over the request set. The first pass warms the tile "
+      "cache so later passes measure the algorithms rather than tile io.")
+      // positional arguments
+      ("input_files",
+       boost::program_options::value<std::vector<std::string>>(&input_files)->multitoken());
+
+  bpo::positional_options_description pos_options;
+  pos_options.add("input_files", 16);
+
+  bpo::variables_map vm;
+  try {
+    bpo::store(bpo::command_line_parser(argc, argv).options(options).positional(pos_options).run(),
+               vm);
+    bpo::notify(vm);
+
+  } catch (std::exception& e) {
+    std::cerr << "Unable to parse command line options because: " << e.what() << "\n"
+              << "This is a bug, please report it at " PACKAGE_BUGREPORT << "\n";
+    return false;
+  }
+
+  if (vm.count("help")) {
+    std::cout << options << "\n";
+    return true;
+  }
+
+  if (vm.count("version")) {
+    std::cout << "valhalla_benchmark_thor " << VALHALLA_VERSION << "\n";
+    return true;
+  }
+
+  // argument checking and verification
+  for (const auto& arg : std::vector<std::string>{"config", "input_files"}) {
+    if (vm.count(arg) == 0) {
+      std::cerr << "The <" << arg << "> argument was not provided, but is mandatory\n\n";
+      std::cerr << options << "\n";
+      return false;
+    }
+  }
+
+  return true;
+}
+
+// the test_requests files are argument lists for the valhalla_run_* tools, so a
+// line may look like: -j '{"locations":...}'. strip that down to the json body
+std::string parse_request_line(const std::string& line) {
+  auto start = line.find('{');
+  auto end = line.rfind('}');
+  if (start == std::string::npos || end == std::string::npos || end < start) {
+    return {};
+  }
+  return line.substr(start, end - start + 1);
+}
+
+void work(const boost::property_tree::ptree& config, std::promise<result_t>& promise) {
+  // each thread gets its own worker objects but they share the tile cache
+  // behavior the service would have with the same configuration
+  valhalla::tyr::actor_t actor(config, true);
+  auto act = [&actor](const std::string& request) {
+    if (action == "route") {
+      return actor.route(request);
+    } else if (action == "matrix") {
+      return actor.matrix(request);
+    } else if (action == "optimized_route") {
+      return actor.optimized_route(request);
+    } else if (action == "isochrone") {
+      return actor.isochrone(request);
+    } else if (action == "trace_route") {
+      return actor.trace_route(request);
+    } else if (action == "trace_attributes") {
+      return actor.trace_attributes(request);
+    }
+    throw std::runtime_error("Unsupported action: " + action);
+  };
+
+  // pull work off and do it
+  result_t result;
+  size_t i;
+  while ((i = request_index.fetch_add(1)) < requests.size()) {
+    auto start = std::chrono::high_resolution_clock::now();
+    try {
+      act(requests[i]);
+      auto end = std::chrono::high_resolution_clock::now();
+      result.times.push_back(
+          std::chrono::duration<double, std::milli>(end - start).count());
+    } catch (...) {
+      ++result.failures;
+    }
+  }
+
+  // return the statistics
+  promise.set_value(std::move(result));
+}
+
+int main(int argc, char** argv) {
+
+  if (!ParseArguments(argc, argv)) {
+    return EXIT_FAILURE;
+  }
+
+  // config file
+  boost::property_tree::ptree pt;
+  rapidjson::read_json(config_file_path.c_str(), pt);
+
+  // configure logging
+  boost::optional<boost::property_tree::ptree&> logging_subtree =
+      pt.get_child_optional("thor.logging");
+  if (logging_subtree) {
+    auto logging_config =
+        valhalla::midgard::ToMap<const boost::property_tree::ptree&,
+                                 std::unordered_map<std::string, std::string>>(logging_subtree.get());
+    valhalla::midgard::logging::Configure(logging_config);
+  }
+
+  // fill up the queue with work
+  for (const auto& file : input_files) {
+    std::ifstream stream(file);
+    std::string line;
+    while (std::getline(stream, line)) {
+      auto request = parse_request_line(line);
+      if (!request.empty()) {
+        requests.push_back(std::move(request));
+      }
+      line.clear();
+    }
+  }
+  if (requests.empty()) {
+    LOG_ERROR("No requests were found in the input files");
+    return EXIT_FAILURE;
+  }
+  LOG_INFO("Replaying " + std::to_string(requests.size()) + " '" + action + "' requests " +
+           std::to_string(iterations) + " time(s) over " + std::to_string(threads) + " thread(s)");
+
+  // each iteration replays the whole request set; keep the per request times
+  // from every pass but report the passes separately so the cold tile cache of
+  // the first pass does not pollute the steady state numbers
+  for (size_t pass = 0; pass < iterations; ++pass) {
+    request_index = 0;
+
+    // start up the threads
+    std::list<std::thread> pool;
+    std::vector<std::promise<result_t>> pool_results(threads);
+    auto pass_start = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < threads; ++i) {
+      pool.emplace_back(work, std::cref(pt), std::ref(pool_results[i]));
+    }
+
+    // let the threads finish up
+    for (auto& thread : pool) {
+      thread.join();
+    }
+    auto pass_end = std::chrono::high_resolution_clock::now();
+    auto elapsed = std::chrono::duration<double>(pass_end - pass_start).count();
+
+    // grab all the results
+    std::vector<double> times;
+    size_t failures = 0;
+    for (auto& thread_result : pool_results) {
+      auto result = thread_result.get_future().get();
+      times.insert(times.end(), result.times.begin(), result.times.end());
+      failures += result.failures;
+    }
+    std::sort(times.begin(), times.end());
+
+    // quantiles over the sorted latencies
+    auto quantile = [&times](double q) {
+      return times[static_cast<size_t>(q * (times.size() - 1))];
+    };
+    double total = 0;
+    for (const auto time : times) {
+      total += time;
+    }
+
+    LOG_INFO("Pass " + std::to_string(pass + 1) + " of " + std::to_string(iterations));
+    LOG_INFO("--------------------------------");
+    LOG_INFO("Succeeded: " + std::to_string(times.size()));
+    LOG_INFO("Failed: " + std::to_string(failures));
+    if (!times.empty()) {
+      LOG_INFO("Throughput: " + std::to_string(times.size() / elapsed) + " requests/second");
+      LOG_INFO("Mean: " + std::to_string(total / times.size()) + "ms");
+      LOG_INFO("Minimum: " + std::to_string(times.front()) + "ms");
+      LOG_INFO("p50: " + std::to_string(quantile(0.5)) + "ms");
+      LOG_INFO("p90: " + std::to_string(quantile(0.9)) + "ms");
+      LOG_INFO("p99: " + std::to_string(quantile(0.99)) + "ms");
+      LOG_INFO("Maximum: " + std::to_string(times.back()) + "ms");
+    }
+    LOG_INFO("--------------------------------\n\n");
+  }
+
+  return EXIT_SUCCESS;
+}
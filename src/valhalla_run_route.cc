@@ -5,6 +5,7 @@
 #include <cmath>
 #include <cstdint>
 #include <iostream>
+#include <memory>
 #include <queue>
 #include <string>
 #include <tuple>
@@ -156,8 +157,10 @@ TripPath PathTest(GraphReader& reader,
   // Form trip path
   t1 = std::chrono::high_resolution_clock::now();
   AttributesController controller;
-  TripPath trip_path = TripPathBuilder::Build(controller, reader, mode_costing, pathedges, origin,
-                                              dest, std::list<valhalla::odin::Location>{});
+  std::unique_ptr<TripPath> built(TripPathBuilder::Build(controller, reader, mode_costing,
+                                                         pathedges, origin, dest,
+                                                         std::list<valhalla::odin::Location>{}));
+  TripPath trip_path = *built;
   t2 = std::chrono::high_resolution_clock::now();
   msecs = std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1).count();
   LOG_INFO("TripPathBuilder took " + std::to_string(msecs) + " ms");
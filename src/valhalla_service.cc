@@ -1,3 +1,4 @@
+#include <fstream>
 #include <functional>
 #include <iostream>
 #include <list>
@@ -8,6 +9,12 @@
 #include <string>
 #include <thread>
 #include <unordered_set>
+#include <vector>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
 
 #include "baldr/rapidjson_utils.h"
 #include <boost/property_tree/ptree.hpp>
@@ -21,6 +28,178 @@ using namespace prime_server;
 #include "loki/worker.h"
 #include "odin/worker.h"
 #include "thor/worker.h"
+#include "tyr/serializers.h"
+
+namespace {
+
+// Restricts worker threads to the cpus of a single numa node, round robin
+// by worker index. Worker threads fault tiles into their readers' caches
+// lazily, so with the kernels default first touch policy a pinned worker
+// ends up with node local tile memory instead of pulling half its tiles
+// across the socket interconnect on every graph expansion
+struct numa_pinner_t {
+  numa_pinner_t(bool enabled) {
+#ifdef __linux__
+    if (!enabled) {
+      return;
+    }
+    // discover the topology from sysfs, each node lists its cpus as
+    // ranges like "0-23,48-71"
+    for (size_t node = 0;; ++node) {
+      std::ifstream file("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+      std::string list;
+      if (!file || !std::getline(file, list)) {
+        break;
+      }
+      cpu_set_t cpus;
+      CPU_ZERO(&cpus);
+      std::stringstream ranges(list);
+      std::string range;
+      while (std::getline(ranges, range, ',')) {
+        auto dash = range.find('-');
+        size_t first = std::stoul(range.substr(0, dash));
+        size_t last = dash == std::string::npos ? first : std::stoul(range.substr(dash + 1));
+        for (size_t cpu = first; cpu <= last && cpu < CPU_SETSIZE; ++cpu) {
+          CPU_SET(cpu, &cpus);
+        }
+      }
+      nodes.push_back(cpus);
+    }
+    if (nodes.size() < 2) {
+      LOG_WARN("Numa pinning requested but " + std::to_string(nodes.size()) +
+               " node(s) found, leaving worker threads unpinned");
+      nodes.clear();
+    } else {
+      LOG_INFO("Pinning worker threads across " + std::to_string(nodes.size()) + " numa nodes");
+    }
+#else
+    if (enabled) {
+      LOG_WARN("Numa pinning is only supported on linux, leaving worker threads unpinned");
+    }
+#endif
+  }
+
+  void pin(std::thread& thread, size_t index) const {
+#ifdef __linux__
+    if (!nodes.empty()) {
+      pthread_setaffinity_np(thread.native_handle(), sizeof(cpu_set_t),
+                             &nodes[index % nodes.size()]);
+    }
+#endif
+  }
+
+#ifdef __linux__
+  std::vector<cpu_set_t> nodes;
+#endif
+};
+
+// A single stage running the whole pipeline: loki checks and correlates the
+// request, thor computes the path and odin narrates it, all within one
+// worker so the intermediate objects pass between stages by reference
+// instead of being serialized over the wire at every hand off. The three
+// workers share one tile reader per thread, mirroring tyr::actor_t.
+struct pipeline_worker_t {
+  pipeline_worker_t(const boost::property_tree::ptree& config)
+      : reader(new valhalla::baldr::GraphReader(config.get_child("mjolnir"))),
+        loki_worker(config, reader), thor_worker(config, reader), odin_worker(config) {
+  }
+
+  worker_t::result_t work(const std::list<zmq::message_t>& job,
+                          void* request_info,
+                          const std::function<void()>& interrupt_function) {
+    auto& info = *static_cast<http_request_info_t*>(request_info);
+    LOG_INFO("Got Request " + std::to_string(info.id));
+    valhalla::valhalla_request_t request;
+    try {
+      // request parsing
+      auto http_request = http_request_t::from_string(static_cast<const char*>(job.front().data()),
+                                                      job.front().size());
+      request.parse(http_request);
+
+      // check there is a valid action
+      if (!request.options.has_action()) {
+        return valhalla::jsonify_error({106}, info, request);
+      }
+
+      // enforce some limits
+      loki_worker.limits(request);
+
+      // set the interrupt function
+      loki_worker.set_interrupt(interrupt_function);
+      thor_worker.set_interrupt(interrupt_function);
+      odin_worker.set_interrupt(interrupt_function);
+
+      // run the stages for this action back to back, handing each stage the
+      // last ones output in memory
+      switch (request.options.action()) {
+        case valhalla::odin::DirectionsOptions::route: {
+          loki_worker.route(request);
+          auto legs = thor_worker.route(request);
+          auto directions = odin_worker.narrate(request, legs);
+          return valhalla::to_response_json(valhalla::tyr::serializeDirections(request, legs,
+                                                                               directions),
+                                            info, request);
+        }
+        case valhalla::odin::DirectionsOptions::optimized_route: {
+          loki_worker.matrix(request);
+          auto legs = thor_worker.optimized_route(request);
+          auto directions = odin_worker.narrate(request, legs);
+          return valhalla::to_response_json(valhalla::tyr::serializeDirections(request, legs,
+                                                                               directions),
+                                            info, request);
+        }
+        case valhalla::odin::DirectionsOptions::sources_to_targets:
+          loki_worker.matrix(request);
+          return valhalla::to_response_json(thor_worker.matrix(request), info, request);
+        case valhalla::odin::DirectionsOptions::isochrone:
+          loki_worker.isochrones(request);
+          return valhalla::to_response_json(thor_worker.isochrones(request), info, request);
+        case valhalla::odin::DirectionsOptions::one_to_all:
+          loki_worker.isochrones(request);
+          return valhalla::to_response_binary(thor_worker.one_to_all(request), info, request);
+        case valhalla::odin::DirectionsOptions::trace_route: {
+          loki_worker.trace(request);
+          std::list<valhalla::odin::TripPath*> legs{thor_worker.trace_route(request)};
+          auto directions = odin_worker.narrate(request, legs);
+          return valhalla::to_response_json(valhalla::tyr::serializeDirections(request, legs,
+                                                                               directions),
+                                            info, request);
+        }
+        case valhalla::odin::DirectionsOptions::trace_attributes:
+          loki_worker.trace(request);
+          return valhalla::to_response_json(thor_worker.trace_attributes(request), info, request);
+        case valhalla::odin::DirectionsOptions::locate:
+          return valhalla::to_response_json(loki_worker.locate(request), info, request);
+        case valhalla::odin::DirectionsOptions::height:
+          return valhalla::to_response_json(loki_worker.height(request), info, request);
+        case valhalla::odin::DirectionsOptions::transit_available:
+          return valhalla::to_response_json(loki_worker.transit_available(request), info, request);
+        default:
+          // apparently you wanted something that we figured we'd support but havent written yet
+          return valhalla::jsonify_error({107}, info, request);
+      }
+    } catch (const valhalla::valhalla_exception_t& e) {
+      valhalla::midgard::logging::Log("400::" + std::string(e.what()), " [ANALYTICS] ");
+      return valhalla::jsonify_error(e, info, request);
+    } catch (const std::exception& e) {
+      valhalla::midgard::logging::Log("400::" + std::string(e.what()), " [ANALYTICS] ");
+      return valhalla::jsonify_error({199, std::string(e.what())}, info, request);
+    }
+  }
+
+  void cleanup() {
+    loki_worker.cleanup();
+    thor_worker.cleanup();
+    odin_worker.cleanup();
+  }
+
+  std::shared_ptr<valhalla::baldr::GraphReader> reader;
+  valhalla::loki::loki_worker_t loki_worker;
+  valhalla::thor::thor_worker_t thor_worker;
+  valhalla::odin::odin_worker_t odin_worker;
+};
+
+} // namespace
 
 int main(int argc, char** argv) {
 
@@ -64,11 +243,16 @@ int main(int argc, char** argv) {
     valhalla::midgard::logging::Configure(logging_config);
   }
 
-  // number of workers to use at each stage
-  auto worker_concurrency = std::thread::hardware_concurrency();
-  if (argc > 2) {
-    worker_concurrency = std::stoul(argv[2]);
-  }
+  // number of workers to use at each stage. With httpd.service.autotune
+  // enabled the concurrency and the memory tunables not explicitly
+  // configured are derived from the hardware (cores, affinity mask and
+  // container limits); an explicit concurrency argument always wins
+  size_t requested_concurrency = argc > 2 ? std::stoul(argv[2]) : 0;
+  auto worker_concurrency = valhalla::autotune_config(config, requested_concurrency);
+
+  // on multi socket hosts optionally spread the worker threads over the
+  // numa nodes so each thread's tile cache stays in node local memory
+  numa_pinner_t pinner(config.get<bool>("httpd.service.numa_pinning", false));
 
   // setup the cluster within this process
   zmq::context_t context;
@@ -80,9 +264,39 @@ int main(int argc, char** argv) {
   std::thread loki_proxy_thread(
       std::bind(&proxy_t::forward, proxy_t(context, loki_proxy + "_in", loki_proxy + "_out")));
   loki_proxy_thread.detach();
+
+  // single process pipeline mode - each worker runs all three stages back
+  // to back so the intermediate results never cross a socket. The separate
+  // stage mode remains the default since it lets deployments scale the
+  // stages independently across processes or machines
+  if (config.get<bool>("httpd.service.single_pipeline", false)) {
+    std::list<std::thread> pipeline_worker_threads;
+    for (size_t i = 0; i < worker_concurrency; ++i) {
+      pipeline_worker_threads.emplace_back([&config, &loki_proxy, &loopback, &interrupt]() {
+        zmq::context_t context;
+        pipeline_worker_t pipeline_worker(config);
+        prime_server::worker_t worker(context, loki_proxy + "_out", "ipc:///dev/null", loopback,
+                                      interrupt,
+                                      std::bind(&pipeline_worker_t::work, std::ref(pipeline_worker),
+                                                std::placeholders::_1, std::placeholders::_2,
+                                                std::placeholders::_3),
+                                      std::bind(&pipeline_worker_t::cleanup,
+                                                std::ref(pipeline_worker)));
+        worker.work();
+      });
+      pinner.pin(pipeline_worker_threads.back(), i);
+      pipeline_worker_threads.back().detach();
+    }
+
+    // wait forever (or for interrupt)
+    server_thread.join();
+    return 0;
+  }
+
   std::list<std::thread> loki_worker_threads;
   for (size_t i = 0; i < worker_concurrency; ++i) {
     loki_worker_threads.emplace_back(valhalla::loki::run_service, config);
+    pinner.pin(loki_worker_threads.back(), i);
     loki_worker_threads.back().detach();
   }
 
@@ -93,6 +307,7 @@ int main(int argc, char** argv) {
   std::list<std::thread> thor_worker_threads;
   for (size_t i = 0; i < worker_concurrency; ++i) {
     thor_worker_threads.emplace_back(valhalla::thor::run_service, config);
+    pinner.pin(thor_worker_threads.back(), i);
     thor_worker_threads.back().detach();
   }
 
@@ -103,6 +318,7 @@ int main(int argc, char** argv) {
   std::list<std::thread> odin_worker_threads;
   for (size_t i = 0; i < worker_concurrency; ++i) {
     odin_worker_threads.emplace_back(valhalla::odin::run_service, config);
+    pinner.pin(odin_worker_threads.back(), i);
     odin_worker_threads.back().detach();
   }
 
@@ -17,6 +17,9 @@ int main(int argc, char** argv) {
   boost::property_tree::ptree config;
   rapidjson::read_json(config_file, config);
 
+  // fill in hardware derived tunables when autotune is enabled
+  valhalla::autotune_config(config);
+
   // run the service worker
   valhalla::thor::run_service(config);
 
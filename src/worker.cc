@@ -1,7 +1,28 @@
+#include <array>
+#include <cstring>
+#include <ctime>
+#include <fstream>
 #include <iostream>
+#include <mutex>
 #include <sstream>
+#include <thread>
 #include <unordered_map>
 
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+#ifndef _MSC_VER
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <boost/property_tree/ptree.hpp>
+
+#include "baldr/compression_utils.h"
 #include "baldr/datetime.h"
 #include "baldr/location.h"
 #include "midgard/encoded.h"
@@ -121,7 +142,7 @@ const std::unordered_map<unsigned, unsigned> ERROR_TO_STATUS{
 
     {420, 400}, {421, 400}, {422, 400}, {423, 400}, {424, 400},
 
-    {430, 400},
+    {430, 400}, {431, 503},
 
     {440, 400}, {441, 400}, {442, 400}, {443, 400}, {444, 400}, {445, 400},
 
@@ -245,6 +266,7 @@ const std::unordered_map<unsigned, std::string> OSRM_ERRORS_CODES{
      R"({"code":"InvalidValue","message":"The successfully parsed query parameters are invalid."})"},
 
     {430, R"({"code":"InvalidUrl","message":"URL string is invalid."})"},
+    {431, R"({"code":"ServiceUnavailable","message":"The service is temporarily unavailable."})"},
 
     {440, R"({"code":"InvalidUrl","message":"URL string is invalid."})"},
     {441, R"({"code":"InvalidUrl","message":"URL string is invalid."})"},
@@ -674,6 +696,18 @@ void from_json(rapidjson::Document& doc, odin::DirectionsOptions& options) {
     options.set_show_locations(*show_locations);
   }
 
+  // if specified, get the stage_trace boolean in there
+  auto stage_trace = rapidjson::get_optional<bool>(doc, "/stage_trace");
+  if (stage_trace) {
+    options.set_stage_trace(*stage_trace);
+  }
+
+  // if specified, get the reverse boolean in there
+  auto reverse = rapidjson::get_optional<bool>(doc, "/reverse");
+  if (reverse) {
+    options.set_reverse(*reverse);
+  }
+
   // if specified, get the shape_match in there
   auto shape_match_str = rapidjson::get_optional<std::string>(doc, "/shape_match");
   odin::ShapeMatch shape_match;
@@ -739,6 +773,38 @@ void from_json(rapidjson::Document& doc, odin::DirectionsOptions& options) {
                 allocator);
 }
 
+// Process wide per stage latency histograms with power of two millisecond
+// buckets. Every traced stage sample lands here and the aggregate is dumped to
+// the log periodically, so a p99 regression can be attributed to a stage after
+// the fact without per request logging
+constexpr size_t kStageHistogramBuckets = 16;
+constexpr uint32_t kStageHistogramLogInterval = 1000;
+std::mutex stage_histogram_mutex;
+std::unordered_map<std::string, std::array<uint64_t, kStageHistogramBuckets>> stage_histograms;
+uint32_t stage_histogram_samples = 0;
+
+void histogram_stage_sample(const std::string& stage, float elapsed_ms) {
+  // bucket i counts samples in [2^(i-1), 2^i) ms, anything slower than the
+  // last boundary lands in the last bucket
+  size_t bucket = 0;
+  while (bucket + 1 < kStageHistogramBuckets && elapsed_ms >= static_cast<float>(1u << bucket)) {
+    ++bucket;
+  }
+  std::lock_guard<std::mutex> lock(stage_histogram_mutex);
+  stage_histograms[stage][bucket]++;
+  if (++stage_histogram_samples % kStageHistogramLogInterval == 0) {
+    for (const auto& histogram : stage_histograms) {
+      std::string counts;
+      for (const auto count : histogram.second) {
+        counts += std::to_string(count) + ',';
+      }
+      counts.pop_back();
+      valhalla::midgard::logging::Log("valhalla_stage_histogram_" + histogram.first + "::" + counts,
+                                      " [ANALYTICS] ");
+    }
+  }
+}
+
 } // namespace
 
 namespace valhalla {
@@ -903,6 +969,75 @@ const std::string& FilterAction_Name(const odin::FilterAction action) {
 }
 } // namespace odin
 
+void add_stage_trace(odin::DirectionsOptions& options,
+                     const std::string& stage,
+                     float elapsed_ms,
+                     uint64_t labels_expanded) {
+  if (!options.do_not_track()) {
+    histogram_stage_sample(stage, elapsed_ms);
+  }
+  if (options.stage_trace()) {
+    auto* trace = options.add_stage_traces();
+    trace->set_stage(stage);
+    trace->set_elapsed_ms(elapsed_ms);
+    if (labels_expanded > 0) {
+      trace->set_labels_expanded(labels_expanded);
+    }
+  }
+}
+
+void parse_trace_shape(const rapidjson::Value& trace, odin::DirectionsOptions& options) {
+  options.clear_shape();
+  options.clear_encoded_polyline();
+
+  // the same two shape forms a single trace request accepts
+  auto encoded_polyline = rapidjson::get_optional<std::string>(trace, "/encoded_polyline");
+  if (encoded_polyline) {
+    options.set_encoded_polyline(*encoded_polyline);
+    auto decoded = midgard::decode<std::vector<midgard::PointLL>>(*encoded_polyline);
+    for (const auto& ll : decoded) {
+      auto* sll = options.mutable_shape()->Add();
+      sll->mutable_ll()->set_lat(ll.lat());
+      sll->mutable_ll()->set_lng(ll.lng());
+    }
+  } else {
+    auto shape = rapidjson::get_optional<rapidjson::Value::ConstArray>(trace, "/shape");
+    if (shape) {
+      for (const auto& point : *shape) {
+        auto lat = rapidjson::get_optional<float>(point, "/lat");
+        auto lon = rapidjson::get_optional<float>(point, "/lon");
+        if (!lat || !lon) {
+          throw valhalla_exception_t{134};
+        }
+        auto* sll = options.mutable_shape()->Add();
+        sll->mutable_ll()->set_lat(*lat);
+        sll->mutable_ll()->set_lng(midgard::circular_range_clamp<float>(*lon, -180, 180));
+        auto time = rapidjson::get_optional<unsigned int>(point, "/time");
+        if (time) {
+          sll->set_time(*time);
+        }
+        auto accuracy = rapidjson::get_optional<unsigned int>(point, "/accuracy");
+        if (accuracy) {
+          sll->set_accuracy(*accuracy);
+        }
+        auto radius = rapidjson::get_optional<unsigned int>(point, "/radius");
+        if (radius) {
+          sll->set_radius(*radius);
+        }
+      }
+    }
+  }
+  if (options.shape().empty()) {
+    throw valhalla_exception_t{114};
+  }
+
+  // an id so the caller can tell which result belongs to which trace
+  auto id = rapidjson::get_optional<std::string>(trace, "/id");
+  if (id) {
+    options.set_id(*id);
+  }
+}
+
 valhalla_exception_t::valhalla_exception_t(unsigned code, const boost::optional<std::string>& extra)
     : std::runtime_error(""), code(code), extra(extra) {
   auto code_iter = error_codes.find(code);
@@ -929,6 +1064,438 @@ void valhalla_request_t::parse(const std::string& request, const std::string& se
   // TODO: sanity check the parsed values
 }
 
+size_t autotune_config(boost::property_tree::ptree& config, size_t requested_concurrency) {
+  // an explicit count always wins, otherwise start from what the host claims
+  size_t concurrency =
+      requested_concurrency ? requested_concurrency
+                            : std::max(1u, std::thread::hardware_concurrency());
+  if (!config.get<bool>("httpd.service.autotune", false)) {
+    return concurrency;
+  }
+
+  uint64_t memory = 0;
+#ifdef __linux__
+  // the affinity mask is what the scheduler will actually let us run on
+  if (!requested_concurrency) {
+    cpu_set_t cpus;
+    if (sched_getaffinity(0, sizeof(cpus), &cpus) == 0 && CPU_COUNT(&cpus) > 0) {
+      concurrency = std::min(concurrency, static_cast<size_t>(CPU_COUNT(&cpus)));
+    }
+    // a cgroup cpu quota caps us below the core count in containers,
+    // v2 keeps "quota period" in one file, v1 splits them and uses -1
+    // for no quota
+    std::ifstream v2("/sys/fs/cgroup/cpu.max");
+    std::string quota;
+    uint64_t period = 0;
+    if (v2 && (v2 >> quota >> period) && quota != "max" && period != 0) {
+      concurrency = std::min(concurrency, std::max<size_t>(1, std::stoull(quota) / period));
+    } else {
+      std::ifstream quota_file("/sys/fs/cgroup/cpu/cpu.cfs_quota_us");
+      std::ifstream period_file("/sys/fs/cgroup/cpu/cpu.cfs_period_us");
+      int64_t v1_quota = 0;
+      int64_t v1_period = 0;
+      if (quota_file && (quota_file >> v1_quota) && period_file && (period_file >> v1_period) &&
+          v1_quota > 0 && v1_period > 0) {
+        concurrency = std::min(concurrency, std::max<size_t>(1, v1_quota / v1_period));
+      }
+    }
+  }
+
+  // what the host has to give right now beats its total
+  std::ifstream meminfo("/proc/meminfo");
+  std::string line;
+  while (meminfo && std::getline(meminfo, line)) {
+    if (line.compare(0, 13, "MemAvailable:") == 0) {
+      memory = std::stoull(line.substr(13)) * 1024;
+      break;
+    }
+  }
+  // a cgroup memory limit caps what we may actually allocate, unlimited
+  // shows up as "max" (v2) or an absurdly large number (v1)
+  for (const auto* path :
+       {"/sys/fs/cgroup/memory.max", "/sys/fs/cgroup/memory/memory.limit_in_bytes"}) {
+    std::ifstream file(path);
+    uint64_t limit = 0;
+    if (file && (file >> limit) && limit != 0 && limit < (1ull << 62)) {
+      memory = memory ? std::min(memory, limit) : limit;
+    }
+  }
+#endif
+  if (memory == 0) {
+    // no introspection available, be conservative rather than guessing big
+    memory = 1ull << 30;
+  }
+
+  LOG_INFO("Autotune detected " + std::to_string(concurrency) + " usable cpus and " +
+           std::to_string(memory >> 20) + "MB of usable memory");
+
+  // half the memory goes to tile caching - one process wide cache gets all
+  // of it, per thread caches split it. Values the deployment set explicitly
+  // always win over the derived ones
+  if (!config.get_optional<size_t>("mjolnir.max_cache_size")) {
+    bool shared_cache =
+        config.get<bool>("mjolnir.global_synchronized_cache", false) ||
+        config.get<bool>("mjolnir.sharded_cache", false) ||
+        static_cast<bool>(config.get_optional<std::string>("mjolnir.shared_cache_name"));
+    size_t cache_size = memory / 2 / (shared_cache ? 1 : concurrency);
+    config.put("mjolnir.max_cache_size", cache_size);
+    LOG_INFO("Autotune set mjolnir.max_cache_size to " + std::to_string(cache_size >> 20) + "MB");
+  }
+
+  // a quarter of the memory bounds the per request search trees so a burst
+  // of heavy requests degrades to partial results instead of an oom kill
+  if (!config.get_optional<uint64_t>("thor.request_memory_budget_mb")) {
+    uint64_t budget_mb = std::max<uint64_t>(1, memory / 4 / concurrency >> 20);
+    config.put("thor.request_memory_budget_mb", budget_mb);
+    LOG_INFO("Autotune set thor.request_memory_budget_mb to " + std::to_string(budget_mb));
+  }
+
+  // give a share of the threads to response serialization so workers get
+  // back to routing while large bodies are turned into bytes
+  if (!config.get_optional<size_t>("thor.serializer_threads")) {
+    size_t serializers = std::max<size_t>(1, concurrency / 4);
+    config.put("thor.serializer_threads", serializers);
+    LOG_INFO("Autotune set thor.serializer_threads to " + std::to_string(serializers));
+  }
+
+  // keep heavy requests from occupying every worker at once
+  if (!config.get_optional<uint32_t>("thor.max_heavy_requests")) {
+    uint32_t heavy = std::max<size_t>(1, concurrency / 2);
+    config.put("thor.max_heavy_requests", heavy);
+    LOG_INFO("Autotune set thor.max_heavy_requests to " + std::to_string(heavy));
+  }
+
+  return concurrency;
+}
+
+// The front of the message segment, the ring bytes follow directly after
+struct shm_message_arena_t::segment_header_t {
+#ifndef _MSC_VER
+  pthread_mutex_t lock;
+#endif
+  uint64_t magic;     // set last, under the lock, to signal initialization
+  uint64_t ring_size; // size of the message ring in bytes
+  uint64_t head;      // monotonic byte offset allocation has reached
+  uint64_t tail;      // monotonic byte offset of the oldest unreclaimed block
+  uint64_t sequence;  // stash counter, foils handles to reclaimed blocks
+};
+
+// Prefixes every stashed message in the ring
+struct shm_message_arena_t::block_header_t {
+  uint64_t sequence; // which stash the block belongs to
+  uint64_t stamp;    // when it was stashed or claimed, for abandoned reclaim
+  uint32_t size;     // payload bytes that follow
+  uint32_t state;    // ready, claimed or released
+};
+
+namespace {
+constexpr uint64_t MESSAGE_ARENA_MAGIC = 0x7367736d686c6176; // "valhmsgs"
+// a consumer normally shows up within milliseconds of the stash; a block
+// this old was dropped in flight (the request died between stages) and the
+// ring may take it back
+constexpr uint64_t ABANDONED_SECONDS = 60;
+// envelope messages carrying a handle instead of the bytes start with this
+const std::string HANDLE_PREFIX = "shm+pbf://";
+enum message_block_state_t : uint32_t { READY = 1, CLAIMED = 2, RELEASED = 3 };
+// payloads are padded so every block header lands 8 byte aligned
+constexpr uint64_t padded(uint64_t size) {
+  return (size + 7) & ~uint64_t(7);
+}
+} // namespace
+
+bool shm_message_arena_t::is_handle(const void* data, size_t size) {
+  return size > HANDLE_PREFIX.size() &&
+         memcmp(data, HANDLE_PREFIX.data(), HANDLE_PREFIX.size()) == 0;
+}
+
+bool shm_message_arena_t::is_handle(const std::string& message) {
+  return is_handle(message.data(), message.size());
+}
+
+std::shared_ptr<shm_message_arena_t>
+shm_message_arena_t::from_config(const boost::property_tree::ptree& config) {
+  // one segment per process no matter how many stages it runs, the first
+  // config to ask decides
+  static std::mutex mutex;
+  static std::shared_ptr<shm_message_arena_t> arena;
+  static bool checked = false;
+  std::lock_guard<std::mutex> lock(mutex);
+  if (!checked) {
+    checked = true;
+    if (config.get<bool>("httpd.service.shm_messaging", false)) {
+      try {
+        arena.reset(
+            new shm_message_arena_t(config.get<std::string>("httpd.service.shm_message_segment",
+                                                            "/valhalla_messages"),
+                                    config.get<size_t>("httpd.service.shm_message_size",
+                                                       64 * 1024 * 1024),
+                                    config.get<size_t>("httpd.service.shm_message_min_size",
+                                                       16384)));
+        LOG_INFO("Passing large intermediate messages through shared memory");
+      } catch (const std::exception& e) {
+        LOG_ERROR("Shared memory messaging disabled: " + std::string(e.what()));
+      }
+    }
+  }
+  return arena;
+}
+
+std::string shm_message_arena_t::stash(const std::string& bytes) {
+  if (header_ == nullptr || bytes.size() < min_message_size_) {
+    return {};
+  }
+  uint64_t offset, sequence;
+  char* block = allocate(bytes.size(), offset, sequence);
+  if (block == nullptr) {
+    return {};
+  }
+  memcpy(block, bytes.data(), bytes.size());
+  return HANDLE_PREFIX + segment_name_ + "/" + std::to_string(offset) + "/" +
+         std::to_string(sequence);
+}
+
+std::string shm_message_arena_t::stash(const google::protobuf::MessageLite& message) {
+  auto size = static_cast<size_t>(message.ByteSize());
+  if (header_ == nullptr || size < min_message_size_) {
+    return {};
+  }
+  uint64_t offset, sequence;
+  char* block = allocate(size, offset, sequence);
+  if (block == nullptr) {
+    return {};
+  }
+  // serialized exactly once, straight into the mapped bytes
+  if (!message.SerializeToArray(block, static_cast<int>(size))) {
+    release(offset, sequence);
+    return {};
+  }
+  return HANDLE_PREFIX + segment_name_ + "/" + std::to_string(offset) + "/" +
+         std::to_string(sequence);
+}
+
+bool shm_message_arena_t::fetch(const std::string& handle,
+                                const std::function<bool(const void*, size_t)>& use) {
+  size_t size;
+  uint64_t offset, sequence;
+  const char* bytes = claim(handle, size, offset, sequence);
+  if (bytes == nullptr) {
+    return false;
+  }
+  bool used = use(bytes, size);
+  release(offset, sequence);
+  return used;
+}
+
+bool shm_message_arena_t::fetch(const std::string& handle, std::string& bytes) {
+  return fetch(handle, [&bytes](const void* data, size_t size) {
+    bytes.assign(static_cast<const char*>(data), size);
+    return true;
+  });
+}
+
+#ifndef _MSC_VER
+
+// Constructor. Creates or attaches to the named segment.
+shm_message_arena_t::shm_message_arena_t(const std::string& segment_name,
+                                         size_t size,
+                                         size_t min_message_size)
+    : segment_name_(segment_name), segment_size_(0), min_message_size_(min_message_size),
+      header_(nullptr) {
+  size_t ring_size = padded(std::max<size_t>(size, 1024));
+  segment_size_ = sizeof(segment_header_t) + ring_size;
+
+  // first creator gets to initialize, everyone else just attaches
+  bool creator = true;
+  int fd = shm_open(segment_name_.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+  if (fd == -1 && errno == EEXIST) {
+    creator = false;
+    fd = shm_open(segment_name_.c_str(), O_RDWR, 0644);
+  }
+  if (fd == -1) {
+    throw std::runtime_error(segment_name_ + "(shm_open): " + strerror(errno));
+  }
+  if (creator && ftruncate(fd, segment_size_) == -1) {
+    close(fd);
+    throw std::runtime_error(segment_name_ + "(ftruncate): " + strerror(errno));
+  }
+  // attachers take whatever size the creator picked, which it may not have
+  // gotten around to setting quite yet
+  if (!creator) {
+    struct stat segment_stat {};
+    while (fstat(fd, &segment_stat) == 0 &&
+           static_cast<size_t>(segment_stat.st_size) < sizeof(segment_header_t)) {
+      sched_yield();
+    }
+    if (static_cast<size_t>(segment_stat.st_size) < sizeof(segment_header_t)) {
+      close(fd);
+      throw std::runtime_error(segment_name_ + "(fstat): " + strerror(errno));
+    }
+    segment_size_ = segment_stat.st_size;
+  }
+
+  void* base = mmap(nullptr, segment_size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (base == MAP_FAILED) {
+    throw std::runtime_error(segment_name_ + "(mmap): " + strerror(errno));
+  }
+  header_ = static_cast<segment_header_t*>(base);
+
+  // initialize the header, ring and process-shared lock exactly once
+  if (creator) {
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+    pthread_mutex_init(&header_->lock, &attr);
+    pthread_mutexattr_destroy(&attr);
+
+    header_->ring_size = ring_size;
+    header_->head = 0;
+    header_->tail = 0;
+    header_->sequence = 0;
+    __sync_synchronize();
+    header_->magic = MESSAGE_ARENA_MAGIC;
+  } // spin briefly until the creator finishes initializing
+  else {
+    while (header_->magic != MESSAGE_ARENA_MAGIC) {
+      sched_yield();
+    }
+  }
+}
+
+// Destructor. The segment stays alive for the other stages.
+shm_message_arena_t::~shm_message_arena_t() {
+  if (header_) {
+    munmap(header_, segment_size_);
+  }
+}
+
+char* shm_message_arena_t::allocate(const size_t size, uint64_t& offset, uint64_t& sequence) {
+  const uint64_t needed = sizeof(block_header_t) + padded(size);
+  auto* ring = reinterpret_cast<char*>(header_ + 1);
+  pthread_mutex_lock(&header_->lock);
+  const uint64_t ring_size = header_->ring_size;
+  if (needed > ring_size) {
+    pthread_mutex_unlock(&header_->lock);
+    return nullptr;
+  }
+  while (true) {
+    // a block may not straddle the end of the ring; the gap to the end is
+    // wasted, marked released when a header fits in it and recognized by its
+    // position when one doesnt
+    uint64_t pos = header_->head % ring_size;
+    uint64_t gap = pos + needed > ring_size ? ring_size - pos : 0;
+    if (header_->head + gap + needed - header_->tail <= ring_size) {
+      if (gap >= sizeof(block_header_t)) {
+        auto* filler = reinterpret_cast<block_header_t*>(ring + pos);
+        filler->sequence = 0;
+        filler->stamp = 0;
+        filler->size = static_cast<uint32_t>(gap - sizeof(block_header_t));
+        filler->state = RELEASED;
+      }
+      header_->head += gap;
+      auto* block = reinterpret_cast<block_header_t*>(ring + header_->head % ring_size);
+      block->sequence = sequence = ++header_->sequence;
+      block->stamp = static_cast<uint64_t>(time(nullptr));
+      block->size = static_cast<uint32_t>(size);
+      block->state = READY;
+      offset = header_->head;
+      header_->head += needed;
+      pthread_mutex_unlock(&header_->lock);
+      return reinterpret_cast<char*>(block + 1);
+    }
+    // make room by taking back the oldest block, if its been consumed or its
+    // consumer is long gone
+    uint64_t tail_pos = header_->tail % ring_size;
+    if (ring_size - tail_pos < sizeof(block_header_t)) {
+      header_->tail += ring_size - tail_pos;
+      continue;
+    }
+    auto* tail_block = reinterpret_cast<block_header_t*>(ring + tail_pos);
+    if (tail_block->state == RELEASED ||
+        static_cast<uint64_t>(time(nullptr)) - tail_block->stamp > ABANDONED_SECONDS) {
+      header_->tail += sizeof(block_header_t) + padded(tail_block->size);
+      continue;
+    }
+    // the oldest block is still in flight, the producer falls back to
+    // passing this message in the envelope
+    pthread_mutex_unlock(&header_->lock);
+    return nullptr;
+  }
+}
+
+const char* shm_message_arena_t::claim(const std::string& handle,
+                                       size_t& size,
+                                       uint64_t& offset,
+                                       uint64_t& sequence) {
+  // handles look like shm+pbf://<segment>/<offset>/<sequence>
+  if (header_ == nullptr || !is_handle(handle)) {
+    return nullptr;
+  }
+  auto sequence_pos = handle.find_last_of('/');
+  auto offset_pos =
+      sequence_pos == std::string::npos ? sequence_pos : handle.find_last_of('/', sequence_pos - 1);
+  if (offset_pos == std::string::npos || offset_pos <= HANDLE_PREFIX.size() ||
+      handle.compare(HANDLE_PREFIX.size(), offset_pos - HANDLE_PREFIX.size(), segment_name_) != 0) {
+    return nullptr;
+  }
+  try {
+    offset = std::stoull(handle.substr(offset_pos + 1, sequence_pos - offset_pos - 1));
+    sequence = std::stoull(handle.substr(sequence_pos + 1));
+  } catch (...) { return nullptr; }
+
+  auto* ring = reinterpret_cast<char*>(header_ + 1);
+  pthread_mutex_lock(&header_->lock);
+  auto* block = reinterpret_cast<block_header_t*>(ring + offset % header_->ring_size);
+  // a block thats already back in the ring (or was never there) is gone
+  if (offset < header_->tail || offset >= header_->head || block->sequence != sequence ||
+      block->state != READY) {
+    pthread_mutex_unlock(&header_->lock);
+    return nullptr;
+  }
+  block->state = CLAIMED;
+  block->stamp = static_cast<uint64_t>(time(nullptr));
+  size = block->size;
+  pthread_mutex_unlock(&header_->lock);
+  return reinterpret_cast<const char*>(block + 1);
+}
+
+void shm_message_arena_t::release(const uint64_t offset, const uint64_t sequence) {
+  auto* ring = reinterpret_cast<char*>(header_ + 1);
+  pthread_mutex_lock(&header_->lock);
+  auto* block = reinterpret_cast<block_header_t*>(ring + offset % header_->ring_size);
+  if (offset >= header_->tail && offset < header_->head && block->sequence == sequence) {
+    block->state = RELEASED;
+  }
+  pthread_mutex_unlock(&header_->lock);
+}
+
+#else
+
+// shm_open style segments are posix, elsewhere the mode quietly stays off
+shm_message_arena_t::shm_message_arena_t(const std::string& segment_name,
+                                         size_t,
+                                         size_t min_message_size)
+    : segment_name_(segment_name), segment_size_(0), min_message_size_(min_message_size),
+      header_(nullptr) {
+  throw std::runtime_error("shared memory messaging is not supported on this platform");
+}
+
+shm_message_arena_t::~shm_message_arena_t() {
+}
+
+char* shm_message_arena_t::allocate(const size_t, uint64_t&, uint64_t&) {
+  return nullptr;
+}
+
+const char* shm_message_arena_t::claim(const std::string&, size_t&, uint64_t&, uint64_t&) {
+  return nullptr;
+}
+
+void shm_message_arena_t::release(const uint64_t, const uint64_t) {
+}
+
+#endif
+
 #ifdef HAVE_HTTP
 void valhalla_request_t::parse(const http_request_t& request) {
 
@@ -987,6 +1554,12 @@ void valhalla_request_t::parse(const http_request_t& request) {
   options.set_do_not_track(options.do_not_track() ||
                            (do_not_track != request.headers.cend() && do_not_track->second == "1"));
 
+  // remember whether the client takes compressed responses; the flag rides
+  // the options down the pipeline to whichever stage serializes the response
+  auto accept_encoding = request.headers.find("Accept-Encoding");
+  options.set_accept_gzip(accept_encoding != request.headers.cend() &&
+                          accept_encoding->second.find("gzip") != std::string::npos);
+
   // parse out the options
   from_json(document, options);
 }
@@ -997,6 +1570,56 @@ const headers_t::value_type JS_MIME{"Content-type", "application/javascript;char
 const headers_t::value_type XML_MIME{"Content-type", "text/xml;charset=utf-8"};
 const headers_t::value_type GPX_MIME{"Content-type", "application/gpx+xml;charset=utf-8"};
 const headers_t::value_type ATTACHMENT{"Content-Disposition", "attachment; filename=route.gpx"};
+const headers_t::value_type OCTET_MIME{"Content-type", "application/octet-stream"};
+const headers_t::value_type GZIP_ENCODING{"Content-Encoding", "gzip"};
+
+namespace {
+// Bodies below this size ship uncompressed, the savings would not cover the
+// cpu spent or the header overhead
+constexpr size_t kMinimumCompressibleSize = 1024;
+
+/**
+ * Compresses a response body in place when the client advertised gzip support
+ * and the body is large enough to be worth it. On any failure the body ships
+ * uncompressed rather than failing the request.
+ * @param request  the request whose options say whether the client takes gzip
+ * @param body     the body, replaced with the gzipped bytes on success
+ * @return true when the body was compressed and the encoding header applies
+ */
+bool compress_response(const valhalla_request_t& request, std::string& body) {
+  if (!request.options.accept_gzip() || body.size() < kMinimumCompressibleSize) {
+    return false;
+  }
+
+  // the whole body is in memory already
+  auto src_func = [&body](z_stream& s) -> int {
+    s.next_in = static_cast<Byte*>(static_cast<void*>(&body[0]));
+    s.avail_in = static_cast<unsigned int>(body.size());
+    return Z_FINISH;
+  };
+
+  // grow the output in chunks sized so geojson-ish bodies finish in one or two
+  std::string compressed;
+  auto dst_func = [&compressed, &body](z_stream& s) -> void {
+    auto size = compressed.size();
+    if (s.total_out < size) {
+      compressed.resize(s.total_out);
+    } else {
+      compressed.resize(size + body.size() / 4 + 16);
+      s.next_out = static_cast<Byte*>(static_cast<void*>(&compressed[0] + size));
+      s.avail_out = static_cast<unsigned int>(compressed.size() - size);
+    }
+  };
+
+  // favor speed over ratio, responses are latency sensitive
+  if (!baldr::deflate(src_func, dst_func, Z_DEFAULT_COMPRESSION) ||
+      compressed.size() >= body.size()) {
+    return false;
+  }
+  body.swap(compressed);
+  return true;
+}
+} // namespace
 
 worker_t::result_t jsonify_error(const valhalla_exception_t& exception,
                                  http_request_info_t& request_info,
@@ -1046,9 +1669,14 @@ worker_t::result_t to_response(const baldr::json::ArrayPtr& array,
     stream << ')';
   }
 
+  auto body = stream.str();
+  headers_t headers{CORS, request.options.has_jsonp() ? JS_MIME : JSON_MIME};
+  if (compress_response(request, body)) {
+    headers.insert(GZIP_ENCODING);
+  }
+
   worker_t::result_t result{false};
-  http_response_t response(200, "OK", stream.str(),
-                           headers_t{CORS, request.options.has_jsonp() ? JS_MIME : JSON_MIME});
+  http_response_t response(200, "OK", body, headers);
   response.from_info(request_info);
   result.messages.emplace_back(response.to_string());
   return result;
@@ -1067,9 +1695,14 @@ worker_t::result_t to_response(const baldr::json::MapPtr& map,
     stream << ')';
   }
 
+  auto body = stream.str();
+  headers_t headers{CORS, request.options.has_jsonp() ? JS_MIME : JSON_MIME};
+  if (compress_response(request, body)) {
+    headers.insert(GZIP_ENCODING);
+  }
+
   worker_t::result_t result{false};
-  http_response_t response(200, "OK", stream.str(),
-                           headers_t{CORS, request.options.has_jsonp() ? JS_MIME : JSON_MIME});
+  http_response_t response(200, "OK", body, headers);
   response.from_info(request_info);
   result.messages.emplace_back(response.to_string());
   return result;
@@ -1088,9 +1721,14 @@ worker_t::result_t to_response_json(const std::string& json,
     stream << ')';
   }
 
+  auto body = stream.str();
+  headers_t headers{CORS, request.options.has_jsonp() ? JS_MIME : JSON_MIME};
+  if (compress_response(request, body)) {
+    headers.insert(GZIP_ENCODING);
+  }
+
   worker_t::result_t result{false};
-  http_response_t response(200, "OK", stream.str(),
-                           headers_t{CORS, request.options.has_jsonp() ? JS_MIME : JSON_MIME});
+  http_response_t response(200, "OK", body, headers);
   response.from_info(request_info);
   result.messages.emplace_back(response.to_string());
   return result;
@@ -1099,13 +1737,95 @@ worker_t::result_t to_response_json(const std::string& json,
 worker_t::result_t to_response_xml(const std::string& xml,
                                    http_request_info_t& request_info,
                                    const valhalla_request_t& request) {
+  auto body = xml;
+  headers_t headers{CORS, GPX_MIME, ATTACHMENT};
+  if (compress_response(request, body)) {
+    headers.insert(GZIP_ENCODING);
+  }
+
+  worker_t::result_t result{false};
+  http_response_t response(200, "OK", body, headers);
+  response.from_info(request_info);
+  result.messages.emplace_back(response.to_string());
+  return result;
+}
+
+worker_t::result_t to_response_binary(std::string&& data,
+                                      http_request_info_t& request_info,
+                                      const valhalla_request_t& request) {
+  auto body = std::move(data);
+  headers_t headers{CORS, OCTET_MIME};
+  if (compress_response(request, body)) {
+    headers.insert(GZIP_ENCODING);
+  }
+
   worker_t::result_t result{false};
-  http_response_t response(200, "OK", xml, headers_t{CORS, GPX_MIME, ATTACHMENT});
+  http_response_t response(200, "OK", body, headers);
   response.from_info(request_info);
   result.messages.emplace_back(response.to_string());
   return result;
 }
 
+response_executor_t::response_executor_t(const std::string& loopback_endpoint, size_t thread_count)
+    : stop(false) {
+  threads.reserve(thread_count);
+  for (size_t i = 0; i < thread_count; ++i) {
+    threads.emplace_back(&response_executor_t::run, this, loopback_endpoint);
+  }
+}
+
+response_executor_t::~response_executor_t() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stop = true;
+  }
+  signal.notify_all();
+  for (auto& thread : threads) {
+    thread.join();
+  }
+}
+
+bool response_executor_t::enabled() const {
+  return !threads.empty();
+}
+
+void response_executor_t::post(task_t&& task) {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    tasks.emplace_back(std::move(task));
+  }
+  signal.notify_one();
+}
+
+void response_executor_t::run(const std::string& loopback_endpoint) {
+  // each pool thread ships the responses it serializes on its own socket
+  zmq::socket_t loopback(context, ZMQ_PUSH);
+  loopback.connect(loopback_endpoint.c_str());
+  while (true) {
+    task_t task;
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      signal.wait(lock, [this] { return stop || !tasks.empty(); });
+      // drain whats queued before stopping so no accepted request goes unanswered
+      if (tasks.empty()) {
+        return;
+      }
+      task = std::move(tasks.front());
+      tasks.pop_front();
+    }
+    try {
+      auto result = task();
+      for (const auto& message : result.messages) {
+        loopback.send(message, ZMQ_DONTWAIT);
+      }
+    } catch (...) {
+      // tasks are expected to turn their own failures into error responses,
+      // anything escaping here would abandon the client to a timeout
+      LOG_ERROR("response executor task failed to produce a response");
+    }
+  }
+}
+
 #endif
 
 service_worker_t::service_worker_t() : interrupt(nullptr) {
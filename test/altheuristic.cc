@@ -0,0 +1,94 @@
+#include "test.h"
+
+#include "thor/altheuristic.h"
+
+#include <cmath>
+
+using namespace std;
+using namespace valhalla::midgard;
+using namespace valhalla::thor;
+
+namespace {
+
+// A line of 5 nodes, 10 cost apart, with node 0 as the landmark:
+//   0 --10-- 1 --10-- 2 --10-- 3 --10-- 4
+std::shared_ptr<const std::vector<ALTHeuristic::landmark_t>> make_landmarks() {
+  ALTHeuristic::landmark_t landmark;
+  for (uint64_t node = 0; node < 5; ++node) {
+    landmark.from_landmark[node] = node * 10.0f;
+    landmark.to_landmark[node] = node * 10.0f;
+  }
+  auto landmarks = std::make_shared<std::vector<ALTHeuristic::landmark_t>>();
+  landmarks->push_back(std::move(landmark));
+  return landmarks;
+}
+
+void TestLandmarkBound() {
+  ALTHeuristic h;
+  h.SetLandmarks(make_landmarks());
+
+  // target is node 4, locations close together so the distance fallback
+  // is effectively 0 and the landmark bound dominates
+  PointLL ll(0.0f, 0.0f);
+  h.Init(4, ll, 1.0f);
+
+  // from node 1 the triangle inequality gives |40 - 10| = 30, the true cost
+  if (std::fabs(h.Get(1, ll) - 30.0f) > 0.001f)
+    throw runtime_error("landmark bound from node 1 should be 30");
+  if (std::fabs(h.Get(3, ll) - 10.0f) > 0.001f)
+    throw runtime_error("landmark bound from node 3 should be 10");
+  if (std::fabs(h.Get(4, ll)) > 0.001f)
+    throw runtime_error("landmark bound at the target should be 0");
+}
+
+void TestFallback() {
+  ALTHeuristic h;
+  h.SetLandmarks(make_landmarks());
+  PointLL target_ll(0.0f, 0.0f);
+  PointLL node_ll(1.0f, 0.0f);
+  h.Init(4, target_ll, 1.0f);
+
+  // a node missing from the tables gets the distance based bound
+  AStarHeuristic plain;
+  plain.Init(target_ll, 1.0f);
+  if (std::fabs(h.Get(99, node_ll) - plain.Get(node_ll)) > 0.001f)
+    throw runtime_error("uncovered node should fall back to the distance bound");
+
+  // with no landmark tables at all it behaves exactly like plain A*
+  ALTHeuristic bare;
+  bare.Init(4, target_ll, 1.0f);
+  if (std::fabs(bare.Get(1, node_ll) - plain.Get(node_ll)) > 0.001f)
+    throw runtime_error("landmark-less heuristic should equal the distance bound");
+}
+
+void TestNeverBelowFallback() {
+  ALTHeuristic h;
+  h.SetLandmarks(make_landmarks());
+  PointLL target_ll(0.0f, 0.0f);
+  PointLL node_ll(2.0f, 0.0f);
+  h.Init(4, target_ll, 1.0f);
+
+  AStarHeuristic plain;
+  plain.Init(target_ll, 1.0f);
+
+  // even where the landmark bound is weak the estimate must not drop
+  // below the admissible distance bound
+  for (uint64_t node = 0; node < 5; ++node) {
+    if (h.Get(node, node_ll) < plain.Get(node_ll) - 0.001f)
+      throw runtime_error("ALT bound should never be below the distance bound");
+  }
+}
+
+} // namespace
+
+int main() {
+  test::suite suite("altheuristic");
+
+  suite.test(TEST_CASE(TestLandmarkBound));
+
+  suite.test(TEST_CASE(TestFallback));
+
+  suite.test(TEST_CASE(TestNeverBelowFallback));
+
+  return suite.tear_down();
+}
@@ -1,5 +1,6 @@
 #include "test.h"
 #include <cstdint>
+#include <memory>
 
 #include <valhalla/baldr/rapidjson_utils.h>
 
@@ -389,13 +390,14 @@ void trivial_path_no_uturns(const std::string& config_file) {
                         *directions_options.mutable_locations(1), graph_reader, mode_costing, mode);
 
   vt::AttributesController controller;
-  vo::TripPath trip_path =
+  std::unique_ptr<vo::TripPath> trip_path(
       vt::TripPathBuilder::Build(controller, graph_reader, mode_costing, path,
                                  *directions_options.mutable_locations(0),
-                                 *directions_options.mutable_locations(1), std::list<vo::Location>{});
+                                 *directions_options.mutable_locations(1),
+                                 std::list<vo::Location>{}));
   // really could of got the total of the elapsed_time.
   vo::DirectionsBuilder directions;
-  vo::TripDirections trip_directions = directions.Build(directions_options, trip_path);
+  vo::TripDirections trip_directions = directions.Build(directions_options, *trip_path);
 
   if (trip_directions.summary().time() != 0) {
     std::ostringstream ostr;
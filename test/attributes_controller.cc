@@ -127,6 +127,32 @@ void TestAdminAttributeEnabled() {
   TryCategoryAttributeEnabled(controller, kAdminCategory, true);
 }
 
+void TestCompiledMasks() {
+  AttributesController controller;
+
+  // Default route attributes - everything on, so every mask test passes
+  if (!controller(kEdgeNames) || !controller(kNodeType) || !controller(kShape))
+    throw runtime_error("Incorrect compiled mask for enabled attribute");
+  if (controller.group_mask(kEdgeGroup) == 0 || controller.group_mask(kNodeGroup) == 0 ||
+      controller.group_mask(kCommonGroup) == 0)
+    throw runtime_error("Incorrect group mask for enabled attributes");
+
+  // Disabling everything zeroes every group
+  controller.disable_all();
+  if (controller(kEdgeNames) || controller.group_mask(kEdgeGroup) != 0 ||
+      controller.group_mask(kNodeGroup) != 0 || controller.group_mask(kCommonGroup) != 0)
+    throw runtime_error("Incorrect group mask for disabled attributes");
+
+  // Direct map mutation takes effect once the masks are recompiled
+  controller.attributes.at(kEdgeSpeed) = true;
+  if (controller(kEdgeSpeed))
+    throw runtime_error("Masks should be stale until compile is called");
+  controller.compile();
+  if (!controller(kEdgeSpeed) || controller(kEdgeNames) ||
+      controller.group_mask(kNodeGroup) != 0)
+    throw runtime_error("Incorrect compiled mask after recompile");
+}
+
 } // namespace
 
 int main() {
@@ -150,5 +176,8 @@ int main() {
   // Test admin category_attribute_enabled
   suite.test(TEST_CASE(TestAdminAttributeEnabled));
 
+  // Test the compiled bit masks
+  suite.test(TEST_CASE(TestCompiledMasks));
+
   return suite.tear_down();
 }
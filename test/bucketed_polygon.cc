@@ -0,0 +1,95 @@
+#include "midgard/bucketed_polygon.h"
+
+#include "test.h"
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "midgard/pointll.h"
+
+using namespace std;
+using namespace valhalla::midgard;
+
+namespace {
+
+void TestSquare() {
+  // a closed unit square
+  std::vector<PointLL> ring{{0.f, 0.f}, {1.f, 0.f}, {1.f, 1.f}, {0.f, 1.f}, {0.f, 0.f}};
+  BucketedPolygon poly(ring);
+
+  if (!poly.Contains({0.5f, 0.5f}))
+    throw runtime_error("Center of the square should be inside");
+  if (poly.Contains({1.5f, 0.5f}))
+    throw runtime_error("Point right of the square should be outside");
+  if (poly.Contains({0.5f, -0.5f}))
+    throw runtime_error("Point below the square should be outside");
+  if (poly.Contains({-2.f, 3.f}))
+    throw runtime_error("Point outside the bbox should be outside");
+}
+
+void TestOpenRing() {
+  // the same square without the closing duplicate point
+  std::vector<PointLL> ring{{0.f, 0.f}, {1.f, 0.f}, {1.f, 1.f}, {0.f, 1.f}};
+  BucketedPolygon poly(ring);
+
+  if (!poly.Contains({0.5f, 0.5f}))
+    throw runtime_error("Open ring should close itself");
+  if (poly.Contains({1.25f, 0.5f}))
+    throw runtime_error("Open ring should not leak containment");
+}
+
+void TestConcave() {
+  // a u shape, the notch between the prongs is outside
+  std::vector<PointLL> ring{{0.f, 0.f}, {3.f, 0.f}, {3.f, 3.f}, {2.f, 3.f},
+                            {2.f, 1.f}, {1.f, 1.f}, {1.f, 3.f}, {0.f, 3.f}};
+  BucketedPolygon poly(ring);
+
+  if (!poly.Contains({0.5f, 2.f}))
+    throw runtime_error("Left prong should be inside");
+  if (!poly.Contains({2.5f, 2.f}))
+    throw runtime_error("Right prong should be inside");
+  if (poly.Contains({1.5f, 2.f}))
+    throw runtime_error("The notch should be outside");
+  if (!poly.Contains({1.5f, 0.5f}))
+    throw runtime_error("The base should be inside");
+}
+
+void TestMatchesWithinPolygon() {
+  // a jagged star shaped ring exercises many bands; the bucketed result
+  // must agree with the scalar winding test away from the boundary
+  std::default_random_engine generator(1729);
+  std::uniform_real_distribution<float> jitter(0.5f, 1.f);
+  std::vector<PointLL> ring;
+  const int spokes = 101;
+  for (int i = 0; i < spokes; ++i) {
+    float angle = 2.f * 3.14159265f * i / spokes;
+    float radius = jitter(generator);
+    ring.emplace_back(radius * cosf(angle), radius * sinf(angle));
+  }
+  BucketedPolygon poly(ring);
+
+  std::uniform_real_distribution<float> coord(-1.1f, 1.1f);
+  for (int i = 0; i < 10000; ++i) {
+    PointLL point(coord(generator), coord(generator));
+    if (poly.Contains(point) != point.WithinPolygon(ring))
+      throw runtime_error("Bucketed test disagrees with WithinPolygon at " +
+                          std::to_string(point.lng()) + "," + std::to_string(point.lat()));
+  }
+}
+
+} // namespace
+
+int main() {
+  test::suite suite("bucketed_polygon");
+
+  suite.test(TEST_CASE(TestSquare));
+
+  suite.test(TEST_CASE(TestOpenRing));
+
+  suite.test(TEST_CASE(TestConcave));
+
+  suite.test(TEST_CASE(TestMatchesWithinPolygon));
+
+  return suite.tear_down();
+}
@@ -0,0 +1,110 @@
+#include "test.h"
+
+#include "thor/contractionhierarchy.h"
+
+#include <cmath>
+
+using namespace std;
+using namespace valhalla::thor;
+
+namespace {
+
+// A small grid-ish graph with a fast corridor through the middle:
+//
+//   0 --1-- 1 --1-- 2
+//   |       |       |
+//   5       1       5
+//   |       |       |
+//   3 --1-- 4 --1-- 5
+//
+// every pictured edge exists in both directions
+ContractionHierarchy make_graph() {
+  ContractionHierarchy ch(6);
+  auto both = [&ch](uint32_t a, uint32_t b, float w) {
+    ch.AddEdge(a, b, w);
+    ch.AddEdge(b, a, w);
+  };
+  both(0, 1, 1.0f);
+  both(1, 2, 1.0f);
+  both(0, 3, 5.0f);
+  both(1, 4, 1.0f);
+  both(2, 5, 5.0f);
+  both(3, 4, 1.0f);
+  both(4, 5, 1.0f);
+  ch.Build();
+  return ch;
+}
+
+void TestCost() {
+  auto ch = make_graph();
+
+  // corner to corner goes through the corridor, not the side edges
+  if (std::fabs(ch.Cost(0, 5) - 3.0f) > 0.001f)
+    throw runtime_error("0->5 should cost 3 via 1 and 4");
+  if (std::fabs(ch.Cost(3, 2) - 3.0f) > 0.001f)
+    throw runtime_error("3->2 should cost 3 via 4 and 1");
+  if (std::fabs(ch.Cost(0, 0)) > 0.001f)
+    throw runtime_error("trivial query should cost 0");
+
+  // an unreachable target costs infinity
+  ContractionHierarchy disconnected(3);
+  disconnected.AddEdge(0, 1, 1.0f);
+  disconnected.Build();
+  if (disconnected.Cost(0, 2) != std::numeric_limits<float>::infinity())
+    throw runtime_error("unreachable target should cost infinity");
+  if (disconnected.Cost(1, 0) != std::numeric_limits<float>::infinity())
+    throw runtime_error("directed edge should not be usable backwards");
+}
+
+void TestPath() {
+  auto ch = make_graph();
+
+  // unpacking must reproduce the original node sequence, shortcuts or not
+  std::vector<uint32_t> expected = {0, 1, 4, 5};
+  if (ch.Path(0, 5) != expected)
+    throw runtime_error("0->5 path should be 0,1,4,5");
+
+  expected = {3, 4, 1, 2};
+  if (ch.Path(3, 2) != expected)
+    throw runtime_error("3->2 path should be 3,4,1,2");
+
+  expected = {5, 4, 3};
+  if (ch.Path(5, 3) != expected)
+    throw runtime_error("5->3 path should be 5,4,3");
+}
+
+void TestLine() {
+  // a long line graph forces shortcuts over the interior nodes
+  constexpr uint32_t n = 64;
+  ContractionHierarchy ch(n);
+  for (uint32_t i = 0; i + 1 < n; ++i) {
+    ch.AddEdge(i, i + 1, 1.0f);
+    ch.AddEdge(i + 1, i, 1.0f);
+  }
+  ch.Build();
+  if (ch.shortcut_count() == 0)
+    throw runtime_error("contracting a line should add shortcuts");
+  if (std::fabs(ch.Cost(0, n - 1) - (n - 1)) > 0.001f)
+    throw runtime_error("line end to end cost should be its length");
+  auto path = ch.Path(0, n - 1);
+  if (path.size() != n)
+    throw runtime_error("unpacked line path should visit every node");
+  for (uint32_t i = 0; i < n; ++i) {
+    if (path[i] != i)
+      throw runtime_error("unpacked line path should be in order");
+  }
+}
+
+} // namespace
+
+int main() {
+  test::suite suite("contractionhierarchy");
+
+  suite.test(TEST_CASE(TestCost));
+
+  suite.test(TEST_CASE(TestPath));
+
+  suite.test(TEST_CASE(TestLine));
+
+  return suite.tear_down();
+}
@@ -82,6 +82,15 @@ void TestWriteRead() {
   if (directededge.name_consistency(6) != false) {
     throw runtime_error("DirectedEdge name_consistency overwrite idx 6 test failed");
   }
+
+  // tiles that predate the pre-resolution leave the truck envelope bit unset
+  if (directededge.default_truck_ok() != false) {
+    throw runtime_error("DirectedEdge default_truck_ok should default to false");
+  }
+  directededge.set_default_truck_ok(true);
+  if (directededge.default_truck_ok() != true) {
+    throw runtime_error("DirectedEdge default_truck_ok test failed");
+  }
 }
 
 void TestMaxSlope() {
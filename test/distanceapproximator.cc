@@ -34,6 +34,22 @@ void TestDistanceSquaredFromTestPt() {
   TryDistanceSquaredFromTestPt(p1, p2, p1.Distance(p2));
 }
 
+void TestBatchDistanceSquared() {
+  // The batch form must agree with per-point calls
+  PointLL testpt(-79.0f, 41.0f);
+  DistanceApproximator approx(testpt);
+  std::vector<PointLL> pts;
+  for (uint32_t i = 0; i < 37; ++i) {
+    pts.emplace_back(-80.0f + i * 0.05f, 40.0f + i * 0.04f);
+  }
+  std::vector<float> d2(pts.size());
+  approx.DistanceSquared(pts.data(), pts.size(), d2.data());
+  for (uint32_t i = 0; i < pts.size(); ++i) {
+    if (d2[i] != approx.DistanceSquared(pts[i]))
+      throw runtime_error("Batch DistanceSquared does not match per-point calls");
+  }
+}
+
 void TryDistanceSquared(const PointLL& a, const PointLL& b, const float d2) {
   // Test if distance is > 2% the spherical distance
   float d = sqrtf(DistanceApproximator::DistanceSquared(a, b));
@@ -60,6 +76,9 @@ int main() {
   // Test distance squared from a test point
   suite.test(TEST_CASE(TestDistanceSquaredFromTestPt));
 
+  // Test the batch form against per-point calls
+  suite.test(TEST_CASE(TestBatchDistanceSquared));
+
   // Test distance squared between 2 points
   suite.test(TEST_CASE(TestDistanceSquared));
 
@@ -80,6 +80,49 @@ void TestClear() {
   TryClear(costs);
 }
 
+void TestReuse() {
+  std::vector<uint32_t> costs = {67,  325, 25,  466,   1000, 100005,
+                                 758, 167, 258, 16442, 278,  111111000};
+  std::vector<uint32_t> expectedorder = costs;
+  std::sort(expectedorder.begin(), expectedorder.end());
+
+  // Fill a queue, leave labels behind, then reuse it for a second search.
+  // The second search must behave exactly like a freshly constructed queue.
+  std::vector<float> edgelabels;
+  const auto edgecost = [&edgelabels](const uint32_t label) { return edgelabels[label]; };
+  DoubleBucketQueue adjlist(0, 10000, 5, edgecost);
+  uint32_t i = 0;
+  for (auto cost : costs) {
+    edgelabels.emplace_back(cost);
+    adjlist.add(i);
+    i++;
+  }
+  adjlist.pop();
+
+  edgelabels.clear();
+  adjlist.reuse(0, 10000, 5, edgecost);
+  i = 0;
+  for (auto cost : costs) {
+    edgelabels.emplace_back(cost);
+    adjlist.add(i);
+    i++;
+  }
+  uint32_t idx = 0;
+  while (true) {
+    uint32_t label = adjlist.pop();
+    if (label == kInvalidLabel) {
+      break;
+    }
+    if (edgelabels[label] != expectedorder[idx]) {
+      throw runtime_error("TestReuse: expected order test failed");
+    }
+    idx++;
+  }
+  if (idx != costs.size()) {
+    throw runtime_error("TestReuse: all labels added after reuse should pop");
+  }
+}
+
 /**
    void TestDecreseCost() {
    std::vector<uint32_t> costs = { 67, 325, 25, 466, 1000, 100005, 758, 167,
@@ -162,6 +205,19 @@ void TrySimulation(DoubleBucketQueue& dbqueue,
   TryRemove(dbqueue, addedLabels.size(), costs);
 }
 
+void TestAdaptiveRange() {
+  // Costs spread far beyond the initial bucket range so the queue has to
+  // grow its range several times while draining the overflow bucket. The
+  // pop order must stay sorted throughout the growth.
+  std::vector<uint32_t> costs;
+  for (uint32_t cost = 0; cost < 900000; cost += 7919) {
+    costs.push_back(cost);
+  }
+  std::vector<uint32_t> expectedorder = costs;
+  std::sort(expectedorder.begin(), expectedorder.end());
+  TryAddRemove(costs, expectedorder);
+}
+
 void TestSimulation() {
   {
     std::vector<float> costs;
@@ -199,6 +255,10 @@ int main() {
 
   suite.test(TEST_CASE(TestClear));
 
+  suite.test(TEST_CASE(TestReuse));
+
+  suite.test(TEST_CASE(TestAdaptiveRange));
+
   //  suite.test(TEST_CASE(TestDecreaseCost));
 
   suite.test(TEST_CASE(TestSimulation));
@@ -108,6 +108,93 @@ void TestWriteRead() {
   }
 }
 
+void TestShapeIndex() {
+  // Make a long shape, several checkpoints worth of vertices
+  EdgeInfoBuilder eibuilder;
+  eibuilder.set_index_shape(true);
+  std::vector<PointLL> shape;
+  for (size_t i = 0; i < 150; ++i) {
+    shape.push_back(PointLL(-76.3 + i * .001, 40.04 + (i % 7) * .0004));
+  }
+  eibuilder.set_shape(shape);
+  boost::shared_array<char> memblock = ToFileAndBack(eibuilder);
+
+  // Full decode as the reference (encoding quantizes so compare against it)
+  std::unique_ptr<EdgeInfo> ref(new EdgeInfo(memblock.get(), nullptr, 0, true));
+  const auto& reference = ref->shape();
+  if (reference.size() != shape.size())
+    throw runtime_error("ShapeIndex: shape count mismatch");
+
+  std::unique_ptr<EdgeInfo> ei(new EdgeInfo(memblock.get(), nullptr, 0, true));
+  if (!ei->has_shape_index())
+    throw runtime_error("ShapeIndex: index missing on a long shape");
+
+  // A decoder positioned mid shape picks up exactly where a full decode
+  // would be at that vertex
+  for (uint32_t want : {0u, 5u, 31u, 32u, 33u, 64u, 100u, 149u}) {
+    uint32_t vertex = want;
+    auto decoder = ei->lazy_shape_at(vertex);
+    if (vertex > want || want - vertex >= kShapeIndexSampleRate)
+      throw runtime_error("ShapeIndex: snapped too far from the wanted vertex");
+    size_t i = vertex;
+    while (!decoder.empty()) {
+      if (!decoder.pop().ApproximatelyEqual(reference[i]))
+        throw runtime_error("ShapeIndex: wrong point at vertex " + std::to_string(i));
+      ++i;
+    }
+    if (i != reference.size())
+      throw runtime_error("ShapeIndex: decoder ended early");
+  }
+
+  // The trailing piece is a suffix of the shape covering the distance
+  float length = reference.back().Distance(reference[reference.size() - 2]) * 5;
+  auto tail = ei->shape_tail(length);
+  if (tail.empty() || tail.size() >= reference.size())
+    throw runtime_error("ShapeIndex: tail should be a proper piece of the shape");
+  float along = 0.f;
+  for (size_t i = 0; i < tail.size(); ++i) {
+    if (!tail[i].ApproximatelyEqual(reference[reference.size() - tail.size() + i]))
+      throw runtime_error("ShapeIndex: tail is not a suffix of the shape");
+    if (i > 0)
+      along += tail[i].Distance(tail[i - 1]);
+  }
+  if (along <= length)
+    throw runtime_error("ShapeIndex: tail does not cover the distance");
+
+  // The leading piece covers the distance without decoding everything
+  auto head = ei->shape_head(length);
+  if (head.size() < 2 || head.size() >= reference.size())
+    throw runtime_error("ShapeIndex: head should be a proper piece of the shape");
+  for (size_t i = 0; i < head.size(); ++i) {
+    if (!head[i].ApproximatelyEqual(reference[i]))
+      throw runtime_error("ShapeIndex: head is not a prefix of the shape");
+  }
+
+  // Asking for more than the shape has yields the whole thing
+  if (ei->shape_tail(1e10f).size() != reference.size() ||
+      ei->shape_head(1e10f).size() != reference.size())
+    throw runtime_error("ShapeIndex: overlong requests should return the whole shape");
+
+  // A reader that cannot trust the flag (an old tile) ignores the index
+  std::unique_ptr<EdgeInfo> untrusted(new EdgeInfo(memblock.get(), nullptr, 0));
+  if (untrusted->has_shape_index())
+    throw runtime_error("ShapeIndex: untrusted reader should not see an index");
+  if (untrusted->shape().size() != reference.size())
+    throw runtime_error("ShapeIndex: untrusted reader should still decode the shape");
+
+  // Short shapes get no index even when asked for one
+  EdgeInfoBuilder short_builder;
+  short_builder.set_index_shape(true);
+  std::vector<PointLL> short_shape{PointLL(-76.3002, 40.0433), PointLL(-76.3036, 40.043)};
+  short_builder.set_shape(short_shape);
+  boost::shared_array<char> short_block = ToFileAndBack(short_builder);
+  std::unique_ptr<EdgeInfo> short_ei(new EdgeInfo(short_block.get(), nullptr, 0, true));
+  if (short_ei->has_shape_index())
+    throw runtime_error("ShapeIndex: short shapes should not carry an index");
+  if (short_ei->shape().size() != short_shape.size())
+    throw runtime_error("ShapeIndex: short shape decode failed");
+}
+
 } // namespace
 
 int main() {
@@ -116,5 +203,8 @@ int main() {
   // Write to file and read into EdgeInfo
   suite.test(TEST_CASE(TestWriteRead));
 
+  // Shape vertex checkpoint index
+  suite.test(TEST_CASE(TestShapeIndex));
+
   return suite.tear_down();
 }
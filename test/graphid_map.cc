@@ -0,0 +1,153 @@
+#include "test.h"
+
+#include "baldr/graphid_map.h"
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+using namespace valhalla::baldr;
+
+namespace {
+
+void TestInsertFind() {
+  graphid_map<int> map;
+  if (!map.empty() || map.size() != 0)
+    throw runtime_error("New map should be empty");
+  if (map.find(42) != nullptr)
+    throw runtime_error("Find on an empty map should miss");
+
+  // dense tile id style keys
+  for (uint32_t key = 0; key < 1000; ++key) {
+    map.emplace(key) = static_cast<int>(key * 3);
+  }
+  if (map.size() != 1000)
+    throw runtime_error("Wrong size after inserts");
+  for (uint32_t key = 0; key < 1000; ++key) {
+    const int* value = map.find(key);
+    if (value == nullptr || *value != static_cast<int>(key * 3))
+      throw runtime_error("Wrong value for key " + to_string(key));
+  }
+  if (map.find(1000) != nullptr)
+    throw runtime_error("Find of a missing key should miss");
+
+  // emplace of an existing key returns the existing value
+  map.emplace(7) = 42;
+  if (map.size() != 1000 || *map.find(7) != 42)
+    throw runtime_error("Emplace of an existing key should update in place");
+}
+
+void TestErase() {
+  graphid_map<int> map;
+  for (uint32_t key = 0; key < 100; ++key) {
+    map.emplace(key) = static_cast<int>(key);
+  }
+
+  // drop the odd keys
+  for (uint32_t key = 1; key < 100; key += 2) {
+    if (!map.erase(key))
+      throw runtime_error("Erase of a present key should succeed");
+  }
+  if (map.erase(1) || map.erase(100))
+    throw runtime_error("Erase of a missing key should fail");
+  if (map.size() != 50)
+    throw runtime_error("Wrong size after erases");
+
+  // the even keys remain reachable past the tombstones
+  for (uint32_t key = 0; key < 100; ++key) {
+    const int* value = map.find(key);
+    if ((key % 2 == 0) != (value != nullptr))
+      throw runtime_error("Wrong presence for key " + to_string(key) + " after erases");
+  }
+
+  // erased keys can be reinserted
+  map.emplace(1) = -1;
+  if (map.size() != 51 || *map.find(1) != -1)
+    throw runtime_error("Reinsert after erase failed");
+}
+
+void TestChurn() {
+  // interleaved inserts and erases force growth and tombstone cleanup,
+  // compare against the reference container throughout
+  graphid_map<uint32_t> map;
+  unordered_map<uint32_t, uint32_t> expected;
+  uint32_t seed = 123456789;
+  auto rand = [&seed]() { return seed = seed * 1103515245 + 12345; };
+  for (uint32_t i = 0; i < 20000; ++i) {
+    uint32_t key = rand() % 4096;
+    if (rand() % 3 == 0) {
+      if (map.erase(key) != (expected.erase(key) == 1))
+        throw runtime_error("Erase result mismatch");
+    } else {
+      map.emplace(key) = i;
+      expected[key] = i;
+    }
+  }
+  if (map.size() != expected.size())
+    throw runtime_error("Size mismatch after churn");
+  size_t seen = 0;
+  map.each([&expected, &seen](const uint32_t key, const uint32_t& value) {
+    auto check = expected.find(key);
+    if (check == expected.end() || check->second != value)
+      throw runtime_error("Each visited a wrong entry");
+    ++seen;
+  });
+  if (seen != expected.size())
+    throw runtime_error("Each missed entries");
+}
+
+void TestClear() {
+  graphid_map<std::shared_ptr<int>> map;
+  auto value = std::make_shared<int>(5);
+  map.emplace(10) = value;
+  if (value.use_count() != 2)
+    throw runtime_error("Map should hold a reference to its value");
+  map.clear();
+  if (!map.empty() || map.find(10) != nullptr)
+    throw runtime_error("Clear should drop all keys");
+  if (value.use_count() != 1)
+    throw runtime_error("Clear should destroy the values");
+
+  // refills fine after clearing
+  map.emplace(10) = value;
+  if (map.size() != 1 || map.find(10)->get() != value.get())
+    throw runtime_error("Insert after clear failed");
+}
+
+void TestValueStability() {
+  // values that own their storage keep their contents' addresses while
+  // the table grows - the tile caches rely on this
+  graphid_map<std::unique_ptr<int>> map;
+  map.emplace(0).reset(new int(7));
+  const int* stable = map.find(0)->get();
+  for (uint32_t key = 1; key < 1000; ++key) {
+    map.emplace(key).reset(new int(static_cast<int>(key)));
+  }
+  if (map.find(0)->get() != stable || *stable != 7)
+    throw runtime_error("Owned value contents moved during growth");
+}
+
+} // namespace
+
+int main() {
+  test::suite suite("graphid_map");
+
+  // Insert and find
+  suite.test(TEST_CASE(TestInsertFind));
+
+  // Erase and tombstones
+  suite.test(TEST_CASE(TestErase));
+
+  // Growth under churn
+  suite.test(TEST_CASE(TestChurn));
+
+  // Clear
+  suite.test(TEST_CASE(TestClear));
+
+  // Stability of owned value contents
+  suite.test(TEST_CASE(TestValueStability));
+
+  return suite.tear_down();
+}
@@ -59,6 +59,57 @@ void TestCacheLimits() {
     throw std::runtime_error("Cache should be over committed");
 }
 
+void TestLRUCache() {
+  TileCacheLRU cache(10);
+  GraphTile tile;
+  GraphId a(10, 2, 0), b(11, 2, 0), c(12, 2, 0);
+  cache.Put(a, tile, 4);
+  cache.Put(b, tile, 4);
+
+  // touching a makes b the eviction candidate
+  if (cache.Get(a) == nullptr)
+    throw std::runtime_error("a should be resident");
+  cache.Put(c, tile, 4);
+  if (cache.Contains(b))
+    throw std::runtime_error("b should have been evicted as least recently used");
+  if (!cache.Contains(a) || !cache.Contains(c))
+    throw std::runtime_error("a and c should still be resident");
+  if (cache.OverCommitted())
+    throw std::runtime_error("Cache should fit after eviction");
+
+  // a tile larger than the whole budget stays resident but over commits
+  cache.Put(GraphId(13, 2, 0), tile, 20);
+  if (!cache.OverCommitted())
+    throw std::runtime_error("Oversized tile should over commit the cache");
+
+  cache.Clear();
+  if (cache.Contains(a) || cache.OverCommitted())
+    throw std::runtime_error("Cleared cache should be empty and under committed");
+}
+
+void TestShardedCache() {
+  ShardedTileCache cache(10, 4);
+  GraphId id(10, 2, 0);
+  if (cache.Contains(id) || cache.Get(id) != nullptr)
+    throw std::runtime_error("Empty cache should not contain the tile");
+
+  GraphTile tile;
+  auto* inserted = cache.Put(id, tile, 5);
+  if (inserted == nullptr || !cache.Contains(id) || cache.Get(id) != inserted)
+    throw std::runtime_error("Cache should hand back the inserted tile");
+  if (cache.OverCommitted())
+    throw std::runtime_error("Cache should be under committed");
+
+  // a second tile pushes it past the limit
+  cache.Put(GraphId(11, 2, 0), tile, 6);
+  if (!cache.OverCommitted())
+    throw std::runtime_error("Cache should be over committed");
+
+  cache.Clear();
+  if (cache.Contains(id) || cache.OverCommitted())
+    throw std::runtime_error("Cleared cache should be empty and under committed");
+}
+
 void touch_tile(const uint32_t tile_id, const std::string& tile_dir) {
   auto suffix = GraphTile::FileSuffix({tile_id, 2, 0});
   auto fullpath = tile_dir + '/' + suffix;
@@ -136,6 +187,10 @@ int main() {
 
   suite.test(TEST_CASE(TestCacheLimits));
 
+  suite.test(TEST_CASE(TestLRUCache));
+
+  suite.test(TEST_CASE(TestShardedCache));
+
   suite.test(TEST_CASE(TestConnectivityMap));
 
   return suite.tear_down();
@@ -1,8 +1,13 @@
 #include "test.h"
 #include <cstdint>
 
+#include "baldr/compression_utils.h"
 #include "baldr/graphtile.h"
 
+#include <boost/filesystem/operations.hpp>
+#include <cstring>
+#include <fstream>
+#include <string>
 #include <vector>
 
 using namespace valhalla::baldr;
@@ -118,6 +123,83 @@ void bin() {
   }
 }
 
+void sectioned() {
+  // build a tiny flat tile: just a header, some edge info bytes, a text
+  // list and an empty tail section
+  GraphId id(2, 1, 0);
+  GraphTileHeader header;
+  header.set_graphid(id);
+  uint32_t fixed = sizeof(GraphTileHeader);
+  header.set_complex_restriction_forward_offset(fixed);
+  header.set_complex_restriction_reverse_offset(fixed);
+  header.set_edgeinfo_offset(fixed);
+  header.set_textlist_offset(fixed + 16);
+  header.set_lane_connectivity_offset(fixed + 28);
+  header.set_end_offset(fixed + 28);
+
+  std::vector<char> flat(fixed + 28, 0);
+  std::memcpy(flat.data(), &header, sizeof(header));
+  const char text[] = "hello\0world"; // 12 bytes with both terminators
+  std::memcpy(flat.data() + fixed + 16, text, sizeof(text));
+
+  // deflate the sections into one buffer recording the section table, the
+  // empty count arrays make the sign and bin sections zero length
+  const auto bounds = GraphTile::SectionBounds(header, flat.size());
+  GraphTile::SectionRecord records[GraphTile::kSectionCount];
+  std::vector<char> blocks;
+  for (size_t i = 0; i < GraphTile::kSectionCount; ++i) {
+    records[i].raw_offset = bounds[i];
+    records[i].raw_size = bounds[i + 1] - bounds[i];
+    auto start = blocks.size();
+    uint64_t written = 0;
+    auto src = [&](z_stream& s) -> int {
+      s.next_in = static_cast<Byte*>(static_cast<void*>(flat.data() + bounds[i]));
+      s.avail_in = static_cast<unsigned int>(records[i].raw_size);
+      return Z_FINISH;
+    };
+    auto dst = [&](z_stream& s) -> void {
+      written = s.total_out;
+      blocks.resize(start + written + 16384);
+      s.next_out = static_cast<Byte*>(static_cast<void*>(blocks.data() + start + written));
+      s.avail_out = 16384;
+    };
+    if (!valhalla::baldr::deflate(src, dst))
+      throw std::logic_error("Could not deflate a section");
+    blocks.resize(start + written);
+    records[i].comp_size = written;
+  }
+
+  // write it out the way valhalla_compress_tiles does
+  std::string tile_dir = "test/data/sectioned_tiles";
+  std::string file_name = tile_dir + "/" + GraphTile::FileSuffix(id) + ".gzs";
+  boost::filesystem::create_directories(boost::filesystem::path(file_name).parent_path());
+  std::ofstream out(file_name, std::ios::out | std::ios::binary | std::ios::trunc);
+  const uint32_t front[4] = {GraphTile::kSectionedTileMagic, GraphTile::kSectionedTileVersion,
+                             GraphTile::kSectionCount, 0};
+  out.write(reinterpret_cast<const char*>(front), sizeof(front));
+  out.write(reinterpret_cast<const char*>(records), sizeof(records));
+  out.write(blocks.data(), blocks.size());
+  out.close();
+
+  // the tile loads with only the fixed section resident, the names only
+  // inflate on first access
+  GraphTile tile(tile_dir, id);
+  if (!tile.header() || tile.header()->graphid() != id)
+    throw std::logic_error("Sectioned tile did not load");
+  if (tile.header()->end_offset() != fixed + 28)
+    throw std::logic_error("Sectioned tile header is wrong");
+  if (tile.GetName(0) != "hello" || tile.GetName(6) != "world")
+    throw std::logic_error("Sectioned tile names are wrong");
+
+  // a corrupted front refuses to load rather than crashing
+  std::fstream bad(file_name, std::ios::in | std::ios::out | std::ios::binary);
+  bad.write("nope", 4);
+  bad.close();
+  GraphTile corrupt(tile_dir, id);
+  if (corrupt.header())
+    throw std::logic_error("Corrupt sectioned tile should not load");
+}
+
 } // namespace
 
 int main() {
@@ -129,5 +211,7 @@ int main() {
 
   suite.test(TEST_CASE(bin));
 
+  suite.test(TEST_CASE(sectioned));
+
   return suite.tear_down();
 }
@@ -167,6 +167,23 @@ void TestWriteRead() {
     throw runtime_error("Header textlist offset test failed");
   }
 
+  // The directed edge SoA mirror is present only when its offset sits
+  // strictly between 0 and the end offset - legacy tiles wrote the end
+  // offset into every spare slot
+  hdr.set_end_offset(70000);
+  hdr.set_edge_soa_offset(70000);
+  if (hdr.has_edge_soa()) {
+    throw runtime_error("Header edge SoA should be absent when offset equals end offset");
+  }
+  hdr.set_edge_soa_offset(0);
+  if (hdr.has_edge_soa()) {
+    throw runtime_error("Header edge SoA should be absent when offset is 0");
+  }
+  hdr.set_edge_soa_offset(60000);
+  if (!hdr.has_edge_soa() || hdr.edge_soa_offset() != 60000) {
+    throw runtime_error("Header edge SoA offset test failed");
+  }
+
   // TODO - add tests for edge bin offsets
   uint32_t offsets[kBinCount];
   offsets[10] = 66666;
@@ -183,6 +200,47 @@ void TestWriteRead() {
   } catch (const std::runtime_error& e) {
     // Error thrown as it should be
   }
+
+  // Tile statistics stored in the spare words
+  if (hdr.has_stats()) {
+    throw runtime_error("Header stats flag should default to false");
+  }
+  hdr.set_has_stats(true);
+  if (!hdr.has_stats()) {
+    throw runtime_error("Header stats flag test failed");
+  }
+  hdr.set_edge_class_percent(2, 44);
+  hdr.set_edge_class_percent(7, 3);
+  if (hdr.edge_class_percent(2) != 44 || hdr.edge_class_percent(7) != 3) {
+    throw runtime_error("Header edge class percent test failed");
+  }
+  hdr.set_edge_class_percent(0, 120);
+  if (hdr.edge_class_percent(0) != 100) {
+    throw runtime_error("Header edge class percent (bounds check) test failed");
+  }
+  hdr.set_node_density_p50(7);
+  hdr.set_node_density_p90(kMaxDensity + 10);
+  if (hdr.node_density_p50() != 7 || hdr.node_density_p90() != kMaxDensity) {
+    throw runtime_error("Header node density percentile test failed");
+  }
+  hdr.set_branching_factor(2.5f);
+  if (hdr.branching_factor() != 2.5f) {
+    throw runtime_error("Header branching factor test failed");
+  }
+
+  // Update generation for in place tile patches
+  hdr.set_update_generation(hdr.update_generation() + 1);
+  hdr.set_update_generation(hdr.update_generation() + 1);
+  if (hdr.update_generation() != 2) {
+    throw runtime_error("Header update generation test failed");
+  }
+  hdr.set_update_generation(0x1ffff);
+  if (hdr.update_generation() != 0xffff) {
+    throw runtime_error("Header update generation (wrap) test failed");
+  }
+  if (hdr.node_density_p50() != 7 || hdr.branching_factor() != 2.5f) {
+    throw runtime_error("Header update generation clobbered the tile statistics");
+  }
 }
 } // namespace
 
@@ -48,6 +48,29 @@ void TestAddLineSegment() {
   }
 }
 
+void TestAddLineString() {
+  BoundingBox bbox(0, 0, 100, 100);
+  meili::GridRangeQuery<int, midgard::PointLL> grid(bbox, 1.f, 1.f);
+
+  // A zigzag within Cell(2, 3) then off to Cell(10, 3): consecutive
+  // segments share squares but the item must show up only once per square
+  grid.AddLineString(0, {{2.2, 3.2}, {2.8, 3.8}, {2.2, 3.6}, {10.5, 3.5}});
+  const auto& items23 = grid.GetItemsInSquare(2, 3);
+  test::assert_bool(items23.size() == 1, "should be added to Cell(2, 3) exactly once");
+
+  const auto& items103 = grid.GetItemsInSquare(10, 3);
+  test::assert_bool(items103.size() == 1, "should be added to Cell(10, 3)");
+
+  const auto& items53 = grid.GetItemsInSquare(5, 3);
+  test::assert_bool(items53.size() == 1, "should be added to Cell(5, 3)");
+
+  // Degenerate linestrings should add nothing
+  grid.AddLineString(1, {{50.5, 50.5}});
+  grid.AddLineString(1, {});
+  const auto& items50 = grid.GetItemsInSquare(50, 50);
+  test::assert_bool(items50.empty(), "nothing should be added to Cell(50, 50)");
+}
+
 void TestQuery() {
   const BoundingBox bbox(0, 0, 100, 100);
   meili::GridRangeQuery<int, midgard::PointLL> grid(bbox, 1.f, 1.f);
@@ -69,6 +92,8 @@ int main(int argc, char* argv[]) {
 
   suite.test(TEST_CASE(TestAddLineSegment));
 
+  suite.test(TEST_CASE(TestAddLineString));
+
   suite.test(TEST_CASE(TestQuery));
 
   return suite.tear_down();
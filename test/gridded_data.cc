@@ -68,6 +68,31 @@ void test_gridded() {
   std::cout << "]}";*/
 }
 
+void test_sparse() {
+  // a big grid where only a little corner gets touched, blocks for the rest
+  // of it should never be allocated and contouring should still work
+  GriddedData<PointLL> g({-5, -5, 175, 175}, 1, std::numeric_limits<float>::max());
+  for (int i = 0; i < 10; ++i) {
+    for (int j = 0; j < 10; ++j) {
+      Tiles<PointLL> t({-5, -5, 175, 175}, 1);
+      auto b = t.Base(t.TileId(i, j));
+      if (!g.Set(b, PointLL(0, 0).Distance(b)))
+        throw std::logic_error("Should have been able to set this cell");
+    }
+  }
+
+  std::vector<float> iso_markers{100000, 200000, 300000};
+  auto contours = g.GenerateContours(iso_markers, true);
+  if (contours.size() != iso_markers.size())
+    throw std::logic_error("There should be 3 iso lines");
+  size_t rings = 0;
+  for (const auto& collection : contours) {
+    rings += collection.second.front().size();
+  }
+  if (rings == 0)
+    throw std::logic_error("The touched corner of the grid should have produced rings");
+}
+
 } // namespace
 
 int main() {
@@ -75,5 +100,7 @@ int main() {
 
   suite.test(TEST_CASE(test_gridded));
 
+  suite.test(TEST_CASE(test_sparse));
+
   return suite.tear_down();
 }
@@ -48,14 +48,16 @@ void TestRandom() {
 }
 
 void TestBounds() {
+  // a single page worth of ids no matter how small the requested max
+  constexpr uint64_t kPageBits = 512 * 64;
   IdTable t(10);
 
   for (int i = 60; i < 70; ++i)
     if (t.get(i))
       throw std::logic_error("No bits can be set when they are higher than max");
 
-  if (t.max() != 63)
-    throw std::logic_error("Max id should be 10");
+  if (t.max() != kPageBits - 1)
+    throw std::logic_error("Max id should cover exactly one page");
 
   for (int i = 60; i < 70; ++i)
     if (i % 2)
@@ -65,8 +67,14 @@ void TestBounds() {
     if (i % 2 != t.get(i))
       throw std::logic_error("The odd ids should be set");
 
-  if (t.max() != 191)
-    throw std::logic_error("The max id should have been increased to 181");
+  // setting an id past the end should grow the directory to that page
+  t.set(kPageBits * 2 + 5);
+  if (!t.get(kPageBits * 2 + 5))
+    throw std::logic_error("Bit should be set after growing");
+  if (t.get(kPageBits * 2 + 4) || t.get(kPageBits + 5))
+    throw std::logic_error("Neighboring bits should not be set");
+  if (t.max() != kPageBits * 3 - 1)
+    throw std::logic_error("The max id should have been increased to three pages");
 }
 
 int main() {
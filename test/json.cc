@@ -69,12 +69,88 @@ void TestJsonSerialize() {
     throw std::logic_error("Wrong json");
 }
 
+void TestStreamingWriter() {
+  using namespace valhalla::baldr;
+
+  // the writer emits keys in the order they are written so the output
+  // is deterministic, unlike the map based tree above
+  json::Writer writer(64);
+  writer.start_object();
+  writer.key("type");
+  writer.value("FeatureCollection");
+  writer.key("features");
+  writer.start_array();
+  writer.start_object();
+  writer.key("coordinates");
+  writer.start_array();
+  writer.start_array();
+  writer.value(json::fp_t{-76.123456789, 6});
+  writer.value(json::fp_t{40.5, 6});
+  writer.end_array();
+  writer.end_array();
+  writer.key("contour");
+  writer.value(static_cast<uint64_t>(15));
+  writer.key("offset");
+  writer.value(static_cast<int64_t>(-5));
+  writer.key("opacity");
+  writer.value(json::fp_t{.33f, 2});
+  writer.key("escaped_string");
+  writer.value(std::string("\"\t\r\n\\\a"));
+  writer.key("flag");
+  writer.value(true);
+  writer.key("nothing");
+  writer.value(nullptr);
+  writer.end_object();
+  writer.end_array();
+  writer.end_object();
+
+  std::string answer =
+      "{\"type\":\"FeatureCollection\",\"features\":[{\"coordinates\":[[-76.123457,40.500000]],"
+      "\"contour\":15,\"offset\":-5,\"opacity\":0.33,\"escaped_string\":"
+      "\"\\\"\\t\\r\\n\\\\\\u0007\",\"flag\":true,\"nothing\":null}]}";
+  if (writer.document() != answer)
+    throw std::logic_error("Wrong streamed json");
+}
+
+void TestSlabAllocator() {
+  using namespace valhalla::baldr;
+
+  // build and tear down a pile of trees - after the first round every node
+  // comes off the slab's free list, this checks recycled slots behave
+  std::string first;
+  for (size_t i = 0; i < 1000; ++i) {
+    auto tree =
+        json::map({{"id", static_cast<uint64_t>(7)},
+                   {"pi", json::fp_t{3.14159, 5}},
+                   {"rows", json::array({json::map({{"on", true}, {"name", std::string("a")}}),
+                                         json::map({{"off", false}, {"gone", nullptr}})})}});
+    std::stringstream serialized;
+    serialized << *tree;
+    if (i == 0) {
+      first = serialized.str();
+    } else if (serialized.str() != first) {
+      throw std::logic_error("Recycled slab slots changed the serialized json");
+    }
+  }
+
+  // only the nodes themselves live in slots - the containers behind them
+  // can still grow arbitrarily
+  auto big = json::array({});
+  for (size_t i = 0; i < 10000; ++i) {
+    big->emplace_back(static_cast<uint64_t>(i));
+  }
+  if (big->size() != 10000)
+    throw std::logic_error("Large json containers should still work");
+}
+
 } // namespace
 
 int main() {
   test::suite suite("json");
 
   suite.test(TEST_CASE(TestJsonSerialize));
+  suite.test(TEST_CASE(TestStreamingWriter));
+  suite.test(TEST_CASE(TestSlabAllocator));
 
   return suite.tear_down();
 }
@@ -2,8 +2,10 @@
 #include "config.h"
 #include "test.h"
 #include <algorithm>
+#include <cmath>
 #include <cstdint>
 #include <iostream>
+#include <random>
 #include <vector>
 
 using namespace std;
@@ -11,6 +13,53 @@ using namespace valhalla::thor;
 
 namespace {
 
+// Get the cost for a tour given a full cost matrix
+float TourCost(const std::vector<float>& costs,
+               const std::vector<uint32_t>& tour,
+               const uint32_t count) {
+  float c = 0.0f;
+  for (uint32_t i = 0; i < count - 1; i++) {
+    c += costs[(tour[i] * count) + tour[i + 1]];
+  }
+  return c;
+}
+
+// Form a symmetric cost matrix from random locations in a plane
+std::vector<float> RandomCosts(const uint32_t count, const uint32_t seed) {
+  std::mt19937 gen(seed);
+  std::uniform_real_distribution<float> dis(0.0f, 1000.0f);
+  std::vector<float> x(count), y(count);
+  for (uint32_t i = 0; i < count; i++) {
+    x[i] = dis(gen);
+    y[i] = dis(gen);
+  }
+  std::vector<float> costs(count * count);
+  for (uint32_t i = 0; i < count; i++) {
+    for (uint32_t j = 0; j < count; j++) {
+      costs[i * count + j] = sqrtf((x[i] - x[j]) * (x[i] - x[j]) + (y[i] - y[j]) * (y[i] - y[j]));
+    }
+  }
+  return costs;
+}
+
+// Check that the tour visits every location once with the first and last
+// locations fixed
+void ValidateTour(const std::vector<uint32_t>& tour, const uint32_t count) {
+  if (tour.size() != count) {
+    throw runtime_error("Tour does not include all locations");
+  }
+  if (tour.front() != 0 || tour.back() != count - 1) {
+    throw runtime_error("Tour endpoints are not fixed");
+  }
+  std::vector<bool> seen(count, false);
+  for (const auto loc : tour) {
+    if (loc >= count || seen[loc]) {
+      throw runtime_error("Tour is not a permutation of the locations");
+    }
+    seen[loc] = true;
+  }
+}
+
 void TryOptimizer(const uint32_t nlocs,
                   const std::vector<float>& costs,
                   const std::vector<uint32_t>& expected_order) {
@@ -38,6 +87,56 @@ void TestOptimizer() {
   TryOptimizer(11, costs, expected_order);
 }
 
+void TestLocalSearch() {
+  // Solve a tour large enough to use the local search engine
+  constexpr uint32_t count = 100;
+  std::vector<float> costs = RandomCosts(count, 1);
+  Optimizer optimizer;
+  optimizer.Seed(1);
+  auto tour = optimizer.Solve(count, costs);
+  ValidateTour(tour, count);
+
+  // The optimized tour must beat the unoptimized location order
+  std::vector<uint32_t> unoptimized(count);
+  for (uint32_t i = 0; i < count; i++) {
+    unoptimized[i] = i;
+  }
+  if (TourCost(costs, tour, count) >= TourCost(costs, unoptimized, count)) {
+    throw runtime_error("Local search did not improve on the unoptimized order");
+  }
+
+  // The same seed must give the same tour regardless of thread scheduling
+  Optimizer optimizer2;
+  optimizer2.Seed(1);
+  if (optimizer2.Solve(count, costs) != tour) {
+    throw runtime_error("Local search result is not repeatable with the same seed");
+  }
+}
+
+void TestLocalSearchAsymmetric() {
+  // Skew the matrix so forward and reverse costs differ - moves must still
+  // produce a valid, improved tour
+  constexpr uint32_t count = 60;
+  std::vector<float> costs = RandomCosts(count, 2);
+  for (uint32_t i = 0; i < count; i++) {
+    for (uint32_t j = i + 1; j < count; j++) {
+      costs[i * count + j] *= 1.2f;
+    }
+  }
+  Optimizer optimizer;
+  optimizer.Seed(2);
+  auto tour = optimizer.Solve(count, costs);
+  ValidateTour(tour, count);
+
+  std::vector<uint32_t> unoptimized(count);
+  for (uint32_t i = 0; i < count; i++) {
+    unoptimized[i] = i;
+  }
+  if (TourCost(costs, tour, count) >= TourCost(costs, unoptimized, count)) {
+    throw runtime_error("Local search did not improve an asymmetric tour");
+  }
+}
+
 } // namespace
 
 int main() {
@@ -45,5 +144,11 @@ int main() {
 
   suite.test(TEST_CASE(TestOptimizer));
 
+  // Test the local search engine on a symmetric cost matrix
+  suite.test(TEST_CASE(TestLocalSearch));
+
+  // Test the local search engine on an asymmetric cost matrix
+  suite.test(TEST_CASE(TestLocalSearchAsymmetric));
+
   return suite.tear_down();
 }
@@ -0,0 +1,76 @@
+#include "midgard/ring_buffer.h"
+#include "test.h"
+
+#include <cstdint>
+#include <string>
+#include <thread>
+
+using namespace valhalla::midgard;
+
+void test_ordering() {
+  // a small ring so the producer has to wait on the consumer plenty
+  ring_buffer<uint32_t> ring(8);
+  size_t count = 10000;
+  std::thread producer([&ring, count]() {
+    for (uint32_t i = 0; i < count; ++i) {
+      ring.push(std::move(i));
+    }
+    ring.close();
+  });
+  // everything has to come out exactly in the order it went in
+  uint32_t expected = 0, item;
+  while (ring.pop(item)) {
+    if (item != expected)
+      throw std::runtime_error("Popped " + std::to_string(item) + " expecting " +
+                               std::to_string(expected));
+    ++expected;
+  }
+  producer.join();
+  if (expected != count)
+    throw std::runtime_error("Wrong number of items popped: " + std::to_string(expected));
+}
+
+void test_close_empty() {
+  // closing an empty ring makes the pop return false straight away
+  ring_buffer<std::string> ring(4);
+  ring.push("last one");
+  ring.close();
+  std::string item;
+  if (!ring.pop(item) || item != "last one")
+    throw std::runtime_error("Should have popped what was pushed before the close");
+  if (ring.pop(item))
+    throw std::runtime_error("Should not have popped from a closed empty ring");
+}
+
+void test_moved_elements() {
+  // non trivial elements move through without copies being required
+  ring_buffer<std::string> ring(2);
+  std::thread producer([&ring]() {
+    for (size_t i = 0; i < 100; ++i) {
+      ring.push(std::string(1000, 'x'));
+    }
+    ring.close();
+  });
+  size_t popped = 0;
+  std::string item;
+  while (ring.pop(item)) {
+    if (item.size() != 1000)
+      throw std::runtime_error("Popped a mangled element");
+    ++popped;
+  }
+  producer.join();
+  if (popped != 100)
+    throw std::runtime_error("Wrong number of items popped: " + std::to_string(popped));
+}
+
+int main() {
+  test::suite suite("ring_buffer");
+
+  suite.test(TEST_CASE(test_ordering));
+
+  suite.test(TEST_CASE(test_close_empty));
+
+  suite.test(TEST_CASE(test_moved_elements));
+
+  return suite.tear_down();
+}
@@ -0,0 +1,93 @@
+#include "midgard/scratch_allocator.h"
+#include "test.h"
+
+#include <cstdint>
+#include <stdexcept>
+
+using namespace valhalla::midgard;
+
+namespace {
+
+void test_containers() {
+  scratch_arena_t arena;
+
+  // a vector that grows past a few reallocations
+  scratch_vector<uint32_t> v{scratch_allocator<uint32_t>(arena)};
+  for (uint32_t i = 0; i < 10000; ++i) {
+    v.push_back(i);
+  }
+  for (uint32_t i = 0; i < 10000; ++i) {
+    if (v[i] != i) {
+      throw std::runtime_error("Wrong value in scratch vector at " + std::to_string(i));
+    }
+  }
+
+  // a node based container from the same arena
+  scratch_set<uint64_t> s{16, std::hash<uint64_t>(), std::equal_to<uint64_t>(),
+                          scratch_allocator<uint64_t>(arena)};
+  for (uint64_t i = 0; i < 1000; ++i) {
+    if (!s.insert(i * 31).second) {
+      throw std::runtime_error("Scratch set insert should have been unique");
+    }
+  }
+  if (s.size() != 1000 || s.count(31 * 999) != 1) {
+    throw std::runtime_error("Scratch set lost an element");
+  }
+
+  // strings longer than the small string optimization
+  scratch_string str{scratch_allocator<char>(arena)};
+  for (size_t i = 0; i < 100; ++i) {
+    str += "0123456789";
+  }
+  if (str.size() != 1000 || str[999] != '9') {
+    throw std::runtime_error("Scratch string has the wrong contents");
+  }
+}
+
+void test_reset_reuse() {
+  scratch_arena_t arena(1024);
+
+  // remember where the first round of allocations landed
+  scratch_allocator<char> allocator(arena);
+  char* first = allocator.allocate(512);
+  allocator.allocate(4096);
+
+  // after a reset the same memory comes back out
+  arena.reset();
+  if (allocator.allocate(512) != first) {
+    throw std::runtime_error("Reset arena should reuse its first block");
+  }
+}
+
+void test_alignment() {
+  scratch_arena_t arena;
+  scratch_allocator<char> chars(arena);
+  scratch_allocator<double> doubles(arena);
+
+  // a stray byte shouldnt leave the next allocation misaligned
+  chars.allocate(1);
+  auto* d = doubles.allocate(4);
+  if (reinterpret_cast<uintptr_t>(d) % alignof(double) != 0) {
+    throw std::runtime_error("Scratch allocation is misaligned");
+  }
+
+  // allocators over one arena are interchangeable, over different ones not
+  scratch_arena_t other;
+  if (!(chars == scratch_allocator<double>(arena)) || chars == scratch_allocator<char>(other)) {
+    throw std::runtime_error("Scratch allocator equality should compare arenas");
+  }
+}
+
+} // namespace
+
+int main() {
+  test::suite suite("scratch_allocator");
+
+  suite.test(TEST_CASE(test_containers));
+
+  suite.test(TEST_CASE(test_reset_reuse));
+
+  suite.test(TEST_CASE(test_alignment));
+
+  return suite.tear_down();
+}
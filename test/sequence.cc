@@ -13,19 +13,19 @@ struct osm_node {
 
 std::string write_nodes(const uint64_t count) {
   std::string file_name = "nodes.nd";
-  sequence<osm_node> sequence(file_name, true, 512);
+  sequence<osm_node> sequence(file_name, true, false, 512);
   for (uint64_t i = count - 1; i < count; --i)
     sequence.push_back({i, 0.f, 0.f, 0});
   return file_name;
 }
 
 void sort_nodes(const std::string& file_name) {
-  sequence<osm_node> sequence(file_name, false, 512);
+  sequence<osm_node> sequence(file_name, false, false, 512);
   sequence.sort([](const osm_node& a, const osm_node& b) { return a.id < b.id; });
 }
 
 void read_nodes(const std::string& file_name, const uint64_t count) {
-  sequence<osm_node> sequence(file_name, false, 512);
+  sequence<osm_node> sequence(file_name, false, false, 512);
   auto less_than = [](const osm_node& a, const osm_node& b) { return a.id < b.id; };
   for (uint64_t i = 0; i < count; ++i) {
     // grab an element
@@ -52,8 +52,33 @@ void test_read_write() {
   read_nodes(file_name, count);
 }
 
+void test_write_behind() {
+  // small buffers so pushing hands several buffers to the write behind thread
+  std::string file_name = "nodes.nd";
+  sequence<osm_node> sequence(file_name, true, false, 16);
+  size_t count = 100;
+  for (uint64_t i = 0; i < count; ++i)
+    sequence.push_back({i, 0.f, 0.f, 0});
+  if (sequence.size() != count)
+    throw std::runtime_error("Wrong size with writes in flight");
+  // read and write elements in every region: mapped, in flight and buffered
+  for (uint64_t i = 0; i < count; ++i) {
+    auto element = sequence[i];
+    osm_node node = *element;
+    if (node.id != i)
+      throw std::runtime_error("Found wrong node at: " + std::to_string(i));
+    node.attributes = 7;
+    element = node;
+  }
+  sequence.flush();
+  for (uint64_t i = 0; i < count; ++i) {
+    if ((*sequence[i]).attributes != 7)
+      throw std::runtime_error("Lost a write at: " + std::to_string(i));
+  }
+}
+
 void test_iterator() {
-  sequence<osm_node> sequence("nodes.nd", false, 512);
+  sequence<osm_node> sequence("nodes.nd", false, false, 512);
   auto i = sequence.begin();
   auto j = i + 1;
   if (j.position() != 1)
@@ -72,12 +97,42 @@ void test_iterator() {
     throw std::runtime_error("Pre-decrement operator wasn't right");
 }
 
+void test_readonly() {
+  size_t count = 1024;
+  auto file_name = write_nodes(count);
+  sort_nodes(file_name);
+
+  // a readonly sequence can be searched and read like any other
+  sequence<osm_node> sequence(file_name, false, true);
+  auto less_than = [](const osm_node& a, const osm_node& b) { return a.id < b.id; };
+  if (sequence.size() != count)
+    throw std::runtime_error("Wrong readonly size");
+  if ((*sequence[5]).id != 5)
+    throw std::runtime_error("Found wrong node in readonly sequence");
+  if (sequence.find(osm_node{42}, less_than) == sequence.end())
+    throw std::runtime_error("Didn't find node in readonly sequence");
+
+  // but anything that mutates it has to throw
+  try {
+    sequence.push_back({count, 0.f, 0.f, 0});
+    throw std::runtime_error("Readonly push_back should have thrown");
+  } catch (const std::logic_error&) {}
+  try {
+    sequence.sort(less_than);
+    throw std::runtime_error("Readonly sort should have thrown");
+  } catch (const std::logic_error&) {}
+}
+
 int main() {
   test::suite suite("sequence");
 
   suite.test(TEST_CASE(test_read_write));
 
+  suite.test(TEST_CASE(test_write_behind));
+
   suite.test(TEST_CASE(test_iterator));
 
+  suite.test(TEST_CASE(test_readonly));
+
   return suite.tear_down();
 }
@@ -0,0 +1,158 @@
+#include "test.h"
+#include "worker.h"
+
+#include <string>
+#include <vector>
+
+#ifndef _MSC_VER
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+using namespace valhalla;
+
+#ifndef _MSC_VER
+
+// a segment name unique to this run so stale segments from a crashed run
+// cant interfere, unlinked again once the arena under test is attached
+std::string test_segment(const std::string& suffix) {
+  std::string name = "/valhalla_msgring_test_" + std::to_string(getpid()) + "_" + suffix;
+  shm_unlink(name.c_str());
+  return name;
+}
+
+void test_stash_fetch() {
+  auto name = test_segment("roundtrip");
+  shm_message_arena_t arena(name, 8192, 64);
+  // a second instance attaching to the same segment, the way another stage
+  // of the pipeline would
+  shm_message_arena_t attached(name, 8192, 64);
+  shm_unlink(name.c_str());
+
+  // too small to be worth a detour through shared memory
+  if (!arena.stash(std::string("tiny")).empty())
+    throw std::runtime_error("A message below the minimum size should not be stashed");
+
+  std::string bytes(1000, '\0');
+  for (size_t i = 0; i < bytes.size(); ++i)
+    bytes[i] = static_cast<char>(i * 7);
+  auto handle = arena.stash(bytes);
+  if (handle.empty() || !shm_message_arena_t::is_handle(handle))
+    throw std::runtime_error("A big message should have stashed to a handle");
+  if (shm_message_arena_t::is_handle(bytes))
+    throw std::runtime_error("The bytes themselves should not look like a handle");
+
+  // the other instance gets the bytes back, and a handle is good exactly once
+  std::string fetched;
+  if (!attached.fetch(handle, fetched) || fetched != bytes)
+    throw std::runtime_error("Should have fetched back exactly what was stashed");
+  if (arena.fetch(handle, fetched))
+    throw std::runtime_error("A released handle should not fetch again");
+}
+
+void test_pbf_roundtrip() {
+  auto name = test_segment("pbf");
+  shm_message_arena_t arena(name, 65536, 64);
+  shm_unlink(name.c_str());
+
+  // serialized straight into the ring, parsed straight back out of it
+  odin::DirectionsOptions options;
+  options.set_id(std::string(5000, 'x'));
+  auto handle = arena.stash(options);
+  if (handle.empty())
+    throw std::runtime_error("A big message should have stashed to a handle");
+  odin::DirectionsOptions fetched;
+  if (!arena.fetch(handle, [&fetched](const void* data, size_t size) {
+        return fetched.ParseFromArray(data, static_cast<int>(size));
+      }))
+    throw std::runtime_error("Should have parsed the message from the mapped bytes");
+  if (fetched.id() != options.id())
+    throw std::runtime_error("The message did not survive the round trip");
+}
+
+void test_wrap() {
+  auto name = test_segment("wrap");
+  // a ring much smaller than the total traffic so it has to wrap many times
+  shm_message_arena_t arena(name, 4096, 8);
+  shm_unlink(name.c_str());
+
+  for (size_t i = 0; i < 500; ++i) {
+    // vary the sizes so the blocks land at awkward spots near the ring end
+    std::string bytes(256 + (i % 7) * 100 + i % 8, static_cast<char>(i));
+    auto handle = arena.stash(bytes);
+    if (handle.empty())
+      throw std::runtime_error("The ring should have room at iteration " + std::to_string(i));
+    std::string fetched;
+    if (!arena.fetch(handle, fetched) || fetched != bytes)
+      throw std::runtime_error("Wrong bytes after wrapping at iteration " + std::to_string(i));
+  }
+}
+
+void test_full_falls_back() {
+  auto name = test_segment("full");
+  shm_message_arena_t arena(name, 4096, 8);
+  shm_unlink(name.c_str());
+
+  // fill the ring without consuming anything until it refuses, the way a
+  // producer falls back to the envelope when the consumers are behind
+  std::vector<std::string> handles;
+  std::string bytes(512, 'y');
+  for (size_t i = 0; i < 64; ++i) {
+    auto handle = arena.stash(bytes);
+    if (handle.empty())
+      break;
+    handles.push_back(handle);
+  }
+  if (handles.size() < 4 || handles.size() == 64)
+    throw std::runtime_error("The ring should take several messages and then refuse");
+
+  // everything it did take is still intact, and room opens back up
+  for (const auto& handle : handles) {
+    std::string fetched;
+    if (!arena.fetch(handle, fetched) || fetched != bytes)
+      throw std::runtime_error("A message was lost while the ring was full");
+  }
+  if (arena.stash(bytes).empty())
+    throw std::runtime_error("The ring should have room again once its drained");
+}
+
+void test_stale_handle() {
+  auto name = test_segment("stale");
+  shm_message_arena_t arena(name, 8192, 8);
+  shm_unlink(name.c_str());
+
+  if (shm_message_arena_t::is_handle(std::string("{\"json\": \"request\"}")))
+    throw std::runtime_error("A json body should not look like a handle");
+
+  auto handle = arena.stash(std::string(100, 'z'));
+  // a forged sequence number misses even though the block is live
+  std::string forged = handle.substr(0, handle.find_last_of('/') + 1) + "99999";
+  std::string fetched;
+  if (arena.fetch(forged, fetched))
+    throw std::runtime_error("A handle with the wrong sequence should not fetch");
+  if (!arena.fetch(handle, fetched))
+    throw std::runtime_error("The real handle should still fetch");
+  // garbage handles just miss
+  if (arena.fetch("shm+pbf://bogus", fetched))
+    throw std::runtime_error("A malformed handle should not fetch");
+}
+
+#endif
+
+int main() {
+  test::suite suite("shm_message_arena");
+
+#ifndef _MSC_VER
+  suite.test(TEST_CASE(test_stash_fetch));
+
+  suite.test(TEST_CASE(test_pbf_roundtrip));
+
+  suite.test(TEST_CASE(test_wrap));
+
+  suite.test(TEST_CASE(test_full_falls_back));
+
+  suite.test(TEST_CASE(test_stale_handle));
+#endif
+
+  return suite.tear_down();
+}
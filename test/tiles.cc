@@ -60,6 +60,23 @@ void TestRowCol() {
   }
 }
 
+void TestRowColProjection() {
+  // the reciprocal multiply in the row/column mapping must agree with the
+  // plain division for the tile sizes the hierarchy uses
+  for (const auto size : {.25f, 1.f, 4.f}) {
+    Tiles<PointLL> tiles(AABB2<PointLL>(PointLL(-180, -90), PointLL(180, 90)), size);
+    for (float lng = -180.f; lng <= 180.f; lng += 7.13f) {
+      for (float lat = -90.f; lat <= 90.f; lat += 3.97f) {
+        int32_t row = static_cast<int32_t>((lat - -90.f) / size);
+        int32_t col = static_cast<int32_t>((lng - -180.f) / size);
+        if (tiles.Row(lat) != row || tiles.Col(lng) != col) {
+          throw std::runtime_error("Projected row/col does not match the division form");
+        }
+      }
+    }
+  }
+}
+
 void TestNeighbors() {
   Tiles<PointLL> tiles(AABB2<PointLL>(PointLL(-180, -90), PointLL(180, 90)), 1);
 
@@ -545,6 +562,8 @@ int main() {
   // Test tile id to row, col and vice-versa
   suite.test(TEST_CASE(TestRowCol));
 
+  suite.test(TEST_CASE(TestRowColProjection));
+
   // Test neighbors
   suite.test(TEST_CASE(TestNeighbors));
 
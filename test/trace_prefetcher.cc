@@ -0,0 +1,86 @@
+// -*- mode: c++ -*-
+#include <vector>
+
+#include "baldr/rapidjson_utils.h"
+#include <boost/property_tree/ptree.hpp>
+
+#include "meili/trace_prefetcher.h"
+#include "test.h"
+
+#if !defined(VALHALLA_SOURCE_DIR)
+#define VALHALLA_SOURCE_DIR
+#endif
+
+using namespace valhalla;
+using namespace valhalla::meili;
+
+namespace {
+
+boost::property_tree::ptree make_config() {
+  boost::property_tree::ptree root;
+  rapidjson::read_json(VALHALLA_SOURCE_DIR "test/valhalla.json", root);
+  root.put("meili.lookahead_window", 5);
+  return root;
+}
+
+// a trace marching steadily along like a vehicle would
+std::vector<Measurement> make_trace(size_t size) {
+  std::vector<Measurement> measurements;
+  for (size_t i = 0; i < size; ++i) {
+    measurements.emplace_back(midgard::PointLL(5.245f + i * 0.0005f, 52.107f), 5.f, 40.f);
+  }
+  return measurements;
+}
+
+void TestLifecycle() {
+  // there are no tiles to pull in this test so every warm comes up empty,
+  // which exercises exactly the advisory nature of the lookahead: the
+  // walk, the pacing and the hand back must all still work
+  TracePrefetcher prefetcher(make_config());
+  auto measurements = make_trace(100);
+
+  // a paced walk the way the matcher drives it
+  prefetcher.Start(measurements);
+  for (size_t i = 0; i < measurements.size(); ++i) {
+    prefetcher.Advance();
+  }
+  prefetcher.Finish();
+
+  // abandoning mid trace must also hand the measurements back
+  prefetcher.Start(measurements);
+  prefetcher.Advance();
+  prefetcher.Finish();
+
+  // advances with no trace in flight are ignored
+  prefetcher.Advance();
+
+  // back to back traces reuse the thread
+  for (size_t i = 0; i < 10; ++i) {
+    auto trace = make_trace(10 + i);
+    prefetcher.Start(trace);
+    for (size_t j = 0; j < trace.size(); ++j) {
+      prefetcher.Advance();
+    }
+    prefetcher.Finish();
+  }
+}
+
+void TestEmptyishTraces() {
+  TracePrefetcher prefetcher(make_config());
+  // a single point trace finishes without any advance at all
+  auto trace = make_trace(1);
+  prefetcher.Start(trace);
+  prefetcher.Finish();
+}
+
+} // namespace
+
+int main() {
+  test::suite suite("trace_prefetcher");
+
+  suite.test(TEST_CASE(TestLifecycle));
+
+  suite.test(TEST_CASE(TestEmptyishTraces));
+
+  return suite.tear_down();
+}
@@ -449,6 +449,22 @@ void TestSimilarAndEqual() {
   }
 }
 
+void TestShapeLength() {
+  // the one pass overload must sum exactly what Distance gives per segment
+  std::vector<PointLL> shape{{-76.5f, 40.5f},   {-76.52f, 40.51f}, {-76.52f, 40.51f},
+                             {-76.56f, 40.49f}, {-76.6f, 40.53f},  {-76.7f, 40.6f}};
+  float expected = length(shape.begin(), shape.end());
+  if (length(shape) != expected) {
+    throw std::logic_error("One pass shape length disagrees with the segment by segment length");
+  }
+
+  // degenerate shapes have no length
+  if (length(std::vector<PointLL>{}) != 0.0f ||
+      length(std::vector<PointLL>{{-76.5f, 40.5f}}) != 0.0f) {
+    throw std::logic_error("Shape length of fewer than 2 points should be 0");
+  }
+}
+
 } // namespace
 
 int main() {
@@ -485,5 +501,8 @@ int main() {
   // Test similar and equal edge cases
   suite.test(TEST_CASE(TestSimilarAndEqual));
 
+  // shape length fast path
+  suite.test(TEST_CASE(TestShapeLength));
+
   return suite.tear_down();
 }
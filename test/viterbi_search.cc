@@ -466,6 +466,86 @@ void test_viterbisearch_brute_force(const std::vector<Column>& columns, IViterbi
   }
 }
 
+void TestBeamSearch() {
+  const auto& columns = generate_columns(
+      // transition costs
+      std::uniform_int_distribution<int>(1, 10),
+      // emission costs
+      std::uniform_int_distribution<int>(1, 10),
+      generate_column_counts(100,
+                             // column sizes
+                             std::uniform_int_distribution<size_t>(1, 20)));
+
+  SimpleViterbiSearch exact(columns);
+
+  // a beam wider than any column must prune nothing
+  SimpleViterbiSearch wide(columns);
+  wide.set_beam_width(1000);
+
+  // the narrowest beam degenerates to a greedy search
+  SimpleViterbiSearch narrow(columns);
+  narrow.set_beam_width(1);
+
+  for (StateId::Time time = 0; time < columns.size(); time++) {
+    const auto& exact_winner = exact.SearchWinner(time);
+    const auto& wide_winner = wide.SearchWinner(time);
+    test::assert_bool(exact_winner.IsValid() && wide_winner.IsValid(),
+                      "winners should be valid on a fully connected graph");
+    test::assert_bool(exact.AccumulatedCost(exact_winner) == wide.AccumulatedCost(wide_winner),
+                      "a beam wider than every column must stay optimal but got exact = " +
+                          std::to_string(exact.AccumulatedCost(exact_winner)) + " and wide = " +
+                          std::to_string(wide.AccumulatedCost(wide_winner)));
+
+    const auto& narrow_winner = narrow.SearchWinner(time);
+    test::assert_bool(narrow_winner.IsValid(),
+                      "the narrowest beam must still reach every column on a fully connected graph");
+    test::assert_bool(exact.AccumulatedCost(exact_winner) <=
+                          narrow.AccumulatedCost(narrow_winner),
+                      "a beamed path cannot beat the optimal path");
+  }
+}
+
+void TestBatchEmissionCosts() {
+  const auto& columns = generate_columns(
+      // transition costs
+      std::uniform_int_distribution<int>(1, 10),
+      // emission costs
+      std::uniform_int_distribution<int>(1, 10),
+      generate_column_counts(100,
+                             // column sizes
+                             std::uniform_int_distribution<size_t>(1, 20)));
+
+  ViterbiSearch single, batched;
+  AddColumns(single, columns);
+  AddColumns(batched, columns);
+
+  single.set_emission_cost_model(EmissionCostModel(columns));
+  single.set_transition_cost_model(TransitionCostModel(columns));
+
+  // the batch model prices a whole column exactly like the per state model
+  batched.set_emission_cost_model(EmissionCostModel(columns));
+  batched.set_transition_cost_model(TransitionCostModel(columns));
+  const EmissionCostModel model(columns);
+  batched.set_batch_emission_cost_model([model](const std::vector<StateId>& column) {
+    std::vector<float> costs;
+    costs.reserve(column.size());
+    for (const auto& stateid : column) {
+      costs.push_back(model(stateid));
+    }
+    return costs;
+  });
+
+  for (StateId::Time time = 0; time < columns.size(); time++) {
+    const auto& single_winner = single.SearchWinner(time);
+    const auto& batched_winner = batched.SearchWinner(time);
+    test::assert_bool(single_winner == batched_winner,
+                      "an agreeing batch emission model must not change the winner");
+    test::assert_bool(single.AccumulatedCost(single_winner) ==
+                          batched.AccumulatedCost(batched_winner),
+                      "an agreeing batch emission model must not change the winner's cost");
+  }
+}
+
 void TestTopKSearch() {
 
   {
@@ -542,6 +622,10 @@ int main(int argc, char* argv[]) {
 
   suite.test(TEST_CASE(TestViterbiSearch));
 
+  suite.test(TEST_CASE(TestBeamSearch));
+
+  suite.test(TEST_CASE(TestBatchEmissionCosts));
+
   suite.test(TEST_CASE(TestTopKSearch));
 
   return suite.tear_down();
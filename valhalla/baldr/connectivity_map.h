@@ -1,10 +1,10 @@
 #ifndef VALHALLA_BALDR_CONNECTIVITY_MAP_H_
 #define VALHALLA_BALDR_CONNECTIVITY_MAP_H_
 
+#include <valhalla/baldr/graphid_map.h>
 #include <valhalla/baldr/pathlocation.h>
 
 #include <cstdint>
-#include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
@@ -15,9 +15,20 @@ class connectivity_map_t {
 public:
   /**
    * Constructs the connectivity map
-   * @param pt   the ptree sub child labeled mjolnir in the valhalla json config
+   * @param pt          the ptree sub child labeled mjolnir in the valhalla json config
+   * @param use_cached  when true and the tile_dir has a connectivity file written
+   *                    at build time, load the colors from it instead of scanning
+   *                    the tiles
    */
-  connectivity_map_t(const boost::property_tree::ptree& pt);
+  connectivity_map_t(const boost::property_tree::ptree& pt, const bool use_cached = true);
+
+  /**
+   * Writes the colors to a file in the tile directory so that later service
+   * startups can construct the map without scanning the tiles. Called at the
+   * end of the tile build by GraphValidator
+   * @param tile_dir  directory to write the file into
+   */
+  void to_file(const std::string& tile_dir) const;
 
   /**
    * Returns the color for the given graphid
@@ -55,9 +66,17 @@ public:
   std::vector<size_t> to_image(const uint32_t hierarchy_level) const;
 
 private:
+  /**
+   * Loads the colors from a file written by a previous to_file call
+   * @param tile_dir  directory holding the file
+   * @return true if the file was present and parsed completely
+   */
+  bool load(const std::string& tile_dir);
+
   uint32_t transit_level;
-  // this is a map(tile_level, map(tile_id, tile_color))
-  std::unordered_map<uint32_t, std::unordered_map<uint32_t, size_t>> colors;
+  // the color of each tile, indexed by tile level then probed by tile id.
+  // lookups here sit on the hot location correlation path
+  std::vector<graphid_map<size_t>> colors;
 };
 } // namespace baldr
 } // namespace valhalla
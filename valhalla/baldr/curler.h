@@ -25,6 +25,22 @@ struct curler_t {
   std::vector<char>
   operator()(const std::string& url, long& http_code, bool allow_compression = true);
 
+  /**
+   * Fetch a batch of urls concurrently and return the bytes for each. Each
+   * worker thread gets its own connection so the transfers overlap instead
+   * of paying one round trip per url in sequence.
+   *
+   * @param  urls               the urls to fetch
+   * @param  http_codes         per url, the code we got back when fetching
+   * @param  allow_compression  whether to allow and automatically handle compressed content types
+   * @param  concurrency        how many connections to use at most
+   * @return the bytes we fetched, index-aligned with the input urls
+   */
+  std::vector<std::vector<char>> operator()(const std::vector<std::string>& urls,
+                                            std::vector<long>& http_codes,
+                                            bool allow_compression = true,
+                                            size_t concurrency = 8);
+
 protected:
   struct pimpl_t;
   std::shared_ptr<pimpl_t> pimpl;
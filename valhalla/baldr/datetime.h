@@ -6,7 +6,9 @@
 #include <iomanip>
 #include <iostream>
 #include <locale>
+#include <map>
 #include <memory>
+#include <utility>
 #include <sstream>
 #include <string>
 #include <vector>
@@ -88,6 +90,42 @@ int timezone_diff(const uint64_t seconds,
                   const date::time_zone* origin_tz,
                   const date::time_zone* dest_tz);
 
+/**
+ * Caches timezone differences between pairs of timezones. The offset
+ * between two zones only changes at DST transitions, so each entry
+ * remembers the window of time over which its difference is valid and only
+ * goes back to the timezone database when the query time leaves that
+ * window. Intended to be per request - the time dependent algorithms query
+ * the difference once per expanded node, and constructing the date objects
+ * dominates the cost of the raw integer math.
+ */
+struct tz_diff_cache_t {
+  /**
+   * Get the difference between two timezones at the given time. Cached
+   * equivalent of timezone_diff.
+   * @param   seconds       seconds since epoch
+   * @param   origin_tz     timezone for origin
+   * @param   dest_tz       timezone for dest
+   * @return Returns the seconds difference between the 2 timezones.
+   */
+  int diff(const uint64_t seconds, const date::time_zone* origin_tz, const date::time_zone* dest_tz);
+
+  /**
+   * Clear the cached differences (at the start of a request).
+   */
+  void clear();
+
+protected:
+  // Cached difference between a pair of timezones and the window of time
+  // (seconds since epoch) over which it is valid
+  struct entry_t {
+    int64_t begin;
+    int64_t end;
+    int diff;
+  };
+  std::map<std::pair<const date::time_zone*, const date::time_zone*>, entry_t> entries_;
+};
+
 /**
  * Get the iso date time from seconds since epoch and timezone.
  * @param   seconds      seconds since epoch
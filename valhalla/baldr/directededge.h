@@ -10,6 +10,10 @@
 namespace valhalla {
 namespace baldr {
 
+// Maximum value the precomputed edge reach can store. Reaches at or above
+// this saturate, so the stored value is only conclusive below it.
+constexpr uint32_t kMaxEdgeReach = 63;
+
 /**
  * Directed edge within the graph.
  */
@@ -122,6 +126,28 @@ public:
    */
   void set_access_restriction(const uint32_t access);
 
+  /**
+   * Does the default truck envelope pass all access restrictions on this
+   * edge? Pre-resolved at build time by evaluating the static dimensional
+   * limits (height, width, length, weight, axle load, hazmat) against the
+   * default truck attributes; false when any truck restriction is timed or
+   * otherwise needs runtime evaluation, or when the tile predates the
+   * pre-resolution. When true, truck costing with default attributes can
+   * skip the access restriction walk.
+   * @return  Returns true if the restriction walk is unnecessary for the
+   *          default truck envelope.
+   */
+  bool default_truck_ok() const {
+    return default_truck_ok_;
+  }
+
+  /**
+   * Set whether the default truck envelope passes all access restrictions
+   * on this edge.
+   * @param  ok  True if all restrictions are static and pass the envelope.
+   */
+  void set_default_truck_ok(const bool ok);
+
   /**
    * Does this directed edge have exit signs?
    * @return  Returns true if the directed edge has exit signs,
@@ -242,6 +268,24 @@ public:
    */
   void set_deadend(const bool d);
 
+  /**
+   * Approximate reach of this directed edge - the number of nodes that can
+   * be reached from its end node, capped at kMaxEdgeReach. Computed at build
+   * time following edges with any access, so it is an upper bound on the
+   * reach any particular costing would find.
+   * @return  Returns the capped reach, or 0 if it was not computed.
+   */
+  uint32_t reach() const {
+    return reach_;
+  }
+
+  /**
+   * Set the approximate reach of this directed edge. Values above
+   * kMaxEdgeReach are clamped.
+   * @param  reach  Number of nodes reachable from the end node.
+   */
+  void set_reach(const uint32_t reach);
+
   /**
    * Does this edge have a toll or is it part of a toll road?
    * @return  Returns true if this edge is part of a toll road, false if not.
@@ -529,6 +573,23 @@ public:
    */
   void set_ctry_crossing(const bool crossing);
 
+  /**
+   * Get the state crossing flag. Set at build time when the admin records
+   * at the edge's end nodes differ (state/province or country change), so
+   * runtime admin logic can test a bit instead of comparing admin records.
+   * Only meaningful when the tile header has_admin_crossings flag is set.
+   * @return  Returns true if the edge crosses into a new state or province.
+   */
+  bool st_crossing() const {
+    return st_crossing_;
+  }
+
+  /**
+   * Set the state crossing flag.
+   * @param  crossing  True if this edge crosses into a new state or province.
+   */
+  void set_st_crossing(const bool crossing);
+
   /**
    * Get the access modes in the forward direction (bit field).
    * @return  Returns the access modes in the forward direction.
@@ -537,6 +598,17 @@ public:
     return forwardaccess_;
   }
 
+  /**
+   * Test an access mode in the forward direction. The mode is a template
+   * argument so the bitfield extract and mask test fold into a single
+   * immediate test - the access checks run once per edge in the expansion
+   * loops and show up in the costing profiles.
+   * @return  Returns true if the mode is allowed in the forward direction.
+   */
+  template <uint32_t access_mode> bool forwardaccess_allowed() const {
+    return (forwardaccess_ & access_mode) != 0;
+  }
+
   /**
    * Set the access modes in the forward direction (bit field).
    * @param  modes  Allowed access modes in the forward direction.
@@ -556,6 +628,14 @@ public:
     return reverseaccess_;
   }
 
+  /**
+   * Test an access mode in the reverse direction. See forwardaccess_allowed.
+   * @return  Returns true if the mode is allowed in the reverse direction.
+   */
+  template <uint32_t access_mode> bool reverseaccess_allowed() const {
+    return (reverseaccess_ & access_mode) != 0;
+  }
+
   /**
    * Set the access modes in the reverse direction (bit field).
    * @param  modes  Allowed access modes in the reverse direction.
@@ -1088,7 +1168,10 @@ protected:
   uint64_t traffic_signal_ : 1; // Traffic signal at end of the directed edge
   uint64_t seasonal_ : 1;       // Seasonal access (ex. no access in winter)
   uint64_t deadend_ : 1;        // Leads to a dead-end (no other driveable roads) TODO
-  uint64_t spare4_ : 10;
+  uint64_t reach_ : 6;          // Approximate reach from the end node (capped, 0 = unknown)
+  uint64_t st_crossing_ : 1;      // Does the edge cross into a new state/province?
+  uint64_t default_truck_ok_ : 1; // Static access restrictions pass the default truck envelope
+  uint64_t spare4_ : 2;
 
   // 5th 8-byte word
   uint64_t turntype_ : 24;      // Turn type (see graphconstants.h)
@@ -12,13 +12,27 @@ namespace baldr {
 
 constexpr uint32_t kInvalidLabel = std::numeric_limits<uint32_t>::max();
 
+// Number of low-level buckets allocated up front. The bucket range starts
+// at this many buckets and doubles whenever the overflow bucket has to be
+// drained, up to the range the queue was constructed with, so short
+// searches never pay for a continental sized bucket list.
+constexpr uint32_t kInitialBucketCount = 1024;
+
 /**
  * A callable element which returns the cost for a label.
  */
 using LabelCost = std::function<float(const uint32_t label)>;
 
+// An entry in a bucket: the label index along with its sort cost when the
+// entry was added. Storing the cost lets pop() tell live entries apart from
+// ones left behind by decrease(), which appends rather than erases.
+struct bucket_entry_t {
+  uint32_t label;
+  float cost;
+};
+
 // Bucket type and bucket list type.
-using bucket_t = std::vector<uint32_t>;
+using bucket_t = std::vector<bucket_entry_t>;
 using buckets_t = std::vector<bucket_t>;
 
 /**
@@ -36,7 +50,8 @@ public:
    * stored in an "overflow" bucket.
    * @param mincost    Minimum cost. Used to create the initial range for
    *                   bucket sorting.
-   * @param range      Cost range for low-level buckets.
+   * @param range      Maximum cost range for low-level buckets. The range
+   *                   in use starts small and grows adaptively up to this.
    * @param bucketsize Bucket size (range of costs within same bucket).
    *                   Must be an integer value.
    * @param labelcost  Functor to get a cost given a label index.
@@ -45,6 +60,27 @@ public:
                     const float range,
                     const uint32_t bucketsize,
                     const LabelCost& labelcost) {
+    mincost_ = 0.0f;
+    currentbucket_ = buckets_.begin();
+    reuse(mincost, range, bucketsize, labelcost);
+  }
+
+  /**
+   * Reinitialize the queue for another search while retaining the bucket
+   * storage allocated by prior searches. Equivalent to constructing a new
+   * queue but without freeing and reallocating the bucket vectors.
+   * @param mincost    Minimum cost. Used to create the initial range for
+   *                   bucket sorting.
+   * @param range      Maximum cost range for low-level buckets. The range
+   *                   in use starts small and grows adaptively up to this.
+   * @param bucketsize Bucket size (range of costs within same bucket).
+   *                   Must be an integer value.
+   * @param labelcost  Functor to get a cost given a label index.
+   */
+  void reuse(const float mincost,
+             const float range,
+             const uint32_t bucketsize,
+             const LabelCost& labelcost) {
     // We need at least a bucketsize of 1 or more
     if (bucketsize < 1) {
       throw std::runtime_error("Bucketsize must be 1 or greater");
@@ -55,20 +91,31 @@ public:
       throw std::runtime_error("Bucketrange must be greater than 0");
     }
 
+    // Empty any labels left behind by a prior search
+    clear();
+
     // Adjust min cost to be the start of a bucket
     uint32_t c = static_cast<uint32_t>(mincost);
     currentcost_ = (c - (c % bucketsize));
     mincost_ = currentcost_;
-    bucketrange_ = range;
     bucketsize_ = static_cast<float>(bucketsize);
     inv_ = 1.0f / bucketsize_;
 
+    // Start with a small bucket range and let it grow geometrically as the
+    // overflow bucket gets drained. The range passed in is the cap - short
+    // searches never allocate buckets sized for the whole cost range.
+    maxrange_ = range;
+    bucketrange_ = std::min(range, bucketsize_ * kInitialBucketCount);
+
     // Set the maximum cost (above this goes into the overflow bucket)
     maxcost_ = mincost_ + bucketrange_;
 
-    // Allocate the low-level buckets
-    size_t bucketcount = (range / bucketsize_) + 1;
-    buckets_.resize(bucketcount);
+    // Allocate the low-level buckets. Only ever grow the list so the
+    // vectors (and their capacity) survive from one search to the next.
+    size_t bucketcount = (bucketrange_ / bucketsize_) + 1;
+    if (buckets_.size() < bucketcount) {
+      buckets_.resize(bucketcount);
+    }
 
     // Set the current bucket to the lowest cost low level bucket
     currentbucket_ = buckets_.begin();
@@ -108,60 +155,83 @@ public:
    * @param   label  Label index to add to the queue.
    */
   void add(const uint32_t label) {
-    get_bucket(labelcost_(label)).push_back(label);
+    float cost = labelcost_(label);
+    get_bucket(cost).push_back({label, cost});
   }
 
   /**
-   * The specified label index now has a smaller cost.  Reorders it in the
-   * sorted bucket list. Uses the labelcost_ function to get the bucket that
-   * the label is currently within.
+   * The specified label index now has a smaller cost. Appends an entry with
+   * the new cost rather than erasing the old one from its bucket, so this is
+   * O(1); the entry left behind no longer matches the label cost and is
+   * discarded when popped. Must be called before the label itself is updated
+   * with the new sort cost.
    * @param  label        Label index to reorder.
    * @param  newcost      New sort cost.
    */
   void decrease(const uint32_t label, const float newcost) {
-    // Get the buckets of the previous and new costs. Nothing needs to be done
-    // if old cost and the new cost are in the same buckets.
-    bucket_t& prevbucket = get_bucket(labelcost_(label));
-    bucket_t& newbucket = get_bucket(newcost);
-    if (prevbucket != newbucket) {
-      // Add label to newbucket and remove from previous bucket
-      newbucket.push_back(label);
-      prevbucket.erase(std::remove(prevbucket.begin(), prevbucket.end(), label));
-    }
+    get_bucket(newcost).push_back({label, newcost});
   }
 
   /**
-   * Removes the lowest cost label index from the sorted buckets.
+   * Removes the lowest cost label index from the sorted buckets. Entries
+   * whose stored cost no longer matches the label cost were superseded by a
+   * decrease and are skipped.
    * @return  Returns the label index of the lowest cost label. Returns
    *          kInvalidLabel if the buckets are empty.
    */
   uint32_t pop() {
-    if (empty()) {
-      // No labels found in the low-level buckets.
-      if (overflowbucket_.empty()) {
-        // Return an invalid label if no labels are in the overflow buckets.
-        // Reset currentbucket to the last bucket - in case another access of
-        // adjacency list is done.
-        currentbucket_--;
-        return kInvalidLabel;
-      } else {
-        // Move labels from the overflow bucket to the low level buckets.
-        // Return invalid label if still empty.
-        empty_overflow();
-        if (empty()) {
+    while (true) {
+      if (empty()) {
+        // No labels found in the low-level buckets.
+        if (overflowbucket_.empty()) {
+          // Return an invalid label if no labels are in the overflow buckets.
+          // Reset currentbucket to the last bucket - in case another access of
+          // adjacency list is done.
+          currentbucket_--;
           return kInvalidLabel;
+        } else {
+          // Move labels from the overflow bucket to the low level buckets.
+          // Return invalid label if still empty.
+          empty_overflow();
+          if (empty()) {
+            return kInvalidLabel;
+          }
         }
       }
+
+      // Get the entry from the lowest non-empty bucket. Skip it if a
+      // decrease re-added the label with a lower cost - that copy was
+      // already popped from an earlier bucket.
+      bucket_entry_t entry = currentbucket_->back();
+      currentbucket_->pop_back();
+      if (labelcost_(entry.label) == entry.cost) {
+        return entry.label;
+      }
     }
+  }
 
-    // Return label from lowest non-empty bucket
-    uint32_t label = currentbucket_->back();
-    currentbucket_->pop_back();
-    return label;
+  /**
+   * Returns the label index the next call to pop would return, without
+   * removing it. Returns kInvalidLabel when only the overflow bucket holds
+   * labels, so this is a hint (e.g. for prefetching the next label), not
+   * an emptiness test.
+   * @return  Returns the lowest cost label index or kInvalidLabel.
+   */
+  uint32_t peek() {
+    while (!empty()) {
+      const bucket_entry_t& entry = currentbucket_->back();
+      if (labelcost_(entry.label) == entry.cost) {
+        return entry.label;
+      }
+      // Entries superseded by a decrease are dead - drop them here too
+      currentbucket_->pop_back();
+    }
+    return kInvalidLabel;
   }
 
 private:
-  float bucketrange_; // Total range of costs in lower level buckets
+  float bucketrange_; // Current range of costs in lower level buckets
+  float maxrange_;    // Cap on the bucket range as it grows adaptively
   float bucketsize_;  // Bucket size (range of costs in same bucket)
   float inv_;         // 1/bucketsize (so we can avoid division)
   float mincost_;     // Minimum cost within the low level buckets
@@ -210,16 +280,29 @@ private:
    * low level buckets.
    */
   void empty_overflow() {
-    // Get the minimum label so we can figure out where the new range should be
-    auto itr =
-        std::min_element(overflowbucket_.begin(), overflowbucket_.end(),
-                         [this](uint32_t a, uint32_t b) { return labelcost_(a) < labelcost_(b); });
+    // Get the minimum entry so we can figure out where the new range should
+    // be. Entries are placed by their stored cost; stale ones are discarded
+    // by pop wherever they land.
+    auto itr = std::min_element(overflowbucket_.begin(), overflowbucket_.end(),
+                                [](const bucket_entry_t& a, const bucket_entry_t& b) {
+                                  return a.cost < b.cost;
+                                });
 
     // If there is actually stuff to move
     if (itr != overflowbucket_.end()) {
+      // Needing to drain the overflow means the range is too small for this
+      // search - grow it geometrically (up to the constructed range) so each
+      // drain moves more labels and fewer O(overflow) scans remain.
+      if (bucketrange_ < maxrange_) {
+        bucketrange_ = std::min(maxrange_, bucketrange_ * 2.0f);
+        size_t bucketcount = (bucketrange_ / bucketsize_) + 1;
+        if (buckets_.size() < bucketcount) {
+          buckets_.resize(bucketcount);
+        }
+      }
 
       // Adjust cost range so smallest element is in the buckets_
-      float min = labelcost_(*itr);
+      float min = itr->cost;
       mincost_ += (std::floor((min - mincost_) / bucketrange_)) * bucketrange_;
 
       // Avoid precision issues
@@ -232,13 +315,11 @@ private:
 
       // Move elements within the range from overflow to buckets
       bucket_t tmp;
-      for (const auto& label : overflowbucket_) {
-        // Get the cost (using the label cost function)
-        float cost = labelcost_(label);
-        if (cost < maxcost_) {
-          buckets_[static_cast<uint32_t>((cost - mincost_) * inv_)].push_back(label);
+      for (const auto& entry : overflowbucket_) {
+        if (entry.cost < maxcost_) {
+          buckets_[static_cast<uint32_t>((entry.cost - mincost_) * inv_)].push_back(entry);
         } else {
-          tmp.push_back(label);
+          tmp.push_back(entry);
         }
       }
 
@@ -21,6 +21,14 @@ namespace baldr {
 constexpr size_t kMaxNamesPerEdge = 15;
 constexpr size_t kMaxEncodedShapeSize = 65535;
 
+// A shape index checkpoint is stored every this many vertices for shapes
+// long enough to have any, letting a decode start mid shape
+constexpr uint32_t kShapeIndexSampleRate = 32;
+// Bytes per packed checkpoint record: the byte offset into the encoded shape
+// where the checkpoint vertex's encoding begins plus the fixed precision
+// lat,lon accumulated through the vertex just before it
+constexpr size_t kShapeCheckpointSize = sizeof(uint16_t) + 2 * sizeof(int32_t);
+
 // Use elevation bins of 2 meters to store mean elevation. Clamp to a range
 // from -500 meters to 7683 meters.
 constexpr uint32_t kMaxStoredElevation = 4095; // 12 bits
@@ -73,8 +81,15 @@ public:
    * @param  ptr  Pointer to a bit of memory that has the info for this edge
    * @param  names_list  Pointer to the start of the text/names list.
    * @param  names_list_length  Length (bytes) of the text/names list.
+   * @param  use_shape_index  Whether the shape index flag can be trusted.
+   *                          Tiles written before the builder cleared the
+   *                          spare packed bits have garbage there, so only
+   *                          tiles whose header says so turn this on.
    */
-  EdgeInfo(char* ptr, const char* names_list, const size_t names_list_length);
+  EdgeInfo(char* ptr,
+           const char* names_list,
+           const size_t names_list_length,
+           const bool use_shape_index = false);
 
   /**
    * Destructor
@@ -148,6 +163,14 @@ public:
    */
   std::vector<std::pair<std::string, bool>> GetNamesAndTypes() const;
 
+  /**
+   * Get the names and route number flags for an edge without copying them out
+   * of the tile's text list. The pointers are into the tile so they are only
+   * valid as long as the tile is, callers that keep names across tiles copy.
+   * @return   Returns a list (vector) of name pointer/route number pairs.
+   */
+  std::vector<std::pair<const char*, bool>> GetNamePointersAndTypes() const;
+
   /**
    * Convenience method to get the types for the names.
    * @return   Returns types - If a bit is set, it is a route number.
@@ -165,6 +188,42 @@ public:
     return midgard::Shape7Decoder<PointLL>(encoded_shape_, item_->encoded_shape_size);
   }
 
+  /**
+   * Does this edge info carry a shape vertex checkpoint index?
+   * @return  Returns true when checkpoints are present.
+   */
+  bool has_shape_index() const {
+    return shape_index_count_ > 0;
+  }
+
+  /**
+   * Get a decoder positioned at the closest indexed checkpoint at or before
+   * the given vertex, skipping the decode of everything earlier. Without an
+   * index (or for vertices before the first checkpoint) the decoder starts
+   * at the beginning of the shape like lazy_shape does.
+   * @param  vertex  The vertex wanted; snapped down in place to the vertex
+   *                 the returned decoder's first pop actually yields.
+   * @return  Returns the positioned decoder.
+   */
+  midgard::Shape7Decoder<PointLL> lazy_shape_at(uint32_t& vertex) const;
+
+  /**
+   * Decode only the leading piece of the shape covering at least the given
+   * distance in meters, or the whole shape when it is shorter than that.
+   * @param  length  Distance along the shape to cover.
+   * @return  Returns the leading shape points.
+   */
+  std::vector<PointLL> shape_head(const float length) const;
+
+  /**
+   * Decode only the trailing piece of the shape covering at least the given
+   * distance in meters, or the whole shape when it is shorter than that.
+   * Uses the checkpoint index when present to skip decoding the rest.
+   * @param  length  Distance along the shape (from its end) to cover.
+   * @return  Returns the trailing shape points in their stored order.
+   */
+  std::vector<PointLL> shape_tail(const float length) const;
+
   /**
    * Returns the encoded shape string.
    * @return  Returns the encoded shape string.
@@ -183,8 +242,11 @@ public:
   struct PackedItem {
     uint32_t name_count : 4;
     uint32_t encoded_shape_size : 16;
-    uint32_t reserved : 5; // Reserved for use by forks of Valhalla
-    uint32_t spare : 7;
+    uint32_t reserved : 5;         // Reserved for use by forks of Valhalla
+    uint32_t has_shape_index : 1;  // A vertex checkpoint index follows the encoded shape.
+                                   // Only meaningful when the tile header says the tile
+                                   // was written with these bits cleared
+    uint32_t spare : 6;
   };
 
 protected:
@@ -210,6 +272,13 @@ protected:
   // The encoded shape of the edge
   const char* encoded_shape_;
 
+  // The packed checkpoint records following the shape, nullptr if the edge
+  // has none (or the tile was built before they existed)
+  const char* shape_index_;
+
+  // How many checkpoints there are
+  uint32_t shape_index_count_;
+
   // Lng, lat shape of the edge
   mutable std::vector<PointLL> shape_;
 
@@ -485,6 +485,16 @@ enum class AccessType : uint8_t {
   kTimedDenied = 7
 };
 
+// Default truck envelope (dimensions and weights) used when a truck costing
+// request does not override them. Lives here rather than in sif so the graph
+// build can pre-resolve static access restrictions against the same envelope
+// (see DirectedEdge::default_truck_ok).
+constexpr float kDefaultTruckWeight = 21.77f;  // Metric Tons (48,000 lbs)
+constexpr float kDefaultTruckAxleLoad = 9.07f; // Metric Tons (20,000 lbs)
+constexpr float kDefaultTruckHeight = 4.11f;   // Meters (13 feet 6 inches)
+constexpr float kDefaultTruckWidth = 2.6f;     // Meters (102.36 inches)
+constexpr float kDefaultTruckLength = 21.64f;  // Meters (71 feet)
+
 // Minimum meters offset from start/end of shape for finding heading
 constexpr float kMinMetersOffsetForHeading = 15.0f;
 inline float GetOffsetForHeading(RoadClass road_class, Use use) {
@@ -0,0 +1,223 @@
+#ifndef VALHALLA_BALDR_GRAPHID_MAP_H_
+#define VALHALLA_BALDR_GRAPHID_MAP_H_
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace valhalla {
+namespace baldr {
+
+/**
+ * An open addressing hash map specialized for the small dense keys the tiled
+ * graph uses - tile values (hierarchy level and tile id packed into the low
+ * bits of a GraphId) and tile ids within a level. Collisions are resolved by
+ * linear probing through one flat slot array, so a lookup is a cheap
+ * multiplicative hash and a short scan of adjacent memory instead of the
+ * per node pointer chase std::unordered_map pays.
+ *
+ * Values live in the slots themselves and move when the table grows, so the
+ * address of a value is only stable until the next insertion. Values that
+ * own their storage (vectors, unique_ptrs) keep their contents' addresses
+ * across growth either way. T must be default constructible and movable.
+ */
+template <typename T> class graphid_map {
+public:
+  graphid_map() : size_(0), tombstones_(0) {
+  }
+
+  /**
+   * Number of keys in the map.
+   */
+  size_t size() const {
+    return size_;
+  }
+
+  bool empty() const {
+    return size_ == 0;
+  }
+
+  /**
+   * Size the table so count keys fit without growing.
+   * @param count  expected number of keys
+   */
+  void reserve(const size_t count) {
+    if ((count + 1) * 8 > slots_.size() * 7) {
+      rehash(capacity_for(count));
+    }
+  }
+
+  /**
+   * Find the value for a key.
+   * @param  key  tile value or tile id to look for
+   * @return pointer to the value or nullptr if the key is not present
+   */
+  T* find(const uint32_t key) {
+    return const_cast<T*>(const_cast<const graphid_map*>(this)->find(key));
+  }
+
+  const T* find(const uint32_t key) const {
+    if (slots_.empty()) {
+      return nullptr;
+    }
+    const size_t mask = slots_.size() - 1;
+    for (size_t index = hash(key) & mask;; index = (index + 1) & mask) {
+      const auto& slot = slots_[index];
+      if (slot.key == key) {
+        return &slot.value;
+      }
+      if (slot.key == kEmptySlot) {
+        return nullptr;
+      }
+    }
+  }
+
+  /**
+   * Get the value for a key, default constructing it if the key is not
+   * present yet.
+   * @param  key  tile value or tile id
+   * @return reference to the value, valid until the next insertion
+   */
+  T& emplace(const uint32_t key) {
+    // make sure an empty slot always terminates the probe loops
+    if ((size_ + tombstones_ + 2) * 8 > slots_.size() * 7) {
+      rehash(capacity_for(size_ + 1));
+    }
+
+    const size_t mask = slots_.size() - 1;
+    size_t tombstone = kNoSlot;
+    for (size_t index = hash(key) & mask;; index = (index + 1) & mask) {
+      auto& slot = slots_[index];
+      if (slot.key == key) {
+        return slot.value;
+      }
+      if (slot.key == kTombstoneSlot && tombstone == kNoSlot) {
+        tombstone = index;
+      } else if (slot.key == kEmptySlot) {
+        // reuse the first tombstone passed on the way here if there was one
+        auto& target = slots_[tombstone == kNoSlot ? index : tombstone];
+        tombstones_ -= tombstone != kNoSlot;
+        target.key = key;
+        ++size_;
+        return target.value;
+      }
+    }
+  }
+
+  /**
+   * Remove a key and destroy its value.
+   * @param  key  tile value or tile id
+   * @return true if the key was present
+   */
+  bool erase(const uint32_t key) {
+    if (slots_.empty()) {
+      return false;
+    }
+    const size_t mask = slots_.size() - 1;
+    for (size_t index = hash(key) & mask;; index = (index + 1) & mask) {
+      auto& slot = slots_[index];
+      if (slot.key == key) {
+        slot.key = kTombstoneSlot;
+        slot.value = T();
+        --size_;
+        ++tombstones_;
+        return true;
+      }
+      if (slot.key == kEmptySlot) {
+        return false;
+      }
+    }
+  }
+
+  /**
+   * Destroy every value. The slot array is kept so the map refills without
+   * growing again.
+   */
+  void clear() {
+    for (auto& slot : slots_) {
+      if (slot.key != kEmptySlot) {
+        slot.key = kEmptySlot;
+        slot.value = T();
+      }
+    }
+    size_ = 0;
+    tombstones_ = 0;
+  }
+
+  /**
+   * Call a function over every key and value in the map.
+   * @param  fn  callable taking (uint32_t key, T& value)
+   */
+  template <typename F> void each(F&& fn) {
+    for (auto& slot : slots_) {
+      if (slot.key != kEmptySlot && slot.key != kTombstoneSlot) {
+        fn(slot.key, slot.value);
+      }
+    }
+  }
+
+  template <typename F> void each(F&& fn) const {
+    for (const auto& slot : slots_) {
+      if (slot.key != kEmptySlot && slot.key != kTombstoneSlot) {
+        fn(slot.key, slot.value);
+      }
+    }
+  }
+
+protected:
+  // keys are at most 25 bits (3 of level and 22 of tile id) so the top
+  // values are free to mark empty and erased slots
+  static constexpr uint32_t kEmptySlot = 0xffffffffu;
+  static constexpr uint32_t kTombstoneSlot = 0xfffffffeu;
+  static constexpr size_t kNoSlot = static_cast<size_t>(-1);
+  static constexpr size_t kMinSlotCount = 16;
+
+  struct slot_t {
+    uint32_t key = kEmptySlot;
+    T value{};
+  };
+
+  // multiplying by an odd constant is a bijection over the key space, so
+  // the dense tile ids stay spread out under the power of two mask
+  static size_t hash(const uint32_t key) {
+    return key * 2654435769u;
+  }
+
+  // smallest power of two that keeps count keys under the load factor
+  static size_t capacity_for(const size_t count) {
+    size_t capacity = kMinSlotCount;
+    while ((count + 1) * 8 > capacity * 7) {
+      capacity *= 2;
+    }
+    return capacity;
+  }
+
+  // move everything into a fresh table, dropping accumulated tombstones
+  void rehash(const size_t slot_count) {
+    std::vector<slot_t> old_slots;
+    old_slots.swap(slots_);
+    slots_.resize(slot_count);
+    const size_t mask = slot_count - 1;
+    for (auto& slot : old_slots) {
+      if (slot.key == kEmptySlot || slot.key == kTombstoneSlot) {
+        continue;
+      }
+      size_t index = hash(slot.key) & mask;
+      while (slots_[index].key != kEmptySlot) {
+        index = (index + 1) & mask;
+      }
+      slots_[index].key = slot.key;
+      slots_[index].value = std::move(slot.value);
+    }
+    tombstones_ = 0;
+  }
+
+  std::vector<slot_t> slots_;
+  size_t size_;
+  size_t tombstones_;
+};
+
+} // namespace baldr
+} // namespace valhalla
+
+#endif // VALHALLA_BALDR_GRAPHID_MAP_H_
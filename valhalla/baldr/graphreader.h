@@ -1,16 +1,23 @@
 #ifndef VALHALLA_BALDR_GRAPHREADER_H_
 #define VALHALLA_BALDR_GRAPHREADER_H_
 
+#include <atomic>
 #include <cstdint>
+#include <list>
 #include <mutex>
+#include <shared_mutex>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include <boost/property_tree/ptree.hpp>
 #include <valhalla/baldr/curler.h>
 #include <valhalla/baldr/graphid.h>
+#include <valhalla/baldr/graphid_map.h>
 #include <valhalla/baldr/graphtile.h>
+#include <valhalla/baldr/speedoverlay.h>
 #include <valhalla/baldr/tilehierarchy.h>
+#include <valhalla/baldr/tileindex.h>
 
 namespace valhalla {
 namespace baldr {
@@ -59,6 +66,13 @@ public:
    */
   virtual bool OverCommitted() const = 0;
 
+  /**
+   * Removes a single tile from the cache, e.g. because a newer version of
+   * the tile landed on disk. A no-op when the tile is not cached.
+   * @param graphid  the graphid of the tile
+   */
+  virtual void Evict(const GraphId& graphid) = 0;
+
   /**
    * Clears the cache.
    */
@@ -111,14 +125,22 @@ public:
    */
   virtual bool OverCommitted() const;
 
+  /**
+   * Removes a single tile from the cache.
+   * @param graphid  the graphid of the tile
+   */
+  virtual void Evict(const GraphId& graphid);
+
   /**
    * Clears the cache.
    */
   virtual void Clear();
 
 protected:
-  // The actual cached GraphTile objects
-  std::unordered_map<GraphId, GraphTile> cache_;
+  // The cached GraphTile objects in a flat probed table keyed by the tile
+  // value of the base graphid. The tiles sit behind unique_ptrs so the
+  // pointers handed out stay valid while the table grows
+  graphid_map<std::unique_ptr<GraphTile>> cache_;
 
   // The current cache size in bytes
   size_t cache_size_;
@@ -173,6 +195,12 @@ public:
    */
   bool OverCommitted() const override;
 
+  /**
+   * Removes a single tile from the cache.
+   * @param graphid  the graphid of the tile
+   */
+  void Evict(const GraphId& graphid) override;
+
   /**
    * Clears the cache.
    */
@@ -183,6 +211,282 @@ private:
   std::mutex& mutex_ref_;
 };
 
+/**
+ * Tile cache with true least-recently-used eviction. Tiles are kept in
+ * recency order and inserting past the size limit evicts from the cold end
+ * until the cache fits again, so a planet sized tile set can be served from
+ * a bounded footprint without periodic full cache clears.
+ * It is NOT thread-safe, wrap it with SynchronizedTileCache if needed.
+ */
+class TileCacheLRU : public TileCache {
+public:
+  /**
+   * Constructor.
+   * @param max_size  maximum size of the cache
+   */
+  TileCacheLRU(size_t max_size);
+
+  /**
+   * Reserves enough cache to hold (max_cache_size / tile_size) items.
+   * @param tile_size appeoximate size of one tile
+   */
+  void Reserve(size_t tile_size) override;
+
+  /**
+   * Checks if tile exists in the cache.
+   * @param graphid  the graphid of the tile
+   * @return true if tile exists in the cache
+   */
+  bool Contains(const GraphId& graphid) const override;
+
+  /**
+   * Puts a copy of a tile of into the cache. Evicts the least recently
+   * used tiles until the new tile fits under the limit.
+   * @param graphid  the graphid of the tile
+   * @param tile the graph tile
+   * @param size size of the tile in memory
+   */
+  const GraphTile* Put(const GraphId& graphid, const GraphTile& tile, size_t size) override;
+
+  /**
+   * Get a pointer to a graph tile object given a GraphId and mark it as
+   * most recently used.
+   * @param graphid  the graphid of the tile
+   * @return GraphTile* a pointer to the graph tile
+   */
+  const GraphTile* Get(const GraphId& graphid) const override;
+
+  /**
+   * Lets you know if the cache is too large. With eviction in place this
+   * only happens when a single tile is larger than the whole budget.
+   * @return true if the cache is over committed with respect to the limit
+   */
+  bool OverCommitted() const override;
+
+  /**
+   * Removes a single tile from the cache and its recency slot.
+   * @param graphid  the graphid of the tile
+   */
+  void Evict(const GraphId& graphid) override;
+
+  /**
+   * Clears the cache.
+   */
+  void Clear() override;
+
+protected:
+  struct entry_t {
+    GraphTile tile;
+    size_t size;
+    std::list<uint64_t>::iterator position;
+  };
+
+  /**
+   * Evict from the cold end of the recency list until the cache fits
+   * within the limit again.
+   */
+  void TrimToFit();
+
+  // The cached tiles with their size and position in the recency list
+  std::unordered_map<uint64_t, entry_t> cache_;
+
+  // Graphids in recency order, most recently used at the front
+  mutable std::list<uint64_t> recency_;
+
+  // The current cache size in bytes
+  size_t cache_size_;
+
+  // The max cache size in bytes
+  size_t max_cache_size_;
+};
+
+/**
+ * Thread-safe tile cache that spreads the tiles over a number of
+ * independently locked shards so concurrent lookups of different tiles do
+ * not serialize behind one global mutex. Lookups of resident tiles take a
+ * shared lock on just their shard, so readers never block each other;
+ * only the insert of a new tile takes a shard's lock exclusively.
+ */
+class ShardedTileCache : public TileCache {
+public:
+  static constexpr size_t kDefaultShardCount = 64;
+
+  /**
+   * Constructor.
+   * @param max_size    maximum size of the cache
+   * @param shard_count number of shards, rounded up to a power of two
+   */
+  ShardedTileCache(size_t max_size, size_t shard_count = kDefaultShardCount);
+
+  /**
+   * Reserves enough cache to hold (max_cache_size / tile_size) items.
+   * @param tile_size appeoximate size of one tile
+   */
+  void Reserve(size_t tile_size) override;
+
+  /**
+   * Checks if tile exists in the cache.
+   * @param graphid  the graphid of the tile
+   * @return true if tile exists in the cache
+   */
+  bool Contains(const GraphId& graphid) const override;
+
+  /**
+   * Puts a copy of a tile of into the cache.
+   * @param graphid  the graphid of the tile
+   * @param tile the graph tile
+   * @param size size of the tile in memory
+   */
+  const GraphTile* Put(const GraphId& graphid, const GraphTile& tile, size_t size) override;
+
+  /**
+   * Get a pointer to a graph tile object given a GraphId.
+   * @param graphid  the graphid of the tile
+   * @return GraphTile* a pointer to the graph tile
+   */
+  const GraphTile* Get(const GraphId& graphid) const override;
+
+  /**
+   * Lets you know if the cache is too large.
+   * @return true if the cache is over committed with respect to the limit
+   */
+  bool OverCommitted() const override;
+
+  /**
+   * Removes a single tile from its shard.
+   * @param graphid  the graphid of the tile
+   */
+  void Evict(const GraphId& graphid) override;
+
+  /**
+   * Clears the cache.
+   */
+  void Clear() override;
+
+protected:
+  // A shard is just a piece of the tile map with its own reader-writer lock
+  struct shard_t {
+    mutable std::shared_timed_mutex lock;
+    std::unordered_map<uint64_t, GraphTile> tiles;
+  };
+
+  /**
+   * Pick the shard a graphid lives in.
+   */
+  shard_t& shard(const GraphId& graphid) const {
+    return shards_[std::hash<uint64_t>()(graphid.value) & (shards_.size() - 1)];
+  }
+
+  // The shards, sized once at construction
+  mutable std::vector<shard_t> shards_;
+
+  // The current cache size in bytes, updated under the shard locks
+  std::atomic<size_t> cache_size_;
+
+  // The max cache size in bytes
+  size_t max_cache_size_;
+};
+
+/**
+ * Tile cache whose tile bytes live in a named shared memory segment so that
+ * every process on the host shares one copy of the cached tile set. The
+ * segment holds a process-shared mutex, a fixed size graphid index and a bump
+ * allocated data arena; each process keeps its own lightweight GraphTile
+ * views over the shared bytes. There is no eviction - once the arena fills,
+ * later puts degrade to process-local copies.
+ * Only available on POSIX systems.
+ */
+class SharedTileCache : public TileCache {
+public:
+  /**
+   * Constructor.
+   * @param segment_name  name of the shared memory segment (shm_open style)
+   * @param max_size      size in bytes of the shared data arena
+   */
+  SharedTileCache(const std::string& segment_name, size_t max_size);
+
+  /**
+   * Destructor. Unmaps the segment but leaves it for other processes.
+   */
+  ~SharedTileCache() override;
+
+  /**
+   * Reserves enough cache to hold (max_cache_size / tile_size) items.
+   * @param tile_size appeoximate size of one tile
+   */
+  void Reserve(size_t tile_size) override;
+
+  /**
+   * Checks if tile exists in the cache.
+   * @param graphid  the graphid of the tile
+   * @return true if tile exists in the cache
+   */
+  bool Contains(const GraphId& graphid) const override;
+
+  /**
+   * Puts a copy of a tile of into the cache.
+   * @param graphid  the graphid of the tile
+   * @param tile the graph tile
+   * @param size size of the tile in memory
+   */
+  const GraphTile* Put(const GraphId& graphid, const GraphTile& tile, size_t size) override;
+
+  /**
+   * Get a pointer to a graph tile object given a GraphId.
+   * @param graphid  the graphid of the tile
+   * @return GraphTile* a pointer to the graph tile
+   */
+  const GraphTile* Get(const GraphId& graphid) const override;
+
+  /**
+   * Lets you know if the cache is too large.
+   * @return true if the shared arena is exhausted
+   */
+  bool OverCommitted() const override;
+
+  /**
+   * Drops the local view of a tile and tombstones its index slot so the
+   * tile is re-read from disk on the next Get. The old bytes stay in the
+   * arena, so views other processes still hold remain valid until those
+   * processes evict too.
+   * @param graphid  the graphid of the tile
+   */
+  void Evict(const GraphId& graphid) override;
+
+  /**
+   * Clears the local views. The shared segment is left intact for the
+   * other processes attached to it.
+   */
+  void Clear() override;
+
+protected:
+  struct segment_header_t;
+  struct index_entry_t;
+
+  /**
+   * Find the index slot for a graphid. Must be called with the lock held.
+   * @param graphid  the graphid of the tile
+   * @return pointer to the matching or first empty slot, nullptr if full
+   */
+  index_entry_t* FindSlot(const GraphId& graphid) const;
+
+  // Name of the shared memory segment
+  std::string segment_name_;
+
+  // Size of the whole mapping including header and index
+  size_t segment_size_;
+
+  // Size of the data arena
+  size_t max_cache_size_;
+
+  // Base of the mapping, the header lives at the front
+  segment_header_t* header_;
+
+  // Process local GraphTile views over the shared bytes, plus local
+  // fallback copies made after the arena filled up
+  mutable std::unordered_map<uint64_t, GraphTile> views_;
+};
+
 /**
  * Creates tile caches.
  */
@@ -200,6 +504,14 @@ public:
 /**
  * Class that manages access to GraphTiles.
  * Uses TileCache to keep a cache of tiles.
+ * When the configured cache is safe for concurrent use (sharded_cache or
+ * global_synchronized_cache) a single reader can be shared by every worker
+ * thread: the tile bytes live once in the shared cache while each thread
+ * keeps a tiny cache of the tile handles it touched last, so the repeat
+ * lookups that dominate graph expansion stay lock free. In that mode the
+ * reader's own bookkeeping (statistics, remote fetches) goes behind locks.
+ * Clear and CheckForTileUpdates must still happen while no requests are in
+ * flight - handed out tile pointers dangle regardless of the cache type.
  */
 class GraphReader {
 public:
@@ -209,6 +521,84 @@ public:
    */
   GraphReader(const boost::property_tree::ptree& pt);
 
+  /**
+   * Destructor. Stops the prefetch and manifest watcher threads if running.
+   */
+  virtual ~GraphReader();
+
+  /**
+   * Hint that a tile is likely to be requested soon, e.g. because the
+   * search frontier is about to cross into it. When prefetching is enabled
+   * (prefetch_tiles config, requires a thread-safe cache) a background
+   * thread pulls the tile into the cache so the expansion does not stall
+   * on disk. A no-op otherwise.
+   * @param graphid  the graphid of the tile
+   */
+  void Prefetch(const GraphId& graphid);
+
+  /**
+   * Counters describing how well the tile cache is doing and which tiles
+   * are hot. Cheap to keep, cheap to read.
+   */
+  struct cache_statistics_t {
+    size_t hits = 0;        // requests served from the cache
+    size_t misses = 0;      // requests that had to load the tile
+    size_t not_found = 0;   // requests for tiles that do not exist
+    // per tile access counts, keyed by the tile base graphid value
+    std::unordered_map<uint64_t, uint64_t> tile_accesses;
+  };
+
+  /**
+   * Get the cache statistics accumulated since construction or the last
+   * call to ClearCacheStatistics. On a reader shared between threads only
+   * read these while no requests are in flight.
+   * @return the statistics
+   */
+  const cache_statistics_t& cache_statistics() const {
+    return statistics_;
+  }
+
+  /**
+   * Reset the cache statistics.
+   */
+  void ClearCacheStatistics() {
+    statistics_ = cache_statistics_t{};
+  }
+
+  /**
+   * Get the n most frequently accessed tiles, hottest first.
+   * @param n  how many tiles to return at most
+   * @return pairs of tile base graphid and access count
+   */
+  std::vector<std::pair<GraphId, uint64_t>> HottestTiles(size_t n) const;
+
+  /**
+   * Load tiles into the cache up front instead of faulting them in on the
+   * first requests. Tiles are read from disk on a pool of threads and put
+   * into the cache until either every tile is resident or the cache budget
+   * is spent. Also triggered at construction by the preload_tiles config
+   * flag.
+   * @param concurrency  how many loader threads to use, 0 picks the
+   *                     hardware concurrency
+   * @return the number of tiles preloaded
+   */
+  size_t PreloadTiles(size_t concurrency = 0);
+
+  /**
+   * Applies a pending tile data update if the manifest watcher noticed one.
+   * The manifest is a file named tile_manifest.txt in the tile directory
+   * whose first line is "epoch N" followed by one tile file suffix per line
+   * for the tiles that changed since the previous epoch (the same lines
+   * valhalla_identify_dirty_tiles writes). A deployment swaps the changed
+   * tile files in place and then rewrites the manifest with a larger epoch.
+   * This call evicts just the listed tiles from the cache so they reload
+   * from disk on their next request - only call it between requests, when
+   * no tile pointers handed out by this reader are still in use. It also
+   * picks up a newer speed overlay generation if the feeder swapped one in.
+   * @return true if an update was applied
+   */
+  bool CheckForTileUpdates();
+
   /**
    * Test if tile exists
    * @param  graphid  GraphId of the tile to test (tile id and level).
@@ -264,6 +654,7 @@ public:
    */
   void Clear() {
     cache_->Clear();
+    ++cache_generation();
   }
 
   /**
@@ -528,6 +919,17 @@ public:
     return edgeinfo(edgeid, NO_TILE);
   }
 
+  /**
+   * Get the decoded shape of an edge. A small per-reader LRU keyed by tile
+   * and edge info offset keeps recently decoded shapes so repeatedly
+   * touched edges are only varint decoded once. The returned reference is
+   * only valid until the next call to this method on this reader.
+   * @param tile  Tile of the directed edge.
+   * @param edge  Directed edge.
+   * @return Returns the decoded lat,lng shape of the edge.
+   */
+  const std::vector<midgard::PointLL>& edgeshape(const GraphTile* tile, const DirectedEdge* edge);
+
   /**
    * Gets back a set of available tiles
    * @return  returns the list of available tiles
@@ -552,6 +954,18 @@ public:
     return tile_dir_;
   }
 
+  /**
+   * Process-wide generation counter for handed out tile pointers. Bumped
+   * whenever a reader drops tiles (Clear, tile updates) so the per-thread
+   * tile handle caches revalidate lazily. Process-wide rather than per
+   * reader because tile caches can be shared between readers - one reader
+   * clearing a global cache invalidates every other reader's handles too.
+   * Callers holding results derived from tiles (correlation caches) can
+   * compare against it to notice reloads.
+   * @return the generation counter
+   */
+  static std::atomic<uint64_t>& cache_generation();
+
 protected:
   // (Tar) extract of tiles - the contents are empty if not being used
   struct tile_extract_t;
@@ -566,6 +980,84 @@ protected:
   // Information about where the tiles are kept
   std::string tile_dir_;
 
+  // Whether to mmap individual tile files rather than copying them onto the heap
+  bool mmap_tiles_;
+
+  // Sidecar index of the tile directory, written at the end of the tile build.
+  // When present it answers tile existence and tile set queries from memory
+  // instead of statting files or walking the directory tree. Empty (and so
+  // unused) when reading from a tar extract or when no index was written
+  tile_index_t tile_index_;
+
+  // Live speeds maintained by a feeder process, attached to every tile this
+  // reader caches and picked up again in CheckForTileUpdates when the
+  // feeder swaps a new generation in. Empty when traffic_overlay is not set
+  speed_overlay_t speed_overlay_;
+
+  /**
+   * Attach the speed overlay's live speeds for a tile, if it has any,
+   * before the tile goes into the cache.
+   * @param  tile  the loaded tile
+   * @param  base  base graphid of the tile
+   */
+  void AttachSpeedOverlay(GraphTile& tile, const GraphId& base) const;
+
+  // Background tile prefetcher, only present when prefetch_tiles is enabled
+  struct tile_prefetcher_t;
+  std::unique_ptr<tile_prefetcher_t> prefetcher_;
+
+  // Background manifest watcher, only present when tile_manifest_poll_seconds
+  // is set. It just polls the manifest epoch and raises the flag; the cache
+  // itself is only touched from CheckForTileUpdates at a safe point
+  struct tile_manifest_watcher_t;
+  std::unique_ptr<tile_manifest_watcher_t> manifest_watcher_;
+
+  // The manifest epoch the cached tiles were loaded under. Atomic since
+  // the watcher thread compares against it
+  std::atomic<uint64_t> manifest_epoch_;
+
+  // Set by the watcher thread when the manifest epoch on disk moved on
+  std::atomic<bool> update_pending_;
+
+  // Hit/miss and per-tile hotness counters for this reader
+  cache_statistics_t statistics_;
+
+  // True when the configured tile cache is safe for concurrent use and so
+  // the reader itself may be shared between threads. Puts the reader's own
+  // bookkeeping behind locks and turns on the per-thread tile handle cache
+  bool concurrent_;
+
+  // Guards the statistics when the reader is shared between threads
+  mutable std::mutex statistics_mutex_;
+
+  // Serializes remote tile fetches when shared - there is only one curler
+  std::mutex curler_mutex_;
+
+  /**
+   * Bump one statistics counter, locking when the reader is shared.
+   * @param counter  the counter to increment
+   */
+  void BumpStatistic(size_t& counter);
+
+  /**
+   * Record a cache access for a tile, locking when the reader is shared.
+   * @param base     base graphid of the accessed tile
+   * @param counter  the hit or miss counter to increment alongside
+   */
+  void RecordTileAccess(const GraphId& base, size_t& counter);
+
+  // Small LRU of decoded edge shapes keyed by tile and edge info offset.
+  // Keys are stable values (not pointers into tiles) so entries stay
+  // correct across tile cache evictions. Size 0 disables the cache
+  struct shape_cache_entry_t {
+    std::vector<midgard::PointLL> shape;
+    std::list<uint64_t>::iterator lru;
+  };
+  size_t shape_cache_size_;
+  std::unordered_map<uint64_t, shape_cache_entry_t> shape_cache_;
+  std::list<uint64_t> shape_cache_lru_;
+  std::vector<midgard::PointLL> uncached_shape_;
+
   std::unique_ptr<TileCache> cache_;
 };
 
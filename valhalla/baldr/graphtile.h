@@ -24,19 +24,127 @@
 #include <valhalla/baldr/turnlanes.h>
 #include <valhalla/midgard/aabb2.h>
 #include <valhalla/midgard/logging.h>
+#include <valhalla/midgard/sequence.h>
 #include <valhalla/midgard/util.h>
 
+#include <array>
 #include <memory>
 #include <valhalla/baldr/signinfo.h>
 
 namespace valhalla {
 namespace baldr {
 
+/**
+ * Structure of arrays mirror of the hot directed edge fields. Dense scans
+ * (matrix, isochrones) read only a handful of fields from each directed
+ * edge record, so tiles built with the mirror repeat those fields as
+ * parallel arrays that such scans iterate without pulling the full records
+ * into cache. All arrays are indexed by directed edge index within the
+ * tile and are null when the tile does not carry the section.
+ */
+struct EdgeSoA {
+  // Layout of the packed attribute word
+  static constexpr uint32_t kReverseAccessShift = 12; // forward access is the low 12 bits
+  static constexpr uint32_t kClassificationShift = 24;
+  static constexpr uint32_t kShortcutFlag = 1 << 27;
+  static constexpr uint32_t kNotThruFlag = 1 << 28;
+  static constexpr uint32_t kLeavesTileFlag = 1 << 29;
+
+  const uint64_t* endnodes = nullptr;   // End node GraphId values
+  const uint32_t* lengths = nullptr;    // Lengths in meters
+  const uint32_t* attributes = nullptr; // Packed classification, access and flags
+  const uint8_t* speeds = nullptr;      // Speeds in KPH (the base speed of the edge)
+
+  /**
+   * Pack the mirrored attribute fields of a directed edge into one word.
+   * @param  de  Directed edge to mirror.
+   * @return the packed attribute word.
+   */
+  static uint32_t pack_attributes(const DirectedEdge& de) {
+    return de.forwardaccess() | (de.reverseaccess() << kReverseAccessShift) |
+           (static_cast<uint32_t>(de.classification()) << kClassificationShift) |
+           (de.is_shortcut() ? kShortcutFlag : 0) | (de.not_thru() ? kNotThruFlag : 0) |
+           (de.leaves_tile() ? kLeavesTileFlag : 0);
+  }
+
+  /** Forward access modes from a packed attribute word. */
+  static uint32_t forwardaccess(const uint32_t word) {
+    return word & kAllAccess;
+  }
+
+  /** Reverse access modes from a packed attribute word. */
+  static uint32_t reverseaccess(const uint32_t word) {
+    return (word >> kReverseAccessShift) & kAllAccess;
+  }
+
+  /** Road classification from a packed attribute word. */
+  static RoadClass classification(const uint32_t word) {
+    return static_cast<RoadClass>((word >> kClassificationShift) & 0x7);
+  }
+
+  /** Is the edge a shortcut? */
+  static bool is_shortcut(const uint32_t word) {
+    return word & kShortcutFlag;
+  }
+
+  /** Is the edge not-thru? */
+  static bool not_thru(const uint32_t word) {
+    return word & kNotThruFlag;
+  }
+
+  /** Does the edge end in a different tile? */
+  static bool leaves_tile(const uint32_t word) {
+    return word & kLeavesTileFlag;
+  }
+};
+
 /**
  * Graph information for a tile within the Tiled Hierarchical Graph.
  */
 class GraphTile {
 public:
+  // Sections of a tile that are compressed independently in the sectioned
+  // compressed tile format (.gzs) so they can be inflated on first access.
+  // The order matches the section table at the front of the file. Signs and
+  // turn lanes get their own section because only narrative generation reads
+  // them, so tiles that just serve path finding never pay to inflate them
+  enum TileSection : uint32_t {
+    kSectionFixed = 0,    // header through transit transfers
+    kSectionSigns = 1,    // sign and turn lane records
+    kSectionBins = 2,     // admins, edge bins and complex restrictions
+    kSectionEdgeInfo = 3, // edge info records including their shape
+    kSectionNames = 4,    // the text/name list
+    kSectionTail = 5,     // lane connectivity, predicted speeds and beyond
+    kSectionCount = 6,
+  };
+
+  // One record of the section table in a sectioned compressed tile. The
+  // file holds a magic, version, section count and a reserved word (each
+  // 32 bits), then kSectionCount of these, then the deflated blocks back
+  // to back in section order
+  struct SectionRecord {
+    uint64_t raw_offset; // where the section starts within the flat tile
+    uint64_t raw_size;   // size of the section within the flat tile
+    uint64_t comp_size;  // size of the section's deflated block
+  };
+
+  // Front matter of a sectioned compressed tile file
+  static constexpr uint32_t kSectionedTileMagic = 0x737a6776; // "vgzs"
+  static constexpr uint32_t kSectionedTileVersion = 2;
+
+  /**
+   * Where each section starts within a flat tile with the given header.
+   * The writer carves the tile into deflated blocks along these boundaries
+   * and the lazy section mapping checks them against the section table, so
+   * both sides must agree on this one computation.
+   * @param  header     header of the flat tile.
+   * @param  tile_size  size in bytes of the flat tile.
+   * @return Returns kSectionCount + 1 offsets, section i spanning
+   *         [offset i, offset i + 1).
+   */
+  static std::array<uint64_t, kSectionCount + 1> SectionBounds(const GraphTileHeader& header,
+                                                               const uint64_t tile_size);
+
   /**
    * Constructor
    */
@@ -44,11 +152,15 @@ public:
 
   /**
    * Constructor given a GraphId. Reads the graph tile from file
-   * into memory.
+   * into memory or, when requested, maps the tile file read-only so the
+   * pages are shared with any other process mapping the same tile.
    * @param  tile_dir   Tile directory.
    * @param  graphid    GraphId (tileid and level)
+   * @param  memmap     If true mmap the flat tile file rather than copying
+   *                    it onto the heap. Gzipped tiles fall back to the
+   *                    buffered path since they must be inflated anyway.
    */
-  GraphTile(const std::string& tile_dir, const GraphId& graphid);
+  GraphTile(const std::string& tile_dir, const GraphId& graphid, const bool memmap = false);
 
   /**
    * Constructor given the graph Id, pointer to the tile data, and the
@@ -59,6 +171,17 @@ public:
    */
   GraphTile(const GraphId& graphid, char* ptr, size_t size);
 
+  /**
+   * Constructor given the graph Id and caller-owned tile bytes. The tile
+   * shares ownership of the buffer rather than copying it, so callers that
+   * already hold the bytes (custom archives, network payloads, test
+   * fixtures) can hand them over zero-copy and still put the tile into a
+   * cache that outlives them.
+   * @param  graphid  Tile Id.
+   * @param  memory   Shared buffer holding the tile's bytes.
+   */
+  GraphTile(const GraphId& graphid, std::shared_ptr<std::vector<char>> memory);
+
   /**
    * Constructor given the graph Id, in memory tile data
    * @param  tile_url URL of tile
@@ -108,6 +231,15 @@ public:
     return header_;
   }
 
+  /**
+   * Is the tile data backed by a read-only memory mapped file rather than
+   * a private heap copy?
+   * @return  Returns true if the tile bytes live in a memory mapped file.
+   */
+  bool memmapped() const {
+    return memmap_ != nullptr;
+  }
+
   /**
    * Get a pointer to a node.
    * @return  Returns a pointer to the node.
@@ -189,6 +321,18 @@ public:
    */
   iterable_t<const DirectedEdge> GetDirectedEdges(const size_t idx) const;
 
+  /**
+   * Get the contiguous range of directed edges leaving a node. Unlike the
+   * index based overloads this one does no bounds checking since the caller
+   * already holds a validated NodeInfo from this tile, which keeps the
+   * expansion loops free of per node checks and exception machinery.
+   * @param  node  node whose edges to get, must be a node of this tile
+   * @return returns an iterable collection of directed edges
+   */
+  iterable_t<const DirectedEdge> GetDirectedEdges(const NodeInfo* node) const {
+    return iterable_t<const DirectedEdge>{directededges_ + node->edge_index(), node->edge_count()};
+  }
+
   /**
    * Convenience method to get opposing edge Id given a directed edge.
    * The end node of the directed edge must be in this tile.
@@ -231,6 +375,18 @@ public:
         " nodecount= " + std::to_string(header_->nodecount()));
   }
 
+  /**
+   * Get the contiguous range of transitions leaving a node. As with the
+   * DirectedEdge span this skips the bounds checks the GraphId overload
+   * performs since the NodeInfo was already validated against this tile.
+   * @param  node  node whose transitions to get, must be a node of this tile
+   * @return returns an iterable collection of node transitions
+   */
+  iterable_t<const NodeTransition> GetNodeTransitions(const NodeInfo* node) const {
+    return iterable_t<const NodeTransition>{transitions_ + node->transition_index(),
+                                            node->transition_count()};
+  }
+
   /**
    * Get a pointer to edge info.
    * @return  Returns edge info.
@@ -326,6 +482,41 @@ public:
                                            bool wheelchair,
                                            bool bicycle) const;
 
+  /**
+   * Get the next departure given the directed edge Id and the current
+   * time, with the schedule validity for the service day already collapsed
+   * into a bitset (see GetScheduleValidity). Each departure candidate then
+   * costs a single bit test instead of re-evaluating the day and day of
+   * week masks.
+   * @param   lineid            Transit Line Id
+   * @param   current_time      Current time (seconds from midnight).
+   * @param   valid_schedules   Bitset over this tile's schedule indexes.
+   * @param   wheelchair        Only find departures with wheelchair access if true
+   * @param   bicycle           Only find departures with bicycle access if true
+   * @return  Returns a pointer to the transit departure information.
+   *          Returns nullptr if no departures are found.
+   */
+  const TransitDeparture* GetNextDeparture(const uint32_t lineid,
+                                           const uint32_t current_time,
+                                           const std::vector<bool>& valid_schedules,
+                                           bool wheelchair,
+                                           bool bicycle) const;
+
+  /**
+   * Collapse the validity of every schedule entry in this tile for a
+   * single service day into a bitset indexed by schedule index. Search
+   * algorithms hold one service day fixed for a whole request, so they can
+   * compute this once per tile and hand it to GetNextDeparture.
+   * @param   day               Days since the tile creation date.
+   * @param   dow               Day of week (see graphconstants.h)
+   * @param   date_before_tile  Is the date that was inputed before
+   *                            the tile creation date?
+   * @return  Returns a bitset with bit i set when schedule entry i is
+   *          valid on the service day.
+   */
+  std::vector<bool>
+  GetScheduleValidity(const uint32_t day, const uint32_t dow, bool date_before_tile) const;
+
   /**
    * Get the departure given the directed edge Id and tripid
    * @param   lineid  Transit Line Id
@@ -428,6 +619,10 @@ public:
    * @return  Returns the speed for the edge.
    */
   uint32_t GetSpeed(const DirectedEdge* de) const {
+    const uint32_t live = overlay_speed(de);
+    if (live > 0) {
+      return live;
+    }
     return (de->free_flow_speed() > 0) ? de->free_flow_speed() : de->speed();
   }
 
@@ -439,6 +634,11 @@ public:
    * @return Returns the speed for the edge.
    */
   uint32_t GetSpeed(const DirectedEdge* de, const uint32_t seconds_of_day) const {
+    const uint32_t live = overlay_speed(de);
+    if (live > 0) {
+      return live;
+    }
+
     // if time dependent route and we are routing between 7 AM and 7 PM local time.
     if (25200 < seconds_of_day && seconds_of_day < 68400) {
       return (de->constrained_flow_speed() > 0) ? de->constrained_flow_speed() : de->speed();
@@ -456,7 +656,13 @@ public:
    */
   uint32_t
   GetSpeed(const DirectedEdge* de, const GraphId& edgeid, const uint32_t seconds_of_week) const {
+    const uint32_t live = overlay_speed(de);
+    if (live > 0) {
+      return live;
+    }
+
     if (de->predicted_speed()) {
+      EnsureSection(kSectionTail);
       float spd = predictedspeeds_.speed(edgeid.id(), seconds_of_week);
       if (spd > 0.0f && spd < kMaxSpeedKph) {
         return static_cast<uint32_t>(spd);
@@ -477,7 +683,11 @@ public:
    */
   std::vector<uint16_t> turnlanes(const uint32_t idx) const {
     uint32_t offset = turnlanes_offset(idx);
-    return (offset > 0) ? TurnLanes::lanemasks(textlist_ + offset) : std::vector<uint16_t>();
+    if (offset == 0) {
+      return std::vector<uint16_t>();
+    }
+    EnsureSection(kSectionNames);
+    return TurnLanes::lanemasks(textlist_ + offset);
   }
 
   /**
@@ -488,10 +698,82 @@ public:
    */
   uint32_t turnlanes_offset(const uint32_t idx) const;
 
+  /**
+   * Attach live speeds from a speed overlay to this tile. The speeds are a
+   * byte per directed edge index (kph, 0 meaning no data) and take
+   * precedence over predicted and historical speeds in GetSpeed. The anchor
+   * keeps the overlay mapping alive as long as this tile is cached.
+   * @param  speeds  Per edge speed bytes, indexed by directed edge index.
+   * @param  count   Number of speed bytes.
+   * @param  anchor  Shared handle on the mapping backing the speeds.
+   */
+  void SetSpeedOverlay(const uint8_t* speeds, uint32_t count, std::shared_ptr<const void> anchor) {
+    overlay_speeds_ = speeds;
+    overlay_speed_count_ = count;
+    overlay_anchor_ = std::move(anchor);
+  }
+
+  /**
+   * Does this tile carry the directed edge SoA mirror section?
+   * @return true if the SoA arrays are available.
+   */
+  bool has_edge_soa() const {
+    return edge_soa_.endnodes != nullptr;
+  }
+
+  /**
+   * Get the directed edge SoA mirror arrays. Only valid when
+   * has_edge_soa() is true.
+   * @return the parallel endnode/length/attribute/speed arrays.
+   */
+  const EdgeSoA& edge_soa() const {
+    EnsureSection(kSectionTail);
+    return edge_soa_;
+  }
+
 protected:
+  /**
+   * The live speed for an edge of this tile, 0 when the overlay has none.
+   * @param  de  Directed edge within this tile.
+   */
+  uint32_t overlay_speed(const DirectedEdge* de) const {
+    const size_t idx = de - directededges_;
+    return idx < overlay_speed_count_ ? overlay_speeds_[idx] : 0;
+  }
+
+  /**
+   * Shared implementation for the GetNextDeparture overloads. Walks the
+   * line's departures in time order and returns the first one the schedule
+   * validity predicate accepts.
+   * @param   lineid        Transit Line Id
+   * @param   current_time  Current time (seconds from midnight).
+   * @param   wheelchair    Only find departures with wheelchair access if true
+   * @param   bicycle       Only find departures with bicycle access if true
+   * @param   valid         Predicate over a schedule index.
+   * @return  Returns a pointer to the transit departure information.
+   *          Returns nullptr if no departures are found.
+   */
+  template <class validity_t>
+  const TransitDeparture* NextDeparture(const uint32_t lineid,
+                                        const uint32_t current_time,
+                                        bool wheelchair,
+                                        bool bicycle,
+                                        const validity_t& valid) const;
+
   // Graph tile memory, this must be shared so that we can put it into cache
   std::shared_ptr<std::vector<char>> graphtile_;
 
+  // Deflated sections of a sectioned compressed tile (.gzs) that have not
+  // been inflated yet. Null for flat, mapped and wholly gzipped tiles.
+  // Shared like the tile bytes so every copy of this tile inflates each
+  // section exactly once
+  struct lazy_sections_t;
+  std::shared_ptr<lazy_sections_t> lazy_sections_;
+
+  // Memory mapped tile file, used in place of the heap copy above. Shared for
+  // the same reason and so the mapping outlives every copy of this tile
+  std::shared_ptr<midgard::mem_map<char>> memmap_;
+
   // Header information for the tile
   GraphTileHeader* header_;
 
@@ -550,6 +832,18 @@ protected:
   // Size of the complex restrictions in the reverse direction
   std::size_t complex_restriction_reverse_size_;
 
+  // Indexes of the complex restrictions by the edge Id each applies to -
+  // to_graphid for the forward direction, from_graphid for the reverse.
+  // Built when the tile is loaded so restriction lookups during expansion
+  // are constant time rather than a scan of the whole section.
+  std::unordered_multimap<uint64_t, ComplexRestriction*> complex_restriction_forward_index_;
+  std::unordered_multimap<uint64_t, ComplexRestriction*> complex_restriction_reverse_index_;
+
+  // Contiguous [begin, end) ranges of the transit departure list by line Id.
+  // Built when the tile is loaded so a schedule lookup binary searches only
+  // its own line's departures instead of the whole list.
+  std::unordered_map<uint32_t, std::pair<uint32_t, uint32_t>> departure_index_;
+
   // List of edge info structures. Since edgeinfo is not fixed size we
   // use offsets in directed edges.
   char* edgeinfo_;
@@ -577,6 +871,17 @@ protected:
   // Predicted speeds
   PredictedSpeeds predictedspeeds_;
 
+  // The directed edge SoA mirror arrays when the tile carries the section,
+  // all pointers null otherwise
+  EdgeSoA edge_soa_;
+
+  // Live speeds from the speed overlay, a byte per directed edge index (0
+  // meaning no data). Null/0 when no overlay covers this tile. The anchor
+  // keeps the overlay mapping these point into alive across feeder swaps
+  const uint8_t* overlay_speeds_ = nullptr;
+  uint32_t overlay_speed_count_ = 0;
+  std::shared_ptr<const void> overlay_anchor_;
+
   // Map of stop one stops in this tile.
   std::unordered_map<std::string, GraphId> stop_one_stops;
 
@@ -586,6 +891,35 @@ protected:
   // Map of operator one stops in this tile.
   std::unordered_map<std::string, std::list<GraphId>> oper_one_stops;
 
+  /**
+   * Make sure a lazily compressed section is resident before its bytes are
+   * read. A no-op for flat, mapped and wholly gzipped tiles.
+   * @param  section  Which section (see TileSection).
+   */
+  void EnsureSection(const size_t section) const {
+    if (lazy_sections_) {
+      MaterializeSection(section);
+    }
+  }
+
+  /**
+   * Inflate a section of a sectioned compressed tile into its place in the
+   * tile buffer if that has not happened yet. Thread safe - concurrent
+   * readers of a shared tile block until the bytes are resident.
+   * @param  section  Which section (see TileSection).
+   */
+  void MaterializeSection(const size_t section) const;
+
+  /**
+   * Load a sectioned compressed tile (.gzs). Reads the section table,
+   * inflates the fixed section and leaves the rest to be inflated on
+   * first access.
+   * @param  graphid  Graph Id for the tile.
+   * @param  file     Stream positioned at the start of the file.
+   * @return Returns true if the file held a usable sectioned tile.
+   */
+  bool LoadSectioned(const GraphId& graphid, std::istream& file);
+
   /**
    * Set pointers to internal tile data structures.
    * @param  graphid    Graph Id for the tile.
@@ -594,6 +928,20 @@ protected:
    */
   void Initialize(const GraphId& graphid, char* tile_ptr, const size_t tile_size);
 
+  /**
+   * Index the complex restriction sections by the edge Id each restriction
+   * applies to. One pass over each section at tile load replaces a scan of
+   * the whole section on every lookup.
+   */
+  void IndexComplexRestrictions();
+
+  /**
+   * Index the transit departure list by line Id. Departures are sorted by
+   * line Id then departure time so each line's departures are one contiguous
+   * range; schedule lookups then search only their own line.
+   */
+  void IndexDepartures();
+
   /**
    * For transit tiles, save off the pair<tileid,lineid> lookup via
    * onestop_ids.  This will be used for including or excluding transit lines
@@ -16,7 +16,7 @@ namespace baldr {
 // something to the tile simply subtract one from this number and add it
 // just before the empty_slots_ array below. NOTE that it can ONLY be an
 // offset in bytes and NOT a bitfield or union or anything of that sort
-constexpr size_t kEmptySlots = 12;
+constexpr size_t kEmptySlots = 11;
 
 // Maximum size of the version string (stored as a fixed size
 // character array so the GraphTileHeader size remains fixed).
@@ -158,6 +158,162 @@ public:
     has_ext_directededge_ = ext;
   }
 
+  /**
+   * Gets the flag indicating whether edge infos in this tile may carry shape
+   * vertex checkpoint indexes. Only builders that clear the spare packed
+   * bits set this, so the per edge flag can be trusted when it is on.
+   * @return  Returns true if the per edge shape index flags are meaningful.
+   */
+  bool has_shape_indexes() const {
+    return has_shape_indexes_;
+  }
+
+  /**
+   * Sets the flag indicating whether edge infos in this tile may carry shape
+   * vertex checkpoint indexes.
+   * @param  index  True if the per edge shape index flags are meaningful.
+   */
+  void set_has_shape_indexes(const bool index) {
+    has_shape_indexes_ = index;
+  }
+
+  /**
+   * Gets the flag indicating whether the directed edges in this tile carry
+   * the admin crossing flags (country and state/province changes) computed
+   * at build time. Only set once the enhancer has compared the admin
+   * records at each edge's end nodes, so the per edge flags can be trusted
+   * when it is on.
+   * @return  Returns true if the per edge admin crossing flags are meaningful.
+   */
+  bool has_admin_crossings() const {
+    return has_admin_crossings_;
+  }
+
+  /**
+   * Sets the flag indicating whether the directed edges in this tile carry
+   * the admin crossing flags.
+   * @param  crossings  True if the per edge admin crossing flags are meaningful.
+   */
+  void set_has_admin_crossings(const bool crossings) {
+    has_admin_crossings_ = crossings;
+  }
+
+  /**
+   * Gets the flag indicating whether this tile carries the precomputed
+   * routing statistics (edge class shares, node density percentiles and
+   * the branching factor) in its spare words. Written by
+   * valhalla_build_statistics; legacy tiles read zeros.
+   * @return  Returns true if the tile statistics are meaningful.
+   */
+  bool has_stats() const {
+    return has_stats_;
+  }
+
+  /**
+   * Sets the flag indicating whether this tile carries the precomputed
+   * routing statistics in its spare words.
+   * @param  stats  True if the tile statistics are meaningful.
+   */
+  void set_has_stats(const bool stats) {
+    has_stats_ = stats;
+  }
+
+  /**
+   * Get the share of this tile's directed edges with the given road
+   * classification.
+   * @param  road_class  Road classification (0=motorway through 7=service).
+   * @return  Returns the share as a percent (0-100).
+   */
+  uint32_t edge_class_percent(const uint32_t road_class) const {
+    return (spareword0_ >> ((road_class & 0x7) * 7)) & 0x7f;
+  }
+
+  /**
+   * Set the share of this tile's directed edges with the given road
+   * classification.
+   * @param  road_class  Road classification (0=motorway through 7=service).
+   * @param  percent     Share as a percent, clamped to 100.
+   */
+  void set_edge_class_percent(const uint32_t road_class, const uint32_t percent) {
+    uint64_t shift = (road_class & 0x7) * 7;
+    uint64_t value = (percent <= 100) ? percent : 100;
+    spareword0_ = (spareword0_ & ~(static_cast<uint64_t>(0x7f) << shift)) | (value << shift);
+  }
+
+  /**
+   * Get the median of the node densities within this tile.
+   * @return  Returns the median relative density (0-15).
+   */
+  uint32_t node_density_p50() const {
+    return spareword1_ & 0xf;
+  }
+
+  /**
+   * Set the median of the node densities within this tile.
+   * @param  density  Median relative density (0-15).
+   */
+  void set_node_density_p50(const uint32_t density) {
+    spareword1_ = (spareword1_ & ~static_cast<uint64_t>(0xf)) |
+                  ((density <= kMaxDensity) ? density : kMaxDensity);
+  }
+
+  /**
+   * Get the 90th percentile of the node densities within this tile.
+   * @return  Returns the 90th percentile relative density (0-15).
+   */
+  uint32_t node_density_p90() const {
+    return (spareword1_ >> 4) & 0xf;
+  }
+
+  /**
+   * Set the 90th percentile of the node densities within this tile.
+   * @param  density  90th percentile relative density (0-15).
+   */
+  void set_node_density_p90(const uint32_t density) {
+    spareword1_ = (spareword1_ & ~(static_cast<uint64_t>(0xf) << 4)) |
+                  (static_cast<uint64_t>((density <= kMaxDensity) ? density : kMaxDensity) << 4);
+  }
+
+  /**
+   * Get the average expansion branching factor of this tile - directed
+   * edges per node.
+   * @return  Returns the branching factor (0 - ~16, 1/16 resolution).
+   */
+  float branching_factor() const {
+    return ((spareword1_ >> 8) & 0xff) / 16.0f;
+  }
+
+  /**
+   * Set the average expansion branching factor of this tile.
+   * @param  factor  Directed edges per node, clamped to the 8 bit fixed
+   *                 point range.
+   */
+  void set_branching_factor(const float factor) {
+    uint64_t fixed = (factor <= 0.0f) ? 0 : static_cast<uint64_t>(factor * 16.0f + 0.5f);
+    fixed = (fixed <= 0xff) ? fixed : 0xff;
+    spareword1_ = (spareword1_ & ~(static_cast<uint64_t>(0xff) << 8)) | (fixed << 8);
+  }
+
+  /**
+   * Get the update generation of this tile. Bumped each time the tile is
+   * patched in place (e.g. a speed refresh) so readers can detect that the
+   * tile changed without comparing its contents. Tiles that have never
+   * been patched read 0.
+   * @return  Returns the update generation counter.
+   */
+  uint32_t update_generation() const {
+    return (spareword1_ >> 16) & 0xffff;
+  }
+
+  /**
+   * Set the update generation of this tile. Wraps at 16 bits.
+   * @param  generation  Update generation counter.
+   */
+  void set_update_generation(const uint32_t generation) {
+    spareword1_ = (spareword1_ & ~(static_cast<uint64_t>(0xffff) << 16)) |
+                  (static_cast<uint64_t>(generation & 0xffff) << 16);
+  }
+
   /**
    * Get the base (SW corner) of the tile.
    * @return Returns the base lat,lon of the tile (degrees).
@@ -566,6 +722,33 @@ public:
     predictedspeeds_offset_ = offset;
   }
 
+  /**
+   * Gets the offset to the directed edge SoA mirror section.
+   * @return  Returns the offset (bytes) to the parallel endnode/length/
+   *          attribute/speed arrays.
+   */
+  uint32_t edge_soa_offset() const {
+    return edge_soa_offset_;
+  }
+
+  /**
+   * Sets the offset to the directed edge SoA mirror section.
+   * @param offset Offset in bytes to the SoA mirror arrays.
+   */
+  void set_edge_soa_offset(const uint32_t offset) {
+    edge_soa_offset_ = offset;
+  }
+
+  /**
+   * Does this tile carry the directed edge SoA mirror? Tiles written
+   * before the section existed carry the end offset in this slot, so a
+   * valid section sits strictly between 0 and the end of the tile.
+   * @return true if the tile has the SoA mirror section.
+   */
+  bool has_edge_soa() const {
+    return edge_soa_offset_ != 0 && edge_soa_offset_ < end_offset();
+  }
+
   /**
    * Get the offset to the end of the tile
    * @return the number of bytes in the tile, unless the last slot is used
@@ -615,7 +798,10 @@ protected:
   uint32_t transitioncount_ : 22; // Number of node transitions
   uint32_t turnlane_count_ : 21;  // Number of turnlane records
   uint64_t transfercount_ : 16;   // Number of transit transfer records
-  uint64_t spare2_ : 7;
+  uint64_t has_shape_indexes_ : 1;   // Edge infos may carry shape vertex checkpoint indexes
+  uint64_t has_admin_crossings_ : 1; // Directed edges carry admin crossing flags
+  uint64_t has_stats_ : 1;           // Spare words carry the precomputed tile statistics
+  uint64_t spare2_ : 4;
 
   // Number of transit records
   uint64_t departurecount_ : 24;
@@ -653,6 +839,13 @@ protected:
   // Offset to the beginning of the predicted speed data
   uint32_t predictedspeeds_offset_;
 
+  // Offset to the directed edge SoA mirror - parallel endnode, length,
+  // packed attribute and speed arrays the dense algorithms scan in place
+  // of the full directed edge records. Tiles without the section carry 0
+  // or the end offset here (legacy tiles wrote the end offset into every
+  // empty slot)
+  uint32_t edge_soa_offset_;
+
   // Marks the end of this version of the tile with the rest of the slots
   // being available for growth. If you want to use one of the empty slots,
   // simply add a uint32_t some_offset_; just above empty_slots_ and decrease
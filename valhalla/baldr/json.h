@@ -5,6 +5,7 @@
 #include <cinttypes>
 #include <cmath>
 #include <cstddef>
+#include <cstdio>
 #include <iomanip>
 #include <list>
 #include <memory>
@@ -12,6 +13,7 @@
 #include <sstream>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 namespace valhalla {
 namespace baldr {
@@ -173,12 +175,231 @@ inline std::ostream& operator<<(std::ostream& stream, const Jarray& json) {
   return stream;
 }
 
+// Streaming writer that emits json directly into a growing string. When the
+// structure of the output is known up front this avoids allocating the
+// intermediate tree of maps and arrays entirely - on megabyte sized geojson
+// responses more time goes into building the tree than computing the result.
+// Produces the same text as serializing the equivalent tree, except that
+// object keys appear in the order they are written rather than in hash order.
+class Writer {
+public:
+  explicit Writer(const size_t reserve = 1024) : after_key_(false) {
+    buffer_.reserve(reserve);
+  }
+  void start_object() {
+    prefix();
+    buffer_.push_back('{');
+    nesting_.push_back(false);
+  }
+  void end_object() {
+    buffer_.push_back('}');
+    nesting_.pop_back();
+  }
+  void start_array() {
+    prefix();
+    buffer_.push_back('[');
+    nesting_.push_back(false);
+  }
+  void end_array() {
+    buffer_.push_back(']');
+    nesting_.pop_back();
+  }
+  void key(const std::string& name) {
+    prefix();
+    escape(name);
+    buffer_.push_back(':');
+    after_key_ = true;
+  }
+  void value(const std::string& value) {
+    prefix();
+    escape(value);
+  }
+  void value(const char* value) {
+    prefix();
+    escape(value);
+  }
+  void value(const uint64_t value) {
+    prefix();
+    buffer_.append(std::to_string(value));
+  }
+  void value(const int64_t value) {
+    prefix();
+    buffer_.append(std::to_string(value));
+  }
+  void value(const fp_t value) {
+    prefix();
+    char fixed[64];
+    if (std::isfinite(value.value)) {
+      snprintf(fixed, sizeof(fixed), "%.*Lf", static_cast<int>(value.precision), value.value);
+      buffer_.append(fixed);
+    } else {
+      snprintf(fixed, sizeof(fixed), "\"%.*Lf\"", static_cast<int>(value.precision), value.value);
+      buffer_.append(fixed);
+    }
+  }
+  void value(const bool value) {
+    prefix();
+    buffer_.append(value ? "true" : "false");
+  }
+  void value(const std::nullptr_t) {
+    prefix();
+    buffer_.append("null");
+  }
+  // hand back the finished document, the writer is done at this point
+  std::string document() {
+    return std::move(buffer_);
+  }
+
+private:
+  // separate this element from a preceding one in the enclosing container
+  void prefix() {
+    if (after_key_) {
+      after_key_ = false;
+      return;
+    }
+    if (!nesting_.empty()) {
+      if (nesting_.back()) {
+        buffer_.push_back(',');
+      } else {
+        nesting_.back() = true;
+      }
+    }
+  }
+  // same escaping as OstreamVisitor above
+  void escape(const std::string& value) {
+    buffer_.push_back('"');
+    for (const auto& c : value) {
+      switch (c) {
+        case '\\':
+          buffer_.append("\\\\");
+          break;
+        case '"':
+          buffer_.append("\\\"");
+          break;
+        case '/':
+          buffer_.append("\\/");
+          break;
+        case '\b':
+          buffer_.append("\\b");
+          break;
+        case '\f':
+          buffer_.append("\\f");
+          break;
+        case '\n':
+          buffer_.append("\\n");
+          break;
+        case '\r':
+          buffer_.append("\\r");
+          break;
+        case '\t':
+          buffer_.append("\\t");
+          break;
+        default:
+          if (c >= 0 && c < 32) {
+            char unicode[8];
+            snprintf(unicode, sizeof(unicode), "\\u%04X", static_cast<int>(c));
+            buffer_.append(unicode);
+          } else {
+            buffer_.push_back(c);
+          }
+          break;
+      }
+    }
+    buffer_.push_back('"');
+  }
+
+  std::string buffer_;
+  std::vector<bool> nesting_;
+  bool after_key_;
+};
+
+// A per worker (thread local) slab from which the map and array nodes and
+// their shared_ptr control blocks are carved. Big responses build tens of
+// thousands of nodes; fixed size slots recycled through a free list keep the
+// worker threads out of the global allocator (and its locks) on the hot
+// serialization path. The slabs themselves are kept for the life of the
+// thread so steady state requests allocate nothing at all. A slot released
+// on another thread lands on that thread's free list - the memory stays
+// valid since the slabs of these long lived worker threads are never freed.
+class Slab {
+public:
+  // big enough for a map or array node together with its control block
+  static constexpr size_t kSlotSize = 128;
+  static constexpr size_t kSlotsPerSlab = 1024;
+
+  static Slab& instance() {
+    static thread_local Slab slab;
+    return slab;
+  }
+
+  void* allocate(const size_t size) {
+    // anything that does not fit a slot takes the normal path
+    if (size > kSlotSize) {
+      return ::operator new(size);
+    }
+    // reuse a released slot when there is one
+    if (free_list_) {
+      auto* slot = free_list_;
+      free_list_ = slot->next;
+      return slot;
+    }
+    // carve the next slot out of the newest slab, adding one when full
+    if (slabs_.empty() || used_ == kSlotsPerSlab) {
+      slabs_.emplace_back(new char[kSlotSize * kSlotsPerSlab]);
+      used_ = 0;
+    }
+    return slabs_.back().get() + kSlotSize * used_++;
+  }
+
+  void deallocate(void* p, const size_t size) {
+    if (size > kSlotSize) {
+      ::operator delete(p);
+      return;
+    }
+    auto* slot = static_cast<Slot*>(p);
+    slot->next = free_list_;
+    free_list_ = slot;
+  }
+
+private:
+  Slab() : free_list_(nullptr), used_(0) {
+  }
+
+  struct Slot {
+    Slot* next;
+  };
+  std::vector<std::unique_ptr<char[]>> slabs_;
+  Slot* free_list_;
+  size_t used_;
+};
+
+// std allocator over the slab so allocate_shared puts a node and its
+// control block into a single slot
+template <typename T> struct SlabAllocator {
+  using value_type = T;
+  SlabAllocator() = default;
+  template <typename U> SlabAllocator(const SlabAllocator<U>&) {
+  }
+  T* allocate(const size_t n) {
+    return static_cast<T*>(Slab::instance().allocate(n * sizeof(T)));
+  }
+  void deallocate(T* p, const size_t n) {
+    Slab::instance().deallocate(p, n * sizeof(T));
+  }
+  template <typename U> bool operator==(const SlabAllocator<U>&) const {
+    return true;
+  }
+  template <typename U> bool operator!=(const SlabAllocator<U>&) const {
+    return false;
+  }
+};
+
 inline MapPtr map(std::initializer_list<Jmap::value_type> list) {
-  return MapPtr(new Jmap(list));
+  return std::allocate_shared<Jmap>(SlabAllocator<Jmap>{}, list);
 }
 
 inline ArrayPtr array(std::initializer_list<Jarray::value_type> list) {
-  return ArrayPtr(new Jarray(list));
+  return std::allocate_shared<Jarray>(SlabAllocator<Jarray>{}, list);
 }
 
 } // namespace json
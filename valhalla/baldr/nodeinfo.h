@@ -104,6 +104,24 @@ public:
    */
   void set_edge_count(const uint32_t edge_count);
 
+  /**
+   * Get the number of shortcut edges at the start of this node's edge
+   * list. The tile builder stores shortcuts before the regular edges, so
+   * the first shortcut_count edges are the shortcuts and the rest are
+   * regular edges. 0 for nodes without shortcuts (or tiles built before
+   * the count was recorded, where callers must test each edge).
+   * @return  Returns the number of leading shortcut edges.
+   */
+  uint32_t shortcut_count() const {
+    return shortcut_count_;
+  }
+
+  /**
+   * Set the number of shortcut edges at the start of this node's edge list.
+   * @param  shortcut_count  the number of leading shortcut edges.
+   */
+  void set_shortcut_count(const uint32_t shortcut_count);
+
   /**
    * Get the access modes (bit mask) allowed to pass through the node.
    * See graphconstants.h for access constants.
@@ -397,7 +415,8 @@ protected:
                                      // (up to kMaxLocalEdgeIndex+1)
   uint64_t drive_on_right_ : 1;      // Driving side. Right if true (false=left)
 
-  uint64_t spare2_ : 20;
+  uint64_t shortcut_count_ : 7; // Number of shortcut edges at the start of the edge list
+  uint64_t spare2_ : 13;
 
   // Headings of up to kMaxLocalEdgeIndex+1 local edges (rounded to nearest 2 degrees)
   // for all other levels. Connecting way Id (for transit level) while data build occurs.
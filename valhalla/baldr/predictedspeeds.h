@@ -105,14 +105,22 @@ public:
     // Get a pointer to the precomputed cos values for this bucket
     const float* b = BucketCosTable::GetInstance().get(seconds_of_week / kSpeedBucketSizeSeconds);
 
-    // DTC-III with speed normalization
-    float speed = *coefficients * k1OverSqrt2;
-    ++coefficients;
-    ++b;
-    for (uint32_t k = 1; k < kCoefficientCount; ++k, ++coefficients, ++b) {
-      speed += *coefficients * *b;
+    // DTC-III with speed normalization. The dot product is accumulated in
+    // four independent partial sums to break the addition dependency chain,
+    // which keeps the multiply-adds in flight and lets the compiler use
+    // SIMD where the target supports it. The first cos term is replaced by
+    // 1/sqrt(2) per DCT-III.
+    float sum0 = coefficients[0] * k1OverSqrt2;
+    float sum1 = coefficients[1] * b[1];
+    float sum2 = coefficients[2] * b[2];
+    float sum3 = coefficients[3] * b[3];
+    for (uint32_t k = 4; k < kCoefficientCount; k += 4) {
+      sum0 += coefficients[k] * b[k];
+      sum1 += coefficients[k + 1] * b[k + 1];
+      sum2 += coefficients[k + 2] * b[k + 2];
+      sum3 += coefficients[k + 3] * b[k + 3];
     }
-    return speed * kSpeedNormalization;
+    return ((sum0 + sum1) + (sum2 + sum3)) * kSpeedNormalization;
   }
 
 protected:
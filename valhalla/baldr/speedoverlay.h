@@ -0,0 +1,93 @@
+#ifndef VALHALLA_BALDR_SPEEDOVERLAY_H_
+#define VALHALLA_BALDR_SPEEDOVERLAY_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+#include <valhalla/baldr/graphid.h>
+#include <valhalla/midgard/sequence.h>
+
+namespace valhalla {
+namespace baldr {
+
+/**
+ * A read only view onto live speeds maintained by a feeder process. The
+ * overlay is one memory mapped file holding a speed byte (kph, 0 meaning
+ * no data) per directed edge index, grouped per tile. The feeder writes a
+ * complete new file and renames it into place; refresh() picks the new
+ * generation up between requests, while tiles still pointing into the old
+ * mapping keep it alive through the anchor handed out with their speeds.
+ *
+ * layout: header_t, then header_t::count record_t entries, then the speed
+ * bytes the records point at.
+ */
+struct speed_overlay_t {
+
+  struct header_t {
+    uint32_t magic;      // kSpeedOverlayMagic
+    uint32_t version;    // kSpeedOverlayVersion
+    uint64_t generation; // incremented by the feeder on every swap
+    uint64_t count;      // number of tile records that follow
+  };
+
+  struct record_t {
+    uint64_t graphid; // tile base id
+    uint64_t offset;  // offset of the tile's speed bytes from the file start
+    uint32_t count;   // speeds (directed edges) in the tile
+    uint32_t spare;
+  };
+
+  // a tile's slice of the overlay plus the anchor keeping the map alive
+  struct tile_speeds_t {
+    const uint8_t* speeds = nullptr;
+    uint32_t count = 0;
+    std::shared_ptr<const midgard::mem_map<char>> anchor;
+  };
+
+  /**
+   * Remember the overlay file and map its current contents. Missing or
+   * malformed files leave the overlay empty so callers fall back to the
+   * static tile speeds.
+   * @param filename  path to the overlay file
+   * @return true if a valid overlay was mapped
+   */
+  bool from_file(const std::string& filename);
+
+  /**
+   * Remap the overlay if the feeder swapped a new generation into place.
+   * Only call between requests; tiles loaded before the swap keep the
+   * previous mapping alive via their anchors until they are evicted.
+   * @return true if a newer generation was mapped
+   */
+  bool refresh();
+
+  /**
+   * Get the live speeds for a tile. The speeds pointer is null when the
+   * overlay has no data for the tile.
+   * @param tile_base  base graphid of the tile
+   */
+  tile_speeds_t tile_speeds(const GraphId& tile_base) const;
+
+  uint64_t generation() const {
+    return generation_;
+  }
+
+  bool empty() const {
+    return directory_.empty();
+  }
+
+protected:
+  std::string filename_;
+  uint64_t generation_ = 0;
+  std::shared_ptr<const midgard::mem_map<char>> mmap_;
+  // tile base id to offset and edge count within the mapping
+  std::unordered_map<uint64_t, std::pair<uint64_t, uint32_t>> directory_;
+};
+
+} // namespace baldr
+} // namespace valhalla
+
+#endif // VALHALLA_BALDR_SPEEDOVERLAY_H_
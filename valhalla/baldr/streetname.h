@@ -10,7 +10,10 @@ namespace baldr {
 class StreetName {
 public:
   /**
-   * Constructor.
+   * Constructor. The name string is interned in a per worker thread pool -
+   * the same names are decoded from the tiles request after request so
+   * identical names share a single stable string rather than each object
+   * carrying its own heap copy.
    * @param  value  Street name string.
    * @param  is_route_number   boolean indicating if street name is a reference route number.
    */
@@ -43,7 +46,9 @@ public:
   virtual bool HasSameBaseName(const StreetName& rhs) const;
 
 protected:
-  std::string value_;
+  // Handle into the thread's intern pool; names compare equal by handle
+  // before falling back to the characters
+  std::shared_ptr<const std::string> value_;
   bool is_route_number_;
 };
 
@@ -0,0 +1,64 @@
+#ifndef VALHALLA_BALDR_TILEINDEX_H_
+#define VALHALLA_BALDR_TILEINDEX_H_
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+#include <valhalla/baldr/graphid.h>
+
+namespace valhalla {
+namespace baldr {
+
+/**
+ * Binary sidecar index of a tile directory, written at the end of the tile
+ * build by GraphValidator. It records every tile id along with the size and a
+ * checksum of its file, so a graph reader can learn which tiles exist in a
+ * single read instead of statting files or walking the directory tree.
+ */
+class tile_index_t {
+public:
+  struct entry_t {
+    uint64_t size;     // size of the tile file in bytes
+    uint32_t checksum; // crc32 of the front of the tile file
+  };
+
+  /**
+   * Loads the index from the file in the given tile directory.
+   * @param  tile_dir  directory the tiles and the index live in
+   * @return Returns true if a well formed index was loaded
+   */
+  bool from_file(const std::string& tile_dir);
+
+  /**
+   * Scans the tile directory and writes the index beside the tiles. Called
+   * at the end of the tile build so readers pick up a fresh index.
+   * @param  tile_dir  directory the tiles live in
+   * @return Returns true if the index was written
+   */
+  static bool build(const std::string& tile_dir);
+
+  /**
+   * Do we know about this tile? Ids are stored as their tile base.
+   * @param  graphid  the tile id
+   * @return Returns true when the tile was present at build time
+   */
+  bool contains(const GraphId& graphid) const {
+    return tiles_.find(graphid.Tile_Base().value) != tiles_.cend();
+  }
+
+  /**
+   * Returns the indexed tiles, keyed by the tile base id value.
+   */
+  const std::unordered_map<uint64_t, entry_t>& tiles() const {
+    return tiles_;
+  }
+
+protected:
+  std::unordered_map<uint64_t, entry_t> tiles_;
+};
+
+} // namespace baldr
+} // namespace valhalla
+
+#endif // VALHALLA_BALDR_TILEINDEX_H_
@@ -0,0 +1,127 @@
+#ifndef VALHALLA_LOKI_GEOFENCE_INDEX_H_
+#define VALHALLA_LOKI_GEOFENCE_INDEX_H_
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/property_tree/ptree.hpp>
+
+#include <valhalla/baldr/graphreader.h>
+
+namespace valhalla {
+namespace loki {
+
+/**
+ * A precomputed membership index over a fixed set of named areas. Fleet
+ * style deployments ask "is this node/edge inside zone X" against the same
+ * few thousand geofences constantly; rather than re-walking the tile bins
+ * per query this walks them once per zone at startup (via nodes_in_bbox)
+ * and answers membership from sorted in-memory id sets afterwards.
+ *
+ * A node is in a zone when its position is inside the zone's bbox or
+ * polygon. An edge is in a zone when both of its end nodes are.
+ */
+class geofence_index_t {
+public:
+  geofence_index_t() = default;
+
+  /**
+   * Construct the index from configuration. Expects a list of zones, each
+   * with a name and either a bbox [min_lng, min_lat, max_lng, max_lat] or
+   * a polygon [[lng, lat], ...]:
+   *
+   *   "geofences": [{"name": "depot", "bbox": [...]},
+   *                 {"name": "downtown", "polygon": [[...], ...]}]
+   *
+   * @param  pt     the geofences configuration subtree.
+   * @param  reader graph reader object to use for loading tiles.
+   */
+  geofence_index_t(const boost::property_tree::ptree& pt, baldr::GraphReader& reader);
+
+  /**
+   * Add a rectangular zone to the index.
+   *
+   * @param  name   the name of the zone, replaces any previous zone by this name.
+   * @param  bbox   bounding box of the zone.
+   * @param  reader graph reader object to use for loading tiles.
+   */
+  void add_bbox(const std::string& name,
+                const midgard::AABB2<midgard::PointLL>& bbox,
+                baldr::GraphReader& reader);
+
+  /**
+   * Add a polygonal zone to the index.
+   *
+   * @param  name    the name of the zone, replaces any previous zone by this name.
+   * @param  polygon the ring of the zone, implicitly closed.
+   * @param  reader  graph reader object to use for loading tiles.
+   */
+  void add_polygon(const std::string& name,
+                   const std::vector<midgard::PointLL>& polygon,
+                   baldr::GraphReader& reader);
+
+  /**
+   * Does the index know about this zone?
+   *
+   * @param  name the name of the zone.
+   * @return true if the zone was indexed.
+   */
+  bool has_zone(const std::string& name) const;
+
+  /**
+   * Is this node inside the given zone? Answered from memory.
+   *
+   * @param  name the name of the zone.
+   * @param  node the node id.
+   * @return true if the node is inside the zone.
+   */
+  bool node_in_zone(const std::string& name, const baldr::GraphId& node) const;
+
+  /**
+   * Is this edge inside the given zone? Answered from memory.
+   *
+   * @param  name the name of the zone.
+   * @param  edge the directed edge id.
+   * @return true if both end nodes of the edge are inside the zone.
+   */
+  bool edge_in_zone(const std::string& name, const baldr::GraphId& edge) const;
+
+  /**
+   * Get all the nodes inside the given zone.
+   *
+   * @param  name the name of the zone.
+   * @return the sorted node ids inside the zone, empty for unknown zones.
+   */
+  const std::vector<baldr::GraphId>& zone_nodes(const std::string& name) const;
+
+  /**
+   * Get all the edges inside the given zone.
+   *
+   * @param  name the name of the zone.
+   * @return the sorted directed edge ids inside the zone, empty for unknown zones.
+   */
+  const std::vector<baldr::GraphId>& zone_edges(const std::string& name) const;
+
+protected:
+  // the precomputed id sets for one zone, kept sorted so membership is a
+  // binary search with no tile access
+  struct zone_t {
+    std::vector<baldr::GraphId> nodes;
+    std::vector<baldr::GraphId> edges;
+  };
+
+  // finish a zone whose nodes have been found: collect the edges whose end
+  // nodes are both contained and store both sets sorted
+  void finish_zone(const std::string& name,
+                   std::vector<baldr::GraphId>&& nodes,
+                   baldr::GraphReader& reader);
+
+  std::unordered_map<std::string, zone_t> zones_;
+};
+
+} // namespace loki
+} // namespace valhalla
+
+#endif // VALHALLA_LOKI_GEOFENCE_INDEX_H_
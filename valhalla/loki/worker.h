@@ -2,6 +2,9 @@
 #define __VALHALLA_LOKI_SERVICE_H__
 
 #include <cstdint>
+#include <list>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
 #include <boost/property_tree/ptree.hpp>
@@ -53,6 +56,29 @@ protected:
   void parse_costing(valhalla_request_t& request);
   void locations_from_shape(valhalla_request_t& request);
 
+  /**
+   * Correlates locations to the graph, serving repeated waypoints (fleet
+   * depots, popular pickup points) from the correlation cache instead of
+   * re-projecting them through Search(). Falls through to a plain search
+   * when the cache is disabled.
+   * @param  locations  the locations to correlate
+   * @param  request    the request the locations came from, keys the costing filters
+   * @return the correlated result per location, as Search() returns
+   */
+  std::unordered_map<baldr::Location, baldr::PathLocation>
+  cached_search(const std::vector<baldr::Location>& locations, const valhalla_request_t& request);
+
+  /**
+   * Form a cache key for a location's correlation result from its search
+   * relevant attributes and the costing filters. Coordinates are quantized
+   * to ~0.1m so jitter in repeated depot coordinates still hits the cache.
+   * @param  location  the location to key
+   * @param  request   the request the location came from
+   * @return the cache key
+   */
+  std::string correlation_cache_key(const baldr::Location& location,
+                                    const valhalla_request_t& request) const;
+
   void init_locate(valhalla_request_t& request);
   void init_route(valhalla_request_t& request);
   void init_matrix(valhalla_request_t& request);
@@ -84,6 +110,8 @@ protected:
   size_t max_contours;
   size_t max_time;
   size_t max_trace_shape;
+  size_t max_trace_batch_size;
+  size_t max_locate_locations;
   float max_gps_accuracy;
   float max_search_radius;
   unsigned int max_best_paths;
@@ -91,6 +119,23 @@ protected:
   skadi::sample sample;
   size_t max_elevation_shape;
   float min_resample;
+
+  // Optional in-process cache of correlation results keyed by quantized
+  // coordinates, the location's search attributes and the costing filters.
+  // Entries are evicted least recently used and the whole cache is dropped
+  // whenever the tile cache generation changes
+  struct CorrelationCacheEntry {
+    baldr::PathLocation correlated;
+    std::list<std::string>::iterator lru;
+  };
+  size_t correlation_cache_size;
+  std::unordered_map<std::string, CorrelationCacheEntry> correlation_cache;
+  std::list<std::string> correlation_cache_lru;
+  uint64_t correlation_cache_generation;
+
+  // Ring the big intermediate bodies for thor ride in when shared memory
+  // messaging is on, null when it is off
+  std::shared_ptr<shm_message_arena_t> message_arena;
 };
 } // namespace loki
 } // namespace valhalla
@@ -4,6 +4,7 @@
 
 #include <algorithm>
 #include <cmath>
+#include <memory>
 #include <tuple>
 
 #include <boost/property_tree/ptree.hpp>
@@ -63,7 +64,17 @@ public:
                                          float sq_search_radius,
                                          sif::EdgeFilter filter) const override;
 
-  std::unordered_map<baldr::GraphId, grid_t>::size_type size() const {
+  // Query all locations in one batch. The grids covering the locations are
+  // built up front on the calling thread, then the grid range queries run
+  // partitioned across threads against the shared read-only grids. Long
+  // traces with thousands of points see the grid lookups parallelize while
+  // tile bound work stays on the calling thread.
+  std::vector<std::vector<baldr::PathLocation>>
+  QueryBulk(const std::vector<midgard::PointLL>& locations,
+            float sq_search_radius,
+            sif::EdgeFilter filter = nullptr) override;
+
+  size_t size() const {
     return grid_cache_.size();
   }
 
@@ -80,13 +91,25 @@ private:
 
   std::unordered_set<baldr::GraphId> RangeQuery(const midgard::AABB2<midgard::PointLL>& range) const;
 
+  // Process wide cache of built grids shared by every instance, so matchers
+  // running concurrently on separate threads index a hot bin once instead of
+  // each building a private copy. See the definition for the concurrency
+  // scheme
+  struct shared_cache_t;
+  static shared_cache_t& shared_cache();
+
   uint32_t bin_level_;
 
   float cell_width_;
   float cell_height_;
 
-  // Grid cache - cached per "bin" within a graph tile
-  mutable std::unordered_map<int32_t, grid_t> grid_cache_;
+  // Grid cache - cached per "bin" within a graph tile. Holds handles into
+  // the shared cache so lookups on the hot path stay unsynchronized
+  mutable std::unordered_map<int32_t, std::shared_ptr<const grid_t>> grid_cache_;
+
+  // GraphReader::cache_generation() when the handles above were taken,
+  // grids built against tiles that have since been reloaded get tossed
+  mutable uint64_t cache_generation_;
 };
 
 } // namespace meili
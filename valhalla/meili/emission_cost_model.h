@@ -2,6 +2,8 @@
 #define MMP_EMISSION_COST_MODEL_H_
 
 #include <functional>
+#include <vector>
+
 #include <valhalla/meili/state.h>
 
 namespace valhalla {
@@ -32,10 +34,33 @@ public:
     return sq_distance * inv_double_sq_sigma_z_;
   }
 
+  // given a contiguous buffer of *squared* great circle distances, compute the
+  // emission cost of each; a single pass over contiguous floats so the
+  // compiler is free to vectorize the scaling
+  void CalculateEmissionCosts(const float* sq_distances, float* costs, size_t count) const {
+    for (size_t i = 0; i < count; ++i) {
+      costs[i] = sq_distances[i] * inv_double_sq_sigma_z_;
+    }
+  }
+
   float operator()(const StateId& stateid) const {
     return CalculateEmissionCost(container_.state(stateid).candidate().edges.front().distance);
   }
 
+  // price a whole column of states at once: gather their candidates' squared
+  // distances, which candidate search already computed, into a contiguous
+  // buffer and scale them in one batched pass
+  std::vector<float> operator()(const std::vector<StateId>& column) const {
+    std::vector<float> sq_distances;
+    sq_distances.reserve(column.size());
+    for (const auto& stateid : column) {
+      sq_distances.push_back(container_.state(stateid).candidate().edges.front().distance);
+    }
+    std::vector<float> costs(sq_distances.size());
+    CalculateEmissionCosts(sq_distances.data(), costs.data(), sq_distances.size());
+    return costs;
+  }
+
 private:
   baldr::GraphReader& graphreader_;
 
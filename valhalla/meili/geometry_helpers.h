@@ -33,43 +33,58 @@ Project(const coord_t& p,
   float total_length = 0.f;
   float lon_scale = cosf(p.lat() * midgard::kRadPerDeg);
 
-  // for each segment
-  for (decltype(shape.size()) i = 0; i < shape.size() - 1; ++i) {
+  // process the segments in small batches - the projected points are
+  // buffered so their distances can be computed with the vectorizable
+  // batch form of DistanceSquared
+  constexpr decltype(shape.size()) batch_size = 16;
+  coord_t points[batch_size];
+  float distances[batch_size];
+  const auto segments = shape.size() - 1;
+  for (decltype(shape.size()) base = 0; base < segments; base += batch_size) {
+    const auto count = std::min(batch_size, segments - base);
+
     // project a onto b where b is the origin vector representing this segment
     // and a is the origin vector to the point we are projecting, (a.b/b.b)*b
-    const auto& u = shape[i];
-    const auto& v = shape[i + 1];
-    auto bx = v.first - u.first;
-    auto by = v.second - u.second;
-    auto bx2 = bx * lon_scale;
-    auto sq = bx2 * bx2 + by * by;
-    const auto scale =
-        sq > 0 ? (((p.first - u.first) * lon_scale * bx2 + (p.second - u.second) * by) / sq) : 0.f;
-    // projects along the ray before u
-    if (scale <= 0.f) {
-      bx = u.first;
-      by = u.second;
-    } // projects along the ray after v
-    else if (scale >= 1.f) {
-      bx = v.first;
-      by = v.second;
-    } // projects along the ray between u and v
-    else {
-      bx = bx * scale + u.first;
-      by = by * scale + u.second;
-    }
-    // check if this point is better
-    coord_t point(bx, by);
-    const auto distance = approximator.DistanceSquared(point);
-    if (distance < closest_distance) {
-      closest_point = std::move(point);
-      closest_distance = distance;
-      closest_segment = i;
-      closest_partial_length = total_length;
+    for (decltype(shape.size()) j = 0; j < count; ++j) {
+      const auto& u = shape[base + j];
+      const auto& v = shape[base + j + 1];
+      auto bx = v.first - u.first;
+      auto by = v.second - u.second;
+      auto bx2 = bx * lon_scale;
+      auto sq = bx2 * bx2 + by * by;
+      const auto scale =
+          sq > 0 ? (((p.first - u.first) * lon_scale * bx2 + (p.second - u.second) * by) / sq) : 0.f;
+      // projects along the ray before u
+      if (scale <= 0.f) {
+        bx = u.first;
+        by = u.second;
+      } // projects along the ray after v
+      else if (scale >= 1.f) {
+        bx = v.first;
+        by = v.second;
+      } // projects along the ray between u and v
+      else {
+        bx = bx * scale + u.first;
+        by = by * scale + u.second;
+      }
+      points[j] = coord_t(bx, by);
     }
 
-    // total edge length
-    total_length += u.Distance(v);
+    // how close are the projected points
+    approximator.DistanceSquared(points, count, distances);
+
+    // keep whichever is better
+    for (decltype(shape.size()) j = 0; j < count; ++j) {
+      if (distances[j] < closest_distance) {
+        closest_point = points[j];
+        closest_distance = distances[j];
+        closest_segment = base + j;
+        closest_partial_length = total_length;
+      }
+
+      // total edge length
+      total_length += shape[base + j].Distance(shape[base + j + 1]);
+    }
   }
 
   // Offset is a float between 0 and 1 representing the location of
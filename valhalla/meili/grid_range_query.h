@@ -2,6 +2,7 @@
 #ifndef MMP_GRID_RANGE_QUERY_H_
 #define MMP_GRID_RANGE_QUERY_H_
 
+#include <algorithm>
 #include <string>
 #include <tuple>
 #include <unordered_map>
@@ -86,6 +87,22 @@ public:
     AddLineSegment(item, segment.a(), segment.b());
   }
 
+  // Index a whole linestring into the grid in one pass. All segments are
+  // traversed into a single scratch list which is then uniqued, so each
+  // square gets the item at most once no matter how many segments of the
+  // linestring cross it and no per segment allocations are made
+  void AddLineString(const item_t& item, const std::vector<coord_t>& linestring) {
+    squares_.clear();
+    for (size_t i = 1; i < linestring.size(); ++i) {
+      grid_.Traverse(linestring[i - 1], linestring[i], squares_);
+    }
+    std::sort(squares_.begin(), squares_.end());
+    squares_.erase(std::unique(squares_.begin(), squares_.end()), squares_.end());
+    for (const auto& square : squares_) {
+      ItemsInSquare(square.first, square.second).push_back(item);
+    }
+  }
+
   // Query all items that intersects with the range
   std::unordered_set<item_t> Query(const midgard::AABB2<coord_t>& range) const {
     int mincol, minrow, maxcol, maxrow;
@@ -126,6 +143,9 @@ private:
   int ncols_, nrows_;
   GridTraversal<coord_t> grid_;
 
+  // Scratch space for AddLineString, reused across calls
+  std::vector<std::pair<int, int>> squares_;
+
 // Using vector to represent the grid would be faster than using
 // unordered map but it consumes (much) more memeory as well
 #ifdef GRID_USE_VECTOR
@@ -20,13 +20,16 @@ public:
                 int nrows)
       : minx_(minx), miny_(miny), maxx_(minx + square_width * ncols),
         maxy_(miny + square_height * nrows), square_width_(square_width),
-        square_height_(square_height), ncols_(ncols), nrows_(nrows) {
+        square_height_(square_height), square_width_inv_(1.0 / square_width),
+        square_height_inv_(1.0 / square_height), ncols_(ncols), nrows_(nrows) {
   }
 
+  // The square sizes are fixed per grid so mapping a point to its square is
+  // a subtract and a multiply by the precomputed reciprocals
   std::pair<int, int> SquareAtPoint(const coord_t& pt) const {
     const double dx = pt.x() - minx_, dy = pt.y() - miny_;
-    return {static_cast<int>(floor(dx / square_width_)),
-            static_cast<int>(floor(dy / square_height_))};
+    return {static_cast<int>(floor(dx * square_width_inv_)),
+            static_cast<int>(floor(dy * square_height_inv_))};
   }
 
   bool IsValidSquare(int col, int row) const {
@@ -34,6 +37,17 @@ public:
   }
 
   std::vector<std::pair<int, int>> Traverse(const coord_t& origin, const coord_t& dest) const {
+    std::vector<std::pair<int, int>> squares;
+    Traverse(origin, dest, squares);
+    return squares;
+  }
+
+  // Append the squares intersecting the segment to the provided list. Callers
+  // traversing many segments (e.g. every segment of an edge shape) reuse one
+  // list across calls instead of paying for an allocation per segment
+  void Traverse(const coord_t& origin,
+                const coord_t& dest,
+                std::vector<std::pair<int, int>>& squares) const {
     // Division by zero is undefined in C++, here we ensure it to be
     // infinity
     const double height = dest.y() - origin.y(), width = dest.x() - origin.x(),
@@ -46,7 +60,6 @@ public:
     std::tie(dest_col, dest_row) = SquareAtPoint(dest);
 
     // Append intersecting squares
-    std::vector<std::pair<int, int>> squares;
     while (!(col == dest_col && row == dest_row) && IsValidSquare(col, row)) {
       squares.emplace_back(col, row);
 
@@ -91,8 +104,6 @@ public:
     if (IsValidSquare(col, row)) {
       squares.emplace_back(col, row);
     }
-
-    return squares;
   }
 
 private:
@@ -110,7 +121,7 @@ private:
     // Since we have (intersect_x - origin.x()) / (intersect_y - origin.y()) == cotangent
     const double intersect_x = (intersect_y - origin.y()) * cotangent + origin.x();
     // Return the intersecting column
-    return floor((intersect_x - minx_) / square_width_);
+    return floor((intersect_x - minx_) * square_width_inv_);
   }
 
   int IntersectsRow(const coord_t& origin, double tangent, int col) const {
@@ -127,7 +138,7 @@ private:
     // Since we have (intersect_y - origin.y()) / (intersect_x - origin.x()) == tangent
     const double intersect_y = (intersect_x - origin.x()) * tangent + origin.y();
     // Return the intersecting row
-    return floor((intersect_y - miny_) / square_height_);
+    return floor((intersect_y - miny_) * square_height_inv_);
   }
 
   std::pair<int, int>
@@ -178,6 +189,7 @@ private:
 
   double minx_, miny_, maxx_, maxy_;
   double square_width_, square_height_;
+  double square_width_inv_, square_height_inv_;
   int ncols_, nrows_;
 };
 
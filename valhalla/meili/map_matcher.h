@@ -2,6 +2,7 @@
 #ifndef MMP_MAP_MATCHER_H_
 #define MMP_MAP_MATCHER_H_
 
+#include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
@@ -22,6 +23,8 @@
 namespace valhalla {
 namespace meili {
 
+class TracePrefetcher;
+
 // A facade that connects everything
 class MapMatcher final {
 public:
@@ -29,7 +32,8 @@ public:
              baldr::GraphReader& graphreader,
              CandidateQuery& candidatequery,
              const sif::cost_ptr_t* mode_costing,
-             sif::TravelMode travelmode);
+             sif::TravelMode travelmode,
+             TracePrefetcher* prefetcher = nullptr);
 
   ~MapMatcher();
 
@@ -70,6 +74,27 @@ public:
   std::vector<MatchResults> OfflineMatch(const std::vector<Measurement>& measurements,
                                          uint32_t k = 1);
 
+  /**
+   * Match measurements as they arrive instead of all at once. Keeps the
+   * viterbi search alive between calls and returns the results that became
+   * confirmed, i.e. those at least online_confirm_window matched measurements
+   * older than the newest one, whose winning state is unlikely to change as
+   * the trace grows. Unlike OfflineMatch the results near the window boundary
+   * are not guaranteed to be globally optimal and only the single best path
+   * is produced. The first call after construction, Clear or
+   * OnlineMatchFinish starts a new trace
+   * @param measurement  the newest point of the trace
+   * @return the match results confirmed by this point, possibly none
+   */
+  std::vector<MatchResult> OnlineMatch(const Measurement& measurement);
+
+  /**
+   * Finish a trace started with OnlineMatch: emit the results that are still
+   * unconfirmed, in order, and reset so a new trace can begin
+   * @return the remaining match results
+   */
+  std::vector<MatchResult> OnlineMatchFinish();
+
   /**
    * Set a callback that will throw when the map-matching should be aborted
    * @param interrupt_callback  the function to periodically call to see if we should abort
@@ -84,6 +109,11 @@ private:
 
   StateId::Time AppendMeasurement(const Measurement& measurement, const float sq_max_search_radius);
 
+  // Fix the state of the oldest unconfirmed measurement to the one on the
+  // best path ending at the newest matched time and append its match result
+  // (preceded by any measurements interpolated before it) to results
+  void ConfirmOnlineResult(const StateId::Time latest, std::vector<MatchResult>& results);
+
   void RemoveRedundancies(const std::vector<StateId>& result);
   // void RemoveRedundancies(const MatchResults& path, std::vector<StateId>& result);
 
@@ -93,6 +123,10 @@ private:
 
   CandidateQuery& candidatequery_;
 
+  // Walks offline traces ahead of the matcher warming tiles and candidate
+  // grids, null when the lookahead is not configured
+  TracePrefetcher* prefetcher_;
+
   const sif::cost_ptr_t* mode_costing_;
 
   sif::TravelMode travelmode_;
@@ -109,6 +143,19 @@ private:
   EmissionCostModel emission_cost_model_;
 
   TransitionCostModel transition_cost_model_;
+
+  // Whether an OnlineMatch trace is in progress
+  bool online_active_;
+
+  // The time of the oldest matched measurement not yet confirmed
+  StateId::Time online_confirmed_;
+
+  // The winning state of the last confirmed measurement
+  StateId online_last_stateid_;
+
+  // Measurements close enough to the last matched one to be interpolated,
+  // keyed by the matched time they follow
+  std::unordered_map<StateId::Time, std::vector<Measurement>> online_interpolated_;
 };
 
 bool MergeRoute(std::vector<EdgeSegment>& route, const State& source, const State& target);
@@ -4,6 +4,7 @@
 #include <cstdint>
 
 #include <string>
+#include <unordered_set>
 
 #include <boost/property_tree/ptree.hpp>
 #include <rapidjson/rapidjson.h>
@@ -54,6 +55,12 @@ private:
 
   boost::property_tree::ptree config_;
 
+  // The default matcher config and the set of options requests may override,
+  // pulled out of the config tree once so per request merges are plain copies
+  boost::property_tree::ptree default_config_;
+
+  std::unordered_set<std::string> customizable_;
+
   std::shared_ptr<baldr::GraphReader> graphreader_;
 
   valhalla::sif::cost_ptr_t mode_costing_[kModeCostingCount];
@@ -62,6 +69,10 @@ private:
 
   std::shared_ptr<CandidateGridQuery> candidatequery_;
 
+  // Walks long traces ahead of the matchers this factory creates, warming
+  // tiles and candidate grids; null unless meili.lookahead_window is set
+  std::unique_ptr<TracePrefetcher> prefetcher_;
+
   float max_grid_cache_size_;
 };
 
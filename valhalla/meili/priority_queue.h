@@ -37,6 +37,12 @@ public:
     return heap_.top();
   }
 
+  // Get the currently queued label with this id, or nullptr if it is not queued
+  const T* find(const typename T::id_type& id) const {
+    const auto it = handlers_.find(id);
+    return it == handlers_.end() ? nullptr : &(*(it->second));
+  }
+
   bool empty() const {
     return heap_.empty();
   }
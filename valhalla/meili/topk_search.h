@@ -47,12 +47,17 @@ public:
   EnlargedViterbiSearch(IViterbiSearch& vs,
                         std::function<StateId(const StateId::Time&)> claim_stateid,
                         std::unordered_map<StateId, StateId>& initial_origins,
-                        std::unordered_set<StateId>& removed_origins)
+                        std::unordered_set<StateId>& removed_origins,
+                        std::unordered_map<StateId, float>* shared_emission_costs = nullptr,
+                        std::unordered_map<std::pair<StateId, StateId>, float>*
+                            shared_transition_costs = nullptr)
       : vs_(vs), claim_stateid_(claim_stateid),
         original_emission_cost_model_(vs.emission_cost_model()),
         original_transition_cost_model_(vs.transition_cost_model()), origin_(), clone_(),
         clone_start_time_(kInvalidTime), clone_end_time_(kInvalidTime),
-        initial_origins_(initial_origins), removed_origins_(removed_origins) {
+        initial_origins_(initial_origins), removed_origins_(removed_origins),
+        shared_emission_costs_(shared_emission_costs),
+        shared_transition_costs_(shared_transition_costs) {
     vs_.set_emission_cost_model(EnlargedEmissionCostModel(*this));
     vs_.set_transition_cost_model(EnlargedTransitionCostModel(*this));
   }
@@ -65,6 +70,35 @@ public:
     return original_transition_cost_model_;
   }
 
+  // Calls into the models this search wrapped, memoized into the session
+  // wide caches when this is the first enlargement (where the wrapped
+  // models are the real ones). Later kth best searches bottom out here, so
+  // the costs computed while extracting one path are reused by the next
+  // instead of being recomputed pair by pair
+  float OriginalEmissionCost(const StateId& stateid) const {
+    if (shared_emission_costs_ == nullptr) {
+      return original_emission_cost_model_(stateid);
+    }
+    auto it = shared_emission_costs_->find(stateid);
+    if (it == shared_emission_costs_->end()) {
+      it = shared_emission_costs_->emplace(stateid, original_emission_cost_model_(stateid)).first;
+    }
+    return it->second;
+  }
+
+  float OriginalTransitionCost(const StateId& lhs, const StateId& rhs) const {
+    if (shared_transition_costs_ == nullptr) {
+      return original_transition_cost_model_(lhs, rhs);
+    }
+    auto couple = std::make_pair(lhs, rhs);
+    auto it = shared_transition_costs_->find(couple);
+    if (it == shared_transition_costs_->end()) {
+      it = shared_transition_costs_->emplace(couple, original_transition_cost_model_(lhs, rhs))
+               .first;
+    }
+    return it->second;
+  }
+
   StateId GetOrigin(const StateId& stateid) const {
     const auto it = origin_.find(stateid);
     if (it == origin_.end()) {
@@ -121,6 +155,12 @@ private:
   // origins that were removed
   std::unordered_set<StateId>& removed_origins_;
 
+  // session wide memos of the wrapped model calls, owned by TopKSearch and
+  // only set on the first enlargement; null on later ones whose wrapped
+  // models are themselves enlargements that already consult these
+  std::unordered_map<StateId, float>* shared_emission_costs_;
+  std::unordered_map<std::pair<StateId, StateId>, float>* shared_transition_costs_;
+
   StateId::Time clone_start_time_, clone_end_time_;
 };
 
@@ -134,6 +174,8 @@ public:
     evss_.clear();
     initial_origins_.clear();
     removed_origins_.clear();
+    shared_emission_costs_.clear();
+    shared_transition_costs_.clear();
   }
 
   // remove path from first state to last state
@@ -161,6 +203,11 @@ private:
   std::unordered_map<StateId, StateId> initial_origins_;
 
   std::unordered_set<StateId> removed_origins_;
+
+  // memos of the real cost model calls shared by all the enlarged searches
+  // of this session - the kth best search reuses what the first computed
+  std::unordered_map<StateId, float> shared_emission_costs_;
+  std::unordered_map<std::pair<StateId, StateId>, float> shared_transition_costs_;
 };
 
 } // namespace meili
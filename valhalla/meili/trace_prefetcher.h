@@ -0,0 +1,78 @@
+// -*- mode: c++ -*-
+#ifndef MMP_TRACE_PREFETCHER_H_
+#define MMP_TRACE_PREFETCHER_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <boost/property_tree/ptree.hpp>
+
+#include <valhalla/baldr/graphreader.h>
+#include <valhalla/meili/candidate_search.h>
+#include <valhalla/meili/measurement.h>
+
+namespace valhalla {
+namespace meili {
+
+// Walks the measurements of a trace a configured window ahead of the matcher
+// and pulls the tiles and candidate grids they are about to need, so the tile
+// io overlaps the matcher's candidate search and dynamic programming instead
+// of stalling it. A trace progresses predictably along roads which makes its
+// upcoming coordinates a reliable prefetch hint. The lookahead runs on its
+// own thread with its own reader, so it is safe no matter what tile cache
+// the matcher's reader uses: the bytes it faults in warm the os page cache
+// (and any process wide tile cache) for the matcher, and the grids it builds
+// publish to the process wide shared grid cache where the matcher's own
+// query finds them. The whole thing is advisory - errors are swallowed and
+// missing the window only loses the overlap. Enabled with a positive
+// meili.lookahead_window
+class TracePrefetcher final {
+public:
+  // builds the lookahead reader and grid query from the full config tree and
+  // starts the thread
+  TracePrefetcher(const boost::property_tree::ptree& root);
+
+  // stops the thread
+  ~TracePrefetcher();
+
+  // begin walking a trace; the measurements must outlive the paired Finish
+  void Start(const std::vector<Measurement>& measurements);
+
+  // the matcher consumed one more measurement, the walk may move up
+  void Advance();
+
+  // abandon whatever is left of the trace and wait until the walk no longer
+  // touches the measurements
+  void Finish();
+
+private:
+  void Work();
+  void Warm(const Measurement& measurement);
+
+  // how many measurements past the matcher the walk may reach
+  uint32_t window_;
+  // tiles are pulled on the level the candidate search reads
+  uint8_t local_level_;
+  // how many grids the lookahead keeps before dropping its local handles
+  float max_grid_cache_size_;
+  baldr::GraphReader reader_;
+  CandidateGridQuery grid_query_;
+
+  std::mutex mutex_;
+  std::condition_variable signal_;
+  const std::vector<Measurement>* measurements_;
+  std::atomic<uint32_t> progress_;
+  std::atomic<bool> active_;
+  bool abandon_;
+  bool stop_;
+  std::thread thread_;
+};
+
+} // namespace meili
+} // namespace valhalla
+
+#endif // MMP_TRACE_PREFETCHER_H_
@@ -25,7 +25,8 @@ public:
                       float breakage_distance,
                       float max_route_distance_factor,
                       float max_route_time_factor,
-                      float turn_penalty_factor);
+                      float turn_penalty_factor,
+                      bool cache_routes = false);
 
   TransitionCostModel(baldr::GraphReader& graphreader,
                       const IViterbiSearch& vs,
@@ -50,9 +51,51 @@ public:
 
   float operator()(const StateId& lhs, const StateId& rhs) const;
 
+  // route from the left candidate to the right candidate's column if that
+  // has not happened yet, regardless of memoization; route reconstruction
+  // reads the labels this leaves behind on the state
+  void EnsureRoute(const StateId& lhs, const StateId& rhs) const;
+
+  // an admissible lower bound of the transition cost between two candidates
+  // that avoids routing between them: the route can be no shorter than the
+  // great circle distance between the candidates, so the cost can be no less
+  // than the distance it exceeds the measurement distance by, scaled as above
+  float LowerBound(const StateId& lhs, const StateId& rhs) const;
+
 private:
   void UpdateRoute(const StateId& lhs, const StateId& rhs) const;
 
+  // The distance the routing between two candidates is capped at, a
+  // function of how far apart their measurements are
+  float MaxRouteDistance(const StateId& lhs, const StateId& rhs) const;
+
+  // A memoized route between two quantized candidates. Vehicles idling or
+  // crawling in traffic put consecutive trace points on the same edges at
+  // nearly the same offsets, so instead of re-running label propagation we
+  // remember what the network found last time
+  struct route_memo_t {
+    bool found;               // was there a path at all
+    float turn_cost;          // accumulated turn cost along the path
+    float distance;           // network distance along the path
+    float secs;               // network time along the path
+    float max_route_distance; // the distance cap the path was (not) found under
+    float max_route_time;     // the time cap the path was (not) found under
+  };
+
+  // The time the routing between two candidates is capped at, a function
+  // of how far apart their measurements are in time, negative if unbounded
+  float MaxRouteTime(const StateId& lhs, const StateId& rhs) const;
+
+  // Key a state by its candidate edges and offsets quantized to buckets
+  uint64_t CandidateKey(const StateId& stateid) const;
+
+  // The great circle and clock distances between two measurements are the
+  // same for every candidate pair between their columns, so remember the
+  // last pair of times and compute the haversine once per column pair
+  // instead of once per candidate pair
+  const std::pair<float, float>& MeasurementDistances(const StateId::Time lhs,
+                                                      const StateId::Time rhs) const;
+
   float ClockDistance(const StateId::Time& lhs, const StateId::Time& rhs) const {
     double clk_dist = -1.0;
 
@@ -88,6 +131,18 @@ private:
 
   float turn_penalty_factor_;
 
+  // Whether to memoize routes between quantized candidate pairs
+  bool cache_routes_;
+
+  // The memoized routes, bounded by clearing when it grows too large
+  mutable std::unordered_map<uint64_t, route_memo_t> route_memo_;
+
+  // The pair of measurement times whose distances are cached and their
+  // great circle and clock distances
+  mutable StateId::Time cached_lhs_time_ = kInvalidTime;
+  mutable StateId::Time cached_rhs_time_ = kInvalidTime;
+  mutable std::pair<float, float> cached_distances_;
+
   // Cost for each degree in [0, 180]
   float turn_cost_table_[181];
 };
@@ -146,6 +146,21 @@ inline float DefaultTransitionCostModel(const StateId&, const StateId&) {
   return 1;
 }
 
+// Prices a whole column of states in one batched pass. Optional: when
+// absent the per state emission cost model is used, when present it must
+// return exactly what the per state model would for each state
+using IBatchEmissionCostModel = std::function<std::vector<float>(const std::vector<StateId>&)>;
+
+// An admissible lower bound of the transition cost between two states,
+// i.e. it must never exceed the cost the transition cost model would
+// return. Used to skip computing expensive exact transition costs that
+// cannot improve on a state's currently queued cost
+using ITransitionCostLowerBoundModel = std::function<float(const StateId& lhs, const StateId& rhs)>;
+
+inline float DefaultTransitionCostLowerBoundModel(const StateId&, const StateId&) {
+  return 0;
+}
+
 class IViterbiSearch {
 public:
   using stateid_iterator = StateIdIterator;
@@ -153,6 +168,7 @@ public:
   IViterbiSearch(const IEmissionCostModel& emission_cost_model,
                  const ITransitionCostModel& transition_cost_model)
       : emission_cost_model_(emission_cost_model), transition_cost_model_(transition_cost_model),
+        transition_cost_lower_bound_model_(DefaultTransitionCostLowerBoundModel),
         path_end_(stateid_iterator(*this)) {
   }
 
@@ -203,6 +219,17 @@ public:
 
   void set_emission_cost_model(const IEmissionCostModel cost_model) {
     emission_cost_model_ = cost_model;
+    // a batch model must agree with the per state model it accompanies, so
+    // replacing the per state model drops the batch one
+    batch_emission_cost_model_ = IBatchEmissionCostModel();
+  }
+
+  const IBatchEmissionCostModel& batch_emission_cost_model() const {
+    return batch_emission_cost_model_;
+  }
+
+  void set_batch_emission_cost_model(const IBatchEmissionCostModel cost_model) {
+    batch_emission_cost_model_ = cost_model;
   }
 
   const ITransitionCostModel& transition_cost_model() const {
@@ -213,6 +240,14 @@ public:
     transition_cost_model_ = cost_model;
   }
 
+  const ITransitionCostLowerBoundModel& transition_cost_lower_bound_model() const {
+    return transition_cost_lower_bound_model_;
+  }
+
+  void set_transition_cost_lower_bound_model(const ITransitionCostLowerBoundModel cost_model) {
+    transition_cost_lower_bound_model_ = cost_model;
+  }
+
   virtual StateId Predecessor(const StateId& stateid) const = 0;
 
   virtual double AccumulatedCost(const StateId& stateid) const = 0;
@@ -228,6 +263,12 @@ protected:
     return emission_cost_model_(stateid);
   }
 
+  // Calculate a lower bound of the transition cost from left state to
+  // right state without the expense of the exact cost
+  virtual float TransitionCostLowerBound(const StateId& lhs, const StateId& rhs) const {
+    return transition_cost_lower_bound_model_(lhs, rhs);
+  }
+
   // Calculate the a state's costsofar based on its predecessor's
   // costsofar, transition cost from predecessor to this state,
   // and emission cost of this state
@@ -240,8 +281,12 @@ private:
 
   IEmissionCostModel emission_cost_model_;
 
+  IBatchEmissionCostModel batch_emission_cost_model_;
+
   ITransitionCostModel transition_cost_model_;
 
+  ITransitionCostLowerBoundModel transition_cost_lower_bound_model_;
+
   const stateid_iterator path_end_;
 };
 
@@ -301,7 +346,8 @@ class ViterbiSearch : public IViterbiSearch {
 public:
   ViterbiSearch(const IEmissionCostModel& emission_cost_model,
                 const ITransitionCostModel& transition_cost_model)
-      : IViterbiSearch(emission_cost_model, transition_cost_model), earliest_time_(0) {
+      : IViterbiSearch(emission_cost_model, transition_cost_model), earliest_time_(0),
+        beam_width_(0) {
   }
 
   ViterbiSearch() : ViterbiSearch(DefaultEmissionCostModel, DefaultTransitionCostModel) {
@@ -337,6 +383,18 @@ public:
     return cost < 0.f;
   }
 
+  uint32_t beam_width() const {
+    return beam_width_;
+  }
+
+  // Limit each column to its best beam_width states by accumulated cost.
+  // Once a column has settled that many states the rest of the column is
+  // dropped, bounding the work per step on dense candidate sets at the
+  // risk of missing the optimal path. 0 (the default) disables the beam
+  void set_beam_width(uint32_t beam_width) {
+    beam_width_ = beam_width;
+  }
+
   using IViterbiSearch::AccumulatedCost;
 
   virtual double AccumulatedCost(const StateId& stateid) const override;
@@ -357,9 +415,23 @@ private:
 
   void AddSuccessorsToQueue(const StateId& stateid);
 
+  // Memoized emission cost of a state. The first state queried in a column
+  // prices the whole column in one batched pass if a batch model is set,
+  // the successor loop would otherwise reprice it once per settled
+  // predecessor
+  float CachedEmissionCost(const StateId& stateid);
+
   StateId::Time IterativeSearch(StateId::Time target, bool request_new_start);
 
   StateId::Time earliest_time_;
+
+  uint32_t beam_width_;
+
+  // How many states have been settled per column, used to enforce the beam
+  std::vector<uint32_t> scanned_counts_;
+
+  // Emission costs memoized per state for the duration of a search
+  std::unordered_map<StateId, float> emission_costs_;
 };
 
 } // namespace meili
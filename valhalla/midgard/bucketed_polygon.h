@@ -0,0 +1,64 @@
+#ifndef VALHALLA_MIDGARD_BUCKETED_POLYGON_H_
+#define VALHALLA_MIDGARD_BUCKETED_POLYGON_H_
+
+#include <cstdint>
+#include <vector>
+
+#include <valhalla/midgard/aabb2.h>
+#include <valhalla/midgard/pointll.h>
+
+namespace valhalla {
+namespace midgard {
+
+/**
+ * Point in ring test over edges bucketed by latitude band. The ring's edges
+ * are sorted into horizontal bands at construction, so a containment test
+ * only counts ray crossings against the handful of edges overlapping the
+ * point's band rather than the whole ring, and the crossing count itself is
+ * a branch free loop over struct-of-arrays edge data that compilers
+ * vectorize. Worth the setup cost when one ring is tested against many
+ * points (admin assignment, avoid polygons, geofences); for one-off tests
+ * use PointLL::WithinPolygon. Uses the even-odd rule, so the ring must not
+ * self intersect.
+ */
+class BucketedPolygon {
+public:
+  /**
+   * Constructor. Buckets the ring's edges by latitude band. The ring may
+   * be open or repeat its first point at the end.
+   * @param  ring  the ring vertices in either winding order
+   */
+  explicit BucketedPolygon(const std::vector<PointLL>& ring);
+
+  /**
+   * Tests whether the point is inside the ring. Points exactly on the
+   * boundary may fall on either side.
+   * @param  ll  the point to test
+   * @return true if the point is inside
+   */
+  bool Contains(const PointLL& ll) const;
+
+  /**
+   * Get the bounding box of the ring.
+   * @return the bounding box
+   */
+  const AABB2<PointLL>& bbox() const {
+    return bbox_;
+  }
+
+private:
+  // The edges overlapping one latitude band, struct of arrays so the
+  // crossing loop in Contains vectorizes
+  struct band_t {
+    std::vector<float> x1, y1, x2, y2;
+  };
+
+  AABB2<PointLL> bbox_;
+  float inv_band_height_;
+  std::vector<band_t> bands_;
+};
+
+} // namespace midgard
+} // namespace valhalla
+
+#endif // VALHALLA_MIDGARD_BUCKETED_POLYGON_H_
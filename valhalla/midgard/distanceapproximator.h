@@ -2,6 +2,7 @@
 #ifndef VALHALLA_MIDGARD_DISTANCEAPPROXIMATOR_H_
 #define VALHALLA_MIDGARD_DISTANCEAPPROXIMATOR_H_
 
+#include <cstddef>
 #include <math.h>
 
 #include <valhalla/midgard/constants.h>
@@ -79,6 +80,24 @@ public:
            sqr((ll.lng() - centerlng_) * m_per_lng_degree_);
   }
 
+  /**
+   * Approximates the squared arc distance from the test point to each of a
+   * batch of positions. The loop body is branch free over contiguous input
+   * so the compiler can vectorize it - prefer this over per-point calls
+   * when the distances to many candidate positions are needed at once.
+   * @param   lls           Array of lat,lng positions (degrees).
+   * @param   count         Number of positions.
+   * @param   sq_distances  Output squared distances in meters, one per
+   *                        position.
+   */
+  void DistanceSquared(const PointLL* lls, const std::size_t count, float* sq_distances) const {
+    for (std::size_t i = 0; i < count; ++i) {
+      const float latm = (lls[i].lat() - centerlat_) * kMetersPerDegreeLat;
+      const float lngm = (lls[i].lng() - centerlng_) * m_per_lng_degree_;
+      sq_distances[i] = latm * latm + lngm * lngm;
+    }
+  }
+
   /**
    * Approximates arc distance between 2 lat,lng positions using meters per
    * latitude and longitude degree.  Uses the mid latitude of the 2 positions
@@ -65,6 +65,73 @@ template <class container_t> container_t decode7(const std::string& encoded) {
   return decode7<container_t>(encoded.c_str(), encoded.length());
 }
 
+/**
+ * Polyline encoder that takes its points one at a time, for callers that
+ * produce their shape in a streaming fashion and don't want to materialize
+ * a container first. Pushing the same points yields exactly what encode()
+ * would have returned for them
+ */
+class Shape5Encoder {
+public:
+  /**
+   * Constructor
+   * @param expected_points  reserve output room for about this many points
+   */
+  explicit Shape5Encoder(size_t expected_points = 0) : last_lon_(0), last_lat_(0) {
+    // unless the shape is very course you should probably only need about 3 bytes
+    // per coord, which is 6 bytes with 2 coords, so we overshoot to 8 just in case
+    output_.reserve(expected_points * 8);
+  }
+
+  /**
+   * Append a single point to the encoded shape
+   * @param p  the point, first is longitude and second is latitude
+   */
+  template <class point_t> void push(const point_t& p) {
+    // stage the point in a stack buffer and append it in one go -
+    // string::push_back pays a capacity check on every byte. An int32
+    // coordinate delta takes at most 7 of the 5 bit chunks
+    char buffer[14];
+    char* out = buffer;
+
+    // handy lambda to turn an integer into an encoded string
+    auto serialize = [&out](int number) {
+      // move the bits left 1 position and flip all the bits if it was a negative number
+      number = number < 0 ? ~(number << 1) : (number << 1);
+      // write 5 bit chunks of the number
+      while (number >= 0x20) {
+        *out++ = static_cast<char>((0x20 | (number & 0x1f)) + 63);
+        number >>= 5;
+      }
+      // write the last chunk
+      *out++ = static_cast<char>(number + 63);
+    };
+
+    // shift the decimal point 5 places to the right and truncate
+    int lon = static_cast<int>(floor(static_cast<double>(p.first) * 1e6));
+    int lat = static_cast<int>(floor(static_cast<double>(p.second) * 1e6));
+    // encode each coordinate as an offset from the last one, lat first for some reason
+    serialize(lat - last_lat_);
+    serialize(lon - last_lon_);
+    output_.append(buffer, out - buffer);
+    // remember the last one we encountered
+    last_lon_ = lon;
+    last_lat_ = lat;
+  }
+
+  /**
+   * @return the encoded shape, leaving the encoder empty
+   */
+  std::string str() {
+    return std::move(output_);
+  }
+
+private:
+  // the output and the offset encoding state
+  std::string output_;
+  int last_lon_, last_lat_;
+};
+
 /**
  * Polyline encode a container of points into a string suitable for web use
  * Note: newer versions of this algorithm allow one to specify a zoom level
@@ -74,42 +141,11 @@ template <class container_t> container_t decode7(const std::string& encoded) {
  * @return string   the encoded container of points
  */
 template <class container_t> std::string encode(const container_t& points) {
-  // a place to keep the output
-  std::string output;
-  // unless the shape is very course you should probably only need about 3 bytes
-  // per coord, which is 6 bytes with 2 coords, so we overshoot to 8 just in case
-  output.reserve(points.size() * 8);
-
-  // handy lambda to turn an integer into an encoded string
-  auto serialize = [&output](int number) {
-    // move the bits left 1 position and flip all the bits if it was a negative number
-    number = number < 0 ? ~(number << 1) : (number << 1);
-    // write 5 bit chunks of the number
-    while (number >= 0x20) {
-      int nextValue = (0x20 | (number & 0x1f)) + 63;
-      output.push_back(static_cast<char>(nextValue));
-      number >>= 5;
-    }
-    // write the last chunk
-    number += 63;
-    output.push_back(static_cast<char>(number));
-  };
-
-  // this is an offset encoding so we remember the last point we saw
-  int last_lon = 0, last_lat = 0;
-  // for each point
+  Shape5Encoder encoder(points.size());
   for (const auto& p : points) {
-    // shift the decimal point 5 places to the right and truncate
-    int lon = static_cast<int>(floor(static_cast<double>(p.first) * 1e6));
-    int lat = static_cast<int>(floor(static_cast<double>(p.second) * 1e6));
-    // encode each coordinate, lat first for some reason
-    serialize(lat - last_lat);
-    serialize(lon - last_lon);
-    // remember the last one we encountered
-    last_lon = lon;
-    last_lat = lat;
+    encoder.push(p);
   }
-  return output;
+  return encoder.str();
 }
 
 /**
@@ -125,20 +161,25 @@ template <class container_t> std::string encode7(const container_t& points) {
   // per coord, which is 6 bytes with 2 coords, so we overshoot to 8 just in case
   output.reserve(points.size() * 8);
 
+  // stage each point in a stack buffer and append it in one go -
+  // string::push_back pays a capacity check on every byte. An int32
+  // coordinate delta takes at most 5 of the 7 bit chunks
+  char buffer[10];
+  char* out;
+
   // handy lambda to turn an integer into an encoded string
-  auto serialize = [&output](int number) {
+  auto serialize = [&out](int number) {
     // get the sign bit down on the least significant end to
     // make the most significant bits mostly zeros
     number = number < 0 ? ~(number << 1) : number << 1;
     // we take 7 bits of this at a time
     while (number > 0x7f) {
       // marking the most significant bit means there are more pieces to come
-      int nextValue = (0x80 | (number & 0x7f));
-      output.push_back(static_cast<char>(nextValue));
+      *out++ = static_cast<char>(0x80 | (number & 0x7f));
       number >>= 7;
     }
     // write the last chunk
-    output.push_back(static_cast<char>(number & 0x7f));
+    *out++ = static_cast<char>(number & 0x7f);
   };
 
   // this is an offset encoding so we remember the last point we saw
@@ -149,8 +190,10 @@ template <class container_t> std::string encode7(const container_t& points) {
     int lon = static_cast<int>(floor(static_cast<double>(p.first) * 1e6));
     int lat = static_cast<int>(floor(static_cast<double>(p.second) * 1e6));
     // encode each coordinate, lat first for some reason
+    out = buffer;
     serialize(lat - last_lat);
     serialize(lon - last_lon);
+    output.append(buffer, out - buffer);
     // remember the last one we encountered
     last_lon = lon;
     last_lat = lat;
@@ -1,6 +1,7 @@
 #ifndef VALHALLA_MIDGARD_GRIDDEDDATA_H_
 #define VALHALLA_MIDGARD_GRIDDEDDATA_H_
 
+#include <algorithm>
 #include <limits>
 #include <list>
 #include <map>
@@ -14,6 +15,11 @@ namespace midgard {
 // compute an optimal generalization factor when creating contours.
 constexpr float kOptimalGeneralization = std::numeric_limits<float>::max();
 
+// Cells are allocated in square blocks of this many cells on a side the first
+// time one of them is written to, so a large sparse bounding box does not cost
+// memory for the areas an expansion never reached (64x64 floats is 16KB)
+constexpr int32_t kGridBlockDim = 64;
+
 /**
  * Class to store data in a gridded/tiled data structure. Contains methods
  * to mark each tile with data using a compare operator.
@@ -37,8 +43,9 @@ public:
    */
   bool Set(const coord_t& pt, const float value) {
     auto cell_id = this->TileId(pt);
-    if (cell_id >= 0 && cell_id < data_.size()) {
-      data_[cell_id] = value;
+    if (cell_id >= 0 && cell_id < this->nrows_ * this->ncolumns_) {
+      SetCell(cell_id, value);
+      MarkDirty(cell_id);
       return true;
     }
     return false;
@@ -51,8 +58,9 @@ public:
    * @param  value  Value to set at the tile/grid location.
    */
   void SetIfLessThan(const int tile_id, const float value) {
-    if (tile_id >= 0 && tile_id < data_.size() && value < data_[tile_id]) {
-      data_[tile_id] = value;
+    if (tile_id >= 0 && tile_id < this->nrows_ * this->ncolumns_ && value < Get(tile_id)) {
+      SetCell(tile_id, value);
+      MarkDirty(tile_id);
     }
   }
 
@@ -65,17 +73,21 @@ public:
    */
   void SetIfLessThan(const coord_t& pt, const float value) {
     int32_t cell_id = this->TileId(pt);
-    if (cell_id >= 0 && cell_id < data_.size() && value < data_[cell_id]) {
-      data_[cell_id] = value;
+    if (cell_id >= 0 && cell_id < this->nrows_ * this->ncolumns_ && value < Get(cell_id)) {
+      SetCell(cell_id, value);
+      MarkDirty(cell_id);
     }
   }
 
   /**
-   * Get the array of data.
-   * @return  Returns the data associated with the tiles.
+   * Get the value at a specified tile Id. Cells in blocks that were never
+   * written to still hold the initial value.
+   * @param  tile_id  Tile Id to get the value for.
+   * @return  Returns the value at the tile/grid location.
    */
-  const std::vector<float>& data() const {
-    return data_;
+  float Get(const int32_t tile_id) const {
+    const auto& block = blocks_[BlockId(tile_id)];
+    return block.empty() ? max_value_ : block[BlockOffset(tile_id)];
   }
 
   using contour_t = std::list<coord_t>;
@@ -106,8 +118,75 @@ public:
                               const float generalize = 200.f) const;
 
 protected:
-  float max_value_;         // Maximum value stored in the tile
-  std::vector<float> data_; // Data value within each tile
+  float max_value_;    // Maximum value stored in the tile
+  int32_t nblockcols_; // Number of blocks along a row of the grid
+
+  // Cell values in kGridBlockDim x kGridBlockDim blocks, each one empty until
+  // a cell in it is first written to
+  std::vector<std::vector<float>> blocks_;
+
+  // Smallest value written into each block, the initial value if none was.
+  // Contour generation skips blocks whose minimum is above every interval
+  std::vector<float> block_min_;
+
+  /**
+   * Which block a cell belongs to.
+   * @param  tile_id  Id of the cell.
+   * @return Returns the index of the block into blocks_.
+   */
+  int32_t BlockId(const int32_t tile_id) const {
+    int32_t row = tile_id / this->ncolumns_;
+    int32_t col = tile_id % this->ncolumns_;
+    return (row / kGridBlockDim) * nblockcols_ + (col / kGridBlockDim);
+  }
+
+  /**
+   * Where a cell lives within its block.
+   * @param  tile_id  Id of the cell.
+   * @return Returns the index of the cell into its block.
+   */
+  int32_t BlockOffset(const int32_t tile_id) const {
+    int32_t row = tile_id / this->ncolumns_;
+    int32_t col = tile_id % this->ncolumns_;
+    return (row % kGridBlockDim) * kGridBlockDim + (col % kGridBlockDim);
+  }
+
+  /**
+   * Write a value to a cell, allocating the cell's block on first touch and
+   * keeping the block's minimum up to date.
+   * @param  tile_id  Id of the cell to write.
+   * @param  value    Value to write.
+   */
+  void SetCell(const int32_t tile_id, const float value) {
+    auto block_id = BlockId(tile_id);
+    auto& block = blocks_[block_id];
+    if (block.empty()) {
+      block.resize(kGridBlockDim * kGridBlockDim, max_value_);
+    }
+    block[BlockOffset(tile_id)] = value;
+    block_min_[block_id] = std::min(block_min_[block_id], value);
+  }
+
+  // Bounding rows and columns of the cells actually written to. Contour
+  // generation scans only this region; everything outside still holds the
+  // initial value and cannot contribute a contour.
+  int32_t dirty_min_row_;
+  int32_t dirty_max_row_;
+  int32_t dirty_min_col_;
+  int32_t dirty_max_col_;
+
+  /**
+   * Grow the dirty region to include a cell that was written to.
+   * @param  tile_id  Id of the cell that changed.
+   */
+  void MarkDirty(const int32_t tile_id) {
+    int32_t row = tile_id / this->ncolumns_;
+    int32_t col = tile_id % this->ncolumns_;
+    dirty_min_row_ = std::min(dirty_min_row_, row);
+    dirty_max_row_ = std::max(dirty_max_row_, row);
+    dirty_min_col_ = std::min(dirty_min_col_, col);
+    dirty_max_col_ = std::max(dirty_max_col_, col);
+  }
 };
 
 } // namespace midgard
@@ -0,0 +1,89 @@
+#ifndef VALHALLA_MIDGARD_RING_BUFFER_H_
+#define VALHALLA_MIDGARD_RING_BUFFER_H_
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+namespace valhalla {
+namespace midgard {
+
+/**
+ * Fixed capacity single producer single consumer ring buffer. The producer
+ * and the consumer each own one end of the ring, so the hand off needs no
+ * locks: the producer publishes a slot by advancing the tail with a release
+ * store and the consumer retires one by advancing the head. Useful as a
+ * stage boundary between pipeline threads (e.g. pbf decoding feeding graph
+ * construction) where a mutex around every element would serialize the
+ * stages. Exactly one thread may push and exactly one may pop.
+ */
+template <class T> class ring_buffer {
+public:
+  /**
+   * Constructor.
+   * @param  capacity  how many elements the ring can hold before push blocks
+   */
+  explicit ring_buffer(size_t capacity)
+      : slots_(capacity + 1), head_(0), tail_(0), closed_(false) {
+  }
+
+  /**
+   * Add an element to the ring, waiting for the consumer to free a slot
+   * when the ring is full. Producer thread only.
+   * @param  item  the element, moved into the ring
+   */
+  void push(T&& item) {
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    size_t next = (tail + 1) % slots_.size();
+    // the ring is full until the consumer retires the slot after ours
+    while (next == head_.load(std::memory_order_acquire)) {
+      std::this_thread::yield();
+    }
+    slots_[tail] = std::move(item);
+    tail_.store(next, std::memory_order_release);
+  }
+
+  /**
+   * Take the oldest element out of the ring, waiting for the producer when
+   * the ring is empty. Consumer thread only.
+   * @param  item  filled with the element, moved out of the ring
+   * @return true if an element was taken, false if the ring was closed and
+   *         everything pushed before the close has already been taken
+   */
+  bool pop(T& item) {
+    size_t head = head_.load(std::memory_order_relaxed);
+    while (head == tail_.load(std::memory_order_acquire)) {
+      // the close happens after the producers last push, so when we see it
+      // we also see the final tail and an empty ring really is the end
+      if (closed_.load(std::memory_order_acquire) &&
+          head == tail_.load(std::memory_order_acquire)) {
+        return false;
+      }
+      std::this_thread::yield();
+    }
+    item = std::move(slots_[head]);
+    head_.store((head + 1) % slots_.size(), std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * Signal that nothing more will be pushed. Once the consumer drains what
+   * remains its pops return false. Producer thread only.
+   */
+  void close() {
+    closed_.store(true, std::memory_order_release);
+  }
+
+protected:
+  // one slot is kept empty to tell a full ring from an empty one
+  std::vector<T> slots_;
+  std::atomic<size_t> head_;
+  std::atomic<size_t> tail_;
+  std::atomic<bool> closed_;
+};
+
+} // namespace midgard
+} // namespace valhalla
+
+#endif // VALHALLA_MIDGARD_RING_BUFFER_H_
@@ -0,0 +1,133 @@
+#ifndef VALHALLA_MIDGARD_SCRATCH_ALLOCATOR_H_
+#define VALHALLA_MIDGARD_SCRATCH_ALLOCATOR_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace valhalla {
+namespace midgard {
+
+/**
+ * A monotonic arena backing short lived per request containers. Allocations
+ * bump a pointer within a block and individual deallocations are ignored;
+ * reset() recycles all of the memory at a safe point (between requests) so
+ * that in the steady state the containers built on top of it never touch the
+ * heap at all. Not thread safe - give each worker thread its own arena.
+ */
+class scratch_arena_t {
+public:
+  /**
+   * Constructor.
+   * @param  block_size  Granularity of the underlying heap blocks. A single
+   *                     allocation larger than this gets a block of its own.
+   */
+  explicit scratch_arena_t(size_t block_size = 64 * 1024)
+      : block_size_(block_size), current_(0), used_(0) {
+  }
+
+  // the blocks hold pointers handed out to containers so the arena can
+  // neither be copied nor moved out from under them
+  scratch_arena_t(const scratch_arena_t&) = delete;
+  scratch_arena_t& operator=(const scratch_arena_t&) = delete;
+
+  /**
+   * Get a chunk of memory from the arena, growing it when needed.
+   * @param  bytes      How many bytes are needed.
+   * @param  alignment  Alignment required by the object type.
+   * @return Returns a pointer to uninitialized storage within the arena.
+   */
+  void* allocate(size_t bytes, size_t alignment) {
+    // whats left of the current block, aligned for this type
+    while (current_ < blocks_.size()) {
+      size_t aligned = (used_ + alignment - 1) & ~(alignment - 1);
+      if (aligned + bytes <= blocks_[current_].second) {
+        used_ = aligned + bytes;
+        return blocks_[current_].first.get() + aligned;
+      }
+      // this block is spent, move on to the next one kept from a prior reset
+      ++current_;
+      used_ = 0;
+    }
+    // need a fresh block, oversized allocations get a block to themselves
+    size_t size = std::max(block_size_, bytes);
+    blocks_.emplace_back(std::unique_ptr<char[]>(new char[size]), size);
+    used_ = bytes;
+    return blocks_.back().first.get();
+  }
+
+  /**
+   * Make all of the arena's memory available again. Callers must guarantee
+   * that no container backed by the arena is still alive.
+   */
+  void reset() {
+    current_ = 0;
+    used_ = 0;
+  }
+
+private:
+  // granularity of heap blocks
+  size_t block_size_;
+  // the blocks and their sizes, kept over resets for reuse
+  std::vector<std::pair<std::unique_ptr<char[]>, size_t>> blocks_;
+  // block currently allocated from and the bytes used within it
+  size_t current_;
+  size_t used_;
+};
+
+/**
+ * An allocator handing out memory from a scratch_arena_t so that standard
+ * containers can live in the arena. Deallocation is a no-op - the memory
+ * comes back when the arena is reset between requests.
+ */
+template <typename T> class scratch_allocator {
+public:
+  using value_type = T;
+
+  explicit scratch_allocator(scratch_arena_t& arena) : arena_(&arena) {
+  }
+
+  // rebinding copies point at the same arena
+  template <typename U>
+  scratch_allocator(const scratch_allocator<U>& other) : arena_(other.arena()) {
+  }
+
+  T* allocate(size_t n) {
+    return static_cast<T*>(arena_->allocate(n * sizeof(T), alignof(T)));
+  }
+
+  void deallocate(T*, size_t) {
+  }
+
+  scratch_arena_t* arena() const {
+    return arena_;
+  }
+
+private:
+  scratch_arena_t* arena_;
+};
+
+// allocators over the same arena may exchange each others memory
+template <typename T, typename U>
+bool operator==(const scratch_allocator<T>& a, const scratch_allocator<U>& b) {
+  return a.arena() == b.arena();
+}
+template <typename T, typename U>
+bool operator!=(const scratch_allocator<T>& a, const scratch_allocator<U>& b) {
+  return a.arena() != b.arena();
+}
+
+// the usual suspects for per request temporaries
+template <typename T> using scratch_vector = std::vector<T, scratch_allocator<T>>;
+template <typename T>
+using scratch_set = std::unordered_set<T, std::hash<T>, std::equal_to<T>, scratch_allocator<T>>;
+using scratch_string = std::basic_string<char, std::char_traits<char>, scratch_allocator<char>>;
+
+} // namespace midgard
+} // namespace valhalla
+
+#endif // VALHALLA_MIDGARD_SCRATCH_ALLOCATOR_H_
@@ -16,6 +16,7 @@
 #include <memory>
 #include <stdexcept>
 #include <string>
+#include <thread>
 #include <type_traits>
 #include <unordered_map>
 #include <utility>
@@ -136,9 +137,12 @@ public:
   }
 
   // construct with file
-  mem_map(const std::string& file_name, size_t size, int advice = POSIX_MADV_NORMAL)
+  mem_map(const std::string& file_name,
+          size_t size,
+          int advice = POSIX_MADV_NORMAL,
+          bool readonly = false)
       : ptr(nullptr), count(0), file_name("") {
-    map(file_name, size, advice);
+    map(file_name, size, advice, readonly);
   }
 
   // unmap when done
@@ -161,8 +165,12 @@ public:
     map(new_file_name, new_count, advice);
   }
 
-  // reset to another file or another size
-  void map(const std::string& new_file_name, size_t new_count, int advice = POSIX_MADV_NORMAL) {
+  // reset to another file or another size. a readonly map shares clean pages
+  // of the file across processes and faults if anyone writes through it
+  void map(const std::string& new_file_name,
+           size_t new_count,
+           int advice = POSIX_MADV_NORMAL,
+           bool readonly = false) {
     // just in case there was already something
     unmap();
 
@@ -170,14 +178,15 @@ public:
     if (new_count > 0) {
       auto fd =
 #if defined(_MSC_VER)
-          _open(new_file_name.c_str(), O_RDWR, 0);
+          _open(new_file_name.c_str(), readonly ? O_RDONLY : O_RDWR, 0);
 #else
-          open(new_file_name.c_str(), O_RDWR, 0);
+          open(new_file_name.c_str(), readonly ? O_RDONLY : O_RDWR, 0);
 #endif
       if (fd == -1) {
         throw std::runtime_error(new_file_name + "(open): " + strerror(errno));
       }
-      ptr = mmap(nullptr, new_count * sizeof(T), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+      ptr = mmap(nullptr, new_count * sizeof(T), readonly ? PROT_READ : (PROT_READ | PROT_WRITE),
+                 readonly ? MAP_PRIVATE : MAP_SHARED, fd, 0);
       if (ptr == MAP_FAILED) {
         throw std::runtime_error(new_file_name + "(mmap): " + strerror(errno));
       }
@@ -252,13 +261,27 @@ public:
 
   sequence(const sequence&) = delete;
 
+  // a readonly sequence maps the existing file for reading only: consumer
+  // stages page it in on demand and share the page cache with one another
+  // instead of each opening it for writing and reserving write buffers.
+  // mutation (push_back, sort, transform) throws and writing through an
+  // iterator faults on the protected pages
   sequence(const std::string& file_name,
            bool create = false,
+           bool readonly = false,
            size_t write_buffer_size = 1024 * 1024 * 32 / sizeof(T))
       : file(new std::fstream(file_name,
-                              std::ios_base::binary | std::ios_base::in | std::ios_base::out |
-                                  (create ? std::ios_base::trunc : std::ios_base::ate))),
-        file_name(file_name) {
+                              std::ios_base::binary | std::ios_base::in |
+                                  (readonly ? std::ios_base::ate
+                                            : std::ios_base::out |
+                                                  (create ? std::ios_base::trunc
+                                                          : std::ios_base::ate)))),
+        file_name(file_name), readonly(readonly) {
+
+    // no sense in creating a file you may not write to
+    if (create && readonly) {
+      throw std::logic_error(file_name + ": cannot create a readonly sequence");
+    }
 
     // crack open the file
     if (!*file) {
@@ -269,10 +292,13 @@ public:
     if (end != static_cast<decltype(end)>(element_count * sizeof(T))) {
       throw std::runtime_error("This file has an incorrect size for type");
     }
-    write_buffer.reserve(write_buffer_size ? write_buffer_size : 1);
+    if (!readonly) {
+      write_buffer.reserve(write_buffer_size ? write_buffer_size : 1);
+    }
+    file_count = element_count;
 
     // memory map the file for reading
-    memmap.map(file_name, element_count);
+    memmap.map(file_name, element_count, POSIX_MADV_NORMAL, readonly);
   }
 
   ~sequence() {
@@ -282,10 +308,26 @@ public:
 
   // add an element to the sequence
   void push_back(const T& obj) {
+    if (readonly) {
+      throw std::logic_error(file_name + ": cannot push_back on a readonly sequence");
+    }
     write_buffer.push_back(obj);
-    // push it to the file
+    // hand the full buffer to the i/o thread and keep filling the other one,
+    // so the file writes overlap with whoever is producing the elements
     if (write_buffer.size() == write_buffer.capacity()) {
-      flush();
+      wait_for_io();
+      if (memmap.size() < file_count) {
+        memmap.map(file_name, file_count);
+      }
+      file_count += write_buffer.size();
+      write_buffer.swap(io_buffer);
+      write_buffer.reserve(io_buffer.capacity());
+      io_thread = std::thread([this] {
+        file->seekg(0, file->end);
+        file->write(static_cast<const char*>(static_cast<const void*>(io_buffer.data())),
+                    io_buffer.size() * sizeof(T));
+        file->flush();
+      });
     }
   }
 
@@ -310,20 +352,74 @@ public:
   // sort the file based on the predicate
   void sort(const std::function<bool(const T&, const T&)>& predicate,
             size_t buffer_size = 1024 * 1024 * 512 / sizeof(T)) {
-    using queue_t =
-        std::map<T, std::list<std::fstream>::iterator, std::function<bool(const T&, const T&)>>;
-
+    if (readonly) {
+      throw std::logic_error(file_name + ": cannot sort a readonly sequence");
+    }
     flush();
     // if no elements we are done
     if (memmap.size() == 0) {
       return;
     }
-    std::sort(static_cast<T*>(memmap), static_cast<T*>(memmap) + memmap.size(), predicate);
-    return;
+
+    // the data is memory mapped so the sort works directly on the mapping and
+    // the os pages it in and out, but one thread cannot keep up with the node
+    // and edge files of a big build so small sequences aside we parallelize
+    T* data = static_cast<T*>(memmap);
+    size_t count = memmap.size();
+    size_t thread_count = std::max<size_t>(1, std::thread::hardware_concurrency());
+    if (thread_count < 2 || count < thread_count * 2) {
+      std::sort(data, data + count, predicate);
+      return;
+    }
+
+    // round the run count up to a power of two so the merges pair up evenly
+    size_t runs = 1;
+    while (runs < thread_count) {
+      runs *= 2;
+    }
+    size_t run_size = (count + runs - 1) / runs;
+    std::vector<size_t> bounds;
+    bounds.reserve(runs + 1);
+    for (size_t i = 0; i <= runs; ++i) {
+      bounds.push_back(std::min(i * run_size, count));
+    }
+
+    // sort each run on its own thread
+    std::vector<std::shared_ptr<std::thread>> threads(runs);
+    for (size_t i = 0; i < runs; ++i) {
+      threads[i].reset(new std::thread(
+          [&predicate, data, &bounds](size_t run) {
+            std::sort(data + bounds[run], data + bounds[run + 1], predicate);
+          },
+          i));
+    }
+    for (const auto& thread : threads) {
+      thread->join();
+    }
+
+    // merge neighboring runs pairwise, with each merge of a round on its own
+    // thread, until a single sorted run remains
+    for (size_t width = 1; width < runs; width *= 2) {
+      std::vector<std::shared_ptr<std::thread>> mergers;
+      for (size_t i = 0; i + width < runs; i += width * 2) {
+        mergers.emplace_back(new std::thread(
+            [&predicate, data, &bounds, runs, width](size_t run) {
+              std::inplace_merge(data + bounds[run], data + bounds[run + width],
+                                 data + bounds[std::min(run + width * 2, runs)], predicate);
+            },
+            i));
+      }
+      for (const auto& merger : mergers) {
+        merger->join();
+      }
+    }
   }
 
   // perform an volatile operation on all the items of this sequence
   void transform(const std::function<void(T&)>& predicate) {
+    if (readonly) {
+      throw std::logic_error(file_name + ": cannot transform a readonly sequence");
+    }
     flush();
     for (size_t i = 0; i < memmap.size(); ++i) {
       // grab the element
@@ -348,19 +444,29 @@ public:
 
   // force writing whatever we have in the write_buffer to file
   void flush() {
+    // nothing is ever buffered for a readonly sequence
+    if (readonly) {
+      return;
+    }
+    // whatever the i/o thread was writing behind has to be on disk first
+    wait_for_io();
     if (write_buffer.size()) {
       file->seekg(0, file->end);
       file->write(static_cast<const char*>(static_cast<const void*>(write_buffer.data())),
                   write_buffer.size() * sizeof(T));
       file->flush();
-      memmap.map(file_name, memmap.size() + write_buffer.size());
+      file_count += write_buffer.size();
       write_buffer.clear();
     }
+    // catch the mapping up with everything thats on disk
+    if (memmap.size() < file_count) {
+      memmap.map(file_name, file_count);
+    }
   }
 
   // how many things have been written so far
   size_t size() const {
-    return memmap.size() + write_buffer.size();
+    return file_count + write_buffer.size();
   }
 
   // a read/writeable object within the sequence, accessed through memory mapped file
@@ -377,9 +483,9 @@ public:
     }
     iterator& operator=(const T& other) {
       // If index is beyond the end of the mmap buffer, then
-      // access items that may be in the write_buffer.
+      // access items that may be in the write buffers.
       if (index >= parent->memmap.size()) {
-        parent->write_buffer[index - parent->memmap.size()] = other;
+        parent->unwritten(index) = other;
       } else {
         *(static_cast<T*>(parent->memmap) + index) = other;
       }
@@ -387,9 +493,9 @@ public:
     }
     operator T() {
       // If index is beyond the end of the mmap buffer, then
-      // access items that may be in the write_buffer.
+      // access items that may be in the write buffers.
       if (index >= parent->memmap.size()) {
-        return parent->write_buffer.at(index - parent->memmap.size());
+        return parent->unwritten(index);
       } else {
         return *(static_cast<T*>(parent->memmap) + index);
       }
@@ -500,13 +606,42 @@ public:
 
   // invalid end iterator
   iterator end() {
-    return iterator(this, memmap.size() + write_buffer.size());
+    return iterator(this, size());
   }
 
 protected:
+  // wait for the write behind of the last full buffer to finish
+  void wait_for_io() {
+    if (io_thread.joinable()) {
+      io_thread.join();
+      io_buffer.clear();
+    }
+  }
+
+  // the iterators resolve anything beyond the mapping through this: either the
+  // element is still being filled in the write buffer, or the i/o thread owns
+  // it, in which case we wait out the write and catch the mapping up
+  T& unwritten(size_t index) {
+    if (index >= file_count) {
+      return write_buffer[index - file_count];
+    }
+    wait_for_io();
+    if (memmap.size() < file_count) {
+      memmap.map(file_name, file_count);
+    }
+    return *(static_cast<T*>(memmap) + index);
+  }
+
   std::shared_ptr<std::fstream> file;
   std::string file_name;
   std::vector<T> write_buffer;
+  // the buffer the i/o thread is writing behind and the thread doing it, the
+  // count of elements on disk (or handed to the thread) trails in file_count
+  std::vector<T> io_buffer;
+  std::thread io_thread;
+  size_t file_count;
+  // the file was opened for reading only and the mapping is write protected
+  bool readonly;
   mem_map<T> memmap;
 };
 
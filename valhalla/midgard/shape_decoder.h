@@ -10,6 +10,11 @@ template <typename Point> class Shape7Decoder {
 public:
   Shape7Decoder(const char* begin, const size_t size) : begin(begin), end(begin + size) {
   }
+  // start mid stream with the accumulated fixed precision coordinate of the
+  // vertex just before it, as recorded by a shape index checkpoint
+  Shape7Decoder(const char* begin, const size_t size, const int32_t lat, const int32_t lon)
+      : begin(begin), end(begin + size), lat(lat), lon(lon) {
+  }
   Point pop() noexcept(false) {
     lat = next(lat);
     lon = next(lon);
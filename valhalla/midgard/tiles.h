@@ -111,8 +111,9 @@ public:
     }
 
     // If equal to the max y return the largest row
-    return (y == tilebounds_.maxy()) ? nrows_ - 1
-                                     : static_cast<int32_t>((y - tilebounds_.miny()) / tilesize_);
+    return (y == tilebounds_.maxy())
+               ? nrows_ - 1
+               : static_cast<int32_t>((y - tilebounds_.miny()) * tilesize_inv_);
   }
 
   /**
@@ -130,7 +131,7 @@ public:
     if (x == tilebounds_.maxx()) {
       return ncolumns_ - 1;
     } else {
-      float col = (x - tilebounds_.minx()) / tilesize_;
+      float col = (x - tilebounds_.minx()) * tilesize_inv_;
       return (col >= 0.0) ? static_cast<int32_t>(col) : static_cast<int32_t>(col - 1);
     }
   }
@@ -372,6 +373,11 @@ protected:
   // Tile size.  Tiles are square (equal y and x size).
   float tilesize_;
 
+  // Reciprocal of the tile size. The hierarchy tile sizes are constant per
+  // tiling so the division in the per point row/column mapping folds into
+  // a multiply (exact for the power of two sizes the hierarchy uses)
+  float tilesize_inv_;
+
   // Number of rows ( y or latitude)
   int32_t nrows_;
 
@@ -382,6 +388,11 @@ protected:
   unsigned short nsubdivisions_;
 
   float subdivision_size_;
+
+  // Subdivisions (pixels) per unit of x and y, precomputed so projecting a
+  // point into the global subdivision grid is a subtract and multiply
+  float subpixels_per_x_;
+  float subpixels_per_y_;
 };
 
 } // namespace midgard
@@ -37,6 +37,27 @@ template <class T> struct ranged_default_t {
 // Intersection cases.
 enum IntersectCase { kWithin, kContains, kOutside, kIntersects };
 
+/**
+ * Hint the processor to start loading a span of memory into cache. Useful
+ * just before walking densely packed records (directed edges, edge labels)
+ * whose first touch would otherwise stall on memory. Compiles to nothing
+ * where no prefetch intrinsic is available.
+ * @param  addr   start of the span.
+ * @param  bytes  length of the span in bytes.
+ */
+inline void prefetch_range(const void* addr, const size_t bytes) {
+#if defined(__GNUC__) || defined(__clang__)
+  constexpr size_t kCacheLineSize = 64;
+  const char* p = static_cast<const char*>(addr);
+  for (size_t offset = 0; offset < bytes; offset += kCacheLineSize) {
+    __builtin_prefetch(p + offset);
+  }
+#else
+  (void)addr;
+  (void)bytes;
+#endif
+}
+
 /**
  * Compute time (seconds) given a length (km) and speed (km per hour)
  * @param  length  distance in km.
@@ -139,6 +160,12 @@ template <class container_t> float length(const container_t& pts) {
   return length;
 }
 
+// Specialization for the common decoded shape case. Runs over the contiguous
+// points in one pass reusing each vertex's trig between its two segments, so
+// the loop does less work than calling Distance per segment while summing the
+// exact same per segment values.
+float length(const std::vector<PointLL>& pts);
+
 /**
  * Compute the length of a polyline between the 2 specified iterators.
  * @param  begin  Starting point (iterator) within the polyline container.
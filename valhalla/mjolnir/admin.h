@@ -2,15 +2,20 @@
 #define VALHALLA_MJOLNIR_ADMIN_H_
 
 #include <boost/geometry.hpp>
+#include <boost/geometry/geometries/box.hpp>
 #include <boost/geometry/geometries/point_xy.hpp>
 #include <boost/geometry/geometries/polygon.hpp>
+#include <boost/geometry/index/rtree.hpp>
 #include <boost/geometry/io/wkt/wkt.hpp>
 #include <boost/geometry/multi/geometries/multi_polygon.hpp>
 #include <cstdint>
 #include <sqlite3.h>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 #include <valhalla/baldr/graphconstants.h>
 #include <valhalla/midgard/aabb2.h>
+#include <valhalla/midgard/bucketed_polygon.h>
 #include <valhalla/midgard/pointll.h>
 #include <valhalla/mjolnir/graphtilebuilder.h>
 
@@ -24,6 +29,43 @@ namespace mjolnir {
 typedef boost::geometry::model::d2::point_xy<double> point_type;
 typedef boost::geometry::model::polygon<point_type> polygon_type;
 typedef boost::geometry::model::multi_polygon<polygon_type> multi_polygon_type;
+typedef boost::geometry::model::box<point_type> box_type;
+
+/**
+ * A spatial index over a set of multi polygons (timezone or admin areas).
+ * The bounding box of each polygon goes into an r-tree built once up front
+ * with the packing constructor, and each polygon's rings are rebuilt as
+ * bucketed edge structures, so a point lookup narrows to the polygons
+ * whose boxes cover the point and then runs the banded crossing test
+ * instead of walking whole admin rings.
+ */
+class MultiPolyIndex {
+public:
+  /**
+   * Constructor. Builds the r-tree and the bucketed rings over the polys.
+   * @param  polys   unordered map of polys to index.
+   */
+  explicit MultiPolyIndex(const std::unordered_multimap<uint32_t, multi_polygon_type>& polys);
+
+  /**
+   * Get the polygon index of the poly covering the point. Returns 0 if no
+   * poly covers it.
+   * @param  ll   point that needs to be checked.
+   */
+  uint32_t GetMultiPolyId(const midgard::PointLL& ll) const;
+
+private:
+  // One polygon of a multi polygon with its containment test prebuilt:
+  // inside the outer ring and outside every hole
+  struct indexed_poly_t {
+    uint32_t id;
+    midgard::BucketedPolygon outer;
+    std::vector<midgard::BucketedPolygon> inners;
+  };
+  typedef std::pair<box_type, size_t> rtree_value_type;
+  std::vector<indexed_poly_t> polys_;
+  boost::geometry::index::rtree<rtree_value_type, boost::geometry::index::quadratic<16>> rtree_;
+};
 
 /**
  * Get the dbhandle of a sqlite db.  Used for timezones and admins DBs.
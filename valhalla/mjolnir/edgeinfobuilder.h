@@ -89,6 +89,22 @@ public:
    */
   void set_encoded_shape(const std::string& encoded_shape);
 
+  /**
+   * Request that a vertex checkpoint index be written after the encoded
+   * shape so readers can decode from mid shape. The index is only actually
+   * written for shapes with more vertices than the sample rate; shorter
+   * ones pay nothing.
+   * @param  index  True to write the index.
+   */
+  void set_index_shape(const bool index);
+
+  /**
+   * Does this edge info write a shape index? True when one was requested
+   * and the shape is long enough to have any checkpoints.
+   * @return  Returns true if index bytes will be written.
+   */
+  bool index_shape() const;
+
   /**
    * Get the size of this edge info (without padding).
    * @return  Returns the size in bytes of this object.
@@ -122,6 +138,21 @@ protected:
   // Lat,lng shape of the edge
   std::string encoded_shape_;
 
+  // Whether a vertex checkpoint index should be written after the shape
+  bool index_shape_ = false;
+
+  // The packed checkpoint records, built from the encoded shape the first
+  // time the size or the bytes are needed and dropped if the shape changes
+  mutable std::string shape_index_;
+  mutable bool shape_index_built_ = false;
+
+  /**
+   * Get the packed checkpoint index bytes (count plus records), empty when
+   * no index was requested or the shape is too short to have checkpoints.
+   * @return  Returns the index bytes.
+   */
+  const std::string& shape_index() const;
+
   friend std::ostream& operator<<(std::ostream& os, const EdgeInfoBuilder& id);
 };
 
@@ -60,6 +60,16 @@ public:
    */
   void StoreTileData();
 
+  /**
+   * Globally enable (or disable) writing the directed edge SoA mirror
+   * section when tiles are stored. Read from mjolnir.include_edge_soa by
+   * the build drivers before any tiles are written. Tiles that already
+   * carry the section keep it (regenerated from the current edges)
+   * regardless of this setting.
+   * @param  include  true to write the mirror when storing tiles.
+   */
+  static void set_include_edge_soa(const bool include);
+
   /**
    * Update a graph tile with new nodes and directed edges. Assumes no new
    * nodes or edges are added. Attributes within existing nodes and edges
@@ -70,6 +80,18 @@ public:
    */
   void Update(const std::vector<NodeInfo>& nodes, const std::vector<DirectedEdge>& directededges);
 
+  /**
+   * Patch directed edges in place within the stored tile file. Only the
+   * changed fixed size records and the header are written, so attribute
+   * only refreshes (speeds, access flags) touch a few bytes per edge
+   * rather than rewriting the whole tile. The header's update generation
+   * is bumped so readers can detect the change. The tile layout (counts
+   * and offsets) must be unchanged.
+   * @param edges Directed edge index within the tile paired with the new
+   *              record to store at that index.
+   */
+  void PatchDirectedEdges(const std::vector<std::pair<uint32_t, DirectedEdge>>& edges);
+
   /**
    * Get the current list of node builders.
    * @return  Returns the node info builders.
@@ -445,6 +467,13 @@ protected:
   // Header information for the tile
   GraphTileHeader header_builder_;
 
+  // Whether StoreTileData writes the directed edge SoA mirror section.
+  // True when globally enabled or when the source tile already carried it
+  bool include_edge_soa_ = false;
+
+  // The global default for newly stored tiles, set from the build config
+  static bool default_include_edge_soa_;
+
   // List of nodes. This is a fixed size structure so it can be
   // indexed directly.
   std::vector<NodeInfo> nodes_builder_;
@@ -1,10 +1,8 @@
 #ifndef VALHALLA_MJOLNIR_IDTABLE_H
 #define VALHALLA_MJOLNIR_IDTABLE_H
 
-#include <algorithm>
-#include <cmath>
 #include <cstdint>
-#include <midgard/logging.h>
+#include <memory>
 #include <vector>
 
 namespace valhalla {
@@ -12,8 +10,10 @@ namespace mjolnir {
 
 /**
  * A method for marking OSM Ids that are used by ways/nodes/relations.
- * Uses a vector where 1 bit is used for each possible Id.
- * So for a maximum OSM Id of 4 billion this uses 500MB memory
+ * One bit is used for each possible Id but the bits live in fixed size
+ * pages which are only allocated when an id in the page's range is first
+ * set. The table therefore scales with the id ranges actually touched
+ * rather than with the maximum OSM id, which keeps growing upstream.
  */
 class IdTable {
 public:
@@ -22,10 +22,11 @@ public:
    * @param   maxosmid   Maximum OSM Id to support.
    */
   IdTable(const uint64_t maxosmid) {
-    // Create a vector to mark bits. Initialize to 0.
-    bitmarkers_.resize((maxosmid / 64) + 1, 0);
+    // Create the page directory. The pages themselves are allocated when
+    // an id within a page is first set
+    pages_.resize(maxosmid / kPageBits + 1);
     // Set this to the actual maximum as dictated by the storage
-    maxosmid_ = bitmarkers_.size() * 64 - 1;
+    maxosmid_ = pages_.size() * kPageBits - 1;
   }
 
   /**
@@ -39,8 +40,11 @@ public:
    * @param   osmid   OSM Id of the way/node/relation.
    */
   inline void set(const uint64_t id) {
-    auto idx = maybe_resize(id);
-    bitmarkers_[idx] |= static_cast<uint64_t>(1) << (id % static_cast<uint64_t>(64));
+    auto& page = maybe_resize(id);
+    if (!page) {
+      page.reset(new uint64_t[kPageWords]());
+    }
+    page[(id % kPageBits) / 64] |= static_cast<uint64_t>(1) << (id % static_cast<uint64_t>(64));
   }
 
   /**
@@ -48,10 +52,13 @@ public:
    * @param  id  OSM Id
    * @return  Returns true if the OSM Id is used. False if not.
    */
-  inline const bool get(const uint64_t id) {
-    return id > maxosmid_ ? false
-                          : bitmarkers_[id / 64] &
-                                (static_cast<uint64_t>(1) << (id % static_cast<uint64_t>(64)));
+  inline const bool get(const uint64_t id) const {
+    if (id > maxosmid_) {
+      return false;
+    }
+    const auto& page = pages_[id / kPageBits];
+    return page && (page[(id % kPageBits) / 64] &
+                    (static_cast<uint64_t>(1) << (id % static_cast<uint64_t>(64))));
   }
 
   /**
@@ -64,25 +71,27 @@ public:
 
 private:
   /**
-   * Resizes the internal storage and adjusts maxosmid_ if needed
-   * the idea is that we dont need to actually do this very often
+   * Resizes the page directory and adjusts maxosmid_ if needed. The
+   * directory holds only page pointers so growing it is cheap
    *
    * @param the id which needs to fit in storage
-   * @returns the index holding the bit
+   * @returns the page holding the bit
    */
-  inline uint64_t maybe_resize(const uint64_t id) {
-    // we dont double it because that could be huge, so we stay conservative
-    uint64_t idx = id / 64;
+  inline std::unique_ptr<uint64_t[]>& maybe_resize(const uint64_t id) {
+    uint64_t idx = id / kPageBits;
     if (id > maxosmid_) {
-      LOG_WARN("Max osmid exceeded bitset, resizing to fit id: " + std::to_string(id));
-      bitmarkers_.resize(std::ceil(idx * 1.01 + 1), 0);
-      maxosmid_ = bitmarkers_.size() * 64 - 1;
+      pages_.resize(idx + 1);
+      maxosmid_ = pages_.size() * kPageBits - 1;
     }
-    return idx;
+    return pages_[idx];
   }
 
+  // 4kB pages, one bit per id
+  static constexpr uint64_t kPageWords = 512;
+  static constexpr uint64_t kPageBits = kPageWords * 64;
+
   uint64_t maxosmid_;
-  std::vector<uint64_t> bitmarkers_;
+  std::vector<std::unique_ptr<uint64_t[]>> pages_;
 };
 } // namespace mjolnir
 } // namespace valhalla
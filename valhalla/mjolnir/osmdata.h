@@ -45,9 +45,6 @@ using BikeMultiMap = std::unordered_multimap<uint64_t, OSMBike>;
 
 using OSMStringMap = std::unordered_map<uint64_t, std::string>;
 
-using OSMShapeMap = std::unordered_map<uint64_t, PointLL>;
-using OSMWayMap = std::unordered_map<uint64_t, std::list<uint64_t>>;
-
 using OSMLaneConnectivityMultiMap = std::unordered_multimap<uint32_t, OSMLaneConnectivity>;
 
 enum class OSMType : uint8_t { kNode, kWay, kRelation };
@@ -106,12 +103,6 @@ struct OSMData {
   // Backward turn lane strings
   UniqueNames bwd_turn_lanes_map;
 
-  // Map used in admins to store the shape of the nodes.
-  OSMShapeMap shape_map;
-
-  // Map used in admins to store the ways.
-  OSMWayMap way_map;
-
   // Lane connectivity, index by the to way Id
   OSMLaneConnectivityMultiMap lane_connectivity_map;
 
@@ -31,8 +31,14 @@
 #ifndef __OSMPBFPARSER__
 #define __OSMPBFPARSER__
 
+#include <atomic>
+#include <exception>
 #include <fstream>
 #include <string>
+#include <thread>
+#include <vector>
+
+#include <valhalla/midgard/ring_buffer.h>
 
 // this describes the low-level blob storage
 #include <valhalla/proto/fileformat.pb.h>
@@ -77,6 +83,51 @@ struct Callback {
   virtual void changeset_callback(const uint64_t changeset_id) = 0;
 };
 
+// runs another callback on its own consumer thread, fed through a lock free
+// ring buffer, so pbf block decoding overlaps with whatever the wrapped
+// callback does with the primitives (tag transformation, sequence writes).
+// wrap one Parser::parse call; the destructor drains the ring and joins, so
+// the wrapped callback's state is safe to touch again after that
+class ThreadedCallback : public Callback {
+public:
+  ThreadedCallback() = delete;
+  explicit ThreadedCallback(Callback& callback, size_t buffer_size = 8192);
+  virtual ~ThreadedCallback();
+  virtual void node_callback(const uint64_t osmid,
+                             const double lng,
+                             const double lat,
+                             const Tags& tags) override;
+  virtual void
+  way_callback(const uint64_t osmid, const Tags& tags, const std::vector<uint64_t>& nodes) override;
+  virtual void relation_callback(const uint64_t osmid,
+                                 const Tags& tags,
+                                 const std::vector<Member>& members) override;
+  virtual void changeset_callback(const uint64_t changeset_id) override;
+
+protected:
+  // one parsed primitive in flight between the decoder and the consumer
+  struct message {
+    enum class primitive : uint8_t { node, way, relation, changeset };
+    primitive type;
+    uint64_t osmid;
+    double lng, lat;
+    Tags tags;
+    std::vector<uint64_t> nodes;
+    std::vector<Member> members;
+  };
+
+  // hand a primitive to the consumer, surfacing any failure it has hit
+  void enqueue(message&& m);
+
+  Callback& callback_;
+  valhalla::midgard::ring_buffer<message> ring_;
+  std::thread consumer_;
+  // the first exception the wrapped callback threw, rethrown on the next
+  // enqueue so it propagates out of Parser::parse on the decoding thread
+  std::exception_ptr failure_;
+  std::atomic<bool> failed_;
+};
+
 // the parser used to get data out of the osmpbf file
 class Parser {
 public:
@@ -17,10 +17,14 @@ namespace mjolnir {
 class PBFAdminParser {
 public:
   /**
-   * Loads given input files
+   * Loads given input files. The admin relation member way shapes are
+   * streamed to the disk backed way nodes file, sorted by way id and shape
+   * node index, so a planet admin build does not have to hold all of the
+   * geometry in memory at once.
    */
   static OSMData Parse(const boost::property_tree::ptree& pt,
-                       const std::vector<std::string>& input_files);
+                       const std::vector<std::string>& input_files,
+                       const std::string& way_nodes_file);
 };
 
 } // namespace mjolnir
@@ -1,8 +1,8 @@
 #ifndef VALHALLA_MJOLNIR_UNIQUENAMES_H
 #define VALHALLA_MJOLNIR_UNIQUENAMES_H
 
-#include <algorithm>
 #include <cstdint>
+#include <memory>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -10,10 +10,11 @@
 namespace valhalla {
 namespace mjolnir {
 
-using NamesMap = std::unordered_map<std::string, uint32_t>;
-
 /**
- * Class to hold a list of unique names and indexes to them.
+ * Class to hold a list of unique names and indexes to them. The name
+ * characters are stored back to back in a single append-only arena and
+ * referred to by offset. This avoids a heap allocation per name and keeps
+ * name lookups against neighboring entries local in memory.
  */
 class UniqueNames {
 public:
@@ -35,7 +36,7 @@ public:
    * @param  index  Index into the unique name list.
    * @return  Returns the name
    */
-  const std::string& name(const uint32_t index) const;
+  std::string name(const uint32_t index) const;
 
   /**
    * Clear the names and indexes.
@@ -54,12 +55,29 @@ public:
   void Log() const;
 
 protected:
-  // Map of names to indexes
+  // Hashes the null terminated name beginning at an offset in the arena
+  struct NameHash {
+    const std::vector<char>* arena;
+    size_t operator()(const uint32_t offset) const;
+  };
+
+  // Compares the null terminated names beginning at two offsets in the arena
+  struct NameEqual {
+    const std::vector<char>* arena;
+    bool operator()(const uint32_t lhs, const uint32_t rhs) const;
+  };
+
+  using NamesMap = std::unordered_map<uint32_t, uint32_t, NameHash, NameEqual>;
+
+  // The name characters back to back, each name null terminated. Held behind
+  // a pointer so the map functors stay valid when the whole object is moved
+  std::unique_ptr<std::vector<char>> arena_;
+
+  // Map of name offsets to indexes
   NamesMap names_;
 
-  // List of entries into the map
-  using nameiter = NamesMap::iterator;
-  std::vector<nameiter> indexes_;
+  // The arena offset of each name, in index order
+  std::vector<uint32_t> indexes_;
 };
 
 } // namespace mjolnir
@@ -4,6 +4,7 @@
 #include <boost/property_tree/ptree.hpp>
 #include <list>
 #include <string>
+#include <valhalla/baldr/graphid.h>
 #include <valhalla/midgard/pointll.h>
 #include <vector>
 
@@ -42,6 +43,30 @@ bool shapes_match(const std::vector<midgard::PointLL>& shape1,
  */
 uint32_t compute_curvature(const std::list<midgard::PointLL>& shape);
 
+/**
+ * The slice of the tile work this process is responsible for in a
+ * distributed build. Hosts sharing a tile directory each run with the same
+ * mjolnir.shard_count and a distinct mjolnir.shard_index; tiles are assigned
+ * to shards by their tile id so every host derives the same disjoint
+ * partition without coordinating. Defaults to the whole tile set.
+ */
+struct tile_shard_t {
+  uint32_t count;
+  uint32_t index;
+
+  /**
+   * Reads the shard from the mjolnir config subtree.
+   * @param config  the mjolnir config subtree
+   */
+  explicit tile_shard_t(const boost::property_tree::ptree& config);
+
+  /**
+   * Whether this process is responsible for the given tile.
+   * @param tile_id  the tile to test
+   */
+  bool contains(const baldr::GraphId& tile_id) const;
+};
+
 /**
  * Build an entire valhalla tileset give a config file and some input pbfs
  * @param config              used to tell the function where and how to build the tiles
@@ -94,6 +94,10 @@ protected:
   bool
   IsTee(int node_index, EnhancedTripPath_Edge* prev_edge, EnhancedTripPath_Edge* curr_edge) const;
 
+  bool HasCommonBaseNames(int node_index,
+                          EnhancedTripPath_Edge* prev_edge,
+                          EnhancedTripPath_Edge* curr_edge) const;
+
   bool IsLeftPencilPointUturn(int node_index,
                               EnhancedTripPath_Edge* prev_edge,
                               EnhancedTripPath_Edge* curr_edge) const;
@@ -1,9 +1,12 @@
 #ifndef VALHALLA_ODIN_NARRATIVE_DICTIONARY_H_
 #define VALHALLA_ODIN_NARRATIVE_DICTIONARY_H_
 
+#include <cstdint>
+#include <initializer_list>
 #include <locale>
 #include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include <boost/property_tree/ptree.hpp>
@@ -152,8 +155,26 @@ constexpr auto kTransitPlatformCountLabelTag = "<TRANSIT_STOP_COUNT_LABEL>";
 namespace valhalla {
 namespace odin {
 
+// One localized phrase split at its <TAG> placeholders when the dictionary is
+// loaded. The pieces alternate literal text (even indices) and tag (odd
+// indices) so an instruction can be assembled by appending the pieces rather
+// than searching the phrase for every tag each time it is used.
+struct PhraseTemplate {
+  explicit PhraseTemplate(const std::string& phrase);
+
+  std::vector<std::string> pieces;
+};
+
 struct PhraseSet {
   std::unordered_map<std::string, std::string> phrases;
+  std::unordered_map<uint32_t, PhraseTemplate> templates;
+
+  // Returns the phrase for the specified phrase id after replacing each tag
+  // with its supplied value. A tag without a value keeps its placeholder text,
+  // matching what sequential tag replacement leaves behind.
+  std::string
+  FormPhrase(uint32_t phrase_id,
+             std::initializer_list<std::pair<const char*, const std::string&>> values = {}) const;
 };
 
 struct StartSubset : PhraseSet {
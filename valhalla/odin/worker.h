@@ -1,6 +1,8 @@
 #ifndef __VALHALLA_ODIN_SERVICE_H__
 #define __VALHALLA_ODIN_SERVICE_H__
 
+#include <google/protobuf/arena.h>
+
 #include <valhalla/proto/directions_options.pb.h>
 #include <valhalla/proto/tripdirections.pb.h>
 #include <valhalla/proto/trippath.pb.h>
@@ -25,7 +27,19 @@ public:
   virtual void cleanup() override;
 
   std::list<TripDirections> narrate(const valhalla_request_t& request,
-                                    std::list<TripPath>& legs) const;
+                                    std::list<TripPath*>& legs) const;
+
+protected:
+  // Arena the incoming trip path legs are parsed onto. Reset after each
+  // request once the directions have been serialized
+  google::protobuf::Arena arena;
+
+  // How many threads to annotate the legs of a multi leg trip with
+  unsigned int concurrency;
+
+  // Ring the big legs from thor arrive in when shared memory messaging is
+  // on, null when it is off
+  std::shared_ptr<shm_message_arena_t> message_arena;
 };
 } // namespace odin
 } // namespace valhalla
@@ -3,6 +3,8 @@
 
 #include <map>
 #include <memory>
+#include <string>
+#include <unordered_map>
 
 #include <valhalla/baldr/rapidjson_utils.h>
 #include <valhalla/proto/directions_options.pb.h>
@@ -58,6 +60,49 @@ public:
     return itr->second(costing, options);
   }
 
+  /**
+   * Make a cost from its specified type, reusing a previously created cost
+   * object when an identical one (same costing options and avoided edges)
+   * was created before. The overwhelming majority of requests carry default
+   * or identical costing options, so this skips re-parsing the options and
+   * re-allocating the cost object on the hot path. The returned costing has
+   * its per request mutable state (multi-pass flags, relaxed hierarchy
+   * limits) restored to its constructed state. Only safe when the factory
+   * serves one request at a time, as in the single threaded workers.
+   * @param costing  the type of cost to create
+   * @param options  pbf with request options
+   */
+  cost_ptr_t CreateCached(const odin::Costing costing, const odin::DirectionsOptions& options) {
+    // key on everything the costings read from the request: their own
+    // options and the edges to avoid. serialized bytes make an exact key
+    // so differing profiles can never collide
+    std::string key = odin::Costing_Name(costing);
+    if (static_cast<int>(costing) < options.costing_options_size()) {
+      options.costing_options(static_cast<int>(costing)).AppendToString(&key);
+    }
+    for (auto edgeid : options.avoid_edges()) {
+      key.append(reinterpret_cast<const char*>(&edgeid), sizeof(edgeid));
+    }
+
+    // return the pooled costing reset to its constructed state
+    auto itr = cache_.find(key);
+    if (itr != cache_.end()) {
+      itr->second->RestoreDefaultState();
+      return itr->second;
+    }
+
+    // dont let rare profiles accumulate without bound
+    if (cache_.size() >= kMaxCacheSize) {
+      cache_.clear();
+    }
+
+    // create the cost and remember its constructed state for later reuse
+    auto cost = Create(costing, options);
+    cost->SnapshotDefaultState();
+    cache_.emplace(std::move(key), cost);
+    return cost;
+  }
+
   /**
    * Convenience method to register all of the standard costing models.
    */
@@ -76,7 +121,11 @@ public:
   }
 
 private:
+  // Maximum number of distinct costing profiles kept in the reuse cache
+  static constexpr size_t kMaxCacheSize = 100;
+
   std::map<const odin::Costing, factory_function_t> factory_funcs_;
+  std::unordered_map<std::string, cost_ptr_t> cache_;
 };
 
 } // namespace sif
@@ -16,6 +16,7 @@
 #include <valhalla/sif/hierarchylimits.h>
 
 #include <memory>
+#include <unordered_map>
 #include <unordered_set>
 
 namespace valhalla {
@@ -205,6 +206,23 @@ public:
    */
   virtual Cost EdgeCost(const baldr::DirectedEdge* edge, const uint32_t speed) const;
 
+  /**
+   * Get the costs to traverse a batch of directed edges from a single graph
+   * tile. The default implementation prices the edges one at a time; costings
+   * whose edge cost is pure table and factor math may override with a loop
+   * the compiler can vectorize over the tile's contiguous edge array. Useful
+   * for dense expansions such as the cost matrix, where all edges leaving a
+   * node are priced together.
+   * @param   edges   Pointers to the directed edges (from one graph tile).
+   * @param   speeds  Speed (kph) to use for each edge.
+   * @param   count   Number of edges to cost.
+   * @param   costs   Output array of costs, sized to hold count entries.
+   */
+  virtual void EdgeCosts(const baldr::DirectedEdge** edges,
+                         const uint32_t* speeds,
+                         const size_t count,
+                         Cost* costs) const;
+
   /**
    * Returns the cost to make the transition from the predecessor edge.
    * Defaults to 0. Costing models that wish to include edge transition
@@ -240,6 +258,88 @@ public:
                                      const baldr::DirectedEdge* opp_pred_edge,
                                      const bool has_traffic = false) const;
 
+  /**
+   * Evaluate an edge for forward expansion in a single virtual dispatch:
+   * check access and, if allowed, compute the transition cost and the new
+   * cost to the end of the edge. Expansion makes these calls once per edge,
+   * so concrete costings override this to forward to EvaluateForwardImpl,
+   * which binds the calls statically and lets the compiler inline the cost
+   * math. This default keeps externally derived costings working through
+   * the individual virtual methods.
+   * @param  edge            Pointer to a directed edge.
+   * @param  node            Node (intersection) at the start of the edge.
+   * @param  pred            Predecessor edge information.
+   * @param  tile            Current tile.
+   * @param  edgeid          GraphId of the directed edge.
+   * @param  current_time    Current time (seconds since epoch). A value of 0
+   *                         indicates the route is not time dependent.
+   * @param  tz_index        timezone index for the node
+   * @param  speed           Speed to cost the edge with.
+   * @param  transition_cost Set to the cost of transitioning onto the edge.
+   * @param  newcost         Set to the cost to the end of the edge.
+   * @return Returns true if access is allowed and the costs were computed.
+   */
+  virtual bool EvaluateForward(const baldr::DirectedEdge* edge,
+                               const baldr::NodeInfo* node,
+                               const EdgeLabel& pred,
+                               const baldr::GraphTile*& tile,
+                               const baldr::GraphId& edgeid,
+                               const uint64_t current_time,
+                               const uint32_t tz_index,
+                               const uint32_t speed,
+                               Cost& transition_cost,
+                               Cost& newcost) const {
+    if (!Allowed(edge, pred, tile, edgeid, current_time, tz_index)) {
+      return false;
+    }
+    transition_cost = TransitionCost(edge, node, pred);
+    newcost = pred.cost() + transition_cost + EdgeCost(edge, speed);
+    return true;
+  }
+
+  /**
+   * Evaluate an edge for reverse expansion in a single virtual dispatch:
+   * check access and, if allowed, compute the transition cost and the new
+   * cost to the end of the edge. As with EvaluateForward, concrete costings
+   * override this to forward to EvaluateReverseImpl. Only the monetary part
+   * of the transition cost is added to the new cost so the elapsed time can
+   * be properly recovered on the reverse path.
+   * @param  edge            Pointer to a directed edge.
+   * @param  pred            Predecessor edge information.
+   * @param  opp_edge        Pointer to the opposing directed edge.
+   * @param  node            Node (intersection) where the transition occurs.
+   * @param  opp_pred_edge   Pointer to the opposing predecessor edge.
+   * @param  tile            Tile of the opposing edge.
+   * @param  opp_edgeid      GraphId of the opposing edge.
+   * @param  current_time    Current time (seconds since epoch). A value of 0
+   *                         indicates the route is not time dependent.
+   * @param  tz_index        timezone index for the node
+   * @param  speed           Speed to cost the opposing edge with.
+   * @param  transition_cost Set to the cost of transitioning onto the edge.
+   * @param  newcost         Set to the cost to the end of the edge.
+   * @return Returns true if access is allowed and the costs were computed.
+   */
+  virtual bool EvaluateReverse(const baldr::DirectedEdge* edge,
+                               const EdgeLabel& pred,
+                               const baldr::DirectedEdge* opp_edge,
+                               const baldr::NodeInfo* node,
+                               const baldr::DirectedEdge* opp_pred_edge,
+                               const baldr::GraphTile*& tile,
+                               const baldr::GraphId& opp_edgeid,
+                               const uint64_t current_time,
+                               const uint32_t tz_index,
+                               const uint32_t speed,
+                               Cost& transition_cost,
+                               Cost& newcost) const {
+    if (!AllowedReverse(edge, pred, opp_edge, tile, opp_edgeid, current_time, tz_index)) {
+      return false;
+    }
+    transition_cost = TransitionCostReverse(edge->localedgeidx(), node, opp_edge, opp_pred_edge);
+    newcost = pred.cost() + EdgeCost(opp_edge, speed);
+    newcost.cost += transition_cost.cost;
+    return true;
+  }
+
   /**
    * Test if an edge should be restricted due to a complex restriction.
    * @param  edge  Directed edge.
@@ -449,6 +549,23 @@ public:
    */
   void RelaxHierarchyLimits(const float factor, const float expansion_within_factor);
 
+  /**
+   * Snapshot the per request mutable state (pass number, transit connection
+   * and destination only flags, travel mode, and hierarchy limits) as the
+   * defaults for this costing. Multi-pass routing and multimodal expansion
+   * mutate this state on the cost object, so a pooled costing must capture
+   * its constructed state before being handed to a request. Must be called
+   * after the most derived constructor has run - some costings adjust their
+   * hierarchy limits during construction.
+   */
+  void SnapshotDefaultState();
+
+  /**
+   * Restore the per request mutable state captured by SnapshotDefaultState
+   * so a pooled costing behaves as if it was newly constructed.
+   */
+  void RestoreDefaultState();
+
   /**
    * Checks if we should exclude or not.
    */
@@ -476,14 +593,25 @@ public:
   void AddUserAvoidEdges(const std::vector<baldr::GraphId>& avoid_edges);
 
   /**
-   * Check if the edge is in the user-specified avoid list.
+   * Check if the edge is in the user-specified avoid list. The avoid list
+   * is compiled into a bitmap of edge indexes per tile when it is added,
+   * so this is one hash of the tile base and a bit test no matter how many
+   * edges are avoided.
    * @param  edgeid  Directed edge Id.
    * @return Returns true if the edge Id is in the user avoid edges set,
    *         false otherwise.
    */
   bool IsUserAvoidEdge(const baldr::GraphId& edgeid) const {
-    return (user_avoid_edges_.size() != 0 &&
-            user_avoid_edges_.find(edgeid) != user_avoid_edges_.end());
+    if (user_avoid_edges_.empty()) {
+      return false;
+    }
+    const auto tile = user_avoid_edges_.find(edgeid.Tile_Base().value);
+    if (tile == user_avoid_edges_.end()) {
+      return false;
+    }
+    const uint64_t id = edgeid.id();
+    return (id >> 6) < tile->second.size() &&
+           (tile->second[id >> 6] & (uint64_t(1) << (id & 63))) != 0;
   }
 
 protected:
@@ -504,8 +632,24 @@ protected:
   // Hierarchy limits.
   std::vector<HierarchyLimits> hierarchy_limits_;
 
-  // User specified edges to avoid
-  std::unordered_set<baldr::GraphId> user_avoid_edges_;
+  // User specified edges to avoid, held as a bitmap over edge indexes per
+  // tile so lookups in the expansion hot loop stay constant time even with
+  // hundreds of simultaneous closures
+  std::unordered_map<uint64_t, std::vector<uint64_t>> user_avoid_edges_;
+
+  /**
+   * Set the bit for a single avoided edge in its tile's bitmap.
+   * @param  edgeid  Directed edge Id to avoid.
+   */
+  void AddUserAvoidEdge(const baldr::GraphId& edgeid);
+
+  // The constructed values of the per request mutable state, captured by
+  // SnapshotDefaultState so a pooled costing can be reset between requests
+  uint32_t default_pass_;
+  bool default_allow_transit_connections_;
+  bool default_allow_destination_only_;
+  TravelMode default_travel_mode_;
+  std::vector<HierarchyLimits> default_hierarchy_limits_;
 
   // Weighting to apply to ferry edges
   float ferry_factor_;
@@ -578,7 +722,7 @@ protected:
                                          const uint32_t idx) const {
     // Cases with both time and penalty: country crossing, ferry, gate, toll booth
     sif::Cost c;
-    if (node->type() == baldr::NodeType::kBorderControl) {
+    if (node->type() == baldr::NodeType::kBorderControl || edge->ctry_crossing()) {
       c += country_crossing_cost_;
     }
     if (node->type() == baldr::NodeType::kGate) {
@@ -621,7 +765,7 @@ protected:
                                          const uint32_t idx) const {
     // Cases with both time and penalty: country crossing, ferry, gate, toll booth
     sif::Cost c;
-    if (node->type() == baldr::NodeType::kBorderControl) {
+    if (node->type() == baldr::NodeType::kBorderControl || edge->ctry_crossing()) {
       c += country_crossing_cost_;
     }
     if (node->type() == baldr::NodeType::kGate) {
@@ -659,6 +803,63 @@ protected:
   }
 };
 
+/**
+ * Statically bound implementation of DynamicCost::EvaluateForward for a
+ * concrete costing. Instantiated with the concrete type the qualified calls
+ * below bypass the vtable, so a costing forwarding its override here pays a
+ * single virtual dispatch per edge and has its access check and cost math
+ * inlined. Costings derived from another costing must forward their own
+ * override so their method overrides are bound, not their base's.
+ */
+template <typename costing_t>
+bool EvaluateForwardImpl(const costing_t& costing,
+                         const baldr::DirectedEdge* edge,
+                         const baldr::NodeInfo* node,
+                         const EdgeLabel& pred,
+                         const baldr::GraphTile*& tile,
+                         const baldr::GraphId& edgeid,
+                         const uint64_t current_time,
+                         const uint32_t tz_index,
+                         const uint32_t speed,
+                         Cost& transition_cost,
+                         Cost& newcost) {
+  if (!costing.costing_t::Allowed(edge, pred, tile, edgeid, current_time, tz_index)) {
+    return false;
+  }
+  transition_cost = costing.costing_t::TransitionCost(edge, node, pred);
+  newcost = pred.cost() + transition_cost + costing.costing_t::EdgeCost(edge, speed);
+  return true;
+}
+
+/**
+ * Statically bound implementation of DynamicCost::EvaluateReverse for a
+ * concrete costing, see EvaluateForwardImpl.
+ */
+template <typename costing_t>
+bool EvaluateReverseImpl(const costing_t& costing,
+                         const baldr::DirectedEdge* edge,
+                         const EdgeLabel& pred,
+                         const baldr::DirectedEdge* opp_edge,
+                         const baldr::NodeInfo* node,
+                         const baldr::DirectedEdge* opp_pred_edge,
+                         const baldr::GraphTile*& tile,
+                         const baldr::GraphId& opp_edgeid,
+                         const uint64_t current_time,
+                         const uint32_t tz_index,
+                         const uint32_t speed,
+                         Cost& transition_cost,
+                         Cost& newcost) {
+  if (!costing.costing_t::AllowedReverse(edge, pred, opp_edge, tile, opp_edgeid, current_time,
+                                         tz_index)) {
+    return false;
+  }
+  transition_cost =
+      costing.costing_t::TransitionCostReverse(edge->localedgeidx(), node, opp_edge, opp_pred_edge);
+  newcost = pred.cost() + costing.costing_t::EdgeCost(opp_edge, speed);
+  newcost.cost += transition_cost.cost;
+  return true;
+}
+
 typedef std::shared_ptr<DynamicCost> cost_ptr_t;
 
 } // namespace sif
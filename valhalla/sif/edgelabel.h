@@ -51,14 +51,14 @@ public:
             const float dist,
             const TravelMode mode,
             const uint32_t path_distance)
-      : predecessor_(predecessor), path_distance_(path_distance), restrictions_(edge->restrictions()),
-        edgeid_(edgeid), opp_index_(edge->opp_index()), opp_local_idx_(edge->opp_local_idx()),
+      : predecessor_(predecessor), sortcost_(sortcost), cost_(cost), distance_(dist),
+        path_distance_(path_distance), restrictions_(edge->restrictions()), edgeid_(edgeid),
+        opp_index_(edge->opp_index()), opp_local_idx_(edge->opp_local_idx()),
         mode_(static_cast<uint32_t>(mode)), endnode_(edge->endnode()),
         use_(static_cast<uint32_t>(edge->use())),
         classification_(static_cast<uint32_t>(edge->classification())), shortcut_(edge->shortcut()),
         dest_only_(edge->destonly()), origin_(0), toll_(edge->toll()), not_thru_(edge->not_thru()),
-        deadend_(edge->deadend()), on_complex_rest_(edge->part_of_complex_restriction()), cost_(cost),
-        sortcost_(sortcost), distance_(dist) {
+        deadend_(edge->deadend()), on_complex_rest_(edge->part_of_complex_restriction()) {
   }
 
   /**
@@ -294,11 +294,23 @@ public:
   }
 
 protected:
+  // The members below are the ones read and written when a temporarily
+  // labeled edge is reached again with a lower cost (the common revisit in
+  // the expansion loops). They are kept together at the front of the label
+  // so that a revisit usually touches a single cache line; the remaining
+  // members are only read when an edge is first labeled or when the path is
+  // formed. The adjacency list keeps its own copy of the sort cost so queue
+  // operations do not touch the labels at all.
+
   // predecessor_: Index to the predecessor edge label information.
   // Note: invalid predecessor value uses all 32 bits (so if this needs to
   // be part of a bit field make sure kInvalidLabel is changed.
   uint32_t predecessor_;
 
+  float sortcost_; // Sort cost - includes A* heuristic.
+  Cost cost_;      // Cost and elapsed time along the path.
+  float distance_; // Distance to the destination.
+
   // path_distance_: Accumulated path distance in meters.
   // restriction_:   Bit mask of edges (by local edge index at the end node)
   //                 that are restricted (simple turn restrictions)
@@ -342,10 +354,6 @@ protected:
   uint64_t not_thru_ : 1;
   uint64_t deadend_ : 1;
   uint64_t on_complex_rest_ : 1;
-
-  Cost cost_;      // Cost and elapsed time along the path.
-  float sortcost_; // Sort cost - includes A* heuristic.
-  float distance_; // Distance to the destination.
 };
 
 /**
@@ -645,6 +653,25 @@ protected:
   uint32_t has_transit_ : 1;
 };
 
+// Edge label vectors act as per-request arenas: their allocation is kept
+// between requests so labels are recycled rather than reallocated. Cap how
+// much memory one oversized request can leave reserved on a worker.
+constexpr size_t kMaxReservedLabelCount = 1000000;
+
+/**
+ * Clear a label vector but keep a bounded amount of its allocation around
+ * for the next request to reuse.
+ * @param labels  the edge label vector to clear
+ */
+template <typename label_t> void ClearLabels(std::vector<label_t>& labels) {
+  if (labels.capacity() > kMaxReservedLabelCount) {
+    std::vector<label_t>().swap(labels);
+    labels.reserve(kMaxReservedLabelCount);
+  } else {
+    labels.clear();
+  }
+}
+
 } // namespace sif
 } // namespace valhalla
 
@@ -1,6 +1,7 @@
 #ifndef VALHALLA_SIF_HIERARCHYLIMITS_H_
 #define VALHALLA_SIF_HIERARCHYLIMITS_H_
 
+#include <algorithm>
 #include <boost/property_tree/ptree.hpp>
 #include <limits>
 
@@ -22,6 +23,12 @@ constexpr uint32_t kDefaultMaxUpTransitions[] = {0, 400, 100, 0, 0, 0, 0, 0};
 // (per level). Used only for A*.
 constexpr float kDefaultExpansionWithinDist[] = {kMaxDistance, 100000.0f, 5000.0f, 0.0f,
                                                  0.0f,         0.0f,      0.0f,    0.0f};
+
+// Distance over which the default transition counts are fully used and the
+// smallest fraction shorter routes are scaled down to when transitions are
+// scaled by the origin to destination distance.
+constexpr float kFullTransitionsDistance = 100000.0f; // 100 km
+constexpr float kMinTransitionsFactor = 0.25f;
 } // namespace
 
 namespace valhalla {
@@ -80,6 +87,36 @@ struct HierarchyLimits {
     return up_transition_count > max_up_transitions;
   }
 
+  /**
+   * Scale the maximum upward transitions by the origin to destination
+   * distance. Short routes gain little from many transitions onto the
+   * higher levels, yet the defaults allow a dense metro to spend them all
+   * near the origin, so the counts shrink with the distance. A floor keeps
+   * enough transitions to escape the local neighborhood and levels with
+   * unlimited transitions are not scaled.
+   * @param  distance  Straight line origin to destination distance (meters).
+   */
+  void ScaleMaxUpTransitions(const float distance) {
+    if (max_up_transitions != kUnlimitedTransitions && max_up_transitions > 0) {
+      float factor =
+          std::min(1.0f, std::max(kMinTransitionsFactor, distance / kFullTransitionsDistance));
+      max_up_transitions *= factor;
+    }
+  }
+
+  /**
+   * Scale the maximum upward transitions by an arbitrary factor. Used when
+   * measured tile statistics show the local graph is dense enough to reach
+   * the upper levels with a smaller budget. Levels with unlimited
+   * transitions are not scaled.
+   * @param  factor  Factor to scale the transition count by.
+   */
+  void ScaleByFactor(const float factor) {
+    if (max_up_transitions != kUnlimitedTransitions && max_up_transitions > 0) {
+      max_up_transitions *= factor;
+    }
+  }
+
   /**
    * Relax hierarchy limits to try to find a route when initial attempt fails.
    * Do not relax limits if they are unlimited (bicycle and pedestrian for
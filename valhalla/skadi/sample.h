@@ -2,12 +2,15 @@
 #define __VALHALLA_SAMPLE_H__
 
 #include <cstdint>
+#include <functional>
+#include <list>
 #include <memory>
 #include <string>
 #include <unordered_map>
 #include <utility>
 #include <vector>
 
+#include <valhalla/midgard/pointll.h>
 #include <valhalla/midgard/sequence.h>
 
 namespace valhalla {
@@ -40,6 +43,27 @@ public:
    */
   template <class coords_t> std::vector<double> get_all(const coords_t& coords) const;
 
+  /**
+   * Resample a polyline at a fixed resolution, sampling the datasource at
+   * each generated posting and accumulating the distance walked as it goes.
+   * This fuses midgard::resample_spherical_polyline, get_all and the range
+   * computation into a single pass so the caller never has to materialize
+   * the resampled shape before sampling it. The first and last input points
+   * are always kept
+   * @param polyline    the shape to resample
+   * @param resolution  meters between generated postings
+   * @param emit        called with each generated posting, in order
+   * @param heights     filled with the sampled value at each posting
+   * @param ranges      when not null, filled with the cumulative great circle
+   *                    distance in meters along the shape at each posting
+   */
+  template <class coords_t>
+  void get_resampled(const coords_t& polyline,
+                     double resolution,
+                     const std::function<void(const midgard::PointLL&)>& emit,
+                     std::vector<double>& heights,
+                     std::vector<float>* ranges) const;
+
   /**
    * @return the no data value for this data source
    */
@@ -66,9 +90,11 @@ protected:
   // using memory maps
   mutable std::vector<std::pair<format_t, midgard::mem_map<char>>> mapped_cache;
 
-  // TODO: make an LRU
-  using unzipped_t = std::pair<int16_t, std::vector<int16_t>>;
-  mutable unzipped_t unzipped_cache;
+  // most recently used unzipped tiles at the front, bounds how many decoded
+  // tiles are held resident at once while raw tiles stay on their mappings
+  using unzipped_t = std::pair<uint16_t, std::vector<int16_t>>;
+  mutable std::list<unzipped_t> unzipped_cache;
+  mutable std::unordered_map<uint16_t, std::list<unzipped_t>::iterator> unzipped_index;
 
   std::string data_source;
 };
@@ -0,0 +1,142 @@
+#ifndef VALHALLA_THOR_ALTHEURISTIC_H_
+#define VALHALLA_THOR_ALTHEURISTIC_H_
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include <valhalla/thor/astarheuristic.h>
+
+namespace valhalla {
+namespace thor {
+
+// Marks a node a landmark table does not cover
+constexpr float kUncoveredByLandmark = -1.0f;
+
+/**
+ * ALT (A*, landmarks, triangle inequality) cost heuristic. A small set of
+ * landmark nodes with precomputed shortest path costs to and from every
+ * covered node yields the lower bound
+ *   h(v) = max over landmarks L of
+ *          max(cost(v,L) - cost(t,L), cost(L,t) - cost(L,v), 0)
+ * which is admissible and usually much tighter than the straight-line
+ * distance bound, especially where the graph meanders (mountains, fjords,
+ * river crossings).
+ *
+ * The landmark tables are computed offline for one costing snapshot (two
+ * Dijkstra passes per landmark, one forward and one reverse) and keyed by
+ * node graphid value. Nodes missing from a table simply do not contribute;
+ * the heuristic falls back to the distance based bound, so the result is
+ * always at least as tight as plain A*.
+ */
+class ALTHeuristic {
+public:
+  // Precomputed shortest path costs for one landmark
+  struct landmark_t {
+    // cost from the landmark to each node
+    std::unordered_map<uint64_t, float> from_landmark;
+    // cost from each node to the landmark
+    std::unordered_map<uint64_t, float> to_landmark;
+  };
+
+  /**
+   * Constructor.
+   */
+  ALTHeuristic() : target_(0) {
+  }
+
+  /**
+   * Hand the heuristic its landmark tables. Shared so many searches can
+   * use the same tables concurrently.
+   * @param  landmarks  precomputed landmark cost tables
+   */
+  void SetLandmarks(const std::shared_ptr<const std::vector<landmark_t>>& landmarks) {
+    landmarks_ = landmarks;
+  }
+
+  /**
+   * Sets the destination. The distance fallback is initialized with the
+   * same arguments as the plain heuristic; the landmark bounds to the
+   * target are cached per landmark.
+   * @param  target  Graphid value of the destination node.
+   * @param  ll      Latitude, longitude (in degrees) of the destination.
+   * @param  factor  Costing factor for the distance fallback.
+   */
+  void Init(const uint64_t target, const midgard::PointLL& ll, const float factor) {
+    fallback_.Init(ll, factor);
+    target_ = target;
+    target_bounds_.clear();
+    if (landmarks_) {
+      target_bounds_.reserve(landmarks_->size());
+      for (const auto& landmark : *landmarks_) {
+        auto to = landmark.to_landmark.find(target);
+        auto from = landmark.from_landmark.find(target);
+        target_bounds_.push_back(
+            {to == landmark.to_landmark.end() ? kUncoveredByLandmark : to->second,
+             from == landmark.from_landmark.end() ? kUncoveredByLandmark : from->second});
+      }
+    }
+  }
+
+  /**
+   * Get the distance to the destination, delegated to the distance
+   * approximator so callers can keep using it for termination tests.
+   * @param   ll  Current latitude, longitude.
+   * @return  Returns the distance to the destination.
+   */
+  float GetDistance(const midgard::PointLL& ll) const {
+    return fallback_.GetDistance(ll);
+  }
+
+  /**
+   * Get the ALT heuristic for a node. Takes the best landmark bound and
+   * never returns less than the distance based fallback, so the estimate
+   * stays admissible and at least as tight as plain A*.
+   * @param   node  Graphid value of the current node.
+   * @param   ll    Lat,lng of the current node (for the fallback).
+   * @return  Returns an estimate of the cost to the destination.
+   */
+  float Get(const uint64_t node, const midgard::PointLL& ll) const {
+    float bound = fallback_.Get(ll);
+    if (!landmarks_) {
+      return bound;
+    }
+    for (size_t i = 0; i < landmarks_->size(); ++i) {
+      const auto& landmark = (*landmarks_)[i];
+      const auto& target_bound = target_bounds_[i];
+      // cost(v, L) - cost(t, L)
+      if (target_bound.first != kUncoveredByLandmark) {
+        auto to = landmark.to_landmark.find(node);
+        if (to != landmark.to_landmark.end() && to->second - target_bound.first > bound) {
+          bound = to->second - target_bound.first;
+        }
+      }
+      // cost(L, t) - cost(L, v)
+      if (target_bound.second != kUncoveredByLandmark) {
+        auto from = landmark.from_landmark.find(node);
+        if (from != landmark.from_landmark.end() && target_bound.second - from->second > bound) {
+          bound = target_bound.second - from->second;
+        }
+      }
+    }
+    return bound;
+  }
+
+private:
+  // The landmark tables, shared across searches
+  std::shared_ptr<const std::vector<landmark_t>> landmarks_;
+
+  // Distance based heuristic used as an admissible floor and for nodes
+  // the landmark tables do not cover
+  AStarHeuristic fallback_;
+
+  // The destination node and the cached per-landmark costs to/from it
+  uint64_t target_;
+  std::vector<std::pair<float, float>> target_bounds_;
+};
+
+} // namespace thor
+} // namespace valhalla
+
+#endif // VALHALLA_THOR_ALTHEURISTIC_H_
@@ -74,6 +74,13 @@ public:
     max_label_count_ = max_count;
   }
 
+  /**
+   * Returns the number of edge labels the last path computation allocated.
+   */
+  virtual uint64_t expanded_label_count() const override {
+    return edgelabels_.size();
+  }
+
 protected:
   uint32_t max_label_count_; // Max label count to allow
   sif::TravelMode mode_;     // Current travel mode
@@ -100,6 +107,69 @@ protected:
   // Destinations, id and cost
   std::map<uint64_t, sif::Cost> destinations_;
 
+  // Cost lower bounds from nodes to the search target, formed by a bounded
+  // Dijkstra over a lower bound graph (edge lengths scaled by the costing's
+  // admissible cost factor). Used by the time dependent algorithms to guide
+  // the search with tighter bounds than the straight line heuristic.
+  std::unordered_map<uint64_t, float> node_bounds_;
+
+  // Lower bound for any node not settled by the bounding search. All settled
+  // nodes have a bound at or below this and all others at or above it.
+  float bound_horizon_;
+
+  // Per request memo of predicted speeds, keyed by edge Id and 5 minute time
+  // bucket. Decompressing the DCT encoded speed profile is costly and edges
+  // are commonly relaxed several times within the same bucket.
+  std::unordered_map<uint64_t, uint32_t> speed_memo_;
+
+  /**
+   * Form cost lower bounds around the search target by running a bounded
+   * Dijkstra over the lower bound graph: every directed edge is relaxed in
+   * both directions with weight length * AStarCostFactor(), ignoring access
+   * restrictions. Dropping restrictions and direction can only shorten
+   * distances, so the bounds remain admissible for the real search, while
+   * network distances are tighter than the straight line heuristic. The
+   * search settles a fixed budget of nodes; nodes beyond it are bounded by
+   * the cost horizon where the search stopped (which keeps the combined
+   * bound consistent, so the guided search stays exact).
+   * @param  graphreader  Graph tile reader.
+   * @param  target       Location the real search is heading towards (the
+   *                      destination for a forward search, the origin for a
+   *                      reverse search).
+   */
+  void ComputeLowerBounds(baldr::GraphReader& graphreader, const odin::Location& target);
+
+  /**
+   * Get the speed for an edge at a time of the week, memoizing decompressed
+   * predicted speeds per edge and 5 minute bucket for the current request.
+   * Edges without a predicted speed profile bypass the memo.
+   * @param  tile             Graph tile holding the edge.
+   * @param  de               Directed edge information.
+   * @param  edgeid           Graph Id of the edge.
+   * @param  seconds_of_week  Seconds from start of the week (local time).
+   * @return Returns the speed for the edge.
+   */
+  uint32_t MemoizedSpeed(const baldr::GraphTile* tile,
+                         const baldr::DirectedEdge* de,
+                         const baldr::GraphId& edgeid,
+                         const uint32_t seconds_of_week);
+
+  /**
+   * Get the cost lower bound from a node to the search target - the guided
+   * bound from the bounding search when one was formed, never less than the
+   * straight line heuristic.
+   * @param  node       Graph Id of the node.
+   * @param  heuristic  Straight line A* heuristic cost for the node.
+   * @return Returns the lower bound to add to the sort cost.
+   */
+  float SortCostBound(const baldr::GraphId& node, const float heuristic) const {
+    if (node_bounds_.empty()) {
+      return heuristic;
+    }
+    auto bound = node_bounds_.find(node.value);
+    return std::max(heuristic, bound != node_bounds_.end() ? bound->second : bound_horizon_);
+  }
+
   /**
    * Initializes the hierarchy limits, A* heuristic, and adjacency list.
    * @param  origll  Lat,lng of the origin.
@@ -7,115 +7,169 @@
 namespace valhalla {
 namespace thor {
 
+/**
+ * Attribute groups. Each group holds at most 64 attributes so the enabled
+ * set of a whole group compiles down to a single uint64_t.
+ */
+constexpr size_t kEdgeGroup = 0;
+constexpr size_t kNodeGroup = 1;
+constexpr size_t kCommonGroup = 2; // top level, admin and matched keys
+constexpr size_t kGroupCount = 3;
+
+/**
+ * An attribute key: the request facing name plus a precompiled position in
+ * the controller's per group bit masks, so the trip path builder loops can
+ * test whether an attribute is wanted with a single AND instead of a hash
+ * map lookup per attribute per edge.
+ */
+struct Attribute {
+  std::string name;
+  size_t group;
+  uint64_t mask;
+
+  // the name still acts as the key anywhere a string is expected
+  operator const std::string&() const {
+    return name;
+  }
+};
+
 // Edge keys
-const std::string kEdgeNames = "edge.names";
-const std::string kEdgeLength = "edge.length";
-const std::string kEdgeSpeed = "edge.speed";
-const std::string kEdgeRoadClass = "edge.road_class";
-const std::string kEdgeBeginHeading = "edge.begin_heading";
-const std::string kEdgeEndHeading = "edge.end_heading";
-const std::string kEdgeBeginShapeIndex = "edge.begin_shape_index";
-const std::string kEdgeEndShapeIndex = "edge.end_shape_index";
-const std::string kEdgeTraversability = "edge.traversability";
-const std::string kEdgeUse = "edge.use";
-const std::string kEdgeToll = "edge.toll";
-const std::string kEdgeUnpaved = "edge.unpaved";
-const std::string kEdgeTunnel = "edge.tunnel";
-const std::string kEdgeBridge = "edge.bridge";
-const std::string kEdgeRoundabout = "edge.roundabout";
-const std::string kEdgeInternalIntersection = "edge.internal_intersection";
-const std::string kEdgeDriveOnRight = "edge.drive_on_right";
-const std::string kEdgeSurface = "edge.surface";
-const std::string kEdgeSignExitNumber = "edge.sign.exit_number";
-const std::string kEdgeSignExitBranch = "edge.sign.exit_branch";
-const std::string kEdgeSignExitToward = "edge.sign.exit_toward";
-const std::string kEdgeSignExitName = "edge.sign.exit_name";
-const std::string kEdgeTravelMode = "edge.travel_mode";
-const std::string kEdgeVehicleType = "edge.vehicle_type";
-const std::string kEdgePedestrianType = "edge.pedestrian_type";
-const std::string kEdgeBicycleType = "edge.bicycle_type";
-const std::string kEdgeTransitType = "edge.transit_type";
-const std::string kEdgeTransitRouteInfoOnestopId = "edge.transit_route_info.onestop_id";
-const std::string kEdgeTransitRouteInfoBlockId = "edge.transit_route_info.block_id";
-const std::string kEdgeTransitRouteInfoTripId = "edge.transit_route_info.trip_id";
-const std::string kEdgeTransitRouteInfoShortName = "edge.transit_route_info.short_name";
-const std::string kEdgeTransitRouteInfoLongName = "edge.transit_route_info.long_name";
-const std::string kEdgeTransitRouteInfoHeadsign = "edge.transit_route_info.headsign";
-const std::string kEdgeTransitRouteInfoColor = "edge.transit_route_info.color";
-const std::string kEdgeTransitRouteInfoTextColor = "edge.transit_route_info.text_color";
-const std::string kEdgeTransitRouteInfoDescription = "edge.transit_route_info.description";
-const std::string kEdgeTransitRouteInfoOperatorOnestopId =
-    "edge.transit_route_info.operator_onestop_id";
-const std::string kEdgeTransitRouteInfoOperatorName = "edge.transit_route_info.operator_name";
-const std::string kEdgeTransitRouteInfoOperatorUrl = "edge.transit_route_info.operator_url";
-const std::string kEdgeId = "edge.id";
-const std::string kEdgeWayId = "edge.way_id";
-const std::string kEdgeWeightedGrade = "edge.weighted_grade";
-const std::string kEdgeMaxUpwardGrade = "edge.max_upward_grade";
-const std::string kEdgeMaxDownwardGrade = "edge.max_downward_grade";
-const std::string kEdgeMeanElevation = "edge.mean_elevation";
-const std::string kEdgeLaneCount = "edge.lane_count";
-const std::string kEdgeLaneConnectivity = "edge.lane_connectivity";
-const std::string kEdgeCycleLane = "edge.cycle_lane";
-const std::string kEdgeBicycleNetwork = "edge.bicycle_network";
-const std::string kEdgeSidewalk = "edge.sidewalk";
-const std::string kEdgeDensity = "edge.density";
-const std::string kEdgeSpeedLimit = "edge.speed_limit";
-const std::string kEdgeTruckSpeed = "edge.truck_speed";
-const std::string kEdgeTruckRoute = "edge.truck_route";
+const Attribute kEdgeNames{"edge.names", kEdgeGroup, 1ULL << 0};
+const Attribute kEdgeLength{"edge.length", kEdgeGroup, 1ULL << 1};
+const Attribute kEdgeSpeed{"edge.speed", kEdgeGroup, 1ULL << 2};
+const Attribute kEdgeRoadClass{"edge.road_class", kEdgeGroup, 1ULL << 3};
+const Attribute kEdgeBeginHeading{"edge.begin_heading", kEdgeGroup, 1ULL << 4};
+const Attribute kEdgeEndHeading{"edge.end_heading", kEdgeGroup, 1ULL << 5};
+const Attribute kEdgeBeginShapeIndex{"edge.begin_shape_index", kEdgeGroup, 1ULL << 6};
+const Attribute kEdgeEndShapeIndex{"edge.end_shape_index", kEdgeGroup, 1ULL << 7};
+const Attribute kEdgeTraversability{"edge.traversability", kEdgeGroup, 1ULL << 8};
+const Attribute kEdgeUse{"edge.use", kEdgeGroup, 1ULL << 9};
+const Attribute kEdgeToll{"edge.toll", kEdgeGroup, 1ULL << 10};
+const Attribute kEdgeUnpaved{"edge.unpaved", kEdgeGroup, 1ULL << 11};
+const Attribute kEdgeTunnel{"edge.tunnel", kEdgeGroup, 1ULL << 12};
+const Attribute kEdgeBridge{"edge.bridge", kEdgeGroup, 1ULL << 13};
+const Attribute kEdgeRoundabout{"edge.roundabout", kEdgeGroup, 1ULL << 14};
+const Attribute kEdgeInternalIntersection{"edge.internal_intersection", kEdgeGroup, 1ULL << 15};
+const Attribute kEdgeDriveOnRight{"edge.drive_on_right", kEdgeGroup, 1ULL << 16};
+const Attribute kEdgeSurface{"edge.surface", kEdgeGroup, 1ULL << 17};
+const Attribute kEdgeSignExitNumber{"edge.sign.exit_number", kEdgeGroup, 1ULL << 18};
+const Attribute kEdgeSignExitBranch{"edge.sign.exit_branch", kEdgeGroup, 1ULL << 19};
+const Attribute kEdgeSignExitToward{"edge.sign.exit_toward", kEdgeGroup, 1ULL << 20};
+const Attribute kEdgeSignExitName{"edge.sign.exit_name", kEdgeGroup, 1ULL << 21};
+const Attribute kEdgeTravelMode{"edge.travel_mode", kEdgeGroup, 1ULL << 22};
+const Attribute kEdgeVehicleType{"edge.vehicle_type", kEdgeGroup, 1ULL << 23};
+const Attribute kEdgePedestrianType{"edge.pedestrian_type", kEdgeGroup, 1ULL << 24};
+const Attribute kEdgeBicycleType{"edge.bicycle_type", kEdgeGroup, 1ULL << 25};
+const Attribute kEdgeTransitType{"edge.transit_type", kEdgeGroup, 1ULL << 26};
+const Attribute kEdgeTransitRouteInfoOnestopId{
+    "edge.transit_route_info.onestop_id", kEdgeGroup, 1ULL << 27};
+const Attribute kEdgeTransitRouteInfoBlockId{
+    "edge.transit_route_info.block_id", kEdgeGroup, 1ULL << 28};
+const Attribute kEdgeTransitRouteInfoTripId{
+    "edge.transit_route_info.trip_id", kEdgeGroup, 1ULL << 29};
+const Attribute kEdgeTransitRouteInfoShortName{
+    "edge.transit_route_info.short_name", kEdgeGroup, 1ULL << 30};
+const Attribute kEdgeTransitRouteInfoLongName{
+    "edge.transit_route_info.long_name", kEdgeGroup, 1ULL << 31};
+const Attribute kEdgeTransitRouteInfoHeadsign{
+    "edge.transit_route_info.headsign", kEdgeGroup, 1ULL << 32};
+const Attribute kEdgeTransitRouteInfoColor{"edge.transit_route_info.color", kEdgeGroup, 1ULL << 33};
+const Attribute kEdgeTransitRouteInfoTextColor{
+    "edge.transit_route_info.text_color", kEdgeGroup, 1ULL << 34};
+const Attribute kEdgeTransitRouteInfoDescription{
+    "edge.transit_route_info.description", kEdgeGroup, 1ULL << 35};
+const Attribute kEdgeTransitRouteInfoOperatorOnestopId{
+    "edge.transit_route_info.operator_onestop_id", kEdgeGroup, 1ULL << 36};
+const Attribute kEdgeTransitRouteInfoOperatorName{
+    "edge.transit_route_info.operator_name", kEdgeGroup, 1ULL << 37};
+const Attribute kEdgeTransitRouteInfoOperatorUrl{
+    "edge.transit_route_info.operator_url", kEdgeGroup, 1ULL << 38};
+const Attribute kEdgeId{"edge.id", kEdgeGroup, 1ULL << 39};
+const Attribute kEdgeWayId{"edge.way_id", kEdgeGroup, 1ULL << 40};
+const Attribute kEdgeWeightedGrade{"edge.weighted_grade", kEdgeGroup, 1ULL << 41};
+const Attribute kEdgeMaxUpwardGrade{"edge.max_upward_grade", kEdgeGroup, 1ULL << 42};
+const Attribute kEdgeMaxDownwardGrade{"edge.max_downward_grade", kEdgeGroup, 1ULL << 43};
+const Attribute kEdgeMeanElevation{"edge.mean_elevation", kEdgeGroup, 1ULL << 44};
+const Attribute kEdgeLaneCount{"edge.lane_count", kEdgeGroup, 1ULL << 45};
+const Attribute kEdgeLaneConnectivity{"edge.lane_connectivity", kEdgeGroup, 1ULL << 46};
+const Attribute kEdgeCycleLane{"edge.cycle_lane", kEdgeGroup, 1ULL << 47};
+const Attribute kEdgeBicycleNetwork{"edge.bicycle_network", kEdgeGroup, 1ULL << 48};
+const Attribute kEdgeSidewalk{"edge.sidewalk", kEdgeGroup, 1ULL << 49};
+const Attribute kEdgeDensity{"edge.density", kEdgeGroup, 1ULL << 50};
+const Attribute kEdgeSpeedLimit{"edge.speed_limit", kEdgeGroup, 1ULL << 51};
+const Attribute kEdgeTruckSpeed{"edge.truck_speed", kEdgeGroup, 1ULL << 52};
+const Attribute kEdgeTruckRoute{"edge.truck_route", kEdgeGroup, 1ULL << 53};
+const Attribute kEdgeNameConsistency{"edge.name_consistency", kEdgeGroup, 1ULL << 54};
 
 // Node keys
-const std::string kNodeIntersectingEdgeBeginHeading = "node.intersecting_edge.begin_heading";
-const std::string kNodeIntersectingEdgeFromEdgeNameConsistency =
-    "node.intersecting_edge.from_edge_name_consistency";
-const std::string kNodeIntersectingEdgeToEdgeNameConsistency =
-    "node.intersecting_edge.to_edge_name_consistency";
-const std::string kNodeIntersectingEdgeDriveability = "node.intersecting_edge.driveability";
-const std::string kNodeIntersectingEdgeCyclability = "node.intersecting_edge.cyclability";
-const std::string kNodeIntersectingEdgeWalkability = "node.intersecting_edge.walkability";
-const std::string kNodeElapsedTime = "node.elapsed_time";
-const std::string kNodeaAdminIndex = "node.admin_index";
-const std::string kNodeType = "node.type";
-const std::string kNodeFork = "node.fork";
-const std::string kNodeTransitPlatformInfoType = "node.transit_platform_info.type";
-const std::string kNodeTransitPlatformInfoOnestopId = "node.transit_platform_info.onestop_id";
-const std::string kNodeTransitPlatformInfoName = "node.transit_platform_info.name";
-const std::string kNodeTransitPlatformInfoStationOnestopId =
-    "node.transit_platform_info.station_onestop_id";
-const std::string kNodeTransitPlatformInfoStationName = "node.transit_platform_info.station_name";
-const std::string kNodeTransitPlatformInfoArrivalDateTime =
-    "node.transit_platform_info.arrival_date_time";
-const std::string kNodeTransitPlatformInfoDepartureDateTime =
-    "node.transit_platform_info.departure_date_time";
-const std::string kNodeTransitPlatformInfoIsParentStop = "node.transit_platform_info.is_parent_stop";
-const std::string kNodeTransitPlatformInfoAssumedSchedule =
-    "node.transit_platform_info.assumed_schedule";
-const std::string kNodeTransitPlatformInfoLatLon = "node.transit_platform_info.lat_lon";
-const std::string kNodeTransitStationInfoOnestopId = "node.transit_station_info.onestop_id";
-const std::string kNodeTransitStationInfoName = "node.transit_station_info.name";
-const std::string kNodeTransitStationInfoLatLon = "node.transit_station_info.lat_lon";
-const std::string kNodeTransitEgressInfoOnestopId = "node.transit_egress_info.onestop_id";
-const std::string kNodeTransitEgressInfoName = "node.transit_egress_info.name";
-const std::string kNodeTransitEgressInfoLatLon = "node.transit_egress_info.lat_lon";
-
-const std::string kNodeTimeZone = "node.time_zone";
-
-// Top level: osm chnageset, admin list, and full shape keys
-const std::string kOsmChangeset = "osm_changeset";
-const std::string kAdminCountryCode = "admin.country_code";
-const std::string kAdminCountryText = "admin.country_text";
-const std::string kAdminStateCode = "admin.state_code";
-const std::string kAdminStateText = "admin.state_text";
-const std::string kShape = "shape";
-const std::string kMatchedPoint = "matched.point";
-const std::string kMatchedType = "matched.type";
-const std::string kMatchedEdgeIndex = "matched.edge_index";
-const std::string kMatchedBeginRouteDiscontinuity = "matched.begin_route_discontinuity";
-const std::string kMatchedEndRouteDiscontinuity = "matched.end_route_discontinuity";
-const std::string kMatchedDistanceAlongEdge = "matched.distance_along_edge";
-const std::string kMatchedDistanceFromTracePoint = "matched.distance_from_trace_point";
-const std::string kConfidenceScore = "confidence_score";
-const std::string kRawScore = "raw_score";
+const Attribute kNodeIntersectingEdgeBeginHeading{
+    "node.intersecting_edge.begin_heading", kNodeGroup, 1ULL << 0};
+const Attribute kNodeIntersectingEdgeFromEdgeNameConsistency{
+    "node.intersecting_edge.from_edge_name_consistency", kNodeGroup, 1ULL << 1};
+const Attribute kNodeIntersectingEdgeToEdgeNameConsistency{
+    "node.intersecting_edge.to_edge_name_consistency", kNodeGroup, 1ULL << 2};
+const Attribute kNodeIntersectingEdgeDriveability{
+    "node.intersecting_edge.driveability", kNodeGroup, 1ULL << 3};
+const Attribute kNodeIntersectingEdgeCyclability{
+    "node.intersecting_edge.cyclability", kNodeGroup, 1ULL << 4};
+const Attribute kNodeIntersectingEdgeWalkability{
+    "node.intersecting_edge.walkability", kNodeGroup, 1ULL << 5};
+const Attribute kNodeElapsedTime{"node.elapsed_time", kNodeGroup, 1ULL << 6};
+const Attribute kNodeaAdminIndex{"node.admin_index", kNodeGroup, 1ULL << 7};
+const Attribute kNodeType{"node.type", kNodeGroup, 1ULL << 8};
+const Attribute kNodeFork{"node.fork", kNodeGroup, 1ULL << 9};
+const Attribute kNodeTransitPlatformInfoType{
+    "node.transit_platform_info.type", kNodeGroup, 1ULL << 10};
+const Attribute kNodeTransitPlatformInfoOnestopId{
+    "node.transit_platform_info.onestop_id", kNodeGroup, 1ULL << 11};
+const Attribute kNodeTransitPlatformInfoName{
+    "node.transit_platform_info.name", kNodeGroup, 1ULL << 12};
+const Attribute kNodeTransitPlatformInfoStationOnestopId{
+    "node.transit_platform_info.station_onestop_id", kNodeGroup, 1ULL << 13};
+const Attribute kNodeTransitPlatformInfoStationName{
+    "node.transit_platform_info.station_name", kNodeGroup, 1ULL << 14};
+const Attribute kNodeTransitPlatformInfoArrivalDateTime{
+    "node.transit_platform_info.arrival_date_time", kNodeGroup, 1ULL << 15};
+const Attribute kNodeTransitPlatformInfoDepartureDateTime{
+    "node.transit_platform_info.departure_date_time", kNodeGroup, 1ULL << 16};
+const Attribute kNodeTransitPlatformInfoIsParentStop{
+    "node.transit_platform_info.is_parent_stop", kNodeGroup, 1ULL << 17};
+const Attribute kNodeTransitPlatformInfoAssumedSchedule{
+    "node.transit_platform_info.assumed_schedule", kNodeGroup, 1ULL << 18};
+const Attribute kNodeTransitPlatformInfoLatLon{
+    "node.transit_platform_info.lat_lon", kNodeGroup, 1ULL << 19};
+const Attribute kNodeTransitStationInfoOnestopId{
+    "node.transit_station_info.onestop_id", kNodeGroup, 1ULL << 20};
+const Attribute kNodeTransitStationInfoName{
+    "node.transit_station_info.name", kNodeGroup, 1ULL << 21};
+const Attribute kNodeTransitStationInfoLatLon{
+    "node.transit_station_info.lat_lon", kNodeGroup, 1ULL << 22};
+const Attribute kNodeTransitEgressInfoOnestopId{
+    "node.transit_egress_info.onestop_id", kNodeGroup, 1ULL << 23};
+const Attribute kNodeTransitEgressInfoName{"node.transit_egress_info.name", kNodeGroup, 1ULL << 24};
+const Attribute kNodeTransitEgressInfoLatLon{
+    "node.transit_egress_info.lat_lon", kNodeGroup, 1ULL << 25};
+const Attribute kNodeTimeZone{"node.time_zone", kNodeGroup, 1ULL << 26};
+
+// Top level: osm changeset, admin list, and full shape keys
+const Attribute kOsmChangeset{"osm_changeset", kCommonGroup, 1ULL << 0};
+const Attribute kAdminCountryCode{"admin.country_code", kCommonGroup, 1ULL << 1};
+const Attribute kAdminCountryText{"admin.country_text", kCommonGroup, 1ULL << 2};
+const Attribute kAdminStateCode{"admin.state_code", kCommonGroup, 1ULL << 3};
+const Attribute kAdminStateText{"admin.state_text", kCommonGroup, 1ULL << 4};
+const Attribute kShape{"shape", kCommonGroup, 1ULL << 5};
+const Attribute kMatchedPoint{"matched.point", kCommonGroup, 1ULL << 6};
+const Attribute kMatchedType{"matched.type", kCommonGroup, 1ULL << 7};
+const Attribute kMatchedEdgeIndex{"matched.edge_index", kCommonGroup, 1ULL << 8};
+const Attribute kMatchedBeginRouteDiscontinuity{
+    "matched.begin_route_discontinuity", kCommonGroup, 1ULL << 9};
+const Attribute kMatchedEndRouteDiscontinuity{
+    "matched.end_route_discontinuity", kCommonGroup, 1ULL << 10};
+const Attribute kMatchedDistanceAlongEdge{"matched.distance_along_edge", kCommonGroup, 1ULL << 11};
+const Attribute kMatchedDistanceFromTracePoint{
+    "matched.distance_from_trace_point", kCommonGroup, 1ULL << 12};
+const Attribute kConfidenceScore{"confidence_score", kCommonGroup, 1ULL << 13};
+const Attribute kRawScore{"raw_score", kCommonGroup, 1ULL << 14};
 
 // Categories
 const std::string kNodeCategory = "node.";
@@ -153,7 +207,38 @@ struct AttributesController {
    */
   bool category_attribute_enabled(const std::string& category) const;
 
+  /**
+   * Rebuild the per group bit masks from the attributes map. The
+   * constructor, enable_all and disable_all do this themselves; call it
+   * after mutating the attributes map directly and before handing the
+   * controller to the builders.
+   */
+  void compile();
+
+  /**
+   * Is this attribute enabled? Tests the compiled masks - a single AND -
+   * so the builder loops can afford to ask per attribute per edge.
+   * @param  attribute  The attribute key.
+   * @return  Returns true if the attribute is enabled.
+   */
+  bool operator()(const Attribute& attribute) const {
+    return masks_[attribute.group] & attribute.mask;
+  }
+
+  /**
+   * The compiled enabled set of a whole attribute group, for skipping
+   * entire blocks when nothing in the group is wanted.
+   * @param  group  One of the attribute group indexes.
+   * @return  Returns the group's mask, 0 when every attribute is disabled.
+   */
+  uint64_t group_mask(const size_t group) const {
+    return masks_[group];
+  }
+
   std::unordered_map<std::string, bool> attributes;
+
+protected:
+  uint64_t masks_[kGroupCount];
 };
 
 } // namespace thor
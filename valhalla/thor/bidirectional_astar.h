@@ -66,6 +66,47 @@ public:
    */
   void Clear();
 
+  /**
+   * Set whether hierarchy limits are scaled by the origin to destination
+   * distance, so short routes spend fewer transitions on the higher levels.
+   * @param  adaptive  True to scale the limits per request.
+   */
+  void set_adaptive_hierarchy_limits(const bool adaptive) {
+    adaptive_hierarchy_limits_ = adaptive;
+  }
+
+  /**
+   * Set how many alternate paths to consider returning in addition to the
+   * best path. When non zero the candidate connections the two searches
+   * discover are retained and the search runs on until connections within
+   * the stretch limit are exhausted, so paths through other meeting
+   * plateaus can be formed after the best path.
+   * @param  max_alternates  Maximum number of alternate paths to form.
+   */
+  void set_max_alternates(const uint32_t max_alternates) {
+    max_alternates_ = max_alternates;
+  }
+
+  /**
+   * Form alternate paths from the candidate connections the last GetBestPath
+   * call discovered. Candidates are considered in cost order; one becomes an
+   * alternate when its cost is within the stretch limit of the best path and
+   * it shares few enough edges with the best path and the alternates already
+   * accepted. Must be called before Clear.
+   * @param   graphreader  Graph reader for accessing routing graph.
+   * @return  Returns up to the configured number of alternate paths, best
+   *          first. Empty when alternates were not requested or none qualify.
+   */
+  std::vector<std::vector<PathInfo>> GetAlternatePaths(baldr::GraphReader& graphreader);
+
+  /**
+   * Returns the number of edge labels the last path computation allocated,
+   * summed over the forward and reverse searches.
+   */
+  virtual uint64_t expanded_label_count() const override {
+    return edgelabels_forward_.size() + edgelabels_reverse_.size();
+  }
+
 protected:
   // Access mode used by the costing method
   uint32_t access_mode_;
@@ -83,11 +124,40 @@ protected:
   std::vector<sif::HierarchyLimits> hierarchy_limits_forward_;
   std::vector<sif::HierarchyLimits> hierarchy_limits_reverse_;
 
-  // A* heuristic
-  float cost_diff_;
+  // Whether the hierarchy limits are scaled by the origin to destination
+  // distance per request
+  bool adaptive_hierarchy_limits_;
+
+  // Node expansions per hierarchy level in each direction. Logged with the
+  // upward transition counts once a path is formed, to support tuning of
+  // the hierarchy limits.
+  uint32_t expansions_forward_[8];
+  uint32_t expansions_reverse_[8];
+
+  /**
+   * Total node expansions over both directions and all levels so far.
+   */
+  uint32_t total_expansions() const {
+    uint32_t total = 0;
+    for (size_t level = 0; level < 8; ++level) {
+      total += expansions_forward_[level] + expansions_reverse_[level];
+    }
+    return total;
+  }
+
+  // A* heuristics. Each search is keyed by the balanced potential - the
+  // average of the forward and reverse heuristics - so the frontiers stay
+  // consistent with each other and meet near the middle of the route
   AStarHeuristic astarheuristic_forward_;
   AStarHeuristic astarheuristic_reverse_;
 
+  // Per direction constants added to the balanced potentials so each is
+  // zero at its own target. Their sum is the heuristic every pair of
+  // forward/reverse labels carries in excess of the true path cost, so it
+  // joins the best connection cost in the stopping rule.
+  float potential_forward_offset_;
+  float potential_reverse_offset_;
+
   // Vector of edge labels (requires access by index).
   std::vector<sif::BDEdgeLabel> edgelabels_forward_;
   std::vector<sif::BDEdgeLabel> edgelabels_reverse_;
@@ -100,10 +170,19 @@ protected:
   EdgeStatus edgestatus_forward_;
   EdgeStatus edgestatus_reverse_;
 
-  // Best candidate connection and threshold to extend search.
-  float threshold_;
+  // Best candidate connection found so far
   CandidateConnection best_connection_;
 
+  // Total expansions when the best connection last improved. Logged with
+  // the route stats to show what the cost bound termination saves over
+  // searching on
+  uint32_t expansions_at_best_;
+
+  // How many alternate paths to consider, and every candidate connection the
+  // searches discovered (the meeting plateaus alternates are formed from)
+  uint32_t max_alternates_;
+  std::vector<CandidateConnection> candidate_connections_;
+
   /**
    * Initialize the A* heuristic and adjacency lists for both the forward
    * and reverse search.
@@ -112,6 +191,44 @@ protected:
    */
   void Init(const PointLL& origll, const PointLL& destll);
 
+  /**
+   * Balanced potential for a node reached by the forward search - the
+   * average of the estimated cost to the destination and the negated
+   * estimate back to the origin, shifted to be zero at the destination.
+   * @param  ll    Lat,lng of the node.
+   * @param  dist  Set to the distance to the destination.
+   * @return  Returns the potential to add to the path cost for sorting.
+   */
+  float ForwardPotential(const PointLL& ll, float& dist) const {
+    return 0.5f * (astarheuristic_forward_.Get(ll, dist) - astarheuristic_reverse_.Get(ll)) +
+           potential_forward_offset_;
+  }
+
+  /**
+   * Balanced potential for a node reached by the reverse search. Negates
+   * the forward potential (plus the pair constant) so the two searches
+   * remain consistent.
+   * @param  ll    Lat,lng of the node.
+   * @param  dist  Set to the distance to the origin.
+   * @return  Returns the potential to add to the path cost for sorting.
+   */
+  float ReversePotential(const PointLL& ll, float& dist) const {
+    return 0.5f * (astarheuristic_reverse_.Get(ll, dist) - astarheuristic_forward_.Get(ll)) +
+           potential_reverse_offset_;
+  }
+
+  /**
+   * Scale the hierarchy transition budgets by the statistics stored in the
+   * endpoint tiles. Tiles without the build time statistics leave the
+   * budgets unchanged.
+   * @param  graphreader  Graph reader for accessing the endpoint tiles.
+   * @param  origin       Origin location (correlated).
+   * @param  destination  Destination location (correlated).
+   */
+  void ScaleLimitsByTileStats(baldr::GraphReader& graphreader,
+                              const odin::Location& origin,
+                              const odin::Location& destination);
+
   /**
    * Expand from the node along the forward search path.
    */
@@ -174,6 +291,16 @@ protected:
    *          destination - along with travel modes and elapsed time.
    */
   std::vector<PathInfo> FormPath(baldr::GraphReader& graphreader);
+
+  /**
+   * Form the path for the given candidate connection. Same as above but the
+   * paths meet at the supplied connection rather than the best one.
+   * @param   graphreader  Graph tile reader (for getting opposing edges).
+   * @param   connection   The connection where the forward and reverse paths meet.
+   * @return  Returns the path info ordered from origin to destination.
+   */
+  std::vector<PathInfo> FormPath(baldr::GraphReader& graphreader,
+                                 const CandidateConnection& connection);
 };
 
 } // namespace thor
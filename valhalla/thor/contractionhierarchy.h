@@ -0,0 +1,131 @@
+#ifndef VALHALLA_THOR_CONTRACTIONHIERARCHY_H_
+#define VALHALLA_THOR_CONTRACTIONHIERARCHY_H_
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace valhalla {
+namespace thor {
+
+/**
+ * Contraction hierarchy preprocessing and query engine over a directed
+ * graph with fixed edge weights. Nodes are contracted in importance order
+ * (edge difference plus contracted-neighbor depth) with witness searches
+ * limiting the shortcuts that get added; queries run the standard
+ * bidirectional upward search and unpack shortcut edges back into the
+ * original edges.
+ *
+ * This operates on an extracted graph rather than on graph tiles - the
+ * weights must be fixed at build time, so a hierarchy is only valid for
+ * one costing snapshot. Callers extract the subgraph they want to
+ * accelerate (e.g. the highway levels for the default auto costing), build
+ * once and query many times.
+ */
+class ContractionHierarchy {
+public:
+  static constexpr uint32_t kInvalidNode = std::numeric_limits<uint32_t>::max();
+
+  /**
+   * Constructor.
+   * @param node_count  number of nodes in the input graph
+   */
+  ContractionHierarchy(const uint32_t node_count);
+
+  /**
+   * Add a directed edge to the input graph. Must be called before Build.
+   * @param source  source node index
+   * @param target  target node index
+   * @param weight  nonnegative edge weight
+   */
+  void AddEdge(const uint32_t source, const uint32_t target, const float weight);
+
+  /**
+   * Contract the graph. Orders the nodes, runs witness searches and adds
+   * the shortcut edges. Must be called once before any queries.
+   */
+  void Build();
+
+  /**
+   * Shortest path cost between two nodes.
+   * @param source  source node index
+   * @param target  target node index
+   * @return the path cost or infinity if the target is unreachable
+   */
+  float Cost(const uint32_t source, const uint32_t target) const;
+
+  /**
+   * Shortest path between two nodes, unpacked into original graph nodes.
+   * @param source  source node index
+   * @param target  target node index
+   * @return the node sequence from source to target, empty if unreachable
+   */
+  std::vector<uint32_t> Path(const uint32_t source, const uint32_t target) const;
+
+  /**
+   * How many shortcut edges contraction added, mostly for logging and tests.
+   */
+  uint32_t shortcut_count() const {
+    return shortcut_count_;
+  }
+
+protected:
+  // An edge of the hierarchy. Shortcuts remember the contracted node they
+  // bypass so paths can be unpacked after a query
+  struct edge_t {
+    uint32_t target; // the node this edge leads to (source for reverse edges)
+    float weight;
+    uint32_t via; // contracted node a shortcut bypasses, kInvalidNode if original
+  };
+
+  /**
+   * Can the graph get from source to target with cost <= max_weight without
+   * going through the excluded node? Standard witness search, bounded by a
+   * settled-node budget so contraction stays near linear.
+   */
+  bool HasWitness(const uint32_t source,
+                  const uint32_t target,
+                  const uint32_t excluded,
+                  const float max_weight) const;
+
+  /**
+   * The priority of contracting a node right now: edge difference plus the
+   * depth term that keeps contraction spread out.
+   */
+  int32_t ContractionPriority(const uint32_t node) const;
+
+  /**
+   * Contract one node: add shortcuts between its uncontracted neighbors
+   * wherever no witness path exists.
+   */
+  void Contract(const uint32_t node);
+
+  /**
+   * Recursively expand a hierarchy edge into original graph nodes.
+   */
+  void Unpack(const uint32_t source,
+              const uint32_t target,
+              const uint32_t via,
+              std::vector<uint32_t>& path) const;
+
+  // Forward and reverse adjacency, reverse mirrors every forward edge
+  std::vector<std::vector<edge_t>> forward_;
+  std::vector<std::vector<edge_t>> reverse_;
+
+  // Contraction order of each node, higher is more important
+  std::vector<uint32_t> order_;
+
+  // Whether a node is already contracted, only used during Build
+  std::vector<bool> contracted_;
+
+  // Contraction depth term, bumped on neighbors when a node is contracted
+  std::vector<uint32_t> depth_;
+
+  uint32_t shortcut_count_;
+  bool built_;
+};
+
+} // namespace thor
+} // namespace valhalla
+
+#endif // VALHALLA_THOR_CONTRACTIONHIERARCHY_H_
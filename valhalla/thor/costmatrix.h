@@ -2,8 +2,10 @@
 #define VALHALLA_THOR_COSTMATRIX_H_
 
 #include <cstdint>
+#include <functional>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <set>
 #include <unordered_map>
 #include <utility>
@@ -16,6 +18,7 @@
 #include <valhalla/sif/dynamiccost.h>
 #include <valhalla/sif/edgelabel.h>
 #include <valhalla/thor/edgestatus.h>
+#include <valhalla/thor/pathinfo.h>
 
 namespace valhalla {
 namespace thor {
@@ -89,10 +92,15 @@ struct BestCandidate {
 class CostMatrix {
 public:
   /**
-   * Default constructor. Most internal values are set when a query is made so
+   * Constructor. Most internal values are set when a query is made so
    * the constructor mainly just sets some internals to a default empty value.
+   * @param  concurrency  Number of threads used to expand the per-location
+   *                      search trees. Values above 1 require a tile cache
+   *                      that is safe to share between threads (a tile
+   *                      extract, global_synchronized_cache, or the sharded
+   *                      cache).
    */
-  CostMatrix();
+  CostMatrix(const uint32_t concurrency = 1);
 
   /**
    * Forms a time distance matrix from the set of source locations
@@ -113,13 +121,68 @@ public:
                  const sif::TravelMode mode,
                  const float max_matrix_distance);
 
+  /**
+   * Form the path for a source-target pair by replaying the predecessor
+   * links the matrix search recorded. The search trees are retained after
+   * SourceToTarget, so callers that go on to build routes between matrix
+   * locations (optimized routes) can replay the winning connection instead
+   * of running a full route search per leg. Only valid until the next
+   * SourceToTarget or Clear call.
+   * @param  source       Index of the source location.
+   * @param  target       Index of the target location.
+   * @param  graphreader  Graph reader for accessing routing graph.
+   * @return Returns the path (empty if no connection was found).
+   */
+  std::vector<PathInfo>
+  FormPath(const uint32_t source, const uint32_t target, baldr::GraphReader& graphreader) const;
+
   /**
    * Clear the temporary information generated during time+distance
    * matrix construction.
    */
   void Clear();
 
+  /**
+   * Set a callback that will throw when the matrix computation should be
+   * aborted, checked between expansion iterations so a request whose client
+   * went away stops burning a core
+   * @param interrupt_callback  the function to periodically call to see if
+   *                            we should abort
+   */
+  void set_interrupt(const std::function<void()>* interrupt_callback) {
+    interrupt_ = interrupt_callback;
+  }
+
+  /**
+   * Set an approximate memory budget (in bytes) for the search trees. When
+   * the edge labels across every location's tree exceed it the search stops
+   * early and connections not yet found are reported as unreachable - a
+   * partial matrix beats the whole process being killed under co-tenant
+   * requests. A budget of 0 (the default) disables the check.
+   * @param budget  the budget in bytes
+   */
+  void set_memory_budget(const uint64_t budget) {
+    memory_budget_ = budget;
+  }
+
 protected:
+  // Callback to periodically check whether the computation should be aborted
+  const std::function<void()>* interrupt_;
+
+  // Approximate cap in bytes on the memory the search trees may hold, 0
+  // for no cap
+  uint64_t memory_budget_;
+
+  // Number of threads used to expand the per-location search trees
+  uint32_t nthreads_;
+
+  // Protects the shared location status bookkeeping when searches run on
+  // more than one thread
+  std::mutex status_lock_;
+
+  // Protects the map of target edge markings during the backward phase
+  std::mutex targets_lock_;
+
   // Access mode used by the costing method
   uint32_t access_mode_;
 
@@ -159,6 +222,12 @@ protected:
   // Mark each target edge with a list of target indexes that have reached it
   std::unordered_map<baldr::GraphId, std::vector<uint32_t>> targets_;
 
+  // When duplicate correlated locations were collapsed, maps each original
+  // source/target index to the unique location the matrix was actually run
+  // with. Identity mappings when every location is distinct.
+  std::vector<uint32_t> source_remap_;
+  std::vector<uint32_t> target_remap_;
+
   // List of best connections found so far
   std::vector<BestCandidate> best_connection_;
 
@@ -202,6 +271,22 @@ protected:
    */
   void UpdateStatus(const uint32_t source, const uint32_t target);
 
+  /**
+   * Run one search iteration for every location that can still be expanded,
+   * spreading the searches across the worker threads. Threshold decrements
+   * and retirement of exhausted locations stay on the calling thread; each
+   * location owns its labels, adjacency list, and edge status so only the
+   * shared bookkeeping needs locking.
+   * @param  status     Status list for the locations (source or target).
+   * @param  count      Number of locations.
+   * @param  remaining  Count of locations that can still be expanded.
+   * @param  search     One search iteration given a location index.
+   */
+  void RunPhase(std::vector<LocationStatus>& status,
+                const uint32_t count,
+                uint32_t& remaining,
+                const std::function<void(const uint32_t)>& search);
+
   /**
    * Iterate the backward search from the target/destination location.
    * @param  index        Index of the target location.
@@ -245,6 +330,21 @@ protected:
                           const sif::BDEdgeLabel& pred,
                           const uint32_t predindex);
 
+  /**
+   * Collapse locations that correlated to the identical set of graph edges
+   * (e.g. a fleet of vehicles parked at one depot) into one representative
+   * each. Identically correlated locations grow identical search trees, so
+   * the matrix runs over the unique representatives and the result rows and
+   * columns are fanned back out through the remap.
+   * @param  locations  Correlated locations as passed by the caller.
+   * @param  remap      Filled with, per original location, the index of the
+   *                    unique representative whose search results it reads.
+   * @return Returns the unique representative locations in first-seen order.
+   */
+  static google::protobuf::RepeatedPtrField<odin::Location>
+  DedupLocations(const google::protobuf::RepeatedPtrField<odin::Location>& locations,
+                 std::vector<uint32_t>& remap);
+
   /**
    * Form a time/distance matrix from the results.
    * @return  Returns a time distance matrix among locations.
@@ -1,8 +1,10 @@
 #ifndef VALHALLA_THOR_EDGESTATUS_H_
 #define VALHALLA_THOR_EDGESTATUS_H_
 
-#include <unordered_map>
+#include <algorithm>
+#include <vector>
 #include <valhalla/baldr/graphid.h>
+#include <valhalla/baldr/graphid_map.h>
 #include <valhalla/baldr/graphtile.h>
 
 namespace valhalla {
@@ -49,21 +51,16 @@ struct EdgeStatusInfo {
 class EdgeStatus {
 public:
   /**
-   * Destructor. Delete any allocated EdgeStatusInfo arrays.
-   */
-  ~EdgeStatus() {
-    clear();
-  }
-
-  /**
-   * Clear the EdgeStatusInfo arrays and the edge status map.
+   * Clear the edge status info. The per-tile arrays are kept and zeroed so
+   * repeated requests against the same tiles reuse the allocations instead
+   * of paying the new[]/page-fault cost every time.
    */
   void clear() {
-    // Delete any allocated arrays for tiles within the map.
-    for (auto& iter : edgestatus_) {
-      delete[] iter.second;
-    }
-    edgestatus_.clear();
+    edgestatus_.each([](const uint32_t, std::vector<EdgeStatusInfo>& status) {
+      std::fill(status.begin(), status.end(), EdgeStatusInfo());
+    });
+    last_tile_ = baldr::kInvalidGraphId;
+    last_array_ = nullptr;
   }
 
   /**
@@ -77,16 +74,7 @@ public:
            const EdgeSet set,
            const uint32_t index,
            const baldr::GraphTile* tile) {
-    auto p = edgestatus_.find(edgeid.tile_value());
-    if (p != edgestatus_.end()) {
-      p->second[edgeid.id()] = {set, index};
-    } else {
-      // Tile is not in the map. Add an array of EdgeStatusInfo, sized to
-      // the number of directed edges in the specified tile.
-      auto inserted = edgestatus_.emplace(edgeid.tile_value(),
-                                          new EdgeStatusInfo[tile->header()->directededgecount()]);
-      inserted.first->second[edgeid.id()] = {set, index};
-    }
+    GetOrAllocate(edgeid, tile)[edgeid.id()] = {set, index};
   }
 
   /**
@@ -96,12 +84,11 @@ public:
    * @param  set      Label set for this directed edge.
    */
   void Update(const baldr::GraphId& edgeid, const EdgeSet set) {
-    const auto p = edgestatus_.find(edgeid.tile_value());
-    if (p != edgestatus_.end()) {
-      p->second[edgeid.id()].set_ = static_cast<uint32_t>(set);
-    } else {
+    EdgeStatusInfo* array = GetArray(edgeid);
+    if (array == nullptr) {
       throw std::runtime_error("EdgeStatus Update on edge not previously set");
     }
+    array[edgeid.id()].set_ = static_cast<uint32_t>(set);
   }
 
   /**
@@ -110,8 +97,8 @@ public:
    * @return  Returns edge status info.
    */
   EdgeStatusInfo Get(const baldr::GraphId& edgeid) const {
-    const auto p = edgestatus_.find(edgeid.tile_value());
-    return (p == edgestatus_.end()) ? EdgeStatusInfo() : p->second[edgeid.id()];
+    const EdgeStatusInfo* array = GetArray(edgeid);
+    return array == nullptr ? EdgeStatusInfo() : array[edgeid.id()];
   }
 
   /**
@@ -123,23 +110,53 @@ public:
    * @return  Returns a pointer to edge status info for this edge.
    */
   EdgeStatusInfo* GetPtr(const baldr::GraphId& edgeid, const baldr::GraphTile* tile) {
-    const auto p = edgestatus_.find(edgeid.tile_value());
-    if (p != edgestatus_.end()) {
-      return &p->second[edgeid.id()];
-    } else {
-      // Tile is not in the map. Add an array of EdgeStatusInfo, sized to
-      // the number of directed edges in the specified tile.
-      auto inserted = edgestatus_.emplace(edgeid.tile_value(),
-                                          new EdgeStatusInfo[tile->header()->directededgecount()]);
-      return &(inserted.first->second)[edgeid.id()];
-    }
+    return &GetOrAllocate(edgeid, tile)[edgeid.id()];
   }
 
 private:
+  /**
+   * Get the status array of the edge's tile, nullptr if never touched.
+   * The last used tile is memoized since expansion hits the same tile for
+   * long runs of edges.
+   */
+  EdgeStatusInfo* GetArray(const baldr::GraphId& edgeid) const {
+    if (edgeid.tile_value() == last_tile_) {
+      return last_array_;
+    }
+    const auto* status = edgestatus_.find(edgeid.tile_value());
+    if (status == nullptr) {
+      return nullptr;
+    }
+    last_tile_ = edgeid.tile_value();
+    last_array_ = const_cast<EdgeStatusInfo*>(status->data());
+    return last_array_;
+  }
+
+  /**
+   * Get the status array of the edge's tile, allocating it sized to the
+   * tile's directed edge count on first touch.
+   */
+  EdgeStatusInfo* GetOrAllocate(const baldr::GraphId& edgeid, const baldr::GraphTile* tile) {
+    EdgeStatusInfo* array = GetArray(edgeid);
+    if (array == nullptr) {
+      auto& status = edgestatus_.emplace(edgeid.tile_value());
+      status.resize(tile->header()->directededgecount());
+      last_tile_ = edgeid.tile_value();
+      last_array_ = array = status.data();
+    }
+    return array;
+  }
+
   // Edge status - keys are the tile Ids (level and tile Id) and the
-  // values are dynamically allocated arrays of EdgeStatusInfo (sized
-  // based on the directed edge count within the tile).
-  std::unordered_map<uint32_t, EdgeStatusInfo*> edgestatus_;
+  // values are flat arrays of EdgeStatusInfo (sized based on the directed
+  // edge count within the tile). The arrays never resize once created so
+  // pointers into them stay valid even as the table grows.
+  baldr::graphid_map<std::vector<EdgeStatusInfo>> edgestatus_;
+
+  // The most recently touched tile and its array, to skip the hash lookup
+  // on the common case of many consecutive edges in one tile
+  mutable uint64_t last_tile_ = baldr::kInvalidGraphId;
+  mutable EdgeStatusInfo* last_array_ = nullptr;
 };
 
 } // namespace thor
@@ -2,12 +2,14 @@
 #define VALHALLA_THOR_ISOCHRONE_H_
 
 #include <cstdint>
+#include <functional>
 #include <map>
 #include <memory>
 #include <unordered_map>
 #include <utility>
 #include <vector>
 
+#include <valhalla/baldr/datetime.h>
 #include <valhalla/baldr/double_bucket_queue.h>
 #include <valhalla/baldr/graphid.h>
 #include <valhalla/baldr/graphreader.h>
@@ -21,6 +23,21 @@
 namespace valhalla {
 namespace thor {
 
+/**
+ * Per-edge record of the cost surface an expansion leaves behind - the
+ * elapsed time and path distance of the lowest cost path to the end of
+ * the edge.
+ */
+struct ExpansionEdge {
+  baldr::GraphId edgeid;
+  uint32_t secs; // Elapsed time in seconds to the end of the edge
+  uint32_t dist; // Path distance in meters to the end of the edge
+
+  ExpansionEdge(const baldr::GraphId& id, const uint32_t s, const uint32_t d)
+      : edgeid(id), secs(s), dist(d) {
+  }
+};
+
 /**
  * Algorithm to generate an isochrone as a lat,lon grid with time taken to
  * each each grid point. This gridded data can then be contoured to create
@@ -43,6 +60,30 @@ public:
    */
   void Clear();
 
+  /**
+   * Set a callback that will throw when the expansion should be aborted.
+   * Unlike the path algorithms the isochrone catches the throw and returns
+   * the grid built so far, so an aborted request still yields the contours
+   * that were fully expanded before the deadline
+   * @param interrupt_callback  the function to periodically call to see if
+   *                            we should abort
+   */
+  void set_interrupt(const std::function<void()>* interrupt_callback) {
+    interrupt_ = interrupt_callback;
+  }
+
+  /**
+   * Set an approximate memory budget (in bytes) for the request. When set,
+   * the isotile grid is coarsened until its full allocation fits within a
+   * share of the budget - a coarser isochrone beats the process being
+   * killed under co-tenant requests. A budget of 0 (the default) disables
+   * the check.
+   * @param budget  the budget in bytes
+   */
+  void set_memory_budget(const uint64_t budget) {
+    memory_budget_ = budget;
+  }
+
   /**
    * Compute an isochrone grid. This creates and populates a lat,lon grid with
    * time taken to reach each grid point. This gridded data is then contoured
@@ -90,9 +131,29 @@ public:
                     const std::shared_ptr<sif::DynamicCost>* mode_costing,
                     const sif::TravelMode mode);
 
+  /**
+   * Get the per-edge cost surface the last Compute* call left behind. One
+   * record per settled edge, giving the elapsed time and path distance of
+   * the lowest cost path to the end of the edge. Only valid until the next
+   * Compute* or Clear call.
+   * @return  Returns one record per edge the expansion settled.
+   */
+  std::vector<ExpansionEdge> GetExpansionEdges() const;
+
 protected:
+  // Callback to periodically check whether the expansion should be aborted
+  const std::function<void()>* interrupt_;
+
+  // Approximate per request memory budget the isotile grid is sized
+  // against, 0 for no budget
+  uint64_t memory_budget_;
+
   bool has_date_time_;
   int start_tz_index_;   // Timezone at the start of the isochrone
+
+  // Per request cache of timezone differences between the start timezone
+  // and timezones encountered during the expansion
+  baldr::DateTime::tz_diff_cache_t tz_diff_cache_;
   float shape_interval_; // Interval along shape to mark time
   sif::TravelMode mode_; // Current travel mode
   uint32_t access_mode_; // Access mode used by the costing method
@@ -109,6 +170,9 @@ protected:
   std::string origin_date_time_;
   std::unordered_map<std::string, uint32_t> operators_;
   std::unordered_set<uint32_t> processed_tiles_;
+  // Per transit tile bitsets of which schedule entries are valid on the
+  // request's service day, built once per tile on first departure lookup
+  std::unordered_map<uint32_t, std::vector<bool>> schedule_validity_;
 
   // Current costing mode
   std::shared_ptr<sif::DynamicCost> costing_;
@@ -8,6 +8,7 @@
 #include <utility>
 #include <vector>
 
+#include <valhalla/baldr/datetime.h>
 #include <valhalla/baldr/double_bucket_queue.h>
 #include <valhalla/baldr/graphid.h>
 #include <valhalla/baldr/graphreader.h>
@@ -61,12 +62,36 @@ public:
    */
   void Clear();
 
+  /**
+   * Run the destination reachability check on a separate thread, overlapped
+   * with origin and destination initialization. The check is a self contained
+   * pedestrian search with its own labels and queue so it can safely run
+   * alongside the setup work, but both threads read graph tiles so this
+   * should only be enabled when the tile cache can be shared between threads
+   * (a tile extract or one of the thread-safe caches).
+   * @param  parallel  True to overlap the reachability check.
+   */
+  void set_parallel_reachability(const bool parallel) {
+    parallel_reachability_ = parallel;
+  }
+
+  /**
+   * Returns the number of edge labels the last path computation allocated.
+   */
+  virtual uint64_t expanded_label_count() const override {
+    return edgelabels_.size();
+  }
+
 protected:
   // Current walking distance.
   uint32_t walking_distance_;
   bool has_date_time_;
   int start_tz_index_; // Timezone at the start of the mm route
 
+  // Per request cache of timezone differences between the start timezone
+  // and timezones encountered during the expansion
+  baldr::DateTime::tz_diff_cache_t tz_diff_cache_;
+
   uint32_t max_label_count_; // Max label count to allow
   sif::TravelMode mode_;     // Current travel mode
   uint8_t travel_type_;      // Current travel type
@@ -74,6 +99,7 @@ protected:
   bool date_set_;
   bool date_before_tile_;
   bool disable_transit_;
+  bool parallel_reachability_;
   uint32_t date_;
   uint32_t dow_;
   uint32_t day_;
@@ -83,6 +109,9 @@ protected:
   std::string origin_date_time_;
   std::unordered_map<std::string, uint32_t> operators_;
   std::unordered_set<uint32_t> processed_tiles_;
+  // Per transit tile bitsets of which schedule entries are valid on the
+  // request's service day, built once per tile on first departure lookup
+  std::unordered_map<uint32_t, std::vector<bool>> schedule_validity_;
 
   // Hierarchy limits.
   std::vector<sif::HierarchyLimits> hierarchy_limits_;
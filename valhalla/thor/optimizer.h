@@ -15,6 +15,21 @@ namespace thor {
 // setting too high takes longer to converge on a solution.
 constexpr float kCoolingRate = 0.93f;
 
+// Tour size at and above which the local search engine (2-opt and Or-opt
+// moves over candidate neighbor lists, with randomized restarts) is used
+// instead of simulated annealing. Annealing converges well for small tours
+// but does not scale much past 50 locations.
+constexpr uint32_t kLocalSearchMinCount = 10;
+
+// Number of nearest neighbors kept per location as candidates for the
+// local search moves. Restricting moves to near neighbors keeps each
+// improvement pass close to linear in the number of locations.
+constexpr uint32_t kNeighborListSize = 10;
+
+// Number of randomized restarts of the local search. Restarts are
+// independent so they run in parallel when hardware threads are available.
+constexpr uint32_t kLocalSearchRestarts = 8;
+
 // Alteration type.
 // kRotate  - Alters a portion of the tour by rotating the locations about
 //            a middle point. The middle location becomes the new start
@@ -79,6 +94,65 @@ protected:
    */
   uint32_t Anneal(const std::vector<float>& costs, float temperature);
 
+  /**
+   * Solve the tour with multi-restart local search: each restart forms a
+   * randomized nearest neighbor tour and improves it with 2-opt and Or-opt
+   * moves over the candidate neighbor lists until no move improves it.
+   * Restarts run in parallel when hardware threads are available; the best
+   * tour over all restarts is returned.
+   * @param  costs  2-D cost matrix.
+   * @return Returns the best tour found.
+   */
+  std::vector<uint32_t> SolveLocalSearch(const std::vector<float>& costs);
+
+  /**
+   * Build the candidate neighbor lists - for each location, the nearest
+   * locations by cost. Local search moves only consider reconnecting a
+   * location to one of its candidates.
+   * @param  costs  2-D cost matrix.
+   * @return Returns the neighbor list for each location.
+   */
+  std::vector<std::vector<uint32_t>> BuildNeighborLists(const std::vector<float>& costs) const;
+
+  /**
+   * Form an initial tour greedily - from the current location move to one
+   * of the three cheapest unvisited locations, chosen at random so each
+   * restart starts from a different tour.
+   * @param  costs  2-D cost matrix.
+   * @param  rng    Random number generator for this restart.
+   * @return Returns the tour.
+   */
+  std::vector<uint32_t> NearestNeighborTour(const std::vector<float>& costs,
+                                            std::mt19937_64& rng) const;
+
+  /**
+   * One 2-opt improvement pass: for each tour edge, try reconnecting its
+   * start to each of its candidate neighbors and reversing the span in
+   * between. Candidates are screened with the boundary arcs and verified
+   * with the exact cost change (the cost matrix may be asymmetric, so the
+   * reversed span is re-costed) before a move is applied.
+   * @param  costs      2-D cost matrix.
+   * @param  neighbors  Candidate neighbor lists.
+   * @param  tour       Tour to improve (updated in place).
+   * @return Returns true if any move improved the tour.
+   */
+  bool TwoOptPass(const std::vector<float>& costs,
+                  const std::vector<std::vector<uint32_t>>& neighbors,
+                  std::vector<uint32_t>& tour) const;
+
+  /**
+   * One Or-opt improvement pass: try moving spans of 1 to 3 locations,
+   * keeping their orientation, to follow one of the span's candidate
+   * neighbors elsewhere in the tour.
+   * @param  costs      2-D cost matrix.
+   * @param  neighbors  Candidate neighbor lists.
+   * @param  tour       Tour to improve (updated in place).
+   * @return Returns true if any move improved the tour.
+   */
+  bool OrOptPass(const std::vector<float>& costs,
+                 const std::vector<std::vector<uint32_t>>& neighbors,
+                 std::vector<uint32_t>& tour) const;
+
   /**
    * Select a potential alteration of the tour.
    * @return  Returns a candidate tour alteration: type and location indexes.
@@ -1,6 +1,7 @@
 #ifndef VALHALLA_THOR_PATHALGORITHM_H_
 #define VALHALLA_THOR_PATHALGORITHM_H_
 
+#include <algorithm>
 #include <functional>
 #include <map>
 #include <memory>
@@ -20,6 +21,16 @@ namespace thor {
 constexpr uint32_t kBucketCount = 20000;
 constexpr size_t kInterruptIterationsInterval = 5000;
 
+/**
+ * One sampled settlement from a path expansion. Compact on purpose - a
+ * telemetry ring of these stays resident on production workers.
+ */
+struct ExpansionEvent {
+  uint64_t edgeid; // Packed graph id of the settled edge
+  float cost;      // Path cost at which the edge was settled
+  uint32_t level;  // Hierarchy level the expansion was on
+};
+
 /**
  * Pure virtual class defining the interface for PathAlgorithm - the algorithm
  * to create shortest path.
@@ -29,7 +40,9 @@ public:
   /**
    * Constructor
    */
-  PathAlgorithm() : interrupt(nullptr), has_ferry_(false) {
+  PathAlgorithm()
+      : interrupt(nullptr), has_ferry_(false), expansion_count_(0), expansion_head_(0),
+        expansion_sample_mask_(0) {
   }
 
   /**
@@ -77,11 +90,77 @@ public:
     return has_ferry_;
   }
 
+  /**
+   * How many edge labels did the last path computation allocate? This is a
+   * proxy for search effort that stage tracing reports. Algorithms that do
+   * not track labels return 0. Cleared along with the labels by Clear.
+   * @return  Returns the number of edge labels.
+   */
+  virtual uint64_t expanded_label_count() const {
+    return 0;
+  }
+
+  /**
+   * Turn expansion telemetry on (or off with a zero buffer size). Every
+   * sample_rate-th settled edge is recorded into a ring buffer of the given
+   * size so the most recent expansions of a pathological route can be dumped
+   * without reproducing it. The rate is rounded up to a power of two so the
+   * per-settlement cost is an increment and a masked compare.
+   * @param buffer_size  Number of events the ring holds, 0 disables.
+   * @param sample_rate  Record every nth settlement.
+   */
+  void set_expansion_telemetry(const uint32_t buffer_size, const uint32_t sample_rate) {
+    expansion_ring_.clear();
+    expansion_ring_.resize(buffer_size);
+    expansion_count_ = 0;
+    expansion_head_ = 0;
+    expansion_sample_mask_ = 0;
+    if (buffer_size > 0) {
+      while (expansion_sample_mask_ + 1 < sample_rate) {
+        expansion_sample_mask_ = (expansion_sample_mask_ << 1) | 1;
+      }
+    }
+  }
+
+  /**
+   * Dump the sampled expansion events, oldest first. The ring is not
+   * cleared - it keeps rolling across requests.
+   * @return  Returns the recorded events in settlement order.
+   */
+  std::vector<ExpansionEvent> expansion_events() const {
+    std::vector<ExpansionEvent> events;
+    if (expansion_ring_.empty()) {
+      return events;
+    }
+    // before the ring wraps only the first head slots are filled
+    uint64_t filled = std::min<uint64_t>(expansion_head_, expansion_ring_.size());
+    events.reserve(filled);
+    for (uint64_t i = expansion_head_ - filled; i < expansion_head_; ++i) {
+      events.push_back(expansion_ring_[i % expansion_ring_.size()]);
+    }
+    return events;
+  }
+
 protected:
   const std::function<void()>* interrupt;
 
   bool has_ferry_; // Indicates whether the path has a ferry
 
+  /**
+   * Record a settled edge into the telemetry ring. Called once per
+   * settlement by the expansion loops; when telemetry is off this is a
+   * single load and branch.
+   * @param edgeid  Graph id of the edge just settled.
+   * @param cost    Path cost at the settlement.
+   */
+  void RecordExpansion(const baldr::GraphId& edgeid, const float cost) {
+    if (expansion_ring_.empty() || ((++expansion_count_) & expansion_sample_mask_) != 0) {
+      return;
+    }
+    expansion_ring_[expansion_head_++ % expansion_ring_.size()] = {edgeid.value, cost,
+                                                                   edgeid.level()};
+  }
+
   /**
    * Check for path completion along the same edge. Edge ID in question
    * is along both an origin and destination and origin shows up at the
@@ -117,6 +196,13 @@ protected:
     const baldr::GraphTile* tile = graphreader.GetGraphTile(node);
     return (tile == nullptr) ? 0 : tile->node(node)->timezone();
   }
+
+private:
+  // Telemetry ring of sampled settlements, empty unless opted in
+  std::vector<ExpansionEvent> expansion_ring_;
+  uint64_t expansion_count_;        // Settlements seen since telemetry was enabled
+  uint64_t expansion_head_;         // Next slot to write, modulo the ring size
+  uint32_t expansion_sample_mask_;  // Sample rate (a power of two) minus one
 };
 
 } // namespace thor
@@ -1,6 +1,7 @@
 #ifndef VALHALLA_THOR_TIMEDEP_H_
 #define VALHALLA_THOR_TIMEDEP_H_
 
+#include <valhalla/baldr/datetime.h>
 #include <valhalla/thor/astar.h>
 
 namespace valhalla {
@@ -45,6 +46,10 @@ protected:
   uint32_t origin_tz_index_;
   uint32_t seconds_of_week_;
 
+  // Per request cache of timezone differences between the origin timezone
+  // and timezones encountered during the expansion
+  baldr::DateTime::tz_diff_cache_t tz_diff_cache_;
+
   /**
    * Expand from the node along the forward search path. Immediately expands
    * from the end node of any transition edge (so no transition edges are added
@@ -108,10 +113,22 @@ public:
                                             const std::shared_ptr<sif::DynamicCost>* mode_costing,
                                             const sif::TravelMode mode);
 
+  /**
+   * Returns the number of edge labels the last path computation allocated.
+   * The reverse search keeps its labels separately from the base class.
+   */
+  virtual uint64_t expanded_label_count() const override {
+    return edgelabels_rev_.size();
+  }
+
 protected:
   uint32_t dest_tz_index_;
   uint32_t seconds_of_week_;
 
+  // Per request cache of timezone differences between timezones encountered
+  // during the expansion and the destination timezone
+  baldr::DateTime::tz_diff_cache_t tz_diff_cache_;
+
   // Access mode used by the costing method
   uint32_t access_mode_;
 
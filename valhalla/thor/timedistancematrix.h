@@ -2,6 +2,7 @@
 #define VALHALLA_THOR_TIMEDISTANCEMATRIX_H_
 
 #include <cstdint>
+#include <functional>
 #include <map>
 #include <memory>
 #include <unordered_map>
@@ -12,6 +13,7 @@
 #include <valhalla/baldr/graphid.h>
 #include <valhalla/baldr/graphreader.h>
 #include <valhalla/baldr/pathlocation.h>
+#include <valhalla/midgard/pointll.h>
 #include <valhalla/sif/dynamiccost.h>
 #include <valhalla/sif/edgelabel.h>
 #include <valhalla/thor/astar.h>
@@ -132,13 +134,52 @@ public:
                  const sif::TravelMode mode,
                  const float max_matrix_distance);
 
+  /**
+   * Forms a time distance matrix from the set of source locations to the
+   * set of target locations, handing each completed row (one source to all
+   * targets) to the callback as it settles rather than accumulating the
+   * full matrix. Rows are delivered in source order so the caller can
+   * serialize and release them immediately, bounding memory to one row.
+   * @param  source_location_list  List of source/origin locations.
+   * @param  target_location_list  List of target/destination locations.
+   * @param  graphreader           Graph reader for accessing routing graph.
+   * @param  mode_costing          Costing methods.
+   * @param  mode                  Travel mode to use.
+   * @param  max_matrix_distance   Maximum arc-length distance for current mode.
+   * @param  row_callback          Invoked once per source with its row of
+   *                               time/distance results.
+   */
+  void SourceToTarget(
+      const google::protobuf::RepeatedPtrField<odin::Location>& source_location_list,
+      const google::protobuf::RepeatedPtrField<odin::Location>& target_location_list,
+      baldr::GraphReader& graphreader,
+      const std::shared_ptr<sif::DynamicCost>* mode_costing,
+      const sif::TravelMode mode,
+      const float max_matrix_distance,
+      const std::function<void(const uint32_t source_index, const std::vector<TimeDistance>& row)>&
+          row_callback);
+
   /**
    * Clear the temporary information generated during time+distance
    * matrix construction.
    */
   void Clear();
 
+  /**
+   * Set a callback that will throw when the matrix computation should be
+   * aborted, checked every few thousand queue pops so a request whose
+   * client went away stops burning a core
+   * @param interrupt_callback  the function to periodically call to see if
+   *                            we should abort
+   */
+  void set_interrupt(const std::function<void()>* interrupt_callback) {
+    interrupt_ = interrupt_callback;
+  }
+
 protected:
+  // Callback to periodically check whether the computation should be aborted
+  const std::function<void()>* interrupt_;
+
   // Number of destinations that have been found and settled (least cost path
   // computed).
   uint32_t settled_count_;
@@ -149,6 +190,11 @@ protected:
   // List of destinations
   std::vector<Destination> destinations_;
 
+  // The destinations as they were set up. The many to many row loop restores
+  // the working list from this between sources rather than repeating the
+  // graph lookups SetDestinations does.
+  std::vector<Destination> destinations_setup_;
+
   // Current costing mode
   std::shared_ptr<sif::DynamicCost> costing_;
 
@@ -156,6 +202,17 @@ protected:
   // has a vector of indexes into the destinations vector
   std::unordered_map<uint64_t, std::vector<uint32_t>> dest_edges_;
 
+  // Lat,lng of each destination, used to form reachability lower bounds
+  std::vector<midgard::PointLL> dest_ll_;
+
+  // Cost lower bound from each graph tile to the nearest destination, keyed
+  // by tile base Id and computed lazily as tiles are first reached
+  std::unordered_map<uint64_t, float> tile_dest_bound_;
+
+  // Admissible cost-per-meter factor for the current costing, used to turn
+  // the tile to destination distances into cost lower bounds
+  float cost_factor_;
+
   // Vector of edge labels (requires access by index).
   std::vector<sif::EdgeLabel> edgelabels_;
 
@@ -212,6 +269,56 @@ protected:
    */
   float GetCostThreshold(const float max_matrix_distance) const;
 
+  /**
+   * Clear only the state a single search dirtied - edge labels, adjacency
+   * list and edge status. The destination set up (locations, the edge to
+   * destination marking and the per tile cost bounds) is left alone so the
+   * many to many row loop can reuse it for the next source.
+   */
+  void ClearSearch();
+
+  /**
+   * Run the search for one origin against destinations that have already
+   * been set up. The mode and costing must also already be set.
+   * @param  origin        Location of the origin.
+   * @param  locations     List of locations.
+   * @param  graphreader   Graph reader for accessing routing graph.
+   * @param  max_matrix_distance   Maximum arc-length distance for current mode.
+   * @return time/distance from the origin to all other locations
+   */
+  std::vector<TimeDistance>
+  ComputeOneToMany(const odin::Location& origin,
+                   const google::protobuf::RepeatedPtrField<odin::Location>& locations,
+                   baldr::GraphReader& graphreader,
+                   const float max_matrix_distance);
+
+  /**
+   * Run the reverse search for one destination against origins that have
+   * already been set up. The mode and costing must also already be set.
+   * @param  dest          Location of the destination.
+   * @param  locations     List of locations.
+   * @param  graphreader   Graph reader for accessing routing graph.
+   * @param  max_matrix_distance   Maximum arc-length distance for current mode.
+   * @return time/distance to the destination from all other locations
+   */
+  std::vector<TimeDistance>
+  ComputeManyToOne(const odin::Location& dest,
+                   const google::protobuf::RepeatedPtrField<odin::Location>& locations,
+                   baldr::GraphReader& graphreader,
+                   const float max_matrix_distance);
+
+  /**
+   * Get a cost lower bound from the graph tile containing a node to the
+   * nearest destination. Computed once per tile (distance from the tile
+   * bounds to each destination times the admissible costing factor) and
+   * cached. Expansions whose cost plus this bound exceeds the cost
+   * threshold provably cannot improve any destination within the threshold
+   * and can be pruned.
+   * @param  node  Graph Id of the node being expanded from.
+   * @return  Returns a lower bound of the cost to the nearest destination.
+   */
+  float TileDestinationBound(const baldr::GraphId& node);
+
   /**
    * Sets the origin for a many to one time+distance matrix computation.
    * @param  graphreader   Graph reader for accessing routing graph.
@@ -7,6 +7,8 @@
 #include <utility>
 #include <vector>
 
+#include <google/protobuf/arena.h>
+
 #include <valhalla/baldr/graphid.h>
 #include <valhalla/baldr/graphreader.h>
 #include <valhalla/baldr/pathlocation.h>
@@ -36,9 +38,12 @@ public:
 
   /**
    * Format the trip path output given the edges on the path.
-   * For now just return length. TODO - modify to return trip path.
+   * When an arena is provided the trip path and all of its nested messages
+   * are allocated on it - a long leg otherwise costs thousands of small
+   * heap allocations. The returned message is owned by the arena (or by the
+   * caller when no arena is given).
    */
-  static odin::TripPath
+  static odin::TripPath*
   Build(const AttributesController& controller,
         baldr::GraphReader& graphreader,
         const std::shared_ptr<sif::DynamicCost>* mode_costing,
@@ -48,7 +53,8 @@ public:
         const std::list<odin::Location>& through_loc,
         const std::function<void()>* interrupt_callback = nullptr,
         std::unordered_map<size_t, std::pair<RouteDiscontinuity, RouteDiscontinuity>>*
-            route_discontinuities = nullptr);
+            route_discontinuities = nullptr,
+        google::protobuf::Arena* arena = nullptr);
 
   /**
    * Add trip edge. (TODO more comments)
@@ -2,10 +2,15 @@
 #define __VALHALLA_THOR_SERVICE_H__
 
 #include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
 #include <tuple>
+#include <unordered_map>
 #include <vector>
 
 #include <boost/property_tree/ptree.hpp>
+#include <google/protobuf/arena.h>
 
 #include <valhalla/baldr/directededge.h>
 #include <valhalla/baldr/graphid.h>
@@ -48,14 +53,36 @@ public:
 #endif
   virtual void cleanup() override;
 
-  std::list<odin::TripPath> route(valhalla_request_t& request);
+  std::list<odin::TripPath*> route(valhalla_request_t& request);
   std::string matrix(valhalla_request_t& request);
-  std::list<odin::TripPath> optimized_route(valhalla_request_t& request);
+  std::list<odin::TripPath*> optimized_route(valhalla_request_t& request);
   std::string isochrones(valhalla_request_t& request);
-  odin::TripPath trace_route(valhalla_request_t& request);
+  std::string one_to_all(valhalla_request_t& request);
+  odin::TripPath* trace_route(valhalla_request_t& request);
   std::string trace_attributes(valhalla_request_t& request);
+  std::string trace_attributes_batch(valhalla_request_t& request);
 
 protected:
+  // The serialization half of an action split from its computation so it can
+  // run elsewhere (on the response executor) after the action returns. Holds
+  // only self contained copies of the result, nothing owned by the worker
+  using deferred_json_t = std::function<std::string(const valhalla_request_t&)>;
+
+  /**
+   * Computes the matrix and returns its serialization as a deferred step.
+   * @param  request  the matrix request
+   * @return the serialization over the computed time distances
+   */
+  deferred_json_t matrix_deferred(valhalla_request_t& request);
+
+  /**
+   * Computes the isochrone contours and returns their serialization as a
+   * deferred step.
+   * @param  request  the isochrone request
+   * @return the serialization over the computed contour lines
+   */
+  deferred_json_t isochrones_deferred(valhalla_request_t& request);
+
   std::vector<thor::PathInfo> get_path(PathAlgorithm* path_algorithm,
                                        odin::Location& origin,
                                        odin::Location& destination,
@@ -66,16 +93,16 @@ protected:
   thor::PathAlgorithm* get_path_algorithm(const std::string& routetype,
                                           const odin::Location& origin,
                                           const odin::Location& destination);
-  odin::TripPath route_match(valhalla_request_t& request, const AttributesController& controller);
-  std::vector<std::tuple<float, float, std::vector<thor::MatchResult>, odin::TripPath>>
+  odin::TripPath* route_match(valhalla_request_t& request, const AttributesController& controller);
+  std::vector<std::tuple<float, float, std::vector<thor::MatchResult>, odin::TripPath*>>
   map_match(valhalla_request_t& request,
             const AttributesController& controller,
             uint32_t best_paths = 1);
 
-  std::list<odin::TripPath>
+  std::list<odin::TripPath*>
   path_arrive_by(google::protobuf::RepeatedPtrField<valhalla::odin::Location>& correlated,
                  const std::string& costing);
-  std::list<odin::TripPath>
+  std::list<odin::TripPath*>
   path_depart_at(google::protobuf::RepeatedPtrField<valhalla::odin::Location>& correlated,
                  const std::string& costing);
 
@@ -84,6 +111,61 @@ protected:
   std::string parse_costing(const valhalla_request_t& request);
   void filter_attributes(const valhalla_request_t& request, AttributesController& controller);
 
+  /**
+   * Check if a route request may be answered from the route cache. Requests
+   * whose results depend on when they are received (a date_time of "current")
+   * cannot be keyed by their content alone.
+   * @param  request  The parsed and correlated route request.
+   * @return Returns true if the result may be cached and reused.
+   */
+  bool route_cacheable(const valhalla_request_t& request) const;
+
+  /**
+   * Classify a request by its estimated cost. Matrix style requests are
+   * heavy when their cell count (sources x targets) reaches the configured
+   * threshold, isochrones when their largest contour does.
+   * @param  request  The parsed request.
+   * @return Returns true if the request counts against the heavy budget.
+   */
+  bool heavy_request(const valhalla_request_t& request) const;
+
+  /**
+   * Form a cache key for a route request from the correlated edge candidates,
+   * per-location date_times, avoided edges, and the costing options. Distances
+   * along the candidate edges are quantized so near identical requests (e.g.
+   * repeated previews while a location marker is dragged) map to the same key.
+   * The full key string is used rather than a hash of it so distinct requests
+   * can never alias each other in the cache.
+   * @param  request  The parsed and correlated route request.
+   * @param  costing  Costing method name.
+   * @return Returns the cache key.
+   */
+  std::string route_cache_key(const valhalla_request_t& request, const std::string& costing) const;
+
+  /**
+   * Computes a single leg route with state entirely local to the calling
+   * thread (its own cost object, algorithm instance and location copies) so
+   * it can run concurrently with the main search on this worker. Used to
+   * speculatively answer the paired fastest/shortest request. Failures are
+   * swallowed and reported as an empty result since the speculation is only
+   * an optimization.
+   * @param  origin       The correlated origin (by value, the search mutates it).
+   * @param  destination  The correlated destination (by value, the search mutates it).
+   * @param  cost         Cost object for the paired costing, not shared with the main search.
+   * @return Returns the trip path for the leg, or an empty list on failure.
+   */
+  std::list<odin::TripPath> speculative_route(odin::Location origin,
+                                              odin::Location destination,
+                                              sif::cost_ptr_t cost) const;
+
+  /**
+   * Dump the sampled expansion events of every path algorithm to the log in
+   * a compact edgeid/level/cost form. Called when a request trips the long
+   * request threshold so a pathological expansion can be inspected without
+   * reproducing it. Does nothing unless expansion telemetry is configured.
+   */
+  void dump_expansion_telemetry() const;
+
   sif::TravelMode mode;
   std::vector<meili::Measurement> trace;
   sif::CostFactory<sif::DynamicCost> factory;
@@ -100,8 +182,69 @@ protected:
   float max_timedep_distance;
   std::unordered_map<std::string, float> max_matrix_distance;
   SOURCE_TO_TARGET_ALGORITHM source_to_target_algorithm;
+  uint32_t costmatrix_concurrency;
+  // Matrix cell count (sources x targets) at or above which rows are handed
+  // to the serializer as they settle rather than accumulated; 0 disables
+  // streaming
+  uint32_t matrix_streaming_threshold;
+  // Approximate per request memory budget in bytes that the big allocators
+  // (search tree labels, matrix tables, isochrone grids) degrade against;
+  // 0 disables the accounting
+  uint64_t request_memory_budget;
+
+  // Edge labels the path algorithms allocated while serving the current
+  // request, reported by stage tracing as a proxy for search effort
+  uint64_t expanded_labels;
+
+  // Optional in-process cache of route results keyed by the correlated edge
+  // candidates and costing options. Entries are evicted least recently used
+  // and the whole cache is dropped whenever the tile cache is reloaded.
+  struct RouteCacheEntry {
+    std::list<odin::TripPath> trippaths;
+    std::list<std::string>::iterator lru;
+  };
+  uint32_t route_cache_size;
+  std::unordered_map<std::string, RouteCacheEntry> route_cache;
+  std::list<std::string> route_cache_lru;
+  // Run the paired fastest/shortest costing on another thread while the
+  // requested one runs here, seeding the route cache with its result.
+  // Requires a thread safe tile cache
+  bool speculative_dual_costing;
+
+  // The last isochrone grid, kept so a contour time slider re-running the
+  // same origin and costing only re-traces contours over the retained grid
+  // instead of re-running the whole expansion. The grid is marked out to the
+  // largest time it was computed with so any smaller contour can be served
+  // from it. Dropped whenever the tile cache is reloaded
+  std::string iso_grid_key;
+  float iso_grid_seconds;
+  std::shared_ptr<const midgard::GriddedData<midgard::PointLL>> iso_grid;
+
+  // Admission control: how many heavy requests may run at once across the
+  // worker threads of this process (0 disables it) and the thresholds at
+  // which a matrix or isochrone request counts as heavy
+  uint32_t max_heavy_requests;
+  uint32_t heavy_matrix_cells;
+  uint32_t heavy_isochrone_minutes;
+
+#ifdef HAVE_HTTP
+  // Runs matrix and isochrone response serialization off the search thread,
+  // shipping the finished responses straight to the loopback. Empty when
+  // disabled and the serializers run inline as they always have
+  std::unique_ptr<response_executor_t> response_executor;
+#endif
+
   meili::MapMatcherFactory matcher_factory;
   std::shared_ptr<baldr::GraphReader> reader;
+
+  // Ring the big intermediate bodies arrive from loki and leave for odin in
+  // when shared memory messaging is on, null when it is off
+  std::shared_ptr<shm_message_arena_t> message_arena;
+
+  // Arena the trip paths (and their thousands of nested messages) are
+  // built on. Reset after each request once the results are serialized;
+  // the cached route results above own plain copies and outlive it.
+  google::protobuf::Arena arena;
 };
 
 } // namespace thor
@@ -22,6 +22,8 @@ public:
                               const std::function<void()>& interrupt = []() -> void {});
   std::string isochrone(const std::string& request_str,
                         const std::function<void()>& interrupt = []() -> void {});
+  std::string one_to_all(const std::string& request_str,
+                         const std::function<void()>& interrupt = []() -> void {});
   std::string trace_route(const std::string& request_str,
                           const std::function<void()>& interrupt = []() -> void {});
   std::string trace_attributes(const std::string& request_str,
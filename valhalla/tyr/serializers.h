@@ -1,6 +1,7 @@
 #ifndef __VALHALLA_TYR_SERVICE_H__
 #define __VALHALLA_TYR_SERVICE_H__
 
+#include <functional>
 #include <iostream>
 #include <list>
 #include <string>
@@ -27,7 +28,7 @@ namespace tyr {
  * Turn path and directions into a route that one can follow
  */
 std::string serializeDirections(const valhalla_request_t& request,
-                                const std::list<odin::TripPath>& path_legs,
+                                const std::list<odin::TripPath*>& path_legs,
                                 const std::list<odin::TripDirections>& directions_legs);
 
 /**
@@ -37,6 +38,28 @@ std::string serializeMatrix(const valhalla_request_t& request,
                             const std::vector<thor::TimeDistance>& time_distances,
                             double distance_scale);
 
+/**
+ * Callback used to hand one completed matrix row (a single source to every
+ * target) to the streaming serializer
+ */
+using MatrixRowCallback =
+    std::function<void(const uint32_t source_index, const std::vector<thor::TimeDistance>& row)>;
+
+/**
+ * Turn a time distance matrix into json row by row as the rows are computed.
+ * Each completed row is serialized and appended to the response immediately
+ * so the full matrix of results is never held in memory at once.
+ *
+ * @param request       The original request
+ * @param compute_rows  Function that computes the matrix, invoking the
+ *                      supplied callback once per completed source row, in
+ *                      source order
+ * @param distance_scale  Scale applied to distances (kilometers or miles)
+ */
+std::string serializeMatrix(const valhalla_request_t& request,
+                            const std::function<void(const MatrixRowCallback&)>& compute_rows,
+                            double distance_scale);
+
 /**
  * Turn grid data contours into geojson
  *
@@ -98,7 +121,8 @@ std::string serializeTransitAvailable(const valhalla_request_t& request,
 std::string serializeTraceAttributes(
     const valhalla_request_t& request,
     const thor::AttributesController& controller,
-    std::vector<std::tuple<float, float, std::vector<thor::MatchResult>, odin::TripPath>>& results);
+    std::vector<std::tuple<float, float, std::vector<thor::MatchResult>, odin::TripPath*>>&
+        results);
 
 } // namespace tyr
 } // namespace valhalla
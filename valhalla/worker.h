@@ -1,7 +1,12 @@
 #ifndef __VALHALLA_SERVICE_H__
 #define __VALHALLA_SERVICE_H__
+#include <cstdint>
+#include <functional>
+#include <memory>
 #include <string>
 
+#include <boost/property_tree/ptree_fwd.hpp>
+
 #include <valhalla/baldr/json.h>
 #include <valhalla/baldr/rapidjson_utils.h>
 #include <valhalla/proto/directions_options.pb.h>
@@ -11,6 +16,13 @@
 #include <prime_server/http_protocol.hpp>
 #include <prime_server/prime_server.hpp>
 using namespace prime_server;
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
 #endif
 
 namespace valhalla {
@@ -44,6 +56,7 @@ const std::unordered_map<unsigned, std::string>
                  "Insufficiently specified required parameter 'locations' or 'sources & targets'"},
                 {113, "Insufficiently specified required parameter 'contours'"},
                 {114, "Insufficiently specified required parameter 'shape' or 'encoded_polyline'"},
+                {115, "Insufficiently specified required parameter 'traces'"},
 
                 {120, "Insufficient number of locations provided"},
                 {121, "Insufficient number of sources provided"},
@@ -74,6 +87,7 @@ const std::unordered_map<unsigned, std::string>
                 {156, "Outside the valid walking distance between stops of a multimodal route"},
                 {157, "Exceeded max avoid locations"},
                 {158, "Input trace option is out of bounds"},
+                {159, "Exceeded max trace batch size"},
 
                 {160, "Date and time required for origin for date_type of depart at"},
                 {161, "Date and time required for destination for date_type of arrive by"},
@@ -126,6 +140,7 @@ const std::unordered_map<unsigned, std::string>
                 {424, "Failed to parse shape"},
 
                 {430, "Exceeded max iterations in CostMatrix::SourceToTarget"},
+                {431, "Too many heavy requests in flight, try again later"},
 
                 {440, "Cannot reach destination - too far from a transit stop"},
                 {441, "Location is unreachable"},
@@ -169,6 +184,152 @@ struct valhalla_request_t {
 #endif
 };
 
+/**
+ * Record a per stage timing sample for a request. The sample is appended to the
+ * request options, which each worker reserializes for the next pipeline stage,
+ * so the final serializer can surface all the stages in the response's debug
+ * block when the request asked for stage_trace. It also feeds process wide per
+ * stage latency histograms that are dumped to the log periodically (unless the
+ * request opted out of analytics with do_not_track).
+ * @param options          the request options the sample is recorded into
+ * @param stage            which pipeline stage recorded the sample
+ * @param elapsed_ms       wall clock time the request has spent in the stage
+ * @param labels_expanded  edge labels the stage's path algorithm allocated, if any
+ */
+void add_stage_trace(odin::DirectionsOptions& options,
+                     const std::string& stage,
+                     float elapsed_ms,
+                     uint64_t labels_expanded = 0);
+
+/**
+ * Replaces the shape in the options with the shape of one trace from a batched
+ * trace request. A trace is an object with either an encoded_polyline or a
+ * shape array of lat,lon points (with optional time, accuracy and radius), the
+ * same forms a single trace request accepts, plus an optional id that is set
+ * on the options so each result can be correlated to its trace.
+ * @param trace    one element of the request's traces array
+ * @param options  the options whose shape is replaced
+ */
+void parse_trace_shape(const rapidjson::Value& trace, odin::DirectionsOptions& options);
+
+/**
+ * Derives worker thread counts and memory tunables from the hardware the
+ * process actually has. Reads the cpu count (capped by the scheduler
+ * affinity mask and any cgroup cpu quota) and the available memory (capped
+ * by any cgroup memory limit) and fills in the tunables that were not
+ * explicitly configured - the tile cache size, per request memory budgets,
+ * serializer threads and the heavy request cap. Every derived value is
+ * logged and any value present in the config is left alone. Enabled with
+ * "httpd.service.autotune": true; when disabled only the concurrency
+ * fallback below applies.
+ * @param config                 the config to read and fill in
+ * @param requested_concurrency  an explicit worker thread count (e.g. from
+ *                               the command line), 0 to detect it
+ * @return the number of worker threads to run at each stage
+ */
+size_t autotune_config(boost::property_tree::ptree& config, size_t requested_concurrency = 0);
+
+/**
+ * A ring of request messages in posix shared memory for co-located pipeline
+ * stages. The stages already exchange serialized protobuf over their sockets;
+ * when a deployment runs every stage on one host the bytes can stay in a
+ * shared segment and only a small handle needs to travel through the proxies.
+ * A producing stage serializes a message once, directly into the ring, and
+ * forwards the handle; the consuming stage parses straight out of the mapped
+ * bytes and releases the block. Blocks whose consumer never showed up (the
+ * request died in flight) are reclaimed after a grace period. When the ring
+ * is full, or a message is too small to be worth the detour, the producer
+ * falls back to passing the bytes in the envelope as always, so turning the
+ * mode on never changes what a stage can consume - only how the big bodies
+ * get there. Enabled with "httpd.service.shm_messaging": true on every stage
+ * of the host. Not supported on windows.
+ */
+class shm_message_arena_t {
+public:
+  /**
+   * Creates or attaches to the named segment. The first process to create it
+   * sizes the ring, later ones just attach.
+   * @param segment_name      name of the shared memory segment (shm_open style)
+   * @param size              size of the message ring in bytes
+   * @param min_message_size  messages smaller than this are never stashed
+   */
+  shm_message_arena_t(const std::string& segment_name, size_t size, size_t min_message_size);
+
+  /**
+   * Detaches from the segment, which lives on for the other stages.
+   */
+  virtual ~shm_message_arena_t();
+
+  /**
+   * The process wide arena the config asks for, shared by every stage the
+   * process runs. A null pointer means the mode is off (or the segment could
+   * not be set up, which is logged and degrades to envelope passing).
+   * @param config  the config of any stage, read under httpd.service
+   * @return the arena or nullptr
+   */
+  static std::shared_ptr<shm_message_arena_t>
+  from_config(const boost::property_tree::ptree& config);
+
+  /**
+   * Whether an envelope message is a handle to stashed bytes rather than the
+   * bytes themselves.
+   * @param data  the message bytes
+   * @param size  the message size
+   * @return true if the message looks like a handle
+   */
+  static bool is_handle(const void* data, size_t size);
+  static bool is_handle(const std::string& message);
+
+  /**
+   * Serializes a message directly into the ring.
+   * @param message  the message to stash
+   * @return the handle to forward in the envelope, or an empty string when
+   *         the message is too small to bother or the ring has no room
+   */
+  std::string stash(const google::protobuf::MessageLite& message);
+
+  /**
+   * Copies already serialized bytes into the ring.
+   * @param bytes  the bytes to stash
+   * @return the handle or an empty string, as above
+   */
+  std::string stash(const std::string& bytes);
+
+  /**
+   * Runs a function over the stashed bytes of a handle and releases the
+   * block for reuse.
+   * @param handle  the handle from the envelope
+   * @param use     called with the mapped bytes, returns whether it took them
+   * @return false when the handle is stale (its block was already reclaimed)
+   *         or the function returned false
+   */
+  bool fetch(const std::string& handle, const std::function<bool(const void*, size_t)>& use);
+
+  /**
+   * Copies the stashed bytes of a handle out and releases the block.
+   * @param handle  the handle from the envelope
+   * @param bytes   filled with the stashed bytes, may alias the handle
+   * @return false when the handle is stale
+   */
+  bool fetch(const std::string& handle, std::string& bytes);
+
+protected:
+  struct segment_header_t;
+  struct block_header_t;
+
+  // reserves a ready block in the ring, null when there is no room
+  char* allocate(const size_t size, uint64_t& offset, uint64_t& sequence);
+  // finds and claims the block of a handle, null when it is gone
+  const char* claim(const std::string& handle, size_t& size, uint64_t& offset, uint64_t& sequence);
+  // releases a claimed block back to the ring
+  void release(const uint64_t offset, const uint64_t sequence);
+
+  std::string segment_name_;
+  size_t segment_size_;
+  size_t min_message_size_;
+  segment_header_t* header_;
+};
+
 #ifdef HAVE_HTTP
 worker_t::result_t jsonify_error(const valhalla_exception_t& exception,
                                  http_request_info_t& request_info,
@@ -185,6 +346,58 @@ worker_t::result_t to_response_json(const std::string& json,
 worker_t::result_t to_response_xml(const std::string& xml,
                                    http_request_info_t& request_info,
                                    const valhalla_request_t& options);
+worker_t::result_t to_response_binary(std::string&& data,
+                                      http_request_info_t& request_info,
+                                      const valhalla_request_t& options);
+
+/**
+ * A small pool of threads a worker may hand the serialization of a finished
+ * result to, so the thread that did the computation can pull its next request
+ * while a large response is still being turned into bytes. Each pool thread
+ * owns its own connection to the server's loopback and ships the responses it
+ * produces there directly, the same way the service workers ship theirs; the
+ * responses carry the request info they were stamped with so the server can
+ * route them to the right client session.
+ */
+class response_executor_t {
+public:
+  // a deferred bit of serialization producing the finished responses to ship
+  using task_t = std::function<worker_t::result_t()>;
+
+  /**
+   * Constructs the executor and starts its threads
+   * @param loopback_endpoint  the server's loopback the responses are sent to
+   * @param thread_count       number of serializer threads, 0 starts none
+   */
+  response_executor_t(const std::string& loopback_endpoint, size_t thread_count);
+
+  /**
+   * Drains any queued tasks and stops the threads
+   */
+  ~response_executor_t();
+
+  /**
+   * Whether any threads were started and tasks may be posted
+   */
+  bool enabled() const;
+
+  /**
+   * Queues a task; its result's messages are sent to the loopback from
+   * whichever pool thread runs it
+   * @param task  the deferred serialization
+   */
+  void post(task_t&& task);
+
+protected:
+  void run(const std::string& loopback_endpoint);
+
+  zmq::context_t context;
+  std::mutex mutex;
+  std::condition_variable signal;
+  std::deque<task_t> tasks;
+  bool stop;
+  std::vector<std::thread> threads;
+};
 #endif
 
 class service_worker_t {